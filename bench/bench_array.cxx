@@ -0,0 +1,81 @@
+#include "bench_helpers.hxx"
+
+namespace
+{
+/// SQL array text for @c elements elements, each made by @c element(i).
+template<typename FUNC>
+std::string make_array(std::size_t elements, FUNC const &element)
+{
+  std::string text{"{"};
+  for (std::size_t i{0}; i < elements; ++i)
+  {
+    if (i > 0)
+      text.push_back(',');
+    text += element(i);
+  }
+  text.push_back('}');
+  return text;
+}
+
+
+/// Parse @c text @c n times.  Returns the number of bytes parsed.
+std::size_t parse_array(
+  std::string const &text, pqxx::internal::encoding_group enc, std::size_t n)
+{
+  for (std::size_t i{0}; i < n; ++i)
+  {
+    pqxx::array_parser parser{text, enc};
+    for (auto step{parser.get_next_view()};
+         step.first != pqxx::array_parser::juncture::done;
+         step = parser.get_next_view())
+      pqxx::bench::keep(step.second);
+  }
+  return n * std::size(text);
+}
+
+
+void array_benchmarks()
+{
+  using pqxx::internal::encoding_group;
+  for (auto const size : pqxx::bench::sizes)
+  {
+    auto const elements{size / 8 + 1};
+    auto const numbers{make_array(
+      elements, [](std::size_t i) { return pqxx::to_string(i * 7919); })};
+    auto const quoted{make_array(elements, [](std::size_t i) {
+      return "\"item \\\"" + pqxx::to_string(i) + "\\\"\"";
+    })};
+    auto const utf8{make_array(elements, [](std::size_t i) {
+      return "\"na\xc3\xafve \xe2\x82\xac" + pqxx::to_string(i) + "\"";
+    })};
+    auto const suffix{"/" + pqxx::to_string(elements)};
+
+    pqxx::bench::add(
+      "array_parser/numbers" + suffix, [numbers](std::size_t n) {
+        return parse_array(numbers, encoding_group::MONOBYTE, n);
+      });
+    pqxx::bench::add("array_parser/quoted" + suffix, [quoted](std::size_t n) {
+      return parse_array(quoted, encoding_group::MONOBYTE, n);
+    });
+    pqxx::bench::add("array_parser/utf8" + suffix, [utf8](std::size_t n) {
+      return parse_array(utf8, encoding_group::UTF8, n);
+    });
+
+    pqxx::bench::add(
+      "array_parser/get_next" + suffix, [quoted](std::size_t n) {
+        for (std::size_t i{0}; i < n; ++i)
+        {
+          pqxx::array_parser parser{quoted};
+          for (auto step{parser.get_next()};
+               step.first != pqxx::array_parser::juncture::done;
+               step = parser.get_next())
+            pqxx::bench::keep(step.second);
+        }
+        return n * std::size(quoted);
+      });
+  }
+}
+
+
+PQXX_REGISTER_BENCHMARKS(array_benchmarks);
+} // namespace
@@ -0,0 +1,63 @@
+#include "bench_helpers.hxx"
+
+#include <pqxx/internal/encodings.hxx>
+
+namespace
+{
+using pqxx::internal::encoding_group;
+
+
+/// Text of about @c size bytes, ending in a semicolon.
+/** Repeats @c glyphs, which must be valid text in the encoding at hand.
+ */
+std::string make_text(std::size_t size, std::string_view glyphs)
+{
+  std::string text;
+  text.reserve(size + std::size(glyphs));
+  while (std::size(text) + 1 < size) text.append(glyphs);
+  text.push_back(';');
+  return text;
+}
+
+
+void encoding_benchmarks()
+{
+  // Text for each encoding: ASCII mixed with a few multibyte characters.
+  std::pair<char const *, std::pair<encoding_group, char const *>> const
+    encodings[]{
+      {"MONOBYTE", {encoding_group::MONOBYTE, "select x from t where "}},
+      {"UTF8", {encoding_group::UTF8, "na\xc3\xafve \xe2\x82\xac value "}},
+      {"SJIS", {encoding_group::SJIS, "abc \x82\xa0\x82\xa2 def "}},
+      {"BIG5", {encoding_group::BIG5, "abc \xa4\x40\xa4\x41 def "}},
+      {"GBK", {encoding_group::GBK, "abc \xb0\xa1\xb0\xa2 def "}},
+      {"EUC_JP", {encoding_group::EUC_JP, "abc \xa4\xa2\xa4\xa4 def "}},
+    };
+
+  for (auto const size : pqxx::bench::sizes)
+    for (auto const &[name, spec] : encodings)
+    {
+      auto const enc{spec.first};
+      auto const text{make_text(size, spec.second)};
+      auto const suffix{std::string{"/"} + name + "/" + pqxx::to_string(size)};
+
+      pqxx::bench::add(
+        "find_with_encoding/char" + suffix, [enc, text](std::size_t n) {
+          for (std::size_t i{0}; i < n; ++i)
+            pqxx::bench::keep(
+              pqxx::internal::find_with_encoding(enc, text, ';'));
+          return n * std::size(text);
+        });
+
+      pqxx::bench::add(
+        "find_with_encoding/string" + suffix, [enc, text](std::size_t n) {
+          for (std::size_t i{0}; i < n; ++i)
+            pqxx::bench::keep(
+              pqxx::internal::find_with_encoding(enc, text, "t;"));
+          return n * std::size(text);
+        });
+    }
+}
+
+
+PQXX_REGISTER_BENCHMARKS(encoding_benchmarks);
+} // namespace
@@ -0,0 +1,41 @@
+#include "bench_helpers.hxx"
+
+namespace
+{
+/// @c size bytes of text, with a special character every @c every bytes.
+std::string make_text(std::size_t size, std::size_t every)
+{
+  char const specials[]{'\t', '\n', '\\', '\r'};
+  std::string text;
+  text.reserve(size);
+  for (std::size_t i{0}; i < size; ++i)
+    if (every > 0 and i % every == every - 1)
+      text.push_back(specials[(i / every) % 4]);
+    else
+      text.push_back(static_cast<char>('a' + i % 26));
+  return text;
+}
+
+
+void escape_benchmarks()
+{
+  for (auto const size : pqxx::bench::sizes)
+    for (auto const &[kind, every] :
+         {std::pair{"plain", 0}, std::pair{"sparse", 64},
+          std::pair{"dense", 4}})
+    {
+      auto const text{make_text(size, static_cast<std::size_t>(every))};
+      pqxx::bench::add(
+        std::string{"copy_string_escape/"} + kind + "/" +
+          pqxx::to_string(size),
+        [text](std::size_t n) {
+          for (std::size_t i{0}; i < n; ++i)
+            pqxx::bench::keep(pqxx::internal::copy_string_escape(text));
+          return n * std::size(text);
+        });
+    }
+}
+
+
+PQXX_REGISTER_BENCHMARKS(escape_benchmarks);
+} // namespace
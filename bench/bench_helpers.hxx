@@ -0,0 +1,48 @@
+/* Helpers for libpqxx micro-benchmarks.
+ */
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include <pqxx/pqxx>
+
+namespace pqxx::bench
+{
+/// A benchmark: run the operation @c iterations times.
+/** Returns the total number of bytes it processed, or zero if that doesn't
+ * mean anything for this benchmark.
+ */
+using benchfunc = std::function<std::size_t(std::size_t iterations)>;
+
+
+/// Add a benchmark to the suite.
+void add(std::string const &name, benchfunc func);
+
+
+/// Runs a function which adds benchmarks, at startup.
+struct registrar
+{
+  explicit registrar(void (*setup)()) { setup(); }
+};
+
+
+/// Keep the compiler from optimising away the computation of @c value.
+template<typename T> inline void keep(T const &value) noexcept
+{
+#if defined(__GNUC__)
+  asm volatile("" : : "r"(&value) : "memory");
+#else
+  static void const *volatile sink;
+  sink = &value;
+#endif
+}
+
+
+/// Input sizes, in bytes or elements, at which to run scalable benchmarks.
+inline constexpr std::size_t sizes[]{16, 1024, 65536};
+} // namespace pqxx::bench
+
+
+// Register a function which adds benchmarks, so the runner will run them.
+#define PQXX_REGISTER_BENCHMARKS(setup)                                       \
+  pqxx::bench::registrar bench_##setup { setup }
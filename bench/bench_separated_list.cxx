@@ -0,0 +1,46 @@
+#include <vector>
+
+#include "bench_helpers.hxx"
+
+namespace
+{
+void separated_list_benchmarks()
+{
+  for (auto const size : pqxx::bench::sizes)
+  {
+    std::vector<int> numbers;
+    std::vector<std::string> names;
+    for (std::size_t i{0}; i < size; ++i)
+    {
+      numbers.push_back(static_cast<int>(i * 7919));
+      names.push_back("column_" + pqxx::to_string(i));
+    }
+    auto const suffix{"/" + pqxx::to_string(size)};
+
+    pqxx::bench::add("separated_list/int" + suffix, [numbers](std::size_t n) {
+      std::size_t bytes{0};
+      for (std::size_t i{0}; i < n; ++i)
+      {
+        auto const list{pqxx::separated_list(",", numbers)};
+        pqxx::bench::keep(list);
+        bytes += std::size(list);
+      }
+      return bytes;
+    });
+
+    pqxx::bench::add("separated_list/string" + suffix, [names](std::size_t n) {
+      std::size_t bytes{0};
+      for (std::size_t i{0}; i < n; ++i)
+      {
+        auto const list{pqxx::separated_list(", ", names)};
+        pqxx::bench::keep(list);
+        bytes += std::size(list);
+      }
+      return bytes;
+    });
+  }
+}
+
+
+PQXX_REGISTER_BENCHMARKS(separated_list_benchmarks);
+} // namespace
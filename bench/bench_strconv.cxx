@@ -0,0 +1,76 @@
+#include <vector>
+
+#include "bench_helpers.hxx"
+
+namespace
+{
+/// A spread of values of type T, as text, for parsing benchmarks.
+template<typename T> std::vector<std::string> sample_texts()
+{
+  std::vector<std::string> texts;
+  for (int i{0}; i < 1024; ++i)
+    texts.push_back(pqxx::to_string(static_cast<T>((i - 512) * 7919)));
+  return texts;
+}
+
+
+template<typename T> void add_conversions(std::string const &type)
+{
+  pqxx::bench::add("to_string/" + type, [](std::size_t n) {
+    std::size_t bytes{0};
+    for (std::size_t i{0}; i < n; ++i)
+    {
+      auto const text{pqxx::to_string(static_cast<T>(i * 7919))};
+      pqxx::bench::keep(text);
+      bytes += std::size(text);
+    }
+    return bytes;
+  });
+
+  pqxx::bench::add("into_buf/" + type, [](std::size_t n) {
+    char buf[64];
+    std::size_t bytes{0};
+    for (std::size_t i{0}; i < n; ++i)
+    {
+      auto const end{pqxx::string_traits<T>::into_buf(
+        buf, buf + std::size(buf), static_cast<T>(i * 7919))};
+      pqxx::bench::keep(buf);
+      bytes += static_cast<std::size_t>(end - buf);
+    }
+    return bytes;
+  });
+
+  pqxx::bench::add("from_string/" + type, [](std::size_t n) {
+    static auto const texts{sample_texts<T>()};
+    std::size_t bytes{0};
+    for (std::size_t i{0}; i < n; ++i)
+    {
+      auto const &text{texts[i % std::size(texts)]};
+      pqxx::bench::keep(pqxx::from_string<T>(text));
+      bytes += std::size(text);
+    }
+    return bytes;
+  });
+}
+
+
+void strconv_benchmarks()
+{
+  add_conversions<short>("short");
+  add_conversions<int>("int");
+  add_conversions<long long>("long_long");
+  add_conversions<unsigned>("unsigned");
+  add_conversions<float>("float");
+  add_conversions<double>("double");
+
+  pqxx::bench::add("from_string/bool", [](std::size_t n) {
+    char const *const texts[]{"true", "f", "1", "FALSE"};
+    for (std::size_t i{0}; i < n; ++i)
+      pqxx::bench::keep(pqxx::from_string<bool>(texts[i % 4]));
+    return std::size_t{0};
+  });
+}
+
+
+PQXX_REGISTER_BENCHMARKS(strconv_benchmarks);
+} // namespace
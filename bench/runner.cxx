@@ -0,0 +1,119 @@
+/* Runner for libpqxx micro-benchmarks.
+ *
+ * Usage: runner [--quick] [--min-time=SECONDS] [FILTER...]
+ *
+ * Runs each benchmark whose name contains any of the FILTER strings, or all
+ * of them if there are none.  Each benchmark runs long enough to take at
+ * least the minimum time, which defaults to a quarter of a second.  With
+ * --quick, each runs only once: a quick check that they all still work.
+ */
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "bench_helpers.hxx"
+
+namespace
+{
+std::map<std::string, pqxx::bench::benchfunc> *all_benchmarks = nullptr;
+
+
+/// Does @c name match any of the filters?  All names match no filters.
+bool selected(std::string const &name, std::vector<std::string> const &filters)
+{
+  if (std::empty(filters))
+    return true;
+  for (auto const &f : filters)
+    if (name.find(f) != std::string::npos)
+      return true;
+  return false;
+}
+
+
+void run(
+  std::string const &name, pqxx::bench::benchfunc const &func,
+  std::chrono::duration<double> min_time)
+{
+  using clock = std::chrono::steady_clock;
+  std::size_t iterations{1}, bytes{0};
+  std::chrono::duration<double> elapsed{0};
+  for (;;)
+  {
+    auto const start{clock::now()};
+    bytes = func(iterations);
+    elapsed = clock::now() - start;
+    if (elapsed >= min_time)
+      break;
+    // Aim a bit past the minimum time, but grow at most tenfold per round.
+    auto const guess{
+      (elapsed.count() > 0) ?
+        1.2 * static_cast<double>(iterations) * min_time / elapsed :
+        1e9};
+    iterations = static_cast<std::size_t>(
+      std::min(guess, 10.0 * static_cast<double>(iterations))) + 1;
+  }
+
+  auto const nanos{1e9 * elapsed.count() / static_cast<double>(iterations)};
+  std::cout << std::left << std::setw(48) << name << std::right
+            << std::setw(12) << iterations << std::setw(14) << std::fixed
+            << std::setprecision(1) << nanos << " ns/op";
+  if (bytes > 0)
+    std::cout << std::setw(12) << std::setprecision(1)
+              << static_cast<double>(bytes) / elapsed.count() / 1e6
+              << " MB/s";
+  std::cout << '\n';
+}
+} // namespace
+
+
+namespace pqxx::bench
+{
+void add(std::string const &name, benchfunc func)
+{
+  if (all_benchmarks == nullptr)
+    all_benchmarks = new std::map<std::string, benchfunc>;
+  all_benchmarks->emplace(name, std::move(func));
+}
+} // namespace pqxx::bench
+
+
+int main(int argc, char const *argv[])
+{
+  bool quick{false};
+  std::chrono::duration<double> min_time{0.25};
+  std::vector<std::string> filters;
+  for (int i{1}; i < argc; ++i)
+  {
+    std::string const arg{argv[i]};
+    std::string const min_time_opt{"--min-time="};
+    if (arg == "--quick")
+      quick = true;
+    else if (arg.compare(0, std::size(min_time_opt), min_time_opt) == 0)
+      min_time = std::chrono::duration<double>{
+        pqxx::from_string<double>(arg.substr(std::size(min_time_opt)))};
+    else
+      filters.push_back(arg);
+  }
+
+  int failures{0};
+  for (auto const &[name, func] : *all_benchmarks)
+  {
+    if (not selected(name, filters))
+      continue;
+    try
+    {
+      if (quick)
+        func(1);
+      else
+        run(name, func, min_time);
+    }
+    catch (std::exception const &e)
+    {
+      std::cerr << "FAILED: " << name << ": " << e.what() << std::endl;
+      ++failures;
+    }
+  }
+  return failures;
+}
@@ -0,0 +1,492 @@
+/* End-to-end throughput and latency benchmarks, against a live database.
+ *
+ * Usage: throughput [--connect=STRING] [--ops=N] [--rows=N] [--repeat=N]
+ *                   [FILTER...]
+ *
+ * Connects to the database given by the connection string, or by the usual
+ * PG* environment variables if there is none.  Runs each benchmark whose name
+ * contains any of the FILTER strings, or all of them if there are none.
+ *
+ * Writes one line of JSON for each benchmark to standard output, so that you
+ * can compare the numbers between libpqxx versions or builds.  Each line
+ * holds the total rows and bytes transferred, the elapsed time, throughput,
+ * and latency percentiles in microseconds.
+ *
+ * What a latency sample measures depends on the benchmark.  For single-row
+ * queries, and for queries in a pipeline, it's a single query: from issuing
+ * it to receiving its result.  For bulk transfers (streams, cursors, and large
+ * objects) it's one full transfer, which runs --repeat times.
+ *
+ * The benchmarks create only temporary tables, and leave no changes behind.
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include <pqxx/pqxx>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+
+/// Workload sizes, as set on the command line.
+struct settings
+{
+  /// Number of queries for single-row and pipeline benchmarks.
+  std::size_t ops = 1000;
+  /// Number of rows in each bulk transfer.
+  std::size_t rows = 100000;
+  /// Number of times to repeat each bulk transfer.
+  std::size_t repeat = 5;
+};
+
+
+/// Collects a benchmark's latency samples, and the work it did.
+class recorder
+{
+public:
+  void sample(clock_type::duration latency) { m_samples.push_back(latency); }
+
+  /// Run @c func, and record how long it took as a sample.
+  template<typename FUNC> void time(FUNC const &func)
+  {
+    auto const start{clock_type::now()};
+    func();
+    sample(clock_type::now() - start);
+  }
+
+  void count(std::size_t rows, std::size_t bytes = 0)
+  {
+    m_rows += rows;
+    m_bytes += bytes;
+  }
+
+  /// Write the outcome as a JSON object, on a line of its own.
+  void report(
+    std::ostream &out, std::string const &name, std::string const &server,
+    std::chrono::duration<double> elapsed);
+
+private:
+  /// Latency percentile @c p (in [0, 1]), in microseconds.
+  double percentile(double p) const
+  {
+    if (std::empty(m_samples))
+      return 0;
+    auto const rank{static_cast<std::size_t>(
+      std::ceil(p * static_cast<double>(std::size(m_samples))))};
+    auto const index{std::min(
+      std::max(rank, std::size_t{1}) - 1, std::size(m_samples) - 1)};
+    return std::chrono::duration<double, std::micro>{m_samples[index]}
+      .count();
+  }
+
+  std::vector<clock_type::duration> m_samples;
+  std::size_t m_rows = 0, m_bytes = 0;
+};
+
+
+void recorder::report(
+  std::ostream &out, std::string const &name, std::string const &server,
+  std::chrono::duration<double> elapsed)
+{
+  std::sort(std::begin(m_samples), std::end(m_samples));
+  auto const seconds{elapsed.count()};
+  auto const rate{[seconds](std::size_t amount) {
+    return (seconds > 0) ? static_cast<double>(amount) / seconds : 0.0;
+  }};
+
+  // Build the line separately, so that the stream's settings don't leak.
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(3) << "{\"libpqxx\": \""
+       << PQXX_VERSION << "\", \"server\": " << server
+       << ", \"benchmark\": \"" << name
+       << "\", \"samples\": " << std::size(m_samples)
+       << ", \"rows\": " << m_rows << ", \"bytes\": " << m_bytes
+       << ", \"seconds\": " << seconds
+       << ", \"rows_per_second\": " << rate(m_rows)
+       << ", \"bytes_per_second\": " << rate(m_bytes)
+       << ", \"latency_us\": {\"min\": " << percentile(0)
+       << ", \"p50\": " << percentile(0.5) << ", \"p90\": " << percentile(0.9)
+       << ", \"p99\": " << percentile(0.99) << ", \"max\": " << percentile(1)
+       << "}}";
+  out << line.str() << std::endl;
+}
+
+
+using benchfunc =
+  std::function<void(pqxx::connection &, recorder &, settings const &)>;
+
+
+/// Comma-separated list of @c width copies of @c column.
+std::string columns(std::size_t width, std::string const &column)
+{
+  std::vector<std::string> const cols(width, column);
+  return pqxx::separated_list(", ", std::begin(cols), std::end(cols));
+}
+
+
+/// Single-row queries, one at a time: plain, parameterised, or prepared.
+/** For prepared statements, there are several ways to go about it: all in one
+ * long-lived @c nontransaction, with a fresh @c nontransaction for each
+ * query, or through @c connection::exec_prepared_autocommit().  Compare
+ * these to @c libpq_point_queries.
+ */
+enum class point_kind
+{
+  exec,
+  exec_params,
+  exec_prepared,
+  nontransaction_each,
+  autocommit
+};
+
+
+void point_queries(
+  point_kind kind, pqxx::connection &conn, recorder &rec,
+  settings const &set)
+{
+  bool const prepared{kind != point_kind::exec and
+                     kind != point_kind::exec_params};
+  if (prepared)
+    conn.prepare("pqxx_bench_point", "SELECT $1::integer + 1");
+  std::optional<pqxx::nontransaction> tx;
+  if (
+    kind != point_kind::nontransaction_each and
+    kind != point_kind::autocommit)
+    tx.emplace(conn);
+  for (std::size_t i{0}; i < set.ops; ++i)
+  {
+    auto const n{static_cast<int>(i)};
+    rec.time([&] {
+      switch (kind)
+      {
+      case point_kind::exec:
+        tx->exec1("SELECT " + pqxx::to_string(n) + " + 1");
+        break;
+      case point_kind::exec_params:
+        tx->exec_params1("SELECT $1::integer + 1", n);
+        break;
+      case point_kind::exec_prepared:
+        tx->exec_prepared1("pqxx_bench_point", n);
+        break;
+      case point_kind::nontransaction_each:
+        pqxx::nontransaction{conn}.exec_prepared1("pqxx_bench_point", n);
+        break;
+      case point_kind::autocommit:
+        conn.exec_prepared_autocommit("pqxx_bench_point", n);
+        break;
+      }
+    });
+    rec.count(1);
+  }
+  if (prepared)
+    conn.unprepare("pqxx_bench_point");
+}
+
+
+/// The prepared point queries, straight through libpq.
+/** This runs on a connection of its own.  It's the baseline for measuring
+ * libpqxx's own overhead per query.
+ */
+void libpq_point_queries(
+  pqxx::connection &conn, recorder &rec, settings const &set)
+{
+  std::unique_ptr<PGconn, void (*)(PGconn *)> const raw{
+    PQconnectdb(conn.connection_string().c_str()), PQfinish};
+  if (PQstatus(raw.get()) != CONNECTION_OK)
+    throw pqxx::broken_connection{PQerrorMessage(raw.get())};
+  auto const check{[&raw](PGresult *res, ExecStatusType expect) {
+    auto const ok{PQresultStatus(res) == expect};
+    PQclear(res);
+    if (not ok)
+      throw pqxx::failure{PQerrorMessage(raw.get())};
+  }};
+  check(
+    PQprepare(
+      raw.get(), "pqxx_bench_point", "SELECT $1::integer + 1", 0, nullptr),
+    PGRES_COMMAND_OK);
+
+  for (std::size_t i{0}; i < set.ops; ++i)
+  {
+    auto const text{pqxx::to_string(i)};
+    char const *const values[]{text.c_str()};
+    rec.time([&] {
+      check(
+        PQexecPrepared(
+          raw.get(), "pqxx_bench_point", 1, values, nullptr, nullptr, 0),
+        PGRES_TUPLES_OK);
+    });
+    rec.count(1);
+  }
+}
+
+
+/// Single-row queries in a pipeline, which retains up to @c retain of them.
+void pipelined_queries(
+  int retain, pqxx::connection &conn, recorder &rec, settings const &set)
+{
+  pqxx::work tx{conn};
+  pqxx::pipeline pipe{tx};
+  pipe.retain(retain);
+  std::vector<clock_type::time_point> issued(set.ops);
+  for (std::size_t i{0}; i < set.ops; ++i)
+  {
+    issued[i] = clock_type::now();
+    pipe.insert(
+      "SELECT " + pqxx::to_string(i) + " + 1",
+      [&rec, &issued, i](pqxx::pipeline::query_id, pqxx::result const &) {
+        rec.sample(clock_type::now() - issued[i]);
+        rec.count(1);
+      });
+  }
+  pipe.complete();
+}
+
+
+/// Read rows of @c WIDTH integers through a @c stream_from.
+template<std::size_t WIDTH>
+void stream_from_rows(
+  pqxx::connection &conn, recorder &rec, settings const &set)
+{
+  pqxx::work tx{conn};
+  auto const query{
+    "SELECT " + columns(WIDTH, "n") + " FROM generate_series(1, " +
+    pqxx::to_string(set.rows) + ") AS n"};
+  for (std::size_t r{0}; r < set.repeat; ++r)
+    rec.time([&] {
+      auto stream{pqxx::stream_from::query(tx, query)};
+      std::array<long, WIDTH> row;
+      std::size_t rows{0};
+      while (stream >> row) ++rows;
+      stream.complete();
+      rec.count(rows);
+    });
+}
+
+
+/// Write rows of @c WIDTH integers through a @c stream_to.
+template<std::size_t WIDTH>
+void stream_to_rows(
+  pqxx::connection &conn, recorder &rec, settings const &set)
+{
+  pqxx::work tx{conn};
+  std::string const table{"pqxx_bench_stream_" + pqxx::to_string(WIDTH)};
+  std::vector<std::string> defs;
+  for (std::size_t c{0}; c < WIDTH; ++c)
+    defs.push_back("c" + pqxx::to_string(c) + " bigint");
+  tx.exec0(
+    "CREATE TEMP TABLE " + table + " (" +
+    pqxx::separated_list(", ", std::begin(defs), std::end(defs)) + ")");
+
+  for (std::size_t r{0}; r < set.repeat; ++r)
+  {
+    rec.time([&] {
+      pqxx::stream_to stream{tx, table};
+      std::array<long, WIDTH> row;
+      for (std::size_t n{0}; n < set.rows; ++n)
+      {
+        row.fill(static_cast<long>(n));
+        stream << row;
+      }
+      stream.complete();
+    });
+    rec.count(set.rows);
+    tx.exec0("TRUNCATE " + table);
+  }
+}
+
+
+/// Read rows through an @c icursorstream, @c stride rows at a time.
+void cursor_rows(
+  pqxx::cursor_base::difference_type stride, pqxx::connection &conn,
+  recorder &rec, settings const &set)
+{
+  pqxx::work tx{conn};
+  auto const query{
+    "SELECT n, 'row ' || n FROM generate_series(1, " +
+    pqxx::to_string(set.rows) + ") AS n"};
+  for (std::size_t r{0}; r < set.repeat; ++r)
+    rec.time([&] {
+      pqxx::icursorstream cursor{tx, query, "pqxx_bench_cursor", stride};
+      pqxx::result chunk;
+      std::size_t rows{0};
+      while (cursor >> chunk) rows += static_cast<std::size_t>(chunk.size());
+      rec.count(rows);
+    });
+}
+
+
+/// Write a large object of @c size bytes, and read it back.
+void large_object_transfer(
+  bool reading, std::size_t size, pqxx::connection &conn, recorder &rec,
+  settings const &set)
+{
+  pqxx::work tx{conn};
+  std::string const data(size, 'x');
+  std::string buffer(size, '\0');
+  // Never committed, so the large objects go away with the transaction.
+  for (std::size_t r{0}; r < set.repeat; ++r)
+  {
+    pqxx::largeobjectaccess object{tx};
+    if (reading)
+    {
+      object.write(data);
+      object.seek(0, std::ios::beg);
+      rec.time([&] {
+        std::size_t got{0};
+        while (got < size)
+        {
+          auto const chunk{object.read(std::data(buffer) + got, size - got)};
+          if (chunk <= 0)
+            throw pqxx::failure{"Large object came back truncated."};
+          got += static_cast<std::size_t>(chunk);
+        }
+      });
+    }
+    else
+    {
+      rec.time([&] { object.write(data); });
+    }
+    rec.count(0, size);
+  }
+}
+
+
+/// All benchmarks, by name.
+std::vector<std::pair<std::string, benchfunc>> make_benchmarks()
+{
+  using namespace std::placeholders;
+  std::vector<std::pair<std::string, benchfunc>> all{
+    {"exec", std::bind(point_queries, point_kind::exec, _1, _2, _3)},
+    {"exec_params",
+     std::bind(point_queries, point_kind::exec_params, _1, _2, _3)},
+    {"exec_prepared",
+     std::bind(point_queries, point_kind::exec_prepared, _1, _2, _3)},
+    {"exec_prepared/nontransaction_each",
+     std::bind(point_queries, point_kind::nontransaction_each, _1, _2, _3)},
+    {"exec_prepared/autocommit",
+     std::bind(point_queries, point_kind::autocommit, _1, _2, _3)},
+    {"exec_prepared/libpq", libpq_point_queries},
+    {"stream_from/width=1", stream_from_rows<1>},
+    {"stream_from/width=8", stream_from_rows<8>},
+    {"stream_from/width=32", stream_from_rows<32>},
+    {"stream_to/width=1", stream_to_rows<1>},
+    {"stream_to/width=8", stream_to_rows<8>},
+    {"stream_to/width=32", stream_to_rows<32>},
+  };
+  for (int retain : {1, 8, 64})
+    all.emplace_back(
+      "pipeline/retain=" + pqxx::to_string(retain),
+      std::bind(pipelined_queries, retain, _1, _2, _3));
+  for (pqxx::cursor_base::difference_type stride : {10, 100, 1000})
+    all.emplace_back(
+      "cursor/stride=" + pqxx::to_string(stride),
+      std::bind(cursor_rows, stride, _1, _2, _3));
+  for (std::size_t size : {1u << 16, 1u << 20, 1u << 24})
+  {
+    auto const suffix{"/bytes=" + pqxx::to_string(size)};
+    all.emplace_back(
+      "large_object/write" + suffix,
+      std::bind(large_object_transfer, false, size, _1, _2, _3));
+    all.emplace_back(
+      "large_object/read" + suffix,
+      std::bind(large_object_transfer, true, size, _1, _2, _3));
+  }
+  return all;
+}
+
+
+/// Does @c name match any of the filters?  All names match no filters.
+bool selected(std::string const &name, std::vector<std::string> const &filters)
+{
+  if (std::empty(filters))
+    return true;
+  for (auto const &f : filters)
+    if (name.find(f) != std::string::npos)
+      return true;
+  return false;
+}
+
+
+/// If @c arg is "--NAME=VALUE" for the given option name, extract VALUE.
+bool option(
+  std::string const &arg, std::string const &name, std::string &value)
+{
+  auto const prefix{"--" + name + "="};
+  if (arg.compare(0, std::size(prefix), prefix) != 0)
+    return false;
+  value = arg.substr(std::size(prefix));
+  return true;
+}
+} // namespace
+
+
+int main(int argc, char const *argv[])
+{
+  std::string connect, value;
+  settings set;
+  std::vector<std::string> filters;
+  try
+  {
+    for (int i{1}; i < argc; ++i)
+    {
+      std::string const arg{argv[i]};
+      if (option(arg, "connect", value))
+        connect = value;
+      else if (option(arg, "ops", value))
+        set.ops = pqxx::from_string<std::size_t>(value);
+      else if (option(arg, "rows", value))
+        set.rows = pqxx::from_string<std::size_t>(value);
+      else if (option(arg, "repeat", value))
+        set.repeat = pqxx::from_string<std::size_t>(value);
+      else
+        filters.push_back(arg);
+    }
+  }
+  catch (std::exception const &e)
+  {
+    std::cerr << "Bad option: " << e.what() << std::endl;
+    return 2;
+  }
+
+  int failures{0};
+  try
+  {
+    pqxx::connection conn{connect};
+    auto const server{pqxx::to_string(conn.server_version())};
+    for (auto const &[name, func] : make_benchmarks())
+    {
+      if (not selected(name, filters))
+        continue;
+      try
+      {
+        recorder rec;
+        auto const start{clock_type::now()};
+        func(conn, rec, set);
+        rec.report(std::cout, name, server, clock_type::now() - start);
+      }
+      catch (std::exception const &e)
+      {
+        std::cerr << "FAILED: " << name << ": " << e.what() << std::endl;
+        ++failures;
+      }
+    }
+  }
+  catch (std::exception const &e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return failures;
+}
@@ -24,6 +24,33 @@ check_symbol_exists(
 	"${PostgreSQL_INCLUDE_DIR}/libpq-fe.h"
 	PQXX_HAVE_PQENCRYPTPASSWORDCONN)
 
+check_symbol_exists(
+	PQenterPipelineMode
+	"${PostgreSQL_INCLUDE_DIR}/libpq-fe.h"
+	PQXX_HAVE_PQ_PIPELINE)
+
+check_symbol_exists(
+	PQsetChunkedRowsMode
+	"${PostgreSQL_INCLUDE_DIR}/libpq-fe.h"
+	PQXX_HAVE_PQ_CHUNKED_ROWS)
+
+check_symbol_exists(
+	PQcancelCreate
+	"${PostgreSQL_INCLUDE_DIR}/libpq-fe.h"
+	PQXX_HAVE_PQ_CANCEL_CONN)
+
+check_symbol_exists(
+	PQresultMemorySize
+	"${PostgreSQL_INCLUDE_DIR}/libpq-fe.h"
+	PQXX_HAVE_PQRESULTMEMORYSIZE)
+
+if(PQXX_ENABLE_TRACEPOINTS)
+	check_include_file_cxx("sys/sdt.h" PQXX_HAVE_SYS_SDT_H)
+	if(NOT PQXX_HAVE_SYS_SDT_H)
+		message(FATAL_ERROR "Tracepoints need sys/sdt.h, e.g. from systemtap.")
+	endif()
+endif()
+
 cmake_determine_compile_features(CXX)
 cmake_policy(SET CMP0057 NEW)
 
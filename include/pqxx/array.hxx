@@ -19,6 +19,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 
 
@@ -74,21 +75,50 @@ public:
    */
   std::pair<juncture, std::string> get_next();
 
+  /// Parse the next step in the array, without allocating a string for it.
+  /** Works like @c get_next, but returns the value as a view.  For an
+   * unquoted value, the view points into the input.  For a quoted one, it
+   * points to the value's unescaped text in a buffer inside the parser,
+   * which the parser re-uses.
+   *
+   * So the view is only valid until your next call to the parser, and only
+   * while the input stays in memory.
+   */
+  std::pair<juncture, std::string_view> get_next_view();
+
 private:
   std::string_view m_input;
-  internal::glyph_scanner_func *const m_scan;
+  internal::encoding_group const m_encoding;
 
   /// Current parsing position in the input.
   std::string::size_type m_pos;
 
+  /// Buffer for unescaping quoted values.
+  std::string m_buffer;
+
+  // These are all specialised per encoding group, so that the compiler can
+  // inline the glyph scanner.  The get_next() call picks one.
+
+  template<internal::encoding_group>
+  std::pair<juncture, std::string_view> parse_next();
+
+  template<internal::encoding_group>
   std::string::size_type scan_single_quoted_string() const;
-  std::string parse_single_quoted_string(std::string::size_type end) const;
+  template<internal::encoding_group>
+  void parse_single_quoted_string(
+    std::string::size_type end, std::string &output) const;
+  template<internal::encoding_group>
   std::string::size_type scan_double_quoted_string() const;
-  std::string parse_double_quoted_string(std::string::size_type end) const;
+  template<internal::encoding_group>
+  void parse_double_quoted_string(
+    std::string::size_type end, std::string &output) const;
+  template<internal::encoding_group>
   std::string::size_type scan_unquoted_string() const;
-  std::string parse_unquoted_string(std::string::size_type end) const;
+  std::string_view parse_unquoted_string(std::string::size_type end) const;
 
+  template<internal::encoding_group>
   std::string::size_type scan_glyph(std::string::size_type pos) const;
+  template<internal::encoding_group>
   std::string::size_type
   scan_glyph(std::string::size_type pos, std::string::size_type end) const;
 };
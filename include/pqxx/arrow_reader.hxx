@@ -0,0 +1,192 @@
+/* Definition of the pqxx::arrow_reader class.
+ *
+ * pqxx::arrow_reader turns a binary stream_from into Apache Arrow batches.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/arrow_reader instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_ARROW_READER
+#define PQXX_H_ARROW_READER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pqxx/stream_from.hxx"
+#include "pqxx/time.hxx"
+
+
+// The Apache Arrow C Data Interface.  These definitions are part of the
+// Arrow specification; the guard macro lets them coexist with Arrow's own
+// headers, or those of any other library that defines them.
+#ifndef ARROW_C_DATA_INTERFACE
+#  define ARROW_C_DATA_INTERFACE
+
+#  define ARROW_FLAG_DICTIONARY_ORDERED 1
+#  define ARROW_FLAG_NULLABLE 2
+#  define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C"
+{
+  struct ArrowSchema
+  {
+    // Array type description
+    char const *format;
+    char const *name;
+    char const *metadata;
+    std::int64_t flags;
+    std::int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema *);
+    // Opaque producer-specific data
+    void *private_data;
+  };
+
+  struct ArrowArray
+  {
+    // Array data description
+    std::int64_t length;
+    std::int64_t null_count;
+    std::int64_t offset;
+    std::int64_t n_buffers;
+    std::int64_t n_children;
+    void const **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray *);
+    // Opaque producer-specific data
+    void *private_data;
+  };
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+
+namespace pqxx
+{
+/// Arrow data types which @c arrow_reader and @c arrow_writer support.
+/** Each corresponds to the binary format of one or more PostgreSQL types.
+ * (When writing, the column's type must match the Arrow type exactly: e.g.
+ * an @c int32 only goes into an @c integer column.)
+ */
+enum class arrow_type
+{
+  /// From @c boolean.
+  boolean,
+  /// From @c smallint.
+  int16,
+  /// From @c smallint or @c integer.
+  int32,
+  /// From @c smallint, @c integer, or @c bigint.
+  int64,
+  /// From @c real.
+  float32,
+  /// From @c real or @c double @c precision.
+  float64,
+  /// From @c text, @c varchar, @c char, or @c name.
+  utf8,
+  /// Raw bytes: from @c bytea, or any type's binary format.
+  binary,
+  /// Days since the epoch: from @c date.
+  date32,
+  /// Microseconds since the epoch: from @c timestamp.
+  timestamp,
+  /// Microseconds since the epoch, in UTC: from @c timestamptz.
+  timestamptz,
+};
+
+
+/// Name and type of one column in an Arrow record batch.
+struct arrow_field
+{
+  std::string name;
+  arrow_type type;
+};
+
+
+namespace internal
+{
+/// The Arrow format string for @c type.
+PQXX_LIBEXPORT char const *arrow_format(arrow_type type);
+} // namespace internal
+
+
+/// Read a binary @c stream_from as Apache Arrow record batches.
+/** Converts binary COPY data straight into Arrow's columnar layout: validity
+ * bitmaps, offsets, and value buffers.  No row objects, no text parsing.  The
+ * batches follow the Arrow C Data Interface, so you can hand them to any
+ * library that supports it, such as DuckDB, Polars, or Arrow itself.
+ *
+ * The COPY data has no type information, so you tell the reader what Arrow
+ * type to produce for each column.  The types must fit the columns' binary
+ * formats; see @c arrow_type.  Only the stream's data format matters to the
+ * reader, so it works equally with table streams and query streams.
+ *
+ * @code
+ *	pqxx::stream_from stream{
+ *	  tx, "measurement", std::vector<std::string>{"id", "value"},
+ *	  pqxx::format::binary};
+ *	pqxx::arrow_reader reader{
+ *	  stream, {{"id", pqxx::arrow_type::int64},
+ *	           {"value", pqxx::arrow_type::float64}}};
+ *	ArrowSchema schema;
+ *	reader.export_schema(&schema);
+ *	ArrowArray batch;
+ *	while (reader.read_batch(65536, &batch) > 0)
+ *	  consume(&schema, &batch);	// Takes ownership of the batch.
+ *	stream.complete();
+ * @endcode
+ *
+ * Each exported schema and batch owns its memory, independently of the
+ * reader.  Whoever ends up holding it calls its @c release callback, as the
+ * Arrow specification requires.
+ */
+class PQXX_LIBEXPORT arrow_reader
+{
+public:
+  /**
+   * @param stream A stream in binary format.  It must stay alive for as long
+   *     as you read from the @c arrow_reader.
+   * @param fields Name and Arrow type for each of the stream's columns.
+   */
+  arrow_reader(stream_from &stream, std::vector<arrow_field> fields);
+
+  /// The Arrow schema for the batches: a struct with one child per column.
+  void export_schema(ArrowSchema *out) const;
+
+  /// Read up to @c max_rows rows into an Arrow record batch.
+  /** The batch is a struct array, with one child array per column.
+   *
+   * @return The number of rows read.  At the end of the stream this is zero,
+   *     and @c out is left untouched.
+   */
+  std::size_t read_batch(std::size_t max_rows, ArrowArray *out);
+
+  /// The columns, as passed to the constructor.
+  [[nodiscard]] std::vector<arrow_field> const &fields() const noexcept
+  {
+    return m_fields;
+  }
+
+private:
+  stream_from &m_stream;
+  std::vector<arrow_field> const m_fields;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
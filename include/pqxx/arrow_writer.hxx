@@ -0,0 +1,95 @@
+/* Definition of the pqxx::arrow_writer class.
+ *
+ * pqxx::arrow_writer writes Apache Arrow batches into a binary stream_to.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/arrow_writer instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_ARROW_WRITER
+#define PQXX_H_ARROW_WRITER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <vector>
+
+#include "pqxx/arrow_reader.hxx"
+#include "pqxx/stream_to.hxx"
+
+
+namespace pqxx
+{
+/// Write Apache Arrow record batches into a binary @c stream_to.
+/** Encodes columnar data straight into binary COPY, one column at a time,
+ * without building a row object for each row.  Use this for bulk loads of
+ * data that is already columnar, e.g. from Parquet files.
+ *
+ * The batches follow the Arrow C Data Interface: each is a struct array with
+ * one child array per column, as produced by Arrow itself, or by libraries
+ * such as DuckDB or Polars.  The writer only reads a batch; it does not
+ * release it.
+ *
+ * The column types must match the table's columns exactly.  Binary COPY
+ * does not convert: an @c int64 column only goes into a @c bigint, a
+ * @c float64 only into a @c double @c precision, and so on.
+ *
+ * @code
+ *	pqxx::stream_to stream{
+ *	  tx, "measurement", std::vector<std::string>{"id", "value"},
+ *	  pqxx::format::binary};
+ *	pqxx::arrow_writer writer{stream, schema};
+ *	while (next_batch(&batch))
+ *	{
+ *	  writer.write_batch(batch);
+ *	  batch.release(&batch);
+ *	}
+ *	stream.complete();
+ * @endcode
+ */
+class PQXX_LIBEXPORT arrow_writer
+{
+public:
+  /**
+   * @param stream A stream in binary format.  It must stay alive for as long
+   *     as you write to the @c arrow_writer.
+   * @param types Arrow type of each of the stream's columns.
+   */
+  arrow_writer(stream_to &stream, std::vector<arrow_type> types);
+
+  /// Take the column types from an Arrow schema.
+  /** The schema must be a struct, with one child per column.  The writer
+   * supports only the Arrow types in @c arrow_type.
+   */
+  arrow_writer(stream_to &stream, ArrowSchema const &schema);
+
+  /// Write all rows of an Arrow record batch into the stream.
+  /** The stream's buffer may grow to hold the entire batch, before it goes
+   * to the server.
+   */
+  void write_batch(ArrowArray const &batch);
+
+  /// The column types.
+  [[nodiscard]] std::vector<arrow_type> const &types() const noexcept
+  {
+    return m_types;
+  }
+
+private:
+  stream_to &m_stream;
+  std::vector<arrow_type> const m_types;
+
+  /// Write position for each row of the current batch, in the buffer.
+  /** Kept between batches, to save allocations.
+   */
+  std::vector<std::size_t> m_rows;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
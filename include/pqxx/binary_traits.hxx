@@ -0,0 +1,680 @@
+/* Conversions to and from PostgreSQL's binary data representations.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/binary_traits instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_BINARY_TRAITS
+#define PQXX_H_BINARY_TRAITS
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "pqxx/except.hxx"
+#include "pqxx/strconv.hxx"
+#include "pqxx/util.hxx"
+
+
+namespace pqxx
+{
+/**
+ * @addtogroup stringconversion
+ *
+ * Queries can also return their results in binary format.  That saves the
+ * work of formatting and parsing text, and for numbers it also saves space.
+ * But binary data needs different conversions: the ones defined by
+ * specialisations of @c binary_traits.
+ */
+//@{
+
+/// Traits class for converting to and from PostgreSQL's binary format.
+/** Specialise this template for a type if you want to read it from binary
+ * result fields, or write it in binary format.  There is no generic
+ * definition, so for any type which has no specialisation, binary data is an
+ * error.
+ *
+ * A specialisation for reading defines:
+ *
+ *      static TYPE from_binary(std::string_view data);
+ *
+ * A specialisation for writing defines:
+ *
+ *      static std::size_t binary_size(TYPE const &value);
+ *      static char *into_binary(char *begin, char *end, TYPE const &value);
+ *
+ * Here, @c binary_size returns the exact number of bytes that @c into_binary
+ * will write.  And @c into_binary writes the value's binary representation
+ * starting at @c begin, and returns the address just beyond it.  If the
+ * buffer is too small, it throws @c conversion_overrun.
+ *
+ * A writing specialisation may also define the OID of the SQL type whose
+ * binary format it writes:
+ *
+ *      static constexpr oid type_oid;
+ *
+ * When you pass a value as a binary statement parameter, that tells the
+ * server the parameter's type.
+ *
+ * Binary formats are defined by the PostgreSQL server, per data type.  The
+ * built-in specialisations cover integers, floating-point types, @c bool,
+ * and strings.  A string transfers raw bytes, which makes it suitable for
+ * @c text and @c bytea alike.
+ *
+ * When writing, the C++ type determines the binary format: the server will
+ * not convert from one binary format to another.  So write @c smallint
+ * columns as @c short, @c integer as @c int, @c bigint as @c long @c long,
+ * @c real as @c float, and @c double @c precision as @c double.  Unsigned
+ * types can only be read.
+ */
+template<typename TYPE> struct binary_traits;
+} // namespace pqxx
+
+
+namespace pqxx::internal
+{
+/// Read an integer in network byte order ("big-endian").
+template<typename INT> inline INT from_big_endian(char const data[]) noexcept
+{
+  using unsigned_type = std::make_unsigned_t<INT>;
+  unsigned_type value{0};
+  for (std::size_t i{0}; i < sizeof(INT); ++i)
+    value = static_cast<unsigned_type>(
+      (value << 8) | static_cast<unsigned char>(data[i]));
+  return static_cast<INT>(value);
+}
+
+
+/// Write an integer in network byte order ("big-endian").
+/** Returns the address just beyond the written value.
+ */
+template<typename INT>
+inline char *into_big_endian(char here[], INT value) noexcept
+{
+  using unsigned_type = std::make_unsigned_t<INT>;
+  auto bits{static_cast<unsigned_type>(value)};
+  for (std::size_t i{sizeof(INT)}; i > 0; --i)
+  {
+    here[i - 1] = static_cast<char>(bits & 0xffu);
+    bits = static_cast<unsigned_type>(bits >> 8);
+  }
+  return here + sizeof(INT);
+}
+
+
+/// Throw exception for a buffer too small to hold a binary value.
+[[noreturn]] PQXX_LIBEXPORT void throw_binary_overrun(char const type[]);
+
+
+/// Throw @c conversion_overrun unless the buffer has room for @c size bytes.
+inline void check_binary_space(
+  char const *begin, char const *end, std::size_t size, char const type[])
+{
+  if (end < begin or static_cast<std::size_t>(end - begin) < size)
+    throw_binary_overrun(type);
+}
+
+
+/// Throw exception for binary data of a size that makes no sense for a type.
+[[noreturn]] PQXX_LIBEXPORT void
+throw_binary_size_mismatch(char const type[], std::size_t size);
+
+
+/// Throw if binary data is not of the given size.
+inline void check_binary_size(
+  std::string_view data, std::size_t expected, char const type[])
+{
+  if (data.size() != expected)
+    throw_binary_size_mismatch(type, data.size());
+}
+
+
+/// Binary conversion for integral types.
+/** Accepts any of PostgreSQL's binary integer sizes, so long as the value
+ * fits in @c T.
+ */
+template<typename T> struct integral_binary_traits
+{
+  [[nodiscard]] static T from_binary(std::string_view data)
+  {
+    switch (data.size())
+    {
+    case 2:
+      return check_cast<T>(
+        from_big_endian<std::int16_t>(data.data()), "binary smallint");
+    case 4:
+      return check_cast<T>(
+        from_big_endian<std::int32_t>(data.data()), "binary integer");
+    case 8:
+      return check_cast<T>(
+        from_big_endian<std::int64_t>(data.data()), "binary bigint");
+    default: throw_binary_size_mismatch("integer", data.size());
+    }
+  }
+};
+
+
+/// Binary conversion for signed integral types, in both directions.
+/** Writes a value in the binary format for an integer of the same size.
+ */
+template<typename T>
+struct signed_binary_traits : integral_binary_traits<T>
+{
+  static_assert(sizeof(T) == 2 or sizeof(T) == 4 or sizeof(T) == 8);
+
+  /// OID of @c smallint, @c integer, or @c bigint, depending on size.
+  static constexpr oid type_oid{
+    (sizeof(T) == 2) ? 21u : ((sizeof(T) == 4) ? 23u : 20u)};
+
+  [[nodiscard]] static constexpr std::size_t binary_size(T const &) noexcept
+  {
+    return sizeof(T);
+  }
+
+  static char *into_binary(char *begin, char *end, T const &value)
+  {
+    check_binary_space(begin, end, sizeof(T), "integer");
+    return into_big_endian(begin, value);
+  }
+};
+
+
+/// Binary conversion for floating-point types.
+/** Accepts both @c real and @c double @c precision values.
+ */
+template<typename T> struct float_binary_traits
+{
+  [[nodiscard]] static T from_binary(std::string_view data)
+  {
+    if (data.size() == sizeof(std::uint32_t))
+    {
+      auto const bits{from_big_endian<std::uint32_t>(data.data())};
+      float value;
+      static_assert(sizeof(value) == sizeof(bits));
+      std::memcpy(&value, &bits, sizeof(value));
+      return static_cast<T>(value);
+    }
+    check_binary_size(data, sizeof(std::uint64_t), "floating-point number");
+    auto const bits{from_big_endian<std::uint64_t>(data.data())};
+    double value;
+    static_assert(sizeof(value) == sizeof(bits));
+    std::memcpy(&value, &bits, sizeof(value));
+    return static_cast<T>(value);
+  }
+
+  /// A @c float becomes a @c real; anything else a @c double @c precision.
+  using wire_type =
+    std::conditional_t<std::is_same_v<T, float>, float, double>;
+
+  /// OID of @c real or @c double @c precision.
+  static constexpr oid type_oid{(sizeof(wire_type) == 4) ? 700u : 701u};
+
+  [[nodiscard]] static constexpr std::size_t binary_size(T const &) noexcept
+  {
+    return sizeof(wire_type);
+  }
+
+  static char *into_binary(char *begin, char *end, T const &value)
+  {
+    using bits_type = std::conditional_t<
+      sizeof(wire_type) == 4, std::uint32_t, std::uint64_t>;
+    static_assert(sizeof(bits_type) == sizeof(wire_type));
+    check_binary_space(begin, end, sizeof(wire_type), "floating-point number");
+    auto const wire_value{static_cast<wire_type>(value)};
+    bits_type bits;
+    std::memcpy(&bits, &wire_value, sizeof(bits));
+    return into_big_endian(begin, bits);
+  }
+};
+
+
+/// Binary conversion to raw bytes, for string-like types.
+template<typename T> struct raw_binary_traits
+{
+  [[nodiscard]] static std::size_t binary_size(T const &value) noexcept
+  {
+    return std::string_view{value}.size();
+  }
+
+  static char *into_binary(char *begin, char *end, T const &value)
+  {
+    std::string_view const data{value};
+    check_binary_space(begin, end, data.size(), "string");
+    data.copy(begin, data.size());
+    return begin + data.size();
+  }
+};
+
+
+/// Detect whether binary_traits are defined for a type.
+template<typename T, typename = void>
+struct has_binary_traits : std::false_type
+{};
+
+template<typename T>
+struct has_binary_traits<
+  T, std::void_t<decltype(binary_traits<T>::from_binary(std::string_view{}))>>
+        : std::true_type
+{};
+
+
+/// The SQL type OID which a type's binary output represents, if known.
+template<typename T, typename = void>
+struct binary_type_oid : std::integral_constant<oid, oid_none>
+{};
+
+template<typename T>
+struct binary_type_oid<T, std::void_t<decltype(binary_traits<T>::type_oid)>>
+        : std::integral_constant<oid, binary_traits<T>::type_oid>
+{};
+
+
+/// Detect whether binary_traits for a type support writing.
+template<typename T, typename = void>
+struct has_binary_output : std::false_type
+{};
+
+template<typename T>
+struct has_binary_output<
+  T, std::void_t<decltype(binary_traits<T>::into_binary(
+       nullptr, nullptr, std::declval<T const &>()))>> : std::true_type
+{};
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Can values of this type be read from binary fields?
+template<typename T>
+inline constexpr bool has_binary_traits{internal::has_binary_traits<T>::value};
+
+/// Can values of this type be written in binary format?
+template<typename T>
+inline constexpr bool has_binary_output{internal::has_binary_output<T>::value};
+
+
+template<> struct binary_traits<short> : internal::signed_binary_traits<short>
+{};
+template<>
+struct binary_traits<unsigned short>
+        : internal::integral_binary_traits<unsigned short>
+{};
+template<> struct binary_traits<int> : internal::signed_binary_traits<int>
+{};
+template<>
+struct binary_traits<unsigned> : internal::integral_binary_traits<unsigned>
+{};
+template<> struct binary_traits<long> : internal::signed_binary_traits<long>
+{};
+template<>
+struct binary_traits<unsigned long>
+        : internal::integral_binary_traits<unsigned long>
+{};
+template<>
+struct binary_traits<long long> : internal::signed_binary_traits<long long>
+{};
+template<>
+struct binary_traits<unsigned long long>
+        : internal::integral_binary_traits<unsigned long long>
+{};
+template<> struct binary_traits<float> : internal::float_binary_traits<float>
+{};
+template<> struct binary_traits<double> : internal::float_binary_traits<double>
+{};
+template<>
+struct binary_traits<long double> : internal::float_binary_traits<long double>
+{};
+
+
+template<> struct binary_traits<bool>
+{
+  static constexpr oid type_oid{16};
+
+  [[nodiscard]] static bool from_binary(std::string_view data)
+  {
+    internal::check_binary_size(data, 1, "boolean");
+    return data[0] != '\0';
+  }
+
+  [[nodiscard]] static constexpr std::size_t binary_size(bool const &) noexcept
+  {
+    return 1;
+  }
+
+  static char *into_binary(char *begin, char *end, bool const &value)
+  {
+    internal::check_binary_space(begin, end, 1, "boolean");
+    *begin = value ? '\1' : '\0';
+    return begin + 1;
+  }
+};
+
+
+/// A string receives the field's raw bytes, whatever its type.
+template<>
+struct binary_traits<std::string> : internal::raw_binary_traits<std::string>
+{
+  [[nodiscard]] static std::string from_binary(std::string_view data)
+  {
+    return std::string{data};
+  }
+};
+
+
+/// A view on the field's raw bytes.
+/** The view is valid only as long as the result object, or a copy of it,
+ * exists.
+ */
+template<>
+struct binary_traits<std::string_view>
+        : internal::raw_binary_traits<std::string_view>
+{
+  [[nodiscard]] static std::string_view
+  from_binary(std::string_view data) noexcept
+  {
+    return data;
+  }
+};
+
+
+/// A zero-terminated view on the field's raw bytes.
+/** Like the @c std::string_view conversion, but libpq also terminates each
+ * binary value with a zero byte.  The data itself may contain zero bytes as
+ * well, so don't rely on @c c_str() to tell you where it ends.
+ */
+template<> struct binary_traits<zview> : internal::raw_binary_traits<zview>
+{
+  [[nodiscard]] static zview from_binary(std::string_view data) noexcept
+  {
+    return zview{data};
+  }
+};
+
+
+/// A C-style string can be written as raw bytes, but not read.
+template<>
+struct binary_traits<char const *> : internal::raw_binary_traits<char const *>
+{};
+
+
+/// A C-style string can be written as raw bytes, but not read.
+template<> struct binary_traits<char *> : internal::raw_binary_traits<char *>
+{};
+
+
+/// Raw bytes from a C-style string literal, without the terminating zero.
+template<std::size_t N> struct binary_traits<char[N]>
+{
+  [[nodiscard]] static std::size_t binary_size(char const (&value)[N]) noexcept
+  {
+    return std::string_view{value}.size();
+  }
+
+  static char *into_binary(char *begin, char *end, char const (&value)[N])
+  {
+    return binary_traits<std::string_view>::into_binary(
+      begin, end, std::string_view{value});
+  }
+};
+
+
+/// An @c optional reads and writes its contained type from binary.
+/** Nulls never get here; they arrive as empty @c optional values.
+ */
+template<typename T> struct binary_traits<std::optional<T>>
+{
+  static constexpr oid type_oid{internal::binary_type_oid<T>::value};
+
+  // Templated only so that this drops out of overload resolution, and thus
+  // has_binary_traits, if @c T has no binary conversion.
+  template<typename U = T>
+  [[nodiscard]] static auto from_binary(std::string_view data)
+    -> decltype(binary_traits<U>::from_binary(data), std::optional<T>{})
+  {
+    return std::optional<T>{
+      std::in_place, binary_traits<U>::from_binary(data)};
+  }
+
+  /// Size of a non-null value.
+  template<typename U = T>
+  [[nodiscard]] static auto binary_size(std::optional<T> const &value)
+    -> decltype(binary_traits<U>::binary_size(*value))
+  {
+    return binary_traits<U>::binary_size(*value);
+  }
+
+  /// Write a non-null value.
+  template<typename U = T>
+  static auto
+  into_binary(char *begin, char *end, std::optional<T> const &value)
+    -> decltype(binary_traits<U>::into_binary(begin, end, *value))
+  {
+    return binary_traits<U>::into_binary(begin, end, *value);
+  }
+};
+} // namespace pqxx
+
+
+namespace pqxx::internal
+{
+/// OID of the SQL array type whose elements have type @c element.
+/** Returns @c oid_none if we don't know that array type.
+ */
+constexpr oid array_type_oid(oid element) noexcept
+{
+  switch (element)
+  {
+  case 16: return 1000;  // bool
+  case 20: return 1016;  // bigint
+  case 21: return 1005;  // smallint
+  case 23: return 1007;  // integer
+  case 700: return 1021; // real
+  case 701: return 1022; // double precision
+  default: return oid_none;
+  }
+}
+
+
+/// Can we write binary SQL arrays with elements of type @c T?
+template<typename T>
+inline constexpr bool is_binary_array_element{
+  has_binary_output<T>::value and
+  (array_type_oid(binary_type_oid<T>::value) != oid_none)};
+
+
+/// Binary conversion for one-dimensional SQL arrays.
+/** The binary array format starts with a header: the number of dimensions,
+ * a "has nulls" flag, and the element type's OID.  Then for each dimension
+ * come its size and its lower bound.  Finally, each element is a 4-byte
+ * length (or -1 for a null) followed by the element's own binary format.
+ *
+ * Reads any one-dimensional array whose elements @c ELT can read.  Writes
+ * only arrays of elements whose SQL type we know, since the server checks
+ * the element type.
+ */
+template<typename CONTAINER, typename ELT> struct binary_array_traits
+{
+  static constexpr oid type_oid{array_type_oid(binary_type_oid<ELT>::value)};
+
+  // Templated only so that this drops out of overload resolution, and thus
+  // has_binary_traits, if @c ELT has no binary conversion.
+  template<typename U = ELT>
+  [[nodiscard]] static auto from_binary(std::string_view data)
+    -> decltype(binary_traits<U>::from_binary(data), CONTAINER{})
+  {
+    if (data.size() < header_size)
+      throw_binary_size_mismatch("array", data.size());
+    auto const dimensions{from_big_endian<std::int32_t>(data.data())};
+    std::size_t elements{0};
+    std::size_t here{header_size};
+    if (dimensions == 1)
+    {
+      if (data.size() < header_size + dimension_size)
+        throw_binary_size_mismatch("array", data.size());
+      elements = static_cast<std::size_t>(
+        check_cast<std::uint32_t>(
+          from_big_endian<std::int32_t>(data.data() + here),
+          "binary array size"));
+      here += dimension_size;
+    }
+    else if (dimensions != 0)
+    {
+      throw conversion_error{
+        "Can only read one-dimensional binary arrays, not " +
+        to_string(dimensions) + "-dimensional ones."};
+    }
+
+    CONTAINER out{};
+    if constexpr (is_vector)
+    {
+      out.reserve(elements);
+    }
+    else if (elements != std::size(out))
+    {
+      throw conversion_error{
+        "Binary array has " + to_string(elements) + " elements; expected " +
+        to_string(std::size(out)) + "."};
+    }
+
+    for (std::size_t i{0}; i < elements; ++i)
+    {
+      if (data.size() - here < sizeof(std::int32_t))
+        throw_binary_size_mismatch("array", data.size());
+      auto const length{from_big_endian<std::int32_t>(data.data() + here)};
+      here += sizeof(std::int32_t);
+      if (length < 0)
+      {
+        if constexpr (nullness<ELT>::has_null)
+          store(out, i, nullness<ELT>::null());
+        else
+          throw_null_conversion(name_type<ELT>());
+      }
+      else
+      {
+        auto const size{static_cast<std::size_t>(length)};
+        if (data.size() - here < size)
+          throw_binary_size_mismatch("array", data.size());
+        store(
+          out, i, binary_traits<U>::from_binary(data.substr(here, size)));
+        here += size;
+      }
+    }
+    return out;
+  }
+
+  template<typename U = ELT>
+  [[nodiscard]] static auto binary_size(CONTAINER const &value)
+    -> std::enable_if_t<is_binary_array_element<U>, std::size_t>
+  {
+    std::size_t size{header_size};
+    if (not std::empty(value))
+      size += dimension_size;
+    for (auto const &elt : value)
+    {
+      size += sizeof(std::int32_t);
+      if (not nullness<ELT>::is_null(elt))
+        size += binary_traits<U>::binary_size(elt);
+    }
+    return size;
+  }
+
+  template<typename U = ELT>
+  static auto into_binary(char *begin, char *end, CONTAINER const &value)
+    -> std::enable_if_t<is_binary_array_element<U>, char *>
+  {
+    check_binary_space(begin, end, binary_size(value), "array");
+    auto const elements{std::size(value)};
+    bool has_nulls{false};
+    for (auto const &elt : value)
+      if (nullness<ELT>::is_null(elt))
+        has_nulls = true;
+
+    auto here{into_big_endian(begin, std::int32_t{elements != 0})};
+    here = into_big_endian(here, std::int32_t{has_nulls});
+    here = into_big_endian(here, binary_type_oid<ELT>::value);
+    if (elements != 0)
+    {
+      here = into_big_endian(
+        here, check_cast<std::int32_t>(elements, "binary array size"));
+      // Lower bound.  SQL arrays normally start at 1.
+      here = into_big_endian(here, std::int32_t{1});
+    }
+    for (auto const &elt : value)
+    {
+      if (nullness<ELT>::is_null(elt))
+      {
+        here = into_big_endian(here, std::int32_t{-1});
+      }
+      else
+      {
+        auto const size{binary_traits<U>::binary_size(elt)};
+        here = into_big_endian(
+          here, check_cast<std::int32_t>(size, "binary array element"));
+        here = binary_traits<U>::into_binary(here, end, elt);
+      }
+    }
+    return here;
+  }
+
+private:
+  /// Size of the header: dimensions, flags, and element type.
+  static constexpr std::size_t header_size{3 * sizeof(std::int32_t)};
+  /// Size of one dimension's description: size, and lower bound.
+  static constexpr std::size_t dimension_size{2 * sizeof(std::int32_t)};
+
+  static constexpr bool is_vector{
+    std::is_same_v<CONTAINER, std::vector<ELT>>};
+
+  static void store(CONTAINER &out, std::size_t index, ELT &&value)
+  {
+    if constexpr (is_vector)
+    {
+      ignore_unused(index);
+      out.push_back(std::move(value));
+    }
+    else
+    {
+      out[index] = std::move(value);
+    }
+  }
+};
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// A @c std::vector reads and writes one-dimensional binary SQL arrays.
+/** Writing works for elements of type @c bool, @c short, @c int,
+ * @c long @c long, @c float, and @c double, or @c std::optional of those.
+ */
+template<typename T>
+struct binary_traits<std::vector<T>>
+        : internal::binary_array_traits<std::vector<T>, T>
+{};
+
+
+/// A @c std::array reads and writes one-dimensional binary SQL arrays.
+/** Reading throws @c conversion_error unless the SQL array has exactly
+ * @c N elements.
+ */
+template<typename T, std::size_t N>
+struct binary_traits<std::array<T, N>>
+        : internal::binary_array_traits<std::array<T, N>, T>
+{};
+//@}
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
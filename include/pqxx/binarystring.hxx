@@ -18,6 +18,7 @@
 #include <string>
 #include <string_view>
 
+#include "pqxx/binary_traits.hxx"
 #include "pqxx/result.hxx"
 
 namespace pqxx
@@ -67,6 +68,11 @@ public:
   /// Read and unescape bytea field.
   /** The field will be zero-terminated, even if the original bytea field
    * isn't.
+   *
+   * If the field is in binary format, the binarystring does not copy the
+   * data.  Instead it shares ownership of the result's data, which therefore
+   * stays in memory for as long as the binarystring or a copy of it exists.
+   *
    * @param F the field to read; must be a bytea field
    */
   explicit binarystring(field const &);
@@ -154,6 +160,28 @@ private:
   std::shared_ptr<value_type> m_buf;
   size_type m_size{0};
 };
+
+
+/// In binary format, a @c bytea is just its raw bytes.
+template<> struct binary_traits<binarystring>
+{
+  [[nodiscard]] static binarystring from_binary(std::string_view data)
+  {
+    return binarystring{data};
+  }
+
+  [[nodiscard]] static std::size_t
+  binary_size(binarystring const &value) noexcept
+  {
+    return value.size();
+  }
+
+  static char *into_binary(char *begin, char *end, binarystring const &value)
+  {
+    return binary_traits<std::string_view>::into_binary(
+      begin, end, value.view());
+  }
+};
 } // namespace pqxx
 
 #include "pqxx/internal/compiler-internal-post.hxx"
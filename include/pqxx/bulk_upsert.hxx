@@ -0,0 +1,148 @@
+/* Definition of the pqxx::bulk_upsert class.
+ *
+ * pqxx::bulk_upsert merges streamed rows into a table, through a staging
+ * table.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/bulk_upsert instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_BULK_UPSERT
+#define PQXX_H_BULK_UPSERT
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pqxx/separated_list.hxx"
+#include "pqxx/stream_to.hxx"
+
+
+namespace pqxx
+{
+/// Insert or update many rows at COPY speed.
+/** A @c stream_to is the fastest way to get rows into a table, but it can
+ * only insert.  This class streams your rows into a temporary staging table
+ * instead, and then merges them into the real table in a single
+ * <tt>INSERT ... SELECT</tt> statement, with an @c ON @c CONFLICT clause of
+ * your choosing.
+ *
+ * The staging table has just the columns you name, with the same types as in
+ * the real table, but without constraints or defaults.  Being temporary, it
+ * is also unlogged.  Once the merge is done, the table is dropped.  If
+ * something goes wrong before then, it goes away when the transaction ends.
+ *
+ * @code
+ *	pqxx::bulk_upsert up{
+ *	  tx, "item", {"id", "price"},
+ *	  "ON CONFLICT (id) DO UPDATE SET price = excluded.price"};
+ *	for (auto const &[id, price] : prices) up << std::tuple{id, price};
+ *	auto const merged{up.complete()};
+ * @endcode
+ *
+ * The table and column names go into the SQL as they are.  Quote them with
+ * @c quote_name() as needed.
+ *
+ * As with a @c stream_to, you can't use the transaction for anything else
+ * until you call @c complete().
+ */
+class PQXX_LIBEXPORT bulk_upsert
+{
+public:
+  /// Start an upsert into @c table, on the columns in @c columns.
+  /**
+   * @param tx The transaction to work in.
+   * @param table The table to merge the rows into.
+   * @param columns The columns for which you will write values, in order.
+   * @param conflict What to do with rows that clash with existing ones, e.g.
+   *     <tt>ON CONFLICT (id) DO UPDATE SET x = excluded.x</tt>.
+   * @param data_format Stream the rows in text or binary COPY format.  See
+   *     @c stream_to.
+   */
+  template<typename COLUMNS>
+  bulk_upsert(
+    transaction_base &tx, std::string_view table, COLUMNS const &columns,
+    std::string_view conflict, format data_format = format::text) :
+          bulk_upsert{
+            tx, table, separated_list(",", columns), conflict, data_format,
+            nullptr}
+  {}
+
+  bulk_upsert(
+    transaction_base &tx, std::string_view table,
+    std::initializer_list<std::string_view> columns,
+    std::string_view conflict, format data_format = format::text) :
+          bulk_upsert{
+            tx, table, separated_list(",", columns), conflict, data_format,
+            nullptr}
+  {}
+
+  /// Write a row, as you would to a @c stream_to.
+  template<typename TUPLE> bulk_upsert &operator<<(TUPLE const &row)
+  {
+    m_stream << row;
+    return *this;
+  }
+
+  /// Weed out rows whose key is the same as an earlier row's.
+  /** Merging two rows with the same key in one statement is an error, even
+   * with @c ON @c CONFLICT @c DO @c UPDATE.  This drops the duplicates in the
+   * stream, before they go to the server: see @c stream_to::set_dedup().  The
+   * key consists of the columns in positions @c key in your rows, counting
+   * from zero.  The first row with a given key wins.
+   *
+   * If the stream's set of keys fills up, some duplicates will get into the
+   * staging table.  In that case the merge weeds them out, using
+   * @c SELECT @c DISTINCT @c ON.  Which of those duplicates wins is then up
+   * to the server.
+   */
+  void set_dedup(
+    std::vector<row_size_type> key,
+    std::size_t max_memory = stream_to::default_dedup_memory);
+
+  /// The stream into the staging table.
+  /** Use this to tune its buffer, say, or to load a file into it.
+   */
+  [[nodiscard]] stream_to &stream() noexcept { return m_stream; }
+
+  /// Finish streaming, merge the rows into the table, and drop the staging.
+  /** The merge and the drop go to the server together, in one round trip.
+   *
+   * @return The number of rows the merge inserted or updated.
+   */
+  std::size_t complete();
+
+private:
+  /// The constructor that does the work.
+  /** The last parameter only tells it apart from the public constructors.
+   */
+  bulk_upsert(
+    transaction_base &tx, std::string_view table, std::string &&columns,
+    std::string_view conflict, format data_format, std::nullptr_t);
+
+  transaction_base &m_tx;
+  /// The columns, as a comma-separated list.  Empty means "all columns."
+  std::string const m_columns;
+  /// The staging table's name.
+  std::string const m_staging;
+  std::string const m_table;
+  /// The @c ON @c CONFLICT clause for the merge.
+  std::string const m_conflict;
+  /// Key columns for weeding out duplicates, if any.
+  std::vector<row_size_type> m_key;
+  stream_to m_stream;
+  bool m_done = false;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,172 @@
+/* Definition of the pqxx::chunked_field_stream class, and its buffer.
+ *
+ * pqxx::chunked_field_stream reads one huge field value in chunks.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/chunked_field instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_CHUNKED_FIELD
+#define PQXX_H_CHUNKED_FIELD
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <istream>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "pqxx/pipeline.hxx"
+#include "pqxx/transaction_base.hxx"
+
+
+namespace pqxx
+{
+/// How a @c chunked_field_buf fetches its value.
+struct field_chunks
+{
+  /// Characters (for @c text) or bytes (for @c bytea) per query.
+  std::size_t chunk_size = 1024 * 1024;
+  /// Number of queries to keep in flight beyond the chunk being read.
+  std::size_t readahead = 2;
+};
+
+
+/// Stream buffer for reading one huge @c text or @c bytea value in chunks.
+/** Reading a field of hundreds of megabytes the normal way holds the whole
+ * value in the result, and for @c bytea, once more after unescaping.  This
+ * reads it a chunk at a time instead, using the server's @c substr().  So
+ * memory stays bounded however big the value is: roughly
+ * @c field_chunks::readahead + 1 chunks.
+ *
+ * You pass a query which produces the value, as a single row with a single
+ * column, plus its parameters.  The buffer wraps it into a query for each
+ * chunk, so the server runs it once per chunk.  Make it cheap, e.g. a lookup
+ * by primary key:
+ *
+ * @code
+ *	pqxx::chunked_field_stream in{
+ *	  tx, "SELECT data FROM file WHERE id = $1", file_id};
+ *	out << in.rdbuf();
+ * @endcode
+ *
+ * The chunk queries go through a @c pipeline, so the next few are already
+ * underway while you read the current one.  While the buffer is reading, the
+ * transaction is busy: don't execute anything else on it until you have read
+ * up to the end, or destroyed the buffer.  Destroying it early still waits
+ * for the chunks that are in flight.
+ *
+ * A null value reads as an empty stream.  If the query produces anything but
+ * a single row, reading throws @c unexpected_rows.
+ */
+class PQXX_LIBEXPORT chunked_field_buf : public std::streambuf
+{
+public:
+  /// Read the value that @c query produces, in default-sized chunks.
+  template<typename... Args>
+  chunked_field_buf(
+    transaction_base &tx, std::string_view query, Args &&... args) :
+          chunked_field_buf{
+            tx, field_chunks{}, query, std::forward<Args>(args)...}
+  {}
+
+  /// Read the value that @c query produces, in chunks as given.
+  template<typename... Args>
+  chunked_field_buf(
+    transaction_base &tx, field_chunks chunks, std::string_view query,
+    Args &&... args) :
+          m_trans{tx},
+          m_chunks{chunks},
+          m_params{std::forward<Args>(args)...}
+  {
+    m_params.own();
+    init(query);
+  }
+
+  chunked_field_buf(chunked_field_buf const &) = delete;
+  chunked_field_buf &operator=(chunked_field_buf const &) = delete;
+  ~chunked_field_buf() noexcept override;
+
+  /// Number of chunk queries executed so far.
+  [[nodiscard]] std::size_t fetches() const noexcept { return m_fetches; }
+
+protected:
+  int_type underflow() override;
+
+private:
+  /// Compose the chunk query around @c query.
+  void PQXX_PRIVATE init(std::string_view query);
+  /// Put more chunk queries in flight, up to the read-ahead.
+  void PQXX_PRIVATE issue();
+  /// We've seen the end.  Drain the chunks that are still in flight.
+  void PQXX_PRIVATE finish();
+
+  transaction_base &m_trans;
+  field_chunks const m_chunks;
+  /// The caller's query parameters.
+  internal::params m_params;
+  /// The query that fetches a chunk.
+  std::string m_query;
+  std::optional<pipeline> m_pipe;
+  /// The chunk that the get area points into.
+  result m_current;
+  /// Unescaped @c bytea data of the current chunk.
+  std::string m_buffer;
+  /// Where the next chunk to request starts, counting from 1.
+  std::size_t m_next = 1;
+  std::size_t m_in_flight = 0;
+  std::size_t m_fetches = 0;
+  /// Have we seen the end of the value?
+  bool m_end = false;
+};
+
+
+/// Input stream that reads one huge @c text or @c bytea value in chunks.
+/** Use this as you would any other @c std::istream.  See
+ * @c chunked_field_buf for how it works.
+ */
+class PQXX_LIBEXPORT chunked_field_stream : public std::istream
+{
+public:
+  /// Read the value that @c query produces, in default-sized chunks.
+  template<typename... Args>
+  chunked_field_stream(
+    transaction_base &tx, std::string_view query, Args &&... args) :
+          std::istream{nullptr},
+          m_buf{tx, query, std::forward<Args>(args)...}
+  {
+    init(&m_buf);
+  }
+
+  /// Read the value that @c query produces, in chunks as given.
+  template<typename... Args>
+  chunked_field_stream(
+    transaction_base &tx, field_chunks chunks, std::string_view query,
+    Args &&... args) :
+          std::istream{nullptr},
+          m_buf{tx, chunks, query, std::forward<Args>(args)...}
+  {
+    init(&m_buf);
+  }
+
+  /// Number of chunk queries executed so far.
+  [[nodiscard]] std::size_t fetches() const noexcept
+  {
+    return m_buf.fetches();
+  }
+
+private:
+  chunked_field_buf m_buf;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
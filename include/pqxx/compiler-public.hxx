@@ -106,4 +106,11 @@
 #  define PQXX_NOVTABLE
 #endif
 
+
+// Polymorphic memory resources, for allocating from arenas.  Some standard
+// libraries don't have them yet.
+#if __has_include(<memory_resource>)
+#  define PQXX_HAVE_PMR
+#endif
+
 #endif
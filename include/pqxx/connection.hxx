@@ -16,13 +16,22 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "pqxx/errorhandler.hxx"
 #include "pqxx/except.hxx"
+#include "pqxx/internal/encoding_group.hxx"
 #include "pqxx/prepared_statement.hxx"
 #include "pqxx/strconv.hxx"
 #include "pqxx/util.hxx"
@@ -58,7 +67,14 @@
 
 namespace pqxx::internal
 {
+class slow_query_log;
 class sql_cursor;
+
+/// Free memory that libpq allocated.  Wraps @c PQfreemem.
+void PQXX_LIBEXPORT pq_freemem(void const *) noexcept;
+
+/// A buffer allocated by libpq.
+using pq_buffer = std::unique_ptr<char, void (*)(void const *)>;
 } // namespace pqxx::internal
 
 
@@ -67,10 +83,14 @@ namespace pqxx::internal::gate
 class connection_dbtransaction;
 class connection_errorhandler;
 class connection_largeobject;
+class connection_notification_publisher;
 class connection_notification_receiver;
 class connection_pipeline;
+class connection_reactor;
+class connection_replication_stream;
 class connection_sql_cursor;
 class connection_stream_from;
+class connection_stream_query;
 class connection_stream_to;
 class connection_transaction;
 class const_connection_largeobject;
@@ -101,6 +121,217 @@ enum class error_verbosity : int
 };
 
 
+/// What the server says about a table's columns.
+/** See @c connection::describe_table().
+ */
+struct table_description
+{
+  /// The table's name, as you passed it to @c connection::describe_table().
+  std::string name;
+  /// The names of the table's columns, in the table's order.
+  std::vector<std::string> column_names;
+  /// The types of the table's columns.
+  std::vector<oid> column_types;
+  /// All the table's column names, quoted, and separated by commas.
+  std::string column_list;
+
+  /// Can we read the table's columns as @c TYPE... in binary format?
+  /** True if there is one type for each column, and each of the types has
+   * @c binary_traits for exactly that column's SQL type.
+   */
+  template<typename... TYPE> [[nodiscard]] bool binary_readable() const
+  {
+    if (std::size(column_types) != sizeof...(TYPE))
+      return false;
+    std::size_t col{0};
+    return (
+      (pqxx::has_binary_traits<TYPE> and
+       pqxx::internal::binary_type_oid<TYPE>::value != oid_none and
+       pqxx::internal::binary_type_oid<TYPE>::value == column_types[col++]) and
+      ...);
+  }
+
+  /// Can we write @c TYPE... to the table's columns in binary format?
+  /** True if there is one type for each column, and each of the types has
+   * @c binary_traits which can write exactly that column's SQL type.
+   */
+  template<typename... TYPE> [[nodiscard]] bool binary_writable() const
+  {
+    if (std::size(column_types) != sizeof...(TYPE))
+      return false;
+    std::size_t col{0};
+    return (
+      (pqxx::has_binary_output<TYPE> and
+       pqxx::internal::binary_type_oid<TYPE>::value != oid_none and
+       pqxx::internal::binary_type_oid<TYPE>::value == column_types[col++]) and
+      ...);
+  }
+};
+
+
+/// What one query, batch of queries, or COPY cost.
+/** A connection passes these to its query hook, if it has one.
+ */
+struct PQXX_LIBEXPORT query_stats
+{
+  /// What sort of operation this was.
+  enum class kind
+  {
+    /// A query, with or without parameters.
+    query,
+    /// Execution of a prepared statement.
+    prepared,
+    /// A batch of statements, sent in one go and answered in one go.
+    batch,
+    /// A COPY to or from a table stream, from start to finish.
+    copy
+  };
+
+  kind what = kind::query;
+  /// Query text, or prepared statement name.  Valid only during the call.
+  std::string_view query;
+  /// Wall time, from sending the query until it was done.
+  std::chrono::steady_clock::duration elapsed{0};
+  /// Time until the first result came in.
+  /** For a single query, that's the same as @c elapsed since libpq only
+   * hands out complete results.  For a batch, it's when the first statement's
+   * result came in.  For a COPY, it's when data first came in, or when the
+   * server accepted the COPY if it's a COPY into the database.
+   */
+  std::chrono::steady_clock::duration first_result{0};
+  /// Rows returned, or affected.  For a batch, the total.
+  result_size_type rows = 0;
+  /// Number of statements.
+  std::size_t statements = 1;
+  /// Bytes of query text, parameters, and COPY data sent.
+  std::size_t bytes_sent = 0;
+  /// Bytes of result data, and COPY data, received.
+  /** For results, this is their size in memory, which is close to the size
+   * on the wire.
+   */
+  std::size_t bytes_received = 0;
+  /// For a COPY: time spent waiting for COPY data to come in or go out.
+  /** The rest of the time went into the client's own work, such as
+   * converting data, and into the server's.
+   */
+  std::chrono::steady_clock::duration blocked{0};
+  /// Did the operation fail?
+  bool failed = false;
+};
+
+
+/// Rows, bytes, and waiting time of a table stream so far.
+/** See @c stream_from::stats() and @c stream_to::stats().  If a stream spends
+ * most of its time @c blocked, it's waiting for the network or the server.
+ * If not, it's the client's own work, such as converting data, which holds
+ * it up.
+ */
+struct PQXX_LIBEXPORT stream_stats
+{
+  /// Rows read or written.
+  std::size_t rows = 0;
+  /// Bytes of COPY data received or sent.
+  std::size_t bytes = 0;
+  /// Time since the stream started, or until it finished.
+  std::chrono::steady_clock::duration elapsed{0};
+  /// Time spent waiting for COPY data to come in, or to go out.
+  std::chrono::steady_clock::duration blocked{0};
+};
+
+
+/// Callback for query statistics.  It must not throw.
+using query_hook = std::function<void(query_stats const &)>;
+
+
+/// Round trips, statements, and traffic of a transaction so far.
+/** See @c transaction_base::collect_stats().
+ */
+struct PQXX_LIBEXPORT transaction_stats
+{
+  /// Number of times the transaction waited for the server.
+  /** A batch of statements sent in one go, or a whole COPY, counts as one.
+   */
+  std::size_t round_trips = 0;
+  /// Number of statements, including BEGIN and COMMIT.
+  std::size_t statements = 0;
+  /// Bytes of query text, parameters, and COPY data sent.
+  std::size_t bytes_sent = 0;
+  /// Bytes of result data, and COPY data, received.
+  std::size_t bytes_received = 0;
+  /// Most times that any one query, or prepared statement, has executed.
+  /** A high number here often means an "N+1" pattern: a query in a loop,
+   * where a single query for all rows would do.
+   */
+  std::size_t most_repeats = 0;
+};
+
+
+/// When a transaction should report that it's doing too much work.
+struct PQXX_LIBEXPORT stats_limits
+{
+  /// Alert when the transaction goes over this many round trips.
+  /** Zero means no limit. */
+  std::size_t round_trips = 0;
+  /// Alert when the transaction runs the same query more than this often.
+  /** Zero means no limit. */
+  std::size_t repeats = 0;
+};
+
+
+/// Callback for a transaction that goes over its @c stats_limits.
+/** Receives the transaction, its statistics so far, and the query or prepared
+ * statement that crossed the limit.  It fires once when the transaction goes
+ * over its round trip limit, and once for each query that goes over the
+ * repeat limit.
+ *
+ * It must not throw.
+ */
+using stats_alert = std::function<void(
+  transaction_base const &, transaction_stats const &, std::string_view)>;
+
+
+/// Settings for a connection's slow query log.
+/** See @c connection::set_slow_query_log().
+ */
+struct PQXX_LIBEXPORT slow_query_config
+{
+  /// Log queries that take at least this long.
+  std::chrono::steady_clock::duration threshold{
+    std::chrono::milliseconds{100}};
+  /// Keep the most recent this-many slow queries.  Must be at least 1.
+  std::size_t capacity = 64;
+  /// Capture a query plan for one in every this-many slow queries.
+  /** Zero means never.  One means for every slow query.
+   */
+  std::size_t explain_every = 0;
+  /// Connection string for the side connection that runs @c EXPLAIN.
+  /** If empty, the side connection uses this connection's own parameters.
+   */
+  std::string explain_options;
+};
+
+
+/// A query that a connection's slow query log caught.
+struct PQXX_LIBEXPORT slow_query
+{
+  query_stats::kind what = query_stats::kind::query;
+  /// Query text, or prepared statement name.
+  std::string query;
+  /// Parameter values, as text.  Binary ones are in @c bytea hex format.
+  std::vector<std::optional<std::string>> parameters;
+  /// When the query completed.
+  std::chrono::system_clock::time_point when;
+  std::chrono::steady_clock::duration elapsed{0};
+  /// Rows returned, or affected.
+  result_size_type rows = 0;
+  bool failed = false;
+  /// The query plan, if this query was sampled for @c EXPLAIN.
+  /** If the sample failed, this says why.
+   */
+  std::string plan;
+};
+
+
 /// Connection to a database.
 /** This is the first class to look at when you wish to work with a database
  * through libpqxx.  The connection opens during construction, and closes upon
@@ -182,6 +413,49 @@ public:
    */
   [[nodiscard]] bool PQXX_PURE is_open() const noexcept;
 
+  /**
+   * @name Reconnecting
+   *
+   * If the connection to the server breaks, @c reconnect() can open a fresh
+   * one, using the same connection options.  It restores the session state
+   * that the connection knows about, all in one round trip where libpq
+   * supports pipelining:
+   *
+   * 1. The channels on which your @c notification_receiver objects listen.
+   * 2. Automatically prepared statements.
+   * 3. With @c set_reconnect(), also the statements you @c prepare(), and the
+   *    session variables you set through @c set_variable().
+   */
+  //@{
+  /// Record session state, and reconnect automatically.
+  /** Once enabled, the connection remembers the statements you prepare (by
+   * name; unnamed statements are not restored) and the variables you set, so
+   * that @c reconnect() can restore them.
+   *
+   * It also reconnects by itself, when you start a transaction on a broken
+   * connection.  It never reconnects in the middle of a transaction, or
+   * retries a failed query: only you know whether that's safe.
+   *
+   * A variable you set inside a transaction that later aborts is still
+   * recorded.  Set variables outside transactions to avoid surprises.
+   *
+   * Disabling forgets what was recorded.
+   */
+  void set_reconnect(bool enable = true);
+
+  /// Does this connection record its session state for @c reconnect()?
+  [[nodiscard]] bool reconnect_enabled() const noexcept { return m_reconnect; }
+
+  /// Replace a broken (or healthy) backend connection with a fresh one.
+  /** Restores the session state, as described above.  There must be no
+   * transaction open.
+   *
+   * @throw broken_connection if it could not connect.
+   * @throw sql_error (or a subclass) if replaying the session state failed.
+   */
+  void reconnect();
+  //@}
+
   /// Invoke notice processor function.  The message should end in newline.
   void process_notice(char const[]) noexcept;
   /// Invoke notice processor function.  Newline at end is recommended.
@@ -194,10 +468,70 @@ public:
    * efficient way to call process_notice.
    */
   void process_notice(zview) noexcept;
+  /// Pass a notice to the error handlers' @c on_notice().
+  /** This is how notices from the server reach the error handlers.
+   */
+  void process_notice(notice const &) noexcept;
 
   /// Enable tracing to a given output stream, or nullptr to disable.
   void trace(std::FILE *) noexcept;
 
+  /// Report the cost of each query to @c hook.  Pass an empty one to stop.
+  /** The connection calls @c hook after each query, prepared statement
+   * execution, pipelined batch, and COPY, including ones that fail.  Use it
+   * to collect latency histograms and such, without wrapping every call.
+   *
+   * There's no cost when there's no hook, but with a hook, the connection
+   * reads the clock before and after each operation.
+   *
+   * If the hook throws an exception anyway, the connection passes the error
+   * message to its notice processor.
+   */
+  void set_query_hook(query_hook hook);
+
+  /// Trace transactions and queries as spans, through @c t.
+  /** Pass null to stop tracing.  This works alongside any query hook, and
+   * like the query hook, costs nothing when not in use.
+   *
+   * @throw usage_error if a transaction is open.
+   */
+  void set_tracer(std::shared_ptr<tracer> t);
+
+  /// Keep a log of queries that take longer than a threshold.
+  /** Once the log is on, every query, prepared statement execution, batch,
+   * or COPY which takes at least @c config.threshold goes into the log: its
+   * text or statement name, parameters, and timing.  The log keeps only the
+   * most recent @c config.capacity queries, re-using their memory.
+   *
+   * The log can also capture query plans for a sample of the slow queries.
+   * For that, it runs @c EXPLAIN (without @c ANALYZE) on a side connection,
+   * with the same parameters, right after the slow query completes.  This
+   * adds the time that takes to those sampled queries.  The side connection
+   * does not share this connection's session state, such as its search path.
+   * It knows the definitions of prepared statements that you prepare after
+   * enabling the log, or with @c set_reconnect() enabled.
+   *
+   * Calling this again replaces the configuration, and empties the log.
+   */
+  void set_slow_query_log(slow_query_config config);
+
+  /// Stop logging slow queries, and forget the ones logged so far.
+  void stop_slow_query_log() noexcept;
+
+  /// The queries in the slow query log, oldest first.
+  [[nodiscard]] std::vector<slow_query> slow_queries() const;
+
+  /// Have each new transaction on this connection collect statistics.
+  /** This calls @c transaction_base::collect_stats() with @c limits and
+   * @c alert for every transaction that you start from here on.  It's how
+   * you look for "N+1" query patterns throughout an application.
+   */
+  void
+  collect_transaction_stats(stats_limits limits = {}, stats_alert alert = {});
+
+  /// Stop having new transactions collect statistics.
+  void stop_transaction_stats() noexcept;
+
   /**
    * @name Connection properties
    *
@@ -302,9 +636,41 @@ public:
    */
   void set_client_encoding(char const encoding[]);
 
+  /// Trust that the text the server sends is valid in the client encoding.
+  /** Normally, when libpqxx parses text from the server, such as an array or
+   * a row of @c COPY data, it checks each multibyte character.  That's not
+   * really needed: the server has already validated its data.  In trusted
+   * mode, libpqxx skips those checks where the encoding allows, and searches
+   * for delimiters byte by byte, which is a lot faster.
+   *
+   * That's only safe in encodings where a byte in the ASCII range always
+   * means that ASCII character, as in UTF-8 or the EUC family.  In encodings
+   * where it may be part of a multibyte character, such as SJIS or GBK,
+   * trusted mode changes nothing.
+   *
+   * Invalid text then no longer causes an @c argument_error, so only trust
+   * text that comes from the server, not strings you build yourself.
+   */
+  void trust_encoding(bool trust = true) noexcept { m_trust_encoding = trust; }
+
+  /// Is this connection in trusted-encoding mode?  See @c trust_encoding().
+  [[nodiscard]] bool trusts_encoding() const noexcept
+  {
+    return m_trust_encoding;
+  }
+
   /// Get the connection's encoding, as a PostgreSQL-defined code.
   [[nodiscard]] int PQXX_PRIVATE encoding_id() const;
 
+  /// Get the connection's encoding group, for parsing text.
+  /** Cached per connection, so it's cheap to call.  Keeps up when the client
+   * encoding changes.
+   *
+   * In trusted-encoding mode, this returns @c MONOBYTE for any encoding
+   * where that is safe for finding ASCII delimiters.
+   */
+  [[nodiscard]] internal::encoding_group PQXX_PRIVATE enc_group() const;
+
   //@}
 
   /// Set session variable, using SQL's @c SET command.
@@ -326,8 +692,14 @@ public:
   void set_variable(std::string_view var, std::string_view value);
 
   /// Read session variable, using SQL's @c SHOW command.
-  /** @warning This executes an SQL query, so do not get or set variables while
-   * a table stream or pipeline is active on the same connection.
+  /** The server reports some variables to the client whenever they change,
+   * such as @c client_encoding, @c TimeZone, @c DateStyle, and
+   * @c standard_conforming_strings.  Those come straight from libpq, without
+   * a query.  The name must match exactly, including case, for that to work.
+   *
+   * @warning For any other variable, this executes an SQL query, so do not
+   * get or set those while a table stream or pipeline is active on the same
+   * connection.
    */
   std::string get_variable(std::string_view);
   //@}
@@ -473,6 +845,61 @@ public:
     prepare(name.c_str(), definition.c_str());
   }
 
+  /// Define a prepared statement, with explicit parameter types.
+  /** Works like the other @c prepare(), but tells the server the types of
+   * the parameters, as type oids.  A zero oid, or a parameter beyond the end
+   * of the list, leaves it to the server to work out that parameter's type.
+   *
+   * Use @c prepare::types() to derive the oids from C++ types.
+   */
+  void prepare(
+    char const name[], char const definition[],
+    std::vector<oid> const &types);
+
+  void prepare(
+    std::string const &name, std::string const &definition,
+    std::vector<oid> const &types)
+  {
+    prepare(name.c_str(), definition.c_str(), types);
+  }
+
+  void
+  prepare(zview name, zview definition, std::vector<oid> const &types)
+  {
+    prepare(name.c_str(), definition.c_str(), types);
+  }
+
+  /// Define a prepared statement, and get a typed handle for executing it.
+  /** @c TYPE... are the C++ types of the statement's parameters.  Where
+   * @c prepare::types() knows a type's SQL type, this tells the server.
+   *
+   * @code
+   * auto find{cx.prepare<long long, std::string>(
+   *   "find", "SELECT * FROM item WHERE id = $1 AND owner = $2")};
+   * pqxx::work tx{cx};
+   * auto const r{tx.exec_prepared(find, 42LL, "me")};
+   * @endcode
+   *
+   * See @c prepared.
+   */
+  template<typename... TYPE>
+  [[nodiscard]] prepared<TYPE...>
+  prepare(std::string const &name, std::string const &definition)
+  {
+    prepare(name.c_str(), definition.c_str(), pqxx::prepare::types<TYPE...>());
+    return prepared<TYPE...>{statement_text(name)};
+  }
+
+  /// Define many prepared statements at once.
+  /** Does the same as calling @c prepare() for each statement in turn, but
+   * when libpq supports pipeline mode, it takes just one round trip for the
+   * whole list.
+   *
+   * If a statement fails to prepare, this throws its error.  The statements
+   * before it in the list are prepared, but the ones after it are not.
+   */
+  void prepare_all(std::vector<prepare::statement> const &statements);
+
   /// Define a nameless prepared statement.
   /**
    * This can be useful if you merely want to pass large binary parameters to a
@@ -487,6 +914,148 @@ public:
   /// Drop prepared statement.
   void unprepare(std::string_view name);
 
+  /// Ask the server for a prepared statement's parameter and column types.
+  /** The first call for a statement costs a round trip.  After that, the
+   * connection remembers the answer, until you prepare or unprepare a
+   * statement of that name, or reconnect.
+   *
+   * The reference stays valid until then as well.
+   */
+  [[nodiscard]] prepare::description const &
+  describe_prepared(std::string_view name);
+
+  /// Ask the server for a table's columns: their names, types, and order.
+  /** Pass the table's name as you would write it in SQL, e.g. schema-qualified
+   * or quoted.  The first call for a table costs a round trip.  After that,
+   * the connection remembers the answer, until you call @c forget_table()
+   * for that table, or reconnect.  It does not notice when you alter the
+   * table.
+   *
+   * The reference stays valid until then as well.
+   *
+   * The table streams use this to check your row types against the table,
+   * and to choose binary format where they can: see @c stream_to::checked()
+   * and @c stream_from::checked().
+   *
+   * @warning This executes an SQL query, so do not call it while a table
+   * stream or pipeline is active on the same connection.
+   */
+  [[nodiscard]] table_description const &
+  describe_table(std::string_view table);
+
+  /// Drop the cached description of @c table, e.g. after altering it.
+  void forget_table(std::string_view table) noexcept;
+
+  /// Execute a prepared statement on its own, outside any transaction.
+  /** This is the fast path for simple point queries at high rates.  It does
+   * what a @c nontransaction would do, but without creating a transaction
+   * object for each statement: no name or description strings, no
+   * registering and unregistering with the connection, and no status
+   * checks.  It goes pretty much straight to libpq.
+   *
+   * The statement commits as soon as it is done, as it would in a
+   * @c nontransaction.  Query hooks, tracers, and the slow query log still
+   * see it.
+   *
+   * @throw usage_error If a transaction is open on the connection.
+   */
+  template<typename... Args>
+  result
+  exec_prepared_autocommit(std::string_view statement, Args &&... args)
+  {
+    return exec_autocommit(
+      statement, internal::params{std::forward<Args>(args)...});
+  }
+
+  /// Prepare frequently executed parameterised queries automatically.
+  /** Once you enable this, the connection keeps count of the parameterised
+   * queries you execute through @c transaction_base::exec_params() and its
+   * variants.  When the same query text has run @c runs times, the
+   * connection prepares it under a generated name, and from then on executes
+   * the prepared statement instead.  That saves the server the work of
+   * parsing and planning the query each time.
+   *
+   * The connection keeps track of at most @c capacity different queries.
+   * Beyond that, it forgets the one it used least recently, and deallocates
+   * it if it had prepared it.
+   *
+   * Pass zero for @c runs to turn this off again.  That deallocates all
+   * automatically prepared statements.
+   *
+   * Bear in mind the warning above: the plan for a prepared statement does
+   * not take its parameter values into account.
+   *
+   * An @c exec_params call with binary parameters of known types (see
+   * @c prepare::make_binary_param) never gets prepared automatically.
+   */
+  void set_auto_prepare(std::size_t runs, std::size_t capacity = 100);
+
+  /// Forget automatically prepared statements, without deallocating them.
+  /** Call this when the session has lost its prepared statements without the
+   * connection knowing about it, e.g. after running @c DISCARD @c ALL.
+   */
+  void forget_auto_prepared() noexcept;
+
+  /// Number of statements the connection has prepared automatically.
+  [[nodiscard]] std::size_t auto_prepared() const noexcept
+  {
+    return m_auto_prepared;
+  }
+
+  /// Limit how much client memory a single query result may take.
+  /** When a query's result takes more than @c bytes bytes (as measured by
+   * @c result::memory_usage()), executing the query throws
+   * @c result_too_large instead of returning the result.
+   *
+   * This can't stop the result from arriving in memory in the first place.
+   * For queries that may return a lot of data, use @c stream_from or
+   * @c stream_query: they receive the data in small pieces, so the limit does
+   * not get in their way.
+   *
+   * Pass zero to remove the limit.  That is the default.
+   */
+  void set_result_size_limit(std::size_t bytes) noexcept
+  {
+    m_result_size_limit = bytes;
+  }
+
+  /// The current limit on a query result's size, or zero for "no limit."
+  [[nodiscard]] std::size_t result_size_limit() const noexcept
+  {
+    return m_result_size_limit;
+  }
+
+  /// Spin for up to @c max_spin waiting for a query's result, then block.
+  /** Normally, a query waits for its result by putting the thread to sleep
+   * until the socket has data.  On a fast local connection, the reply may
+   * come back within microseconds, and the trip through the operating
+   * system's scheduler can take longer than the query itself.
+   *
+   * With a spin limit, the connection keeps polling the socket for the
+   * result, without sleeping, for up to that long.  Only if the result
+   * still isn't in by then does it go to sleep.  This burns CPU time in
+   * return for lower latency, so only use it when you have cores to spare.
+   *
+   * The limit is adaptive: the connection spins for about twice as long as
+   * recent queries took to come back, but never longer than @c max_spin.
+   * When queries take longer than that, it mostly gives up on spinning.
+   *
+   * Affects @c exec(), @c exec_params(), and @c exec_prepared(), when not
+   * batched with deferred commands.  Pass zero to turn spinning off.  That
+   * is the default.
+   */
+  void set_spin_wait(std::chrono::microseconds max_spin) noexcept
+  {
+    m_max_spin = max_spin;
+    m_spin_limit = max_spin;
+  }
+
+  /// Maximum time to spin for a query's result, or zero for "never."
+  [[nodiscard]] std::chrono::microseconds spin_wait() const noexcept
+  {
+    return m_max_spin;
+  }
+
   /**
    * @}
    */
@@ -524,6 +1093,26 @@ public:
    */
   [[nodiscard]] std::string esc(std::string_view text) const;
 
+  /// Buffer size that @c esc_into() needs for escaping @c text.
+  [[nodiscard]] static constexpr std::size_t
+  size_esc(std::string_view text) noexcept
+  {
+    return 2 * text.size() + 1;
+  }
+
+  /// Escape string into a buffer of your own, without allocating.
+  /** Writes the escaped text, and a terminating zero, into the buffer from
+   * @c begin to @c end.  Like @c string_traits::into_buf, returns the address
+   * just beyond the terminating zero.  So to build a long query text, you can
+   * write another value starting one byte before that address.
+   *
+   * Throws @c conversion_overrun if the buffer is smaller than
+   * @c size_esc(text).
+   *
+   * @warning If the string contains a zero byte, escaping stops there!
+   */
+  char *esc_into(std::string_view text, char *begin, char *end) const;
+
   /// Escape binary string for use as SQL string literal on this connection.
   [[nodiscard]] std::string
   esc_raw(unsigned char const bin[], size_t len) const;
@@ -559,12 +1148,49 @@ public:
   /// Escape and quote an SQL identifier for use in a query.
   [[nodiscard]] std::string quote_name(std::string_view identifier) const;
 
+  /// Buffer size that @c quote_name_into() needs for @c identifier.
+  [[nodiscard]] static constexpr std::size_t
+  size_quote_name(std::string_view identifier) noexcept
+  {
+    return 2 * identifier.size() + 3;
+  }
+
+  /// Escape and quote an SQL identifier into a buffer of your own.
+  /** Works like @c esc_into(), for @c quote_name().
+   */
+  char *
+  quote_name_into(std::string_view identifier, char *begin, char *end) const;
+
   /// Represent object as SQL string, including quoting & escaping.
   /**
    * Nulls are recognized and represented as SQL nulls.  They get no quotes.
    */
   template<typename T>[[nodiscard]] inline std::string quote(T const &t) const;
 
+  /// Buffer size that @c quote_into() may need for @c t.
+  /** This is an upper bound, like @c string_traits::size_buffer.
+   */
+  template<typename T>
+  [[nodiscard]] static inline std::size_t size_quote(T const &t);
+
+  /// Represent object as SQL string, into a buffer of your own.
+  /** Works like @c esc_into(), for @c quote().  The buffer must be at least
+   * @c size_quote(t) bytes.
+   *
+   * @code
+   * std::vector<char> buf(total_size);
+   * char *here{buf.data()}, *const end{buf.data() + std::size(buf)};
+   * for (auto const &name : names)
+   * {
+   *   here = conn.quote_into(name, here, end);
+   *   // Overwrite the terminating zero with a comma.
+   *   here[-1] = ',';
+   * }
+   * @endcode
+   */
+  template<typename T>
+  inline char *quote_into(T const &t, char *begin, char *end) const;
+
   [[nodiscard]] std::string quote(binarystring const &) const;
 
   /// Escape string for literal LIKE match.
@@ -593,12 +1219,29 @@ public:
    */
   [[nodiscard]] std::string
   esc_like(std::string_view text, char escape_char = '\\') const;
+
+  /// Buffer size that @c esc_like_into() needs for @c text.
+  [[nodiscard]] static constexpr std::size_t
+  size_esc_like(std::string_view text) noexcept
+  {
+    return 2 * text.size() + 1;
+  }
+
+  /// Escape string for literal LIKE match, into a buffer of your own.
+  /** Works like @c esc_into(), for @c esc_like().
+   */
+  char *esc_like_into(
+    std::string_view text, char *begin, char *end,
+    char escape_char = '\\') const;
   //@}
 
   /// Attempt to cancel the ongoing query, if any.
   /** You can use this from another thread, and/or while a query is executing
    * in a pipeline, but it's up to you to ensure that you're not canceling the
    * wrong query.  This may involve locking.
+   *
+   * This blocks until the server has received the request.  It does not
+   * allocate memory: the connection keeps a cancel handle ready for this.
    */
   void cancel_query();
 
@@ -645,8 +1288,26 @@ public:
   void close();
 
 private:
+  friend class connecting;
+  enum connect_mode
+  {
+    connect_nonblocking
+  };
+  /// Start connecting, without waiting for the connection to complete.
+  connection(connect_mode, char const options[]);
+
   void init(char const options[]);
 
+  /// Set up a freshly established connection.
+  void complete_init();
+
+  /// Poll for an ongoing connection, and try to move it along.
+  /** @return A pair of "now wait until the socket is ready for reading" and
+   * "now wait until the socket is ready for writing."  If both are false, the
+   * connection is complete.
+   */
+  std::pair<bool, bool> poll_connect();
+
   void wait_read() const;
   void wait_read(long seconds, long microseconds) const;
 
@@ -656,6 +1317,57 @@ private:
   void PQXX_PRIVATE set_up_state();
   void PQXX_PRIVATE check_result(result const &);
 
+  /// Start time of a query which we report to the query hook, if any.
+  std::chrono::steady_clock::time_point query_start() const noexcept
+  {
+    return reporting() ? std::chrono::steady_clock::now() :
+                         std::chrono::steady_clock::time_point{};
+  }
+  /// Do we report queries anywhere: hook, tracer, stats, or slow query log?
+  bool reporting() const noexcept
+  {
+    return bool(m_query_hook) or bool(m_tracer) or m_counting or
+           bool(m_slow_log);
+  }
+  /// Shared copy of a query's text, for the query's result to keep.
+  /** Re-uses the previous query's copy if the text is the same, so running
+   * the same query over and over does not copy it each time.
+   */
+  std::shared_ptr<std::string> PQXX_PRIVATE query_text(std::string_view);
+  /// Shared copy of a prepared statement's name, for its results to keep.
+  /** Statements prepared through this connection have their names interned,
+   * so executing one does not copy the name.
+   */
+  std::shared_ptr<std::string> PQXX_PRIVATE statement_text(std::string_view);
+  /// Drop any cached description of prepared statement @c name.
+  void PQXX_PRIVATE forget_description(std::string_view name) noexcept;
+  /// Query text to send: the query, with any trace context in front.
+  /** Without a trace context, this is just the query's own text.  Otherwise
+   * it writes the combined text to @c buf, and returns that.
+   */
+  PQXX_PRIVATE char const *
+  traced(std::string const &query, std::string &buf) const;
+  /// Check a result, and report it to the query hook if there is one.
+  /** If the result starts a COPY, the report waits until the COPY ends.
+   */
+  void PQXX_PRIVATE check_result(
+    result const &, query_stats::kind, std::string_view query,
+    std::size_t sent, std::chrono::steady_clock::time_point start,
+    std::size_t statements = 1, internal::params const *args = nullptr);
+  /// Pass statistics to whatever we report queries to.
+  /** If the query had parameters, pass them in @c args, for the slow query
+   * log.
+   */
+  void PQXX_PRIVATE report_query(
+    query_stats const &, internal::params const *args = nullptr) noexcept;
+  /// Put a query in the slow query log.
+  void PQXX_PRIVATE
+  log_slow_query(query_stats const &, internal::params const *args) noexcept;
+  /// Note COPY data going in or out, for the query hook.
+  void PQXX_PRIVATE time_copy_data(std::size_t sent, std::size_t received);
+  /// Report the end of a COPY to the query hook, if we're timing it.
+  void PQXX_PRIVATE end_copy_timing(result const *) noexcept;
+
   int PQXX_PRIVATE PQXX_PURE status() const noexcept;
 
   /// Escape a string, into a buffer allocated by the caller.
@@ -670,7 +1382,48 @@ private:
 
   void PQXX_PRIVATE process_notice_raw(char const msg[]) noexcept;
 
-  result exec_prepared(std::string_view statement, internal::params const &);
+  result exec_prepared(
+    std::string_view statement, internal::params const &,
+    format result_format = format::text);
+  /// Execute a prepared statement whose name we've already looked up.
+  result exec_prepared(
+    std::shared_ptr<std::string> const &statement, internal::params const &,
+    format result_format = format::text);
+
+  /// Implementation for @c exec_prepared_autocommit().
+  result exec_autocommit(std::string_view statement, internal::params const &);
+
+  /// Execute a prepared statement, with each column in its cheapest format.
+  /** See @c transaction_base::exec_prepared_mixed().
+   */
+  result exec_prepared_mixed(
+    std::string_view statement, internal::params const &);
+
+  /// Execute a prepared statement for each of a series of parameter sets.
+  /** Calls @c next to fill in each parameter set, until it returns false.
+   * @return Number of rows affected by each execution.
+   */
+  std::vector<result_size_type> exec_prepared_bulk(
+    zview statement, std::function<bool(internal::params &)> const &next);
+
+  /// Execute a parameterised statement for each of a series of parameter sets.
+  /** Works like @c exec_prepared_bulk(), except @c next may also change the
+   * text of @c query from one execution to the next.
+   * @return Number of rows affected by each execution.
+   */
+  std::vector<result_size_type> exec_params_bulk(
+    std::shared_ptr<std::string> const &query,
+    std::function<bool(internal::params &)> const &next);
+
+  friend class internal::gate::connection_notification_publisher;
+  /// Common implementation for @c exec_prepared_bulk and @c exec_params_bulk.
+  /** Passes each execution's result to @c sink, in order.
+   */
+  void PQXX_PRIVATE exec_bulk(
+    std::shared_ptr<std::string> const &query, bool prepared,
+    std::function<bool(internal::params &)> const &next,
+    std::function<void(result const &)> const &sink,
+    format result_format = format::text);
 
   /// Throw @c usage_error if this connection is not in a movable state.
   void check_movable() const;
@@ -686,47 +1439,353 @@ private:
   result PQXX_PRIVATE exec(std::shared_ptr<std::string>);
   void PQXX_PRIVATE register_transaction(transaction_base *);
   void PQXX_PRIVATE unregister_transaction(transaction_base *) noexcept;
+  /// End the current transaction's span, if we're tracing it.
+  void PQXX_PRIVATE end_trace_span(bool committed) noexcept;
+
+  /// Hold back a transaction's opening command until its first statement.
+  /** The command must stay valid until the connection sends it.
+   */
+  void PQXX_PRIVATE defer_begin(char const command[]) noexcept
+  {
+    m_deferred_begin = command;
+  }
+  /// Forget the deferred opening command.  Return whether there was one.
+  bool PQXX_PRIVATE drop_deferred_begin() noexcept
+  {
+    return std::exchange(m_deferred_begin, nullptr) != nullptr;
+  }
+  /// Hold back a savepoint command until the next statement.
+  /** Commands go out in the order in which they were deferred, after any
+   * deferred opening command.
+   */
+  void PQXX_PRIVATE defer_savepoint(std::string command)
+  {
+    m_deferred_savepoints.push_back(std::move(command));
+  }
+  /// Take back the last deferred savepoint command, if it is @c command.
+  /** Return whether it was.  If so, the command never reached the server.
+   */
+  bool PQXX_PRIVATE drop_deferred_savepoint(std::string_view command) noexcept
+  {
+    if (
+      m_deferred_savepoints.empty() or m_deferred_savepoints.back() != command)
+      return false;
+    m_deferred_savepoints.pop_back();
+    return true;
+  }
+  /// Hold back a cursor's @c CLOSE until the next statement, if that's safe.
+  /** It's safe if the transaction is in a healthy state, and there are no
+   * savepoint commands waiting, after which the cursor might not exist.
+   * Returns whether it deferred the command.
+   *
+   * If the transaction ends first, the command never goes out.  Ending the
+   * transaction closes the cursor anyway.
+   */
+  bool PQXX_PRIVATE defer_close(std::string command);
+  /// Are there any deferred commands waiting for the next statement?
+  bool PQXX_PRIVATE have_deferred() const noexcept
+  {
+    return m_deferred_begin != nullptr or not m_deferred_savepoints.empty();
+  }
+  /// If there are deferred commands, execute them now.
+  void PQXX_PRIVATE flush_deferred();
+  /// Execute a statement, plus deferred commands and/or COMMIT.
+  /** Sends it all in one go, and waits for a single round trip.  Returns the
+   * statement's own result.
+   *
+   * For a plain SQL query, pass null for @c args.  For a prepared statement,
+   * @c query is the statement's name.
+   */
+  result PQXX_PRIVATE exec_bundled(
+    std::shared_ptr<std::string> const &query, internal::params const *args,
+    bool prepared, format result_format, bool commit);
+  /// Execute a multi-statement script, and return each statement's result.
+  /** Any deferred commands go out along with the script, in the same round
+   * trip.  Their results are not in the vector.
+   */
+  std::vector<result> PQXX_PRIVATE exec_all(std::string_view script);
 
   friend class internal::gate::connection_stream_from;
+  /// Total time that COPY reads and writes have waited on this connection.
+  std::chrono::steady_clock::duration copy_blocked() const noexcept
+  {
+    return m_copy_blocked;
+  }
   bool PQXX_PRIVATE read_copy_line(std::string &);
+  /// Read a line of COPY data, without copying it out of libpq's buffer.
+  /** Returns a null buffer once there is no more data.
+   */
+  std::pair<internal::pq_buffer, std::size_t> PQXX_PRIVATE read_copy_line();
+  /// Read a line of COPY data if one is available, without blocking.
+  /** Returns a null buffer if there is no line available yet.  Once the data
+   * ends, returns a null buffer and sets @c done.  From there on, call
+   * @c try_end_copy_read() until it returns @c true.
+   */
+  std::pair<internal::pq_buffer, std::size_t>
+    PQXX_PRIVATE try_read_copy_line(bool &done);
+  /// Finish reading COPY data, once it has ended.
+  void PQXX_PRIVATE end_copy_read();
+  /// Finish reading COPY data, if that can be done without blocking.
+  bool PQXX_PRIVATE try_end_copy_read();
+
+  friend class internal::gate::connection_replication_stream;
+  /// Send one CopyData message during a COPY BOTH, and flush it out.
+  void PQXX_PRIVATE send_copy_message(std::string_view);
+  /// End a COPY BOTH: stop sending, and skip what the server still sends.
+  /** Pass @c server_done if the server has already ended its side.
+   */
+  void PQXX_PRIVATE end_copy_both(bool server_done);
+
+  friend class internal::gate::connection_stream_query;
+  /// Receive the current query's results one row at a time.
+  void PQXX_PRIVATE set_single_row_mode();
+  /// Receive the current query's results in chunks of rows, if supported.
+  void PQXX_PRIVATE set_chunked_rows_mode(int rows);
 
   friend class internal::gate::connection_stream_to;
   void PQXX_PRIVATE write_copy_line(std::string_view);
+  /// Write raw COPY data, as-is.
+  void PQXX_PRIVATE write_copy_data(std::string_view);
   void PQXX_PRIVATE end_copy_write();
+  /// Like @c drain_output(), but count the waiting time as COPY blocking.
+  void PQXX_PRIVATE drain_copy_output() { m_copy_blocked += drain_output(); }
 
   friend class internal::gate::connection_largeobject;
-  internal::pq::PGconn *raw_connection() const { return m_conn; }
+  internal::pq::PGconn *raw_connection()
+  {
+    flush_deferred();
+    return m_conn;
+  }
 
   friend class internal::gate::connection_notification_receiver;
   void add_receiver(notification_receiver *);
   void remove_receiver(notification_receiver *) noexcept;
+  /// Hold back LISTEN and UNLISTEN commands, until @c end_listen_batch().
+  void PQXX_PRIVATE begin_listen_batch();
+  /// Send the held-back LISTEN and UNLISTEN commands, in one go.
+  void PQXX_PRIVATE end_listen_batch();
+  /// Hold back a LISTEN (or UNLISTEN) on @c channel, for the current batch.
+  void PQXX_PRIVATE queue_listen(std::string const &channel, bool listen);
 
   friend class internal::gate::connection_pipeline;
+  friend class internal::gate::connection_reactor;
   void PQXX_PRIVATE start_exec(char const query[]);
+  void PQXX_PRIVATE start_exec_params(
+    char const query[], internal::params const &args,
+    format result_format = format::text);
+  void PQXX_PRIVATE start_exec_prepared(
+    char const statement[], internal::params const &args,
+    format result_format = format::text);
   bool PQXX_PRIVATE consume_input() noexcept;
+  /// Pass notifications that libpq has already received to their receivers.
+  int PQXX_PRIVATE deliver_notifs();
   bool PQXX_PRIVATE is_busy() const noexcept;
   internal::pq::PGresult *get_result();
+  /// Collect the result of a query we've just sent, like @c PQexec() does.
+  /** Spins first, if the connection has a spin limit.  If @c sent is false,
+   * returns null, just like @c PQexec() does when it can't send.
+   */
+  PQXX_PRIVATE internal::pq::PGresult *spin_result(bool sent);
+
+  /// Make libpq queue up outgoing data instead of blocking, or stop that.
+  /** Switching back to blocking mode first sends any data that libpq has
+   * queued up, waiting for the socket as needed.
+   */
+  void PQXX_PRIVATE set_nonblocking(bool enable);
+  /// Send as much queued data as the socket will take, without blocking.
+  /** @return Whether all queued data has gone out.
+   */
+  bool PQXX_PRIVATE flush_output();
+  /// Send all queued data, waiting for the socket as needed.
+  /** @return Time spent waiting for the socket.
+   */
+  std::chrono::steady_clock::duration PQXX_PRIVATE drain_output();
+
+  /// Start cancelling the ongoing query, without blocking if possible.
+  /** Without libpq support for non-blocking cancellation, this falls back to
+   * @c cancel_query().
+   *
+   * @return Whether the cancel request is complete already.
+   */
+  bool PQXX_PRIVATE start_cancel();
+  /// Make progress on a cancel request started with @c start_cancel().
+  /** @return Whether the cancel request is complete. */
+  bool PQXX_PRIVATE poll_cancel();
+
+  /// Put the connection in libpq's native pipeline mode.
+  void PQXX_PRIVATE enter_pipeline_mode();
+  /// Leave pipeline mode.  All results must have been received.
+  void PQXX_PRIVATE exit_pipeline_mode();
+  /// Mark a synchronisation point in the pipeline, and flush.
+  void PQXX_PRIVATE pipeline_sync();
+  /// Receive results up to the pipeline sync, and leave pipeline mode.
+  void PQXX_PRIVATE
+  drain_pipeline(std::function<void(internal::pq::PGresult *)> const &accept);
+
+  /// Wait for the result of a query sent with @c start_exec().
+  /** Checks the result, and reads any notifications, just like @c exec().
+   */
+  result PQXX_PRIVATE receive_result(std::shared_ptr<std::string> const &);
+  /// Wait for all results of a multi-statement query sent with start_exec().
+  std::vector<result> PQXX_PRIVATE
+  receive_results(std::shared_ptr<std::string> const &);
 
   friend class internal::gate::connection_dbtransaction;
   friend class internal::gate::connection_sql_cursor;
 
-  result exec_params(std::string_view query, internal::params const &args);
+  result exec_params(
+    std::string_view query, internal::params const &args,
+    format result_format = format::text);
+
+  /// Replace the backend connection, and restore the session state.
+  /** Unlike @c reconnect(), does not check for an open transaction.
+   */
+  void PQXX_PRIVATE reset_session();
+
+  /// Restore the session state on a fresh backend connection.
+  void PQXX_PRIVATE replay_session();
+
+  /// Execute a parameterised query, never mind automatic preparation.
+  result PQXX_PRIVATE exec_params_now(
+    std::string_view query, internal::params const &args,
+    format result_format);
+
+  /// Count an execution of @c query, and prepare it if it's time.
+  /** @return The prepared statement's name, or an empty string if the query
+   * is not prepared.
+   */
+  std::string const &auto_prepare(std::string_view query);
+  /// Forget least recently used queries until we're within capacity.
+  void PQXX_PRIVATE trim_auto_prepared();
 
   /// Connection handle.
   internal::pq::PGconn *m_conn = nullptr;
 
+  /// Handle for cancelling queries, set up along with the connection.
+  /** It holds the backend's cancel key, so it changes when we reconnect.
+   */
+  internal::pq::PGcancel *m_cancel = nullptr;
+
+  /// Non-blocking cancel request, if libpq supports it.  Created on demand.
+  internal::pq::PGcancelConn *m_cancel_conn = nullptr;
+
+  /// Set up @c m_cancel for the current connection.
+  void PQXX_PRIVATE make_cancel();
+  /// Free any cancel handles.
+  void PQXX_PRIVATE drop_cancel() noexcept;
+
   /// Active transaction on connection, if any.
   internal::unique<transaction_base> m_trans;
 
+  /// The active transaction's opening command, if it hasn't been sent yet.
+  char const *m_deferred_begin = nullptr;
+  /// Savepoint and cursor commands that haven't been sent yet, in order.
+  std::vector<std::string> m_deferred_savepoints;
+
   std::list<errorhandler *> m_errorhandlers;
 
+  /// Receivers by channel.  Transparent lookup: finding one allocates nothing.
   using receiver_list =
-    std::multimap<std::string, pqxx::notification_receiver *>;
+    std::multimap<std::string, pqxx::notification_receiver *, std::less<>>;
   /// Notification receivers.
   receiver_list m_receivers;
+  /// Is a @c receiver_batch holding back LISTEN and UNLISTEN commands?
+  bool m_batching_listens = false;
+  /// Held-back commands: whether each channel needs a LISTEN or an UNLISTEN.
+  std::map<std::string, bool, std::less<>> m_pending_listens;
+
+  /// Are we recording session state for @c reconnect()?
+  bool m_reconnect = false;
+  /// Skip validation of the text that the server sends?
+  bool m_trust_encoding = false;
+  /// Named prepared statements, for @c reconnect(): name to definition.
+  std::map<std::string, prepare::statement, std::less<>> m_session_statements;
+  /// Session variables, for @c reconnect(): name to value.
+  std::map<std::string, std::string, std::less<>> m_session_variables;
+
+  /// Text of the last query, for results of identical queries to share.
+  std::shared_ptr<std::string> m_last_query;
+  /// Interned names of statements we prepared, for their results to share.
+  std::map<std::string, std::shared_ptr<std::string>, std::less<>>
+    m_statement_names;
+  /// Cached descriptions of prepared statements, by name.
+  std::map<std::string, prepare::description, std::less<>> m_descriptions;
+  /// Cached descriptions of tables, by name.
+  std::map<std::string, table_description, std::less<>> m_tables;
 
   /// Unique number to use as suffix for identifiers (see adorn_name()).
   int m_unique_id = 0;
+
+  /// Callback for query statistics, if any.
+  query_hook m_query_hook;
+
+  /// Tracer for transactions and queries, if any.
+  std::shared_ptr<tracer> m_tracer;
+
+  /// Statistics settings for new transactions, if they collect statistics.
+  std::optional<std::pair<stats_limits, stats_alert>> m_stats_defaults;
+  /// Is the current transaction collecting statistics?
+  bool m_counting = false;
+
+  /// The slow query log, if any.
+  std::shared_ptr<internal::slow_query_log> m_slow_log;
+  /// The current transaction's span, if we're tracing it.
+  void *m_trans_span = nullptr;
+  /// SQL comment with the current transaction's trace context, if any.
+  std::string m_trace_comment;
+
+  /// Statistics for a COPY in progress, when we have a query hook.
+  struct copy_timing
+  {
+    std::string query;
+    std::chrono::steady_clock::time_point start;
+    query_stats stats;
+    /// The value of @c m_copy_blocked when the COPY started.
+    std::chrono::steady_clock::duration blocked_before{0};
+    bool got_data = false;
+  };
+  /// The COPY we're timing for the query hook, if any.
+  std::optional<copy_timing> m_copy_timing;
+  /// Total time that COPY reads and writes have waited, ever.
+  std::chrono::steady_clock::duration m_copy_blocked{0};
+
+  /// Client encoding for which @c m_enc_group is valid, or -1 for none.
+  mutable int m_enc_id = -1;
+  /// Cached encoding group for client encoding @c m_enc_id.
+  mutable internal::encoding_group m_enc_group =
+    internal::encoding_group::MONOBYTE;
+
+  /// A query which we track for automatic preparation.
+  struct auto_prepare_entry
+  {
+    /// Number of times the query has run.
+    std::size_t runs = 0;
+    /// Name of the prepared statement, or empty if it's not prepared.
+    std::string name;
+    /// This query's position in @c m_auto_lru.
+    std::list<std::string_view>::iterator lru;
+  };
+
+  /// Queries tracked for automatic preparation, by query text.
+  std::map<std::string, auto_prepare_entry, std::less<>> m_auto_prepare;
+  /// Tracked query texts, most recently used first.
+  /** These point to the keys in @c m_auto_prepare.
+   */
+  std::list<std::string_view> m_auto_lru;
+  /// Prepare a query after this many runs, or zero for "never."
+  std::size_t m_auto_prepare_runs = 0;
+  /// Maximum number of queries to track for automatic preparation.
+  std::size_t m_auto_prepare_capacity = 0;
+  /// Number of tracked queries which we have prepared.
+  std::size_t m_auto_prepared = 0;
+
+  /// Maximum memory size for a query result, or zero for "no limit."
+  std::size_t m_result_size_limit = 0;
+
+  /// Longest we'll ever spin waiting for a result.  Zero means never spin.
+  std::chrono::microseconds m_max_spin{0};
+  /// How long we'll spin for the next result, adapted to recent queries.
+  std::chrono::microseconds m_spin_limit{0};
 };
 
 
@@ -753,6 +1812,190 @@ template<typename T> inline std::string connection::quote(T const &t) const
   buf.resize(end);
   return buf;
 }
+
+
+template<typename T> inline std::size_t connection::size_quote(T const &t)
+{
+  // A nullptr converts to std::string_view, but we mustn't try that.
+  if constexpr (std::is_same_v<T, std::nullptr_t>)
+    return std::size("NULL");
+  else if (is_null(t))
+    return std::size("NULL");
+  else if constexpr (std::is_convertible_v<T const &, std::string_view>)
+    return 2 * std::string_view{t}.size() + 3;
+  else
+    // Room for the unescaped text at the end, and the quoted text before it.
+    return 3 * string_traits<T>::size_buffer(t) + 2;
+}
+
+
+template<typename T>
+inline char *connection::quote_into(T const &t, char *begin, char *end) const
+{
+  auto const budget{size_quote(t)};
+  if (end < begin or static_cast<std::size_t>(end - begin) < budget)
+    throw conversion_overrun{
+      "Buffer too small to quote " + std::string{name_type<T>()} + ": need " +
+      to_string(budget) + " bytes, have " + to_string(end - begin) + "."};
+
+  if (is_null(t))
+  {
+    std::memcpy(begin, "NULL", std::size("NULL"));
+    return begin + std::size("NULL");
+  }
+
+  std::string_view text;
+  if constexpr (std::is_same_v<T, std::nullptr_t>)
+  {
+    // Always null, so we never get here.  But don't convert it to a view.
+  }
+  else if constexpr (std::is_convertible_v<T const &, std::string_view>)
+  {
+    text = t;
+  }
+  else
+  {
+    // Render the value at the end of the buffer, out of the way of the
+    // escaped text.
+    text = string_traits<T>::to_buf(
+      end - string_traits<T>::size_buffer(t), end, t);
+  }
+
+  *begin = '\'';
+  auto const content_bytes{esc_to_buf(text, begin + 1)};
+  auto const closing_quote{begin + 1 + content_bytes};
+  closing_quote[0] = '\'';
+  closing_quote[1] = '\0';
+  return closing_quote + 2;
+}
+} // namespace pqxx
+
+
+namespace pqxx
+{
+/// An ongoing, non-blocking stepping stone to a connection.
+/** Use this when you want to connect to a database, without blocking your
+ * program while the connection gets set up.  That may involve a DNS lookup,
+ * a TCP handshake, a TLS handshake, and authentication.  With a
+ * @c connecting, you can wait for the socket yourself, e.g. alongside those of
+ * other connections in your own event loop.
+ *
+ * Here's how it works:
+ * 1. Create a @c connecting object, passing it a connection string.
+ * 2. Wait until @c sock() is ready for reading if @c wait_to_read() is true,
+ *    or for writing if @c wait_to_write() is true.
+ * 3. Call @c process().
+ * 4. Repeat from step 2 until @c done() returns true.
+ * 5. Call @c produce() to get the completed connection.
+ *
+ * If the connection fails, you'll get a @c broken_connection exception, from
+ * the constructor or from @c process().
+ *
+ * To bring up several connections at once, see @c connect_all().
+ */
+class PQXX_LIBEXPORT connecting
+{
+public:
+  /// Start connecting.
+  explicit connecting(zview options);
+  explicit connecting(std::string const &options) :
+          connecting{zview{options.c_str(), options.size()}}
+  {}
+
+  connecting(connecting const &) = delete;
+  connecting(connecting &&) = default;
+  connecting &operator=(connecting const &) = delete;
+  connecting &operator=(connecting &&) = default;
+
+  /// Get the socket.  The socket may change during the connection process.
+  [[nodiscard]] int sock() const noexcept { return m_conn.sock(); }
+
+  /// Should we currently wait to be able to @em read from the socket?
+  [[nodiscard]] bool wait_to_read() const noexcept { return m_reading; }
+
+  /// Should we currently wait to be able to @em write to the socket?
+  [[nodiscard]] bool wait_to_write() const noexcept { return m_writing; }
+
+  /// Progress towards completion (but don't block).
+  /** Call this when the socket is ready for whatever @c wait_to_read() and
+   * @c wait_to_write() asked for.
+   */
+  void process();
+
+  /// Is our connection finished?
+  [[nodiscard]] bool done() const noexcept
+  {
+    return not m_reading and not m_writing;
+  }
+
+  /// Produce the completed connection object.
+  /** Use this only once, after @c done() returned @c true.  Once you have
+   * called this, the @c connecting object has no connection anymore.
+   */
+  [[nodiscard]] connection produce() &&;
+
+private:
+  connection m_conn;
+  // A new connection starts out waiting to write.
+  bool m_reading{false};
+  bool m_writing{true};
+};
+
+
+/// Bring up several connections at once.
+/** Instead of connecting to the database one connection after the other,
+ * this lets all the connections make progress concurrently.  So the total
+ * time is more like the time for one connection than for all of them.
+ *
+ * @param options One connection string for each connection.
+ * @throw broken_connection if any of the connections fails.
+ */
+[[nodiscard]] PQXX_LIBEXPORT std::vector<connection>
+connect_all(std::vector<std::string> const &options);
+
+/// Bring up several connections, all with the same options, at once.
+[[nodiscard]] PQXX_LIBEXPORT std::vector<connection>
+connect_all(zview options, std::size_t count);
+
+
+/// Settings for @c connect_first().
+struct connect_first_config
+{
+  /// How long to give one attempt before starting the next alongside it.
+  std::chrono::milliseconds stagger{250};
+
+  /// How long to remember the addresses that a host name resolved to.
+  std::chrono::seconds address_ttl{60};
+};
+
+
+/// Connect to whichever host in a connection string answers first.
+/** Given several hosts, e.g. @c "host=db1,db2,db3", libpq tries them one
+ * after the other.  If the first host is down, you may wait for a full
+ * connection timeout before it even tries the second.
+ *
+ * This tries all of them, in "happy eyeballs" style.  It resolves each host
+ * name to its addresses, and starts connecting to the first.  If that hasn't
+ * succeeded after @c connect_first_config::stagger, or once it fails, it
+ * starts on the next address, and so on, without giving up on the earlier
+ * ones.  The first attempt to succeed wins, and the others get closed.
+ *
+ * Each attempt gets the connection string's other options, including
+ * @c target_session_attrs.  So with @c target_session_attrs=read-write, only
+ * a primary can win.
+ *
+ * Host name lookups get cached, for @c connect_first_config::address_ttl,
+ * so that reconnecting during a failover doesn't wait for DNS each time.
+ * A Unix socket directory, or a host with a @c hostaddr, needs no lookup.
+ *
+ * @throw broken_connection If no attempt succeeds.  The error is that of
+ *     the last attempt to fail.
+ */
+[[nodiscard]] PQXX_LIBEXPORT connection connect_first(
+  zview options, connect_first_config const &config = connect_first_config{});
+
+/// Forget all host addresses that @c connect_first() has cached.
+PQXX_LIBEXPORT void forget_host_addresses() noexcept;
 } // namespace pqxx
 
 
@@ -762,6 +2005,9 @@ PQXX_LIBEXPORT void wait_read(internal::pq::PGconn const *);
 PQXX_LIBEXPORT void
 wait_read(internal::pq::PGconn const *, long seconds, long microseconds);
 PQXX_LIBEXPORT void wait_write(internal::pq::PGconn const *);
+
+/// Wait until a socket is ready for reading, or for writing.
+PQXX_LIBEXPORT void wait_socket(int fd, bool for_write);
 } // namespace pqxx::internal
 
 #include "pqxx/internal/compiler-internal-post.hxx"
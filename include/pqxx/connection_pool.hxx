@@ -0,0 +1,416 @@
+/* Definition of the pqxx::connection_pool class.
+ *
+ * pqxx::connection_pool shares a set of connections between threads.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/connection_pool instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_CONNECTION_POOL
+#define PQXX_H_CONNECTION_POOL
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+
+
+namespace pqxx
+{
+class connection_pool;
+
+
+/// How a @c connection_pool cleans up a connection that comes back to it.
+enum class pool_reset
+{
+  /// Leave the session as it is.
+  none,
+  /// Run @c DISCARD @c ALL.
+  /** This resets the session to its original state: session variables,
+   * temporary tables, @c LISTEN registrations, and so on.  It also drops
+   * prepared statements, so the pool prepares its statements again the next
+   * time it hands out the connection.
+   */
+  discard_all,
+};
+
+
+/// Priority class for borrowing a connection from a @c connection_pool.
+enum class pool_priority
+{
+  /// Latency-sensitive work.  Goes ahead of any batch callers.
+  interactive,
+  /// Background work.  Waits while any interactive callers are waiting.
+  batch,
+};
+
+
+/// Statistics on a @c connection_pool's wait queue, for one priority class.
+struct pool_queue_stats
+{
+  /// Connections handed out.
+  std::size_t checkouts = 0;
+  /// Checkouts that had to wait for a connection.
+  std::size_t waits = 0;
+  /// Callers that gave up waiting, because they reached their timeout.
+  std::size_t timeouts = 0;
+  /// Callers that failed right away, because the wait queue was full.
+  std::size_t rejections = 0;
+  /// Callers waiting right now.
+  std::size_t waiting = 0;
+  /// Total time that callers spent waiting, including ones that timed out.
+  std::chrono::nanoseconds total_wait{0};
+  /// Longest time any caller waited.
+  std::chrono::nanoseconds max_wait{0};
+};
+
+
+/// Settings for a @c connection_pool.
+struct connection_pool_config
+{
+  /// Number of connections to keep open, even when they're idle.
+  /** The pool opens these when you create it. */
+  std::size_t min_size = 0;
+
+  /// Most connections the pool will have open at any time.
+  std::size_t max_size = 10;
+
+  /// Close connections beyond @c min_size after they've been idle this long.
+  std::chrono::seconds max_idle{60};
+
+  /// How long @c connection_pool::get() may wait for a connection.
+  /** Zero means no limit. */
+  std::chrono::milliseconds checkout_timeout{0};
+
+  /// What to do to a connection when it comes back to the pool.
+  pool_reset reset = pool_reset::none;
+
+  /// Number of shards to split the idle connections into.
+  /** Each thread borrows connections from its own shard, and returns them
+   * there, so a connection tends to stay with the thread that last used it.
+   * When a thread's shard has no idle connections, it takes one from another
+   * shard.  Each shard has its own lock, so threads contend less.
+   *
+   * For per-core or per-NUMA-node locality, pin your worker threads to cores
+   * and use as many shards as you have worker threads.  The default, one
+   * shard, shares a single list of idle connections between all threads.
+   */
+  std::size_t shards = 1;
+
+  /// Keep at least this many idle connections open, in the background.
+  /** With this set, a maintenance thread opens new connections whenever
+   * fewer than this many are idle, as long as the pool stays within
+   * @c max_size.  It opens them all at once, and prepares the pool's
+   * statements on them, so that they're ready to hand out.  Zero means no
+   * prewarming.
+   */
+  std::size_t min_idle = 0;
+
+  /// Check connections that have been idle for this long.
+  /** The maintenance thread sends an empty query to each of them.  If that
+   * fails, the pool closes the connection, so that @c get() won't hand it
+   * out.  After a network problem or failover, the pool finds out about dead
+   * connections this way, instead of on the next query.  Zero means no
+   * heartbeats.
+   */
+  std::chrono::milliseconds heartbeat{0};
+
+  /// How often the maintenance thread does its rounds.
+  /** There is only a maintenance thread if @c min_idle or @c heartbeat is
+   * nonzero.
+   */
+  std::chrono::milliseconds maintenance_interval{1000};
+
+  /// Most callers that may be waiting for a connection at any time.
+  /** Once this many are waiting, @c connection_pool::get() fails right away
+   * instead of joining the queue.  Zero means no limit.
+   */
+  std::size_t max_waiting = 0;
+
+  /// Most connections that batch callers may have borrowed at any time.
+  /** Set this below @c max_size to keep some connections available to
+   * interactive callers, however much batch work there is.  Zero means no
+   * limit.
+   */
+  std::size_t max_batch = 0;
+};
+
+
+/// A connection, on loan from a @c connection_pool.
+/** When this object is destroyed, the connection goes back to the pool.  Make
+ * sure that any transaction on the connection has ended by then.
+ *
+ * If the connection is broken, the pool closes it instead of handing it out
+ * again.
+ */
+class PQXX_LIBEXPORT pooled_connection
+{
+public:
+  pooled_connection(pooled_connection &&) noexcept = default;
+  pooled_connection &operator=(pooled_connection &&) noexcept;
+  pooled_connection(pooled_connection const &) = delete;
+  pooled_connection &operator=(pooled_connection const &) = delete;
+
+  ~pooled_connection() noexcept { give_back(); }
+
+  connection &operator*() const noexcept { return *m_conn; }
+  connection *operator->() const noexcept { return m_conn.get(); }
+
+  /// Give the connection back to the pool now, instead of on destruction.
+  void give_back() noexcept;
+
+private:
+  friend class connection_pool;
+  pooled_connection(
+    connection_pool &pool, std::unique_ptr<connection> conn,
+    std::size_t num_prepared, pool_priority priority) noexcept :
+          m_pool{&pool},
+          m_conn{std::move(conn)},
+          m_num_prepared{num_prepared},
+          m_priority{priority}
+  {}
+
+  connection_pool *m_pool;
+  std::unique_ptr<connection> m_conn;
+  /// How many of the pool's prepared statements this connection has.
+  std::size_t m_num_prepared;
+  /// Priority class of the borrower.
+  pool_priority m_priority;
+};
+
+
+/// A thread-safe pool of connections to the same database.
+/** Opening a connection takes several round trips, and authentication can be
+ * expensive.  A pool keeps connections open, and hands them out to whichever
+ * thread needs one.  Use @c get() to borrow a connection; it goes back to
+ * the pool when you're done with it.
+ *
+ * The pool opens new connections as needed, up to @c max_size.  Once that
+ * many are in use, @c get() waits for one to come back.  The most recently
+ * returned connection is the first to be handed out again, so the rest can
+ * stay idle long enough to be closed.  The pool closes idle connections when
+ * a connection is borrowed or returned.
+ *
+ * Optionally, a background thread keeps a minimum number of connections idle
+ * and ready, and checks idle connections with a heartbeat.  See
+ * @c connection_pool_config::min_idle and
+ * @c connection_pool_config::heartbeat.
+ *
+ * The pool can split its idle connections into shards, one for each group of
+ * threads.  See @c connection_pool_config::shards.
+ *
+ * Callers who have to wait for a connection get in line.  Interactive callers
+ * go ahead of batch callers; within a priority class, it's first come, first
+ * served.  See @c pool_priority, @c connection_pool_config::max_batch, and
+ * @c connection_pool_config::max_waiting.
+ *
+ * Before handing out a connection, the pool checks that it is still open.
+ * That costs no round trip, so a connection may still break just after.
+ *
+ * Statements you @c prepare() on the pool get prepared on each connection,
+ * before it is first handed out.
+ *
+ * All connections in the pool must be back before the pool is destroyed.
+ */
+class PQXX_LIBEXPORT connection_pool
+{
+public:
+  explicit connection_pool(
+    std::string options,
+    connection_pool_config const &config = connection_pool_config{});
+  ~connection_pool() noexcept;
+
+  connection_pool(connection_pool const &) = delete;
+  connection_pool &operator=(connection_pool const &) = delete;
+
+  /// Borrow a connection, with interactive priority.
+  /** @throw pqxx::failure if none became available within the configured
+   * checkout timeout, or if the wait queue was full.
+   * @throw pqxx::broken_connection if opening a new connection failed.
+   */
+  [[nodiscard]] pooled_connection get()
+  {
+    return get(pool_priority::interactive, m_config.checkout_timeout);
+  }
+
+  /// Borrow a connection, with the given priority.
+  /** @throw pqxx::failure if none became available within the configured
+   * checkout timeout, or if the wait queue was full.
+   * @throw pqxx::broken_connection if opening a new connection failed.
+   */
+  [[nodiscard]] pooled_connection get(pool_priority priority)
+  {
+    return get(priority, m_config.checkout_timeout);
+  }
+
+  /// Borrow a connection, with the given priority and timeout.
+  /** A zero timeout means wait as long as it takes.
+   *
+   * @throw pqxx::failure if none became available within @c timeout, or if
+   * the wait queue was full.
+   * @throw pqxx::broken_connection if opening a new connection failed.
+   */
+  [[nodiscard]] pooled_connection
+  get(pool_priority priority, std::chrono::milliseconds timeout);
+
+  /// Prepare a statement on every connection this pool hands out.
+  /** Connections get the statement the next time they're borrowed.  So if the
+   * definition has an error, you won't see it until then.
+   */
+  void prepare(std::string const &name, std::string const &definition);
+
+  /// Prepare a list of statements on every connection this pool hands out.
+  /** Works like @c prepare(), but a connection prepares the whole list in
+   * one go, using @c connection::prepare_all().
+   */
+  void prepare_all(std::vector<prepare::statement> const &statements);
+
+  /// Number of connections the pool has open, including borrowed ones.
+  [[nodiscard]] std::size_t size() const;
+
+  /// Number of open connections that are not currently borrowed.
+  [[nodiscard]] std::size_t idle() const;
+
+  /// Statistics on the wait queue for callers of the given priority.
+  [[nodiscard]] pool_queue_stats stats(pool_priority priority) const;
+
+  /// Do one round of maintenance now.
+  /** Closes connections that have been idle too long, sends heartbeats, and
+   * opens connections up to @c connection_pool_config::min_idle.  This is
+   * what the maintenance thread does periodically, but you can also call it
+   * yourself, with or without the thread.
+   *
+   * @throw broken_connection if opening new connections failed.
+   */
+  void maintain();
+
+private:
+  friend class pooled_connection;
+  using clock = std::chrono::steady_clock;
+
+  /// A connection sitting in the pool.
+  struct idle_connection
+  {
+    std::unique_ptr<connection> conn;
+    std::size_t num_prepared;
+    clock::time_point since;
+    /// When we last knew the connection to be working.
+    clock::time_point checked;
+  };
+
+  /// Idle connections for a group of threads, with their own lock.
+  struct shard
+  {
+    mutable std::mutex mutex;
+    /// Idle connections, most recently returned last.
+    std::vector<idle_connection> idle;
+  };
+
+  /// Take a connection back.
+  void give_back(
+    std::unique_ptr<connection>, std::size_t num_prepared,
+    pool_priority priority);
+
+  /// May the caller holding @c ticket try to get a connection now?
+  /** Call only while holding @c m_mutex. */
+  bool PQXX_PRIVATE
+  may_go(std::uint64_t ticket, pool_priority priority) const noexcept;
+
+  /// Take @c ticket out of the wait queue.  Hold @c m_mutex.
+  void PQXX_PRIVATE leave_queue(std::uint64_t ticket, pool_priority) noexcept;
+
+  /// The calling thread's own shard.
+  shard &home_shard() noexcept;
+
+  /// Take an idle connection that's still open, if there is one.
+  /** Tries the calling thread's own shard first, then the others.  Moves any
+   * broken connections it finds into @c doomed.
+   */
+  bool take_idle(
+    idle_connection &out, std::vector<std::unique_ptr<connection>> &doomed);
+
+  /// Remove idle connections beyond min_size from one shard.
+  /** Moves the connections into @c doomed, so the caller can close them
+   * after letting go of the locks.
+   */
+  void evict(shard &, std::vector<std::unique_ptr<connection>> &doomed);
+
+  /// Evict from the calling thread's shard, and from one other in turn.
+  void evict(std::vector<std::unique_ptr<connection>> &doomed);
+
+  /// Check idle connections that are due a heartbeat.
+  /** Moves any dead connections into @c doomed. */
+  void heartbeat(std::vector<std::unique_ptr<connection>> &doomed);
+
+  /// Open connections until there are @c min_idle idle ones.
+  void top_up();
+
+  /// Put connections into the shards, in order of their return times.
+  void PQXX_PRIVATE restore(shard &, std::vector<idle_connection> &entries);
+
+  /// Body of the maintenance thread.
+  void PQXX_PRIVATE maintenance_loop() noexcept;
+
+  /// Prepare any statements the connection does not have yet.
+  std::size_t
+  prepare_missing(connection &, std::size_t num_prepared) const;
+
+  std::string const m_options;
+  connection_pool_config const m_config;
+
+  /// Idle connections, by shard.
+  /** Lock a shard's mutex before @c m_mutex, never the other way around. */
+  std::vector<shard> m_shards;
+  /// Next shard to check for idle connections, apart from the caller's own.
+  std::atomic<std::size_t> m_evict_next{0};
+
+  mutable std::mutex m_mutex;
+  /// Signals that a connection came back, or a connection slot freed up.
+  std::condition_variable m_returned;
+  /// Counts the events that @c m_returned signals.
+  /** By comparing this before and after looking for an idle connection,
+   * @c get() knows whether it may have missed a signal.
+   */
+  std::size_t m_returns = 0;
+  /// Connections open or being opened, including borrowed ones.
+  std::size_t m_open = 0;
+  /// Statements to prepare on each connection.
+  std::vector<prepare::statement> m_statements;
+
+  /// Callers in line for a connection, as ticket numbers, by priority.
+  std::array<std::deque<std::uint64_t>, 2> m_queue;
+  /// Ticket number for the next caller of @c get().
+  std::uint64_t m_next_ticket = 0;
+  /// Connections borrowed by batch callers.
+  std::size_t m_batch_busy = 0;
+  /// Wait queue statistics, by priority.
+  std::array<pool_queue_stats, 2> m_stats;
+
+  /// Wakes up the maintenance thread.
+  std::condition_variable m_wake;
+  /// Tells the maintenance thread to stop.
+  bool m_stopping = false;
+  /// Background maintenance, if configured.  Starts last, stops first.
+  std::thread m_maintenance;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,199 @@
+/* Definition of the pqxx::connection_router class.
+ *
+ * pqxx::connection_router sends read-only work to replicas.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/connection_router instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_CONNECTION_ROUTER
+#define PQXX_H_CONNECTION_ROUTER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "pqxx/connection_pool.hxx"
+#include "pqxx/transaction.hxx"
+
+
+namespace pqxx::internal
+{
+/// Does a transaction of type @c TX only read?
+template<typename TX> inline constexpr bool is_read_only_transaction{false};
+
+template<isolation_level ISOLATION>
+inline constexpr bool
+  is_read_only_transaction<transaction<ISOLATION, write_policy::read_only>>{
+    true};
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Settings for a @c connection_router.
+struct connection_router_config
+{
+  /// Settings for each server's connection pool.
+  /** The replicas' pools ignore @c min_size: they connect only once they
+   * need to, so that a replica being down does not stop you from creating
+   * the router.
+   */
+  connection_pool_config pool;
+
+  /// Most replication lag a replica may have, and still get work.
+  /** The lag is the time since the replica replayed its last transaction
+   * from the primary.  If the primary is idle, that overstates it.
+   */
+  std::chrono::milliseconds max_lag{std::chrono::seconds{10}};
+
+  /// How often to measure the replicas' latency and lag.
+  std::chrono::milliseconds probe_interval{std::chrono::seconds{5}};
+
+  /// How long to leave a replica alone, once connecting to it failed.
+  std::chrono::milliseconds retry_interval{std::chrono::seconds{5}};
+
+  /// How long to wait for a replica to catch up with a commit.
+  /** When you ask for a replica that has replayed a given commit, and none
+   * has as far as the router knows, it checks the best replica again for
+   * up to this long.  After that, it gives you the primary.  Zero means don't
+   * wait at all.
+   */
+  std::chrono::milliseconds causal_wait{10};
+};
+
+
+/// Hands out connections to a primary, or to one of its replicas.
+/** Give the router a connection string for the primary, and one for each
+ * replica.  Then ask it for a connection to suit the kind of transaction you
+ * want to run: @c get<pqxx::read_transaction>() borrows a connection to a
+ * replica, and @c get<pqxx::work>() one to the primary.
+ *
+ * Every so often, the router measures each replica's round-trip latency and
+ * replication lag.  Of the replicas that are up and not lagging too far
+ * behind, it picks the one with the lowest latency.  If there is none, read
+ * work goes to the primary as well.  The measuring happens in whichever
+ * thread next asks for a replica connection once it's due.
+ *
+ * A primary connection string may itself list several hosts, with
+ * @c target_session_attrs=read-write, so that libpq finds whichever of them
+ * is the primary at the time.
+ *
+ * A router is thread-safe.  All connections must be back before the router
+ * is destroyed.
+ */
+class PQXX_LIBEXPORT connection_router
+{
+public:
+  /// What the router knows about a replica.
+  struct replica_status
+  {
+    /// Connection string.
+    std::string options;
+    /// Was the replica reachable the last time we tried?
+    bool up = true;
+    /// Smoothed round-trip time of the last probes.
+    std::chrono::microseconds latency{0};
+    /// Replication lag, as of the last probe.
+    std::chrono::milliseconds lag{0};
+    /// How far the replica had replayed the write-ahead log, last we looked.
+    lsn replayed = 0;
+  };
+
+  connection_router(
+    std::string primary, std::vector<std::string> const &replicas,
+    connection_router_config const &config = connection_router_config{});
+  ~connection_router() noexcept;
+
+  connection_router(connection_router const &) = delete;
+  connection_router &operator=(connection_router const &) = delete;
+
+  /// Borrow a connection to the primary.
+  [[nodiscard]] pooled_connection primary();
+
+  /// Borrow a connection for read-only work.
+  /** Goes to the best replica, or if no replica is fit for work, to the
+   * primary.  If connecting to the chosen replica fails, the router marks it
+   * as down and tries the next best.
+   */
+  [[nodiscard]] pooled_connection replica();
+
+  /// Borrow a connection that can see everything up to a given commit.
+  /** This is for reading your own writes.  Pass the @c commit_lsn() of a
+   * transaction that you committed on the primary, and you get a connection
+   * to a replica which has replayed that commit.  If no replica has caught up
+   * yet, it waits up to @c connection_router_config::causal_wait for the best
+   * one, and failing that, gives you the primary.
+   *
+   * The router remembers how far each replica got, as of the last probe or
+   * wait.  So usually this costs nothing extra.
+   *
+   * A @c commit of zero means there is nothing to wait for.
+   */
+  [[nodiscard]] pooled_connection replica(lsn commit);
+
+  /// Borrow a connection suitable for running a transaction of type @c TX.
+  /** Read-only transaction types, such as @c read_transaction, go to a
+   * replica.  All others, including @c nontransaction, go to the primary.
+   */
+  template<typename TX> [[nodiscard]] pooled_connection get()
+  {
+    if constexpr (internal::is_read_only_transaction<TX>)
+      return replica();
+    else
+      return primary();
+  }
+
+  /// Like @c get(), but read-only work must see everything up to @c commit.
+  template<typename TX> [[nodiscard]] pooled_connection get(lsn commit)
+  {
+    if constexpr (internal::is_read_only_transaction<TX>)
+      return replica(commit);
+    else
+      return primary();
+  }
+
+  /// Measure all replicas' latency and lag, now.
+  void probe();
+
+  /// What the router currently knows about its replicas.
+  [[nodiscard]] std::vector<replica_status> replicas() const;
+
+private:
+  struct replica_state;
+
+  /// Probe if it's been long enough since the last time.
+  PQXX_PRIVATE void probe_if_due();
+  /// Measure one replica.  Call without holding the lock.
+  PQXX_PRIVATE void probe(replica_state &);
+  /// Replicas fit for work, best first.
+  PQXX_PRIVATE std::vector<replica_state *> candidates() const;
+  /// Mark a replica as down.
+  PQXX_PRIVATE void mark_down(replica_state &);
+  /// Poll a replica until it has replayed @c commit, or we run out of time.
+  PQXX_PRIVATE bool catch_up(replica_state &, connection &, lsn commit);
+
+  connection_router_config const m_config;
+  connection_pool m_primary;
+  std::vector<std::unique_ptr<replica_state>> m_replicas;
+
+  mutable std::mutex m_mutex;
+  /// When we last probed, or nothing if we never did.
+  std::optional<std::chrono::steady_clock::time_point> m_last_probe;
+  /// Is a probe in progress?
+  bool m_probing = false;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
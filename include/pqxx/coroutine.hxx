@@ -0,0 +1,235 @@
+/* Awaitable queries and stream reads, for C++20 coroutines.
+ *
+ * These suspend a coroutine until a pqxx::reactor has the outcome.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/coroutine instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_COROUTINE
+#define PQXX_H_COROUTINE
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+// The library itself builds as C++17.  These awaitables live entirely in
+// this header, so they're there whenever your own code compiles with
+// coroutine support.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#  include <coroutine>
+#  include <exception>
+#  include <memory>
+#  include <string>
+#  include <utility>
+
+#  include "pqxx/reactor.hxx"
+#  include "pqxx/stream_from.hxx"
+
+
+namespace pqxx::internal
+{
+/// Awaitable for a query which a @c reactor executes.
+class query_awaiter
+{
+public:
+  query_awaiter(
+    reactor &r, connection &c, std::shared_ptr<std::string> text,
+    std::shared_ptr<params const> args = {}, bool prepared = false) :
+          m_reactor{r},
+          m_conn{c},
+          m_query{std::move(text), {}, std::move(args), prepared}
+  {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> waiter)
+  {
+    m_query.callback = [this, waiter](
+                         result const &res, std::exception_ptr err) {
+      m_result = res;
+      m_error = std::move(err);
+      waiter.resume();
+    };
+    m_reactor.enqueue(m_conn, std::move(m_query));
+  }
+
+  result await_resume()
+  {
+    if (m_error)
+      std::rethrow_exception(m_error);
+    return std::move(m_result);
+  }
+
+private:
+  reactor &m_reactor;
+  connection &m_conn;
+  reactor::queued_query m_query;
+  result m_result;
+  std::exception_ptr m_error;
+};
+
+
+/// Awaitable for input to arrive on a connection.
+class readable_awaiter
+{
+public:
+  readable_awaiter(reactor &r, connection &c) : m_reactor{r}, m_conn{c} {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> waiter)
+  {
+    m_reactor.once_readable(
+      m_conn, [waiter](connection &) { waiter.resume(); });
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  reactor &m_reactor;
+  connection &m_conn;
+};
+
+
+/// Awaitable for a row from a @c stream_from.
+/** Tries to read right away.  Only if no row is available yet does it
+ * suspend, until the reactor sees input on the connection.
+ */
+template<typename Tuple> class read_awaiter
+{
+public:
+  read_awaiter(reactor &r, connection &c, stream_from &s, Tuple &row) :
+          m_reactor{r},
+          m_conn{c},
+          m_stream{s},
+          m_row{row}
+  {}
+
+  bool await_ready()
+  {
+    m_status = m_stream.try_read(m_row);
+    return m_status != stream_from::read_status::would_block;
+  }
+
+  void await_suspend(std::coroutine_handle<> waiter) { wait(waiter); }
+
+  bool await_resume()
+  {
+    if (m_error)
+      std::rethrow_exception(m_error);
+    return m_status == stream_from::read_status::row;
+  }
+
+private:
+  void wait(std::coroutine_handle<> waiter)
+  {
+    m_reactor.once_readable(m_conn, [this, waiter](connection &) {
+      try
+      {
+        m_status = m_stream.try_read(m_row);
+        if (m_status == stream_from::read_status::would_block)
+        {
+          wait(waiter);
+          return;
+        }
+      }
+      catch (std::exception const &)
+      {
+        m_error = std::current_exception();
+      }
+      waiter.resume();
+    });
+  }
+
+  reactor &m_reactor;
+  connection &m_conn;
+  stream_from &m_stream;
+  Tuple &m_row;
+  stream_from::read_status m_status = stream_from::read_status::would_block;
+  std::exception_ptr m_error;
+};
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Execute a query on a connection, from a coroutine.
+/** The coroutine suspends until the query completes, and then resumes inside
+ * @c reactor::poll() or @c reactor::run(), on that thread.  The result of the
+ * @c co_await is the query's result.  If the query fails, the @c co_await
+ * throws the exception.
+ *
+ * The connection must have been added to the reactor.
+ */
+[[nodiscard]] inline internal::query_awaiter
+async_exec(reactor &r, connection &c, std::string query)
+{
+  return {r, c, std::make_shared<std::string>(std::move(query))};
+}
+
+
+/// Execute a parameterised query, from a coroutine.
+/** Works like @c async_exec(), but with parameters, like
+ * @c transaction_base::exec_params().
+ */
+template<typename... Args>
+[[nodiscard]] inline internal::query_awaiter async_exec_params(
+  reactor &r, connection &c, std::string query, Args &&... args)
+{
+  return {
+    r, c, std::make_shared<std::string>(std::move(query)),
+    std::make_shared<internal::params>(std::forward<Args>(args)...), false};
+}
+
+
+/// Execute a prepared statement, from a coroutine.
+/** Works like @c async_exec_params(), but executes the prepared statement of
+ * the given name.
+ */
+template<typename... Args>
+[[nodiscard]] inline internal::query_awaiter async_exec_prepared(
+  reactor &r, connection &c, std::string statement, Args &&... args)
+{
+  return {
+    r, c, std::make_shared<std::string>(std::move(statement)),
+    std::make_shared<internal::params>(std::forward<Args>(args)...), true};
+}
+
+
+/// Suspend a coroutine until input arrives on a connection.
+[[nodiscard]] inline internal::readable_awaiter
+async_readable(reactor &r, connection &c)
+{
+  return {r, c};
+}
+
+
+/// Read a row from a @c stream_from, from a coroutine.
+/** The result of the @c co_await is @c true if it read a row into @c row, or
+ * @c false if the stream has ended.  Pass the connection on which the stream
+ * runs; it must have been added to the reactor.
+ *
+ * @code
+ * std::tuple<int, std::string> row;
+ * while (co_await pqxx::async_read(reactor, conn, stream, row))
+ *   process(row);
+ * stream.complete();
+ * @endcode
+ */
+template<typename Tuple>
+[[nodiscard]] inline internal::read_awaiter<Tuple>
+async_read(reactor &r, connection &c, stream_from &s, Tuple &row)
+{
+  return {r, c, s, row};
+}
+} // namespace pqxx
+
+#endif
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
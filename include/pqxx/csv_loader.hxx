@@ -0,0 +1,199 @@
+/* Definition of the pqxx::csv_loader class.
+ *
+ * pqxx::csv_loader parses CSV files in parallel, and writes them to tables.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/csv_loader instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_CSV_LOADER
+#define PQXX_H_CSV_LOADER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "pqxx/stream_to.hxx"
+
+
+namespace pqxx
+{
+/// How a @c csv_loader reads its input.
+struct csv_options
+{
+  /// Character between fields: a comma for CSV, or a tab for TSV.
+  char delimiter = ',';
+  /// Character around quoted fields.
+  char quote = '"';
+  /// Does the file start with a header record?  If so, it gets skipped.
+  bool header = false;
+  /// Number of threads to parse with.  Zero means one per processor core.
+  std::size_t threads = 0;
+  /// Amount of input, in bytes, that each thread parses at a time.
+  std::size_t chunk_size = 4 * 1024 * 1024;
+};
+
+
+namespace internal
+{
+/// One field of a CSV record.
+struct csv_field
+{
+  /// The field's text, without any quotes.
+  std::string_view text;
+  /// Was the field quoted?  An empty unquoted field is a null.
+  bool quoted;
+};
+
+
+/// Parse the CSV record at @c here in @c data into @c fields.
+/** Returns @c false when there are no more records.  Otherwise, moves
+ * @c here past the record.  The fields' text may point into @c data, or
+ * into @c workspace, so they're valid until the next call.
+ */
+PQXX_LIBEXPORT bool next_csv_record(
+  std::string_view data, std::size_t &here, csv_options const &options,
+  std::vector<csv_field> &fields, std::string &workspace);
+
+
+/// Convert one CSV field into @c out, as a field in COPY's text format.
+template<typename T>
+inline void encode_csv_field(csv_field const &field, std::string &out)
+{
+  if (field.text.empty() and not field.quoted)
+  {
+    if constexpr (nullness<T>::has_null)
+      out += "\\N";
+    else
+      throw_null_conversion(name_type<T>());
+  }
+  else if constexpr (std::is_same_v<T, std::string>)
+  {
+    // No conversion needed, so don't build a string just to check it.
+    auto const start{out.size()};
+    out += field.text;
+    copy_escape_tail(out, start);
+  }
+  else
+  {
+    // This is the validation: the text has to make sense as a T.
+    append_copy_field(out, from_string<T>(field.text));
+  }
+}
+
+
+template<typename... TYPE, std::size_t... INDEX>
+inline void encode_csv_record(
+  std::vector<csv_field> const &fields, std::string &out,
+  std::index_sequence<INDEX...>)
+{
+  (((INDEX == 0 ? void() : out.push_back('\t')),
+    encode_csv_field<TYPE>(fields[INDEX], out)),
+   ...);
+  out.push_back('\n');
+}
+
+
+/// Convert a chunk of CSV records to COPY text, converting each field.
+/** Counts the records in @c records as it goes, so if a conversion throws,
+ * @c records says which record it was.
+ */
+template<typename... TYPE>
+inline void encode_csv_chunk(
+  std::string_view chunk, csv_options const &options, std::string &out,
+  std::size_t &records)
+{
+  std::vector<csv_field> fields;
+  std::string workspace;
+  std::size_t here{0};
+  while (next_csv_record(chunk, here, options, fields, workspace))
+  {
+    if (std::size(fields) != sizeof...(TYPE))
+      throw conversion_error{
+        "Expected " + to_string(sizeof...(TYPE)) +
+        " field(s) in CSV record, found " + to_string(std::size(fields)) +
+        "."};
+    encode_csv_record<TYPE...>(
+      fields, out, std::index_sequence_for<TYPE...>{});
+    ++records;
+  }
+}
+
+
+/// Signature of @c encode_csv_chunk.
+using csv_encoder = void (*)(
+  std::string_view, csv_options const &, std::string &, std::size_t &);
+} // namespace internal
+
+
+/// Load CSV files into tables, parsing and validating them in parallel.
+/** When a load needs the data checked and converted on the client side,
+ * parsing the file on a single core can be the bottleneck.  A @c csv_loader
+ * maps the file into memory, splits it into chunks at record boundaries, and
+ * converts the chunks on a pool of threads.  Each field must convert to its
+ * column's C++ type; a bad record stops the load, with an error saying which
+ * record it was.  The converted chunks go to the streams in order.
+ *
+ * With several target streams, each on its own connection, the chunks go to
+ * the streams in turn.  Then each stream gets its records in file order, but
+ * of course the database will no longer see them in a single order.
+ *
+ * The input follows RFC 4180: records end in a newline (optionally with a
+ * carriage return), and fields containing delimiters, quotes, or newlines are
+ * quoted, with any quotes inside doubled.  Quotes may not appear in unquoted
+ * fields.  As in PostgreSQL's own CSV format, an empty unquoted field is a
+ * null; a quoted empty field is an empty string.
+ *
+ * @code
+ *	pqxx::stream_to stream{tx, "measurement"};
+ *	pqxx::csv_loader loader{stream};
+ *	loader.load<int, std::string, std::optional<double>>("data.csv");
+ *	stream.complete();
+ * @endcode
+ *
+ * This class starts threads, so your program may need to link to a
+ * threading library.  The conversions run concurrently, so their
+ * @c string_traits must be thread-safe; the ones in libpqxx are.  Only the
+ * calling thread touches the streams.
+ */
+class PQXX_LIBEXPORT csv_loader
+{
+public:
+  /// Load into a single stream, which must be in text format.
+  explicit csv_loader(stream_to &target, csv_options const &options = {});
+
+  /// Load into several streams, sending chunks to each in turn.
+  csv_loader(std::vector<stream_to *> targets, csv_options const &options);
+
+  /// Load the CSV file at @c path, converting each record to @c TYPE....
+  /** Throws @c conversion_error if a record has the wrong number of fields,
+   * or a field does not convert.  The message says which record, counting
+   * from 1 but not counting any header.  By then, the records before it may
+   * already have gone to the streams, so abort the transactions.
+   *
+   * @return The number of records loaded.
+   */
+  template<typename... TYPE> std::size_t load(std::string_view path)
+  {
+    return run(path, &internal::encode_csv_chunk<TYPE...>);
+  }
+
+private:
+  std::size_t run(std::string_view path, internal::csv_encoder);
+
+  std::vector<stream_to *> const m_targets;
+  csv_options const m_options;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
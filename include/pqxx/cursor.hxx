@@ -16,8 +16,13 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <chrono>
 #include <limits>
+#include <list>
+#include <optional>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "pqxx/result.hxx"
 #include "pqxx/transaction_base.hxx"
@@ -184,6 +189,26 @@ public:
     return internal::obtain_stateless_cursor_size(m_cur);
   }
 
+  /// Cache rows in blocks of @c block_rows, keeping up to @c max_blocks.
+  /** With the cache on, a @c retrieve() of exactly one block, in ascending
+   * order, comes from the cache if it can.  If not, it fetches that block,
+   * plus the next one in the direction you're scrolling, in a single round
+   * trip.  So if you page through the rows with a page size of
+   * @c block_rows, only every other page costs a round trip, and revisiting
+   * a recent page costs none.  Other ranges go to the server as before.
+   *
+   * Pass zero for @c block_rows to turn the cache off.
+   */
+  void set_cache(size_type block_rows, std::size_t max_blocks = 8)
+  {
+    if (block_rows < 0)
+      throw argument_error{"Negative cursor cache block size."};
+    if (block_rows == 0)
+      m_cache.reset();
+    else
+      m_cache.emplace(block_rows, max_blocks);
+  }
+
   /// Retrieve rows from begin_pos (inclusive) to end_pos (exclusive)
   /** Rows are numbered starting from 0 to size()-1.
    *
@@ -198,8 +223,11 @@ public:
    */
   result retrieve(difference_type begin_pos, difference_type end_pos)
   {
+    auto const rows{result::difference_type(size())};
+    if (m_cache)
+      return m_cache->retrieve(m_cur, rows, begin_pos, end_pos);
     return internal::stateless_cursor_retrieve(
-      m_cur, result::difference_type(size()), begin_pos, end_pos);
+      m_cur, rows, begin_pos, end_pos);
   }
 
   [[nodiscard]] std::string const &name() const noexcept
@@ -209,6 +237,7 @@ public:
 
 private:
   internal::sql_cursor m_cur;
+  std::optional<internal::stateless_cursor_cache> m_cache;
 };
 
 
@@ -223,8 +252,69 @@ class icursorstream_icursor_iterator;
 } // namespace pqxx::internal::gate
 
 
+namespace pqxx::internal
+{
+/// A FETCH which an @c icursorstream sent ahead of time.
+/** While the FETCH is in flight, this object is the transaction's focus, so
+ * that nothing else tries to use the connection before the rows come in.
+ */
+class PQXX_LIBEXPORT cursor_prefetch : public transactionfocus
+{
+public:
+  using difference_type = cursor_base::difference_type;
+
+  cursor_prefetch(transaction_base &t, sql_cursor &cur) :
+          namedclass{"icursorstream", cur.name()},
+          transactionfocus{t},
+          m_cur{cur}
+  {}
+  ~cursor_prefetch() noexcept;
+
+  /// Is there a FETCH in flight?
+  [[nodiscard]] bool pending() const noexcept { return registered(); }
+
+  /// Number of rows the FETCH in flight asked for.
+  [[nodiscard]] difference_type rows() const noexcept { return m_rows; }
+
+  /// Send a FETCH for @c rows rows.
+  void start(difference_type rows);
+
+  /// Wait for the rows from the FETCH in flight.
+  result finish();
+
+private:
+  sql_cursor &m_cur;
+  difference_type m_rows = 0;
+};
+} // namespace pqxx::internal
+
+
 namespace pqxx
 {
+/// Adaptive stride policy for an @c icursorstream.
+/** Instead of fetching a fixed number of rows at a time, a cursor stream can
+ * pick each block's size based on what it measured on earlier blocks.  See
+ * @c icursorstream::set_stride(adaptive_stride const &).
+ */
+struct adaptive_stride
+{
+  /// Aim for blocks taking up about this many bytes in memory.
+  std::size_t block_bytes = 4 * 1024 * 1024;
+
+  /// Keep each block's FETCH from taking longer than this.
+  /** Zero means no limit.
+   */
+  std::chrono::steady_clock::duration max_latency =
+    std::chrono::milliseconds{200};
+
+  /// Never fetch fewer rows at a time than this.
+  cursor_base::difference_type min_stride = 1;
+
+  /// Never fetch more rows at a time than this.
+  cursor_base::difference_type max_stride = 1000000;
+};
+
+
 /// Simple read-only cursor represented as a stream of results
 /** SQL cursors can be tricky, especially in C++ since the two languages seem
  * to have been designed on different planets.  An SQL cursor has two singular
@@ -327,10 +417,48 @@ public:
    * @param stride Must be a positive number
    */
   void set_stride(difference_type stride);
+
+  /// Let the stream pick each block's number of rows, within limits.
+  /** After each block comes in, the stream works out the next block's stride
+   * from the average memory size of the rows it has seen so far, aiming for
+   * @c adaptive_stride::block_bytes per block.  If a block's FETCH takes
+   * time, the stride is also limited to what can arrive within
+   * @c adaptive_stride::max_latency at the measured time per row.  Time
+   * spent on prefetched blocks is not measured, since that would include the
+   * time you spent processing the previous block.
+   *
+   * The first block uses the current stride.  Calling @c set_stride with a
+   * number switches back to a fixed stride.
+   *
+   * Use this with @c get() or @c operator>>, not with @c icursor_iterator.
+   */
+  void set_stride(adaptive_stride const &policy);
+
+  /// Number of rows to fetch in the next block.
   [[nodiscard]] difference_type stride() const noexcept { return m_stride; }
 
+  /// Fetch each next block in the background, while you process this one.
+  /** With prefetching enabled, each time you read a block, the stream sends
+   * a request for the following block before it returns.  So while you work
+   * on the rows, the next ones are on their way.  Reading a block then only
+   * waits for the rows that were already requested.
+   *
+   * While a block is in flight, the transaction can't execute any other
+   * queries.  So read until the stream runs out, or destroy it, before you
+   * do anything else in the transaction.  To skip rows with @c ignore() while
+   * a block is in flight, skip at least a full stride.
+   *
+   * Turning prefetching off takes effect after the block in flight, if any.
+   */
+  void set_prefetch(bool prefetch = true) noexcept { m_prefetch = prefetch; }
+  [[nodiscard]] bool prefetch() const noexcept { return m_prefetch; }
+
 private:
   result fetchblock();
+  /// Pick the next stride, based on a block which took @c elapsed to fetch.
+  /** Pass zero for @c elapsed if the time wasn't measured.
+   */
+  void adapt_stride(result const &, std::chrono::steady_clock::duration);
 
   friend class internal::gate::icursorstream_icursor_iterator;
   size_type forward(size_type n = 1);
@@ -340,6 +468,8 @@ private:
   void service_iterators(difference_type);
 
   internal::sql_cursor m_cur;
+  /// The FETCH in flight, if any.  Must go before @c m_cur does.
+  internal::cursor_prefetch m_ahead;
 
   difference_type m_stride;
   difference_type m_realpos, m_reqpos;
@@ -347,6 +477,14 @@ private:
   mutable icursor_iterator *m_iterators;
 
   bool m_done;
+  bool m_prefetch = false;
+
+  std::optional<adaptive_stride> m_adaptive;
+  /// Rows, and their memory size, in blocks seen so far.
+  double m_sampled_rows = 0, m_sampled_bytes = 0;
+  /// Rows, and time taken, in blocks whose FETCH time we measured.
+  double m_timed_rows = 0;
+  std::chrono::duration<double> m_timed{0};
 };
 
 
@@ -0,0 +1,188 @@
+/* Definition of the pqxx::decimal template.
+ *
+ * pqxx::decimal is a fixed-point number, for NUMERIC columns.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/decimal instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_DECIMAL
+#define PQXX_H_DECIMAL
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstdint>
+
+#include "pqxx/binary_traits.hxx"
+#include "pqxx/strconv.hxx"
+
+
+namespace pqxx::internal
+{
+/// Most bytes a @c decimal can take in binary @c numeric format.
+/** Header of four 16-bit words, plus at most 7 base-10000 digits of 16 bits
+ * each: 19 decimal digits, plus padding to whole groups on both sides of the
+ * decimal point.
+ */
+constexpr std::size_t decimal_binary_max{8 + 2 * 7};
+
+/// Parse @c numeric text as a count of units of 10^-scale.
+PQXX_LIBEXPORT std::int64_t parse_decimal(std::string_view text, int scale);
+
+/// Write a count of units of 10^-scale as @c numeric text.
+/** Writes a terminating zero, and returns the address just after it.
+ */
+PQXX_LIBEXPORT char *
+write_decimal(char *begin, char *end, std::int64_t units, int scale);
+
+/// Read binary @c numeric as a count of units of 10^-scale.
+PQXX_LIBEXPORT std::int64_t
+decimal_from_binary(std::string_view data, int scale);
+
+/// Write units of 10^-scale in binary @c numeric format.
+/** Writes at most @c decimal_binary_max bytes.  Returns the address just
+ * beyond the data.
+ */
+PQXX_LIBEXPORT char *
+decimal_into_binary(char *begin, char *end, std::int64_t units, int scale);
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Fixed-point decimal number, with @c SCALE digits after the decimal point.
+/** This is a compact alternative to reading @c numeric columns as strings,
+ * or as floating-point numbers which can't represent most decimal fractions
+ * exactly.  It holds a signed 64-bit count of units of 10 to the power of
+ * -SCALE.  So a @c decimal<2> can go up to about 92 quadrillion, in steps of
+ * 0.01; and a @c decimal<0> holds whole numbers only.
+ *
+ * Converting text or binary @c numeric data to a @c decimal is exact, or it
+ * fails: a value with more digits after the decimal point than @c SCALE is a
+ * @c conversion_error, and one that's too large is a @c range_error.  So are
+ * NaN and the infinities.  None of the conversions allocate memory, except
+ * to report errors.
+ *
+ * Arithmetic is up to you: work in @c units(), and construct the result using
+ * @c from_units().
+ */
+template<int SCALE> class decimal
+{
+public:
+  static_assert(SCALE >= 0 and SCALE <= 18, "Unsupported decimal scale.");
+
+  /// Number of digits after the decimal point.
+  static constexpr int scale{SCALE};
+
+  constexpr decimal() noexcept = default;
+
+  /// A decimal of @c units times 10 to the power of -SCALE.
+  [[nodiscard]] static constexpr decimal
+  from_units(std::int64_t units) noexcept
+  {
+    decimal value;
+    value.m_units = units;
+    return value;
+  }
+
+  /// The value as a count of units of 10 to the power of -SCALE.
+  [[nodiscard]] constexpr std::int64_t units() const noexcept
+  {
+    return m_units;
+  }
+
+  [[nodiscard]] constexpr bool operator==(decimal rhs) const noexcept
+  {
+    return m_units == rhs.m_units;
+  }
+  [[nodiscard]] constexpr bool operator!=(decimal rhs) const noexcept
+  {
+    return m_units != rhs.m_units;
+  }
+  [[nodiscard]] constexpr bool operator<(decimal rhs) const noexcept
+  {
+    return m_units < rhs.m_units;
+  }
+  [[nodiscard]] constexpr bool operator<=(decimal rhs) const noexcept
+  {
+    return m_units <= rhs.m_units;
+  }
+  [[nodiscard]] constexpr bool operator>(decimal rhs) const noexcept
+  {
+    return m_units > rhs.m_units;
+  }
+  [[nodiscard]] constexpr bool operator>=(decimal rhs) const noexcept
+  {
+    return m_units >= rhs.m_units;
+  }
+
+private:
+  std::int64_t m_units = 0;
+};
+
+
+template<int SCALE> struct nullness<decimal<SCALE>> : no_null<decimal<SCALE>>
+{};
+
+
+template<int SCALE> struct string_traits<decimal<SCALE>>
+{
+  [[nodiscard]] static decimal<SCALE> from_string(std::string_view text)
+  {
+    return decimal<SCALE>::from_units(internal::parse_decimal(text, SCALE));
+  }
+
+  static zview to_buf(char *begin, char *end, decimal<SCALE> const &value)
+  {
+    auto const stop{into_buf(begin, end, value)};
+    return zview{begin, static_cast<std::size_t>(stop - begin - 1)};
+  }
+
+  static char *into_buf(char *begin, char *end, decimal<SCALE> const &value)
+  {
+    return internal::write_decimal(begin, end, value.units(), SCALE);
+  }
+
+  /// Sign, 19 digits, a leading zero, a decimal point, and a zero.
+  static constexpr std::size_t size_buffer(decimal<SCALE> const &) noexcept
+  {
+    return 1 + 19 + 1 + 1 + 1;
+  }
+};
+
+
+template<int SCALE> struct binary_traits<decimal<SCALE>>
+{
+  /// OID of @c numeric.
+  static constexpr oid type_oid{1700};
+
+  [[nodiscard]] static decimal<SCALE> from_binary(std::string_view data)
+  {
+    return decimal<SCALE>::from_units(
+      internal::decimal_from_binary(data, SCALE));
+  }
+
+  [[nodiscard]] static std::size_t binary_size(decimal<SCALE> const &value)
+  {
+    char buf[internal::decimal_binary_max];
+    return static_cast<std::size_t>(
+      internal::decimal_into_binary(
+        buf, buf + sizeof(buf), value.units(), SCALE) -
+      buf);
+  }
+
+  static char *
+  into_binary(char *begin, char *end, decimal<SCALE> const &value)
+  {
+    return internal::decimal_into_binary(begin, end, value.units(), SCALE);
+  }
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
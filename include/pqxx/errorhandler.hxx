@@ -17,6 +17,7 @@
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
 #include "pqxx/types.hxx"
+#include "pqxx/zview.hxx"
 
 
 namespace pqxx::internal::gate
@@ -32,6 +33,28 @@ namespace pqxx
  * @{
  */
 
+/// A notice or warning from the server, broken down into its fields.
+/** The fields point into libpq's own copy of the message, so they stay valid
+ * only until the error handler returns.  A field that the server did not send
+ * is an empty string.
+ */
+struct PQXX_LIBEXPORT notice
+{
+  /// The full message, as libpq formats it.  Ends in a newline.
+  zview message;
+  /// Severity, e.g. "NOTICE" or "WARNING".  Never translated.
+  zview severity;
+  /// The SQLSTATE code.
+  zview sqlstate;
+  /// The primary message, on its own.
+  zview primary;
+  /// Optional detail message.
+  zview detail;
+  /// Optional suggestion for what to do about it.
+  zview hint;
+};
+
+
 /// Base class for error-handler callbacks.
 /** To receive errors and warnings from a connection, subclass this with your
  * own error-handler functor, and instantiate it for the connection. Destroying
@@ -63,6 +86,21 @@ public:
    */
   virtual bool operator()(char const msg[]) noexcept = 0;
 
+  /// Receive a notice from the server, with its fields broken down.
+  /** Override this if you need the notice's individual fields.  By default,
+   * it passes the notice's full message to the other function call operator.
+   *
+   * Messages that don't come from the server, such as warnings from libpqxx
+   * itself, go only to the other function call operator.
+   *
+   * @return Whether the same notice should also be passed to the remaining,
+   * older errorhandlers.
+   */
+  virtual bool on_notice(notice const &n) noexcept
+  {
+    return (*this)(n.message.c_str());
+  }
+
   errorhandler() = delete;
   errorhandler(errorhandler const &) = delete;
   errorhandler &operator=(errorhandler const &) = delete;
@@ -109,6 +109,16 @@ struct PQXX_LIBEXPORT in_doubt_error : failure
 };
 
 
+/// A query result took more memory than the connection allows.
+/** See @c connection::set_result_size_limit().  By the time this happens, the
+ * result is already in memory, but libpqxx frees it right away.
+ */
+struct PQXX_LIBEXPORT result_too_large : failure
+{
+  explicit result_too_large(std::string const &);
+};
+
+
 /// The backend saw itself forced to roll back the ongoing transaction.
 struct PQXX_LIBEXPORT transaction_rollback : sql_error
 {
@@ -19,10 +19,112 @@
 #include <optional>
 
 #include "pqxx/array.hxx"
+#include "pqxx/binary_traits.hxx"
 #include "pqxx/result.hxx"
 #include "pqxx/strconv.hxx"
 #include "pqxx/types.hxx"
 
+namespace pqxx
+{
+template<typename CONTAINER, typename FIELD>
+CONTAINER parse_array(FIELD const &f);
+} // namespace pqxx
+
+
+namespace pqxx::internal::gate
+{
+class field_binarystring;
+} // namespace pqxx::internal::gate
+
+
+namespace pqxx::internal
+{
+/// Read a field's value into obj, or if null, return @c false.
+/** Shared between @c field and @c field_ref.  If the field is in binary
+ * format, this uses @c binary_traits instead of @c string_traits.
+ */
+template<typename FIELD, typename T>
+inline bool read_field(FIELD const &f, T &obj)
+{
+  if (f.is_binary())
+  {
+    if constexpr (pqxx::has_binary_traits<T>)
+    {
+      if (f.is_null())
+        return false;
+      obj = binary_traits<T>::from_binary(f.view());
+      return true;
+    }
+    else
+    {
+      throw conversion_error{
+        "No conversion from binary format to " +
+        std::string{name_type<T>()} + "."};
+    }
+  }
+  auto const bytes{f.c_str()};
+  if (bytes[0] == '\0' and f.is_null())
+    return false;
+  // Assigning keeps a string's allocator, e.g. a std::pmr::string's arena.
+  if constexpr (is_char_string<T>)
+    obj.assign(bytes, f.size());
+  else if constexpr (is_text_view<T>)
+    obj = from_string<T>(std::string_view{bytes, f.size()});
+  else if constexpr (std::is_same_v<T, char const *>)
+    obj = bytes;
+  else if constexpr (is_sql_array<T>)
+    obj = parse_array<T>(f);
+  else
+    from_string(bytes, obj);
+  return true;
+}
+
+
+/// Convert a non-null field to @c T, when we already know its format.
+/** For reading many rows: the caller checks each column's format once, and
+ * passes it in, instead of checking it for every field.
+ */
+template<typename T, typename FIELD>
+inline T read_value(FIELD const &f, bool binary)
+{
+  if (binary)
+  {
+    if constexpr (pqxx::has_binary_traits<T>)
+      return binary_traits<T>::from_binary(f.view());
+    else
+      throw conversion_error{
+        "No conversion from binary format to " +
+        std::string{name_type<T>()} + "."};
+  }
+  else if constexpr (is_sql_array<T>)
+  {
+    return parse_array<T>(f);
+  }
+  else
+  {
+    return from_string<T>(f.view());
+  }
+}
+
+
+/// Convert a field to @c T, when we already know the field's format.
+/** Like @c read_value, but also handles nulls.
+ */
+template<typename T, typename FIELD>
+inline T read_cell(FIELD const &f, bool binary)
+{
+  if (f.is_null())
+  {
+    if constexpr (nullness<T>::has_null)
+      return nullness<T>::null();
+    else
+      internal::throw_null_conversion(name_type<T>());
+  }
+  return read_value<T>(f, binary);
+}
+} // namespace pqxx::internal
+
+
 namespace pqxx
 {
 /// Reference to a field in a result set.
@@ -83,6 +185,12 @@ public:
   /// Column type
   [[nodiscard]] oid type() const;
 
+  /// Is this field in binary format, rather than text?
+  /** Fields are normally in text format.  Query functions with "binary" in
+   * their names produce results in binary format.
+   */
+  [[nodiscard]] bool is_binary() const noexcept;
+
   /// What table did this column come from?
   [[nodiscard]] oid table() const;
 
@@ -122,17 +230,16 @@ public:
   /// Read value into obj; or if null, leave obj untouched and return @c false.
   /** This can be used with optional types (except pointers other than C-style
    * strings).
+   *
+   * If the field is in binary format, this uses @c binary_traits instead of
+   * @c string_traits.
    */
   template<typename T>
   auto to(T &obj) const -> typename std::enable_if<
     (not std::is_pointer<T>::value or std::is_same<T, char const *>::value),
     bool>::type
   {
-    auto const bytes{c_str()};
-    if (bytes[0] == '\0' and is_null())
-      return false;
-    from_string(bytes, obj);
-    return true;
+    return internal::read_field(*this, obj);
   }
 
   /// Read value into obj; or leave obj untouched and return @c false if null.
@@ -178,7 +285,7 @@ public:
       if constexpr (nullness<T>::has_null)
         obj = nullness<T>::null();
       else
-        internal::throw_null_conversion(type_name<T>);
+        internal::throw_null_conversion(name_type<T>());
     }
     return obj;
   }
@@ -219,6 +326,15 @@ protected:
   row_size_type m_col;
 
 private:
+  friend class pqxx::internal::gate::field_binarystring;
+
+  /// The result's data, for sharing ownership of a value's bytes.
+  std::shared_ptr<internal::pq::PGresult const> const &
+  result_data() const noexcept
+  {
+    return m_home.m_data;
+  }
+
   result m_home;
   result::size_type m_row;
 };
@@ -230,7 +346,7 @@ template<> inline bool field::to<std::string>(std::string &obj) const
   char const *const bytes = c_str();
   if (bytes[0] == '\0' and is_null())
     return false;
-  obj = std::string{bytes, size()};
+  obj.assign(bytes, size());
   return true;
 }
 
@@ -242,6 +358,9 @@ template<> inline bool field::to<std::string>(std::string &obj) const
  */
 template<> inline bool field::to<char const *>(char const *&obj) const
 {
+  // Binary data may contain zero bytes.  Use c_str() and size() for those.
+  if (is_binary())
+    throw conversion_error{"Can't read binary field as a C-style string."};
   if (is_null())
     return false;
   obj = c_str();
@@ -249,6 +368,131 @@ template<> inline bool field::to<char const *>(char const *&obj) const
 }
 
 
+/// Lightweight, non-owning reference to a field in a result set.
+/** Works like @c field, but does not keep the result set alive.  Where a
+ * @c field holds its own copy of the @c result, and updates its reference
+ * counts on every copy and destruction, a @c field_ref merely points to a
+ * @c result object.  That makes it practically free to create, copy, and
+ * destroy, which matters in tight loops over large results.
+ *
+ * The price is that you have to keep that @c result object itself alive and
+ * unchanged for as long as you use the @c field_ref.  A copy of the result
+ * is not enough: the pointer is to the object.
+ */
+class field_ref
+{
+public:
+  using size_type = field_size_type;
+
+  /// Refer to field number @c col in row number @c row of @c r.
+  constexpr field_ref(
+    result const &r, result_size_type row, row_size_type col) noexcept :
+          m_home{&r},
+          m_row{row},
+          m_col{col}
+  {}
+
+  /// Column name.
+  [[nodiscard]] char const *name() const { return m_home->column_name(m_col); }
+
+  /// Column type.
+  [[nodiscard]] oid type() const { return m_home->column_type(m_col); }
+
+  /// Is this field in binary format, rather than text?
+  [[nodiscard]] bool is_binary() const noexcept
+  {
+    return m_home->column_format(m_col) == format::binary;
+  }
+
+  [[nodiscard]] row_size_type num() const noexcept { return m_col; }
+
+  /// Read as @c string_view.
+  [[nodiscard]] std::string_view view() const
+  {
+    return std::string_view(c_str(), size());
+  }
+
+  /// Read as plain C string.
+  [[nodiscard]] char const *c_str() const
+  {
+    return m_home->get_value(m_row, m_col);
+  }
+
+  /// Is this field's value null?
+  [[nodiscard]] bool is_null() const noexcept
+  {
+    return m_home->get_is_null(m_row, m_col);
+  }
+
+  /// Return number of bytes taken up by the field's value.
+  [[nodiscard]] size_type size() const noexcept
+  {
+    return m_home->get_length(m_row, m_col);
+  }
+
+  /// Read value into obj; or if null, leave obj untouched and return @c false.
+  template<typename T>
+  auto to(T &obj) const -> typename std::enable_if<
+    (not std::is_pointer<T>::value or std::is_same<T, char const *>::value),
+    bool>::type
+  {
+    return internal::read_field(*this, obj);
+  }
+
+  /// Read value into obj; or if null, use default value and return @c false.
+  template<typename T>
+  auto to(T &obj, T const &default_value) const -> typename std::enable_if<
+    (not std::is_pointer<T>::value or std::is_same<T, char const *>::value),
+    bool>::type
+  {
+    bool const has_value{to(obj)};
+    if (not has_value)
+      obj = default_value;
+    return has_value;
+  }
+
+  /// Return value as object of given type, or default value if null.
+  template<typename T> T as(T const &default_value) const
+  {
+    T obj;
+    to(obj, default_value);
+    return obj;
+  }
+
+  /// Return value as object of given type, or throw exception if null.
+  template<typename T> T as() const
+  {
+    T obj;
+    if (not to(obj))
+    {
+      if constexpr (nullness<T>::has_null)
+        obj = nullness<T>::null();
+      else
+        internal::throw_null_conversion(name_type<T>());
+    }
+    return obj;
+  }
+
+  /// Return value wrapped in some optional type (empty for nulls).
+  template<typename T, template<typename> class O = std::optional>
+  constexpr O<T> get() const
+  {
+    return as<O<T>>();
+  }
+
+  /// Parse the field as an SQL array.
+  array_parser as_array() const
+  {
+    return array_parser{c_str(), m_home->m_encoding};
+  }
+
+private:
+  result const *m_home;
+  result_size_type m_row;
+  row_size_type m_col;
+};
+
+
 template<typename CHAR = char, typename TRAITS = std::char_traits<CHAR>>
 class field_streambuf : public std::basic_streambuf<CHAR, TRAITS>
 {
@@ -361,5 +605,95 @@ template<typename T> inline T from_string(field const &value)
 template<> PQXX_LIBEXPORT std::string to_string(field const &value);
 } // namespace pqxx
 
+
+namespace pqxx::internal
+{
+/// Read an SQL array's elements into @c out, up to the closing brace.
+/** Call this right after the parser has found the opening brace.  If the
+ * container's elements are themselves containers, reads nested arrays into
+ * them.
+ */
+template<typename CONTAINER>
+inline void parse_array_elements(array_parser &parser, CONTAINER &out)
+{
+  using elt_type = typename CONTAINER::value_type;
+  static_assert(
+    not is_text_view<elt_type>,
+    "Array elements can't be views; their text does not last.");
+  using junc = array_parser::juncture;
+  for (;;)
+  {
+    auto const [found, value]{parser.get_next_view()};
+    switch (found)
+    {
+    case junc::string_value:
+      if constexpr (is_sql_array<elt_type>)
+        throw conversion_error{
+          "Expected nested array, got '" + std::string{value} + "'."};
+      else
+        out.push_back(from_string<elt_type>(value));
+      break;
+
+    case junc::null_value:
+      if constexpr (nullness<elt_type>::has_null)
+        out.push_back(nullness<elt_type>::null());
+      else
+        throw_null_conversion(name_type<elt_type>());
+      break;
+
+    case junc::row_start:
+      if constexpr (is_sql_array<elt_type>)
+        parse_array_elements(parser, out.emplace_back());
+      else
+        throw conversion_error{
+          "Unexpected nested array, reading array of " +
+          std::string{name_type<elt_type>()} +
+          "."};
+      break;
+
+    case junc::row_end: return;
+
+    case junc::done: throw conversion_error{"SQL array ended prematurely."};
+    }
+  }
+}
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Parse an SQL array field into a container, such as a @c std::vector.
+/** The container must support @c push_back(), and its elements must support
+ * @c from_string().  For a multi-dimensional array, use containers of
+ * containers, e.g. @c std::vector<std::vector<int>>.  An element type that
+ * can't be null, such as @c int, can't hold a null element; use an
+ * @c std::optional for those.
+ *
+ * This uses the parser's @c get_next_view(), so it won't allocate a string
+ * for each element.  But it does need the client encoding, so unlike
+ * @c from_string() it takes the field itself, or a @c field_ref:
+ *
+ * @code
+ * auto const tags{pqxx::parse_array<std::vector<std::string>>(row["tags"])};
+ * @endcode
+ */
+template<typename CONTAINER, typename FIELD>
+[[nodiscard]] inline CONTAINER parse_array(FIELD const &f)
+{
+  if (f.is_null())
+    internal::throw_null_conversion(name_type<CONTAINER>());
+  auto parser{f.as_array()};
+  if (parser.get_next_view().first != array_parser::juncture::row_start)
+    throw conversion_error{
+      "Not an SQL array: '" + std::string{f.view()} + "'."};
+  CONTAINER out;
+  internal::parse_array_elements(parser, out);
+  if (parser.get_next_view().first != array_parser::juncture::done)
+    throw conversion_error{
+      "Unexpected data after SQL array: '" + std::string{f.view()} + "'."};
+  return out;
+}
+} // namespace pqxx
+
 #include "pqxx/internal/compiler-internal-post.hxx"
 #endif
@@ -0,0 +1,129 @@
+/* Definition of the pqxx::group_commit class.
+ *
+ * pqxx::group_commit runs small writes from many threads in shared
+ * transactions.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/group_commit instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_GROUP_COMMIT
+#define PQXX_H_GROUP_COMMIT
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+#include "pqxx/transaction_base.hxx"
+
+
+namespace pqxx
+{
+/// What a @c group_commit does when one of its writes fails.
+enum class group_failure
+{
+  /// Run each write in a savepoint.  A write that fails, fails alone.
+  isolate,
+  /// A write that fails aborts its whole batch.
+  all_or_nothing,
+};
+
+
+/// When a @c group_commit commits what it has collected, and how.
+struct group_commit_policy
+{
+  /// Commit once this many writes are waiting.  Zero means no limit.
+  std::size_t max_writes = 100;
+  /// Commit once the oldest waiting write is this old.
+  std::chrono::milliseconds max_delay{5};
+  /// What to do when a write fails.
+  group_failure on_failure = group_failure::isolate;
+};
+
+
+/// Runs small, independent writes from many threads in shared transactions.
+/** Every transaction costs round trips for its @c BEGIN and @c COMMIT, and a
+ * flush of the server's write-ahead log on commit.  For a stream of tiny
+ * writes, that overhead can be most of the work.  A group commit collects
+ * writes from any number of threads for a short while, and runs them all in
+ * a single transaction.  That trades a bounded delay for throughput.
+ *
+ * You @c submit() each write as a callback, which gets a transaction.  You
+ * get a @c std::future, which completes once the transaction containing the
+ * write has committed, or carries the exception if it failed.
+ *
+ * A background thread does the work, on the connection you pass.  It owns
+ * that connection for as long as the group commit exists: don't use it for
+ * anything else in the meantime.
+ *
+ * With @c group_failure::isolate, each write runs in a savepoint, so one
+ * failing write does not affect the others in its batch.  With
+ * @c group_failure::all_or_nothing there are no savepoints, which is
+ * cheaper, but any failure aborts the batch, and all of its writes get the
+ * exception.  Either way, if the commit itself fails, all writes in the batch
+ * fail with it.
+ *
+ * Writes must not commit or abort the transaction they get.
+ */
+class PQXX_LIBEXPORT group_commit
+{
+public:
+  /// A write.  It executes its statements on the transaction it gets.
+  using write = std::function<void(transaction_base &)>;
+
+  explicit group_commit(connection &cx, group_commit_policy policy = {});
+  group_commit(group_commit const &) = delete;
+  group_commit &operator=(group_commit const &) = delete;
+  /// Commit the writes that are still waiting, and stop.
+  ~group_commit() noexcept;
+
+  /// Queue a write.  The future completes when its batch has committed.
+  [[nodiscard]] std::future<void> submit(write w);
+
+  /// Number of writes waiting for the next batch.
+  [[nodiscard]] std::size_t pending() const;
+
+  /// Number of batches that have committed so far.
+  [[nodiscard]] std::size_t batches() const;
+
+private:
+  struct queued
+  {
+    write w;
+    std::promise<void> done;
+    /// When the write came in.
+    std::chrono::steady_clock::time_point since;
+  };
+
+  /// The background thread's main loop.
+  void PQXX_PRIVATE run() noexcept;
+  /// Run one batch of writes in a transaction, and complete their futures.
+  void PQXX_PRIVATE commit_batch(std::vector<queued> &batch) noexcept;
+
+  connection &m_conn;
+  group_commit_policy const m_policy;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<queued> m_queue;
+  std::size_t m_batches = 0;
+  bool m_stop = false;
+  /// Comes last, so it starts after everything else is ready.
+  std::thread m_thread;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
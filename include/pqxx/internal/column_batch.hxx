@@ -0,0 +1,71 @@
+/** Batches of values, one column at a time.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY.  Other headers include it for you.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_COLUMN_BATCH
+#define PQXX_H_COLUMN_BATCH
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace pqxx
+{
+/// One column's worth of values.
+/** See @c stream_from::read_columns() and @c result::column_as().  For each
+ * row, @c values holds the field's value, and @c nulls says whether the field
+ * was null.  Where it was, the value is @c T's null value if it has one, or a
+ * default-constructed @c T if it doesn't.
+ */
+template<typename T> struct column_batch
+{
+  std::vector<T> values;
+  std::vector<bool> nulls;
+
+  /// Number of rows in the batch.
+  [[nodiscard]] std::size_t size() const noexcept { return values.size(); }
+
+  /// Was the field in row @c row null?
+  [[nodiscard]] bool is_null(std::size_t row) const { return nulls[row]; }
+
+  /// Empty the batch.  Keeps the memory allocated, for re-use.
+  void clear() noexcept
+  {
+    values.clear();
+    nulls.clear();
+  }
+
+  /// Shrink the batch to @c rows rows.
+  void truncate(std::size_t rows)
+  {
+    values.erase(
+      values.begin() + static_cast<std::ptrdiff_t>(rows), values.end());
+    nulls.resize(rows);
+  }
+
+  /// Pack the null flags into an Arrow-style validity bitmap.
+  /** One bit per row, least significant bit first.  A row's bit is set if its
+   * field is not null.  Any unused bits in the last byte are zero.
+   */
+  [[nodiscard]] std::vector<std::uint8_t> validity_bitmap() const
+  {
+    std::vector<std::uint8_t> bits((std::size(nulls) + 7) / 8);
+    for (std::size_t row{0}; row < std::size(nulls); ++row)
+      if (not nulls[row])
+        bits[row / 8] |= static_cast<std::uint8_t>(1u << (row % 8));
+    return bits;
+  }
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -66,7 +66,19 @@ inline std::string state_buffer_overrun(HAVE have_bytes, NEED need_bytes)
 
 /// Throw exception for attempt to convert null to given type.
 [[noreturn]] PQXX_LIBEXPORT void
-throw_null_conversion(std::string const &type);
+throw_null_conversion(std::string_view type);
+
+
+/// Is @c T a type that refers to text, instead of holding it?
+/** Converting to one of these types costs no allocation or copying, but the
+ * result is only valid for as long as the text it came from.
+ */
+template<typename T>
+inline constexpr bool is_text_view{
+  std::is_same_v<T, std::string_view> or std::is_same_v<T, zview>};
+
+template<typename T>
+inline constexpr bool is_text_view<std::optional<T>>{is_text_view<T>};
 
 
 template<typename T> PQXX_LIBEXPORT extern std::string to_string_float(T);
@@ -83,7 +95,7 @@ inline char *generic_into_buf(char *begin, char *end, T const &value)
   auto const len = text.size() + 1;
   if (len > space)
     throw conversion_overrun{"Not enough buffer space to insert " +
-                             type_name<T> + ".  " +
+                             std::string{name_type<T>()} + ".  " +
                              state_buffer_overrun(space, len)};
   std::memmove(begin, text.data(), len);
   return begin + len;
@@ -119,9 +131,25 @@ template<typename T> struct float_traits
   {
     /** Includes a sign if needed; a possible leading zero before the decimal
      * point; the full number of base-10 digits which may be needed; a decimal
-     * point if needed; and the terminating zero.
+     * point if needed; an exponent, with its "e" and sign; and the
+     * terminating zero.
      */
-    return 1 + 1 + std::numeric_limits<T>::max_digits10 + 1 + 1;
+    return 1 + 1 + std::numeric_limits<T>::max_digits10 + 1 +
+           (2 + exponent_digits()) + 1;
+  }
+
+private:
+  /// Maximum number of digits in a decimal exponent.
+  /** Subnormal numbers can go a bit further than @c min_exponent10, but never
+   * by enough to need another digit.
+   */
+  static constexpr size_t exponent_digits() noexcept
+  {
+    size_t digits{1};
+    for (auto exp{std::numeric_limits<T>::max_exponent10}; exp >= 10;
+         exp /= 10)
+      ++digits;
+    return digits;
   }
 };
 } // namespace pqxx::internal
@@ -353,10 +381,10 @@ template<> struct string_traits<std::string>
     if (value.size() >= std::size_t(end - begin))
       throw conversion_overrun{
         "Could not convert string to string: too long for buffer."};
+    value.copy(begin, value.size());
+    begin[value.size()] = '\0';
     // Include the trailing zero.
-    auto const len = value.size() + 1;
-    value.copy(begin, len);
-    return begin + len;
+    return begin + value.size() + 1;
   }
 
   static zview to_buf(char *begin, char *end, std::string const &value)
@@ -382,9 +410,35 @@ template<> struct nullness<std::string_view> : no_null<std::string_view>
 
 
 /// String traits for `string_view`.
+/** Converting text to a @c string_view does not copy it: the view refers to
+ * the original text, and is valid only for as long as that text is.  When
+ * you convert a field, that means: as long as the result object, or a copy
+ * of it, exists.
+ */
 template<> struct string_traits<std::string_view>
 {
-  // Don't allow conversion to this type; it has nowhere to store its contents.
+  static constexpr std::string_view
+  from_string(std::string_view text) noexcept
+  {
+    return text;
+  }
+
+  static char *into_buf(char *begin, char *end, std::string_view const &value)
+  {
+    if (value.size() >= std::size_t(end - begin))
+      throw conversion_overrun{
+        "Could not store string_view: too long for buffer."};
+    value.copy(begin, value.size());
+    begin[value.size()] = '\0';
+    return begin + value.size() + 1;
+  }
+
+  /// Copy the text into the buffer, to make sure it's zero-terminated.
+  static zview to_buf(char *begin, char *end, std::string_view const &value)
+  {
+    char *const next{into_buf(begin, end, value)};
+    return zview{begin, static_cast<size_t>(next - begin - 1)};
+  }
 
   static constexpr size_t size_buffer(std::string_view const &value) noexcept
   {
@@ -393,14 +447,67 @@ template<> struct string_traits<std::string_view>
 };
 
 
+#if defined(PQXX_HAVE_PMR)
+template<> struct nullness<std::pmr::string> : no_null<std::pmr::string>
+{};
+
+
+/// String traits for @c std::pmr::string.
+/** Converting text to a @c std::pmr::string allocates it from the default
+ * memory resource.  To use a different resource, read into a string which
+ * already has that resource, e.g. using @c field::to().
+ */
+template<> struct string_traits<std::pmr::string>
+{
+  static std::pmr::string from_string(std::string_view text)
+  {
+    return std::pmr::string{text};
+  }
+
+  static char *into_buf(char *begin, char *end, std::pmr::string const &value)
+  {
+    return string_traits<std::string_view>::into_buf(begin, end, value);
+  }
+
+  static zview to_buf(char *begin, char *end, std::pmr::string const &value)
+  {
+    return string_traits<std::string_view>::to_buf(begin, end, value);
+  }
+
+  static size_t size_buffer(std::pmr::string const &value) noexcept
+  {
+    return value.size() + 1;
+  }
+};
+#endif
+
+
 template<> struct nullness<zview> : no_null<zview>
 {};
 
 
 /// String traits for `zview`.
+/** Like the conversion to @c std::string_view, this refers to the original
+ * text instead of copying it.  Convert only text that is zero-terminated,
+ * such as a field's value.
+ */
 template<> struct string_traits<zview>
 {
-  // Don't allow conversion to this type; it has nowhere to store its contents.
+  static constexpr zview from_string(std::string_view text) noexcept
+  {
+    return zview{text};
+  }
+
+  static char *into_buf(char *begin, char *end, zview const &value)
+  {
+    return string_traits<std::string_view>::into_buf(begin, end, value);
+  }
+
+  /// A @c zview is already zero-terminated, so this needs no copy.
+  static constexpr zview to_buf(char *, char *, zview const &value) noexcept
+  {
+    return value;
+  }
 
   static constexpr size_t size_buffer(std::string_view const &value) noexcept
   {
@@ -629,8 +736,9 @@ namespace pqxx
 template<typename T> inline std::string to_string(T const &value)
 {
   if (is_null(value))
-    throw conversion_error{"Attempt to convert null " + type_name<T> +
-                           " to a string."};
+    throw conversion_error{
+      "Attempt to convert null " + std::string{name_type<T>()} +
+      " to a string."};
 
   std::string buf;
   // We can't just reserve() data; modifying the terminating zero leads to
@@ -661,11 +769,14 @@ template<> inline std::string to_string(std::stringstream const &value)
 }
 
 
-template<typename T> inline void into_string(T const &value, std::string &out)
+template<typename T, typename ALLOC>
+inline void into_string(
+  T const &value, std::basic_string<char, std::char_traits<char>, ALLOC> &out)
 {
   if (is_null(value))
-    throw conversion_error{"Attempt to convert null " + type_name<T> +
-                           " to a string."};
+    throw conversion_error{
+      "Attempt to convert null " + std::string{name_type<T>()} +
+      " to a string."};
 
   // We can't just reserve() data; modifying the terminating zero leads to
   // undefined behaviour.
@@ -674,4 +785,16 @@ template<typename T> inline void into_string(T const &value, std::string &out)
     string_traits<T>::into_buf(out.data(), out.data() + out.size(), value)};
   out.resize(static_cast<size_t>(end - out.data() - 1));
 }
+
+
+#if defined(PQXX_HAVE_PMR)
+template<typename T>
+inline std::pmr::string
+to_string(T const &value, std::pmr::memory_resource *resource)
+{
+  std::pmr::string buf{resource};
+  into_string(value, buf);
+  return buf;
+}
+#endif
 } // namespace pqxx
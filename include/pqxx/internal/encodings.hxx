@@ -14,8 +14,11 @@
 #include "pqxx/internal/encoding_group.hxx"
 
 #include <string>
+#include <type_traits>
 #include <string_view>
 
+#include "pqxx/except.hxx"
+
 
 namespace pqxx::internal
 {
@@ -27,6 +30,26 @@ encoding_group enc_group(int /* libpq encoding ID */);
 encoding_group enc_group(std::string_view);
 
 
+/// Can a byte in the ASCII range only ever mean that ASCII character?
+/** This is true for most encodings.  But in some, the second byte of a
+ * multibyte character can look like a tab or a backslash.
+ */
+constexpr bool is_ascii_safe(encoding_group enc) noexcept
+{
+  switch (enc)
+  {
+  case encoding_group::BIG5:
+  case encoding_group::GB18030:
+  case encoding_group::GBK:
+  case encoding_group::JOHAB:
+  case encoding_group::SJIS:
+  case encoding_group::SHIFT_JIS_2004:
+  case encoding_group::UHC: return false;
+  default: return true;
+  }
+}
+
+
 /// Function type: "find the end of the current glyph."
 /** This type of function takes a text buffer, and a location in that buffer,
  * and returns the location one byte past the end of the current glyph.
@@ -42,6 +65,124 @@ using glyph_scanner_func = std::string::size_type(
   std::string::size_type start);
 
 
+/// Glyph scanner for encoding group @c E.
+/** The static member function @c call is a @c glyph_scanner_func.  Where you
+ * know the encoding group at compile time, calling it directly lets the
+ * compiler inline it into your loop.  For @c MONOBYTE and @c UTF8 that
+ * reduces scanning over ASCII text to little more than a byte loop.
+ */
+template<encoding_group E> struct glyph_scanner
+{
+  static std::string::size_type call(
+    char const buffer[], std::string::size_type buffer_len,
+    std::string::size_type start);
+};
+
+
+template<> struct glyph_scanner<encoding_group::MONOBYTE>
+{
+  static constexpr std::string::size_type call(
+    char const /* buffer */[], std::string::size_type buffer_len,
+    std::string::size_type start) noexcept
+  {
+    if (start >= buffer_len)
+      return std::string::npos;
+    else
+      return start + 1;
+  }
+};
+
+
+template<> struct glyph_scanner<encoding_group::UTF8>
+{
+  static std::string::size_type call(
+    char const buffer[], std::string::size_type buffer_len,
+    std::string::size_type start)
+  {
+    if (start >= buffer_len)
+      return std::string::npos;
+    else if (static_cast<unsigned char>(buffer[start]) < 0x80)
+      return start + 1;
+    else
+      return call_multibyte(buffer, buffer_len, start);
+  }
+
+  /// Scan a glyph whose first byte is not ASCII.
+  PQXX_LIBEXPORT static std::string::size_type call_multibyte(
+    char const buffer[], std::string::size_type buffer_len,
+    std::string::size_type start);
+};
+
+
+#define PQXX_DECLARE_GLYPH_SCANNER(ENC)                                       \
+  template<>                                                                  \
+  PQXX_LIBEXPORT std::string::size_type                                       \
+  glyph_scanner<encoding_group::ENC>::call(                                   \
+    char const buffer[], std::string::size_type buffer_len,                   \
+    std::string::size_type start)
+
+PQXX_DECLARE_GLYPH_SCANNER(BIG5);
+PQXX_DECLARE_GLYPH_SCANNER(EUC_CN);
+PQXX_DECLARE_GLYPH_SCANNER(EUC_JP);
+PQXX_DECLARE_GLYPH_SCANNER(EUC_JIS_2004);
+PQXX_DECLARE_GLYPH_SCANNER(EUC_KR);
+PQXX_DECLARE_GLYPH_SCANNER(EUC_TW);
+PQXX_DECLARE_GLYPH_SCANNER(GB18030);
+PQXX_DECLARE_GLYPH_SCANNER(GBK);
+PQXX_DECLARE_GLYPH_SCANNER(JOHAB);
+PQXX_DECLARE_GLYPH_SCANNER(MULE_INTERNAL);
+PQXX_DECLARE_GLYPH_SCANNER(SJIS);
+PQXX_DECLARE_GLYPH_SCANNER(SHIFT_JIS_2004);
+PQXX_DECLARE_GLYPH_SCANNER(UHC);
+
+#undef PQXX_DECLARE_GLYPH_SCANNER
+
+
+/// Call @c func with encoding group @c enc as a compile-time constant.
+/** Passes @c func a @c std::integral_constant for the encoding group.  This
+ * way you pay for the runtime dispatch once, and @c func can run a loop
+ * which is specialised for that one encoding, e.g.:
+ *
+ * @code
+ * with_encoding(enc, [&](auto e) { return scan<decltype(e)::value>(text); });
+ * @endcode
+ *
+ * The compiler instantiates @c func for every encoding group, so each must
+ * return the same type.
+ */
+template<typename CALLABLE>
+inline decltype(auto) with_encoding(encoding_group enc, CALLABLE &&func)
+{
+#define PQXX_CASE_GROUP(ENC)                                                  \
+  case encoding_group::ENC:                                                   \
+    return func(std::integral_constant<encoding_group, encoding_group::ENC>{})
+
+  switch (enc)
+  {
+    PQXX_CASE_GROUP(MONOBYTE);
+    PQXX_CASE_GROUP(BIG5);
+    PQXX_CASE_GROUP(EUC_CN);
+    PQXX_CASE_GROUP(EUC_JP);
+    PQXX_CASE_GROUP(EUC_JIS_2004);
+    PQXX_CASE_GROUP(EUC_KR);
+    PQXX_CASE_GROUP(EUC_TW);
+    PQXX_CASE_GROUP(GB18030);
+    PQXX_CASE_GROUP(GBK);
+    PQXX_CASE_GROUP(JOHAB);
+    PQXX_CASE_GROUP(MULE_INTERNAL);
+    PQXX_CASE_GROUP(SJIS);
+    PQXX_CASE_GROUP(SHIFT_JIS_2004);
+    PQXX_CASE_GROUP(UHC);
+    PQXX_CASE_GROUP(UTF8);
+  }
+  throw usage_error{
+    "Unsupported encoding group code " +
+    std::to_string(static_cast<int>(enc)) + "."};
+
+#undef PQXX_CASE_GROUP
+}
+
+
 /// Look up the glyph scanner function for a given encoding group.
 /** To identify the glyph boundaries in a buffer, call this to obtain the
  * scanner function appropriate for the buffer's encoding.  Then, repeatedly
@@ -51,7 +192,10 @@ PQXX_LIBEXPORT glyph_scanner_func *get_glyph_scanner(encoding_group);
 
 
 /// Find a single-byte "needle" character in a "haystack" text buffer.
-std::string::size_type find_with_encoding(
+/** Throws @c argument_error if the text before the needle is not valid in
+ * the encoding.
+ */
+PQXX_LIBEXPORT std::string::size_type find_with_encoding(
   encoding_group enc, std::string_view haystack, char needle,
   std::string::size_type start = 0);
 
@@ -61,23 +205,41 @@ PQXX_LIBEXPORT std::string::size_type find_with_encoding(
   std::string::size_type start = 0);
 
 
-/// Iterate over the glyphs in a buffer.
+/// Iterate over the glyphs in a buffer, in encoding group @c E.
 /** Scans the glyphs in the buffer, and for each, passes its begin and its
  * one-past-end pointers to @c callback.
  */
-template<typename CALLABLE>
+template<encoding_group E, typename CALLABLE>
 inline void for_glyphs(
-  encoding_group enc, CALLABLE callback, char const buffer[],
-  std::string::size_type buffer_len, std::string::size_type start = 0)
+  CALLABLE callback, char const buffer[], std::string::size_type buffer_len,
+  std::string::size_type start = 0)
 {
-  auto const scan = get_glyph_scanner(enc);
   for (std::string::size_type here = start, next; here < buffer_len;
        here = next)
   {
-    next = scan(buffer, buffer_len, here);
+    next = glyph_scanner<E>::call(buffer, buffer_len, here);
     callback(buffer + here, buffer + next);
   }
 }
+
+
+/// Iterate over the glyphs in a buffer.
+/** Scans the glyphs in the buffer, and for each, passes its begin and its
+ * one-past-end pointers to @c callback.
+ *
+ * Picks the loop for the encoding once, up front, so the glyph scanner and
+ * the callback inline into it.
+ */
+template<typename CALLABLE>
+inline void for_glyphs(
+  encoding_group enc, CALLABLE callback, char const buffer[],
+  std::string::size_type buffer_len, std::string::size_type start = 0)
+{
+  with_encoding(enc, [&](auto e) {
+    for_glyphs<decltype(e)::value, CALLABLE &>(
+      callback, buffer, buffer_len, start);
+  });
+}
 } // namespace pqxx::internal
 
 #include "pqxx/internal/compiler-internal-post.hxx"
@@ -1,3 +1,5 @@
+#include <functional>
+#include <memory>
 #include <string>
 
 #include <pqxx/internal/callgate.hxx>
@@ -6,7 +8,8 @@
 namespace pqxx
 {
 class largeobject;
-}
+class largeobjectaccess;
+} // namespace pqxx
 
 
 namespace pqxx::internal::gate
@@ -14,10 +17,21 @@ namespace pqxx::internal::gate
 class PQXX_PRIVATE connection_largeobject : callgate<connection>
 {
   friend class pqxx::largeobject;
+  friend class pqxx::largeobjectaccess;
 
   connection_largeobject(reference x) : super(x) {}
 
   pq::PGconn *raw_connection() const { return home().raw_connection(); }
+
+  /// Execute @c query for each parameter set, pipelined where possible.
+  void exec_params_bulk(
+    std::shared_ptr<std::string> const &query,
+    std::function<bool(internal::params &)> const &next,
+    std::function<void(result const &)> const &sink,
+    format result_format = format::text)
+  {
+    home().exec_bulk(query, false, next, sink, result_format);
+  }
 };
 
 
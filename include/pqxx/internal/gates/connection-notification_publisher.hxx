@@ -0,0 +1,28 @@
+#include <pqxx/internal/callgate.hxx>
+
+#include <pqxx/connection>
+
+
+namespace pqxx
+{
+class notification_publisher;
+}
+
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE connection_notification_publisher : callgate<connection>
+{
+  friend class pqxx::notification_publisher;
+
+  connection_notification_publisher(reference x) : super(x) {}
+
+  /// Execute @c query for each parameter set, discarding the results.
+  void exec_bulk(
+    std::shared_ptr<std::string> const &query,
+    std::function<bool(internal::params &)> const &next)
+  {
+    home().exec_bulk(query, false, next, [](result const &) {});
+  }
+};
+} // namespace pqxx::internal::gate
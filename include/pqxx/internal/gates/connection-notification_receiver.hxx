@@ -6,6 +6,7 @@
 namespace pqxx
 {
 class notification_receiver;
+class receiver_batch;
 }
 
 
@@ -14,6 +15,7 @@ namespace pqxx::internal::gate
 class PQXX_PRIVATE connection_notification_receiver : callgate<connection>
 {
   friend class pqxx::notification_receiver;
+  friend class pqxx::receiver_batch;
 
   connection_notification_receiver(reference x) : super(x) {}
 
@@ -25,5 +27,7 @@ class PQXX_PRIVATE connection_notification_receiver : callgate<connection>
   {
     home().remove_receiver(receiver);
   }
+  void begin_listen_batch() { home().begin_listen_batch(); }
+  void end_listen_batch() { home().end_listen_batch(); }
 };
 } // namespace pqxx::internal::gate
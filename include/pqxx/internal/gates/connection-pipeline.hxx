@@ -10,12 +10,36 @@ class PQXX_PRIVATE connection_pipeline : callgate<connection>
   connection_pipeline(reference x) : super(x) {}
 
   void start_exec(char const query[]) { home().start_exec(query); }
+  void start_exec_params(char const query[], internal::params const &args)
+  {
+    home().start_exec_params(query, args);
+  }
+  void
+  start_exec_prepared(char const statement[], internal::params const &args)
+  {
+    home().start_exec_prepared(statement, args);
+  }
   pqxx::internal::pq::PGresult *get_result() { return home().get_result(); }
   void cancel_query() { home().cancel_query(); }
 
   bool consume_input() noexcept { return home().consume_input(); }
   bool is_busy() const noexcept { return home().is_busy(); }
 
-  int encoding_id() { return home().encoding_id(); }
+  void enter_pipeline_mode() { home().enter_pipeline_mode(); }
+  void exit_pipeline_mode() { home().exit_pipeline_mode(); }
+  void pipeline_sync() { home().pipeline_sync(); }
+  void set_nonblocking(bool enable) { home().set_nonblocking(enable); }
+  void reset_session() { home().reset_session(); }
+
+  encoding_group enc_group() { return home().enc_group(); }
+
+  std::chrono::steady_clock::time_point query_start() const noexcept
+  {
+    return home().query_start();
+  }
+  void report_query(query_stats const &stats) noexcept
+  {
+    home().report_query(stats);
+  }
 };
 } // namespace pqxx::internal::gate
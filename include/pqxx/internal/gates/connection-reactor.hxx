@@ -0,0 +1,32 @@
+#include "pqxx/internal/libpq-forward.hxx"
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE connection_reactor : callgate<connection>
+{
+  friend class pqxx::reactor;
+
+  connection_reactor(reference x) : super(x) {}
+
+  void start_exec(char const query[]) { home().start_exec(query); }
+  void start_exec_params(char const query[], internal::params const &args)
+  {
+    home().start_exec_params(query, args);
+  }
+  void
+  start_exec_prepared(char const statement[], internal::params const &args)
+  {
+    home().start_exec_prepared(statement, args);
+  }
+  pqxx::internal::pq::PGresult *get_result() { return home().get_result(); }
+
+  bool consume_input() noexcept { return home().consume_input(); }
+  bool is_busy() const noexcept { return home().is_busy(); }
+
+  bool start_cancel() { return home().start_cancel(); }
+  bool poll_cancel() { return home().poll_cancel(); }
+
+  encoding_group enc_group() { return home().enc_group(); }
+};
+} // namespace pqxx::internal::gate
@@ -0,0 +1,38 @@
+#include <pqxx/internal/callgate.hxx>
+
+#include <pqxx/connection>
+
+
+namespace pqxx
+{
+class replication_stream;
+}
+
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE connection_replication_stream : callgate<connection>
+{
+  friend class pqxx::replication_stream;
+
+  connection_replication_stream(reference x) : super(x) {}
+
+  result exec(std::shared_ptr<std::string> const &query)
+  {
+    return home().exec(query);
+  }
+  std::pair<internal::pq_buffer, std::size_t> try_read_copy_line(bool &done)
+  {
+    return home().try_read_copy_line(done);
+  }
+  void send_copy_message(std::string_view message)
+  {
+    home().send_copy_message(message);
+  }
+  void end_copy_both(bool server_done) { home().end_copy_both(server_done); }
+  void wait_read(long seconds, long microseconds) const
+  {
+    home().wait_read(seconds, microseconds);
+  }
+};
+} // namespace pqxx::internal::gate
@@ -15,5 +15,24 @@ class PQXX_PRIVATE connection_sql_cursor : callgate<connection>
   connection_sql_cursor(reference x) : super(x) {}
 
   result exec(char const query[]) { return home().exec(query); }
+  void start_exec(char const query[]) { home().start_exec(query); }
+  result receive_result(std::shared_ptr<std::string> const &query)
+  {
+    return home().receive_result(query);
+  }
+  std::vector<result>
+  receive_results(std::shared_ptr<std::string> const &query)
+  {
+    return home().receive_results(query);
+  }
+
+  bool defer_close(std::string command)
+  {
+    return home().defer_close(std::move(command));
+  }
+  transaction_base const *transaction() const noexcept
+  {
+    return home().m_trans.get();
+  }
 };
 } // namespace pqxx::internal::gate
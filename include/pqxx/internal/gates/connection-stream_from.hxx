@@ -1,10 +1,17 @@
 #include <pqxx/internal/callgate.hxx>
 
+namespace pqxx::internal
+{
+class copy_reader;
+} // namespace pqxx::internal
+
+
 namespace pqxx::internal::gate
 {
 class PQXX_PRIVATE connection_stream_from : callgate<connection>
 {
   friend class pqxx::stream_from;
+  friend class pqxx::internal::copy_reader;
 
   connection_stream_from(reference x) : super{x} {}
 
@@ -12,5 +19,19 @@ class PQXX_PRIVATE connection_stream_from : callgate<connection>
   {
     return home().read_copy_line(line);
   }
+  std::pair<internal::pq_buffer, std::size_t> read_copy_line()
+  {
+    return home().read_copy_line();
+  }
+  std::pair<internal::pq_buffer, std::size_t> try_read_copy_line(bool &done)
+  {
+    return home().try_read_copy_line(done);
+  }
+  void end_copy_read() { home().end_copy_read(); }
+  bool try_end_copy_read() { return home().try_end_copy_read(); }
+  std::chrono::steady_clock::duration copy_blocked() const noexcept
+  {
+    return home().copy_blocked();
+  }
 };
 } // namespace pqxx::internal::gate
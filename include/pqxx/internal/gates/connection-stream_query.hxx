@@ -0,0 +1,18 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE connection_stream_query : callgate<connection>
+{
+  friend class pqxx::stream_query;
+
+  connection_stream_query(reference x) : super(x) {}
+
+  void start_exec(char const query[]) { home().start_exec(query); }
+  void set_single_row_mode() { home().set_single_row_mode(); }
+  void set_chunked_rows_mode(int rows) { home().set_chunked_rows_mode(rows); }
+  pqxx::internal::pq::PGresult *get_result() { return home().get_result(); }
+
+  encoding_group enc_group() { return home().enc_group(); }
+};
+} // namespace pqxx::internal::gate
@@ -8,7 +8,14 @@ class PQXX_PRIVATE connection_stream_to : callgate<connection>
 
   connection_stream_to(reference x) : super(x) {}
 
-  void write_copy_line(std::string_view line) { home().write_copy_line(line); }
+  void write_copy_data(std::string_view data) { home().write_copy_data(data); }
   void end_copy_write() { home().end_copy_write(); }
+  void set_nonblocking(bool enable) { home().set_nonblocking(enable); }
+  bool flush_output() { return home().flush_output(); }
+  void drain_copy_output() { home().drain_copy_output(); }
+  std::chrono::steady_clock::duration copy_blocked() const noexcept
+  {
+    return home().copy_blocked();
+  }
 };
 } // namespace pqxx::internal::gate
@@ -17,6 +17,10 @@ class PQXX_PRIVATE connection_transaction : callgate<connection>
   {
     return home().exec(query);
   }
+  std::vector<result> exec_all(std::string_view script)
+  {
+    return home().exec_all(script);
+  }
 
   void register_transaction(transaction_base *t)
   {
@@ -26,6 +30,29 @@ class PQXX_PRIVATE connection_transaction : callgate<connection>
   {
     home().unregister_transaction(t);
   }
+  void end_trace_span(bool committed) noexcept
+  {
+    home().end_trace_span(committed);
+  }
+  void count_stats(bool on) noexcept { home().m_counting = on; }
+
+  void defer_begin(char const command[]) noexcept
+  {
+    home().defer_begin(command);
+  }
+  bool drop_deferred_begin() noexcept { return home().drop_deferred_begin(); }
+  void defer_savepoint(std::string command)
+  {
+    home().defer_savepoint(std::move(command));
+  }
+  bool drop_deferred_savepoint(std::string_view command) noexcept
+  {
+    return home().drop_deferred_savepoint(command);
+  }
+  result exec_commit(std::shared_ptr<std::string> const &query)
+  {
+    return home().exec_bundled(query, nullptr, false, format::text, true);
+  }
 
   bool read_copy_line(std::string &line)
   {
@@ -34,14 +61,42 @@ class PQXX_PRIVATE connection_transaction : callgate<connection>
   void write_copy_line(std::string_view line) { home().write_copy_line(line); }
   void end_copy_write() { home().end_copy_write(); }
 
-  result exec_prepared(zview statement, internal::params const &args)
+  result exec_prepared(
+    zview statement, internal::params const &args, format result_format)
+  {
+    return home().exec_prepared(statement, args, result_format);
+  }
+
+  result exec_prepared(
+    std::shared_ptr<std::string> const &statement,
+    internal::params const &args, format result_format)
+  {
+    return home().exec_prepared(statement, args, result_format);
+  }
+
+  result exec_prepared_mixed(zview statement, internal::params const &args)
+  {
+    return home().exec_prepared_mixed(statement, args);
+  }
+
+  result exec_params(
+    std::string const &query, internal::params const &args,
+    format result_format)
+  {
+    return home().exec_params(query, args, result_format);
+  }
+
+  std::vector<result_size_type> exec_prepared_bulk(
+    zview statement, std::function<bool(internal::params &)> const &next)
   {
-    return home().exec_prepared(statement, args);
+    return home().exec_prepared_bulk(statement, next);
   }
 
-  result exec_params(std::string const &query, internal::params const &args)
+  std::vector<result_size_type> exec_params_bulk(
+    std::shared_ptr<std::string> const &query,
+    std::function<bool(internal::params &)> const &next)
   {
-    return home().exec_params(query, args);
+    return home().exec_params_bulk(query, next);
   }
 };
 } // namespace pqxx::internal::gate
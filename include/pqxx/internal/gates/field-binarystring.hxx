@@ -0,0 +1,17 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE field_binarystring : callgate<field const>
+{
+  friend class pqxx::binarystring;
+
+  field_binarystring(reference x) : super(x) {}
+
+  std::shared_ptr<internal::pq::PGresult const> const &
+  result_data() const noexcept
+  {
+    return home().result_data();
+  }
+};
+} // namespace pqxx::internal::gate
@@ -10,5 +10,6 @@ class PQXX_PRIVATE result_connection : callgate<result const>
 
   operator bool() const { return bool(home()); }
   bool operator!() const { return not home(); }
+  bool starts_copy() const noexcept { return home().starts_copy(); }
 };
 } // namespace pqxx::internal::gate
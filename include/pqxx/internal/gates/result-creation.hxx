@@ -6,6 +6,8 @@ class PQXX_PRIVATE result_creation : callgate<result const>
 {
   friend class pqxx::connection;
   friend class pqxx::pipeline;
+  friend class pqxx::reactor;
+  friend class pqxx::stream_query;
 
   result_creation(reference x) : super(x) {}
 
@@ -17,5 +19,10 @@ class PQXX_PRIVATE result_creation : callgate<result const>
   }
 
   void check_status() const { return home().check_status(); }
+
+  void read_as_text(std::vector<bool> columns) const
+  {
+    home().read_as_text(std::move(columns));
+  }
 };
 } // namespace pqxx::internal::gate
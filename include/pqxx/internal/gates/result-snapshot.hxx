@@ -0,0 +1,13 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE result_snapshot : callgate<result const>
+{
+  friend class pqxx::result_snapshot;
+
+  result_snapshot(reference x) : super(x) {}
+
+  encoding_group encoding() const noexcept { return home().m_encoding; }
+};
+} // namespace pqxx::internal::gate
@@ -9,5 +9,6 @@ class PQXX_PRIVATE result_sql_cursor : callgate<result const>
   result_sql_cursor(reference x) : super(x) {}
 
   char const *cmd_status() const noexcept { return home().cmd_status(); }
+  result empty_copy() const { return home().empty_copy(); }
 };
 } // namespace pqxx::internal::gate
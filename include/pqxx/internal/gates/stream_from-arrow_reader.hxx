@@ -0,0 +1,25 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE stream_from_arrow_reader : callgate<stream_from>
+{
+  friend class pqxx::arrow_reader;
+
+  stream_from_arrow_reader(reference x) : super{x} {}
+
+  /// Read the next row.  Returns @c false at the end of the data.
+  bool get_binary_row() { return home().get_binary_row(); }
+  /// Number of fields in the current row.
+  std::size_t binary_fields() const noexcept { return home().m_binary_fields; }
+  /// Offset of the current row's first field.
+  std::string::size_type binary_row_start() const noexcept
+  {
+    return home().m_binary_row_start;
+  }
+  bool next_binary_field(std::string::size_type &here, std::string_view &data)
+  {
+    return home().next_binary_field(here, data);
+  }
+};
+} // namespace pqxx::internal::gate
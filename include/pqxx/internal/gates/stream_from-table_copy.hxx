@@ -0,0 +1,16 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE stream_from_table_copy : callgate<stream_from>
+{
+  friend class pqxx::table_copy;
+
+  stream_from_table_copy(reference x) : super{x} {}
+
+  /// Read the next row's raw data.  Returns @c false at the end.
+  bool get_raw_row(std::string_view &row) { return home().get_raw_row(row); }
+  /// The connection on which the stream reads.
+  connection &conn() const noexcept { return home().m_trans.conn(); }
+};
+} // namespace pqxx::internal::gate
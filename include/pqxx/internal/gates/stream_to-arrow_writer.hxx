@@ -0,0 +1,16 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE stream_to_arrow_writer : callgate<stream_to>
+{
+  friend class pqxx::arrow_writer;
+
+  stream_to_arrow_writer(reference x) : super{x} {}
+
+  /// The stream's buffer of data waiting to be sent.
+  std::string &buffer() noexcept { return home().m_buffer; }
+  /// Send the buffered data, if the buffer is full enough.
+  void flush_if_full() { home().flush_if_full(); }
+};
+} // namespace pqxx::internal::gate
@@ -0,0 +1,14 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE stream_to_csv_loader : callgate<stream_to>
+{
+  friend class pqxx::csv_loader;
+
+  stream_to_csv_loader(reference x) : super{x} {}
+
+  /// Send raw COPY data to the server right away, without buffering it.
+  void send_raw_data(std::string_view data) { home().send_raw_data(data); }
+};
+} // namespace pqxx::internal::gate
@@ -0,0 +1,16 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE stream_to_table_copy : callgate<stream_to>
+{
+  friend class pqxx::table_copy;
+
+  stream_to_table_copy(reference x) : super{x} {}
+
+  /// Send raw COPY data to the server right away, without buffering it.
+  void send_raw_data(std::string_view data) { home().send_raw_data(data); }
+  /// The connection on which the stream writes.
+  connection &conn() const noexcept { return home().m_trans.conn(); }
+};
+} // namespace pqxx::internal::gate
@@ -0,0 +1,16 @@
+#include <pqxx/internal/callgate.hxx>
+
+namespace pqxx::internal::gate
+{
+class PQXX_PRIVATE transaction_connection : callgate<transaction_base>
+{
+  friend class pqxx::connection;
+
+  transaction_connection(reference x) : super(x) {}
+
+  void count_query(query_stats const &stats) noexcept
+  {
+    home().count_query(stats);
+  }
+};
+} // namespace pqxx::internal::gate
@@ -13,6 +13,8 @@ extern "C"
   struct pg_conn;
   struct pg_result;
   struct pgNotify;
+  struct pg_cancel;
+  struct pg_cancel_conn;
 }
 
 /// Forward declarations of libpq types as needed in libpqxx headers.
@@ -21,6 +23,8 @@ namespace pqxx::internal::pq
 using PGconn = pg_conn;
 using PGresult = pg_result;
 using PGnotify = pgNotify;
+using PGcancel = pg_cancel;
+using PGcancelConn = pg_cancel_conn;
 using PQnoticeProcessor = void (*)(void *, char const *);
 } // namespace pqxx::internal::pq
 
@@ -0,0 +1,48 @@
+/** Read-only access to a whole file's contents.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_MAPPED_FILE
+#define PQXX_H_MAPPED_FILE
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+namespace pqxx::internal
+{
+/// A file's contents, mapped into memory for sequential reading.
+/** Where the system has no @c mmap(), this reads the whole file into memory
+ * instead.  Either way, the data stays valid for the object's lifetime.
+ */
+class PQXX_PRIVATE mapped_file
+{
+public:
+  /// Open and map @c path.  Throws @c failure if that doesn't work.
+  explicit mapped_file(std::string const &path);
+  ~mapped_file() noexcept;
+
+  mapped_file(mapped_file const &) = delete;
+  mapped_file &operator=(mapped_file const &) = delete;
+
+  [[nodiscard]] std::string_view data() const noexcept { return m_data; }
+
+private:
+  std::string_view m_data;
+  /// The mapping, if we have one.
+  void *m_map = nullptr;
+  /// The file's contents, if we could not map it.
+  std::string m_contents;
+};
+} // namespace pqxx::internal
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
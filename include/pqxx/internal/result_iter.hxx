@@ -0,0 +1,194 @@
+/** Result iteration as tuples of typed values, and columnar conversion.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY.  Other headers include it for you.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_RESULT_ITER
+#define PQXX_H_RESULT_ITER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <tuple>
+#include <utility>
+
+#include "pqxx/field.hxx"
+#include "pqxx/internal/column_batch.hxx"
+#include "pqxx/result.hxx"
+
+
+namespace pqxx::internal
+{
+/// Range of a result's rows, converted to tuples.  See @c result::iter().
+/** Works out how to read each column when you create it, so that converting
+ * each row is nothing more than a null check and a conversion per field.
+ */
+template<typename... TYPE> class result_iteration
+{
+public:
+  using value_type = std::tuple<TYPE...>;
+
+  /// Input iterator over the rows, as tuples.
+  class iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::tuple<TYPE...>;
+    using pointer = void;
+    using reference = value_type;
+    using difference_type = result_difference_type;
+
+    iterator(result_iteration const &home, result_size_type index) noexcept :
+            m_home{&home},
+            m_index{index}
+    {}
+
+    [[nodiscard]] value_type operator*() const
+    {
+      return m_home->read_row(m_index);
+    }
+
+    iterator &operator++() noexcept
+    {
+      ++m_index;
+      return *this;
+    }
+    iterator operator++(int) noexcept
+    {
+      auto const old{*this};
+      ++m_index;
+      return old;
+    }
+
+    [[nodiscard]] bool operator==(iterator const &rhs) const noexcept
+    {
+      return m_index == rhs.m_index;
+    }
+    [[nodiscard]] bool operator!=(iterator const &rhs) const noexcept
+    {
+      return m_index != rhs.m_index;
+    }
+
+  private:
+    result_iteration const *m_home;
+    result_size_type m_index;
+  };
+
+  explicit result_iteration(result const &home) : m_home{&home}
+  {
+    if (home.columns() != sizeof...(TYPE))
+      throw usage_error{
+        "Tried to extract " + to_string(sizeof...(TYPE)) +
+        " field(s) from a result with " + to_string(home.columns()) +
+        " column(s)."};
+    for (std::size_t i{0}; i < sizeof...(TYPE); ++i)
+      m_binary[i] = (home.column_format(static_cast<row_size_type>(i)) ==
+                     format::binary);
+  }
+
+  [[nodiscard]] iterator begin() const noexcept { return {*this, 0}; }
+  [[nodiscard]] iterator end() const noexcept
+  {
+    return {*this, m_home->size()};
+  }
+
+  /// Convert row number @c index.
+  [[nodiscard]] value_type read_row(result_size_type index) const
+  {
+    return read_row(index, std::index_sequence_for<TYPE...>{});
+  }
+
+private:
+  template<std::size_t... INDEX>
+  value_type
+  read_row(result_size_type index, std::index_sequence<INDEX...>) const
+  {
+    return value_type{read_cell<TYPE>(
+      field_ref{*m_home, index, static_cast<row_size_type>(INDEX)},
+      m_binary[INDEX])...};
+  }
+
+  result const *m_home;
+  /// Is each column in binary format?
+  std::array<bool, sizeof...(TYPE)> m_binary{};
+};
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+template<typename... TYPE>
+inline internal::result_iteration<TYPE...> result::iter() const
+{
+  return internal::result_iteration<TYPE...>{*this};
+}
+
+
+template<typename T>
+inline void result::column_as(row_size_type col, column_batch<T> &out) const
+{
+  if ((col < 0) or (col >= columns()))
+    throw range_error{"Invalid column number: " + to_string(col) + "."};
+  bool const binary{column_format(col) == format::binary};
+  auto const rows{size()};
+  out.clear();
+  out.values.reserve(static_cast<std::size_t>(rows));
+  out.nulls.reserve(static_cast<std::size_t>(rows));
+  for (result_size_type row{0}; row < rows; ++row)
+  {
+    field_ref const f{*this, row, col};
+    bool const null{f.is_null()};
+    if (not null)
+      out.values.push_back(internal::read_value<T>(f, binary));
+    else if constexpr (nullness<T>::has_null)
+      out.values.push_back(nullness<T>::null());
+    else
+      out.values.emplace_back();
+    out.nulls.push_back(null);
+  }
+}
+
+
+template<typename T>
+inline void result::column_as(
+  row_size_type col, T *values, std::uint8_t *validity) const
+{
+  if ((col < 0) or (col >= columns()))
+    throw range_error{"Invalid column number: " + to_string(col) + "."};
+  bool const binary{column_format(col) == format::binary};
+  auto const rows{size()};
+  // With a bitmap to write anyway, we can find the nulls in one quick pass.
+  if (validity != nullptr)
+    validity_bitmap(col, validity);
+  for (result_size_type row{0}; row < rows; ++row)
+  {
+    field_ref const f{*this, row, col};
+    bool const valid{
+      (validity == nullptr) ? not f.is_null() :
+                              ((validity[row / 8] >> (row % 8)) & 1u) != 0};
+    if (valid)
+    {
+      values[row] = internal::read_value<T>(f, binary);
+    }
+    else if constexpr (nullness<T>::has_null)
+    {
+      values[row] = nullness<T>::null();
+    }
+    else
+    {
+      values[row] = T{};
+    }
+  }
+}
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,77 @@
+/** Ring buffer of slow queries, for a connection's slow query log.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_SLOW_QUERY_LOG
+#define PQXX_H_SLOW_QUERY_LOG
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+
+
+namespace pqxx::internal
+{
+/// The most recent slow queries on a connection.
+/** Once the buffer is full, each new entry overwrites the oldest one,
+ * re-using its strings.
+ */
+class PQXX_PRIVATE slow_query_log
+{
+public:
+  explicit slow_query_log(slow_query_config config);
+  ~slow_query_log() noexcept;
+
+  slow_query_log(slow_query_log const &) = delete;
+  slow_query_log &operator=(slow_query_log const &) = delete;
+
+  [[nodiscard]] std::chrono::steady_clock::duration
+  threshold() const noexcept
+  {
+    return m_config.threshold;
+  }
+
+  /// Log a slow query.
+  /** @param stats What the connection reports about the query.
+   * @param args The query's parameters, if any.
+   * @param definition The SQL to @c EXPLAIN, if the query gets sampled.  For
+   *     a prepared statement, that's its definition, if known.  Empty means
+   *     we can't explain this one.
+   * @param home The connection that ran the query, for its parameters.
+   */
+  void record(
+    query_stats const &stats, params const *args, std::string_view definition,
+    connection const &home);
+
+  /// The logged queries, oldest first.
+  [[nodiscard]] std::vector<slow_query> entries() const;
+
+private:
+  /// Run @c EXPLAIN on the side connection, and put the plan in @c entry.
+  void explain(
+    slow_query &entry, params const *args, std::string_view definition,
+    connection const &home);
+
+  slow_query_config m_config;
+  std::vector<slow_query> m_ring;
+  /// Where the next entry goes, once @c m_ring is full.
+  std::size_t m_next = 0;
+  /// Slow queries seen so far, for sampling.
+  std::size_t m_seen = 0;
+  /// Side connection for running @c EXPLAIN, once we need it.
+  std::unique_ptr<connection> m_side;
+};
+} // namespace pqxx::internal
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
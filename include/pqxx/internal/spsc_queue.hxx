@@ -0,0 +1,152 @@
+/** Bounded single-producer, single-consumer queue.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_SPSC_QUEUE
+#define PQXX_H_SPSC_QUEUE
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace pqxx::internal
+{
+/// Lock-free bounded queue, for one producer thread and one consumer thread.
+/** A ring buffer of pre-allocated slots.  The producer only ever writes the
+ * tail, and the consumer only ever writes the head, so neither needs a lock.
+ *
+ * Besides the non-blocking @c try_push() and @c try_pop(), there are
+ * @c push() and @c pop(), which spin briefly and then sleep until the other
+ * side makes progress.  Those take a "stop" predicate, so that a waiting
+ * thread can give up.  Whoever changes what that predicate looks at must
+ * call @c wake() afterwards, so sleeping threads notice.
+ *
+ * The element type must be default-constructible and move-assignable.
+ */
+template<typename T> class spsc_queue
+{
+public:
+  explicit spsc_queue(std::size_t capacity) : m_slots(capacity + 1) {}
+
+  spsc_queue(spsc_queue const &) = delete;
+  spsc_queue &operator=(spsc_queue const &) = delete;
+
+  /// Append @c value, if there is room.  Only move from it if successful.
+  /** Call this only from the producer thread.
+   */
+  bool try_push(T &value)
+  {
+    auto const tail{m_tail.load(std::memory_order_relaxed)};
+    auto const next{advance(tail)};
+    if (next == m_head.load(std::memory_order_acquire))
+      return false;
+    m_slots[tail] = std::move(value);
+    m_tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// Move the oldest element into @c out, if there is one.
+  /** Call this only from the consumer thread.
+   */
+  bool try_pop(T &out)
+  {
+    auto const head{m_head.load(std::memory_order_relaxed)};
+    if (head == m_tail.load(std::memory_order_acquire))
+      return false;
+    out = std::move(m_slots[head]);
+    m_head.store(advance(head), std::memory_order_release);
+    return true;
+  }
+
+  /// Append @c value, waiting for room.  Only move from it if successful.
+  /** Returns false, without appending, if the queue is full and @c stop()
+   * returns true.  Call this only from the producer thread.
+   */
+  template<typename STOP> bool push(T &value, STOP const &stop)
+  {
+    return wait_until([this, &value] { return try_push(value); }, stop);
+  }
+
+  /// Move the oldest element into @c out, waiting for one if needed.
+  /** Returns false if the queue is empty and @c stop() returns true.  Call
+   * this only from the consumer thread.
+   */
+  template<typename STOP> bool pop(T &out, STOP const &stop)
+  {
+    return wait_until([this, &out] { return try_pop(out); }, stop);
+  }
+
+  /// Wake any thread that is waiting in @c push() or @c pop().
+  void wake()
+  {
+    std::lock_guard const lock{m_mutex};
+    m_wake.notify_all();
+  }
+
+private:
+  /// How often @c push() and @c pop() retry before they go to sleep.
+  static constexpr int spins{64};
+
+  /// Retry @c attempt until it succeeds, or @c stop says to give up.
+  template<typename ATTEMPT, typename STOP>
+  bool wait_until(ATTEMPT const &attempt, STOP const &stop)
+  {
+    bool done{false};
+    for (int i{0}; i < spins and not done; ++i)
+    {
+      done = attempt();
+      if (not done and stop())
+        return false;
+    }
+    if (not done)
+    {
+      std::unique_lock lock{m_mutex};
+      m_waiters.fetch_add(1);
+      // Make sure the other side sees us waiting, or we see its progress.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      for (;;)
+      {
+        done = attempt();
+        if (done or stop())
+          break;
+        m_wake.wait(lock);
+      }
+      m_waiters.fetch_sub(1);
+    }
+    if (done)
+    {
+      // The other side may be asleep, waiting for what we just did.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_waiters.load() > 0)
+        wake();
+    }
+    return done;
+  }
+
+  std::size_t advance(std::size_t index) const noexcept
+  {
+    return (index + 1 == m_slots.size()) ? 0 : index + 1;
+  }
+
+  std::vector<T> m_slots;
+  // Keep the two ends on separate cache lines, so the threads don't fight
+  // over them.
+  alignas(64) std::atomic<std::size_t> m_head{0};
+  alignas(64) std::atomic<std::size_t> m_tail{0};
+  /// Number of threads asleep in @c push() or @c pop().
+  std::atomic<int> m_waiters{0};
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+};
+} // namespace pqxx::internal
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
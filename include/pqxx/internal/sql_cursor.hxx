@@ -25,6 +25,13 @@ namespace pqxx::internal
  * does not refer to a row.  There is a similar non-row position at the end of
  * the result set.
  *
+ * A cursor that is not @c WITH @c HOLD does not go out to the server right
+ * away.  Its @c DECLARE goes out along with its first @c FETCH or @c MOVE,
+ * in a single round trip.  So the query starts executing at that point, and
+ * any error in it shows up there.  When the cursor closes, its @c CLOSE
+ * waits for the transaction's next statement, or for the transaction's end,
+ * which closes the cursor anyway.
+ *
  * Don't use this at home.  You deserve better.  Use the stateles_cursor
  * instead.
  */
@@ -48,6 +55,23 @@ public:
     difference_type d = 0;
     return fetch(rows, d);
   }
+  /// Send a FETCH to the server, but don't wait for its result.
+  /** Until you call @c finish_fetch(), the connection can't do anything else.
+   */
+  void start_fetch(difference_type rows);
+  /// Receive the rows which @c start_fetch() requested.
+  /** Pass the same number of @c rows.
+   */
+  result finish_fetch(difference_type rows, difference_type &displacement);
+
+  /// Fetch several ranges of rows, in a single round trip.
+  /** Each range is a number of rows before the range (so the range starts at
+   * row number @c first, counting from zero), and a number of rows to fetch.
+   * Returns one result per range.
+   */
+  std::vector<result> fetch_ranges(
+    std::vector<std::pair<difference_type, difference_type>> const &ranges);
+
   difference_type move(difference_type rows, difference_type &displacement);
   difference_type move(difference_type rows)
   {
@@ -74,19 +98,31 @@ public:
   difference_type endpos() const noexcept { return m_endpos; }
 
   /// Return zero-row result for this cursor
-  result const &empty_result() const noexcept { return m_empty_result; }
+  /** If the cursor has not gone out to the server yet, this declares it.
+   */
+  result const &empty_result();
 
   void close() noexcept;
 
 private:
   difference_type adjust(difference_type hoped, difference_type actual);
   static std::string stridestring(difference_type);
-  /// Initialize cached empty result.  Call only at beginning or end!
-  void init_empty_result(transaction_base &);
+  /// Compose a FETCH command.
+  std::string fetch_query(difference_type rows) const;
+  /// Execute @c query, preceded by the @c DECLARE if that's still pending.
+  result exec(std::string query);
+  /// Send the @c DECLARE if it's still pending, with a @c FETCH of no rows.
+  void declare();
 
   /// Connection in which this cursor lives.
   connection &m_home;
 
+  /// The transaction which created this cursor.
+  transaction_base const *m_trans;
+
+  /// The @c DECLARE command, if it hasn't gone out yet.
+  std::string m_declare;
+
   /// Zero-row result from this cursor (or plain empty one if cursor is
   /// adopted)
   result m_empty_result;
@@ -99,6 +135,9 @@ private:
   /// Will this cursor object destroy its SQL cursor when it dies?
   cursor_base::ownership_policy m_ownership;
 
+  /// Is this a cursor @c WITH @c HOLD?  (If adopted, we don't know.)
+  bool m_hold;
+
   /// At starting position (-1), somewhere in the middle (0), or past end (1)
   int m_at_end;
 
@@ -110,6 +149,54 @@ private:
 };
 
 
+/// Cache of fixed-size blocks of rows, for a @c stateless_cursor.
+/** Keeps the most recently used blocks.  Block @c n holds rows
+ * <tt>n * block_rows</tt> up to <tt>(n + 1) * block_rows</tt>.
+ */
+class PQXX_LIBEXPORT stateless_cursor_cache
+{
+public:
+  using difference_type = result::difference_type;
+
+  stateless_cursor_cache(difference_type block_rows, std::size_t max_blocks);
+
+  /// Retrieve rows from @c begin_pos to @c end_pos, using the cache.
+  /** Works just like @c stateless_cursor_retrieve().  If the range is exactly
+   * one block, ascending, this serves it from the cache, or fetches it into
+   * the cache along with the next block in the scrolling direction.  Other
+   * ranges go to the server.
+   */
+  result retrieve(
+    sql_cursor &, difference_type size, difference_type begin_pos,
+    difference_type end_pos);
+
+  [[nodiscard]] difference_type block_rows() const noexcept
+  {
+    return m_block_rows;
+  }
+
+  /// Number of blocks currently in the cache.
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    return std::size(m_blocks);
+  }
+
+private:
+  /// Look up a block, and make it the most recently used one.
+  result const *find(difference_type block) noexcept;
+
+  /// Add a block, evicting the least recently used if needed.
+  void store(difference_type block, result const &);
+
+  difference_type m_block_rows;
+  std::size_t m_max_blocks;
+  /// Cached blocks, most recently used first.
+  std::list<std::pair<difference_type, result>> m_blocks;
+  /// The last block we retrieved, to tell which way the caller scrolls.
+  difference_type m_last_block = -1;
+};
+
+
 PQXX_LIBEXPORT result_size_type obtain_stateless_cursor_size(sql_cursor &);
 PQXX_LIBEXPORT result stateless_cursor_retrieve(
   sql_cursor &, result::difference_type size,
@@ -16,12 +16,24 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if __has_include(<span>)
+#  include <span>
+#endif
+
+#include "pqxx/binary_traits"
 #include "pqxx/binarystring"
 #include "pqxx/strconv"
 #include "pqxx/util"
@@ -106,6 +118,56 @@ private:
 };
 
 
+/// Wrapper: pass a statement parameter in binary format.
+/** Holds a reference to the value, so don't keep it around.
+ */
+template<typename T> struct binary_param
+{
+  static_assert(
+    pqxx::has_binary_output<T>,
+    "This type has no binary_traits for writing, so it can't be a binary "
+    "parameter.");
+
+  T const &value;
+};
+
+
+/// Is @c T a @c binary_param?
+template<typename T> inline constexpr bool is_binary_param{false};
+
+template<typename T>
+inline constexpr bool is_binary_param<binary_param<T>>{true};
+
+
+/// Is @c T a type of raw binary data that a parameter can point to?
+/** Parameters of these types go to the server in binary, straight from the
+ * caller's memory, without being copied.
+ */
+template<typename T> inline constexpr bool is_raw_bytes{false};
+
+template<>
+inline constexpr bool is_raw_bytes<std::vector<std::byte>>{true};
+template<>
+inline constexpr bool is_raw_bytes<std::vector<std::uint8_t>>{true};
+template<typename TRAITS>
+inline constexpr bool is_raw_bytes<std::basic_string_view<std::byte, TRAITS>>{
+  true};
+
+#if defined(__cpp_lib_span)
+template<std::size_t EXTENT>
+inline constexpr bool is_raw_bytes<std::span<std::byte const, EXTENT>>{true};
+template<std::size_t EXTENT>
+inline constexpr bool is_raw_bytes<std::span<std::byte, EXTENT>>{true};
+#endif
+
+
+/// Is @c T a @c dynamic_params?
+template<typename T> inline constexpr bool is_dynamic_params{false};
+
+template<typename IT, typename ACCESSOR>
+inline constexpr bool is_dynamic_params<dynamic_params<IT, ACCESSOR>>{true};
+
+
 class PQXX_LIBEXPORT statement_parameters
 {
 public:
@@ -140,76 +202,423 @@ private:
 };
 
 
+/// Growable array of trivial values, which keeps small sizes inline.
+/** Holds up to @c N elements without allocating any memory on the heap.
+ * Beyond that it works much like a @c std::vector, except it does not
+ * initialise the elements which @c resize() adds.
+ *
+ * Where the standard library has polymorphic memory resources, you can make
+ * the buffer allocate from a memory resource of your choice.
+ */
+template<typename T, std::size_t N> class small_buffer
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+  small_buffer() noexcept {}
+  small_buffer(small_buffer const &rhs) { *this = rhs; }
+  small_buffer(small_buffer &&rhs) noexcept { *this = std::move(rhs); }
+  ~small_buffer() { release(); }
+
+  small_buffer &operator=(small_buffer const &rhs)
+  {
+    if (&rhs != this)
+    {
+      resize(rhs.m_size);
+      std::memcpy(data(), rhs.data(), m_size * sizeof(T));
+    }
+    return *this;
+  }
+
+  /// Move.  The buffer takes on @c rhs's memory resource, if any.
+  small_buffer &operator=(small_buffer &&rhs) noexcept
+  {
+    if (&rhs == this)
+      return *this;
+    release();
+#if defined(PQXX_HAVE_PMR)
+    m_resource = rhs.m_resource;
+#endif
+    if (rhs.m_heap != nullptr)
+    {
+      m_heap = std::exchange(rhs.m_heap, nullptr);
+      m_capacity = std::exchange(rhs.m_capacity, N);
+    }
+    else
+    {
+      std::memcpy(m_inline, rhs.m_inline, rhs.m_size * sizeof(T));
+    }
+    m_size = std::exchange(rhs.m_size, 0u);
+    return *this;
+  }
+
+#if defined(PQXX_HAVE_PMR)
+  /// Allocate any heap memory from @c resource.  Null means "the heap."
+  /** Only call this while the buffer has no heap memory, e.g. just after
+   * creating it.
+   */
+  void set_memory_resource(std::pmr::memory_resource *resource) noexcept
+  {
+    m_resource = resource;
+  }
+#endif
+
+  [[nodiscard]] T *data() noexcept { return m_heap ? m_heap : m_inline; }
+  [[nodiscard]] T const *data() const noexcept
+  {
+    return m_heap ? m_heap : m_inline;
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+  [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+  [[nodiscard]] T const *begin() const noexcept { return data(); }
+  [[nodiscard]] T const *end() const noexcept { return data() + m_size; }
+  T &operator[](std::size_t i) noexcept { return data()[i]; }
+  T const &operator[](std::size_t i) const noexcept { return data()[i]; }
+
+  /// Make room for at least @c n elements.
+  void reserve(std::size_t n)
+  {
+    if (n <= m_capacity)
+      return;
+    auto const capacity{std::max(n, 2 * m_capacity)};
+    T *const bigger{allocate(capacity)};
+    std::memcpy(bigger, data(), m_size * sizeof(T));
+    release();
+    m_heap = bigger;
+    m_capacity = capacity;
+  }
+
+  /// Set the number of elements.  Leaves any new elements uninitialised.
+  void resize(std::size_t n)
+  {
+    reserve(n);
+    m_size = n;
+  }
+
+  void push_back(T value)
+  {
+    reserve(m_size + 1);
+    data()[m_size++] = value;
+  }
+
+  /// Remove all elements, but keep the memory for re-use.
+  void clear() noexcept { m_size = 0; }
+
+private:
+  T *allocate(std::size_t n)
+  {
+#if defined(PQXX_HAVE_PMR)
+    if (m_resource != nullptr)
+      return static_cast<T *>(
+        m_resource->allocate(n * sizeof(T), alignof(T)));
+#endif
+    return new T[n];
+  }
+
+  /// Free any heap memory, and go back to the inline storage.
+  void release() noexcept
+  {
+    if (m_heap == nullptr)
+      return;
+#if defined(PQXX_HAVE_PMR)
+    if (m_resource != nullptr)
+      m_resource->deallocate(m_heap, m_capacity * sizeof(T), alignof(T));
+    else
+#endif
+      delete[] m_heap;
+    m_heap = nullptr;
+    m_capacity = N;
+  }
+
+  T m_inline[N];
+  T *m_heap = nullptr;
+  std::size_t m_size = 0;
+  std::size_t m_capacity = N;
+#if defined(PQXX_HAVE_PMR)
+  std::pmr::memory_resource *m_resource = nullptr;
+#endif
+};
+
+
 /// Internal type: encode statement parameters.
 /** Compiles arguments for prepared statements and parameterised queries into
  * a format that can be passed into libpq.
  *
- * Objects of this type are meant to be short-lived.  If you pass in a non-null
- * pointer as a parameter, it may simply use that pointer as a parameter value.
+ * All parameter values go into a single contiguous buffer, one after the
+ * other, each with a terminating zero.  For the common case of a few short
+ * parameters, that buffer and the arrays libpq needs are all inline, so
+ * building a @c params allocates no memory at all.
+ *
+ * Raw binary data (see @c is_raw_bytes) is the exception: those parameters
+ * point straight into the caller's memory.  They're "borrowed."  If the
+ * object needs to outlive the call that built it, call @c own() to copy them.
+ *
+ * Objects of this type are meant to be short-lived.
  */
 struct params
 {
+  /// Number of parameters for which a params object has room inline.
+  static constexpr std::size_t inline_params{16};
+  /// Amount of parameter text for which a params object has room inline.
+  static constexpr std::size_t inline_bytes{256};
+
   /// Construct directly from a series of statement arguments.
   /** The arrays all default to zero, null, and empty strings.
    */
-  template<typename... Args> constexpr params(Args &&... args)
+  template<typename... Args> params(Args &&... args)
   {
-    strings.reserve(sizeof...(args));
-    lengths.reserve(sizeof...(args));
-    nonnulls.reserve(sizeof...(args));
-    binaries.reserve(sizeof...(args));
+    reserve_for(args...);
+    add_fields(std::forward<Args>(args)...);
+  }
+
+  params(params const &) = default;
+  /// Copy.  (Without this, a non-const params would go into the variadic one.)
+  params(params &rhs) : params{std::as_const(rhs)} {}
+  params(params &&) noexcept = default;
+  params &operator=(params const &) = default;
+  params &operator=(params &&) noexcept = default;
+
+  /// Replace the parameters with a new series of statement arguments.
+  /** Re-uses the existing buffers, so that a loop executing the same
+   * statement with many different parameter sets need not allocate a new
+   * set of arrays for each.
+   */
+  template<typename... Args> void assign(Args &&... args)
+  {
+    clear();
+    append(std::forward<Args>(args)...);
+  }
 
-    // Start recursively storing parameters.
+  /// Add more statement arguments after the ones already there.
+  template<typename... Args> void append(Args &&... args)
+  {
+    reserve_for(args...);
     add_fields(std::forward<Args>(args)...);
   }
 
-  /// Compose a vector of pointers to parameter string values.
-  std::vector<char const *> get_pointers() const
+#if defined(PQXX_HAVE_PMR)
+  /// Allocate any memory beyond the inline room from @c resource.
+  /** Call this before adding any parameters.  Null means "the heap."
+   */
+  void set_memory_resource(std::pmr::memory_resource *resource) noexcept
+  {
+    lengths.set_memory_resource(resource);
+    nonnulls.set_memory_resource(resource);
+    binaries.set_memory_resource(resource);
+    types.set_memory_resource(resource);
+    m_values.set_memory_resource(resource);
+    m_borrowed.set_memory_resource(resource);
+    m_resource = resource;
+  }
+#endif
+
+  /// Remove all parameters, but keep the buffers for re-use.
+  void clear() noexcept
+  {
+    lengths.clear();
+    nonnulls.clear();
+    binaries.clear();
+    types.clear();
+    m_values.clear();
+    m_borrowed.clear();
+    m_borrowed_bytes = 0;
+  }
+
+  /// Copy any borrowed values into our own buffer.
+  /** After this, the parameters no longer refer to the caller's memory.  Do
+   * this whenever the object may outlive the arguments it was built from.
+   */
+  void own()
   {
-    std::size_t const num_fields{lengths.size()};
-    std::size_t cur_string{0}, cur_bin_string{0};
-    std::vector<char const *> pointers(num_fields);
+    if (m_borrowed.empty())
+      return;
+    small_buffer<char, inline_bytes> values;
+#if defined(PQXX_HAVE_PMR)
+    values.set_memory_resource(m_resource);
+#endif
+    values.reserve(
+      std::size(m_values) + m_borrowed_bytes + std::size(m_borrowed));
+    auto const pointers{get_pointers()};
+    std::size_t const num_fields{std::size(lengths)};
     for (std::size_t index{0}; index < num_fields; index++)
     {
-      char const *value;
-      if (binaries[index] != 0)
+      if (nonnulls[index] == 0)
+        continue;
+      auto const length{static_cast<std::size_t>(lengths[index])};
+      auto const here{std::size(values)};
+      values.resize(here + length + 1);
+      if (length > 0)
+        std::memcpy(values.data() + here, pointers[index], length);
+      values[here + length] = '\0';
+    }
+    m_values = std::move(values);
+    m_borrowed.clear();
+    m_borrowed_bytes = 0;
+  }
+
+  /// Number of parameters.
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    return std::size(lengths);
+  }
+
+  /// Total size of the parameter values, in bytes.
+  [[nodiscard]] std::size_t value_bytes() const noexcept
+  {
+    return std::size(m_values) + m_borrowed_bytes;
+  }
+
+  /// Compose an array of pointers to parameter values.
+  small_buffer<char const *, inline_params> get_pointers() const
+  {
+    std::size_t const num_fields{std::size(lengths)};
+    small_buffer<char const *, inline_params> pointers;
+#if defined(PQXX_HAVE_PMR)
+    pointers.set_memory_resource(m_resource);
+#endif
+    pointers.resize(num_fields);
+    char const *here{m_values.data()};
+    auto borrowed{std::begin(m_borrowed)};
+    for (std::size_t index{0}; index < num_fields; index++)
+    {
+      if (nonnulls[index] == 0)
       {
-        value = bin_strings[cur_bin_string].get();
-        cur_bin_string++;
+        pointers[index] = nullptr;
       }
-      else if (nonnulls[index] != 0)
+      else if (
+        borrowed != std::end(m_borrowed) and borrowed->index == index)
       {
-        value = strings[cur_string].c_str();
-        cur_string++;
+        pointers[index] = borrowed->data;
+        ++borrowed;
       }
       else
       {
-        value = nullptr;
+        pointers[index] = here;
+        here += lengths[index] + 1;
       }
-      pointers[index] = value;
     }
     return pointers;
   }
 
-  /// String values, for string parameters.
-  std::vector<std::string> strings;
   /// As used by libpq: lengths of non-null arguments, in bytes.
-  std::vector<int> lengths;
+  small_buffer<int, inline_params> lengths;
   /// As used by libpq: boolean "is this parameter non-null?"
-  std::vector<int> nonnulls;
+  small_buffer<int, inline_params> nonnulls;
   /// As used by libpq: boolean "is this parameter in binary format?"
-  std::vector<int> binaries;
-  /// Binary string values, for binary parameters.
-  std::vector<pqxx::binarystring> bin_strings;
+  small_buffer<int, inline_params> binaries;
+  /// As used by libpq: parameter types, or zero to let the server decide.
+  /** Only binary parameters of known types set this.
+   */
+  small_buffer<oid, inline_params> types;
+
+  /// Append an unambiguous encoding of the parameters to @c out.
+  /** Two parameter lists get the same encoding if, and only if, they pass the
+   * same values in the same formats.  This makes it usable as a lookup key.
+   */
+  void encode(std::string &out) const
+  {
+    auto const pointers{get_pointers()};
+    std::size_t const num_fields{std::size(lengths)};
+    for (std::size_t index{0}; index < num_fields; index++)
+    {
+      if (nonnulls[index] == 0)
+      {
+        out.push_back('n');
+        continue;
+      }
+      out.push_back((binaries[index] != 0) ? 'b' : 't');
+      out.append(
+        reinterpret_cast<char const *>(&types[index]), sizeof(types[index]));
+      out.append(
+        reinterpret_cast<char const *>(&lengths[index]),
+        sizeof(lengths[index]));
+      out.append(pointers[index], static_cast<std::size_t>(lengths[index]));
+    }
+  }
+
+  /// Does any parameter come with a type?
+  [[nodiscard]] bool has_types() const noexcept
+  {
+    for (auto const type : types)
+      if (type != oid_none)
+        return true;
+    return false;
+  }
 
 private:
-  /// Add a non-null string field.
-  void add_field(std::string text)
+  /// How much room a non-dynamic argument may need, including its zero.
+  template<typename Arg> static std::size_t budget(Arg const &arg)
+  {
+    if constexpr (std::is_same_v<Arg, std::nullptr_t> or is_raw_bytes<Arg>)
+      return 0;
+    else if constexpr (is_binary_param<Arg>)
+      return is_null(arg.value) ? 0 : budget_binary(arg.value);
+    else if constexpr (std::is_same_v<Arg, binarystring>)
+      return std::size(arg) + 1;
+    else if (is_null(arg))
+      return 0;
+    else if constexpr (std::is_convertible_v<Arg const &, std::string_view>)
+      return std::size(std::string_view{arg}) + 1;
+    else
+      return string_traits<Arg>::size_buffer(arg);
+  }
+
+  /// How much room a binary parameter needs, including the trailing zero.
+  template<typename T> static std::size_t budget_binary(T const &value)
+  {
+    return binary_traits<T>::binary_size(value) + 1;
+  }
+
+  /// Allocate all the room we're going to need, in one go.
+  /** If the number of arguments is fixed at compile time, as it is for most
+   * statements, we know exactly how many parameters there will be, and
+   * roughly how much space their values will take.  That way, we'll need at
+   * most a single allocation, and none at all for the usual small parameter
+   * lists.
+   */
+  template<typename... Args> void reserve_for(Args const &... args)
+  {
+    if constexpr (not(is_dynamic_params<std::decay_t<Args>> or ...))
+    {
+      std::size_t const count{std::size(lengths) + sizeof...(Args)};
+      lengths.reserve(count);
+      nonnulls.reserve(count);
+      binaries.reserve(count);
+      types.reserve(count);
+      m_values.reserve(
+        std::size(m_values) + (std::size_t{0} + ... + budget(args)));
+    }
+  }
+
+  /// Register a parameter whose value we just wrote into m_values.
+  void add_entry(std::size_t length, bool binary, oid type = oid_none)
   {
-    lengths.push_back(int(text.size()));
+    lengths.push_back(check_cast<int>(length, "statement parameter"));
     nonnulls.push_back(1);
-    binaries.push_back(0);
-    strings.emplace_back(std::move(text));
+    binaries.push_back(binary ? 1 : 0);
+    types.push_back(type);
+  }
+
+  /// Add a non-null parameter, by copying its bytes.
+  void add_bytes(void const *data, std::size_t length, bool binary)
+  {
+    auto const here{std::size(m_values)};
+    m_values.resize(here + length + 1);
+    if (length > 0)
+      std::memcpy(m_values.data() + here, data, length);
+    m_values[here + length] = '\0';
+    add_entry(length, binary);
+  }
+
+  /// Add a non-null binary parameter, pointing to the caller's data.
+  void add_borrowed(void const *data, std::size_t length)
+  {
+    // An empty range may have a null pointer, but to libpq that means null.
+    m_borrowed.push_back(borrowed_value{
+      std::size(lengths),
+      (length == 0) ? "" : static_cast<char const *>(data)});
+    m_borrowed_bytes += length;
+    add_entry(length, true);
   }
 
   /// Compile one argument (specialised for null pointer, a null value).
@@ -218,26 +627,68 @@ private:
     lengths.push_back(0);
     nonnulls.push_back(0);
     binaries.push_back(0);
+    types.push_back(oid_none);
   }
 
   /// Compile one argument (specialised for binarystring).
   void add_field(binarystring const &arg)
   {
-    lengths.push_back(int(arg.size()));
-    nonnulls.push_back(1);
-    binaries.push_back(1);
-    bin_strings.push_back(arg);
+    add_bytes(arg.data(), arg.size(), true);
+  }
+
+  /// Compile one argument (specialised for binary_param).
+  /** A null is just a null, even if it's a binary one.
+   */
+  template<typename T> void add_field(binary_param<T> const &arg)
+  {
+    if (is_null(arg.value))
+    {
+      add_field(nullptr);
+      return;
+    }
+    auto const here{std::size(m_values)};
+    auto const size{binary_traits<T>::binary_size(arg.value)};
+    m_values.resize(here + size + 1);
+    char *const begin{m_values.data() + here};
+    char *const end{
+      binary_traits<T>::into_binary(begin, begin + size, arg.value)};
+    // Keep up the convention of a trailing zero after each value.
+    *end = '\0';
+    add_entry(size, true, binary_type_oid<T>::value);
   }
 
   /// Compile one argument (default, generic implementation).
-  /** Uses string_traits to represent the argument as a std::string.
+  /** Writes the argument's text representation straight into the values
+   * buffer: as-is if it's already a string, or using @c string_traits.
    */
   template<typename Arg> void add_field(Arg const &arg)
   {
-    if (is_null(arg))
+    if constexpr (is_raw_bytes<Arg>)
+    {
+      add_borrowed(std::data(arg), std::size(arg));
+    }
+    else if (is_null(arg))
+    {
       add_field(nullptr);
+    }
+    else if constexpr (std::is_convertible_v<Arg const &, std::string_view>)
+    {
+      std::string_view const text{arg};
+      add_bytes(text.data(), std::size(text), false);
+    }
     else
-      add_field(to_string(arg));
+    {
+      auto const here{std::size(m_values)};
+      auto const budget{string_traits<Arg>::size_buffer(arg)};
+      m_values.resize(here + budget);
+      char *const begin{m_values.data() + here};
+      char *const end{
+        string_traits<Arg>::into_buf(begin, begin + budget, arg)};
+      // The value ends in a terminating zero; keep it, but don't count it.
+      auto const length{static_cast<std::size_t>(end - begin) - 1};
+      m_values.resize(here + length + 1);
+      add_entry(length, false);
+    }
   }
 
   /// Compile a dynamic_params object into a dynamic number of parameters.
@@ -267,6 +718,26 @@ private:
   /** Recursion in add_fields ends with this call.
    */
   void add_fields() {}
+
+  /// A parameter whose value is in the caller's memory, not in @c m_values.
+  struct borrowed_value
+  {
+    std::size_t index;
+    char const *data;
+  };
+
+  /// All non-null parameter values, back to back, each with a trailing zero.
+  /** Except the borrowed ones.
+   */
+  small_buffer<char, inline_bytes> m_values;
+  /// The borrowed parameters, in order.
+  small_buffer<borrowed_value, 4> m_borrowed;
+  /// Total size of the borrowed parameters' values.
+  std::size_t m_borrowed_bytes = 0;
+#if defined(PQXX_HAVE_PMR)
+  /// Memory resource for the buffers, or null for the heap.
+  std::pmr::memory_resource *m_resource = nullptr;
+#endif
 };
 } // namespace pqxx::internal
 
@@ -12,17 +12,23 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
-namespace pqxx
-{
-class stream_from;
-}
-
+#include <tuple>
+#include <utility>
 
 namespace pqxx::internal
 {
 // TODO: Replace with C++20 generator.
-/// Input iterator for stream_from.
-template<typename... TYPE> class stream_input_iterator
+/// Input iterator for a stream, such as stream_from or stream_query.
+/** The iterator holds the current row as a tuple, and reads each next row
+ * into that same tuple, so that fields such as @c std::string can re-use
+ * their storage from one row to the next.  Once the buffers have grown large
+ * enough, iteration does not allocate.
+ *
+ * To keep a row, move it out: "auto row{std::move(*i)}", or in a range-based
+ * loop, "for (auto &&[a, b] : stream.iter<A, B>()) keep(std::move(a))".  The
+ * next row then has to allocate afresh, of course.
+ */
+template<typename STREAM, typename... TYPE> class stream_input_iterator
 {
 public:
   using value_type = std::tuple<TYPE...>;
@@ -30,7 +36,7 @@ public:
   /// Construct an "end" iterator.
   stream_input_iterator() = default;
 
-  explicit stream_input_iterator(stream_from &home) : m_home(&home)
+  explicit stream_input_iterator(STREAM &home) : m_home(&home)
   {
     advance();
   }
@@ -41,14 +47,22 @@ public:
     advance();
     return *this;
   }
-  stream_input_iterator operator++(int)
+  /// Post-increment.  Returns a holder for the previous row.
+  /** The previous row moves into the holder, so there is no copying; but
+   * its storage can not be re-used for the next row.
+   */
+  auto operator++(int)
   {
-    stream_input_iterator next{*this};
-    return ++next;
+    postfix_holder previous{std::move(m_value)};
+    advance();
+    return previous;
   }
 
-  const value_type &operator*() const { return m_value; }
-  const value_type *operator->() const { return &m_value; }
+  value_type const &operator*() const noexcept { return m_value; }
+  value_type const *operator->() const noexcept { return &m_value; }
+  /// The current row, which you may move out of.
+  value_type &operator*() noexcept { return m_value; }
+  value_type *operator->() noexcept { return &m_value; }
 
   bool operator==(stream_input_iterator const &rhs) const
   {
@@ -61,31 +75,43 @@ public:
   }
 
 private:
+  /// What post-increment returns: the row that was current until then.
+  class postfix_holder
+  {
+  public:
+    explicit postfix_holder(value_type &&value) : m_held{std::move(value)} {}
+    value_type &operator*() noexcept { return m_held; }
+    value_type *operator->() noexcept { return &m_held; }
+
+  private:
+    value_type m_held;
+  };
+
   void advance()
   {
     if (m_home == nullptr)
-      throw usage_error{"Moving stream_from iterator beyond end()."};
+      throw usage_error{"Moving stream iterator beyond end()."};
     ++m_offset;
     if (not((*m_home) >> m_value))
       m_home = nullptr;
   }
 
-  stream_from *m_home = nullptr;
+  STREAM *m_home = nullptr;
   size_t m_offset = 0;
   value_type m_value;
 };
 
 
-template<typename... TYPE> class stream_input_iteration
+template<typename STREAM, typename... TYPE> class stream_input_iteration
 {
 public:
-  using iterator = stream_input_iterator<TYPE...>;
-  explicit stream_input_iteration(stream_from &home) : m_home(home) {}
+  using iterator = stream_input_iterator<STREAM, TYPE...>;
+  explicit stream_input_iteration(STREAM &home) : m_home(home) {}
   iterator begin() const { return iterator{m_home}; }
   iterator end() const { return iterator{}; }
 
 private:
-  stream_from &m_home;
+  STREAM &m_home;
 };
 } // namespace pqxx::internal
 
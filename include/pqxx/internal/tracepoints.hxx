@@ -0,0 +1,66 @@
+/** Static tracepoints (USDT probes) on libpqxx's hot paths.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_TRACEPOINTS
+#define PQXX_H_TRACEPOINTS
+
+/* Build libpqxx with --enable-tracepoints (or the CMake option
+ * PQXX_ENABLE_TRACEPOINTS) and it gets USDT probes, which systemtap,
+ * bpftrace, or DTrace can attach to at run time.  For example:
+ *
+ *	bpftrace -e 'usdt:libpqxx.so:libpqxx:wait__start { @[tid] = nsecs; }'
+ *
+ * Each probe compiles to a single no-op instruction, plus a note in the
+ * binary saying where it is.  Without the option, the probes compile to
+ * nothing at all, and their arguments don't get evaluated.
+ *
+ * The probes, all under provider "libpqxx":
+ *
+ * connection__open(connection *)
+ *	A connection has been established.
+ * connection__close(connection *)
+ *	A connection is about to close.
+ * exec__start(connection *, char const *query)
+ *	About to send a query or prepared statement, and wait for its result.
+ *	For a prepared statement, the "query" is the statement's name.
+ * exec__done(connection *, char const *query)
+ *	The result (or error) has come in, but not yet been checked.
+ * pipeline__issue(pipeline *, long first_id, long count)
+ *	A pipeline has sent out "count" queries, starting at "first_id".
+ * pipeline__receive(pipeline *, long id)
+ *	A pipeline has received the result for query "id".
+ * copy__read(connection *, size_t bytes)
+ *	Received a line (or chunk) of COPY data.
+ * copy__write(connection *, size_t bytes)
+ *	Sent a line (or chunk) of COPY data.
+ * wait__start(int socket, int for_write)
+ *	About to block, waiting for a socket to become ready.
+ * wait__done(int socket)
+ *	Done waiting.
+ *
+ * The time between exec__start and exec__done is the round trip.  The time
+ * spent between wait__start and wait__done is the client's blocking time.
+ * Whatever is left is the client's own work, such as conversions.
+ */
+
+#if defined(PQXX_ENABLE_TRACEPOINTS)
+
+#  include <sys/sdt.h>
+
+#  define PQXX_TRACE1(name, a) DTRACE_PROBE1(libpqxx, name, a)
+#  define PQXX_TRACE2(name, a, b) DTRACE_PROBE2(libpqxx, name, a, b)
+#  define PQXX_TRACE3(name, a, b, c) DTRACE_PROBE3(libpqxx, name, a, b, c)
+
+#else
+
+#  define PQXX_TRACE1(name, a) ((void)0)
+#  define PQXX_TRACE2(name, a, b) ((void)0)
+#  define PQXX_TRACE3(name, a, b, c) ((void)0)
+
+#endif // PQXX_ENABLE_TRACEPOINTS
+#endif
@@ -0,0 +1,160 @@
+/* Definition of the pqxx::json_view type.
+ *
+ * pqxx::json_view refers to a JSON document's text, without copying it.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/json instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_JSON
+#define PQXX_H_JSON
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "pqxx/binary_traits.hxx"
+#include "pqxx/strconv.hxx"
+#include "pqxx/zview.hxx"
+
+
+namespace pqxx
+{
+/// A @c json or @c jsonb value's text, wherever it happens to be.
+/** Reading a field as a @c json_view costs no copy and no allocation: the
+ * view points into the result, so it is valid only as long as the result
+ * object, or a copy of it, exists.
+ *
+ * This works for @c json and @c jsonb fields alike, in text or in binary
+ * format.  In binary, the server sends a @c jsonb as a version byte followed
+ * by the text; the view leaves out the version byte.  Either way, the text is
+ * zero-terminated.
+ *
+ * Writing a @c json_view as a parameter or into a @c stream_to copies its
+ * text straight into the outgoing buffer.  As a binary parameter (see
+ * @c prepare::make_binary_param) it goes to the server as a binary @c jsonb.
+ */
+class json_view
+{
+public:
+  /// Version of the binary @c jsonb format that we know.
+  static constexpr char jsonb_version{1};
+
+  constexpr json_view() noexcept = default;
+  /// Refer to JSON text.  It must stay alive as long as you use the view.
+  explicit constexpr json_view(zview text) noexcept : m_text{text} {}
+
+  /// The JSON text.
+  [[nodiscard]] constexpr zview text() const noexcept { return m_text; }
+  /// The JSON text, as a zero-terminated C-style string.
+  [[nodiscard]] constexpr char const *c_str() const noexcept
+  {
+    return m_text.c_str();
+  }
+  [[nodiscard]] constexpr char const *data() const noexcept
+  {
+    return m_text.data();
+  }
+  [[nodiscard]] constexpr std::size_t size() const noexcept
+  {
+    return std::size(m_text);
+  }
+  [[nodiscard]] constexpr bool empty() const noexcept
+  {
+    return std::empty(m_text);
+  }
+
+  /// Copy the text into @c buffer, followed by @c padding zero bytes.
+  /** Some fast JSON parsers, such as simdjson, read their input in blocks,
+   * so they need readable memory beyond the end of the text.  There's no
+   * way to guarantee that in the result itself, so this copies.  If you
+   * re-use the same buffer for many values, it soon stops allocating.
+   *
+   * Returns a view of just the text, in @c buffer.  The padding follows.
+   */
+  std::string_view
+  padded(std::string &buffer, std::size_t padding = 64) const
+  {
+    buffer.resize(size() + padding);
+    if (not empty())
+      std::memcpy(buffer.data(), data(), size());
+    std::memset(buffer.data() + size(), 0, padding);
+    return std::string_view{buffer.data(), size()};
+  }
+
+private:
+  zview m_text;
+};
+
+
+template<> struct nullness<json_view> : no_null<json_view>
+{};
+
+
+/// Converts a @c json_view to and from text.  Neither copies the text.
+template<> struct string_traits<json_view>
+{
+  static json_view from_string(std::string_view text) noexcept
+  {
+    // A field's text is always zero-terminated.
+    return json_view{zview{text}};
+  }
+
+  static char *into_buf(char *begin, char *end, json_view const &value)
+  {
+    return string_traits<zview>::into_buf(begin, end, value.text());
+  }
+
+  static zview to_buf(char *, char *, json_view const &value) noexcept
+  {
+    return value.text();
+  }
+
+  static std::size_t size_buffer(json_view const &value) noexcept
+  {
+    return value.size() + 1;
+  }
+};
+
+
+/// Reads @c json and @c jsonb in binary; writes @c jsonb.
+template<> struct binary_traits<json_view>
+{
+  /// OID of @c jsonb.
+  static constexpr oid type_oid{3802};
+
+  /// Read a binary @c jsonb, or a @c json, which in binary is just its text.
+  /** No JSON text can start with the version byte, so this tells them apart
+   * by looking at the first byte.
+   */
+  [[nodiscard]] static json_view from_binary(std::string_view data) noexcept
+  {
+    if (not std::empty(data) and data[0] == json_view::jsonb_version)
+      data.remove_prefix(1);
+    return json_view{zview{data}};
+  }
+
+  [[nodiscard]] static std::size_t binary_size(json_view const &value) noexcept
+  {
+    return 1 + value.size();
+  }
+
+  static char *into_binary(char *begin, char *end, json_view const &value)
+  {
+    internal::check_binary_space(begin, end, 1 + value.size(), "jsonb");
+    *begin = json_view::jsonb_version;
+    value.text().copy(begin + 1, value.size());
+    return begin + 1 + value.size();
+  }
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,211 @@
+/* Definition of the pqxx::keyset_cursor class.
+ *
+ * pqxx::keyset_cursor pages through a query's results by sort key.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/keyset_cursor instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_KEYSET_CURSOR
+#define PQXX_H_KEYSET_CURSOR
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pqxx/result.hxx"
+#include "pqxx/result_iterator.hxx"
+#include "pqxx/row.hxx"
+
+
+namespace pqxx
+{
+/// Direction in which a @c keyset_cursor goes through the sort key.
+enum class keyset_order
+{
+  ascending,
+  descending,
+};
+
+
+/// One page of rows from a @c keyset_cursor.
+/** This is a range of rows in a @c result.  It shares the result with any
+ * other pages that came out of the same fetch.
+ */
+class PQXX_LIBEXPORT keyset_page
+{
+public:
+  using size_type = result_size_type;
+  using const_iterator = result::const_iterator;
+
+  keyset_page() = default;
+
+  [[nodiscard]] size_type size() const noexcept { return m_end - m_begin; }
+  [[nodiscard]] bool empty() const noexcept { return m_end == m_begin; }
+
+  [[nodiscard]] row operator[](size_type i) const noexcept
+  {
+    return m_result[m_begin + i];
+  }
+
+  [[nodiscard]] const_iterator begin() const noexcept
+  {
+    return m_result.begin() + m_begin;
+  }
+  [[nodiscard]] const_iterator end() const noexcept
+  {
+    return m_result.begin() + m_end;
+  }
+
+  /// The result that this page's rows come from.
+  [[nodiscard]] result const &source() const noexcept { return m_result; }
+
+private:
+  friend class keyset_cursor;
+  keyset_page(result const &res, size_type begin, size_type end) :
+          m_result{res}, m_begin{begin}, m_end{end}
+  {}
+
+  result m_result;
+  size_type m_begin = 0, m_end = 0;
+};
+
+
+/// Page through a query's results by sort key, without a server-side cursor.
+/** This is "keyset pagination."  The cursor remembers the sort key of the
+ * last row it returned.  To get the next page, it queries for the rows that
+ * come after that key, up to the page size:
+ *
+ * @code
+ *	SELECT * FROM (query) WHERE (key) > (last key) ORDER BY key LIMIT n
+ * @endcode
+ *
+ * With an index on the key, each page is an index seek.  Unlike a
+ * @c stateless_cursor, there is no transaction that needs to stay open, and
+ * no backend tied up with cursor state: you can fetch each page in a
+ * different transaction, or even on a different connection.  You can also
+ * save the position, e.g. in a page token for a web API, and @c seek() back
+ * to it later.
+ *
+ * The key consists of one or more columns of the query's result.  Their
+ * combined values must be unique, and not null, or pages will miss rows.
+ *
+ * The cursor sees changes to the data as it goes.  A row inserted before
+ * the current position won't show up; one inserted after it will.
+ *
+ * The query must not have parameters of its own.
+ */
+class PQXX_LIBEXPORT keyset_cursor
+{
+public:
+  using size_type = result_size_type;
+
+  /// Create a cursor on @c query, sorting on columns @c key.
+  /** @param cx Connection, just for quoting the key's column names.  The
+   *     cursor does not keep it.
+   * @param query The query whose results to page through.
+   * @param key Names of the columns that make up the sort key.
+   * @param page_size Number of rows per page.
+   * @param order Whether to go through the key in ascending or descending
+   *     order.
+   */
+  keyset_cursor(
+    connection &cx, std::string_view query, std::vector<std::string> key,
+    size_type page_size, keyset_order order = keyset_order::ascending);
+
+  /// Fetch the next page, using @c tx.
+  /** At the end, returns an empty page.
+   */
+  keyset_page next(transaction_base &tx);
+
+  /// Has the cursor returned all rows?
+  [[nodiscard]] bool done() const noexcept { return m_done; }
+
+  /// Key of the last row that @c next() returned.  Empty at the start.
+  [[nodiscard]] std::vector<std::string> const &position() const noexcept
+  {
+    return m_position;
+  }
+
+  /// Continue after the row with key @c position.
+  /** Pass an empty vector to go back to the start.
+   *
+   * @throw argument_error If the key has the wrong number of values.
+   */
+  void seek(std::vector<std::string> position);
+
+  /// Go back to the start.
+  void rewind() { seek({}); }
+
+  /// Fetch this many extra pages along with each page.
+  /** This saves round trips: a single query fetches @c pages + 1 pages, and
+   * the following calls to @c next() return the extra pages from memory.
+   * Those rows may be slightly out of date by the time you get them.
+   *
+   * The default is zero: fetch a page at a time.
+   */
+  void set_prefetch(size_type pages);
+
+  /// Execute prepared statements, instead of plain queries.
+  /** Prepares the cursor's statements on @c cx, as @c name (for pages after
+   * the first) and @c name followed by @c "_first" (for the first page).
+   * From then on, the cursor executes those statements.
+   *
+   * If you use the cursor on other connections as well, prepare the
+   * statements on those too, under the same name.
+   */
+  void prepare(connection &cx, std::string const &name);
+
+  /// Execute statements that you have already prepared.
+  /** Use this when you've prepared them yourself, e.g. in a
+   * @c connection_pool.  The statements are @c seek_query() as @c name, and
+   * @c first_query() as @c name followed by @c "_first".  An empty name
+   * goes back to executing plain queries.
+   */
+  void use_prepared(std::string name);
+
+  /// The SQL for the first page.  Its one parameter is the row limit.
+  [[nodiscard]] std::string const &first_query() const noexcept
+  {
+    return m_first_query;
+  }
+
+  /// The SQL for a page after a given key.
+  /** The parameters are the key's values, followed by the row limit.
+   */
+  [[nodiscard]] std::string const &seek_query() const noexcept
+  {
+    return m_seek_query;
+  }
+
+private:
+  /// Run the right query for the next rows.
+  result PQXX_PRIVATE fetch(transaction_base &tx, size_type limit);
+
+  std::string m_first_query;
+  std::string m_seek_query;
+  /// Name of the prepared statement for @c m_seek_query, if any.
+  std::string m_statement;
+  std::vector<std::string> m_key;
+  std::vector<std::string> m_position;
+  size_type m_page_size;
+  size_type m_prefetch = 0;
+  /// Rows fetched so far, of which we may not have returned all.
+  result m_buffer;
+  /// First row in @c m_buffer that we haven't returned yet.
+  size_type m_buffered = 0;
+  /// Did the last fetch reach the end of the query's rows?
+  bool m_exhausted = false;
+  bool m_done = false;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
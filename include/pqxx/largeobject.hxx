@@ -16,7 +16,11 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <functional>
+#include <list>
+#include <memory>
 #include <streambuf>
+#include <unordered_map>
 
 #include "pqxx/dbtransaction.hxx"
 
@@ -36,6 +40,9 @@ class PQXX_LIBEXPORT largeobject
 public:
   using size_type = large_object_size_type;
 
+  /// Default buffer size for the large object stream classes.
+  static constexpr size_type default_buffer_size{64 * 1024};
+
   /// Refer to a nonexistent large object (similar to what a null pointer does)
   largeobject() noexcept = default;
 
@@ -220,6 +227,7 @@ public:
     largeobject::to_file(m_trans, file);
   }
 
+  using largeobject::default_buffer_size;
   using largeobject::to_file;
 
   /**
@@ -260,6 +268,40 @@ public:
    * @return The current position in the large object.
    */
   [[nodiscard]] size_type tell() const;
+
+  /// Default chunk size for @c read_all() and @c write_all().
+  static constexpr size_t default_chunk_size{1024 * 1024};
+
+  /// Read everything from the current position to the end of the object.
+  /** Reads in chunks of up to @c chunk_size bytes.  Where libpq supports
+   * pipeline mode, this sends the requests for all chunks without waiting for
+   * the data to come back, so a big object does not cost a round trip per
+   * chunk.
+   *
+   * Leaves the current position at the end of the object.
+   */
+  [[nodiscard]] std::string read_all(size_t chunk_size = default_chunk_size);
+
+  /// Write @c data at the current position, in pipelined chunks.
+  /** Like @c write(), but sends the data in chunks of up to @c chunk_size
+   * bytes, without waiting for each chunk to finish before sending the next
+   * one.  There is no 2GB limit on the total size.
+   */
+  void
+  write_all(std::string_view data, size_t chunk_size = default_chunk_size);
+
+  /// Write everything from the current position onwards to a local file.
+  /** Works like @c read_all(), but writes each chunk to @c file as it comes
+   * in, so the object need not fit in memory.  Overwrites the file.
+   */
+  void read_to_file(
+    std::string_view file, size_t chunk_size = default_chunk_size);
+
+  /// Write a local file's contents at the current position.
+  /** Works like @c write_all(), reading the file a chunk at a time.
+   */
+  void write_from_file(
+    std::string_view file, size_t chunk_size = default_chunk_size);
   //@}
 
   /**
@@ -334,6 +376,17 @@ public:
 
 private:
   PQXX_PRIVATE std::string reason(int err) const;
+  /// Check a chunk size for @c read_all() or @c write_all().
+  PQXX_PRIVATE static size_t check_chunk_size(size_t chunk_size);
+  /// Number of bytes from the current position to the end of the object.
+  PQXX_PRIVATE size_t remaining();
+  /// Read @c total bytes in pipelined chunks, passing each to @c sink.
+  PQXX_PRIVATE void read_chunks(
+    size_t total, size_t chunk_size,
+    std::function<void(std::string_view)> const &sink);
+  /// Write chunks in a pipeline, until @c next returns an empty one.
+  PQXX_PRIVATE void
+  write_chunks(std::function<std::string_view()> const &next);
   internal::pq::PGconn *raw_connection() const
   {
     return largeobject::raw_connection(m_trans);
@@ -370,7 +423,8 @@ public:
 
   largeobject_streambuf(
     dbtransaction &t, largeobject o,
-    openmode mode = std::ios::in | std::ios::out, size_type buf_size = 512) :
+    openmode mode = std::ios::in | std::ios::out,
+    size_type buf_size = largeobject::default_buffer_size) :
           m_bufsize{buf_size},
           m_obj{t, o, mode},
           m_g{nullptr},
@@ -381,7 +435,7 @@ public:
 
   largeobject_streambuf(
     dbtransaction &t, oid o, openmode mode = std::ios::in | std::ios::out,
-    size_type buf_size = 512) :
+    size_type buf_size = largeobject::default_buffer_size) :
           m_bufsize{buf_size},
           m_obj{t, o, mode},
           m_g{nullptr},
@@ -530,7 +584,8 @@ public:
    * @param buf_size Size of buffer to use internally (optional)
    */
   basic_ilostream(
-    dbtransaction &t, largeobject o, largeobject::size_type buf_size = 512) :
+    dbtransaction &t, largeobject o,
+    largeobject::size_type buf_size = largeobject::default_buffer_size) :
           super{nullptr},
           m_buf{t, o, std::ios::in, buf_size}
   {
@@ -544,7 +599,8 @@ public:
    * @param buf_size Size of buffer to use internally (optional)
    */
   basic_ilostream(
-    dbtransaction &t, oid o, largeobject::size_type buf_size = 512) :
+    dbtransaction &t, oid o,
+    largeobject::size_type buf_size = largeobject::default_buffer_size) :
           super{nullptr},
           m_buf{t, o, std::ios::in, buf_size}
   {
@@ -586,7 +642,8 @@ public:
    * @param buf_size size of buffer to use internally (optional)
    */
   basic_olostream(
-    dbtransaction &t, largeobject o, largeobject::size_type buf_size = 512) :
+    dbtransaction &t, largeobject o,
+    largeobject::size_type buf_size = largeobject::default_buffer_size) :
           super{nullptr},
           m_buf{t, o, std::ios::out, buf_size}
   {
@@ -600,7 +657,8 @@ public:
    * @param buf_size size of buffer to use internally (optional)
    */
   basic_olostream(
-    dbtransaction &t, oid o, largeobject::size_type buf_size = 512) :
+    dbtransaction &t, oid o,
+    largeobject::size_type buf_size = largeobject::default_buffer_size) :
           super{nullptr},
           m_buf{t, o, std::ios::out, buf_size}
   {
@@ -655,7 +713,8 @@ public:
    * @param buf_size Size of buffer to use internally (optional)
    */
   basic_lostream(
-    dbtransaction &t, largeobject o, largeobject::size_type buf_size = 512) :
+    dbtransaction &t, largeobject o,
+    largeobject::size_type buf_size = largeobject::default_buffer_size) :
           super{nullptr},
           m_buf{t, o, std::ios::in | std::ios::out, buf_size}
   {
@@ -669,7 +728,8 @@ public:
    * @param buf_size Size of buffer to use internally (optional)
    */
   basic_lostream(
-    dbtransaction &t, oid o, largeobject::size_type buf_size = 512) :
+    dbtransaction &t, oid o,
+    largeobject::size_type buf_size = largeobject::default_buffer_size) :
           super{nullptr},
           m_buf{t, o, std::ios::in | std::ios::out, buf_size}
   {
@@ -694,6 +754,158 @@ private:
 };
 
 using lostream = basic_lostream<char>;
+
+
+/// Read-only, random access to a large object, through a page cache.
+/** Every @c largeobjectaccess::read() or @c seek() is a round trip to the
+ * server.  That adds up when you read scattered ranges of an object, e.g. to
+ * serve HTTP range requests.  A largeobject_view instead reads the object in
+ * fixed-size pages, and keeps the most recently used ones in memory.  Reads
+ * from cached pages cost no round trip at all.
+ *
+ * A read that misses the cache fetches all the missing pages it needs in a
+ * single query.  When the view sees you reading pages in sequence, it also
+ * fetches some pages ahead of where you are.  See @c set_readahead().
+ *
+ * The view does not see changes that you make to the object after it has
+ * cached the pages involved.  Call @c clear() to drop the cache.
+ *
+ * For an @c std::istream interface, wrap the view in a
+ * @c largeobject_view_buf.
+ *
+ * Use a view only within the transaction @c t, and only from one thread at a
+ * time.  It uses the server's @c lo_get() function, which needs PostgreSQL
+ * 9.4 or better.
+ */
+class PQXX_LIBEXPORT largeobject_view
+{
+public:
+  using size_type = largeobject::size_type;
+
+  /// Default page size: the size of a chunk in @c pg_largeobject, times 32.
+  static constexpr size_type default_page_size{64 * 1024};
+
+  /// Default maximum number of pages to keep in memory.
+  static constexpr std::size_t default_cache_pages{64};
+
+  /// Default number of pages to read ahead when reading sequentially.
+  static constexpr std::size_t default_readahead{4};
+
+  /**
+   * @param t Transaction in which to read the object.
+   * @param obj The large object to read.
+   * @param page_size Number of bytes per page.
+   * @param cache_pages Largest number of pages to keep in memory.
+   */
+  largeobject_view(
+    dbtransaction &t, largeobject obj,
+    size_type page_size = default_page_size,
+    std::size_t cache_pages = default_cache_pages);
+
+  largeobject_view(largeobject_view const &) = delete;
+  largeobject_view &operator=(largeobject_view const &) = delete;
+
+  /// The large object's identifier.
+  [[nodiscard]] oid id() const noexcept { return m_id; }
+
+  /// The object's size, in bytes.
+  /** The first call opens the object to find out, unless an earlier read
+   * already ran into the end of the object.
+   */
+  [[nodiscard]] size_type size();
+
+  /// Read up to @c len bytes, starting at @c offset, into @c buf.
+  /** @return Number of bytes read.  This is less than @c len only if the
+   * range reaches the end of the object.
+   */
+  std::size_t read(size_type offset, char buf[], std::size_t len);
+
+  /// Read up to @c len bytes, starting at @c offset.
+  [[nodiscard]] std::string read(size_type offset, std::size_t len);
+
+  /// Fetch this many extra pages when reading sequentially.
+  /** When a read misses the cache on the page right after the one it read
+   * last, the view fetches @c pages more pages along with it, in the same
+   * query.  Zero disables read-ahead.
+   */
+  void set_readahead(std::size_t pages) noexcept { m_readahead = pages; }
+
+  /// Drop all cached pages.
+  void clear() noexcept;
+
+  /// Number of queries the view has executed so far.
+  [[nodiscard]] std::size_t fetches() const noexcept { return m_fetches; }
+
+  /// Number of pages in the cache right now.
+  [[nodiscard]] std::size_t cached_pages() const noexcept
+  {
+    return std::size(m_pages);
+  }
+
+private:
+  friend class largeobject_view_buf;
+  using page_ptr = std::shared_ptr<std::string const>;
+
+  /// Get page number @c index, fetching it if needed.  Null past the end.
+  PQXX_PRIVATE page_ptr page(size_type index, size_type last);
+  /// Get a page from the cache, marking it as most recently used.
+  PQXX_PRIVATE page_ptr cached(size_type index) noexcept;
+  /// Fetch up to @c count pages, starting at @c first, into the cache.
+  PQXX_PRIVATE void fetch(size_type first, size_type count);
+
+  dbtransaction &m_trans;
+  oid m_id;
+  size_type m_page_size;
+  std::size_t m_capacity;
+  std::size_t m_readahead = default_readahead;
+  /// Cached pages, most recently used first.
+  std::list<std::pair<size_type, page_ptr>> m_lru;
+  std::unordered_map<size_type, decltype(m_lru)::iterator> m_pages;
+  /// The object's size, or -1 if we don't know it yet.
+  size_type m_size = -1;
+  /// The last page we returned, or -1.
+  size_type m_last_page = -1;
+  std::size_t m_fetches = 0;
+};
+
+
+/// Stream buffer for reading a @c largeobject_view as an @c std::istream.
+/** The stream reads straight out of the view's cached pages.  It supports
+ * seeking, so you can do range reads through the stream interface:
+ *
+ * @code
+ *	pqxx::largeobject_view view{tx, obj};
+ *	pqxx::largeobject_view_buf buf{view};
+ *	std::istream in{&buf};
+ *	in.seekg(offset);
+ * @endcode
+ *
+ * The view must stay alive for as long as you use the buffer.
+ */
+class PQXX_LIBEXPORT largeobject_view_buf : public std::streambuf
+{
+public:
+  explicit largeobject_view_buf(largeobject_view &view) : m_view{view} {}
+
+protected:
+  int_type underflow() override;
+  std::streamsize xsgetn(char_type *buf, std::streamsize len) override;
+  pos_type seekoff(off_type offset, std::ios::seekdir dir, std::ios::openmode)
+    override;
+  pos_type seekpos(pos_type pos, std::ios::openmode) override;
+
+private:
+  /// Current position in the object.
+  PQXX_PRIVATE largeobject_view::size_type position() const noexcept;
+  /// Go to @c pos, dropping the current page.
+  PQXX_PRIVATE pos_type jump(largeobject_view::size_type pos);
+
+  largeobject_view &m_view;
+  /// The page that the get area points into.
+  largeobject_view::page_ptr m_page;
+  /// Offset of @c m_page in the object, or of the position, if no page.
+  largeobject_view::size_type m_base = 0;
+};
 } // namespace pqxx
 
 #include "pqxx/internal/compiler-internal-post.hxx"
@@ -0,0 +1,74 @@
+/* Moving many large objects to or from local files, in parallel.
+ *
+ * These spread the objects over several pooled connections.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/largeobject_transfer
+ * instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_LARGEOBJECT_TRANSFER
+#define PQXX_H_LARGEOBJECT_TRANSFER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <string>
+#include <vector>
+
+#include "pqxx/connection_pool.hxx"
+#include "pqxx/largeobject.hxx"
+
+
+namespace pqxx
+{
+/// A large object, and the local file that holds its contents.
+struct large_object_file
+{
+  oid id = oid_none;
+  std::string path;
+};
+
+
+/// Write each of the large objects to its local file.
+/** Works on several objects at once, each thread on a connection of its own
+ * from @c pool.  Each object is read in a transaction of its own, using
+ * @c largeobjectaccess::read_to_file(), so its chunks travel in a pipeline.
+ *
+ * @param pool Where to get the connections.
+ * @param objects The objects to export, and the files to write them to.
+ * @param threads Number of threads to use, or zero to use as many as the
+ *     hardware supports.  There won't be more threads than objects.
+ * @param chunk_size Largest number of bytes to request in one go.
+ *
+ * If an object fails, the other threads stop as soon as they're done with
+ * the object they're working on.  Once they have all finished, this
+ * re-throws the first exception.
+ */
+PQXX_LIBEXPORT void export_large_objects(
+  connection_pool &pool, std::vector<large_object_file> const &objects,
+  std::size_t threads = 0,
+  std::size_t chunk_size = largeobjectaccess::default_chunk_size);
+
+
+/// Create a large object from each of the local files.
+/** Works like @c export_large_objects(), but in the other direction.  Each
+ * file becomes a new large object, committed in a transaction of its own.
+ * Sets each entry's @c id to the new object's identifier.
+ *
+ * If an import fails, the objects which were already committed remain, and
+ * their entries show their identifiers.  The other entries keep
+ * @c oid_none.
+ */
+PQXX_LIBEXPORT void import_large_objects(
+  connection_pool &pool, std::vector<large_object_file> &files,
+  std::size_t threads = 0,
+  std::size_t chunk_size = largeobjectaccess::default_chunk_size);
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -69,7 +69,11 @@ public:
   virtual ~nontransaction() override { close(); }
 
 private:
-  virtual void do_commit() override {}
+  virtual void do_commit() override
+  {
+    if (capturing_commit_lsn())
+      read_commit_lsn();
+  }
   virtual void do_abort() override {}
 };
 } // namespace pqxx
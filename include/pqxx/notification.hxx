@@ -19,6 +19,7 @@
 #include <string>
 
 #include "pqxx/types.hxx"
+#include "pqxx/zview.hxx"
 
 
 namespace pqxx
@@ -75,8 +76,21 @@ public:
    * @param backend_pid Process ID of the database backend process that served
    * our connection when the notification arrived.  The actual process ID
    * behind the connection may have changed by the time this method is called.
+   *
+   * Override either this, or @c receive().  The default does nothing.
    */
-  virtual void operator()(std::string const &payload, int backend_pid) = 0;
+  virtual void operator()(std::string const &payload, int backend_pid);
+
+  /// Overridable: like the function call operator, but without copying.
+  /** The connection calls this when a notification arrives.  The payload
+   * points into libpq's notification object, which goes away right after the
+   * call returns, so copy it if you need to hold on to it.
+   *
+   * The default implementation copies the payload into a @c std::string, and
+   * calls the function call operator.  Override this if you want to avoid
+   * that allocation.
+   */
+  virtual void receive(zview payload, int backend_pid);
 
 protected:
   connection &conn() const noexcept { return m_conn; }
@@ -85,6 +99,50 @@ private:
   connection &m_conn;
   std::string m_channel;
 };
+
+
+/// Register or remove many notification receivers in one round trip.
+/** @addtogroup notification Notifications and Receivers
+ *
+ * Normally, creating the first receiver for a channel executes a @c LISTEN
+ * right away, and destroying the last one executes an @c UNLISTEN.  That's a
+ * round trip to the database each time.  When you set up receivers for many
+ * channels at once, it adds up.
+ *
+ * While a @c receiver_batch is open on a connection, the connection holds
+ * back those commands instead.  When you call @c complete(), it sends them
+ * all in a single statement.  A channel which gets its first receiver and
+ * then loses its last one during the batch never goes to the server at all.
+ *
+ * @code
+ *	pqxx::receiver_batch batch{conn};
+ *	for (auto const &tenant : tenants)
+ *	  receivers.push_back(std::make_unique<my_receiver>(conn, tenant));
+ *	batch.complete();
+ * @endcode
+ *
+ * Notifications for a channel can only start coming in once the batch is
+ * complete.  There can be only one batch at a time on a connection.
+ */
+class PQXX_LIBEXPORT receiver_batch
+{
+public:
+  explicit receiver_batch(connection &c);
+  receiver_batch(receiver_batch const &) = delete;
+  receiver_batch &operator=(receiver_batch const &) = delete;
+  /// Complete the batch, if that hasn't happened yet.
+  /** A destructor can't throw, so any error just becomes a notice.  Call
+   * @c complete() yourself if you want to know about errors.
+   */
+  ~receiver_batch() noexcept;
+
+  /// Send all the held-back commands, and end the batch.
+  void complete();
+
+private:
+  connection &m_conn;
+  bool m_done = false;
+};
 } // namespace pqxx
 
 #include "pqxx/internal/compiler-internal-post.hxx"
@@ -0,0 +1,179 @@
+/* Definition of the pqxx::notification_dispatcher class.
+ *
+ * pqxx::notification_dispatcher delivers notifications from worker threads.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/notification_dispatcher
+ * instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_NOTIFICATION_DISPATCHER
+#define PQXX_H_NOTIFICATION_DISPATCHER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+
+
+namespace pqxx
+{
+/// Dispatches notifications to handlers, from threads of its own.
+/** @addtogroup notification Notifications and Receivers
+ *
+ * A dispatcher opens a connection of its own, which does nothing but listen.
+ * One thread waits for notifications on that connection.  It groups them
+ * by channel, and hands them to a pool of worker threads, which call your
+ * handlers.
+ *
+ * A handler receives a batch: all the notifications on its channel that
+ * arrived since its last call.  So if a handler is slow, or notifications
+ * come in bursts, it gets called less often, with bigger batches.  Batches
+ * for the same channel never overlap, and arrive in order.  Batches for
+ * different channels may run concurrently.
+ *
+ * Handlers run on the worker threads, so they must be thread-safe.  If a
+ * handler throws an exception, the dispatcher counts it in its
+ * @c statistics, and carries on.
+ *
+ * If the connection fails, the dispatcher stops delivering.  Then
+ * @c stop() re-throws the exception.
+ */
+class PQXX_LIBEXPORT notification_dispatcher
+{
+public:
+  /// One incoming notification.
+  struct notification
+  {
+    /// The channel this notification came in on.
+    std::string channel;
+    /// The payload string, or an empty string if there was none.
+    std::string payload;
+    /// Process ID of the backend that sent the notification.
+    int backend_pid;
+    /// When the dispatcher received the notification.
+    std::chrono::steady_clock::time_point received;
+  };
+
+  /// Handler for a batch of notifications on the same channel.
+  using handler = std::function<void(std::vector<notification> const &)>;
+
+  /// Counters for how the dispatcher is doing.
+  struct statistics
+  {
+    /// Notifications received.
+    std::size_t received = 0;
+    /// Notifications delivered to their handlers.
+    std::size_t delivered = 0;
+    /// Batches delivered.
+    std::size_t batches = 0;
+    /// Handler calls that threw an exception.
+    std::size_t failures = 0;
+    /// Notifications received, but not delivered yet.
+    std::size_t queue_depth = 0;
+    /// Longest time a notification waited for its handler call to start.
+    std::chrono::microseconds max_delay{0};
+    /// Total time notifications waited for their handler calls to start.
+    std::chrono::microseconds total_delay{0};
+  };
+
+  /// Connect, and start the dispatcher's threads.
+  /**
+   * @param options Connection string for the dispatcher's own connection.
+   * @param threads Number of worker threads, or zero to use as many as the
+   *     hardware supports.
+   * @param poll_interval How long the listening thread may block at a time.
+   *     This limits how quickly @c listen() or @c stop() take effect.  It does
+   *     not delay notifications.
+   */
+  explicit notification_dispatcher(
+    std::string const &options, std::size_t threads = 1,
+    std::chrono::milliseconds poll_interval = std::chrono::milliseconds{100});
+  ~notification_dispatcher() noexcept;
+
+  notification_dispatcher(notification_dispatcher const &) = delete;
+  notification_dispatcher &operator=(notification_dispatcher const &) = delete;
+
+  /// Call @c callback with notifications on @c channel.
+  /** Returns once the dispatcher is listening on the channel.  You can add
+   * several handlers for the same channel; each gets every batch.
+   */
+  void listen(std::string_view channel, handler callback);
+
+  /// Snapshot of the dispatcher's counters.
+  [[nodiscard]] statistics stats() const;
+
+  /// Stop listening, and wait for handlers in progress to finish.
+  /** Notifications which have not been delivered yet are dropped.  If the
+   * dispatcher stopped because of an error, this re-throws it.
+   */
+  void stop();
+
+private:
+  class receiver;
+
+  /// A channel's handlers, and its notifications waiting for delivery.
+  struct channel_state
+  {
+    std::vector<handler> handlers;
+    std::vector<notification> pending;
+    /// Is this channel in @c m_ready, or being delivered?
+    bool scheduled = false;
+    /// Has the listening thread executed the LISTEN?
+    bool listening = false;
+  };
+
+  using channel_map = std::map<std::string, channel_state, std::less<>>;
+
+  /// Body of the listening thread.
+  PQXX_PRIVATE void listen_loop();
+  /// Body of a worker thread.
+  PQXX_PRIVATE void work_loop();
+  /// Queue a notification for delivery.  Called by the listening thread.
+  PQXX_PRIVATE void enqueue(channel_map::value_type &, notification &&);
+  /// Tell all threads to stop, and wait for them.
+  PQXX_PRIVATE void halt() noexcept;
+
+  connection m_conn;
+  std::chrono::milliseconds const m_poll_interval;
+
+  mutable std::mutex m_mutex;
+  /// Signals workers that a channel is ready, or that we're stopping.
+  std::condition_variable m_wake_workers;
+  /// Signals @c listen() that a LISTEN has happened, or failed.
+  std::condition_variable m_listened;
+
+  channel_map m_channels;
+  /// Channels the listening thread has yet to LISTEN on.
+  std::vector<channel_map::value_type *> m_new_channels;
+  /// Channels with notifications to deliver, in order of arrival.
+  std::deque<channel_map::value_type *> m_ready;
+  statistics m_stats;
+  bool m_stopping = false;
+  /// Error that stopped the listening thread, if any.
+  std::exception_ptr m_error;
+
+  std::thread m_listener;
+  std::vector<std::thread> m_workers;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
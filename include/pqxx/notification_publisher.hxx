@@ -0,0 +1,103 @@
+/* Definition of the pqxx::notification_publisher class.
+ *
+ * pqxx::notification_publisher sends notifications in batches.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/notification_publisher
+ * instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_NOTIFICATION_PUBLISHER
+#define PQXX_H_NOTIFICATION_PUBLISHER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+
+
+namespace pqxx
+{
+/// When a @c notification_publisher sends what it has collected.
+struct publish_policy
+{
+  /// Send once this many notifications are waiting.  Zero means no limit.
+  std::size_t max_pending = 1000;
+  /// Send once the oldest waiting notification is this old.  Zero means no
+  /// limit.
+  std::chrono::milliseconds max_delay{100};
+};
+
+
+/// Collects notifications, and sends them in batches.
+/** @addtogroup notification Notifications and Receivers
+ *
+ * Sending a notification with a @c NOTIFY statement costs a round trip to
+ * the database.  A publisher collects notifications instead, and sends them
+ * as one batch of @c pg_notify() calls.  When libpq supports pipeline mode,
+ * that batch takes a single round trip.
+ *
+ * The publisher sends what it has when you call @c flush(), or when
+ * @c publish() finds that the @c publish_policy says it's time.  Nothing
+ * happens in the background: if your program goes quiet, the last few
+ * notifications wait until the next @c publish() or @c flush().  The
+ * destructor flushes as well.
+ *
+ * The calls execute on the connection.  If there is a transaction open at
+ * the time, they become part of it, and PostgreSQL delivers the
+ * notifications only when that transaction commits.  Otherwise, each one
+ * goes out right away.
+ *
+ * Do not use the connection for anything else while a flush is in progress.
+ * In particular, the publisher is not thread-safe.
+ */
+class PQXX_LIBEXPORT notification_publisher
+{
+public:
+  explicit notification_publisher(connection &c, publish_policy policy = {});
+  notification_publisher(notification_publisher const &) = delete;
+  notification_publisher &operator=(notification_publisher const &) = delete;
+  /// Flush.  A destructor can't throw, so any error just becomes a notice.
+  ~notification_publisher() noexcept;
+
+  /// Queue a notification on @c channel.  May flush, so may throw.
+  void publish(std::string_view channel, std::string_view payload = {});
+
+  /// Send all waiting notifications.
+  /** If this fails, it throws the error, and drops the notifications it
+   * hadn't sent yet.  Outside a transaction, the ones before the error may
+   * already have gone out.
+   *
+   * @return The number of notifications sent.
+   */
+  std::size_t flush();
+
+  /// Number of notifications waiting to be sent.
+  [[nodiscard]] std::size_t pending() const noexcept
+  {
+    return std::size(m_pending);
+  }
+
+private:
+  connection &m_conn;
+  publish_policy const m_policy;
+  /// Channel and payload for each waiting notification, in order.
+  std::vector<std::pair<std::string, std::string>> m_pending;
+  /// When the oldest waiting notification came in.
+  std::chrono::steady_clock::time_point m_oldest;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,250 @@
+/* Definition of the pqxx::parallel_export class.
+ *
+ * pqxx::parallel_export reads a table over several connections at once.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/parallel_export instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_PARALLEL_EXPORT
+#define PQXX_H_PARALLEL_EXPORT
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <atomic>
+#include <exception>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+#include "pqxx/connection_pool.hxx"
+#include "pqxx/cursor.hxx"
+#include "pqxx/parallel_result.hxx"
+#include "pqxx/stream_from.hxx"
+#include "pqxx/transaction.hxx"
+
+
+namespace pqxx
+{
+/// Read a table in parallel, over several connections.
+/** A single @c stream_from is limited to what one connection and one server
+ * backend can do.  A @c parallel_export splits a table into partitions, and
+ * reads each partition through its own @c stream_from, on its own connection,
+ * in its own thread.
+ *
+ * All partitions see the same, consistent snapshot of the database.  A
+ * "leader" connection exports its snapshot, and each of the partitions'
+ * transactions imports it using @c SET TRANSACTION SNAPSHOT.
+ *
+ * Describe each partition as an SQL condition, as you would write it in a
+ * @c WHERE clause.  Make sure that together, the partitions cover each row in
+ * the table exactly once.  The static functions @c ctid_partitions() and
+ * @c key_partitions() can do this for you.
+ *
+ * This class starts threads, so your program may need to link to a threading
+ * library.  Connections are never shared between threads: each thread works
+ * only on its own connection.  But your consumer function will be called from
+ * the various threads concurrently, and it must be safe for that.
+ */
+class PQXX_LIBEXPORT parallel_export
+{
+public:
+  /// Prepare to export @c table over several connections.
+  /**
+   * @param connection_string Every connection uses this connection string.
+   * @param table The table to export.
+   * @param columns The columns to read, as a comma-separated list.
+   * @param partitions One SQL condition for each partition.
+   */
+  parallel_export(
+    std::string connection_string, std::string_view table,
+    std::string_view columns, std::vector<std::string> partitions);
+
+  /// Number of partitions, and so, the number of connections and threads.
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    return std::size(m_partitions);
+  }
+
+  /// The query that reads partition @c index.
+  [[nodiscard]] std::string partition_query(std::size_t index) const;
+
+  /// Read all partitions, passing each row to @c consume.
+  /** Reads the rows as tuples of @c TYPE....  For each row, calls
+   * @c consume(partition, row), where @c partition is the partition's index
+   * and @c row is a @c std::tuple<TYPE...> const reference.
+   *
+   * Each partition is read in its own thread, so @c consume gets called
+   * concurrently.  Calls for any one partition happen in order, and from the
+   * same thread.
+   *
+   * If anything goes wrong in any of the threads, the others stop as soon as
+   * possible, and once all threads have finished, @c run() re-throws the
+   * first exception.
+   */
+  template<typename... TYPE, typename CONSUMER> void run(CONSUMER &&consume);
+
+  /// Read all partitions through cursors, on connections from a pool.
+  /** Where @c run() streams each partition using @c COPY, this reads each
+   * one through an @c icursorstream, which fetches blocks of @c stride rows
+   * and prefetches the next block while you process the current one.  That
+   * works for any column types, and the blocks are plain results.
+   *
+   * For each block, calls @c consume(partition, block), where @c block is a
+   * @c result const reference.  Up to @c threads worker threads (or as many
+   * as the hardware supports, if you pass zero) take partitions in order, so
+   * having more partitions than threads balances the load.  Each thread
+   * borrows one connection from @c pool for all of its partitions, and one
+   * more connection holds the snapshot which all partitions share.  So the
+   * pool should allow one more connection than there are threads.
+   *
+   * The pool's connections must go to the database holding the table.  This
+   * does not use the connection string you passed to the constructor.
+   *
+   * Errors work as in @c run().
+   */
+  template<typename CONSUMER>
+  void scan(
+    connection_pool &pool, CONSUMER &&consume,
+    cursor_base::difference_type stride = 1000, std::size_t threads = 0);
+
+  /// Partition a table into @c count ranges of physical row locations.
+  /** Splits the table into ranges of pages, using the row's @c ctid, based on
+   * the table's current size.  The first and last partitions are open-ended,
+   * so that rows in pages added since are not lost.
+   *
+   * On PostgreSQL 14 and up, the server can read just the pages in the range.
+   * Older versions read through the whole table for each partition, and may
+   * make this slower than a plain @c stream_from.
+   */
+  [[nodiscard]] static std::vector<std::string> ctid_partitions(
+    transaction_base &, std::string_view table, std::size_t count);
+
+  /// Partition a table into ranges of a key.
+  /** Each value in @c bounds is the boundary between one partition and the
+   * next, so you get one more partition than you pass bounds.  The bounds
+   * must be in ascending order.  The key is an SQL expression, such as a
+   * column name.  Rows where it is null are in the last partition.
+   */
+  [[nodiscard]] static std::vector<std::string> key_partitions(
+    transaction_base &, std::string_view key,
+    std::vector<std::string> const &bounds);
+
+private:
+  using read_tx =
+    transaction<isolation_level::repeatable_read, write_policy::read_only>;
+
+  /// Export the leader transaction's snapshot.  Returns its identifier.
+  static std::string export_snapshot(transaction_base &);
+  /// Make a transaction use an exported snapshot.
+  static void import_snapshot(transaction_base &, std::string const &);
+
+  std::string m_connection_string;
+  std::string m_table;
+  std::string m_columns;
+  std::vector<std::string> m_partitions;
+};
+
+
+template<typename... TYPE, typename CONSUMER>
+inline void parallel_export::run(CONSUMER &&consume)
+{
+  connection leader{m_connection_string};
+  read_tx leader_tx{leader};
+  auto const snapshot{export_snapshot(leader_tx)};
+
+  auto const count{size()};
+  std::vector<std::exception_ptr> errors(count);
+  std::atomic<bool> stop{false};
+
+  auto const export_partition{[&](std::size_t partition) {
+    try
+    {
+      connection conn{m_connection_string};
+      read_tx tx{conn};
+      import_snapshot(tx, snapshot);
+      auto stream{stream_from::query(tx, partition_query(partition))};
+      for (auto const &row : stream.iter<TYPE...>())
+      {
+        if (stop.load(std::memory_order_relaxed))
+          return;
+        consume(partition, row);
+      }
+      tx.commit();
+    }
+    catch (...)
+    {
+      errors[partition] = std::current_exception();
+      stop = true;
+    }
+  }};
+
+  std::vector<std::thread> threads;
+  threads.reserve(count);
+  try
+  {
+    for (std::size_t partition{0}; partition < count; ++partition)
+      threads.emplace_back(export_partition, partition);
+  }
+  catch (...)
+  {
+    stop = true;
+    for (auto &thread : threads) thread.join();
+    throw;
+  }
+  for (auto &thread : threads) thread.join();
+
+  for (auto const &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+  leader_tx.commit();
+}
+
+
+template<typename CONSUMER>
+inline void parallel_export::scan(
+  connection_pool &pool, CONSUMER &&consume,
+  cursor_base::difference_type stride, std::size_t threads)
+{
+  auto leader{pool.get()};
+  read_tx leader_tx{*leader};
+  auto const snapshot{export_snapshot(leader_tx)};
+
+  auto const count{size()};
+  // Partitions are handed out in order, to whichever thread is free.
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> stop{false};
+  internal::run_chunks(
+    internal::parallel_threads(static_cast<result_size_type>(count), threads),
+    stop, [&](std::size_t) {
+      auto conn{pool.get()};
+      for (auto partition{next++}; partition < count and not stop.load();
+           partition = next++)
+      {
+        read_tx tx{*conn};
+        import_snapshot(tx, snapshot);
+        {
+          icursorstream stream{
+            tx, partition_query(partition), "scan", stride};
+          stream.set_prefetch();
+          result block;
+          while (not stop.load(std::memory_order_relaxed) and
+                 (stream >> block, not block.empty()))
+            consume(partition, std::as_const(block));
+        }
+        tx.commit();
+      }
+    });
+  leader_tx.commit();
+}
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,284 @@
+/* Definition of the pqxx::parallel_load class.
+ *
+ * pqxx::parallel_load writes rows to a table over several connections at once.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/parallel_load instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_PARALLEL_LOAD
+#define PQXX_H_PARALLEL_LOAD
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+#include "pqxx/internal/spsc_queue.hxx"
+#include "pqxx/stream_to.hxx"
+#include "pqxx/transaction.hxx"
+
+
+namespace pqxx
+{
+/// When should a @c parallel_load commit its connections' transactions?
+enum class commit_policy
+{
+  /// Commit all transactions at the end, but only if all of them succeeded.
+  /** This is not an atomic commit: if one of the commits fails, the ones
+   * before it will still have happened.  But errors while writing the data
+   * are much more likely, and those will cancel all transactions.
+   */
+  together,
+
+  /// Each connection commits as soon as it is done, regardless of the others.
+  /** Use this for loads that you can safely repeat, e.g. because each
+   * connection writes a distinct partition of the data, or because the table
+   * ignores duplicates.
+   */
+  per_connection,
+};
+
+
+/// Write rows to a table in parallel, over several connections.
+/** A single @c stream_to is limited to what one connection and one server
+ * backend can do.  A @c parallel_load spreads the rows over several
+ * @c stream_to streams, each on its own connection, and each served by its
+ * own thread.
+ *
+ * You insert rows from one thread, and they go into a bounded queue for one
+ * of the connections.  If that queue is full, the insertion sleeps until it
+ * drains.  A connection with nothing to do sleeps, too.  So a slow database
+ * holds back your producer, instead of letting the queues consume ever more
+ * memory.
+ *
+ * If anything goes wrong in any of the connections, the next insertion (or
+ * the call to @c complete()) stops all the threads, and re-throws the error.
+ *
+ * Each row is a @c std::tuple<TYPE...>.  All @c TYPE must be
+ * default-constructible.  This class starts threads, so your program may need
+ * to link to a threading library.
+ */
+template<typename... TYPE> class parallel_load
+{
+public:
+  using row_type = std::tuple<TYPE...>;
+
+  /// Start a parallel load into @c table.
+  /**
+   * @param connection_string Every connection uses this connection string.
+   * @param table The table to write to.
+   * @param columns The columns to write; empty means "all, in order."
+   * @param connections Number of connections (and threads) to use.
+   * @param policy When to commit: see @c commit_policy.
+   * @param queue_size How many rows each connection's queue can hold.
+   */
+  parallel_load(
+    std::string const &connection_string, std::string_view table,
+    std::vector<std::string> const &columns, std::size_t connections,
+    commit_policy policy = commit_policy::together,
+    std::size_t queue_size = 1024) :
+          m_policy{policy}
+  {
+    if (connections == 0)
+      throw usage_error{"A parallel_load needs at least one connection."};
+    if (queue_size == 0)
+      throw usage_error{"A parallel_load needs room in its queues."};
+    m_lanes.reserve(connections);
+    for (std::size_t i{0}; i < connections; ++i)
+      m_lanes.push_back(std::make_unique<lane>(
+        connection_string, table, columns, queue_size));
+    try
+    {
+      for (auto &l : m_lanes)
+      {
+        lane *const raw{l.get()};
+        l->thread = std::thread{[this, raw] { drain(*raw); }};
+      }
+    }
+    catch (...)
+    {
+      stop();
+      throw;
+    }
+  }
+
+  parallel_load(parallel_load const &) = delete;
+  parallel_load &operator=(parallel_load const &) = delete;
+
+  /// Abandon the load, if it has not completed.  Nothing gets committed.
+  /** Except of course with @c commit_policy::per_connection, where any
+   * connections that have already finished will have committed.
+   */
+  ~parallel_load() noexcept { stop(); }
+
+  /// Insert a row.  Goes to the connections in turn.
+  parallel_load &operator<<(row_type row)
+  {
+    insert(m_next, std::move(row));
+    m_next = (m_next + 1 == std::size(m_lanes)) ? 0 : m_next + 1;
+    return *this;
+  }
+
+  /// Insert a row through the given connection, e.g. to partition the data.
+  void insert(std::size_t connection, row_type row)
+  {
+    if (m_finished)
+      throw usage_error{"Inserting into a parallel_load that has finished."};
+    check_failures();
+    auto &l{*m_lanes.at(connection)};
+    if (not l.queue.push(
+          row, [this] { return m_failed.load(std::memory_order_acquire); }))
+      check_failures();
+  }
+
+  /// Number of connections.
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    return std::size(m_lanes);
+  }
+
+  /// Finish writing, wait for all connections, and commit.
+  /** Re-throws the first error from any of the connections, if there was
+   * one.  In that case, nothing gets committed (except, with
+   * @c commit_policy::per_connection, the connections that finished).
+   */
+  void complete()
+  {
+    if (m_finished)
+      return;
+    m_closed = true;
+    wake_all();
+    join();
+    m_finished = true;
+    rethrow_failure();
+    if (m_policy == commit_policy::together)
+      for (auto &l : m_lanes) l->tx.commit();
+  }
+
+private:
+  /// One connection, with its stream, its queue, and its thread.
+  struct lane
+  {
+    lane(
+      std::string const &connection_string, std::string_view table,
+      std::vector<std::string> const &columns, std::size_t queue_size) :
+            conn{connection_string},
+            tx{conn},
+            stream{make_stream(tx, table, columns)},
+            queue{queue_size}
+    {}
+
+    static stream_to make_stream(
+      transaction_base &t, std::string_view table,
+      std::vector<std::string> const &columns)
+    {
+      if (columns.empty())
+        return stream_to{t, table};
+      else
+        return stream_to{t, table, columns};
+    }
+
+    connection conn;
+    work tx;
+    stream_to stream;
+    internal::spsc_queue<row_type> queue;
+    std::thread thread;
+    std::exception_ptr error;
+  };
+
+  /// Thread body: write rows from a lane's queue to its stream.
+  void drain(lane &l) noexcept
+  {
+    try
+    {
+      auto const done{[this] {
+        return m_stop.load(std::memory_order_acquire) or
+               m_closed.load(std::memory_order_acquire);
+      }};
+      row_type row;
+      // Once the producer has closed, this still takes any rows it pushed
+      // before that.  It only gives up when the queue is empty.
+      while (l.queue.pop(row, done))
+      {
+        if (m_stop.load(std::memory_order_acquire))
+          return;
+        l.stream << row;
+      }
+      if (m_stop.load(std::memory_order_acquire))
+        return;
+      l.stream.complete();
+      if (m_policy == commit_policy::per_connection)
+        l.tx.commit();
+    }
+    catch (...)
+    {
+      l.error = std::current_exception();
+      m_failed.store(true, std::memory_order_release);
+      // The producer may be waiting for room in any of the queues.
+      wake_all();
+    }
+  }
+
+  /// If any connection failed, stop everything and re-throw its error.
+  void check_failures()
+  {
+    if (m_failed.load(std::memory_order_acquire))
+    {
+      stop();
+      rethrow_failure();
+    }
+  }
+
+  void rethrow_failure()
+  {
+    for (auto &l : m_lanes)
+      if (l->error)
+        std::rethrow_exception(l->error);
+  }
+
+  /// Make all threads stop, and wait for them.
+  void stop() noexcept
+  {
+    m_stop = true;
+    wake_all();
+    join();
+    m_finished = true;
+  }
+
+  /// Wake any threads sleeping on the queues, to look at our flags.
+  void wake_all() noexcept
+  {
+    for (auto &l : m_lanes) l->queue.wake();
+  }
+
+  void join() noexcept
+  {
+    for (auto &l : m_lanes)
+      if (l->thread.joinable())
+        l->thread.join();
+  }
+
+  commit_policy const m_policy;
+  std::vector<std::unique_ptr<lane>> m_lanes;
+  std::size_t m_next = 0;
+  bool m_finished = false;
+  std::atomic<bool> m_closed{false};
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_failed{false};
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,136 @@
+/* Running many retryable transactions at once, on pooled connections.
+ *
+ * This is the transactor framework, spread over several threads.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/parallel_perform instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_PARALLEL_PERFORM
+#define PQXX_H_PARALLEL_PERFORM
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "pqxx/connection_pool.hxx"
+#include "pqxx/parallel_result.hxx"
+#include "pqxx/transactor.hxx"
+
+
+namespace pqxx
+{
+/// What became of one of the callbacks that you passed to @c perform_all.
+/** If the callback succeeded, possibly after retries, @c value holds what it
+ * returned.  If it failed for good, @c error holds the exception.
+ */
+template<typename RESULT> struct perform_outcome
+{
+  std::optional<RESULT> value;
+  std::exception_ptr error;
+
+  /// Did the callback succeed?
+  [[nodiscard]] bool ok() const noexcept { return not error; }
+};
+
+
+/// What became of a @c perform_all callback that returns nothing.
+template<> struct perform_outcome<void>
+{
+  std::exception_ptr error;
+
+  /// Did the callback succeed?
+  [[nodiscard]] bool ok() const noexcept { return not error; }
+};
+
+
+/// Run many independent transactions at once, on connections from a pool.
+/** Calls each of @c callbacks as a transactor: each takes a @c connection
+ * reference, opens a transaction on it, does its work, and commits.  Like
+ * @c perform, this retries a callback when it fails for transient reasons,
+ * such as a serialization failure or a lost connection, according to
+ * @c policy.
+ *
+ * The work runs in several threads, each with a connection of its own from
+ * @c pool, borrowed at batch priority.  A thread that finishes a callback
+ * takes the next one that nobody has started yet, so one slow transaction
+ * does not hold up the others.  If a callback breaks the thread's
+ * connection, the thread borrows a fresh one for its next attempt.
+ *
+ * One callback failing does not stop the others.  Instead of throwing, this
+ * returns an outcome for each callback, in the same order, holding either
+ * its return value or its exception.
+ *
+ * The callbacks run concurrently, so they must be safe for that.  So must
+ * the policy's @c on_retry callback.
+ *
+ * @param pool Where to get the connections.
+ * @param callbacks A random-access range, such as a @c std::vector, of
+ *     callables which take a @c connection reference.
+ * @param threads Number of threads to use, or zero to use as many as the
+ *     hardware supports.  There won't be more threads than callbacks, nor
+ *     should there be more than the pool's maximum size.
+ * @param policy How to retry failed transactions.
+ */
+template<typename CALLBACKS>
+inline auto perform_all(
+  connection_pool &pool, CALLBACKS const &callbacks, std::size_t threads = 0,
+  retry_policy const &policy = {})
+{
+  using callback_type = decltype(*std::begin(callbacks));
+  using result_type = std::invoke_result_t<callback_type, connection &>;
+
+  auto const count{std::size(callbacks)};
+  std::vector<perform_outcome<result_type>> outcomes(count);
+  if (count == 0)
+    return outcomes;
+
+  std::atomic<std::size_t> next{0};
+  // Failures stay with their callbacks, so nothing ever sets this.
+  std::atomic<bool> stop{false};
+  internal::run_chunks(
+    internal::parallel_threads(
+      check_cast<result_size_type>(count, "transactions"), threads),
+    stop, [&](std::size_t) {
+      std::optional<pooled_connection> conn;
+      for (auto index{next++}; index < count; index = next++)
+      {
+        auto const &callback{std::begin(callbacks)[index]};
+        auto const attempt{[&pool, &conn, &callback] {
+          if (not conn or not(*conn)->is_open())
+          {
+            conn.reset();
+            conn.emplace(pool.get(pool_priority::batch));
+          }
+          return callback(**conn);
+        }};
+        auto &outcome{outcomes[index]};
+        try
+        {
+          if constexpr (std::is_void_v<result_type>)
+            perform(attempt, policy);
+          else
+            outcome.value.emplace(perform(attempt, policy));
+        }
+        catch (...)
+        {
+          outcome.error = std::current_exception();
+        }
+      }
+    });
+  return outcomes;
+}
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,182 @@
+/* Helpers for processing a result's rows in several threads at once.
+ *
+ * These split a result into ranges of rows, and work on each in its own
+ * thread.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/parallel_result instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_PARALLEL_RESULT
+#define PQXX_H_PARALLEL_RESULT
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pqxx/result.hxx"
+#include "pqxx/row.hxx"
+
+
+namespace pqxx::internal
+{
+/// How many threads should work on @c rows rows?
+/** If @c threads is zero, uses the number of hardware threads.  Never more
+ * threads than rows, and never fewer than one.
+ */
+inline std::size_t
+parallel_threads(result_size_type rows, std::size_t threads) noexcept
+{
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  return std::max(
+    std::size_t{1},
+    std::min(threads, static_cast<std::size_t>(std::max(rows, 0))));
+}
+
+
+/// First row in chunk @c chunk, when splitting @c rows rows into @c chunks.
+inline result_size_type chunk_begin(
+  result_size_type rows, std::size_t chunks, std::size_t chunk) noexcept
+{
+  return static_cast<result_size_type>(
+    (static_cast<std::size_t>(rows) * chunk) / chunks);
+}
+
+
+/// Call @c work(chunk) for each chunk in [0, @c chunks), each in a thread.
+/** Once any call throws an exception, sets @c stop.  When all threads have
+ * finished, re-throws the first exception.
+ */
+template<typename WORK>
+inline void
+run_chunks(std::size_t chunks, std::atomic<bool> &stop, WORK const &work)
+{
+  std::vector<std::exception_ptr> errors(chunks);
+  auto const run{[&](std::size_t chunk) {
+    try
+    {
+      work(chunk);
+    }
+    catch (...)
+    {
+      errors[chunk] = std::current_exception();
+      stop = true;
+    }
+  }};
+
+  // The calling thread takes the first chunk itself.
+  std::vector<std::thread> threads;
+  threads.reserve(chunks - 1);
+  try
+  {
+    for (std::size_t chunk{1}; chunk < chunks; ++chunk)
+      threads.emplace_back(run, chunk);
+  }
+  catch (...)
+  {
+    stop = true;
+    for (auto &thread : threads) thread.join();
+    throw;
+  }
+  run(0);
+  for (auto &thread : threads) thread.join();
+
+  for (auto const &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Call @c func on each of a result's rows, from several threads at once.
+/** Splits the result into ranges of adjacent rows, one per thread, and calls
+ * @c func(row) for each row, where @c row is a @c row_ref.  Calls for rows in
+ * the same range happen in order, and from the same thread.  But calls for
+ * different ranges happen concurrently, so @c func must be safe for that.
+ *
+ * The threads share the result without copying it: a @c row_ref does not
+ * touch the result's reference count.  So keep the result alive and
+ * unchanged until this returns.
+ *
+ * @param res The result whose rows you want to process.
+ * @param func Callback, taking a @c row_ref.
+ * @param threads Number of threads to use, or zero to use as many as the
+ *     hardware supports.  There won't be more threads than rows.
+ *
+ * If @c func throws an exception, the other threads stop as soon as possible,
+ * and once they have all finished, this re-throws the first exception.
+ */
+template<typename FUNC>
+inline void
+parallel_for_each_row(result const &res, FUNC &&func, std::size_t threads = 0)
+{
+  auto const rows{res.size()};
+  auto const chunks{internal::parallel_threads(rows, threads)};
+  std::atomic<bool> stop{false};
+  internal::run_chunks(chunks, stop, [&](std::size_t chunk) {
+    auto const end{internal::chunk_begin(rows, chunks, chunk + 1)};
+    for (auto row{internal::chunk_begin(rows, chunks, chunk)};
+         (row < end) and not stop.load(std::memory_order_relaxed); ++row)
+      func(row_ref{res, row});
+  });
+}
+
+
+/// Convert each of a result's rows, in several threads at once.
+/** Like @c parallel_for_each_row, but collects what @c func returns for each
+ * row.  Returns a vector with one element for each row, in the same order as
+ * the rows.  The element type need not be default-constructible.
+ *
+ * @code
+ *	auto const totals{pqxx::parallel_transform(res, [](pqxx::row_ref row) {
+ *	  auto const [price, count]{row.as<double, int>()};
+ *	  return price * count;
+ *	})};
+ * @endcode
+ */
+template<typename FUNC>
+[[nodiscard]] inline std::vector<std::invoke_result_t<FUNC &, row_ref>>
+parallel_transform(result const &res, FUNC &&func, std::size_t threads = 0)
+{
+  using value_type = std::invoke_result_t<FUNC &, row_ref>;
+  auto const rows{res.size()};
+  auto const chunks{internal::parallel_threads(rows, threads)};
+  std::vector<std::vector<value_type>> parts(chunks);
+  std::atomic<bool> stop{false};
+  internal::run_chunks(chunks, stop, [&](std::size_t chunk) {
+    auto const begin{internal::chunk_begin(rows, chunks, chunk)},
+      end{internal::chunk_begin(rows, chunks, chunk + 1)};
+    auto &part{parts[chunk]};
+    part.reserve(static_cast<std::size_t>(end - begin));
+    for (auto row{begin};
+         (row < end) and not stop.load(std::memory_order_relaxed); ++row)
+      part.push_back(func(row_ref{res, row}));
+  });
+
+  if (chunks == 1)
+    return std::move(parts[0]);
+  std::vector<value_type> out;
+  out.reserve(static_cast<std::size_t>(rows));
+  for (auto &part : parts)
+    std::move(std::begin(part), std::end(part), std::back_inserter(out));
+  return out;
+}
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -16,15 +16,42 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
 #include <limits>
-#include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
+#include "pqxx/internal/statement_parameters.hxx"
 #include "pqxx/transaction_base.hxx"
 
 
 namespace pqxx
 {
+/// Adaptive batching policy for a @c pipeline.
+/** Instead of retaining a fixed number of queries, a pipeline can decide when
+ * to issue them based on how much data is waiting, and on how long the server
+ * takes to respond.  See @c pipeline::retain(pipeline_batching const &).
+ */
+struct pipeline_batching
+{
+  /// Issue retained queries once their text and parameters reach this size.
+  std::size_t max_bytes = 64 * 1024;
+
+  /// Most queries the pipeline may have in flight at any time.
+  /** A query is in flight once it has been issued, until its result comes in.
+   * When the limit is reached, inserting another query waits for results to
+   * come in.  Zero means no limit.
+   */
+  int max_in_flight = 0;
+};
+
+
 /// Processes several queries in FIFO manner, optimized for high throughput.
 /** Use a pipeline if you want to keep doing useful work while your queries are
  * executing.  Result retrieval is decoupled from execution request; queries
@@ -38,12 +65,22 @@ namespace pqxx
  * Generally, if any of the queries fails, it will throw an exception at the
  * point where you request its result.  But it may happen earlier, especially
  * if you request results out of chronological order.
+ *
+ * When libpqxx is built against libpq 14 or better, the pipeline uses libpq's
+ * native "pipeline mode."  Each query then goes to the server as a separate
+ * statement, without being glued into one big string first, and new batches
+ * can go out while results from earlier ones are still coming in.  With older
+ * libpq versions, the pipeline falls back to sending each batch as a single
+ * multi-statement query string.
  */
 class PQXX_LIBEXPORT pipeline : public internal::transactionfocus
 {
 public:
   using query_id = long;
 
+  /// Callback that receives a query's result.
+  using result_callback = std::function<void(query_id, result const &)>;
+
   pipeline(pipeline const &) = delete;
   pipeline &operator=(pipeline const &) = delete;
 
@@ -75,14 +112,71 @@ public:
   ~pipeline() noexcept;
 
   /// Add query to the pipeline.
-  /** Queries accumulate in the pipeline, which sends them to the backend in a
-   * batch separated by semicolons.  The queries you insert must not use this
-   * trick themselves, or the pipeline will get hopelessly confused!
+  /** Queries accumulate in the pipeline, which sends them to the backend in
+   * batches.  Each query you insert must be a single SQL statement.  Don't
+   * combine multiple statements in one query string using semicolons, or the
+   * pipeline will get hopelessly confused!
    *
    * @return Identifier for this query, unique only within this pipeline.
    */
   query_id insert(std::string_view);
 
+  /// Add query to the pipeline, and have its result passed to a callback.
+  /** Equivalent to @c insert() followed by @c on_result().
+   *
+   * @return Identifier for this query, unique only within this pipeline.
+   */
+  query_id insert(std::string_view, result_callback);
+
+  /// Add a query whose result you don't need.
+  /** The pipeline drops the result as soon as it comes in, so it takes up no
+   * memory, and you can't @c retrieve() it.  If the query fails, the error
+   * comes out of the pipeline call that received it, as with @c on_result().
+   *
+   * @return Identifier for this query, unique only within this pipeline.
+   */
+  query_id insert_discard(std::string_view);
+
+  /// Add a parameterised query to the pipeline.
+  /** Works like @c transaction_base::exec_params, except the query goes into
+   * the pipeline.  Its parameters are converted to strings right away, so
+   * they need not stay alive until the query executes.
+   *
+   * When libpq has no pipeline mode, a parameterised query can't be combined
+   * with other queries in one batch.  It will still work, but it will go out
+   * to the server on its own.
+   *
+   * @return Identifier for this query, unique only within this pipeline.
+   */
+  template<typename... Args>
+  query_id insert_params(std::string_view query, Args &&... args)
+  {
+    auto parameters{
+      std::make_shared<internal::params>(std::forward<Args>(args)...)};
+    parameters->own();
+    return insert_query(Query{query, std::move(parameters), false});
+  }
+
+  /// Add an invocation of a prepared statement to the pipeline.
+  /** Works like @c transaction_base::exec_prepared, except the statement goes
+   * into the pipeline.  Its parameters are converted to strings right away,
+   * so they need not stay alive until the statement executes.
+   *
+   * Prepare the statement before you start inserting queries into the
+   * pipeline.  While the pipeline is active, the connection can't execute
+   * anything else, including the preparation of statements.
+   *
+   * @return Identifier for this query, unique only within this pipeline.
+   */
+  template<typename... Args>
+  query_id insert_prepared(std::string_view statement, Args &&... args)
+  {
+    auto parameters{
+      std::make_shared<internal::params>(std::forward<Args>(args)...)};
+    parameters->own();
+    return insert_query(Query{statement, std::move(parameters), true});
+  }
+
   /// Wait for all ongoing or pending operations to complete, and detach.
   /** Detaches from the transaction when done.
    *
@@ -127,9 +221,43 @@ public:
    */
   result retrieve(query_id qid)
   {
-    return retrieve(m_queries.find(qid)).second;
+    return retrieve(qid, m_queries.find(qid)).second;
   }
 
+  /// Have the given query's result passed to a callback once it comes in.
+  /** Use this instead of @c retrieve() when you'd rather not poll for the
+   * result.  The callback runs as soon as the pipeline sees the result, from
+   * inside the call to @c insert(), @c resume(), or @c complete() during
+   * which it arrived.  If the result is already in, the callback runs right
+   * away.
+   *
+   * The callback may insert more queries into the pipeline.  The query's
+   * result is no longer available to @c retrieve() after the callback has
+   * run.
+   *
+   * If the query fails, the callback does not run.  Instead the error is
+   * thrown from the pipeline call that found it, just like @c retrieve()
+   * would throw it.  If you retrieve the result yourself before the callback
+   * runs, or the query gets cancelled or flushed, the callback never runs.
+   */
+  void on_result(query_id, result_callback);
+
+  /// Get a @c std::future for the given query's result.
+  /** The future becomes ready once the pipeline has seen the query's result.
+   * Waiting for the future does not make that happen; the pipeline only
+   * receives results during calls such as @c insert(), @c resume(), and
+   * @c complete().  So call @c complete() (or @c retrieve() an earlier
+   * query) before you wait for a future.
+   *
+   * If the query fails, the future holds the exception.  If the query is
+   * cancelled or flushed, or the pipeline is destroyed before the result
+   * comes in, the future gets a @c std::future_error.
+   *
+   * The query's result is no longer available to @c retrieve() after the
+   * future has received it.
+   */
+  [[nodiscard]] std::future<result> get_future(query_id);
+
   /// Retrieve oldest unretrieved result (possibly wait for one).
   /** @return The query's identifier and its result set. */
   std::pair<query_id, result> retrieve();
@@ -151,11 +279,117 @@ public:
    */
   int retain(int retain_max = 2);
 
+  /// Let the pipeline decide adaptively when to issue queries.
+  /** Retained queries get issued when:
+   * - the pipeline has no queries in flight, so the server would go idle; or
+   * - the retained queries' text and parameters add up to
+   *   @c pipeline_batching::max_bytes or more; or
+   * - the oldest retained query has waited longer than the round-trip time
+   *   measured on earlier batches.
+   *
+   * So while a slow batch is underway, more queries accumulate for the next
+   * one.  The pipeline only checks these conditions when you insert a query,
+   * or call @c resume().
+   *
+   * If issuing would put more than @c pipeline_batching::max_in_flight queries
+   * in flight, the pipeline first waits for results to come in.
+   *
+   * Calling @c retain(int) switches back to a fixed retention count.
+   */
+  void retain(pipeline_batching const &);
+
+  /// Don't wait for the socket when issuing queries.
+  /** Normally, issuing a batch of queries waits until the socket has taken
+   * all of them.  With a big batch, that can mean waiting for the server to
+   * work its way through the earlier queries.  In non-blocking mode, libpq
+   * queues up whatever the socket won't take yet, and sends it while the
+   * pipeline is receiving results.  So you can go on inserting queries in
+   * the meantime.
+   *
+   * The connection is in non-blocking mode only while the pipeline is
+   * active.  Once the pipeline completes, it goes back to normal.
+   */
+  void set_nonblocking(bool enable = true);
+
+  /// Is this pipeline in non-blocking mode?
+  [[nodiscard]] bool nonblocking() const noexcept { return m_nonblocking; }
+
+  /// Drop the results of all queries that you insert from now on.
+  /** Works like @c insert_discard(), but for every query, including those
+   * from @c insert_params() and @c insert_prepared().  This is for pipelines
+   * that only write: memory use stays flat, no matter how many queries go
+   * through.
+   *
+   * You can still set a callback or get a future for a query.  Those take
+   * the place of the discarding.
+   */
+  void discard_results(bool enable = true) noexcept { m_discard = enable; }
+
+  /// Does this pipeline drop the results of new queries?
+  [[nodiscard]] bool discarding_results() const noexcept { return m_discard; }
+
+  /// Smoothed round-trip time measured on earlier batches.
+  /** Zero until the first measurement comes in. */
+  [[nodiscard]] std::chrono::steady_clock::duration round_trip() const noexcept
+  {
+    return m_rtt;
+  }
+
 
   /// Resume retained query emission.  Harmless when not needed.
   void resume();
 
+  /**
+   * @name Resubmission
+   *
+   * If the connection breaks while queries are in flight, the pipeline can
+   * reconnect and carry on where it left off.  Queries that had not gone out
+   * yet are no problem.  Queries that were in flight may or may not have
+   * executed on the server, and there is no way to find out.  Those that you
+   * marked as idempotent go out again, in their original order and with their
+   * original ids.  The others are "in doubt:" retrieving their results throws
+   * @c in_doubt_error, and @c in_doubt() lists them.
+   *
+   * This only works in a @c nontransaction, where each query commits on its
+   * own.  In any other transaction, a broken connection also takes down the
+   * transaction, and anything that went before in it.
+   *
+   * The connection restores its session state, as with
+   * @c connection::reconnect().
+   */
+  //@{
+  /// Reconnect and resubmit queries after the connection breaks.
+  /** @throw usage_error If the pipeline is not in a @c nontransaction.
+   * @throw feature_not_supported If libpq has no pipeline mode.
+   */
+  void set_resubmit(bool enable = true);
+
+  /// Does this pipeline reconnect and resubmit after connection loss?
+  [[nodiscard]] bool resubmit_enabled() const noexcept { return m_resubmit; }
+
+  /// Mark a query as safe to execute more than once.
+  /** A query is idempotent if executing it twice has the same effect as
+   * executing it once.  A @c SELECT without side effects is idempotent, and
+   * so is an @c UPDATE that sets a column to a fixed value.  An @c INSERT or
+   * an increment generally is not.
+   */
+  void mark_idempotent(query_id);
+
+  /// Queries which were in flight when the connection broke.
+  /** They were not idempotent, so the pipeline did not resubmit them.  They
+   * may or may not have executed.
+   */
+  [[nodiscard]] std::vector<query_id> const &in_doubt() const noexcept
+  {
+    return m_in_doubt;
+  }
+  //@}
+
 private:
+  /// Receiver for a query's result, or the reason why it failed.
+  using handler =
+    std::function<void(query_id, result const &, std::exception_ptr)>;
+
   class PQXX_PRIVATE Query
   {
   public:
@@ -164,16 +398,123 @@ private:
             m_res{}
     {}
 
+    /// A parameterised query, or an invocation of a prepared statement.
+    /** For a prepared statement, @c q is the statement's name.
+     */
+    Query(
+      std::string_view q, std::shared_ptr<internal::params const> args,
+      bool prepared) :
+            m_query{std::make_shared<std::string>(q)},
+            m_params{std::move(args)},
+            m_res{},
+            m_prepared{prepared}
+    {}
+
     result const &get_result() const noexcept { return m_res; }
     void set_result(result const &r) noexcept { m_res = r; }
     std::shared_ptr<std::string> get_query() const noexcept { return m_query; }
 
+    /// Statement parameters, or null for a plain SQL query.
+    internal::params const *get_params() const noexcept
+    {
+      return m_params.get();
+    }
+
+    /// Is this an invocation of a prepared statement?
+    bool is_prepared() const noexcept { return m_prepared; }
+
+    /// Number of bytes of query text and parameters.
+    std::size_t size() const noexcept
+    {
+      std::size_t total{std::size(*m_query)};
+      if (m_params != nullptr)
+        for (auto const len : m_params->lengths)
+          total += static_cast<std::size_t>(len);
+      return total;
+    }
+
+    /// Whoever is waiting for the result, if anyone.
+    handler &get_handler() noexcept { return m_handler; }
+    void set_handler(handler &&h) { m_handler = std::move(h); }
+
+    /// Is this query safe to resubmit?
+    bool is_idempotent() const noexcept { return m_idempotent; }
+    void set_idempotent() noexcept { m_idempotent = true; }
+
+    /// Was this query in flight when the connection broke?
+    bool is_in_doubt() const noexcept { return m_in_doubt; }
+    void set_in_doubt() noexcept { m_in_doubt = true; }
+
   private:
     std::shared_ptr<std::string> m_query;
+    std::shared_ptr<internal::params const> m_params;
     result m_res;
+    handler m_handler;
+    bool m_prepared = false;
+    bool m_idempotent = false;
+    bool m_in_doubt = false;
   };
 
-  using QueryMap = std::map<query_id, Query>;
+  /// The pipeline's queries, in a ring buffer indexed by query id.
+  /** Query ids are handed out in strictly increasing order, so the queries
+   * form a contiguous range of ids.  This keeps them in a circular array,
+   * which only allocates when it needs to grow.
+   *
+   * A query's slot stays in place after its result has been retrieved, but
+   * it becomes empty.  Empty slots at the front of the range get recycled.
+   */
+  class PQXX_PRIVATE QueryRing
+  {
+  public:
+    /// Is the ring without any queries?
+    bool empty() const noexcept { return m_size == 0; }
+
+    /// Id of the oldest query in the ring.
+    query_id begin_id() const noexcept { return m_base; }
+    /// Id one past that of the newest query in the ring.
+    query_id end_id() const noexcept
+    {
+      return m_base + static_cast<query_id>(m_size);
+    }
+
+    /// Look up query by id.  Returns null if there is no such query.
+    Query *find(query_id) noexcept;
+
+    /// Is there a query with this id?
+    bool contains(query_id) const noexcept;
+
+    /// Access query by id.  The query must exist.
+    Query &at(query_id qid) noexcept { return *slot(qid); }
+
+    /// Add a query.  Its id must be @c end_id().
+    void push_back(query_id, Query &&);
+
+    /// Remove a query.
+    void erase(query_id) noexcept;
+
+    /// Remove all queries.
+    void clear() noexcept;
+
+  private:
+    std::size_t index(query_id qid) const noexcept
+    {
+      auto const offset{static_cast<std::size_t>(qid - m_base)};
+      return (m_head + offset) & (m_slots.size() - 1);
+    }
+    std::optional<Query> &slot(query_id qid) noexcept
+    {
+      return m_slots[index(qid)];
+    }
+
+    /// Circular array; its size is zero or a power of two.
+    std::vector<std::optional<Query>> m_slots;
+    /// Index of the oldest query's slot.
+    std::size_t m_head = 0;
+    /// Number of slots in use, counting from the oldest query.
+    std::size_t m_size = 0;
+    /// Id of the oldest query.
+    query_id m_base = 1;
+  };
 
   void init();
   void attach();
@@ -192,11 +533,38 @@ private:
   /// Create new query_id
   PQXX_PRIVATE query_id generate_id();
 
+  /// Add a query to the pipeline.
+  query_id insert_query(Query &&);
+
   bool have_pending() const noexcept
   {
     return m_issuedrange.second != m_issuedrange.first;
   }
 
+  /// Number of queries issued whose results have not come in yet.
+  query_id in_flight() const noexcept
+  {
+    return m_issuedrange.second - m_issuedrange.first;
+  }
+
+  /// In adaptive batching mode: is it time to issue retained queries?
+  PQXX_PRIVATE bool want_issue() const;
+
+  /// In adaptive batching mode: wait for results to keep within limits.
+  PQXX_PRIVATE void make_room();
+
+  /// Record arrival of a result, for round-trip time measurement.
+  PQXX_PRIVATE void note_received() noexcept;
+
+  /// Record arrival of a result, for the connection's query hook.
+  PQXX_PRIVATE void time_result(result const &, bool failed);
+
+  /// One past the last query that issue() may issue.
+  PQXX_PRIVATE query_id issue_limit() const noexcept;
+
+  /// Update bookkeeping for queries that have just been issued.
+  PQXX_PRIVATE void mark_issued(query_id oldest, query_id stop);
+
   PQXX_PRIVATE void issue();
 
   /// The given query failed; never issue anything beyond that
@@ -212,25 +580,102 @@ private:
   PQXX_PRIVATE bool obtain_result(bool expect_none = false);
 
   PQXX_PRIVATE void obtain_dummy();
+
+  /// Receive next result in libpq pipeline mode.
+  /** @param wait Block until a result comes in.  If false, give up when the
+   * result is not yet available.
+   * @return Whether a result was received.
+   */
+  PQXX_PRIVATE bool obtain_native_result(bool wait);
+
+  /// In pipeline mode, discard remaining results up to the last sync point.
+  PQXX_PRIVATE void drain_native();
+
+  /// Should we recover from a broken connection, and is it broken?
+  PQXX_PRIVATE bool lost_connection() const noexcept;
+
+  /// Reconnect, and resubmit the idempotent queries that were in flight.
+  PQXX_PRIVATE void resubmit();
+
+  /// Skip past any queries in flight which will get no result.
+  PQXX_PRIVATE void skip_in_doubt() noexcept;
+
   PQXX_PRIVATE void get_further_available_results();
   PQXX_PRIVATE void check_end_results();
 
   /// Receive any results that happen to be available; it's not urgent
   PQXX_PRIVATE void receive_if_available();
 
+  /// Attach a handler to a query.
+  PQXX_PRIVATE void set_handler(query_id, handler &&);
+
+  /// Pass any results that have come in to their handlers.
+  PQXX_PRIVATE void run_handlers();
+
   /// Receive results, up to stop if possible
-  PQXX_PRIVATE void receive(pipeline::QueryMap::const_iterator stop);
-  std::pair<pipeline::query_id, result> retrieve(pipeline::QueryMap::iterator);
+  PQXX_PRIVATE void receive(query_id stop);
+  std::pair<pipeline::query_id, result> retrieve(query_id, Query *);
 
-  QueryMap m_queries;
-  std::pair<QueryMap::iterator, QueryMap::iterator> m_issuedrange;
+  QueryRing m_queries;
+  /// Ids of queries that have been issued, but whose results are not in yet.
+  /** The second id is one past the last issued query.  Queries from there
+   * up to @c m_queries.end_id() are still waiting to be issued.
+   */
+  std::pair<query_id, query_id> m_issuedrange;
   int m_retain = 0;
   int m_num_waiting = 0;
+
+  /// Adaptive batching policy, if enabled.
+  std::optional<pipeline_batching> m_batching;
+  /// Total size of queries waiting to be issued.
+  std::size_t m_waiting_bytes = 0;
+  /// Since when has the oldest of the waiting queries been waiting?
+  std::chrono::steady_clock::time_point m_waiting_since;
+  /// Smoothed round-trip time.
+  std::chrono::steady_clock::duration m_rtt{0};
+  /// Query whose result will give us a round-trip time sample, if any.
+  query_id m_timed_qid = 0;
+  /// When did we issue m_timed_qid?
+  std::chrono::steady_clock::time_point m_timed_start;
   query_id m_q_id = 0;
 
+  /// A batch of queries which we're timing for the connection's query hook.
+  struct batch_timing
+  {
+    /// One past the batch's last query.
+    query_id stop;
+    std::chrono::steady_clock::time_point start;
+    /// The batch's first query.
+    std::shared_ptr<std::string> query;
+    query_stats stats;
+  };
+  /// Batches in flight which we're timing, oldest first.
+  std::deque<batch_timing> m_batch_timing;
+
   /// Is there a "dummy query" pending?
   bool m_dummy_pending = false;
 
+  /// In native pipeline mode: number of sync points not yet received.
+  int m_pending_syncs = 0;
+
+  /// Oldest query that run_handlers() may not have looked at yet.
+  query_id m_handler_scan = 0;
+
+  /// Is run_handlers() running?  Handlers can call back into the pipeline.
+  bool m_running_handlers = false;
+
+  /// Reconnect and resubmit after the connection breaks?
+  bool m_resubmit = false;
+
+  /// Queue up outgoing queries instead of waiting for the socket?
+  bool m_nonblocking = false;
+
+  /// Drop the results of new queries as they come in?
+  bool m_discard = false;
+
+  /// Queries that were in flight, and not idempotent, when we lost contact.
+  std::vector<query_id> m_in_doubt;
+
   /// Point at which an error occurred; no results beyond it will be available
   query_id m_error = qid_limit();
 };
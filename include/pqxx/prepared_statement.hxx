@@ -14,6 +14,11 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "pqxx/internal/statement_parameters.hxx"
 #include "pqxx/types.hxx"
 
@@ -90,7 +95,193 @@ make_dynamic_params(C &container, ACCESSOR accessor)
   using IT = decltype(std::begin(container));
   return pqxx::internal::dynamic_params<IT, ACCESSOR>{container, accessor};
 }
+
+
+/// Pass a statement parameter in binary format.
+/** Numbers and booleans normally go to the server as text, which the server
+ * then parses.  Passing them in binary saves that work, and for large
+ * numbers, it also saves space.  It uses @c binary_traits to write the value.
+ *
+ * A binary parameter has a fixed SQL type, determined by its C++ type: an
+ * @c int is an @c integer, a @c long @c long is a @c bigint, a @c double is a
+ * @c double @c precision, and so on.  When you use it in @c exec_params, that
+ * also tells the server the parameter's type.  But a prepared statement
+ * already has its parameter types, so there it must be exactly the right
+ * type: the server will misread an @c int passed where it expects a
+ * @c bigint.
+ *
+ * The wrapper holds a reference to @c value, so use it only in the call.
+ */
+template<typename T>
+[[nodiscard]] constexpr inline pqxx::internal::binary_param<T>
+make_binary_param(T const &value) noexcept
+{
+  return {value};
+}
+
+
+/// Pass a whole vector as one SQL array parameter.
+/** Use this with @c "= ANY($1)" or @c "unnest($1)" to work with any number
+ * of values in a single, small statement, instead of building a long
+ * @c IN list into the SQL text.
+ *
+ * If the SQL array's element type is one we can write in binary (such as
+ * @c int, @c long @c long, or @c double), the array goes to the server in
+ * binary.  Otherwise it goes as text, and the server works out its type.
+ *
+ * Like @c make_binary_param, this holds a reference to @c values, so use it
+ * only in the call.
+ */
+template<typename T>
+[[nodiscard]] constexpr inline decltype(auto)
+make_array_param(std::vector<T> const &values) noexcept
+{
+  if constexpr (pqxx::internal::is_binary_array_element<T>)
+    return make_binary_param(values);
+  else
+    return (values);
+}
+
+
+/// A prepared statement's definition, for @c connection::prepare_all().
+/** This lets you keep all your prepared statements in one list:
+ *
+ * @code
+ * std::vector<pqxx::prepare::statement> const statements{
+ *   {"find_user", "SELECT * FROM users WHERE id = $1"},
+ *   {"add_user", "INSERT INTO users (name) VALUES ($1)", {25}},
+ * };
+ * @endcode
+ */
+struct statement
+{
+  /// The statement's name.  Must not be empty.
+  std::string name;
+  /// The statement's SQL.
+  std::string definition;
+  /// Parameter types, as type oids.
+  /** If there are fewer types than parameters, or a type is zero, the server
+   * works out the types of the rest, as it would without this list.
+   */
+  std::vector<oid> types = {};
+};
+
+
+/// Parameter types for a prepared statement, derived from C++ types.
+/** For each C++ type that has @c binary_traits with a known SQL type, this
+ * gives that type's oid.  For other types, it gives zero, so the server works
+ * out that parameter's type for itself.
+ *
+ * @code
+ * conn.prepare(
+ *   "find", "SELECT * FROM item WHERE id = $1 AND price < $2",
+ *   pqxx::prepare::types<long long, double>());
+ * @endcode
+ */
+template<typename... TYPE> [[nodiscard]] inline std::vector<oid> types()
+{
+  return {pqxx::internal::binary_type_oid<TYPE>::value...};
+}
+
+
+/// What the server says about a prepared statement.
+/** See @c connection::describe_prepared().
+ */
+struct description
+{
+  /// The types of the statement's parameters, as the server sees them.
+  std::vector<oid> param_types;
+  /// The names of the statement's result columns.
+  std::vector<std::string> column_names;
+  /// The types of the statement's result columns.
+  std::vector<oid> column_types;
+  /// The cheapest format in which to receive each result column.
+  /** Binary for types whose binary form is cheaper to decode than their
+   * text, such as numbers and booleans.  Text for all others.  See
+   * @c transaction_base::exec_prepared_mixed().
+   */
+  std::vector<format> column_formats;
+
+  /// Can we read the statement's result columns as @c TYPE... in binary?
+  /** True if there is one type for each column, and each of the types has
+   * @c binary_traits for exactly that column's SQL type.
+   */
+  template<typename... TYPE> [[nodiscard]] bool binary_matches() const
+  {
+    if (std::size(column_types) != sizeof...(TYPE))
+      return false;
+    std::size_t col{0};
+    return (
+      (pqxx::has_binary_traits<TYPE> and
+       pqxx::internal::binary_type_oid<TYPE>::value != oid_none and
+       pqxx::internal::binary_type_oid<TYPE>::value == column_types[col++]) and
+      ...);
+  }
+};
 } // namespace pqxx::prepare
 
+
+namespace pqxx::internal
+{
+/// Pass an argument to a @c prepared statement, in binary if we can.
+/** That's if the type has @c binary_traits for writing, with a known SQL
+ * type.  The handle told the server that type when preparing the statement.
+ */
+template<typename T>
+[[nodiscard]] constexpr inline decltype(auto)
+typed_param(T const &value) noexcept
+{
+  if constexpr (
+    pqxx::has_binary_output<T> and binary_type_oid<T>::value != oid_none)
+    return binary_param<T>{value};
+  else
+    return (value);
+}
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Handle to a prepared statement, with its parameter types built in.
+/** Get one from @c connection::prepare<TYPE...>(), and execute it with
+ * @c transaction_base::exec_prepared().  Compared to executing a statement
+ * by its name, this:
+ *
+ * 1. Checks at compile time that you pass the right number of arguments.
+ * 2. Sends each argument whose type has @c binary_traits with a known SQL
+ *    type in binary.  (The server learns those types when the statement
+ *    gets prepared.)  Other arguments go as text, as usual.
+ * 3. Re-uses one parameter buffer for all executions, and skips looking up
+ *    the statement by name.
+ *
+ * A handle is only good for the connection that prepared it.  Because of its
+ * buffer, use it in only one thread at a time.
+ */
+template<typename... TYPE> class prepared
+{
+public:
+  /// The statement's name.
+  [[nodiscard]] std::string const &name() const noexcept { return *m_name; }
+
+  /// Encode @c args into the handle's parameter buffer.
+  internal::params const &bind(TYPE const &... args)
+  {
+    m_params.assign(internal::typed_param<TYPE>(args)...);
+    return m_params;
+  }
+
+private:
+  friend class connection;
+  friend class transaction_base;
+
+  explicit prepared(std::shared_ptr<std::string> name) noexcept :
+          m_name{std::move(name)}
+  {}
+
+  std::shared_ptr<std::string> m_name;
+  internal::params m_params;
+};
+} // namespace pqxx
+
 #include "pqxx/internal/compiler-internal-post.hxx"
 #endif
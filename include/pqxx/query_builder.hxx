@@ -0,0 +1,151 @@
+/* Definition of the pqxx::query_builder class.
+ *
+ * pqxx::query_builder composes SQL text in a buffer that it re-uses.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/query_builder instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_QUERY_BUILDER
+#define PQXX_H_QUERY_BUILDER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "pqxx/connection.hxx"
+#include "pqxx/strconv.hxx"
+
+
+namespace pqxx
+{
+/// Compose query text, re-using the same buffer from one query to the next.
+/** Building dynamic SQL out of @c std::string concatenations or a
+ * @c std::stringstream allocates memory all the time.  A query_builder
+ * writes everything into a single string, which keeps its memory when you
+ * @c clear() it.  So once it has grown to the size of your queries, it stops
+ * allocating.
+ *
+ * Values go in through their @c string_traits, straight into the buffer.
+ * Quoting and escaping also happen in place.
+ *
+ * @code
+ *	auto &q{tx.build_query()};
+ *	q.append("SELECT * FROM ").append_identifier(table)
+ *	  .append(" WHERE id > ").append(lowest)
+ *	  .append(" AND name = ").append_quoted(name);
+ *	auto const r{tx.exec(q)};
+ * @endcode
+ *
+ * Each transaction has a builder of its own: see
+ * @c transaction_base::build_query().  To keep the buffer across
+ * transactions, create a builder of your own on the connection instead.
+ */
+class query_builder
+{
+public:
+  /// Create a builder.  It uses @c cx for escaping.
+  explicit query_builder(connection &cx) noexcept : m_conn{&cx} {}
+
+  /// Start over with empty text.  Keeps the memory.
+  query_builder &clear() noexcept
+  {
+    m_text.clear();
+    return *this;
+  }
+
+  /// Append SQL text, or a value's text, without quoting.
+  /** Strings go in as they are, so don't use this for anything that comes
+   * from outside your program: use @c append_quoted() for that.
+   *
+   * Other types go in through @c string_traits::into_buf(), with no
+   * temporary string.  A null value becomes @c NULL.
+   */
+  template<typename T> query_builder &append(T const &value)
+  {
+    if constexpr (std::is_convertible_v<T const &, std::string_view>)
+    {
+      m_text += std::string_view{value};
+    }
+    else if (is_null(value))
+    {
+      m_text += "NULL";
+    }
+    else
+    {
+      auto const start{std::size(m_text)};
+      auto const budget{string_traits<T>::size_buffer(value)};
+      m_text.resize(start + budget);
+      auto const data{std::data(m_text)};
+      auto const end{string_traits<T>::into_buf(
+        data + start, data + start + budget, value)};
+      // Leave out the terminating zero.
+      m_text.resize(static_cast<std::size_t>(end - data) - 1);
+    }
+    return *this;
+  }
+
+  /// Append a value as a quoted, escaped SQL string literal.
+  /** A null value becomes @c NULL, without quotes.
+   */
+  template<typename T> query_builder &append_quoted(T const &value)
+  {
+    auto const start{std::size(m_text)};
+    auto const budget{connection::size_quote(value)};
+    m_text.resize(start + budget);
+    auto const data{std::data(m_text)};
+    auto const end{
+      m_conn->quote_into(value, data + start, data + start + budget)};
+    // Leave out the terminating zero.
+    m_text.resize(static_cast<std::size_t>(end - data) - 1);
+    return *this;
+  }
+
+  /// Append an SQL identifier, such as a table name, quoted.
+  query_builder &append_identifier(std::string_view name)
+  {
+    // Unlike a single quote, a double quote can't be part of a multibyte
+    // character in any client encoding that PostgreSQL supports.  So we can
+    // just double it.
+    m_text.reserve(std::size(m_text) + std::size(name) + 2);
+    m_text.push_back('"');
+    for (auto const c : name)
+    {
+      if (c == '"')
+        m_text.push_back('"');
+      m_text.push_back(c);
+    }
+    m_text.push_back('"');
+    return *this;
+  }
+
+  /// The text so far.
+  [[nodiscard]] std::string const &str() const noexcept { return m_text; }
+
+  /// The text so far.
+  [[nodiscard]] std::string_view view() const noexcept { return m_text; }
+
+  [[nodiscard]] std::size_t size() const noexcept { return std::size(m_text); }
+  [[nodiscard]] bool empty() const noexcept { return std::empty(m_text); }
+
+  /// Number of bytes the builder can hold without allocating more memory.
+  [[nodiscard]] std::size_t capacity() const noexcept
+  {
+    return m_text.capacity();
+  }
+
+private:
+  connection *m_conn;
+  std::string m_text;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,387 @@
+/* Definition of the pqxx::reactor class.
+ *
+ * pqxx::reactor drives queries and notifications on many connections.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/reactor instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_REACTOR
+#define PQXX_H_REACTOR
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+#include "pqxx/result.hxx"
+#include "pqxx/internal/statement_parameters.hxx"
+
+
+namespace pqxx::internal
+{
+class query_awaiter;
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+class reactor;
+
+
+/// The eventual outcome of a query that a @c reactor executes.
+/** You get one of these from @c reactor::async_exec() and its siblings.  The
+ * query makes progress whenever the reactor runs: in @c reactor::poll(),
+ * @c reactor::run(), or in this object's own @c get() or @c wait_for().
+ *
+ * So to fan out queries over several connections, issue them all through
+ * the same reactor, and then @c get() each of the results.  They all run
+ * at the same time, without a thread for each connection.
+ *
+ * Copies of a @c query_future share the same outcome.  The reactor must
+ * stay alive for as long as you use the future.
+ */
+class PQXX_LIBEXPORT query_future
+{
+public:
+  /// Has the query completed, successfully or not?
+  [[nodiscard]] bool ready() const noexcept { return m_state->done; }
+
+  /// Wait for the query to complete, and return its result.
+  /** Runs the reactor until the query is done, so other queries on the same
+   * reactor make progress meanwhile, and their callbacks get called.
+   *
+   * @throw Whatever exception the query failed with, if it failed.
+   */
+  result get();
+
+  /// Run the reactor until the query completes, or the timeout expires.
+  /** @return Whether the query has completed. */
+  bool wait_for(std::chrono::milliseconds timeout);
+
+private:
+  friend class reactor;
+
+  struct state
+  {
+    result res;
+    std::exception_ptr error;
+    bool done = false;
+  };
+
+  query_future(reactor &r, std::shared_ptr<state> s) noexcept :
+          m_reactor{&r},
+          m_state{std::move(s)}
+  {}
+
+  reactor *m_reactor;
+  std::shared_ptr<state> m_state;
+};
+
+
+/// Event loop serving any number of connections from a single thread.
+/** A reactor watches the sockets of the connections you add to it, and waits
+ * for all of them at once.  It uses epoll on Linux, kqueue on the BSDs and
+ * macOS, and @c poll() (or @c WSAPoll() on Windows) elsewhere.  When input
+ * arrives on a connection, the reactor reads it and dispatches it:
+ *
+ * 1. Completed queries that you started through @c exec() go to their
+ *    callbacks.
+ * 2. Notifications go to the connection's @c notification_receiver objects,
+ *    just as if you had called @c connection::get_notifs().
+ * 3. If you set a callback with @c on_readable(), the reactor calls that
+ *    instead.  That's how you read a COPY stream without blocking: call
+ *    @c stream_from::try_read() from the callback.
+ *
+ * Nothing happens until you call @c poll() or @c run().  Callbacks run inside
+ * those calls, on the calling thread.
+ *
+ * You can give queries a deadline, using @c set_query_timeout() or
+ * @c cancel_after().  When a deadline passes, the reactor asks the server to
+ * cancel what the connection is doing.  There's no thread per query for
+ * this: the reactor keeps track of the deadlines as it polls.
+ *
+ * A reactor is not thread-safe; neither is a connection.  To spread the load
+ * over a few threads, give each thread its own reactor and its own share of
+ * the connections.
+ *
+ * While its connection is registered with a reactor, don't use it for
+ * anything else except from an @c on_readable() callback.  In particular,
+ * don't have a transaction open on the connection while you @c exec()
+ * queries on it through the reactor: those queries run outside of any
+ * transaction, each one committing on its own.
+ */
+class PQXX_LIBEXPORT reactor
+{
+public:
+  /// Callback for a completed query.
+  /** If the query failed, the @c std::exception_ptr holds the exception, and
+   * the result is empty.  Otherwise, the @c std::exception_ptr is null.
+   *
+   * If the query consisted of several statements, you get the result of the
+   * last one.
+   */
+  using query_callback =
+    std::function<void(result const &, std::exception_ptr)>;
+
+  /// Callback for a connection that has input ready.  See @c on_readable().
+  using ready_callback = std::function<void(connection &)>;
+
+  reactor();
+  reactor(reactor const &) = delete;
+  ~reactor() noexcept;
+  reactor &operator=(reactor const &) = delete;
+
+  /// Start watching a connection.
+  /** Remove the connection from the reactor before you close it.
+   */
+  void add(connection &);
+
+  /// Stop watching a connection.
+  /** You can't remove a connection while it still has queries pending on it,
+   * unless the connection has broken.  It's safe to call this from inside a
+   * callback.
+   */
+  void remove(connection &);
+
+  /// Number of connections being watched.
+  [[nodiscard]] std::size_t size() const noexcept;
+
+  /// Execute a query on a connection, and call @c callback once it's done.
+  /** The connection must have been added to the reactor.  If it's already
+   * executing a query, the new one waits its turn: each connection executes
+   * its queries in the order in which you issue them.
+   */
+  void exec(connection &, std::string query, query_callback callback);
+
+  /// Execute a parameterised query, and call @c callback once it's done.
+  /** Works like @c exec(), but with parameters, like
+   * @c transaction_base::exec_params().  The parameters are converted to
+   * strings right away, so they need not stay alive until the query executes.
+   */
+  template<typename... Args>
+  void exec_params(
+    connection &c, std::string query, query_callback callback,
+    Args &&... args)
+  {
+    auto parameters{
+      std::make_shared<internal::params>(std::forward<Args>(args)...)};
+    parameters->own();
+    enqueue(
+      c, queued_query{
+           std::make_shared<std::string>(std::move(query)),
+           std::move(callback), std::move(parameters), false});
+  }
+
+  /// Execute a prepared statement, and call @c callback once it's done.
+  /** Works like @c exec_params(), but executes the prepared statement of the
+   * given name.  Prepare it on the connection before you add the connection
+   * to the reactor.
+   */
+  template<typename... Args>
+  void exec_prepared(
+    connection &c, std::string statement, query_callback callback,
+    Args &&... args)
+  {
+    auto parameters{
+      std::make_shared<internal::params>(std::forward<Args>(args)...)};
+    parameters->own();
+    enqueue(
+      c, queued_query{
+           std::make_shared<std::string>(std::move(statement)),
+           std::move(callback), std::move(parameters), true});
+  }
+
+  /// Execute a query on a connection, and return a future for its result.
+  /** Works like @c exec(), but instead of calling a callback, it completes
+   * the @c query_future.
+   */
+  [[nodiscard]] query_future async_exec(connection &, std::string query);
+
+  /// Execute a parameterised query, and return a future for its result.
+  template<typename... Args>
+  [[nodiscard]] query_future
+  async_exec_params(connection &c, std::string query, Args &&... args)
+  {
+    auto [future, callback]{make_future()};
+    exec_params(
+      c, std::move(query), std::move(callback), std::forward<Args>(args)...);
+    return future;
+  }
+
+  /// Execute a prepared statement, and return a future for its result.
+  template<typename... Args>
+  [[nodiscard]] query_future
+  async_exec_prepared(connection &c, std::string statement, Args &&... args)
+  {
+    auto [future, callback]{make_future()};
+    exec_prepared(
+      c, std::move(statement), std::move(callback),
+      std::forward<Args>(args)...);
+    return future;
+  }
+
+  /// Give each query on a connection a deadline.
+  /** Applies to the queries you issue on the connection from here on,
+   * through @c exec() and its siblings.  If a query has not completed
+   * @c timeout after you issued it, the reactor cancels it.  Its callback
+   * then receives an @c sql_error with SQLSTATE 57014 ("query_canceled").
+   *
+   * The deadline includes any time the query spends waiting for its turn.
+   * A zero timeout means no deadline, which is the default.
+   */
+  void set_query_timeout(connection &, std::chrono::milliseconds timeout);
+
+  /// Cancel whatever the connection is doing, once @c timeout has passed.
+  /** This is a one-off deadline for the connection.  Use it to bound a COPY
+   * stream that you read through @c on_readable(), for example: the stream
+   * then fails as if you had called @c connection::cancel_query().
+   *
+   * Calling this again replaces the deadline.  A zero timeout disarms it.
+   */
+  void cancel_after(connection &, std::chrono::milliseconds timeout);
+
+  /// Call @c callback whenever input arrives on a connection.
+  /** This takes over from the reactor's own handling of that connection's
+   * input: it reads no results and delivers no notifications for it, until
+   * you set an empty callback again.  Use this to read COPY data without
+   * blocking, for example.
+   */
+  void on_readable(connection &, ready_callback callback);
+
+  /// Call @c callback once, the next time input arrives on a connection.
+  /** Like @c on_readable(), but the reactor forgets the callback as soon as
+   * it calls it.  The callback may register a new one.
+   */
+  void once_readable(connection &, ready_callback callback);
+
+  /// Number of queries issued through @c exec() which haven't completed yet.
+  [[nodiscard]] std::size_t pending() const noexcept { return m_pending; }
+
+  /// Wait for input on any of the connections, and dispatch it.
+  /** Waits at most @c timeout, or indefinitely if @c timeout is negative.
+   * Returns once it has handled input from one or more connections, or the
+   * timeout has expired.
+   *
+   * If a callback throws an exception, it propagates out of @c poll().  The
+   * reactor itself will still be in a consistent state, so you can keep
+   * calling @c poll() afterwards.
+   *
+   * @return The number of connections on which the reactor handled input.
+   */
+  std::size_t poll(std::chrono::milliseconds timeout);
+
+  /// Keep calling @c poll() until all queries have completed.
+  void run();
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  /// A query that was passed to @c exec(), and has not completed yet.
+  struct PQXX_PRIVATE queued_query
+  {
+    /// The SQL, or for a prepared statement, its name.
+    std::shared_ptr<std::string> text;
+    query_callback callback;
+    /// Statement parameters, or null for a plain SQL query.
+    std::shared_ptr<internal::params const> args{};
+    bool prepared = false;
+    /// When to cancel the query, if it hasn't completed by then.
+    clock::time_point deadline = clock::time_point::max();
+  };
+
+  /// State for one watched connection.
+  struct PQXX_PRIVATE watched
+  {
+    /// The connection, or null if it's been removed.
+    connection *conn;
+    int fd;
+    /// Queries for this connection.  The first one is executing.
+    std::deque<queued_query> queries{};
+    /// Result of the executing query, so far.
+    result last{};
+    /// First error in the executing query, if any.
+    std::exception_ptr error{};
+    ready_callback on_readable{};
+    ready_callback once_readable{};
+    /// Deadline for each new query, or zero for none.
+    std::chrono::milliseconds query_timeout{0};
+    /// When to cancel whatever the connection is doing; see cancel_after().
+    clock::time_point cancel_at = clock::time_point::max();
+    bool broken = false;
+    /// Is the first of @c queries executing?
+    bool running = false;
+    /// Is a cancel request in flight?  If so, hold back the next query.
+    bool cancelling = false;
+  };
+
+  /// A completed query, waiting for its callback to be called.
+  struct PQXX_PRIVATE completion
+  {
+    query_callback callback;
+    result res;
+    std::exception_ptr error;
+  };
+
+  class backend;
+
+  friend class internal::query_awaiter;
+  /// Queue up a query for execution.
+  void enqueue(connection &, queued_query &&);
+
+  /// Create a @c query_future, and the callback that completes it.
+  std::pair<query_future, query_callback> make_future();
+
+  watched &find(connection &);
+  /// Send the first of a connection's queued queries to the server.
+  void PQXX_PRIVATE send(watched &);
+  /// Start the first of a connection's queued queries, if any.
+  void PQXX_PRIVATE start_next(watched &);
+  /// Handle input on a connection.
+  void PQXX_PRIVATE dispatch(watched &);
+  /// Receive whatever results are available on a connection.
+  void PQXX_PRIVATE receive(watched &);
+  /// Fail all of a connection's queries, and stop watching it.
+  void PQXX_PRIVATE break_connection(watched &, std::exception_ptr);
+  /// Ask the server to cancel what the connection is doing.
+  void PQXX_PRIVATE cancel(watched &);
+  /// Cancel whatever has passed its deadline, and follow up on cancels.
+  void PQXX_PRIVATE expire();
+  /// Shorten @c timeout so that we don't sleep through a deadline.
+  std::chrono::milliseconds PQXX_PRIVATE
+  until_deadline(std::chrono::milliseconds timeout) const;
+  /// Call the callbacks for completed queries.
+  void PQXX_PRIVATE deliver();
+  /// Clean up connections that have been removed.
+  void PQXX_PRIVATE sweep();
+  void PQXX_PRIVATE forget(watched &) noexcept;
+
+  std::unique_ptr<backend> m_backend;
+  std::vector<std::unique_ptr<watched>> m_watched;
+  /// Completed queries whose callbacks haven't been called yet.
+  std::deque<completion> m_done;
+  /// Keys of connections found ready in the current @c poll().
+  std::vector<void *> m_ready;
+  /// Queries issued but not yet delivered to their callbacks.
+  std::size_t m_pending = 0;
+  /// Are there removed connections left to clean up?
+  bool m_stale = false;
+  /// Has anyone set a deadline?  If not, we needn't look for expired ones.
+  bool m_deadlines = false;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,184 @@
+/* Definition of the pqxx::replication_stream class.
+ *
+ * pqxx::replication_stream consumes a logical replication stream.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/replication_stream instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_REPLICATION_STREAM
+#define PQXX_H_REPLICATION_STREAM
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "pqxx/connection.hxx"
+
+
+namespace pqxx
+{
+/// Parse an LSN in PostgreSQL's notation, e.g. "16/B374D848".
+[[nodiscard]] PQXX_LIBEXPORT lsn parse_lsn(std::string_view text);
+
+/// Write an LSN in PostgreSQL's notation, e.g. "16/B374D848".
+[[nodiscard]] PQXX_LIBEXPORT std::string lsn_to_string(lsn position);
+
+
+/// One message of change data from a replication stream.
+struct replication_message
+{
+  /// WAL position where this message's data starts.
+  lsn start = 0;
+  /// Current end of the WAL on the server.
+  lsn server_end = 0;
+  /// When the server sent this message, by the server's clock.
+  std::chrono::system_clock::time_point sent;
+  /// The output plugin's message.
+  /** Points into the connection's buffer, without copying.  It stays valid
+   * until you read the next message, or the stream ends.
+   */
+  std::string_view data;
+};
+
+
+namespace internal
+{
+/// Parse a COPY BOTH message from a replication stream.
+/** An XLogData message fills in @c out, and returns @c true.  A keepalive
+ * message sets only @c out.server_end and @c reply_requested, and returns
+ * @c false.
+ */
+PQXX_LIBEXPORT bool parse_replication_message(
+  std::string_view message, replication_message &out, bool &reply_requested);
+} // namespace internal
+
+
+/// Stream of changes from a logical replication slot.
+/** This is how change data capture works in PostgreSQL: a replication slot
+ * with an output plugin, such as @c pgoutput or @c test_decoding, turns
+ * the write-ahead log into a stream of messages.  The stream runs on the
+ * COPY BOTH protocol: the server sends the changes, and the client sends
+ * back status updates saying how far it got.
+ *
+ * The connection must be a replication connection: pass
+ * @c replication=database in its connection string.  The slot must already
+ * exist; you can create it with the @c pg_create_logical_replication_slot()
+ * function.  While the stream is open, do not use the connection for
+ * anything else.
+ *
+ * The stream hands out each message's data straight out of libpq's buffer,
+ * without copying.  The data is whatever the output plugin produces: text
+ * for @c test_decoding, or the binary logical replication protocol for
+ * @c pgoutput.  Decoding that is up to you.
+ *
+ * Once you have durably processed a message, call @c confirm() with its
+ * position.  The stream does not send out every confirmation separately.
+ * It sends a status update at most once every @c status_interval, or when
+ * the server asks for one, or when you call @c send_status().  The server
+ * can discard WAL up to the confirmed position, so after a restart, you'll
+ * see everything after that point again.
+ *
+ * @code
+ *	pqxx::connection conn{"dbname=mydb replication=database"};
+ *	pqxx::replication_stream stream{conn, "my_slot"};
+ *	pqxx::replication_message message;
+ *	while (stream.read(message))
+ *	{
+ *	  process(message.data);
+ *	  stream.confirm(message.start);
+ *	}
+ * @endcode
+ *
+ * To read from an event loop, use @c try_read().  It never blocks, but it
+ * also sends any status update that is due, so call it at least once every
+ * @c status_interval.  Wait for @c sock() to become readable between calls.
+ */
+class PQXX_LIBEXPORT replication_stream
+{
+public:
+  /// Start streaming from @c slot.
+  /**
+   * @param c A replication connection, not in a transaction.
+   * @param slot Name of the replication slot.
+   * @param start Where to start.  Zero means "wherever the slot is."
+   * @param plugin_options Options for the output plugin, as they go into
+   *     the @c START_REPLICATION command, e.g.
+   *     <tt>proto_version '1', publication_names 'mypub'</tt>.
+   * @param status_interval How often to send status updates.
+   */
+  replication_stream(
+    connection &c, std::string_view slot, lsn start = 0,
+    std::string_view plugin_options = {},
+    std::chrono::milliseconds status_interval = std::chrono::seconds{10});
+  replication_stream(replication_stream const &) = delete;
+  replication_stream &operator=(replication_stream const &) = delete;
+  /// Close the stream.  Reports any error as a notice.
+  ~replication_stream() noexcept;
+
+  /// Wait for the next message.
+  /** Handles keepalives and status updates along the way.
+   *
+   * @return Whether there was a message.  If not, the server ended the
+   *     stream.
+   */
+  bool read(replication_message &message);
+
+  /// Get the next message if one has arrived, without blocking.
+  /** @return Whether there was a message.  If not, check @c done() to see
+   *     whether there will be more.
+   */
+  bool try_read(replication_message &message);
+
+  /// Has the stream ended?
+  [[nodiscard]] bool done() const noexcept { return m_done; }
+
+  /// The socket to wait on, for @c try_read().
+  [[nodiscard]] int sock() const noexcept { return m_conn.sock(); }
+
+  /// Report that everything up to @c position has been processed.
+  /** This goes out with the next status update.
+   */
+  void confirm(lsn position) noexcept
+  {
+    if (position > m_confirmed)
+      m_confirmed = position;
+  }
+
+  /// Send a status update now.
+  void send_status();
+
+  /// End the stream, after sending a final status update.
+  void complete();
+
+private:
+  /// Handle one message from the connection.  Returns whether it was data.
+  PQXX_PRIVATE bool accept(replication_message &, std::size_t size);
+  /// Send a status update if one is due.
+  PQXX_PRIVATE void keep_up();
+  /// Time until the next status update is due.
+  PQXX_PRIVATE std::chrono::microseconds time_to_status() const;
+
+  connection &m_conn;
+  std::chrono::milliseconds const m_status_interval;
+  /// The latest message, which the caller's @c data points into.
+  internal::pq_buffer m_buffer{nullptr, internal::pq_freemem};
+  /// Furthest position we've received.
+  lsn m_received = 0;
+  /// Furthest position the caller has confirmed.
+  lsn m_confirmed = 0;
+  std::chrono::steady_clock::time_point m_last_status;
+  bool m_done = false;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -16,9 +16,12 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <cstdint>
 #include <ios>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 #include "pqxx/except.hxx"
 #include "pqxx/types.hxx"
@@ -31,7 +34,12 @@
 namespace pqxx::internal
 {
 PQXX_LIBEXPORT void clear_result(pq::PGresult const *);
-}
+
+class row_ref_iterator;
+class row_ref_range;
+template<typename... TYPE> class result_iteration;
+struct column_index;
+} // namespace pqxx::internal
 
 
 namespace pqxx::internal::gate
@@ -40,6 +48,7 @@ class result_connection;
 class result_creation;
 class result_pipeline;
 class result_row;
+class result_snapshot;
 class result_sql_cursor;
 } // namespace pqxx::internal::gate
 
@@ -66,6 +75,11 @@ namespace pqxx
  * another thread may be copying, destroying, querying, or otherwise accessing
  * the same result set--even if it is doing so through a different result
  * object!
+ *
+ * Several threads can however read the same result at the same time, through
+ * @c row_ref and @c field_ref objects, so long as nothing modifies, copies, or
+ * destroys the result meanwhile.  The functions in @c pqxx/parallel_result
+ * do this for you.
  */
 class PQXX_LIBEXPORT result
 {
@@ -118,13 +132,108 @@ public:
 
   void swap(result &) noexcept;
 
+  /// How much memory does this result set take, in bytes?
+  /** All copies of the result share the same memory.  When built against
+   * libpq 12 or better, this is libpq's own figure.  With older versions,
+   * it's an estimate based on the sizes of the fields.
+   */
+  [[nodiscard]] std::size_t memory_usage() const noexcept;
+
   [[nodiscard]] row operator[](size_type i) const noexcept;
   row at(size_type) const;
 
+  /// Iterate over the rows as lightweight @c row_ref objects.
+  /** This is faster than regular iteration, but you must keep this result
+   * object alive and unchanged while you use the rows: see @c row_ref.
+   */
+  [[nodiscard]] inline internal::row_ref_range row_refs() const noexcept;
+
+  /// Iterate over the rows, converted to tuples of the given types.
+  /** The result must have exactly as many columns as there are types.  The
+   * column formats are checked only once, when you call this.  Each row then
+   * converts straight into a @c std::tuple, which works well with structured
+   * bindings:
+   *
+   * @code
+   *	for (auto [id, name] : res.iter<int, std::string>())
+   *	  process(id, name);
+   * @endcode
+   *
+   * Keep this result object alive and unchanged while you iterate.
+   */
+  template<typename... TYPE>
+  [[nodiscard]] inline internal::result_iteration<TYPE...> iter() const;
+
+  /// Convert one column into a @c column_batch.
+  /** Converts the column's fields one after the other, which is easier on the
+   * CPU cache than converting row by row.  Replaces any previous contents of
+   * @c out, but re-uses its memory where it can.
+   */
+  template<typename T>
+  inline void column_as(row_size_type col, column_batch<T> &out) const;
+
+  /// Convert one column into an array of @c size() values.
+  /** Writes each field's value to @c values.  For a null field, that's
+   * @c T's null value, or a default-constructed @c T if it has none.
+   *
+   * If you pass @c validity, it must have room for @c (size()+7)/8 bytes.
+   * This writes an Arrow-style validity bitmap there: one bit per row, least
+   * significant bit first, set if the field is not null.
+   */
+  template<typename T>
+  inline void column_as(
+    row_size_type col, T *values, std::uint8_t *validity = nullptr) const;
+
+  /// Write a column's validity bitmap: which of its fields are not null.
+  /** This is the same Arrow-style bitmap as @c column_as() writes: one bit
+   * per row, least significant bit first, set if the field is not null.
+   * Any unused bits in the last byte are zero.  The @c bits array must have
+   * room for @c (size()+7)/8 bytes.
+   *
+   * This does the whole column in one tight loop, without going through a
+   * @c field and its non-inline @c field::is_null() for each row.
+   *
+   * @return The number of nulls in the column.
+   */
+  size_type validity_bitmap(row_size_type col, std::uint8_t *bits) const;
+
+  /// Write the lengths of all of a column's fields, in bytes.
+  /** The @c lengths array must have room for @c size() values.  A null field
+   * has length zero.
+   *
+   * Like @c validity_bitmap(), this does the whole column in one loop.
+   */
+  void field_lengths(row_size_type col, field_size_type *lengths) const;
+
+  /// A copy of this result, with just the given columns.
+  /** The copy holds its own data, packed tightly, and does not share
+   * anything with this result.  So if you keep only a few small columns out
+   * of a big result, compact it, and let go of the original to free its
+   * memory.  This is useful for results that you cache for a long time.
+   *
+   * The copy has the same rows, and the given columns in the given order,
+   * with their names, types, and formats.  It does not know the command
+   * status or the number of affected rows.
+   *
+   * @throw range_error If a column does not exist.
+   * @throw argument_error If @c cols is empty.
+   */
+  [[nodiscard]] result compact(std::vector<row_size_type> const &cols) const;
+
+  /// A copy of this result, with just the given columns.
+  /** Identify each column by its number, or by its name.
+   */
+  template<typename... COL>
+  [[nodiscard]] result compact(COL const &...cols) const
+  {
+    return compact(std::vector<row_size_type>{column_of(cols)...});
+  }
+
   void clear() noexcept
   {
     m_data.reset();
     m_query = nullptr;
+    m_columns = nullptr;
   }
 
   /**
@@ -135,6 +244,9 @@ public:
   [[nodiscard]] PQXX_PURE row_size_type columns() const noexcept;
 
   /// Number of given column (throws exception if it doesn't exist).
+  /** The first lookup builds an index of the column names, which all copies
+   * of this result share.  After that, a name lookup takes constant time.
+   */
   row_size_type column_number(char const col_name[]) const;
 
   /// Number of given column (throws exception if it doesn't exist).
@@ -161,6 +273,9 @@ public:
     return column_type(column_number(col_name));
   }
 
+  /// Is this column's data in text or in binary format?
+  [[nodiscard]] format column_format(row_size_type col_num) const noexcept;
+
   /// What table did this column come from?
   [[nodiscard]] oid column_table(row_size_type col_num) const;
 
@@ -213,6 +328,7 @@ private:
   }
 
   friend class pqxx::internal::gate::result_pipeline;
+  friend class pqxx::internal::gate::result_snapshot;
   PQXX_PURE std::shared_ptr<std::string> query_ptr() const noexcept
   {
     return m_query;
@@ -223,15 +339,35 @@ private:
 
   internal::encoding_group m_encoding;
 
+  /// Index of column names, built when first needed.
+  /** Lives alongside the underlying result set, which owns it.
+   */
+  internal::column_index *m_columns = nullptr;
+
   static std::string const s_empty_string;
 
+  /// Number of a column, given its number or its name.
+  template<typename COL> row_size_type column_of(COL const &col) const
+  {
+    if constexpr (std::is_integral_v<COL>)
+      return static_cast<row_size_type>(col);
+    else
+      return column_number(col);
+  }
+
   friend class pqxx::field;
+  friend class pqxx::field_ref;
   PQXX_PURE char const *get_value(size_type row, row_size_type col) const;
   PQXX_PURE bool get_is_null(size_type row, row_size_type col) const;
   PQXX_PURE field_size_type get_length(size_type, row_size_type) const
     noexcept;
 
   friend class pqxx::internal::gate::result_creation;
+  /// Report these columns as text, though the result is in binary format.
+  /** For columns whose binary form is the same as their text form.  Call
+   * this only on a new result, before anyone else sees it.
+   */
+  void PQXX_PRIVATE read_as_text(std::vector<bool> columns) const;
   result(
     internal::pq::PGresult *rhs, std::shared_ptr<std::string> query,
     internal::encoding_group enc);
@@ -242,6 +378,8 @@ private:
   friend class pqxx::internal::gate::result_row;
   bool operator!() const noexcept { return m_data.get() == nullptr; }
   operator bool() const noexcept { return m_data.get() != nullptr; }
+  /// Is this the result of a command which started a COPY?
+  PQXX_PRIVATE PQXX_PURE bool starts_copy() const noexcept;
 
   [[noreturn]] PQXX_PRIVATE void
   ThrowSQLError(std::string const &Err, std::string const &Query) const;
@@ -250,6 +388,10 @@ private:
 
   friend class pqxx::internal::gate::result_sql_cursor;
   PQXX_PURE char const *cmd_status() const noexcept;
+  /// A result with the same columns as this one, but no rows.
+  /** Its command status is still this result's.
+   */
+  PQXX_PRIVATE result empty_copy() const;
 };
 } // namespace pqxx
 
@@ -0,0 +1,198 @@
+/* Definition of the pqxx::result_cache class.
+ *
+ * pqxx::result_cache remembers the results of prepared statements.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/result_cache instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_RESULT_CACHE
+#define PQXX_H_RESULT_CACHE
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pqxx/connection.hxx"
+#include "pqxx/result.hxx"
+#include "pqxx/transaction_base.hxx"
+
+
+namespace pqxx
+{
+/// Settings for a @c result_cache.
+struct result_cache_config
+{
+  /// Most results the cache will hold.  Zero means no limit.
+  std::size_t max_entries = 1000;
+
+  /// Most memory the cached results may take, in bytes.  Zero means no limit.
+  /** This counts each result's @c result::memory_usage().  A result that is
+   * bigger than this all by itself never goes into the cache.
+   */
+  std::size_t max_bytes = 0;
+
+  /// How long a result stays in the cache.  Zero means no limit.
+  std::chrono::milliseconds ttl{0};
+};
+
+
+/// Cache for the results of prepared statements.
+/** For queries that return the same small results over and over, such as
+ * lookups in reference data, this turns repeated round trips to the server
+ * into memory lookups.  It's opt-in: only queries that you execute through
+ * the cache's own @c exec_prepared() go through the cache.
+ *
+ * The cache key is the statement's name, plus its parameters.  Cached
+ * results are shared, not copied: a @c result is a reference-counted handle.
+ *
+ * Of course the cached results may go out of date.  There are three ways to
+ * deal with that: a time-to-live, explicit calls to @c invalidate() or
+ * @c clear(), and invalidation through notifications.  Call
+ * @c invalidate_on() to have a notification channel empty out (part of) the
+ * cache, e.g. from a trigger that issues a @c NOTIFY whenever the reference
+ * data changes.
+ *
+ * The cache listens for those notifications on the connection that you pass
+ * to its constructor, and checks for them on every lookup.  A connection
+ * does not deliver notifications while it has a transaction open, so for
+ * prompt invalidation, give the cache a connection of its own.  The queries
+ * can then execute on transactions on any connection which has the
+ * statements prepared.
+ *
+ * A cache is not thread-safe, and neither is the connection it listens on.
+ */
+class PQXX_LIBEXPORT result_cache
+{
+public:
+  /// Counters for how well the cache is doing.
+  struct statistics
+  {
+    /// Lookups which found a valid result in the cache.
+    std::size_t hits = 0;
+    /// Lookups which had to execute the statement.
+    std::size_t misses = 0;
+    /// Results dropped to stay within the limits, or because they expired.
+    std::size_t evictions = 0;
+    /// Results dropped through @c invalidate(), or by a notification.
+    std::size_t invalidations = 0;
+  };
+
+  /// Create a cache.
+  /**
+   * @param listener Connection on which to listen for invalidations.
+   * @param config Limits for the cache.
+   */
+  explicit result_cache(
+    connection &listener, result_cache_config const &config = {});
+  ~result_cache() noexcept;
+
+  result_cache(result_cache const &) = delete;
+  result_cache &operator=(result_cache const &) = delete;
+
+  /// Execute a prepared statement, or look up its result in the cache.
+  /** Works like @c transaction_base::exec_prepared(), except if the cache
+   * already holds a valid result for the same statement and parameters.  In
+   * that case, it returns that result without executing anything.
+   *
+   * Failed executions do not go into the cache.
+   */
+  template<typename... Args>
+  result exec_prepared(
+    transaction_base &tx, std::string const &statement, Args &&... args)
+  {
+    return exec(
+      tx, zview{statement.c_str(), statement.size()},
+      internal::params(std::forward<Args>(args)...));
+  }
+
+  template<typename... Args>
+  result exec_prepared(transaction_base &tx, zview statement, Args &&... args)
+  {
+    return exec(tx, statement, internal::params(std::forward<Args>(args)...));
+  }
+
+  /// Invalidate cached results when a notification comes in on @c channel.
+  /** If @c statement is empty, a notification invalidates all cached
+   * results.  Otherwise, it invalidates only those of @c statement.
+   *
+   * You can call this several times, for different channels or statements.
+   */
+  void invalidate_on(std::string_view channel, std::string statement = {});
+
+  /// Drop all cached results for @c statement.
+  void invalidate(std::string_view statement);
+
+  /// Drop all cached results.
+  void clear() noexcept;
+
+  /// Number of results currently in the cache.
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    return std::size(m_entries);
+  }
+
+  /// Total memory taken by the cached results, in bytes.
+  [[nodiscard]] std::size_t bytes() const noexcept { return m_bytes; }
+
+  /// Snapshot of the cache's counters.
+  [[nodiscard]] statistics stats() const noexcept { return m_stats; }
+
+private:
+  class invalidator;
+
+  struct entry
+  {
+    result res;
+    /// The result's memory usage, as we counted it in @c m_bytes.
+    std::size_t bytes;
+    /// When this result expires, if the cache has a time-to-live.
+    std::chrono::steady_clock::time_point expires;
+    /// This entry's position in @c m_lru.
+    std::list<std::string_view>::iterator lru;
+  };
+
+  using entry_map = std::map<std::string, entry, std::less<>>;
+
+  result exec(
+    transaction_base &, zview statement, internal::params const &args);
+
+  /// Drop entries from @c begin to @c end, counting them in @c counter.
+  void PQXX_PRIVATE drop(
+    entry_map::iterator begin, entry_map::iterator end,
+    std::size_t &counter) noexcept;
+  /// Drop least recently used entries until we're within the limits.
+  void PQXX_PRIVATE trim() noexcept;
+
+  connection &m_listener;
+  result_cache_config const m_config;
+
+  entry_map m_entries;
+  /// Keys of @c m_entries, most recently used first.
+  /** These point to the keys in @c m_entries.
+   */
+  std::list<std::string_view> m_lru;
+  std::size_t m_bytes = 0;
+  statistics m_stats;
+
+  /// Re-usable buffer for composing lookup keys.
+  std::string m_key;
+
+  std::vector<std::unique_ptr<invalidator>> m_invalidators;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,381 @@
+/* Definition of the pqxx::result_snapshot class.
+ *
+ * pqxx::result_snapshot saves a query result to a file, and reads it back
+ * without parsing.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/result_snapshot instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_RESULT_SNAPSHOT
+#define PQXX_H_RESULT_SNAPSHOT
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "pqxx/field.hxx"
+#include "pqxx/result.hxx"
+
+
+namespace pqxx::internal
+{
+class mapped_file;
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// A query result, saved in a compact binary file, and mapped back in.
+/** Use this to keep expensive query results across process restarts.
+ * @c save() writes a @c result to a file.  Constructing a @c result_snapshot
+ * from that file maps it into memory, where the system supports that, and
+ * gives you read-only access to the same data: column names, types, and
+ * formats, and the fields, including nulls.
+ *
+ * Loading involves no parsing.  The file holds the column metadata, a null
+ * bitmap, and a table of offsets for the fields' data, all laid out so that
+ * finding a field takes constant time.  Pages of the file come into memory
+ * as you read them.
+ *
+ * Fields work like they do in a @c result: @c field_view has @c as(),
+ * @c to(), @c get(), @c view(), @c c_str(), and @c as_array(), with the same
+ * conversions.
+ *
+ * The file format is versioned, and tied to the machine's byte order.
+ * Loading a file with a different version or byte order fails.
+ */
+class PQXX_LIBEXPORT result_snapshot
+{
+public:
+  using size_type = result_size_type;
+
+  /// File format version that this code writes, and reads.
+  static constexpr std::uint32_t version{1};
+
+  /// A field in a @c result_snapshot.
+  class PQXX_LIBEXPORT field_view
+  {
+  public:
+    using size_type = field_size_type;
+
+    /// Column name.
+    [[nodiscard]] char const *name() const
+    {
+      return m_home->column_name(m_col);
+    }
+    /// Column type.
+    [[nodiscard]] oid type() const { return m_home->column_type(m_col); }
+    /// Is this field in binary format, rather than text?
+    [[nodiscard]] bool is_binary() const noexcept
+    {
+      return m_home->column_format(m_col) == format::binary;
+    }
+    [[nodiscard]] row_size_type num() const noexcept { return m_col; }
+
+    [[nodiscard]] bool is_null() const noexcept
+    {
+      return m_home->get_is_null(m_cell);
+    }
+    /// Number of bytes in the field's value.
+    [[nodiscard]] size_type size() const noexcept
+    {
+      return m_home->get_length(m_cell);
+    }
+    /// The field's value, with a terminating zero.
+    [[nodiscard]] char const *c_str() const noexcept
+    {
+      return m_home->get_value(m_cell);
+    }
+    [[nodiscard]] std::string_view view() const noexcept
+    {
+      return std::string_view{c_str(), size()};
+    }
+
+    /// Read value into obj; or if null, leave obj untouched and return false.
+    template<typename T>
+    auto to(T &obj) const -> typename std::enable_if<
+      (not std::is_pointer<T>::value or std::is_same<T, char const *>::value),
+      bool>::type
+    {
+      return internal::read_field(*this, obj);
+    }
+
+    /// Return value as object of given type, or throw exception if null.
+    template<typename T> T as() const
+    {
+      T obj;
+      if (not to(obj))
+      {
+        if constexpr (nullness<T>::has_null)
+          obj = nullness<T>::null();
+        else
+          internal::throw_null_conversion(name_type<T>());
+      }
+      return obj;
+    }
+
+    /// Return value wrapped in some optional type (empty for nulls).
+    template<typename T, template<typename> class O = std::optional>
+    constexpr O<T> get() const
+    {
+      return as<O<T>>();
+    }
+
+    /// Parse the field as an SQL array.
+    [[nodiscard]] array_parser as_array() const
+    {
+      return array_parser{c_str(), m_home->m_encoding};
+    }
+
+  private:
+    friend class result_snapshot;
+    field_view(
+      result_snapshot const &home, row_size_type col,
+      std::size_t cell) noexcept :
+            m_home{&home}, m_col{col}, m_cell{cell}
+    {}
+
+    result_snapshot const *m_home;
+    row_size_type m_col;
+    std::size_t m_cell;
+  };
+
+  /// A row in a @c result_snapshot.
+  class PQXX_LIBEXPORT row_view
+  {
+  public:
+    [[nodiscard]] row_size_type size() const noexcept
+    {
+      return m_home->columns();
+    }
+    [[nodiscard]] size_type rownumber() const noexcept { return m_row; }
+
+    [[nodiscard]] field_view operator[](row_size_type col) const noexcept
+    {
+      return m_home->field_at(m_row, col);
+    }
+    [[nodiscard]] field_view operator[](std::string_view col_name) const
+    {
+      return (*this)[m_home->column_number(col_name)];
+    }
+    /// Field @c col, with range check.
+    [[nodiscard]] field_view at(row_size_type col) const;
+
+    /// Convert the whole row to a tuple of @c TYPE....
+    /** @throw usage_error If the row does not have as many fields as there
+     * are types.
+     */
+    template<typename... TYPE> [[nodiscard]] std::tuple<TYPE...> as() const
+    {
+      check_size(sizeof...(TYPE));
+      return as_tuple<TYPE...>(std::index_sequence_for<TYPE...>{});
+    }
+
+  private:
+    friend class result_snapshot;
+    row_view(result_snapshot const &home, size_type row) noexcept :
+            m_home{&home}, m_row{row}
+    {}
+
+    void check_size(std::size_t expected) const;
+
+    template<typename... TYPE, std::size_t... I>
+    std::tuple<TYPE...> as_tuple(std::index_sequence<I...>) const
+    {
+      return std::tuple<TYPE...>{
+        (*this)[static_cast<row_size_type>(I)].template as<TYPE>()...};
+    }
+
+    result_snapshot const *m_home;
+    size_type m_row;
+  };
+
+  /// Random-access iterator over the rows.
+  class PQXX_LIBEXPORT const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = row_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = row_view const *;
+    using reference = row_view;
+
+    const_iterator() noexcept = default;
+
+    [[nodiscard]] row_view operator*() const noexcept
+    {
+      return (*m_home)[m_row];
+    }
+    [[nodiscard]] row_view operator[](difference_type n) const noexcept
+    {
+      return (*m_home)[static_cast<size_type>(m_row + n)];
+    }
+    const_iterator &operator++() noexcept
+    {
+      ++m_row;
+      return *this;
+    }
+    const_iterator operator++(int) noexcept { return {m_home, m_row++}; }
+    const_iterator &operator--() noexcept
+    {
+      --m_row;
+      return *this;
+    }
+    const_iterator operator--(int) noexcept { return {m_home, m_row--}; }
+    const_iterator &operator+=(difference_type n) noexcept
+    {
+      m_row = static_cast<size_type>(m_row + n);
+      return *this;
+    }
+    const_iterator &operator-=(difference_type n) noexcept
+    {
+      m_row = static_cast<size_type>(m_row - n);
+      return *this;
+    }
+    [[nodiscard]] const_iterator operator+(difference_type n) const noexcept
+    {
+      return {m_home, static_cast<size_type>(m_row + n)};
+    }
+    [[nodiscard]] const_iterator operator-(difference_type n) const noexcept
+    {
+      return {m_home, static_cast<size_type>(m_row - n)};
+    }
+    [[nodiscard]] difference_type
+    operator-(const_iterator const &rhs) const noexcept
+    {
+      return difference_type{m_row} - difference_type{rhs.m_row};
+    }
+
+    [[nodiscard]] bool operator==(const_iterator const &rhs) const noexcept
+    {
+      return m_row == rhs.m_row;
+    }
+    [[nodiscard]] bool operator!=(const_iterator const &rhs) const noexcept
+    {
+      return m_row != rhs.m_row;
+    }
+    [[nodiscard]] bool operator<(const_iterator const &rhs) const noexcept
+    {
+      return m_row < rhs.m_row;
+    }
+    [[nodiscard]] bool operator>(const_iterator const &rhs) const noexcept
+    {
+      return m_row > rhs.m_row;
+    }
+    [[nodiscard]] bool operator<=(const_iterator const &rhs) const noexcept
+    {
+      return m_row <= rhs.m_row;
+    }
+    [[nodiscard]] bool operator>=(const_iterator const &rhs) const noexcept
+    {
+      return m_row >= rhs.m_row;
+    }
+
+  private:
+    friend class result_snapshot;
+    const_iterator(result_snapshot const *home, size_type row) noexcept :
+            m_home{home}, m_row{row}
+    {}
+
+    result_snapshot const *m_home = nullptr;
+    size_type m_row = 0;
+  };
+
+  /// Write @c res to a snapshot file at @c path.  Replaces any existing file.
+  static void save(result const &res, std::string const &path);
+
+  /// Serialise @c res into the snapshot format, in memory.
+  [[nodiscard]] static std::string serialize(result const &res);
+
+  /// Load a snapshot from the file at @c path.
+  /** @throw failure If the file can't be read, or is not a valid snapshot
+   * in this version and byte order.
+   */
+  explicit result_snapshot(std::string const &path);
+
+  ~result_snapshot() noexcept;
+
+  result_snapshot(result_snapshot const &) = delete;
+  result_snapshot &operator=(result_snapshot const &) = delete;
+
+  [[nodiscard]] size_type size() const noexcept { return m_rows; }
+  [[nodiscard]] bool empty() const noexcept { return m_rows == 0; }
+
+  [[nodiscard]] row_size_type columns() const noexcept { return m_columns; }
+  /// Number of the column called @c name.
+  /** @throw argument_error If there is no such column.
+   */
+  [[nodiscard]] row_size_type column_number(std::string_view name) const;
+  [[nodiscard]] char const *column_name(row_size_type col) const;
+  [[nodiscard]] oid column_type(row_size_type col) const;
+  [[nodiscard]] format column_format(row_size_type col) const noexcept;
+
+  [[nodiscard]] row_view operator[](size_type row) const noexcept
+  {
+    return row_view{*this, row};
+  }
+  /// Row number @c row, with range check.
+  [[nodiscard]] row_view at(size_type row) const;
+
+  [[nodiscard]] const_iterator begin() const noexcept { return {this, 0}; }
+  [[nodiscard]] const_iterator end() const noexcept { return {this, m_rows}; }
+
+private:
+  [[nodiscard]] field_view
+  field_at(size_type row, row_size_type col) const noexcept
+  {
+    return field_view{
+      *this, col,
+      static_cast<std::size_t>(row) * static_cast<std::size_t>(m_columns) +
+        static_cast<std::size_t>(col)};
+  }
+
+  [[nodiscard]] bool get_is_null(std::size_t cell) const noexcept
+  {
+    return (static_cast<unsigned char>(m_nulls[cell / 8]) >> (cell % 8)) & 1;
+  }
+  [[nodiscard]] std::uint64_t offset(std::size_t index) const noexcept;
+  [[nodiscard]] field_size_type get_length(std::size_t cell) const noexcept
+  {
+    return static_cast<field_size_type>(offset(cell + 1) - offset(cell) - 1);
+  }
+  [[nodiscard]] char const *get_value(std::size_t cell) const noexcept
+  {
+    return m_data + offset(cell);
+  }
+
+  /// Check the file's layout, and find its parts.
+  void parse();
+
+  std::unique_ptr<internal::mapped_file> m_file;
+  size_type m_rows = 0;
+  row_size_type m_columns = 0;
+  internal::encoding_group m_encoding = internal::encoding_group::MONOBYTE;
+  /// The column table: type, format, name offset, and name length for each.
+  char const *m_column_table = nullptr;
+  /// The column names, each with a terminating zero.
+  char const *m_names = nullptr;
+  /// One bit per field, set for nulls.
+  char const *m_nulls = nullptr;
+  /// Each field's offset in @c m_data, plus one for the end.
+  char const *m_offsets = nullptr;
+  char const *m_data = nullptr;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
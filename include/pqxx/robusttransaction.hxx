@@ -61,7 +61,12 @@ namespace pqxx
  * managed to commit the transaction.
  *
  * Whe this happens, robusttransaction tries to reconnect to the database and
- * figure out what happened.
+ * figure out what happened.  It keeps checking, backing off gradually, for up
+ * to two and a half minutes.
+ *
+ * On the happy path, a robusttransaction takes as many round trips to the
+ * server as a regular transaction: it bundles its extra work with the
+ * @c BEGIN and the @c COMMIT.
  *
  * This service level was made optional since you may not want to pay the
  * overhead where it is not necessary.  Certainly the use of this class makes
@@ -16,6 +16,9 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <tuple>
+#include <utility>
+
 #include "pqxx/except.hxx"
 #include "pqxx/field.hxx"
 #include "pqxx/result.hxx"
@@ -103,6 +106,24 @@ public:
 
   [[nodiscard]] size_type size() const noexcept { return m_end - m_begin; }
 
+  /// Convert the whole row to a tuple of the given types.
+  /** The row must have exactly as many fields as there are types.  A null
+   * converts to the type's null value, if it has one; otherwise it's an
+   * error.
+   *
+   * @code
+   *	auto const [id, name] = row.as<int, std::string>();
+   * @endcode
+   */
+  template<typename... TYPE> [[nodiscard]] std::tuple<TYPE...> as() const
+  {
+    if (size() != sizeof...(TYPE))
+      throw usage_error{
+        "Tried to extract " + to_string(sizeof...(TYPE)) +
+        " field(s) from a row of " + to_string(size()) + "."};
+    return as_tuple<TYPE...>(std::index_sequence_for<TYPE...>{});
+  }
+
   void swap(row &) noexcept;
 
   /// Row number, assuming this is a real row and not end()/rend().
@@ -179,11 +200,21 @@ public:
   [[nodiscard]] PQXX_PURE bool empty() const noexcept;
 
 protected:
+  template<typename... TYPE, std::size_t... INDEX>
+  std::tuple<TYPE...> as_tuple(std::index_sequence<INDEX...>) const
+  {
+    return std::tuple<TYPE...>{internal::read_cell<TYPE>(
+      field_ref{m_result, m_index, m_begin + static_cast<size_type>(INDEX)},
+      m_result.column_format(m_begin + static_cast<size_type>(INDEX)) ==
+        format::binary)...};
+  }
+
   friend class const_row_iterator;
   friend class result;
   row(result const &r, result_size_type i) noexcept;
 
   friend class field;
+  friend class row_ref;
   /// Result set of which this is one row.
   result m_result;
   /// Row number.
@@ -199,6 +230,168 @@ protected:
 };
 
 
+/// Lightweight, non-owning reference to a row in a result set.
+/** Works like @c row, but does not keep the result set alive, and its fields
+ * are @c field_ref objects rather than @c field objects.  See @c field_ref.
+ *
+ * To iterate a result's rows this way, use @c result::row_refs():
+ *
+ * @code
+ *	for (auto const r : res.row_refs()) total += r[0].as<long>();
+ * @endcode
+ *
+ * Keep the @c result object alive and unchanged while you use the
+ * @c row_ref.  If you create the @c row_ref from a @c row, keep that @c row
+ * alive and unchanged.
+ */
+class row_ref
+{
+public:
+  using size_type = row_size_type;
+  using reference = field_ref;
+
+  /// Refer to row number @c index in @c r.
+  row_ref(result const &r, result_size_type index) noexcept :
+          m_result{&r},
+          m_index{index},
+          m_end{r.columns()}
+  {}
+
+  /// Refer to the same row (or slice) as @c r.
+  row_ref(row const &r) noexcept :
+          m_result{&r.m_result},
+          m_index{r.m_index},
+          m_begin{r.m_begin},
+          m_end{r.m_end}
+  {}
+
+  [[nodiscard]] reference operator[](size_type i) const noexcept
+  {
+    return {*m_result, m_index, m_begin + i};
+  }
+  /// Address field by name.
+  /** @warning This is much slower than indexing by number.
+   */
+  [[nodiscard]] reference operator[](char const name[]) const
+  {
+    return (*this)[column_number(name)];
+  }
+  /// Address field by name.
+  /** @warning This is much slower than indexing by number.
+   */
+  [[nodiscard]] reference operator[](std::string const &name) const
+  {
+    return (*this)[column_number(name.c_str())];
+  }
+
+  reference at(size_type i) const
+  {
+    if (i >= size())
+      throw range_error{"Invalid field number."};
+    return (*this)[i];
+  }
+
+  [[nodiscard]] size_type size() const noexcept { return m_end - m_begin; }
+  [[nodiscard]] bool empty() const noexcept { return m_begin == m_end; }
+
+  /// Row number, assuming this is a real row.
+  [[nodiscard]] result::size_type rownumber() const noexcept
+  {
+    return m_index;
+  }
+
+  /// Number of given column (throws exception if it doesn't exist).
+  size_type column_number(char const name[]) const
+  {
+    auto const n{m_result->column_number(name)};
+    if (n < m_begin or n >= m_end)
+      throw argument_error{
+        "Column '" + std::string{name} + "' falls outside slice."};
+    return n - m_begin;
+  }
+
+private:
+  friend class internal::row_ref_iterator;
+
+  result const *m_result;
+  result::size_type m_index;
+  size_type m_begin = 0;
+  size_type m_end;
+};
+
+
+namespace internal
+{
+/// Iterator for @c result::row_refs().
+class row_ref_iterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = row_ref const;
+  using pointer = row_ref const *;
+  using reference = row_ref const &;
+  using difference_type = result_difference_type;
+
+  row_ref_iterator(result const &r, result_size_type index) noexcept :
+          m_row{r, index}
+  {}
+
+  [[nodiscard]] reference operator*() const noexcept { return m_row; }
+  [[nodiscard]] pointer operator->() const noexcept { return &m_row; }
+
+  row_ref_iterator &operator++() noexcept
+  {
+    ++m_row.m_index;
+    return *this;
+  }
+  row_ref_iterator operator++(int) noexcept
+  {
+    auto const old{*this};
+    ++m_row.m_index;
+    return old;
+  }
+
+  [[nodiscard]] bool operator==(row_ref_iterator const &rhs) const noexcept
+  {
+    return m_row.m_index == rhs.m_row.m_index;
+  }
+  [[nodiscard]] bool operator!=(row_ref_iterator const &rhs) const noexcept
+  {
+    return m_row.m_index != rhs.m_row.m_index;
+  }
+
+private:
+  row_ref m_row;
+};
+
+
+/// Range of @c row_ref for a result.  Returned by @c result::row_refs().
+class row_ref_range
+{
+public:
+  explicit row_ref_range(result const &r) noexcept : m_result{&r} {}
+
+  [[nodiscard]] row_ref_iterator begin() const noexcept
+  {
+    return {*m_result, 0};
+  }
+  [[nodiscard]] row_ref_iterator end() const noexcept
+  {
+    return {*m_result, m_result->size()};
+  }
+
+private:
+  result const *m_result;
+};
+} // namespace internal
+
+
+inline internal::row_ref_range result::row_refs() const noexcept
+{
+  return internal::row_ref_range{*this};
+}
+
+
 /// Iterator for fields in a row.  Use as row::const_iterator.
 class PQXX_LIBEXPORT const_row_iterator : public field
 {
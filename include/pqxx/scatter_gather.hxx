@@ -0,0 +1,218 @@
+/* Definition of the pqxx::scatter_gather class.
+ *
+ * pqxx::scatter_gather runs the same query on many shards at once.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/scatter_gather instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_SCATTER_GATHER
+#define PQXX_H_SCATTER_GATHER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pqxx/connection_pool.hxx"
+#include "pqxx/reactor.hxx"
+#include "pqxx/row.hxx"
+
+
+namespace pqxx
+{
+/// Run the same query on many shards at once, and gather the results.
+/** Give it a connection for each shard, or a pool for each shard, and it
+ * sends each query to all shards at the same time.  A @c reactor waits for
+ * all of them from the calling thread, so there is no thread per shard, and
+ * the total time is that of the slowest shard, not the sum of them all.
+ *
+ * There are several ways to gather the results:
+ * 1. @c exec() and @c exec_params() return a result for each shard.
+ * 2. @c gather() calls your callback with each shard's result as soon as it
+ *    arrives.  Use this to aggregate partial results without waiting for the
+ *    slowest shard.
+ * 3. @c merge() feeds you all rows in the order of a sort key, as a k-way
+ *    merge of results that each shard has already sorted.
+ *
+ * Like everything a @c reactor executes, the queries run outside of any
+ * transaction, each committing on its own.  So don't have a transaction open
+ * on a shard's connection while you use it here.
+ *
+ * If a query fails on any shard, the others still run to completion.  Then
+ * the call re-throws the first shard's exception.
+ *
+ * A scatter_gather is not thread-safe.
+ */
+class PQXX_LIBEXPORT scatter_gather
+{
+public:
+  /// Callback for one shard's result: takes the shard's index, and result.
+  using result_callback = std::function<void(std::size_t, result const &)>;
+
+  /// Query these connections, one per shard.
+  /** The connections must stay open for as long as this object exists.
+   */
+  explicit scatter_gather(std::vector<connection *> const &shards);
+
+  /// Borrow a connection from each of these pools, one per shard.
+  /** Keeps the connections until this object is destroyed.
+   */
+  explicit scatter_gather(std::vector<connection_pool *> const &shards);
+
+  scatter_gather(scatter_gather const &) = delete;
+  scatter_gather &operator=(scatter_gather const &) = delete;
+  ~scatter_gather() noexcept;
+
+  /// Number of shards.
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    return std::size(m_shards);
+  }
+
+  /// Connection for shard number @c shard.
+  [[nodiscard]] connection &shard(std::size_t index) const
+  {
+    return *m_shards.at(index);
+  }
+
+  /// Cancel a query on any shard that takes longer than @c timeout.
+  /** The shard's result is then an @c sql_error for a cancelled query.  A
+   * zero timeout, the default, means no limit.
+   */
+  void set_timeout(std::chrono::milliseconds timeout);
+
+  /// Execute @c query on all shards.  Returns their results, in shard order.
+  [[nodiscard]] std::vector<result> exec(std::string const &query)
+  {
+    return exec_params(query);
+  }
+
+  /// Execute a parameterised query on all shards.
+  /** Returns the shards' results, in shard order.
+   */
+  template<typename... Args>
+  [[nodiscard]] std::vector<result>
+  exec_params(std::string const &query, Args &&... args)
+  {
+    std::vector<result> results(size());
+    gather(
+      query,
+      [&results](std::size_t index, result const &res) noexcept {
+        results[index] = res;
+      },
+      std::forward<Args>(args)...);
+    return results;
+  }
+
+  /// Execute a query on all shards; pass each result to @c on_result.
+  /** Calls @c on_result(index, result) for each shard, in the order in which
+   * the shards complete.  The calls happen on the calling thread, in between
+   * waits.  Queries still in flight make no progress until the callback
+   * returns, but they keep running on the server.
+   *
+   * If @c on_result throws an exception, there will be no more calls to it.
+   * Once all shards have completed, the exception propagates out of this
+   * function.
+   */
+  template<typename... Args>
+  void gather(
+    std::string const &query, result_callback const &on_result,
+    Args &&... args)
+  {
+    if constexpr (sizeof...(args) == 0)
+    {
+      scatter(
+        [this, &query](connection &c, reactor::query_callback &&done) {
+          m_reactor.exec(c, query, std::move(done));
+        },
+        on_result);
+    }
+    else
+    {
+      internal::params const p{std::forward<Args>(args)...};
+      scatter(
+        [this, &query, &p](connection &c, reactor::query_callback &&done) {
+          m_reactor.exec_params(c, query, std::move(done), p);
+        },
+        on_result);
+    }
+  }
+
+  /// Execute a sorted query on all shards, and merge the rows in order.
+  /** Each shard's query must return its rows sorted by the same key, e.g.
+   * using @c ORDER @c BY.  This calls @c on_row(index, row) for each row of
+   * each shard, in order of that key, where @c index is the shard's index and
+   * @c row is a @c row_ref.
+   *
+   * The @c less function compares two rows, as @c row_ref objects, and says
+   * whether the first comes before the second.  Rows that compare equal come
+   * out in shard order.
+   *
+   * The merge can't start until all shards have completed.  (Until then,
+   * the next row could come from any shard.)  But it costs just a
+   * logarithmic number of comparisons per row.
+   */
+  template<typename LESS, typename FUNC, typename... Args>
+  void
+  merge(std::string const &query, LESS less, FUNC &&on_row, Args &&... args)
+  {
+    auto const results{exec_params(query, std::forward<Args>(args)...)};
+
+    // The next row from each shard.  The heap's top is the smallest one.
+    using head = std::pair<std::size_t, result::size_type>;
+    auto const later{[&results, &less](head const &lhs, head const &rhs) {
+      row_ref const left{results[lhs.first], lhs.second},
+        right{results[rhs.first], rhs.second};
+      if (less(right, left))
+        return true;
+      if (less(left, right))
+        return false;
+      return lhs.first > rhs.first;
+    }};
+    std::vector<head> heads;
+    heads.reserve(std::size(results));
+    std::priority_queue<head, std::vector<head>, decltype(later)> queue{
+      later, std::move(heads)};
+    for (std::size_t index{0}; index < std::size(results); ++index)
+      if (not std::empty(results[index]))
+        queue.emplace(index, 0);
+
+    while (not std::empty(queue))
+    {
+      auto const [index, row]{queue.top()};
+      queue.pop();
+      on_row(index, row_ref{results[index], row});
+      if (row + 1 < std::size(results[index]))
+        queue.emplace(index, row + 1);
+    }
+  }
+
+private:
+  using issue_func =
+    std::function<void(connection &, reactor::query_callback &&)>;
+
+  /// Issue a query on each shard, and pass each result to @c on_result.
+  void scatter(issue_func const &issue, result_callback const &on_result);
+
+  /// Register the shards with the reactor.
+  void PQXX_PRIVATE add_shards();
+
+  /// Connections borrowed from pools, if any.
+  std::vector<pooled_connection> m_borrowed;
+  std::vector<connection *> m_shards;
+  reactor m_reactor;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
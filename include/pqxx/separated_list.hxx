@@ -16,6 +16,10 @@
 
 #include <algorithm>
 #include <numeric>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #include "pqxx/strconv.hxx"
 
@@ -26,6 +30,43 @@ namespace pqxx
  */
 //@{
 
+namespace internal
+{
+/// Write the elements from @c begin to @c end, joined by @c sep, to @c out.
+/** Replaces what was in @c out.  Keeps @c out's allocator.
+ */
+template<typename STRING, typename ITER, typename ACCESS>
+inline void separated_list_into(
+  STRING &out, std::string_view sep, ITER begin, ITER end, ACCESS access)
+{
+  out.clear();
+  if (end == begin)
+    return;
+
+  using elt_type =
+    std::remove_const_t<std::remove_reference_t<decltype(access(begin))>>;
+  using traits = string_traits<elt_type>;
+
+  size_t budget{0};
+  for (ITER cnt{begin}; cnt != end; ++cnt)
+    budget += traits::size_buffer(access(cnt));
+  budget += static_cast<size_t>(std::distance(begin, end)) * sep.size();
+
+  out.resize(budget);
+
+  char *here{out.data()};
+  char *stop{here + budget};
+  here = traits::into_buf(here, stop, access(begin)) - 1;
+  for (++begin; begin != end; ++begin)
+  {
+    here += sep.copy(here, sep.size());
+    here = traits::into_buf(here, stop, access(begin)) - 1;
+  }
+  out.resize(static_cast<size_t>(here - out.data()));
+}
+} // namespace internal
+
+
 /// Represent sequence of values as a string, joined by a given separator.
 /**
  * Use this to turn e.g. the numbers 1, 2, and 3 into a string "1, 2, 3".
@@ -47,27 +88,8 @@ separated_list(std::string_view sep, ITER begin, ITER end, ACCESS access)
     return to_string(access(begin));
 
   // From here on, we've got at least 2 elements -- meaning that we need sep.
-  using elt_type =
-    std::remove_const_t<std::remove_reference_t<decltype(access(begin))>>;
-  using traits = string_traits<elt_type>;
-
-  size_t budget{0};
-  for (ITER cnt{begin}; cnt != end; ++cnt)
-    budget += traits::size_buffer(access(cnt));
-  budget += static_cast<size_t>(std::distance(begin, end)) * sep.size();
-
   std::string result;
-  result.resize(budget);
-
-  char *here{result.data()};
-  char *stop{here + budget};
-  here = traits::into_buf(here, stop, access(begin)) - 1;
-  for (++begin; begin != end; ++begin)
-  {
-    here += sep.copy(here, sep.size());
-    here = traits::into_buf(here, stop, access(begin)) - 1;
-  }
-  result.resize(static_cast<size_t>(here - result.data()));
+  internal::separated_list_into(result, sep, begin, end, access);
   return result;
 }
 
@@ -99,38 +121,92 @@ separated_list(std::string_view sep, CONTAINER const &c)
 }
 
 
-/// Render items in a tuple as a string, using given separator.
-template<
-  typename TUPLE, std::size_t INDEX = 0, typename ACCESS,
-  typename std::enable_if<
-    (INDEX == std::tuple_size<TUPLE>::value - 1), int>::type = 0>
-[[nodiscard]] inline std::string separated_list(
-  std::string_view /* sep */, TUPLE const &t, ACCESS const &access)
+#if defined(PQXX_HAVE_PMR)
+/// Render items in a container as a string allocated from @c resource.
+/** Works like the other @c separated_list(), but the string's memory comes
+ * from @c resource, e.g. a per-request arena.
+ */
+template<typename ITER, typename ACCESS>
+[[nodiscard]] inline std::pmr::string separated_list(
+  std::pmr::memory_resource *resource, std::string_view sep, ITER begin,
+  ITER end, ACCESS access)
+{
+  std::pmr::string result{resource};
+  internal::separated_list_into(result, sep, begin, end, access);
+  return result;
+}
+
+
+/// Render items in a container as a string allocated from @c resource.
+template<typename CONTAINER>
+[[nodiscard]] inline std::pmr::string separated_list(
+  std::pmr::memory_resource *resource, std::string_view sep,
+  CONTAINER const &c)
 {
-  return to_string(access(&std::get<INDEX>(t)));
+  using iter = decltype(std::begin(c));
+  return separated_list(
+    resource, sep, std::begin(c), std::end(c), [](iter i) { return *i; });
 }
+#endif
 
+
+namespace internal
+{
+/// Render a tuple's elements, as accessed through @c access, joined by @c sep.
+template<typename TUPLE, typename ACCESS, std::size_t... INDEX>
+inline std::string separated_tuple(
+  std::string_view sep, TUPLE const &t, ACCESS const &access,
+  std::index_sequence<INDEX...>)
+{
+  auto const size_elt{[](auto const &elt) {
+    return string_traits<std::decay_t<decltype(elt)>>::size_buffer(elt);
+  }};
+  std::size_t const budget{
+    (std::size_t{0} + ... + size_elt(access(&std::get<INDEX>(t)))) +
+    sizeof...(INDEX) * std::size(sep)};
+
+  std::string result;
+  result.resize(budget);
+  char *here{result.data()};
+  char *const stop{here + budget};
+  auto const write_elt{[&here, stop, sep](std::size_t index, auto const &elt) {
+    if (index > 0)
+      here += sep.copy(here, std::size(sep));
+    here =
+      string_traits<std::decay_t<decltype(elt)>>::into_buf(here, stop, elt) -
+      1;
+  }};
+  (write_elt(INDEX, access(&std::get<INDEX>(t))), ...);
+  result.resize(static_cast<std::size_t>(here - result.data()));
+  return result;
+}
+} // namespace internal
+
+
+/// Render items in a tuple as a string, using given separator.
+/** The accessor receives a pointer to each of the tuple's elements, and
+ * returns the value to render.
+ *
+ * Like the other versions, this computes the size it needs up front, and
+ * writes each item straight into the result.
+ */
 template<
-  typename TUPLE, std::size_t INDEX = 0, typename ACCESS,
-  typename std::enable_if<
-    (INDEX < std::tuple_size<TUPLE>::value - 1), int>::type = 0>
+  typename TUPLE, typename ACCESS,
+  std::size_t SIZE = std::tuple_size<TUPLE>::value>
 [[nodiscard]] inline std::string
 separated_list(std::string_view sep, TUPLE const &t, ACCESS const &access)
 {
-  std::string out{to_string(access(&std::get<INDEX>(t)))};
-  out.append(sep);
-  out.append(separated_list<TUPLE, INDEX + 1>(sep, t, access));
-  return out;
+  return internal::separated_tuple(
+    sep, t, access, std::make_index_sequence<SIZE>{});
 }
 
 template<
-  typename TUPLE, std::size_t INDEX = 0,
-  typename std::enable_if<
-    (INDEX <= std::tuple_size<TUPLE>::value), int>::type = 0>
+  typename TUPLE, std::size_t SIZE = std::tuple_size<TUPLE>::value>
 [[nodiscard]] inline std::string
 separated_list(std::string_view sep, TUPLE const &t)
 {
-  return separated_list(sep, t, [](TUPLE const &tup) { return *tup; });
+  return separated_list(
+    sep, t, [](auto const *elt) -> decltype(auto) { return *elt; });
 }
 //@}
 } // namespace pqxx
@@ -0,0 +1,263 @@
+/* Definition of the pqxx::spilled_result class.
+ *
+ * pqxx::spilled_result holds a query's rows, and moves them out to a file
+ * once they outgrow a memory limit.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/spilled_result instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_SPILLED_RESULT
+#define PQXX_H_SPILLED_RESULT
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "pqxx/transaction_base.hxx"
+
+
+namespace pqxx::internal
+{
+class mapped_file;
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/// Settings for a @c spilled_result.
+struct spill_config
+{
+  /// Keep up to this many bytes of row data in memory.
+  /** Beyond this, the rows go into a file.  Zero means "always spill."
+   */
+  std::size_t memory_limit = 64 * 1024 * 1024;
+
+  /// Directory for the spill file.  Empty means the system's temp directory.
+  std::string directory;
+
+  /// Rows to receive from the server at a time.
+  /** With a libpq older than 17, the rows come in one at a time regardless.
+   */
+  int chunk_rows = 1000;
+};
+
+
+/// A query's rows, kept in memory up to a limit and in a file beyond that.
+/** A regular @c result holds all of its rows in memory.  For a query that
+ * returns gigabytes of data, that may be more than the machine has.  A
+ * @c spilled_result streams the rows in, as a @c stream_query does, and
+ * stores them in a compact form.  While they fit in @c spill_config's
+ * memory limit, they stay in memory.  Once they outgrow it, they all move
+ * to a file, and further rows go straight there.
+ *
+ * When the query is done, the file gets mapped into memory, where the system
+ * supports that.  The operating system then pages rows in as you read them,
+ * and out again when it needs the memory.  The file is deleted as soon as it
+ * is mapped, or else when the @c spilled_result is destroyed.
+ *
+ * Access the rows through @c operator[] or by iterating.  Each row is a
+ * @c spilled_result::row_view, which offers the fields as views or converted
+ * values, by column number.  Random access is cheap, but iterating is
+ * cheaper.
+ *
+ * Row data is stored as text, as the server sends it.  The column names and
+ * types are available only if the query returned rows.
+ */
+class PQXX_LIBEXPORT spilled_result
+{
+public:
+  using size_type = result_size_type;
+
+  /// A row in a @c spilled_result.
+  /** Only valid as long as the @c spilled_result exists.
+   */
+  class PQXX_LIBEXPORT row_view
+  {
+  public:
+    /// Number of fields in the row.
+    [[nodiscard]] row_size_type size() const noexcept { return m_columns; }
+
+    /// Is field @c col null?
+    [[nodiscard]] bool is_null(row_size_type col) const;
+
+    /// The text of field @c col.  Empty for a null.
+    [[nodiscard]] std::string_view view(row_size_type col) const;
+
+    /// Field @c col, as a @c zview.  Empty for a null.
+    [[nodiscard]] zview c_str(row_size_type col) const;
+
+    /// Convert field @c col to @c T.  A null becomes @c T's null value.
+    /** @throw conversion_error If the field is null, and @c T has no null.
+     */
+    template<typename T> [[nodiscard]] T as(row_size_type col) const
+    {
+      if (is_null(col))
+      {
+        if constexpr (nullness<T>::has_null)
+          return nullness<T>::null();
+        else
+          internal::throw_null_conversion(name_type<T>());
+      }
+      else
+      {
+        return from_string<T>(view(col));
+      }
+    }
+
+    /// Convert the whole row to a tuple of @c TYPE....
+    /** @throw usage_error If the row does not have as many fields as there
+     * are types.
+     */
+    template<typename... TYPE> [[nodiscard]] std::tuple<TYPE...> as() const
+    {
+      check_size(sizeof...(TYPE));
+      return as_tuple<TYPE...>(std::index_sequence_for<TYPE...>{});
+    }
+
+  private:
+    friend class spilled_result;
+    row_view(char const *data, row_size_type columns) noexcept :
+            m_data{data}, m_columns{columns}
+    {}
+
+    /// Find field @c col.  Returns null for a null field.
+    char const *find(row_size_type col, std::uint32_t &len) const;
+    void check_size(std::size_t expected) const;
+
+    template<typename... TYPE, std::size_t... I>
+    std::tuple<TYPE...> as_tuple(std::index_sequence<I...>) const
+    {
+      return std::tuple<TYPE...>{
+        as<TYPE>(static_cast<row_size_type>(I))...};
+    }
+
+    char const *m_data;
+    row_size_type m_columns;
+  };
+
+  /// Iterator over the rows.
+  class PQXX_LIBEXPORT const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = row_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = row_view const *;
+    using reference = row_view;
+
+    const_iterator() noexcept = default;
+
+    [[nodiscard]] row_view operator*() const noexcept
+    {
+      return row_view{m_here, m_columns};
+    }
+    const_iterator &operator++() noexcept;
+    const_iterator operator++(int) noexcept
+    {
+      auto const old{*this};
+      ++*this;
+      return old;
+    }
+    [[nodiscard]] bool operator==(const_iterator const &rhs) const noexcept
+    {
+      return m_here == rhs.m_here;
+    }
+    [[nodiscard]] bool operator!=(const_iterator const &rhs) const noexcept
+    {
+      return m_here != rhs.m_here;
+    }
+
+  private:
+    friend class spilled_result;
+    const_iterator(char const *here, row_size_type columns) noexcept :
+            m_here{here}, m_columns{columns}
+    {}
+
+    char const *m_here = nullptr;
+    row_size_type m_columns = 0;
+  };
+
+  /// Execute @c query, and store its rows.
+  spilled_result(
+    transaction_base &tx, std::string_view query, spill_config config = {});
+  ~spilled_result() noexcept;
+
+  spilled_result(spilled_result const &) = delete;
+  spilled_result &operator=(spilled_result const &) = delete;
+
+  /// Number of rows.
+  [[nodiscard]] size_type size() const noexcept { return m_rows; }
+  [[nodiscard]] bool empty() const noexcept { return m_rows == 0; }
+
+  /// Number of columns.  Zero if the query returned no rows.
+  [[nodiscard]] row_size_type columns() const noexcept
+  {
+    return static_cast<row_size_type>(std::size(m_names));
+  }
+  /// Name of column @c col.
+  [[nodiscard]] std::string const &column_name(row_size_type col) const;
+  /// Type of column @c col.
+  [[nodiscard]] oid column_type(row_size_type col) const;
+
+  /// Did the rows outgrow the memory limit, and go into a file?
+  [[nodiscard]] bool spilled() const noexcept { return m_file != nullptr; }
+  /// Size of the stored row data, in bytes.
+  [[nodiscard]] std::size_t data_size() const noexcept
+  {
+    return std::size(m_data);
+  }
+
+  /// Row number @c row.
+  [[nodiscard]] row_view operator[](size_type row) const;
+  /// Row number @c row, with range check.
+  [[nodiscard]] row_view at(size_type row) const;
+
+  [[nodiscard]] const_iterator begin() const noexcept
+  {
+    return const_iterator{std::data(m_data), columns()};
+  }
+  [[nodiscard]] const_iterator end() const noexcept
+  {
+    return const_iterator{std::data(m_data) + std::size(m_data), columns()};
+  }
+
+private:
+  /// Every how many rows the index records a row's offset.
+  static constexpr size_type index_step{64};
+
+  class writer;
+
+  void finish(writer &);
+
+  std::vector<std::string> m_names;
+  std::vector<oid> m_types;
+  size_type m_rows = 0;
+  /// Offset of every @c index_step-th row.
+  std::vector<std::size_t> m_index;
+  /// The rows, if they stayed in memory.
+  std::string m_memory;
+  /// The rows, if they went into a file.
+  std::unique_ptr<internal::mapped_file> m_file;
+  /// The spill file, if we have not been able to delete it yet.
+  std::string m_path;
+  /// The row data, wherever it is.
+  std::string_view m_data;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -14,16 +14,23 @@
 #include "pqxx/compiler-public.hxx"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <cstring>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <typeinfo>
 
 #if __has_include(<charconv>)
 #  include <charconv>
 #endif
 
+#if defined(PQXX_HAVE_PMR)
+#  include <memory_resource>
+#endif
+
 #include "pqxx/except.hxx"
 #include "pqxx/util.hxx"
 #include "pqxx/zview.hxx"
@@ -33,6 +40,38 @@ namespace pqxx::internal
 {
 /// Attempt to demangle @c std::type_info::name() to something human-readable.
 PQXX_LIBEXPORT std::string demangle_type_name(char const[]);
+
+
+#if defined(__GNUC__) || defined(_MSC_VER)
+#  define PQXX_CONSTEXPR_TYPE_NAME
+
+/// This function's own signature, which spells out @c TYPE.
+template<typename TYPE> constexpr char const *signature()
+{
+#  if defined(_MSC_VER)
+  return __FUNCSIG__;
+#  else
+  return __PRETTY_FUNCTION__;
+#  endif
+}
+
+
+/// Cut @c TYPE's name out of @c signature<TYPE>(), at compile time.
+template<typename TYPE> constexpr std::string_view signature_type_name()
+{
+  std::string_view const sig{signature<TYPE>()};
+#  if defined(_MSC_VER)
+  // "const char *__cdecl pqxx::internal::signature<int>(void)"
+  std::string_view const open{"signature<"}, close{">(void)"};
+#  else
+  // gcc: "constexpr const char* pqxx::internal::signature() [with TYPE = int]"
+  // clang: "const char *pqxx::internal::signature() [TYPE = int]"
+  std::string_view const open{"TYPE = "}, close{"]"};
+#  endif
+  auto const begin{sig.find(open) + std::size(open)};
+  return sig.substr(begin, sig.rfind(close) - begin);
+}
+#endif
 } // namespace pqxx::internal
 
 
@@ -64,16 +103,41 @@ namespace pqxx
 //@{
 
 /// A human-readable name for a type, used in error messages and such.
-/** Actually this may not always be very user-friendly.  It uses
- * @c std::type_info::name().  On gcc-like compilers we try to demangle its
- * output.  Visual Studio produces human-friendly names out of the box.
+/** Actually this may not always be very user-friendly.  With gcc, clang, and
+ * Visual Studio, it is the compiler's own spelling of the type, as it appears
+ * in @c __PRETTY_FUNCTION__ or @c __FUNCSIG__.  That gets worked out at
+ * compile time, so there is no cost at run time.
+ *
+ * With other compilers, it is @c std::type_info::name(), demangled if
+ * possible.  That happens the first time you ask for a type's name, which
+ * is generally when an error message needs it.
+ */
+#if defined(PQXX_CONSTEXPR_TYPE_NAME)
+template<typename TYPE> constexpr std::string_view name_type()
+{
+  return internal::signature_type_name<TYPE>();
+}
+#else
+template<typename TYPE> std::string_view name_type()
+{
+  static std::string const name{
+    internal::demangle_type_name(typeid(TYPE).name())};
+  return name;
+}
+#endif
+
+
+/// A human-readable name for a type, as a @c std::string.
+/** This is the older way of doing what @c name_type() does.  Each instance
+ * is a global variable, initialised at program startup, so avoid it in code
+ * that instantiates it for many types.
  *
  * This variable is not inline.  Inlining it gives rise to "memory leak"
  * warnings from asan, the address sanitizer, possibly from use of
  * @c std::type_info::name.
  */
 template<typename TYPE>
-std::string const type_name{internal::demangle_type_name(typeid(TYPE).name())};
+std::string const type_name{name_type<TYPE>()};
 
 
 /// Traits describing a type's "null value," if any.
@@ -225,9 +289,226 @@ template<typename ENUM> struct enum_traits
  *      int main() { std::cout << pqxx::to_string(xa) << std::endl; }
  */
 #define PQXX_DECLARE_ENUM_CONVERSION(ENUM)                                    \
+  template<> constexpr std::string_view name_type<ENUM>()                     \
+  {                                                                           \
+    return #ENUM;                                                             \
+  }                                                                           \
   template<> struct string_traits<ENUM> : pqxx::internal::enum_traits<ENUM>   \
+  {}
+
+
+namespace pqxx
+{
+template<typename TYPE> struct binary_traits;
+
+/// The SQL labels for the values of an enum type.
+/** Don't specialise this yourself: use @c PQXX_DECLARE_ENUM_LABELS.
+ */
+template<typename ENUM> struct enum_labels;
+} // namespace pqxx
+
+
+namespace pqxx::internal
+{
+/// Hash an enum label.  Each @c seed gives a different hash function.
+[[nodiscard]] constexpr std::uint32_t
+enum_label_hash(std::uint32_t seed, std::string_view label) noexcept
+{
+  // FNV-1a, starting from a seeded value, with some extra mixing at the end
+  // because we only use the lowest bits.
+  std::uint32_t h{2166136261u ^ (seed * 0x9e3779b9u)};
+  for (auto const c : label)
+  {
+    h ^= static_cast<unsigned char>(c);
+    h *= 16777619u;
+  }
+  return h ^ (h >> 16);
+}
+
+
+/// Parameters for a perfect hash of a set of enum labels.
+struct enum_label_hash_params
+{
+  std::uint32_t seed;
+  /// Number of slots in the hash table.  Always a power of two.
+  std::size_t slots;
+};
+
+
+/// Find a hash function which gives each of @c labels a slot of its own.
+/** This runs at compile time.  It tries table sizes from about twice the
+ * number of labels upwards, and a range of seeds for each.
+ */
+template<std::size_t N>
+[[nodiscard]] constexpr enum_label_hash_params
+find_enum_label_hash(std::string_view const (&labels)[N])
+{
+  for (std::size_t i{0}; i < N; ++i)
+    for (std::size_t j{i + 1}; j < N; ++j)
+      if (labels[i] == labels[j])
+        throw std::logic_error{"Duplicate enum label."};
+
+  std::size_t slots{1};
+  while (slots < 2 * N) slots *= 2;
+  for (; slots <= 64 * N; slots *= 2)
+    for (std::uint32_t seed{0}; seed < 1000; ++seed)
+    {
+      bool clash{false};
+      for (std::size_t i{0}; i < N and not clash; ++i)
+        for (std::size_t j{i + 1}; j < N and not clash; ++j)
+          clash = ((enum_label_hash(seed, labels[i]) & (slots - 1)) ==
+                   (enum_label_hash(seed, labels[j]) & (slots - 1)));
+      if (not clash)
+        return {seed, slots};
+    }
+  throw std::logic_error{"Could not find a perfect hash for enum labels."};
+}
+
+
+/// Build the hash table: each slot holds a label's index, or N for "none."
+template<std::size_t SLOTS, std::size_t N>
+[[nodiscard]] constexpr std::array<std::uint16_t, SLOTS>
+make_enum_label_slots(std::string_view const (&labels)[N], std::uint32_t seed)
+{
+  static_assert(N < 0xffff, "Too many enum labels.");
+  std::array<std::uint16_t, SLOTS> slots{};
+  for (std::size_t s{0}; s < SLOTS; ++s) slots[s] = N;
+  for (std::size_t i{0}; i < N; ++i)
+    slots[enum_label_hash(seed, labels[i]) & (SLOTS - 1)] =
+      static_cast<std::uint16_t>(i);
+  return slots;
+}
+
+
+/// Helper class for converting enums to and from their SQL labels.
+/** Use @c PQXX_DECLARE_ENUM_LABELS to define these conversions.
+ *
+ * Converting a label to an enum value takes one hash, one table lookup, and
+ * one string comparison.  The hash table is built at compile time.
+ * Converting an enum value to its label is an array lookup.
+ */
+template<typename ENUM> struct enum_label_traits
+{
+  static constexpr auto &labels{enum_labels<ENUM>::labels};
+  static constexpr std::size_t count{std::size(enum_labels<ENUM>::labels)};
+  static constexpr auto hash{find_enum_label_hash(enum_labels<ENUM>::labels)};
+  static constexpr auto slots{make_enum_label_slots<hash.slots>(
+    enum_labels<ENUM>::labels, hash.seed)};
+
+  /// The label for @c value.
+  [[nodiscard]] static std::string_view label(ENUM const &value)
+  {
+    auto const index{static_cast<std::size_t>(
+      static_cast<std::underlying_type_t<ENUM>>(value))};
+    if (index >= count)
+      throw conversion_error{
+        "Value out of range for " + std::string{name_type<ENUM>()} + "."};
+    return labels[index];
+  }
+
+  [[nodiscard]] static ENUM from_string(std::string_view text)
+  {
+    auto const slot{enum_label_hash(hash.seed, text) & (hash.slots - 1)};
+    auto const index{slots[slot]};
+    if (index < count and labels[index] == text)
+      return static_cast<ENUM>(index);
+    throw conversion_error{
+      "Unknown label for " + std::string{name_type<ENUM>()} + ": '" +
+      std::string{text} + "'."};
+  }
+
+  static char *into_buf(char *begin, char *end, ENUM const &value)
+  {
+    auto const text{label(value)};
+    auto const size{std::size(text)};
+    if (end - begin <= static_cast<std::ptrdiff_t>(size))
+      throw conversion_overrun{
+        "Not enough buffer space for " + std::string{name_type<ENUM>()} +
+        "."};
+    std::memcpy(begin, std::data(text), size);
+    begin[size] = '\0';
+    return begin + size + 1;
+  }
+
+  [[nodiscard]] static zview to_buf(char *begin, char *end, ENUM const &value)
+  {
+    auto const stop{into_buf(begin, end, value)};
+    return zview{begin, static_cast<std::size_t>(stop - begin - 1)};
+  }
+
+  [[nodiscard]] static std::size_t size_buffer(ENUM const &value)
+  {
+    return std::size(label(value)) + 1;
+  }
+};
+
+
+/// Binary conversions for an enum with SQL labels.
+/** In binary format, an SQL enum value is just its label.
+ */
+template<typename ENUM> struct enum_label_binary_traits
+{
+  [[nodiscard]] static ENUM from_binary(std::string_view data)
+  {
+    return enum_label_traits<ENUM>::from_string(data);
+  }
+
+  [[nodiscard]] static std::size_t binary_size(ENUM const &value)
+  {
+    return std::size(enum_label_traits<ENUM>::label(value));
+  }
+
+  static char *into_binary(char *begin, char *end, ENUM const &value)
+  {
+    auto const text{enum_label_traits<ENUM>::label(value)};
+    auto const size{std::size(text)};
+    if (end - begin < static_cast<std::ptrdiff_t>(size))
+      throw conversion_overrun{
+        "Not enough buffer space for " + std::string{name_type<ENUM>()} +
+        "."};
+    std::memcpy(begin, std::data(text), size);
+    return begin + size;
+  }
+};
+} // namespace pqxx::internal
+
+
+/// Macro: Define conversions between an enum and the labels of an SQL enum.
+/** PostgreSQL's enum types transfer as their labels, in text and in binary
+ * format alike.  This macro defines conversions between a C++ enum and
+ * those labels, both in @c string_traits and in @c binary_traits.  So you
+ * can read the enum from a result field or a @c stream_from, and write it
+ * as a parameter or into a @c stream_to.
+ *
+ * List the labels in the order of the enum's values, starting at zero.  So
+ * the enum's values must be 0, 1, 2, and so on, without gaps.
+ *
+ * Use it in the @c ::pqxx namespace.  For example:
+ *
+ *      enum class mood { sad, ok, happy };
+ *      namespace pqxx
+ *      {
+ *      PQXX_DECLARE_ENUM_LABELS(mood, "sad", "ok", "happy");
+ *      }
+ *
+ * To write the enum in binary format, you'll need to include
+ * @c pqxx/binary_traits.
+ */
+#define PQXX_DECLARE_ENUM_LABELS(ENUM, ...)                                   \
+  template<> constexpr std::string_view name_type<ENUM>()                     \
+  {                                                                           \
+    return #ENUM;                                                             \
+  }                                                                           \
+  template<> struct enum_labels<ENUM>                                         \
+  {                                                                           \
+    static constexpr std::string_view labels[]{__VA_ARGS__};                  \
+  };                                                                          \
+  template<>                                                                  \
+  struct string_traits<ENUM> : pqxx::internal::enum_label_traits<ENUM>        \
   {};                                                                         \
-  template<> std::string const type_name<ENUM> { #ENUM }
+  template<>                                                                  \
+  struct binary_traits<ENUM> : pqxx::internal::enum_label_binary_traits<ENUM> \
+  {}
 
 
 namespace pqxx
@@ -277,9 +558,25 @@ template<typename TYPE> inline std::string to_string(TYPE const &value);
 /// Convert a value to a readable string that PostgreSQL will understand.
 /** This variant of to_string can sometimes save a bit of time in loops, by
  * re-using a std::string for multiple conversions.
+ *
+ * The string may have any allocator, e.g. a @c std::pmr::string.
+ */
+template<typename TYPE, typename ALLOC>
+inline void into_string(
+  TYPE const &value,
+  std::basic_string<char, std::char_traits<char>, ALLOC> &out);
+
+
+#if defined(PQXX_HAVE_PMR)
+/// Convert a value to a string, allocated from @c resource.
+/** Works like the other @c to_string, but the string's memory comes from
+ * @c resource.  With an arena such as @c std::pmr::monotonic_buffer_resource,
+ * that lets you free all the strings you made in one go.
  */
 template<typename TYPE>
-inline void into_string(TYPE const &value, std::string &out);
+inline std::pmr::string
+to_string(TYPE const &value, std::pmr::memory_resource *resource);
+#endif
 
 
 /// Is @c value null?
@@ -313,5 +610,17 @@ template<typename T> inline constexpr char array_separator{','};
 } // namespace pqxx
 
 
+namespace pqxx::internal
+{
+/// Is @c T a @c std::basic_string of @c char, with any allocator?
+template<typename T> inline constexpr bool is_char_string{false};
+
+template<typename ALLOC>
+inline constexpr bool
+  is_char_string<std::basic_string<char, std::char_traits<char>, ALLOC>>{
+    true};
+} // namespace pqxx::internal
+
+
 #include "pqxx/internal/conversions.hxx"
 #endif
@@ -16,34 +16,155 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <array>
+#include <functional>
+#include <memory>
 #include <variant>
+#include <vector>
 
+#include "pqxx/binary_traits.hxx"
+#include "pqxx/internal/column_batch.hxx"
 #include "pqxx/except.hxx"
 #include "pqxx/internal/stream_iterator.hxx"
 #include "pqxx/separated_list.hxx"
 #include "pqxx/transaction_base.hxx"
 
 
+namespace pqxx::internal
+{
+class copy_reader;
+} // namespace pqxx::internal
+
+
+namespace pqxx::internal::gate
+{
+class stream_from_arrow_reader;
+class stream_from_table_copy;
+} // namespace pqxx::internal::gate
+
+
 namespace pqxx
 {
+/// Marker for @c stream_from constructors: "stream from a query."
+struct from_query_t
+{};
+
+
+/// Pass this to a @c stream_from constructor to stream query results.
+constexpr from_query_t from_query;
+
+
 /// Efficiently pull data directly out of a table.
+/** By default the data comes in COPY's text format.  Pass @c format::binary
+ * to have it come in binary format instead.  That saves the work of finding
+ * field boundaries and unescaping the data, and for numbers it saves space as
+ * well.  But in binary format, you can only read fields as types which have
+ * @c binary_traits.
+ *
+ * Normally, reading from the stream waits until data arrives.  If you'd rather
+ * serve several streams from one thread, use @c try_read() instead.  It never
+ * waits: if there is no row available yet, it returns
+ * @c read_status::would_block, and you can wait for @c sock() to become
+ * readable, e.g. using @c poll() or @c epoll.  (Creating the stream still
+ * waits for the server to start the COPY.)
+ *
+ * A stream can also read the results of a query, instead of a table: see
+ * @c stream_from::query().
+ */
 class PQXX_LIBEXPORT stream_from : internal::transactionfocus
 {
 public:
+  /// Outcome of a non-blocking read: see @c try_read().
+  enum class read_status
+  {
+    /// Read a row.
+    row,
+    /// No row available yet.  Wait for the socket to become readable.
+    would_block,
+    /// The stream has ended.
+    done,
+  };
+
   stream_from(transaction_base &, std::string_view table_name);
+  stream_from(
+    transaction_base &, std::string_view table_name, format data_format);
   template<typename Columns>
   stream_from(
     transaction_base &, std::string_view table_name, Columns const &columns);
+  template<typename Columns>
+  stream_from(
+    transaction_base &, std::string_view table_name, Columns const &columns,
+    format data_format);
   template<typename Iter>
   stream_from(
     transaction_base &, std::string_view table_name, Iter columns_begin,
     Iter columns_end);
+  template<typename Iter>
+  stream_from(
+    transaction_base &, std::string_view table_name, Iter columns_begin,
+    Iter columns_end, format data_format);
+
+  /// Stream all of a table's columns, as described.
+  /** Get the description from @c connection::describe_table().  It's cached
+   * on the connection, so streaming from the same table again and again
+   * costs no extra round trips.
+   */
+  stream_from(
+    transaction_base &, table_description const &table,
+    format data_format = format::text);
+
+  /// Stream rows of @c TYPE... from a table, checking them against it.
+  /** Looks up the table's columns using @c connection::describe_table(), so
+   * only the first stream for a table on a connection costs a round trip.
+   * The rows must have one field for each of the table's columns.
+   *
+   * If each of the types can read its column's SQL type from binary, the
+   * stream uses binary format.  Otherwise, it uses text format.
+   *
+   * @throw usage_error If the number of types does not match the number of
+   * columns.
+   */
+  template<typename... TYPE>
+  [[nodiscard]] static stream_from
+  checked(transaction_base &tb, std::string_view table_name)
+  {
+    auto const &table{tb.conn().describe_table(table_name)};
+    if (std::size(table.column_types) != sizeof...(TYPE))
+      throw usage_error{
+        "Streaming " + to_string(sizeof...(TYPE)) + " field(s) per row from " +
+        std::string{table_name} + ", which has " +
+        to_string(std::size(table.column_types)) + " column(s)."};
+    return stream_from{
+      tb, table,
+      table.binary_readable<TYPE...>() ? format::binary : format::text};
+  }
+
+  /// Stream the results of a query, instead of a table.
+  /** The query can be anything that COPY accepts in parentheses: a
+   * @c SELECT, with any joins, conditions, or computations, or a
+   * @c VALUES list, and so on.  It must not end in a semicolon.
+   */
+  stream_from(
+    transaction_base &, from_query_t, std::string_view query,
+    format data_format = format::text);
+
+  /// Factory: stream the results of a query.  See the @c from_query_t
+  /// constructor.
+  [[nodiscard]] static stream_from query(
+    transaction_base &tb, std::string_view q,
+    format data_format = format::text)
+  {
+    return stream_from{tb, from_query, q, data_format};
+  }
 
   ~stream_from() noexcept;
 
   [[nodiscard]] operator bool() const noexcept { return not m_finished; }
   [[nodiscard]] bool operator!() const noexcept { return m_finished; }
 
+  /// Is this stream reading text or binary COPY data?
+  [[nodiscard]] format data_format() const noexcept { return m_format; }
+
   /// Finish this stream.  Call this before continuing to use the connection.
   /** Consumes all remaining lines, and closes the stream.
    *
@@ -53,9 +174,116 @@ public:
    */
   void complete();
 
+  /// Read a raw line of text from the COPY command, as a copy.
   bool get_raw_line(std::string &);
+
+  /// Read a raw line of text from the COPY command, without copying it.
+  /** Returns @c false at the end of the data.  Otherwise, sets @c line to a
+   * view on libpq's own buffer.  The line stays valid until the next read
+   * from this stream, or until the stream is destroyed.
+   *
+   * In text format, the line includes its terminating newline.
+   */
+  bool get_raw_line(std::string_view &line);
+
+  /// Write all remaining COPY data to file descriptor @c fd, as-is.
+  /** This is the fast way to dump a table or query to a file or pipe.  The
+   * data goes out exactly as the server sends it, in the stream's format,
+   * with no conversion or copying.  Where the system supports it, each
+   * system call writes a batch of rows straight out of libpq's buffers.
+   *
+   * In binary format the output includes the header, if you haven't read
+   * any rows yet, and the trailer.  So a complete binary dump is a valid
+   * binary COPY file.
+   *
+   * Closes the stream once all data is written.  Does not close @c fd.
+   *
+   * @return The number of bytes written.
+   */
+  std::size_t to_fd(int fd);
+
   template<typename Tuple> stream_from &operator>>(Tuple &);
 
+  /// Read a row if one is available, without waiting for one.
+  /** Returns @c read_status::row if it read a row into the tuple.  If no row
+   * is available yet, returns @c read_status::would_block: wait for the
+   * connection's socket to become readable, and try again.  At the end of
+   * the data, returns @c read_status::done and closes the stream.
+   */
+  template<typename Tuple> read_status try_read(Tuple &);
+
+  /// Read a raw line if one is available, without waiting for one.
+  /** Works like @c try_read(), but gives you the line as it came in, like
+   * @c get_raw_line() does.
+   */
+  read_status try_get_raw_line(std::string_view &line);
+
+  /// The connection's socket, for waiting until more data arrives.
+  [[nodiscard]] int sock() const noexcept;
+
+  /// Default number of chunks for @c read_in_background().
+  static constexpr std::size_t default_chunks{8};
+
+  /// Default size of a chunk for @c read_in_background(), in bytes.
+  static constexpr std::size_t default_chunk_size{64 * 1024};
+
+  /// Receive the rest of the data in a separate thread.
+  /** Starts a thread that reads the COPY data off the connection, while your
+   * own thread parses the rows.  This helps when parsing takes about as much
+   * time as receiving, e.g. when the server is far away, or the rows are
+   * large.
+   *
+   * The reader thread copies lines into reusable chunks of about
+   * @c chunk_size bytes each, and hands over each chunk once it's full, or
+   * once no more data is ready to read.  It gets at most @c chunks ahead
+   * of you; after that it waits for you to catch up.
+   *
+   * Until the stream finishes, leave the connection alone: the reader thread
+   * is using it.  You can't use @c try_read() or @c try_get_raw_line() on the
+   * stream any more either.  A line you read stays valid until your next
+   * read, as usual.
+   *
+   * If you close the stream before reaching the end of the data, it waits
+   * for the reader thread to finish the read that it's doing.
+   *
+   * @throw usage_error If the stream has finished, or is already reading in
+   *     the background.
+   */
+  void read_in_background(
+    std::size_t chunks = default_chunks,
+    std::size_t chunk_size = default_chunk_size);
+
+  /// Rows and bytes read so far, and time spent waiting for them.
+  /** Once the stream has finished, the times stay as they were then.
+   *
+   * The connection's query hook gets the waiting time as well, along with
+   * its report on the COPY.
+   */
+  [[nodiscard]] stream_stats stats() const noexcept;
+
+  /// Read a batch of up to @c max_rows rows, one column at a time.
+  /** Instead of reading a row into a tuple, appends each field to its
+   * column's @c column_batch.  Pass one @c column_batch for each column in
+   * the stream.  This saves you having to turn rows into columns, if that is
+   * what your code needs.
+   *
+   * Empties the batches before it starts, but keeps their memory allocated.
+   * So if you keep re-using the same batches, they will stop allocating
+   * memory once they've grown to @c max_rows.
+   *
+   * Returns the number of rows read; zero at the end of the stream.
+   */
+  template<typename... TYPE>
+  std::size_t read_columns(std::size_t max_rows, column_batch<TYPE> &...);
+
+  /// Call @c func on each remaining row, passing its fields as @c TYPE....
+  /** The fields may be views, such as @c std::string_view, even where they
+   * need unescaping.  They stay valid until @c func returns, but no longer.
+   *
+   * Reads the stream to its end.
+   */
+  template<typename... TYPE, typename CALLABLE> void for_each(CALLABLE &&func);
+
   /// Doing this with a @c std::variant is going to be horrifically borked.
   template<typename... Vs>
   stream_from &operator>>(std::variant<Vs...> &) = delete;
@@ -67,43 +295,131 @@ public:
    */
   template<typename... TYPE> [[nodiscard]] auto iter()
   {
-    return pqxx::internal::stream_input_iteration<TYPE...>{*this};
+    return pqxx::internal::stream_input_iteration<stream_from, TYPE...>{
+      *this};
   }
 
 private:
+  friend class internal::gate::stream_from_arrow_reader;
+  friend class internal::gate::stream_from_table_copy;
+
   internal::encoding_group m_copy_encoding =
     internal::encoding_group::MONOBYTE;
-  std::string m_current_line;
+  /// Buffer holding the current line, as libpq gave it to us.
+  internal::pq_buffer m_line_buf{nullptr, internal::pq_freemem};
+  /// The current line, as a view on @c m_line_buf.
+  std::string_view m_line;
   bool m_finished = false;
   bool m_retry_line = false;
+  /// Non-blocking reads: the data has ended, but the COPY has not.
+  bool m_draining = false;
+  format m_format = format::text;
+
+  /// In binary format: have we seen the COPY data's header yet?
+  bool m_binary_header_done = false;
+  /// In binary format: offset of the current row's first field.
+  std::string::size_type m_binary_row_start = 0;
+  /// In binary format: number of fields in the current row.
+  std::size_t m_binary_fields = 0;
+  /// In text format: scratch space for unescaping fields, re-used per row.
+  std::string m_workspace;
+
+  /// When the COPY started.
+  std::chrono::steady_clock::time_point m_start;
+  /// The connection's total COPY waiting time when the COPY started.
+  std::chrono::steady_clock::duration m_blocked_before{0};
+  /// Rows and bytes so far.  Once finished, the times as well.
+  stream_stats m_stats;
+  /// Thread reading the data, if reading in the background.
+  std::shared_ptr<internal::copy_reader> m_reader;
+  /// The stats as of now, for an unfinished stream.
+  stream_stats live_stats() const noexcept;
+
+  /// Count the line that we just read into @c m_line.
+  void count_line() noexcept;
 
   void set_up(transaction_base &, std::string_view table_name);
   void set_up(
     transaction_base &, std::string_view table_name,
     std::string const &columns);
+  /// Start the COPY command.
+  void start_copy(transaction_base &, std::string const &copy_command);
+
+  /// Read the next row of binary data into @c m_line.
+  /** Returns @c false at the end of the data.
+   */
+  bool get_binary_row();
+
+  /// Parse the binary row in @c m_line.  Returns @c false for the trailer.
+  bool parse_binary_row();
+
+  /// Read the next row as raw COPY data, in the stream's format.
+  /** Leaves out the binary format's header and trailer, so that the rows
+   * can go into another stream as they are.  A text row ends in a newline
+   * only if the server sent one.  Returns @c false at the end of the data.
+   */
+  bool get_raw_row(std::string_view &row);
+
+  /// Find the next field in a binary row.  Returns @c false for null.
+  bool next_binary_field(std::string::size_type &, std::string_view &) const;
+
+  template<typename T>
+  void extract_binary_value(T &t, std::string::size_type &here) const;
+
+  template<typename Tuple, std::size_t... I>
+  void do_extract_binary(Tuple &t, std::index_sequence<I...>)
+  {
+    check_binary_fields(std::tuple_size_v<Tuple>);
+    auto here{m_binary_row_start};
+    (extract_binary_value(std::get<I>(t), here), ...);
+  }
+
+  /// Throw @c usage_error if the binary row does not have @c fields fields.
+  void check_binary_fields(std::size_t fields) const;
+
+  /// Throw @c usage_error if we stopped extracting before the end of a line.
+  static void check_line_end(std::string_view line, std::string::size_type);
+
+  /// Append the field at @c here to @c column.
+  template<typename T>
+  void append_field(
+    column_batch<T> &column, std::string::size_type &here,
+    std::string &workspace) const;
 
   void close();
 
+  /// Find the next field in a text row.  Returns @c false for null.
+  /** Sets @c field to the field's text.  Where possible, that is a view on
+   * @c line; only fields with escape sequences get unescaped into
+   * @c workspace.
+   */
   bool extract_field(
-    std::string const &, std::string::size_type &, std::string &) const;
+    std::string_view line, std::string::size_type &,
+    std::string &workspace, std::string_view &field) const;
 
   template<typename T>
   void extract_value(
-    std::string const &line, T &t, std::string::size_type &here,
+    std::string_view line, T &t, std::string::size_type &here,
     std::string &workspace) const;
 
   template<typename Tuple, std::size_t... I>
   void do_extract(
-    const std::string &line, Tuple &t, std::string &workspace,
+    std::string_view line, Tuple &t, std::string &workspace,
     std::index_sequence<I...>)
   {
     std::string::size_type here{};
     (extract_value(line, std::get<I>(t), here, workspace), ...);
-    if (
-      here < line.size() and
-      not(here == line.size() - 1 and line[here] == '\n'))
-      throw usage_error{"Not all fields extracted from stream_from line"};
+    check_line_end(line, here);
   }
+
+  /// Convert a field for @c for_each().  It may come out as a view on @c data.
+  template<typename T>
+  T field_as(bool not_null, std::string_view data) const;
+
+  template<typename... TYPE, typename CALLABLE, std::size_t... I>
+  void call_row(
+    CALLABLE &func, std::array<std::string, sizeof...(TYPE)> &workspaces,
+    std::index_sequence<I...>);
 };
 
 
@@ -114,6 +430,15 @@ inline stream_from::stream_from(
 {}
 
 
+template<typename Columns>
+inline stream_from::stream_from(
+  transaction_base &tb, std::string_view table_name, Columns const &columns,
+  format data_format) :
+        stream_from{
+          tb, table_name, std::begin(columns), std::end(columns), data_format}
+{}
+
+
 template<typename Iter>
 inline stream_from::stream_from(
   transaction_base &tb, std::string_view table_name, Iter columns_begin,
@@ -125,19 +450,46 @@ inline stream_from::stream_from(
 }
 
 
+template<typename Iter>
+inline stream_from::stream_from(
+  transaction_base &tb, std::string_view table_name, Iter columns_begin,
+  Iter columns_end, format data_format) :
+        namedclass{"stream_from", table_name},
+        transactionfocus{tb},
+        m_format{data_format}
+{
+  set_up(tb, table_name, separated_list(",", columns_begin, columns_end));
+}
+
+
 template<typename Tuple> stream_from &stream_from::operator>>(Tuple &t)
 {
-  if (m_retry_line or get_raw_line(m_current_line))
+  if (m_format == format::binary)
+  {
+    if (m_retry_line or get_binary_row())
+    {
+      try
+      {
+        constexpr auto tsize = std::tuple_size_v<Tuple>;
+        do_extract_binary(t, std::make_index_sequence<tsize>{});
+        m_retry_line = false;
+      }
+      catch (...)
+      {
+        m_retry_line = true;
+        throw;
+      }
+    }
+    return *this;
+  }
+
+  if (m_retry_line or get_raw_line(m_line))
   {
-    // This is just a scratchpad for functions further down to play with.
-    // We allocate it here so that we can keep re-using its buffer, rather
-    // than always allocating new ones.
-    std::string workspace;
     try
     {
       constexpr auto tsize = std::tuple_size_v<Tuple>;
       using indexes = std::make_index_sequence<tsize>;
-      do_extract(m_current_line, t, workspace, indexes{});
+      do_extract(m_line, t, m_workspace, indexes{});
       m_retry_line = false;
     }
     catch (...)
@@ -150,23 +502,267 @@ template<typename Tuple> stream_from &stream_from::operator>>(Tuple &t)
 }
 
 
+template<typename Tuple>
+stream_from::read_status stream_from::try_read(Tuple &t)
+{
+  if (not m_retry_line)
+  {
+    read_status status;
+    do
+    {
+      status = try_get_raw_line(m_line);
+      if (status != read_status::row)
+        return status;
+    } while (m_format == format::binary and not parse_binary_row());
+  }
+
+  try
+  {
+    constexpr auto tsize = std::tuple_size_v<Tuple>;
+    using indexes = std::make_index_sequence<tsize>;
+    if (m_format == format::binary)
+    {
+      do_extract_binary(t, indexes{});
+    }
+    else
+    {
+      do_extract(m_line, t, m_workspace, indexes{});
+    }
+    m_retry_line = false;
+  }
+  catch (...)
+  {
+    m_retry_line = true;
+    throw;
+  }
+  return read_status::row;
+}
+
+
+template<typename... TYPE, typename CALLABLE>
+void stream_from::for_each(CALLABLE &&func)
+{
+  // One workspace per column, so that unescaping a field does not overwrite
+  // the one before it.
+  std::array<std::string, sizeof...(TYPE)> workspaces;
+  for (;;)
+  {
+    if (not m_retry_line)
+    {
+      bool const got_row{
+        (m_format == format::binary) ? get_binary_row() :
+                                       get_raw_line(m_line)};
+      if (not got_row)
+        break;
+    }
+    // A row that fails does not come back: func may have seen part of it.
+    m_retry_line = false;
+    call_row<TYPE...>(func, workspaces, std::index_sequence_for<TYPE...>{});
+  }
+}
+
+
+template<typename T>
+T stream_from::field_as(bool not_null, std::string_view data) const
+{
+  if (not not_null)
+  {
+    if constexpr (nullness<T>::has_null)
+      return nullness<T>::null();
+    else
+      internal::throw_null_conversion(name_type<T>());
+  }
+  else if (m_format == format::text)
+  {
+    return from_string<T>(data);
+  }
+  else if constexpr (
+    std::is_same_v<T, std::string> or std::is_same_v<T, std::string_view>)
+  {
+    return T{data};
+  }
+  else if constexpr (has_binary_traits<T>)
+  {
+    return binary_traits<T>::from_binary(data);
+  }
+  else
+  {
+    throw conversion_error{
+      "No conversion from binary format to " +
+      std::string{name_type<T>()} + "."};
+  }
+}
+
+
+template<typename... TYPE, typename CALLABLE, std::size_t... I>
+void stream_from::call_row(
+  CALLABLE &func, std::array<std::string, sizeof...(TYPE)> &workspaces,
+  std::index_sequence<I...>)
+{
+  constexpr auto fields{sizeof...(TYPE)};
+  std::array<std::string_view, fields> data;
+  std::array<bool, fields> not_null;
+  if (m_format == format::binary)
+  {
+    check_binary_fields(fields);
+    auto here{m_binary_row_start};
+    ((not_null[I] = next_binary_field(here, data[I])), ...);
+  }
+  else
+  {
+    std::string::size_type here{0};
+    ((not_null[I] = extract_field(m_line, here, workspaces[I], data[I])),
+     ...);
+    check_line_end(m_line, here);
+  }
+  std::invoke(func, field_as<TYPE>(not_null[I], data[I])...);
+}
+
+
+template<typename... TYPE>
+std::size_t
+stream_from::read_columns(std::size_t max_rows, column_batch<TYPE> &...columns)
+{
+  (columns.clear(), ...);
+  std::size_t rows{0};
+  while (rows < max_rows)
+  {
+    if (not m_retry_line)
+    {
+      bool const got_row{
+        (m_format == format::binary) ? get_binary_row() :
+                                       get_raw_line(m_line)};
+      if (not got_row)
+        break;
+    }
+
+    try
+    {
+      if (m_format == format::binary)
+      {
+        check_binary_fields(sizeof...(TYPE));
+        auto here{m_binary_row_start};
+        (append_field(columns, here, m_workspace), ...);
+      }
+      else
+      {
+        std::string::size_type here{0};
+        (append_field(columns, here, m_workspace), ...);
+        check_line_end(m_line, here);
+      }
+      m_retry_line = false;
+    }
+    catch (...)
+    {
+      // Leave every column with just the complete rows.
+      (columns.truncate(rows), ...);
+      m_retry_line = true;
+      throw;
+    }
+    ++rows;
+  }
+  return rows;
+}
+
+
+template<typename T>
+void stream_from::append_field(
+  column_batch<T> &column, std::string::size_type &here,
+  std::string &workspace) const
+{
+  static_assert(
+    not internal::is_text_view<T>,
+    "Can't stream into a view: the text does not outlive the field.");
+  bool not_null;
+  if (m_format == format::binary)
+  {
+    std::string_view data;
+    not_null = next_binary_field(here, data);
+    if (not_null)
+    {
+      if constexpr (has_binary_traits<T>)
+        column.values.push_back(binary_traits<T>::from_binary(data));
+      else
+        throw conversion_error{
+          "No conversion from binary format to " +
+          std::string{name_type<T>()} + "."};
+    }
+  }
+  else
+  {
+    std::string_view field;
+    not_null = extract_field(m_line, here, workspace, field);
+    if (not_null)
+      column.values.push_back(from_string<T>(field));
+  }
+
+  if (not not_null)
+  {
+    if constexpr (nullness<T>::has_null)
+      column.values.push_back(nullness<T>::null());
+    else
+      column.values.emplace_back();
+  }
+  column.nulls.push_back(not not_null);
+}
+
+
 template<typename T>
 void stream_from::extract_value(
-  std::string const &line, T &t, std::string::size_type &here,
+  std::string_view line, T &t, std::string::size_type &here,
   std::string &workspace) const
 {
-  if (extract_field(line, here, workspace))
-    t = from_string<T>(workspace);
+  static_assert(
+    not internal::is_text_view<T>,
+    "Can't stream into a view: the text does not outlive the field.");
+  std::string_view field;
+  if (extract_field(line, here, workspace, field))
+  {
+    // Re-use the string's storage, instead of building a new one.
+    if constexpr (std::is_same_v<T, std::string>)
+      t.assign(field);
+    else
+      t = from_string<T>(field);
+  }
   else if constexpr (nullness<T>::has_null)
     t = nullness<T>::null();
   else
-    internal::throw_null_conversion(type_name<T>);
+    internal::throw_null_conversion(name_type<T>());
 }
 
 template<>
 void PQXX_LIBEXPORT stream_from::extract_value<std::nullptr_t>(
-  std::string const &line, std::nullptr_t &, std::string::size_type &here,
+  std::string_view line, std::nullptr_t &, std::string::size_type &here,
   std::string &workspace) const;
+
+
+template<typename T>
+void stream_from::extract_binary_value(
+  T &t, std::string::size_type &here) const
+{
+  std::string_view data;
+  if (next_binary_field(here, data))
+  {
+    if constexpr (std::is_same_v<T, std::nullptr_t>)
+      throw conversion_error{"Attempt to convert non-null field to null."};
+    else if constexpr (std::is_same_v<T, std::string>)
+      t.assign(data);
+    else if constexpr (has_binary_traits<T>)
+      t = binary_traits<T>::from_binary(data);
+    else
+      throw conversion_error{
+        "No conversion from binary format to " +
+        std::string{name_type<T>()} + "."};
+  }
+  else if constexpr (nullness<T>::has_null)
+  {
+    t = nullness<T>::null();
+  }
+  else
+  {
+    internal::throw_null_conversion(name_type<T>());
+  }
+}
 } // namespace pqxx
 
 #include "pqxx/internal/compiler-internal-post.hxx"
@@ -0,0 +1,193 @@
+/* Definition of the pqxx::stream_query class.
+ *
+ * pqxx::stream_query reads the results of a query one row at a time.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/stream_query instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_STREAM_QUERY
+#define PQXX_H_STREAM_QUERY
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <functional>
+#include <memory>
+#include <variant>
+
+#include "pqxx/except.hxx"
+#include "pqxx/internal/stream_iterator.hxx"
+#include "pqxx/transaction_base.hxx"
+
+
+namespace pqxx
+{
+/// Read the results of an arbitrary query, without holding them all in memory.
+/** A regular query produces a @c result, which holds all of the query's rows
+ * in memory at once.  A stream_query receives the rows as the server sends
+ * them, and lets go of each one as soon as you move on to the next.  So it
+ * uses a constant amount of memory, however large the result set.
+ *
+ * Unlike @c stream_from, this works with any query, not just with full
+ * tables.  On the other hand, @c stream_from may be faster.
+ *
+ * As long as the stream is open, the transaction can't execute other
+ * queries.  Read it to the end, or call @c complete(), before you do.
+ */
+class PQXX_LIBEXPORT stream_query : internal::transactionfocus
+{
+public:
+  /// Execute @c query, and receive its results one row at a time.
+  stream_query(transaction_base &, std::string_view query);
+
+  /// Execute @c query, and receive its results in chunks of rows.
+  /** Each chunk holds up to @c chunk_rows rows.  This requires a libpq which
+   * supports chunked mode (version 17 or better).  With older versions, the
+   * stream falls back to receiving one row at a time.
+   */
+  stream_query(transaction_base &, std::string_view query, int chunk_rows);
+
+  ~stream_query() noexcept;
+
+  [[nodiscard]] operator bool() const noexcept { return not m_finished; }
+  [[nodiscard]] bool operator!() const noexcept { return m_finished; }
+
+  /// Finish this stream.  Call this before continuing to use the connection.
+  /** Reads and discards any rows you haven't read yet.
+   *
+   * This may take a while if you're abandoning the stream before it's done.
+   */
+  void complete();
+
+  /// Receive the next batch of rows.
+  /** Returns an empty result when the stream has ended.
+   *
+   * Don't mix this with the streaming operator: any rows which @c operator>>
+   * has already received but not yet extracted will be skipped.
+   */
+  result read_chunk();
+
+  /// Read one row into a tuple.
+  /** The tuple must have exactly as many elements as the result has columns.
+   * If there are no more rows, leaves @c t unchanged and closes the stream.
+   */
+  template<typename Tuple> stream_query &operator>>(Tuple &t);
+
+  /// Call @c func on each remaining row, passing its fields as @c TYPE....
+  /** The fields may be views, such as @c std::string_view.  They stay valid
+   * until @c func returns, but no longer.
+   *
+   * Reads the stream to its end.
+   */
+  template<typename... TYPE, typename CALLABLE> void for_each(CALLABLE &&func);
+
+  /// Doing this with a @c std::variant is going to be horrifically borked.
+  template<typename... Vs>
+  stream_query &operator>>(std::variant<Vs...> &) = delete;
+
+  /// Iterate over this stream.  Supports range-based "for" loops.
+  /** Produces an input iterator over the stream.
+   *
+   * Do not call this yourself.  Use it like "for (auto data : stream.iter())".
+   */
+  template<typename... TYPE> [[nodiscard]] auto iter()
+  {
+    return pqxx::internal::stream_input_iteration<stream_query, TYPE...>{
+      *this};
+  }
+
+private:
+  std::shared_ptr<std::string> m_query;
+  internal::encoding_group m_encoding = internal::encoding_group::MONOBYTE;
+  result m_chunk;
+  result::size_type m_chunk_row = 0;
+  bool m_finished = false;
+
+  void set_up(int chunk_rows);
+  void close();
+
+  template<typename T> static void extract_value(field const &f, T &t)
+  {
+    // Re-use the string's storage, instead of building a new one.
+    if constexpr (std::is_same_v<T, std::string>)
+    {
+      if (f.is_null())
+        internal::throw_null_conversion(name_type<T>());
+      t.assign(f.view());
+    }
+    else
+    {
+      t = f.as<T>();
+    }
+  }
+
+  template<typename Tuple, std::size_t... I>
+  static void do_extract(row const &r, Tuple &t, std::index_sequence<I...>)
+  {
+    (extract_value(r[static_cast<row::size_type>(I)], std::get<I>(t)), ...);
+  }
+
+  /// Throw @c usage_error if a row does not have @c fields fields.
+  static void check_fields(row const &r, row::size_type fields)
+  {
+    if (r.size() != fields)
+      throw usage_error{
+        "Tried to extract " + to_string(fields) + " field(s) from a row of " +
+        to_string(r.size()) + "."};
+  }
+
+  template<typename... TYPE, typename CALLABLE, std::size_t... I>
+  static void
+  call_row(row const &r, CALLABLE &func, std::index_sequence<I...>)
+  {
+    std::invoke(func, r[static_cast<row::size_type>(I)].as<TYPE>()...);
+  }
+};
+
+
+template<typename Tuple> stream_query &stream_query::operator>>(Tuple &t)
+{
+  while (m_chunk_row >= m_chunk.size() and not m_finished)
+  {
+    m_chunk = read_chunk();
+    m_chunk_row = 0;
+  }
+  if (m_finished)
+    return *this;
+
+  constexpr auto tsize{std::tuple_size_v<Tuple>};
+  row const r{m_chunk[m_chunk_row]};
+  check_fields(r, static_cast<row::size_type>(tsize));
+  do_extract(r, t, std::make_index_sequence<tsize>{});
+  ++m_chunk_row;
+  return *this;
+}
+
+
+template<typename... TYPE, typename CALLABLE>
+void stream_query::for_each(CALLABLE &&func)
+{
+  for (;;)
+  {
+    // Start with any rows operator>> has received but not yet extracted.
+    while (m_chunk_row < m_chunk.size())
+    {
+      row const r{m_chunk[m_chunk_row++]};
+      check_fields(r, static_cast<row::size_type>(sizeof...(TYPE)));
+      call_row<TYPE...>(r, func, std::index_sequence_for<TYPE...>{});
+    }
+    if (m_finished)
+      break;
+    m_chunk = read_chunk();
+    m_chunk_row = 0;
+  }
+}
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -16,27 +16,66 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <memory>
+#include <vector>
+
+#include "pqxx/binary_traits.hxx"
 #include "pqxx/separated_list.hxx"
 #include "pqxx/transaction_base.hxx"
 
 
+namespace pqxx::internal::gate
+{
+class stream_to_arrow_writer;
+class stream_to_csv_loader;
+class stream_to_table_copy;
+} // namespace pqxx::internal::gate
+
+
 namespace pqxx::internal
 {
+class copy_key_set;
+
 std::string PQXX_LIBEXPORT copy_string_escape(std::string_view);
 
-struct TypedCopyEscaper
+/// Escape the text in @c buf from @c start onwards, for COPY's text format.
+/** Escapes in place: grows @c buf as needed, but allocates no other memory.
+ */
+void PQXX_LIBEXPORT copy_escape_tail(std::string &buf, std::size_t start);
+
+
+/// Append @c value to @c buf as a field in COPY's text format.
+template<typename T>
+inline void append_copy_field(std::string &buf, T const &value)
 {
-  template<typename T> std::string operator()(T const *t) const
+  ignore_unused(value);
+  if constexpr (std::is_same_v<T, std::nullptr_t>)
   {
-    // gcc 9 complains when t is used only in one branch of the "if constexpr".
-    ignore_unused(t);
-    if constexpr (std::is_same_v<T, std::nullptr_t>)
-      return "\\N";
-    else
-      return (t == nullptr or is_null(*t)) ? "\\N" :
-                                             copy_string_escape(to_string(*t));
+    buf += "\\N";
   }
-};
+  else if (is_null(value))
+  {
+    buf += "\\N";
+  }
+  else if constexpr (std::is_convertible_v<T const &, std::string_view>)
+  {
+    auto const start{buf.size()};
+    buf += std::string_view{value};
+    copy_escape_tail(buf, start);
+  }
+  else
+  {
+    // Convert straight into the buffer, then escape in place.
+    auto const start{buf.size()};
+    auto const budget{string_traits<T>::size_buffer(value)};
+    buf.resize(start + budget);
+    char *const begin{buf.data() + start};
+    char *const end{string_traits<T>::into_buf(begin, begin + budget, value)};
+    // Drop the terminating zero.
+    buf.resize(start + static_cast<std::size_t>(end - begin) - 1);
+    copy_escape_tail(buf, start);
+  }
+}
 } // namespace pqxx::internal
 
 
@@ -71,6 +110,18 @@ namespace pqxx
  * match the columns you specified when creating the stream.
  *
  * There is also a matching stream_from for reading data in bulk.
+ *
+ * The stream collects rows in a buffer, and sends them to the server in
+ * batches.  This saves a lot of per-call overhead in libpq, especially when
+ * the rows are small.  You can tune the size of the buffer using
+ * @c set_buffer_size(), and send the buffered data right away using
+ * @c flush().
+ *
+ * By default the stream sends data in COPY's text format.  Pass
+ * @c format::binary to send it in binary format instead.  That skips the
+ * conversion of every field to text, and the escaping.  But each field's C++
+ * type must have @c binary_traits which support writing, and must match its
+ * column's SQL type: see @c binary_traits.
  */
 class PQXX_LIBEXPORT stream_to : internal::transactionfocus
 {
@@ -85,22 +136,79 @@ public:
    */
   stream_to(transaction_base &, std::string_view table_name);
 
+  /// Create a stream in the given format, without specifying columns.
+  stream_to(
+    transaction_base &, std::string_view table_name, format data_format);
+
   /// Create a stream, specifying column names as a container of strings.
   template<typename Columns>
   stream_to(
     transaction_base &, std::string_view table_name, Columns const &columns);
 
+  /// Create a stream in the given format, specifying column names.
+  template<typename Columns>
+  stream_to(
+    transaction_base &, std::string_view table_name, Columns const &columns,
+    format data_format);
+
   /// Create a stream, specifying column names as a sequence of strings.
   template<typename Iter>
   stream_to(
     transaction_base &, std::string_view table_name, Iter columns_begin,
     Iter columns_end);
 
+  /// Create a stream in the given format, specifying column names.
+  template<typename Iter>
+  stream_to(
+    transaction_base &, std::string_view table_name, Iter columns_begin,
+    Iter columns_end, format data_format);
+
+  /// Create a stream for all of a table's columns, as described.
+  /** Get the description from @c connection::describe_table().  It's cached
+   * on the connection, so streaming to the same table again and again costs
+   * no extra round trips.
+   */
+  stream_to(
+    transaction_base &, table_description const &table,
+    format data_format = format::text);
+
+  /// Create a stream for rows of @c TYPE..., checking them against the table.
+  /** Looks up the table's columns using @c connection::describe_table(), so
+   * only the first stream for a table on a connection costs a round trip.
+   * The rows must have one field for each of the table's columns.
+   *
+   * If each of the types can write its column's SQL type in binary, the
+   * stream uses binary format.  Otherwise, it uses text format.
+   *
+   * @throw usage_error If the number of types does not match the number of
+   * columns.
+   */
+  template<typename... TYPE>
+  [[nodiscard]] static stream_to
+  checked(transaction_base &tb, std::string_view table_name)
+  {
+    auto const &table{tb.conn().describe_table(table_name)};
+    if (std::size(table.column_types) != sizeof...(TYPE))
+      throw usage_error{
+        "Streaming " + to_string(sizeof...(TYPE)) + " field(s) per row to " +
+        std::string{table_name} + ", which has " +
+        to_string(std::size(table.column_types)) + " column(s)."};
+    return stream_to{
+      tb, table,
+      table.binary_writable<TYPE...>() ? format::binary : format::text};
+  }
+
   ~stream_to() noexcept;
 
+  /// Default size limit for the buffer of pending data: 64 KiB.
+  static constexpr std::size_t default_buffer_size{64 * 1024};
+
   [[nodiscard]] operator bool() const noexcept { return not m_finished; }
   [[nodiscard]] bool operator!() const noexcept { return m_finished; }
 
+  /// Is this stream writing text or binary COPY data?
+  [[nodiscard]] format data_format() const noexcept { return m_format; }
+
   /// Complete the operation, and check for errors.
   /** Always call this to close the stream in an orderly fashion, even after
    * an error.  (In the case of an error, abort the transaction afterwards.)
@@ -110,13 +218,128 @@ public:
    */
   void complete();
 
+  /// Send any buffered data to the server now.
+  /** You don't normally need to call this.  The stream flushes its buffer
+   * whenever it fills up, and again when it completes.
+   *
+   * It does not wait for the server to process the data, so do not expect
+   * errors in the data to show up at this point.  Those only come out when
+   * you call @c complete().
+   */
+  void flush();
+
+  /// Send the contents of a file, which must be text-format COPY data.
+  /** This is the fast way to load a table from a dump, e.g. one which
+   * @c stream_from::to_fd() wrote.  The data goes to the server in large
+   * chunks, without being parsed or converted.  Where the system supports
+   * it, the file is mapped into memory instead of being read.
+   *
+   * The file must contain rows in COPY's text format, in the stream's
+   * columns.  If it does not end in a newline, this adds one.  You can
+   * write more rows afterwards, or load more files.  As with all data you
+   * write, you'll only learn of errors in the data when you @c complete().
+   *
+   * Only works in text format.
+   *
+   * @return The number of bytes sent.
+   */
+  std::size_t from_file(std::string_view path);
+
+  /// Set the size at which the stream sends its buffered data.
+  /** Once the buffered data reaches this size, the stream sends it to the
+   * server.  A larger buffer means fewer calls into libpq, but more memory.
+   * A size of zero sends every row as soon as you write it.
+   *
+   * The stream may briefly exceed the size by at most one row.
+   */
+  void set_buffer_size(std::size_t size) noexcept { m_buffer_size = size; }
+
+  /// The size at which the stream sends its buffered data.
+  [[nodiscard]] std::size_t buffer_size() const noexcept
+  {
+    return m_buffer_size;
+  }
+
+  /// Default limit on data queued up in non-blocking mode: 1 MiB.
+  static constexpr std::size_t default_max_pending{1024 * 1024};
+
+  /// Keep producing rows while the socket is busy, up to a point.
+  /** Normally, when the stream sends its data and the socket's send buffer
+   * is full, your thread waits until the kernel has room.  In non-blocking
+   * mode, libpq queues the data up in memory instead, so your thread can go
+   * on producing rows while the kernel drains the socket.  Only once about
+   * @c max_pending bytes are queued up does the stream wait for them to go
+   * out.
+   *
+   * To interleave several streams, each on its own connection, in a single
+   * thread: write some rows to each, call @c try_flush() on each, and wait
+   * for the sockets (see @c connection::sock()) of the streams where it
+   * returned false to become ready for writing.
+   *
+   * The connection stays in non-blocking mode until the stream completes.
+   */
+  void set_nonblocking(std::size_t max_pending = default_max_pending);
+
+  /// Send all buffered data that the socket will take, without waiting.
+  /** @return Whether all data has gone out.  In blocking mode, this is
+   * always true: the call is the same as @c flush().
+   */
+  bool try_flush();
+
+  /// Default memory limit for weeding out duplicate keys: 64 MiB.
+  static constexpr std::size_t default_dedup_memory{64 * 1024 * 1024};
+
+  /// Drop rows whose key is the same as that of a row you wrote before.
+  /** A COPY into a table with a unique constraint fails as a whole if two of
+   * its rows have the same key.  With this, the stream remembers the key of
+   * each row it sends, in a hash set, and silently drops any further rows
+   * with a key it has already seen.  The first row with a given key wins.
+   *
+   * The key consists of the fields in positions @c key, counting from zero.
+   * The stream compares the fields as they are encoded in the COPY data, so
+   * values which are equal in SQL but differently written, such as @c 1.0
+   * and @c 1.00 in text format, count as different.  A key with a null in it
+   * is never a duplicate, just as in a unique constraint.
+   *
+   * This applies to rows you write with @c << from here on, but not to data
+   * you send in bulk, e.g. with @c from_file().
+   *
+   * The set of keys takes at most about @c max_memory bytes.  If it fills
+   * up, the stream stops remembering new keys, and @c dedup_overflowed()
+   * returns true.  From then on, duplicates of keys it did not remember get
+   * through.  @c bulk_upsert handles that case on the server side.
+   */
+  void set_dedup(
+    std::vector<row_size_type> key,
+    std::size_t max_memory = default_dedup_memory);
+
+  /// Rows written and bytes sent so far, and time spent waiting to send.
+  /** The rows are those you've written, not counting any duplicates that the
+   * stream dropped.  The bytes are the ones the stream has passed on to
+   * libpq; any data still in the stream's buffer doesn't count yet.  The
+   * time spent waiting includes waiting for the server to finish processing
+   * the data when you @c complete() the stream.
+   *
+   * Once the stream has completed, the times stay as they were then.
+   *
+   * The connection's query hook gets the waiting time as well, along with
+   * its report on the COPY.
+   */
+  [[nodiscard]] stream_stats stats() const noexcept;
+
+  /// Number of rows dropped as duplicates, so far.
+  [[nodiscard]] std::size_t duplicates() const noexcept;
+
+  /// Did the set of keys fill up, so that duplicates may have got through?
+  [[nodiscard]] bool dedup_overflowed() const noexcept;
+
   /// Insert a row of data.
   /** The data can be any type that can be iterated.  Each iterated item
    * becomes a field in the row, in the same order as the columns you
    * specified when creating the stream.
    *
    * Each field will be converted into the database's format using
-   * @c pqxx::to_string.
+   * @c pqxx::to_string, or in binary format, using @c binary_traits.
    */
   template<typename Tuple> stream_to &operator<<(Tuple const &);
 
@@ -124,15 +347,169 @@ public:
   /** This can be useful when copying between different databases.  If the
    * source and the destination are on the same database, you'll get better
    * performance doing it all in a regular query.
+   *
+   * Both streams must use the text format.
    */
   stream_to &operator<<(stream_from &);
 
 private:
+  friend class internal::gate::stream_to_arrow_writer;
+  friend class internal::gate::stream_to_csv_loader;
+  friend class internal::gate::stream_to_table_copy;
+
   bool m_finished = false;
+  format m_format = format::text;
+
+  /// Data waiting to be sent to the server.
+  std::string m_buffer;
+
+  /// Size at which we flush m_buffer.
+  std::size_t m_buffer_size = default_buffer_size;
+
+  /// Keys of the rows written so far, if weeding out duplicates.
+  std::shared_ptr<internal::copy_key_set> m_keys;
+
+  /// When the COPY started.
+  std::chrono::steady_clock::time_point m_start;
+  /// The connection's total COPY waiting time when the COPY started.
+  std::chrono::steady_clock::duration m_blocked_before{0};
+  /// Rows and bytes so far.  Once finished, the times as well.
+  stream_stats m_stats;
+
+  /// In non-blocking mode, how much data may queue up.  Zero for blocking.
+  std::size_t m_max_pending = 0;
+  /// Data sent in non-blocking mode since we last knew libpq's queue empty.
+  std::size_t m_pending = 0;
+  /// The stats as of now, for an unfinished stream.
+  stream_stats live_stats() const noexcept;
+
+  /// Drop the row at @c start in the buffer, if its key is a duplicate.
+  /** Returns whether it dropped the row.
+   */
+  bool drop_duplicate(std::size_t start);
+
+  /// Wrap up the row we just wrote at @c start in the buffer.
+  void end_row(std::size_t start)
+  {
+    if (not m_keys or not drop_duplicate(start))
+      ++m_stats.rows;
+    flush_if_full();
+  }
+
+  /// Pass @c data on to libpq, and count it.
+  void send_copy_data(std::string_view data);
 
   /// Write a row of data, as a line of text.
   void write_raw_line(std::string_view);
 
+  /// Write raw COPY data, as-is.
+  void write_raw_data(std::string_view);
+
+  /// Send raw COPY data straight to the server, after any buffered data.
+  void send_raw_data(std::string_view);
+
+  /// Append a field to m_buffer, in COPY's text format.
+  template<typename T> void write_text_field(T const &value)
+  {
+    internal::append_copy_field(m_buffer, value);
+  }
+
+  template<typename Tuple, std::size_t... I>
+  void write_text_row(Tuple const &t, std::index_sequence<I...>)
+  {
+    auto const start{m_buffer.size()};
+    try
+    {
+      (((I == 0 ? void() : m_buffer.push_back('\t')),
+        write_text_field(std::get<I>(t))),
+       ...);
+    }
+    catch (std::exception const &)
+    {
+      m_buffer.resize(start);
+      throw;
+    }
+    m_buffer.push_back('\n');
+    end_row(start);
+  }
+
+  /// Flush the buffer if it has reached its size limit.
+  void flush_if_full()
+  {
+    if (m_buffer.size() >= m_buffer_size)
+      flush();
+  }
+
+  template<typename T> static std::size_t binary_field_size(T const &value)
+  {
+    ignore_unused(value);
+    if constexpr (std::is_same_v<T, std::nullptr_t>)
+      return 0;
+    else if (is_null(value))
+      return 0;
+    else if constexpr (has_binary_output<T>)
+      return binary_traits<T>::binary_size(value);
+    else
+      throw conversion_error{
+        "No conversion to binary format for " +
+        std::string{name_type<T>()} + "."};
+  }
+
+  template<typename T>
+  static char *write_binary_field(char *here, char *end, T const &value)
+  {
+    ignore_unused(value);
+    if constexpr (std::is_same_v<T, std::nullptr_t>)
+    {
+      return internal::into_big_endian(here, std::int32_t{-1});
+    }
+    else if (is_null(value))
+    {
+      return internal::into_big_endian(here, std::int32_t{-1});
+    }
+    else if constexpr (has_binary_output<T>)
+    {
+      auto const size{binary_traits<T>::binary_size(value)};
+      here = internal::into_big_endian(
+        here, check_cast<std::int32_t>(size, "binary COPY field"));
+      return binary_traits<T>::into_binary(here, end, value);
+    }
+    else
+    {
+      throw conversion_error{
+        "No conversion to binary format for " +
+        std::string{name_type<T>()} + "."};
+    }
+  }
+
+  template<typename Tuple, std::size_t... I>
+  void write_binary_row(Tuple const &t, std::index_sequence<I...>)
+  {
+    constexpr auto fields{sizeof...(I)};
+    static_assert(fields <= 32767, "Too many fields for binary COPY.");
+    // Field count, plus a length prefix for each field.
+    std::size_t size{2 + 4 * fields};
+    ((size += binary_field_size(std::get<I>(t))), ...);
+
+    // Compose the row directly at the end of the buffer.
+    auto const start{m_buffer.size()};
+    m_buffer.resize(start + size);
+    char *here{m_buffer.data() + start};
+    char *const end{here + size};
+    try
+    {
+      here =
+        internal::into_big_endian(here, static_cast<std::int16_t>(fields));
+      ((here = write_binary_field(here, end, std::get<I>(t))), ...);
+    }
+    catch (std::exception const &)
+    {
+      m_buffer.resize(start);
+      throw;
+    }
+    end_row(start);
+  }
+
   void set_up(transaction_base &, std::string_view table_name);
   void set_up(
     transaction_base &, std::string_view table_name,
@@ -147,6 +524,15 @@ inline stream_to::stream_to(
 {}
 
 
+template<typename Columns>
+inline stream_to::stream_to(
+  transaction_base &tb, std::string_view table_name, Columns const &columns,
+  format data_format) :
+        stream_to{
+          tb, table_name, std::begin(columns), std::end(columns), data_format}
+{}
+
+
 template<typename Iter>
 inline stream_to::stream_to(
   transaction_base &tb, std::string_view table_name, Iter columns_begin,
@@ -158,9 +544,25 @@ inline stream_to::stream_to(
 }
 
 
+template<typename Iter>
+inline stream_to::stream_to(
+  transaction_base &tb, std::string_view table_name, Iter columns_begin,
+  Iter columns_end, format data_format) :
+        namedclass{"stream_to", table_name},
+        internal::transactionfocus{tb},
+        m_format{data_format}
+{
+  set_up(tb, table_name, separated_list(",", columns_begin, columns_end));
+}
+
+
 template<typename Tuple> stream_to &stream_to::operator<<(Tuple const &t)
 {
-  write_raw_line(separated_list("\t", t, internal::TypedCopyEscaper{}));
+  constexpr auto fields{std::make_index_sequence<std::tuple_size_v<Tuple>>{}};
+  if (m_format == format::binary)
+    write_binary_row(t, fields);
+  else
+    write_text_row(t, fields);
   return *this;
 }
 } // namespace pqxx
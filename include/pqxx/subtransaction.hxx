@@ -66,6 +66,12 @@ namespace pqxx
  * There are no isolation levels inside a transaction.  They are not needed
  * because all actions within the same backend transaction are always performed
  * sequentially anyway.
+ *
+ * Setting, releasing, or rolling back to the savepoint costs no round trips
+ * of its own: the commands travel along with the next statement.  So if a
+ * subtransaction runs no statements at all, its savepoint never goes to the
+ * server.  One consequence is that if you commit a subtransaction after one
+ * of its statements failed, the error shows up in the next statement.
  */
 class PQXX_LIBEXPORT subtransaction : public internal::transactionfocus,
                                       public dbtransaction
@@ -83,6 +89,7 @@ public:
 
 private:
   std::string quoted_name() const { return quote_name(name()); }
+  std::string savepoint_command() const;
   virtual void do_commit() override;
   virtual void do_abort() override;
 };
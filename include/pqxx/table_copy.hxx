@@ -0,0 +1,97 @@
+/* Definition of the pqxx::table_copy class.
+ *
+ * pqxx::table_copy streams raw COPY data from one connection into another.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/table_copy instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_TABLE_COPY
+#define PQXX_H_TABLE_COPY
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <cstddef>
+
+#include "pqxx/stream_from.hxx"
+#include "pqxx/stream_to.hxx"
+
+
+namespace pqxx
+{
+/// Copy data from a @c stream_from into a @c stream_to, on another connection.
+/** Does the same job as streaming the @c stream_from into the @c stream_to
+ * with @c operator<<, but faster.  It passes the rows along as raw COPY data,
+ * without parsing or copying them one by one.  And it reads and writes at the
+ * same time: a separate thread reads rows from the source into one large
+ * buffer, while the calling thread sends the previous buffer to the target.
+ * So both connections can be busy at once, which helps most when copying
+ * between servers.
+ *
+ * The two streams must use the same data format, text or binary, and the
+ * same columns in the same order.  They must be on different connections;
+ * a connection can't take part in two COPY operations at once anyway.
+ *
+ * Each connection is only ever used from one thread at a time: the source's
+ * from the reader thread, the target's from the calling thread.  Still, do
+ * not touch either stream, or its transaction or connection, while a copy is
+ * running.
+ *
+ * @code
+ *	pqxx::stream_from source{source_tx, "measurement"};
+ *	pqxx::stream_to target{target_tx, "measurement"};
+ *	pqxx::table_copy{source, target}.run();
+ *	target.complete();
+ *	target_tx.commit();
+ * @endcode
+ *
+ * This class starts a thread, so your program may need to link to a
+ * threading library.
+ */
+class PQXX_LIBEXPORT table_copy
+{
+public:
+  /// Default size for each of the two buffers: 1 MiB.
+  static constexpr std::size_t default_buffer_size{1024 * 1024};
+
+  /**
+   * @param source The stream to read from.
+   * @param target The stream to write to.
+   * @param buffer_size Amount of data to read before sending it on.  There
+   *     are two of these buffers: one filling up, one being sent.
+   */
+  table_copy(
+    stream_from &source, stream_to &target,
+    std::size_t buffer_size = default_buffer_size);
+
+  /// Copy all remaining rows from the source to the target.
+  /** Returns once the source stream is exhausted and all data has gone to
+   * the target.  The source is then complete.  The target is not: call its
+   * @c complete() to finish the COPY and see any errors the server found
+   * in the data.
+   *
+   * If anything goes wrong, this re-throws the first error.  After that,
+   * abort both transactions.
+   *
+   * @return The number of rows copied.
+   */
+  std::size_t run();
+
+  /// Number of bytes of COPY data copied so far.
+  [[nodiscard]] std::size_t bytes() const noexcept { return m_bytes; }
+
+private:
+  stream_from &m_source;
+  stream_to &m_target;
+  std::size_t const m_buffer_size;
+  std::size_t m_bytes = 0;
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
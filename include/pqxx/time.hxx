@@ -0,0 +1,442 @@
+/* Conversions for std::chrono date and time types.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/time instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_TIME
+#define PQXX_H_TIME
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <ratio>
+
+#include "pqxx/binary_traits.hxx"
+#include "pqxx/strconv.hxx"
+
+// C++20's calendar types.  Some standard libraries had them well before they
+// set the feature macro, which also covers time zones.
+#if !defined(PQXX_HAVE_YEAR_MONTH_DAY) && __cplusplus >= 202002L
+#  if (defined(__cpp_lib_chrono) && __cpp_lib_chrono >= 201907L) ||          \
+    (defined(_GLIBCXX_RELEASE) && _GLIBCXX_RELEASE >= 11)
+#    define PQXX_HAVE_YEAR_MONTH_DAY
+#  endif
+#endif
+
+
+namespace pqxx::internal
+{
+/// Days from the Unix epoch to PostgreSQL's epoch, 2000-01-01.
+constexpr std::int32_t pg_epoch_days{10957};
+/// Microseconds from the Unix epoch to PostgreSQL's epoch.
+constexpr std::int64_t pg_epoch_micros{
+  pg_epoch_days * std::int64_t{86'400'000'000}};
+
+/// Buffer space for a timestamp as text, including terminating zero.
+/** A 6-digit year, "-MM-DD HH:MM:SS.ffffff+00 BC", and the zero.
+ */
+constexpr std::size_t timestamp_buffer{35};
+/// Buffer space for a date as text, including terminating zero.
+constexpr std::size_t date_buffer{17};
+/// Buffer space for an interval as text, including terminating zero.
+constexpr std::size_t interval_buffer{25};
+
+
+/// Parse a timestamp as microseconds since the Unix epoch, in UTC.
+/** Accepts PostgreSQL's ISO output format for @c timestamp, @c timestamptz,
+ * and @c date, as well as ISO 8601 text with a "T" separator.  Without a time
+ * zone offset, the time is taken to be in UTC.
+ *
+ * Returns the highest or lowest @c int64_t for "infinity" or "-infinity".
+ */
+PQXX_LIBEXPORT std::int64_t parse_timestamp(std::string_view text);
+
+/// Write a timestamp, in microseconds since the Unix epoch, as text.
+/** Writes a terminating zero, and returns the address just after it.
+ */
+PQXX_LIBEXPORT char *
+write_timestamp(char *begin, char *end, std::int64_t micros);
+
+/// Parse a date as days since the Unix epoch.
+PQXX_LIBEXPORT std::int32_t parse_date(std::string_view text);
+
+/// Write a date, in days since the Unix epoch, as text.
+/** Writes a terminating zero, and returns the address just after it.
+ */
+PQXX_LIBEXPORT char *write_date(char *begin, char *end, std::int32_t days);
+
+/// Parse an interval's text as microseconds.
+/** Accepts PostgreSQL's default @c postgres interval style.  An interval
+ * with months or years has no fixed length, so those are an error.  A day
+ * counts as 24 hours.
+ */
+PQXX_LIBEXPORT std::int64_t parse_interval(std::string_view text);
+
+/// Write an interval of @c micros microseconds as text.
+/** Writes a terminating zero, and returns the address just after it.
+ */
+PQXX_LIBEXPORT char *
+write_interval(char *begin, char *end, std::int64_t micros);
+
+/// Read a binary @c interval as microseconds.
+PQXX_LIBEXPORT std::int64_t interval_from_binary(std::string_view data);
+
+
+/// Convert a number of microseconds to @c DURATION, checking for overflow.
+/** Rounds towards negative infinity if @c DURATION is less precise.
+ */
+template<typename DURATION> inline DURATION from_micros(std::int64_t micros)
+{
+  using rep = typename DURATION::rep;
+  static_assert(
+    std::is_integral_v<rep>, "Time conversions need an integral duration.");
+  using period = typename DURATION::period;
+  if constexpr (std::ratio_less_equal_v<period, std::micro>)
+  {
+    using factor = std::ratio_divide<std::micro, period>;
+    static_assert(factor::den == 1);
+    if (
+      micros > std::numeric_limits<rep>::max() / factor::num or
+      micros < std::numeric_limits<rep>::min() / factor::num)
+      throw range_error{
+        "Time value out of range for " + std::string{name_type<rep>()} +
+        "."};
+    return DURATION{static_cast<rep>(micros * factor::num)};
+  }
+  else
+  {
+    return std::chrono::floor<DURATION>(std::chrono::microseconds{micros});
+  }
+}
+
+
+/// Convert a duration to microseconds, checking for overflow.
+/** Rounds towards negative infinity if @c DURATION is more precise.
+ */
+template<typename DURATION> inline std::int64_t to_micros(DURATION value)
+{
+  static_assert(
+    std::is_integral_v<typename DURATION::rep>,
+    "Time conversions need an integral duration.");
+  using period = typename DURATION::period;
+  if constexpr (std::ratio_less_equal_v<period, std::micro>)
+  {
+    return std::chrono::floor<std::chrono::microseconds>(value).count();
+  }
+  else
+  {
+    using factor = std::ratio_divide<period, std::micro>;
+    static_assert(factor::den == 1);
+    auto const count{value.count()};
+    if (
+      count > std::numeric_limits<std::int64_t>::max() / factor::num or
+      count < std::numeric_limits<std::int64_t>::min() / factor::num)
+      throw range_error{"Time value out of range for microseconds."};
+    return static_cast<std::int64_t>(count) * factor::num;
+  }
+}
+
+
+/// Microseconds since the Unix epoch for a time point.
+/** Maps the time point's highest and lowest values to those of @c int64_t,
+ * which stand for PostgreSQL's infinities.
+ */
+template<typename TIME> inline std::int64_t time_to_micros(TIME const &value)
+{
+  if (value == TIME::max())
+    return std::numeric_limits<std::int64_t>::max();
+  if (value == TIME::min())
+    return std::numeric_limits<std::int64_t>::min();
+  return to_micros(value.time_since_epoch());
+}
+
+
+/// A time point for a number of microseconds since the Unix epoch.
+/** The inverse of @c time_to_micros.
+ */
+template<typename TIME> inline TIME time_from_micros(std::int64_t micros)
+{
+  if (micros == std::numeric_limits<std::int64_t>::max())
+    return TIME::max();
+  if (micros == std::numeric_limits<std::int64_t>::min())
+    return TIME::min();
+  return TIME{from_micros<typename TIME::duration>(micros)};
+}
+
+
+/// Shift microseconds from one epoch to another, leaving infinities alone.
+inline std::int64_t
+shift_micros(std::int64_t micros, std::int64_t offset) noexcept
+{
+  if (
+    micros == std::numeric_limits<std::int64_t>::max() or
+    micros == std::numeric_limits<std::int64_t>::min())
+    return micros;
+  return micros + offset;
+}
+} // namespace pqxx::internal
+
+
+namespace pqxx
+{
+/**
+ * @addtogroup stringconversion
+ *
+ * Time points on the system clock convert to and from @c timestamp and
+ * @c timestamptz.  The conversions treat time points as UTC: when writing,
+ * they include a "+00" time zone offset, and when reading text without an
+ * offset, such as a @c timestamp, they interpret it as UTC.  Read
+ * @c timestamptz text in the ISO date style; that is the default.  The
+ * highest and lowest time points stand for "infinity" and "-infinity".
+ *
+ * A time point with nanosecond precision, which is what
+ * @c std::chrono::system_clock uses on some systems, only covers the years
+ * 1678 to 2262.  For other dates, use microsecond precision, which is also
+ * PostgreSQL's.  Values that don't fit throw @c range_error.
+ *
+ * Durations convert to and from @c interval, so long as the interval has no
+ * months or years.  Those have no fixed length.
+ *
+ * In binary format, these are 64-bit microsecond counts.  Binary time
+ * points go into @c timestamptz parameters, and durations into @c interval.
+ *
+ * If your compiler supports C++20's calendar types, a
+ * @c std::chrono::year_month_day converts to and from @c date.
+ */
+//@{
+
+template<typename DURATION>
+struct nullness<std::chrono::time_point<std::chrono::system_clock, DURATION>>
+        : no_null<std::chrono::time_point<std::chrono::system_clock, DURATION>>
+{};
+
+
+template<typename DURATION>
+struct string_traits<
+  std::chrono::time_point<std::chrono::system_clock, DURATION>>
+{
+  using time_type =
+    std::chrono::time_point<std::chrono::system_clock, DURATION>;
+
+  [[nodiscard]] static time_type from_string(std::string_view text)
+  {
+    return internal::time_from_micros<time_type>(
+      internal::parse_timestamp(text));
+  }
+
+  static zview to_buf(char *begin, char *end, time_type const &value)
+  {
+    auto const stop{into_buf(begin, end, value)};
+    return zview{begin, static_cast<std::size_t>(stop - begin - 1)};
+  }
+
+  static char *into_buf(char *begin, char *end, time_type const &value)
+  {
+    return internal::write_timestamp(
+      begin, end, internal::time_to_micros(value));
+  }
+
+  static constexpr std::size_t size_buffer(time_type const &) noexcept
+  {
+    return internal::timestamp_buffer;
+  }
+};
+
+
+template<typename DURATION>
+struct binary_traits<
+  std::chrono::time_point<std::chrono::system_clock, DURATION>>
+{
+  using time_type =
+    std::chrono::time_point<std::chrono::system_clock, DURATION>;
+
+  /// OID of @c timestamptz.
+  static constexpr oid type_oid{1184};
+
+  [[nodiscard]] static time_type from_binary(std::string_view data)
+  {
+    internal::check_binary_size(data, 8, "timestamp");
+    return internal::time_from_micros<time_type>(internal::shift_micros(
+      internal::from_big_endian<std::int64_t>(data.data()),
+      internal::pg_epoch_micros));
+  }
+
+  [[nodiscard]] static constexpr std::size_t
+  binary_size(time_type const &) noexcept
+  {
+    return 8;
+  }
+
+  static char *into_binary(char *begin, char *end, time_type const &value)
+  {
+    internal::check_binary_space(begin, end, 8, "timestamp");
+    return internal::into_big_endian(
+      begin, internal::shift_micros(
+               internal::time_to_micros(value), -internal::pg_epoch_micros));
+  }
+};
+
+
+template<typename REP, typename PERIOD>
+struct nullness<std::chrono::duration<REP, PERIOD>>
+        : no_null<std::chrono::duration<REP, PERIOD>>
+{};
+
+
+template<typename REP, typename PERIOD>
+struct string_traits<std::chrono::duration<REP, PERIOD>>
+{
+  using duration_type = std::chrono::duration<REP, PERIOD>;
+
+  [[nodiscard]] static duration_type from_string(std::string_view text)
+  {
+    return internal::from_micros<duration_type>(
+      internal::parse_interval(text));
+  }
+
+  static zview to_buf(char *begin, char *end, duration_type const &value)
+  {
+    auto const stop{into_buf(begin, end, value)};
+    return zview{begin, static_cast<std::size_t>(stop - begin - 1)};
+  }
+
+  static char *into_buf(char *begin, char *end, duration_type const &value)
+  {
+    return internal::write_interval(begin, end, internal::to_micros(value));
+  }
+
+  static constexpr std::size_t size_buffer(duration_type const &) noexcept
+  {
+    return internal::interval_buffer;
+  }
+};
+
+
+template<typename REP, typename PERIOD>
+struct binary_traits<std::chrono::duration<REP, PERIOD>>
+{
+  using duration_type = std::chrono::duration<REP, PERIOD>;
+
+  /// OID of @c interval.
+  static constexpr oid type_oid{1186};
+
+  [[nodiscard]] static duration_type from_binary(std::string_view data)
+  {
+    return internal::from_micros<duration_type>(
+      internal::interval_from_binary(data));
+  }
+
+  [[nodiscard]] static constexpr std::size_t
+  binary_size(duration_type const &) noexcept
+  {
+    return 16;
+  }
+
+  /// Writes the microseconds, with zero days and zero months.
+  static char *into_binary(char *begin, char *end, duration_type const &value)
+  {
+    internal::check_binary_space(begin, end, 16, "interval");
+    auto here{internal::into_big_endian(begin, internal::to_micros(value))};
+    here = internal::into_big_endian(here, std::int32_t{0});
+    return internal::into_big_endian(here, std::int32_t{0});
+  }
+};
+
+
+#if defined(PQXX_HAVE_YEAR_MONTH_DAY)
+
+template<>
+struct nullness<std::chrono::year_month_day>
+        : no_null<std::chrono::year_month_day>
+{};
+
+
+template<> struct string_traits<std::chrono::year_month_day>
+{
+  [[nodiscard]] static std::chrono::year_month_day
+  from_string(std::string_view text)
+  {
+    return std::chrono::sys_days{
+      std::chrono::days{internal::parse_date(text)}};
+  }
+
+  static zview
+  to_buf(char *begin, char *end, std::chrono::year_month_day const &value)
+  {
+    auto const stop{into_buf(begin, end, value)};
+    return zview{begin, static_cast<std::size_t>(stop - begin - 1)};
+  }
+
+  static char *
+  into_buf(char *begin, char *end, std::chrono::year_month_day const &value)
+  {
+    return internal::write_date(begin, end, days_of(value));
+  }
+
+  static constexpr std::size_t
+  size_buffer(std::chrono::year_month_day const &) noexcept
+  {
+    return internal::date_buffer;
+  }
+
+  /// Days since the Unix epoch.  Throws @c conversion_error if not valid.
+  static std::int32_t days_of(std::chrono::year_month_day const &value)
+  {
+    if (not value.ok())
+      throw conversion_error{"Invalid year_month_day."};
+    return static_cast<std::int32_t>(
+      std::chrono::sys_days{value}.time_since_epoch().count());
+  }
+};
+
+
+template<> struct binary_traits<std::chrono::year_month_day>
+{
+  /// OID of @c date.
+  static constexpr oid type_oid{1082};
+
+  [[nodiscard]] static std::chrono::year_month_day
+  from_binary(std::string_view data)
+  {
+    internal::check_binary_size(data, 4, "date");
+    auto const days{internal::from_big_endian<std::int32_t>(data.data())};
+    if (
+      days == std::numeric_limits<std::int32_t>::max() or
+      days == std::numeric_limits<std::int32_t>::min())
+      throw conversion_error{"Infinite date does not fit year_month_day."};
+    return std::chrono::sys_days{
+      std::chrono::days{days + internal::pg_epoch_days}};
+  }
+
+  [[nodiscard]] static constexpr std::size_t
+  binary_size(std::chrono::year_month_day const &) noexcept
+  {
+    return 4;
+  }
+
+  static char *into_binary(
+    char *begin, char *end, std::chrono::year_month_day const &value)
+  {
+    internal::check_binary_space(begin, end, 4, "date");
+    return internal::into_big_endian(
+      begin, static_cast<std::int32_t>(
+               string_traits<std::chrono::year_month_day>::days_of(value) -
+               internal::pg_epoch_days));
+  }
+};
+
+#endif // PQXX_HAVE_YEAR_MONTH_DAY
+
+//@}
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -0,0 +1,91 @@
+/* Definition of the pqxx::tracer interface.
+ *
+ * pqxx::tracer lets a tracing system, such as OpenTelemetry, see
+ * transactions and queries as spans.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/tracer instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_TRACER
+#define PQXX_H_TRACER
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include "pqxx/connection.hxx"
+
+
+namespace pqxx
+{
+/// Base class for distributed tracing.
+/** Implement this to feed transactions and queries into a tracing system,
+ * such as OpenTelemetry, and pass it to @c connection::set_tracer().
+ *
+ * Each transaction becomes a span, from its start to its commit or abort.
+ * Each query, prepared statement execution, pipelined batch, and COPY stream
+ * becomes a child span of the transaction in which it ran, or a root span if
+ * it ran outside of any transaction.  The child spans come in after the fact,
+ * with their start time and their @c query_stats.
+ *
+ * Spans are opaque to libpqxx: @c start_transaction() returns a pointer to
+ * whatever your tracing system uses, and libpqxx passes it back to you.
+ *
+ * If @c context() returns a trace context for a transaction's span, e.g. a
+ * W3C @c traceparent, libpqxx sends it to the server in an SQL comment in
+ * front of each query in the transaction, so server logs can tie each query
+ * to its trace.  Prepared statements don't get the comment.
+ *
+ * None of these functions may throw, except @c start_transaction() and
+ * @c context(), which may throw to say that you can't start a span.
+ */
+class PQXX_LIBEXPORT PQXX_NOVTABLE tracer
+{
+public:
+  tracer() = default;
+  tracer(tracer const &) = delete;
+  tracer &operator=(tracer const &) = delete;
+  virtual ~tracer() noexcept;
+
+  /// A transaction starts.  Return its span, or null for none.
+  /** @param classname The transaction's class, e.g. "transaction" or
+   *     "robusttransaction".
+   * @param name The transaction's name, or empty if it has none.
+   */
+  [[nodiscard]] virtual void *
+  start_transaction(std::string_view classname, std::string_view name) = 0;
+
+  /// A transaction ends.
+  /** @param span What @c start_transaction() returned for the transaction.
+   * @param committed Did the transaction commit?
+   */
+  virtual void end_transaction(void *span, bool committed) noexcept = 0;
+
+  /// A query, batch, or COPY finished.  Record it as a span.
+  /** @param parent Span of the transaction in which it ran, or null.
+   * @param start When it started.
+   * @param stats What it was, and what it cost.
+   */
+  virtual void record(
+    void *parent, std::chrono::system_clock::time_point start,
+    query_stats const &stats) noexcept = 0;
+
+  /// Trace context to send to the server for a transaction's span.
+  /** Return an empty string to send nothing; that's what the default
+   * implementation does.  The context must not contain the sequence that ends
+   * an SQL comment; if it does, libpqxx won't send it.
+   */
+  [[nodiscard]] virtual std::string context(void *span);
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
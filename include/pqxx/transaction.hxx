@@ -17,17 +17,54 @@
 
 #include "pqxx/dbtransaction.hxx"
 
+namespace pqxx
+{
+/// When a @c transaction sends its @c BEGIN to the database.
+enum class begin_policy
+{
+  /// Begin right away, when the transaction object is created.
+  immediate,
+  /// Send @c BEGIN along with the first statement, in the same round trip.
+  /** If the transaction ends without executing any statements, it never
+   * talks to the database at all.
+   */
+  deferred,
+};
+} // namespace pqxx
+
+
 namespace pqxx::internal
 {
 /// Helper base class for the @c transaction class template.
 class PQXX_LIBEXPORT basic_transaction : public dbtransaction
 {
+public:
+  /// Execute one last query, and commit, in a single round trip.
+  /** This sends the query and the @c COMMIT together, so you save the wait
+   * for the query's result before you commit.  With a deferred @c BEGIN,
+   * that means a single-statement transaction takes just one round trip.
+   *
+   * If the query fails, the transaction aborts, and this throws the query's
+   * error.  If the commit fails, you get the same exceptions as from
+   * @c commit().
+   *
+   * @return The query's result.
+   */
+  result commit_with(std::string_view query);
+
 protected:
-  basic_transaction(connection &c, char const begin_command[]);
+  basic_transaction(
+    connection &c, char const begin_command[],
+    begin_policy policy = begin_policy::immediate);
 
 private:
   virtual void do_commit() override;
   virtual void do_abort() override;
+
+  /// Final query for @c commit_with(), if any.
+  std::shared_ptr<std::string> m_commit_query;
+  /// Result of the final query for @c commit_with().
+  result m_commit_result;
 };
 } // namespace pqxx::internal
 
@@ -80,6 +117,20 @@ public:
 
   explicit transaction(connection &c) : transaction(c, "") {}
 
+  /// Create a transaction, and choose when it sends its @c BEGIN.
+  /** The begin command must be sent before the first statement, but with
+   * @c begin_policy::deferred, it can go out as part of the same message.
+   * That saves a round trip to the database.
+   */
+  transaction(connection &c, std::string const &tname, begin_policy policy) :
+          namedclass{"transaction", tname},
+          internal::basic_transaction(
+            c, internal::begin_cmd<ISOLATION, READWRITE>.c_str(), policy)
+  {}
+
+  transaction(connection &c, begin_policy policy) : transaction(c, "", policy)
+  {}
+
   virtual ~transaction() noexcept override { close(); }
 };
 
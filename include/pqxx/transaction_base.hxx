@@ -17,7 +17,13 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <map>
 #include <string_view>
+#include <tuple>
+#include <vector>
 
 /* End-user programs need not include this file, unless they define their own
  * transaction classes.  This is not something the typical program should want
@@ -31,8 +37,10 @@
 #include "pqxx/connection.hxx"
 #include "pqxx/internal/encoding_group.hxx"
 #include "pqxx/isolation.hxx"
+#include "pqxx/query_builder.hxx"
 #include "pqxx/result.hxx"
 #include "pqxx/row.hxx"
+#include "pqxx/separated_list.hxx"
 
 
 namespace pqxx::internal
@@ -67,6 +75,7 @@ private:
 
 namespace pqxx::internal::gate
 {
+class transaction_connection;
 class transaction_subtransaction;
 class transaction_sql_cursor;
 class transaction_stream_to;
@@ -76,6 +85,21 @@ class transaction_transactionfocus;
 
 namespace pqxx
 {
+class stream_from;
+class stream_query;
+
+
+/// Limits on the statements that @c transaction_base::insert_bulk() builds.
+struct bulk_insert_limits
+{
+  /// Most parameters in one statement.  The protocol allows no more than this.
+  std::size_t max_params = 65535;
+
+  /// End a statement once its parameter values reach this many bytes.
+  std::size_t max_bytes = 1024 * 1024;
+};
+
+
 /**
  * @defgroup transaction Transaction classes
  *
@@ -119,6 +143,29 @@ public:
    */
   void commit();
 
+  /// Find out where in the write-ahead log the commit ends up.
+  /** Once the transaction has committed, @c commit_lsn() returns the position
+   * in the write-ahead log up to which a replica must have replayed, before
+   * it can see the transaction's changes.  Pass it to
+   * @c connection_router::replica() to read your own writes from a replica.
+   *
+   * A regular transaction asks for the position in the same round trip as the
+   * @c COMMIT.  Other types of transaction need an extra query.  A
+   * subtransaction never gets a position: its changes don't become visible
+   * until its parent commits.
+   */
+  void capture_commit_lsn(bool capture = true) noexcept
+  {
+    m_capture_lsn = capture;
+  }
+
+  /// The commit's position in the write-ahead log, or zero if unknown.
+  /** Zero unless you called @c capture_commit_lsn() and the transaction has
+   * committed.  It's also zero if the transaction never actually talked to
+   * the database, so that there is nothing for a replica to catch up on.
+   */
+  [[nodiscard]] lsn commit_lsn() const noexcept { return m_commit_lsn; }
+
   /// Abort the transaction
   /** No special effort is required to call this function; it will be called
    * implicitly when the transaction is destructed.
@@ -236,6 +283,48 @@ public:
     return exec(query.str(), desc);
   }
 
+  /// Execute a script of several statements, in a single round trip.
+  /** The statements are separated by semicolons, as in @c psql.  This
+   * returns a result for each statement, in order.  So for instance, you can
+   * check each statement's @c result::affected_rows() or
+   * @c result::cmd_status().  (The plain @c exec() function only returns
+   * the last statement's result.)
+   *
+   * The statements can't have parameters.  Nor should they include a
+   * @c COPY: that stops the script there, and leaves it to you to handle
+   * the COPY data.
+   *
+   * If a statement fails, the server skips the ones after it, and this
+   * throws that statement's error.  The ones before it did execute, but
+   * the error aborts the transaction.  In a @c nontransaction, the server
+   * runs the script as a single implicit transaction, unless it contains
+   * transaction commands of its own.
+   *
+   * @param script The statements to execute.
+   * @param desc Optional identifier for the script, to help pinpoint errors.
+   */
+  std::vector<result>
+  exec_all(std::string_view script, std::string const &desc = std::string{});
+
+  /// Execute the query in a @c query_builder, without copying it first.
+  result
+  exec(query_builder const &query, std::string const &desc = std::string{})
+  {
+    return exec(query.view(), desc);
+  }
+
+  /// Start composing a query, in this transaction's re-usable buffer.
+  /** Returns this transaction's own @c query_builder, emptied.  It keeps its
+   * memory from one query to the next, so building queries this way stops
+   * allocating memory once the buffer is big enough.
+   *
+   * There is only one builder per transaction: each call clears it.
+   */
+  [[nodiscard]] query_builder &build_query() noexcept
+  {
+    return m_builder.clear();
+  }
+
   /// Execute query, which should zero rows of data.
   /** Works like exec, but fails if the result contains data.  It still returns
    * a result, however, which may contain useful metadata.
@@ -282,6 +371,38 @@ public:
     return r[0].as<TYPE>();
   }
 
+  /// Execute a query, and call @c func on each row of the result.
+  /** Passes each row's fields to @c func as @c TYPE..., in order.  The fields
+   * may be views, such as @c std::string_view.  They stay valid until
+   * @c func returns, but no longer.
+   *
+   * The rows stream in as the server sends them, and never build up into a
+   * full @c result, so memory use stays flat no matter how large the result
+   * is.  A plain @c SELECT, @c VALUES, or @c TABLE query goes through a
+   * @c COPY, as in @c stream_from::query(), which is the fastest way.  Any
+   * other query goes through a @c stream_query, in chunks of rows.
+   *
+   * @code
+   *	tx.for_query<int, std::string_view>(
+   *	  "SELECT id, name FROM item",
+   *	  [](int id, std::string_view name) { std::cout << id << name; });
+   * @endcode
+   *
+   * The query must not end in a semicolon.  As with the streams, the
+   * transaction can't do anything else until this is done.
+   *
+   * @throw usage_error If a row does not have exactly as many fields as
+   * there are types.
+   */
+  template<typename... TYPE, typename CALLABLE>
+  void for_query(std::string_view query, CALLABLE &&func)
+  {
+    if (streams_as_copy(query))
+      stream_each<stream_from, TYPE...>(query, func);
+    else
+      stream_each<stream_query, TYPE...>(query, func);
+  }
+
   /**
    * @name Parameterized statements
    *
@@ -316,7 +437,7 @@ public:
   result exec_params(std::string const &query, Args &&... args)
   {
     return internal_exec_params(
-      query, internal::params(std::forward<Args>(args)...));
+      query, make_params(std::forward<Args>(args)...));
   }
 
   // Execute parameterised statement, expect a single-row result.
@@ -347,6 +468,19 @@ public:
     check_rowcount_params(rows, r.size());
     return r;
   }
+
+  /// Execute an SQL statement with parameters; get the result in binary.
+  /** Works just like @c exec_params, except the server sends the result in
+   * binary format.  That saves formatting and parsing for types which have
+   * @c binary_traits, such as numbers.  But you can only read the fields as
+   * types which support binary conversion.
+   */
+  template<typename... Args>
+  result exec_params_binary(std::string const &query, Args &&... args)
+  {
+    return internal_exec_params(
+      query, make_params(std::forward<Args>(args)...), format::binary);
+  }
   //@}
 
   /**
@@ -383,14 +517,105 @@ public:
   {
     return internal_exec_prepared(
       zview{statement.c_str(), statement.size()},
-      internal::params(std::forward<Args>(args)...));
+      make_params(std::forward<Args>(args)...));
   }
 
   template<typename... Args>
   result exec_prepared(zview statement, Args &&... args)
   {
     return internal_exec_prepared(
-      statement, internal::params(std::forward<Args>(args)...));
+      statement, make_params(std::forward<Args>(args)...));
+  }
+
+  /// Execute a prepared statement through its typed handle.
+  /** See @c connection::prepare<TYPE...>().  Pass exactly one argument for
+   * each of the statement's parameter types.  They convert implicitly, so
+   * you can pass a string literal for a @c std::string, for example.
+   */
+  template<typename... TYPE, typename... Args>
+  result exec_prepared(prepared<TYPE...> &statement, Args const &... args)
+  {
+    static_assert(
+      sizeof...(Args) == sizeof...(TYPE),
+      "Wrong number of arguments for prepared statement.");
+    return internal_exec_prepared(statement.m_name, statement.bind(args...));
+  }
+
+  /// Execute a prepared statement; get the result in binary format.
+  /** Works just like @c exec_prepared, except the server sends the result in
+   * binary format.  See @c exec_params_binary.
+   */
+  template<typename... Args>
+  result exec_prepared_binary(std::string const &statement, Args &&... args)
+  {
+    return internal_exec_prepared(
+      zview{statement.c_str(), statement.size()},
+      make_params(std::forward<Args>(args)...), format::binary);
+  }
+
+  template<typename... Args>
+  result exec_prepared_binary(zview statement, Args &&... args)
+  {
+    return internal_exec_prepared(
+      statement, make_params(std::forward<Args>(args)...),
+      format::binary);
+  }
+
+  /// Execute a prepared statement; get each column in its cheapest format.
+  /** Numbers are cheaper to read in binary, but you may want other columns,
+   * such as dates or enums, in text.  The protocol allows a different format
+   * for each column, but libpq does not.
+   *
+   * This function asks for a binary result if some of the columns are
+   * cheaper to read in binary, and all others are types whose binary form is
+   * the same as their text, such as @c text, @c varchar, or @c json.  Those
+   * columns then show up as text columns, so you can read them just as you
+   * would in a text result.  If any other column is present, or none of the
+   * columns is cheaper in binary, the result comes in text format.
+   *
+   * The choice rests on @c connection::describe_prepared(), so it costs one
+   * extra round trip the first time you execute the statement, but none
+   * after that.  See @c prepare::description::column_formats.
+   */
+  template<typename... Args>
+  result exec_prepared_mixed(zview statement, Args &&... args)
+  {
+    return internal_exec_prepared_mixed(
+      statement, make_params(std::forward<Args>(args)...));
+  }
+
+  template<typename... Args>
+  result exec_prepared_mixed(std::string const &statement, Args &&... args)
+  {
+    return internal_exec_prepared_mixed(
+      zview{statement.c_str(), statement.size()},
+      make_params(std::forward<Args>(args)...));
+  }
+
+  /// Execute a prepared statement, for reading its rows as @c TYPE....
+  /** Asks for the result in binary format if each @c TYPE can read its
+   * column's SQL type in binary, or in text format otherwise.  Either way you
+   * can read the result through @c result::iter<TYPE...>().
+   *
+   * The choice rests on @c connection::describe_prepared(), so it costs one
+   * extra round trip the first time you execute the statement, but none
+   * after that.
+   */
+  template<typename... TYPE, typename... Args>
+  result exec_prepared_as(std::string const &statement, Args &&... args)
+  {
+    return exec_prepared_as<TYPE...>(
+      zview{statement.c_str(), statement.size()}, std::forward<Args>(args)...);
+  }
+
+  template<typename... TYPE, typename... Args>
+  result exec_prepared_as(zview statement, Args &&... args)
+  {
+    auto const binary{
+      conn().describe_prepared(statement).template binary_matches<TYPE...>()};
+    return internal_exec_prepared(
+      statement, make_params(std::forward<Args>(args)...),
+      binary ? format::binary : format::text);
   }
 
   /// Execute a prepared statement, and expect a single-row result.
@@ -445,6 +670,155 @@ public:
     return r;
   }
 
+  /// Execute a prepared statement once for each parameter set in a range.
+  /** Each element of @c param_sets is a tuple (or a pair, or a @c std::array)
+   * holding one execution's parameters.  All executions re-use the same
+   * parameter buffers.
+   *
+   * When libpq supports pipeline mode, the executions all go to the server
+   * without waiting for each other; there is just one synchronisation point,
+   * at the end.  If one fails, the server skips the rest, and this function
+   * throws the error.  Without pipeline mode, each execution is a separate
+   * round trip.
+   *
+   * Use this for statements that produce no data, such as an @c INSERT.
+   * Any rows that a statement returns are discarded.
+   *
+   * @return The number of rows affected by each execution, in order.
+   */
+  template<typename RANGE>
+  std::vector<result::size_type>
+  exec_prepared_bulk(std::string const &statement, RANGE const &param_sets)
+  {
+    return exec_prepared_bulk(
+      zview{statement.c_str(), statement.size()}, param_sets);
+  }
+
+  template<typename RANGE>
+  std::vector<result::size_type>
+  exec_prepared_bulk(zview statement, RANGE const &param_sets)
+  {
+    auto here{std::begin(param_sets)};
+    auto const end{std::end(param_sets)};
+    return internal_exec_prepared_bulk(
+      statement, [&here, &end](internal::params &args) {
+        if (here == end)
+          return false;
+        std::apply(
+          [&args](auto const &... fields) { args.assign(fields...); }, *here);
+        ++here;
+        return true;
+      });
+  }
+
+  /// Insert many rows into a table, in as few statements as possible.
+  /** Builds multi-row statements of the form
+   * <tt>INSERT INTO table (columns) VALUES ($1, $2), ($3, $4), ... tail</tt>
+   * and executes them as parameterised statements.  Each element of @c rows
+   * is a tuple (or a pair, or a @c std::array) holding one row's values, in
+   * the same order as @c columns.
+   *
+   * Use @c tail for whatever follows the values, such as
+   * <tt>ON CONFLICT (id) DO UPDATE SET x = excluded.x</tt>.  That makes this
+   * useful for bulk upserts, which a @c stream_to can't do.
+   *
+   * The rows are split over as many statements as it takes to keep each
+   * within @c limits.  When libpq supports pipeline mode, the statements all
+   * go to the server without waiting for each other, as in
+   * @c exec_prepared_bulk().  They all re-use one parameter buffer, and
+   * statements with the same number of rows share the same text.
+   *
+   * The table and column names go into the SQL as they are.  Quote them with
+   * @c quote_name() as needed.
+   *
+   * @return Total number of rows affected, as reported by the statements.
+   */
+  template<typename COLUMNS, typename RANGE>
+  std::size_t insert_bulk(
+    std::string_view table, COLUMNS const &columns, RANGE const &rows,
+    std::string_view tail = {}, bulk_insert_limits const &limits = {})
+  {
+    auto here{std::begin(rows)};
+    auto const end{std::end(rows)};
+    return internal_insert_bulk(
+      table, separated_list(",", columns), std::size(columns), tail, limits,
+      [&here, &end](internal::params &args) {
+        if (here == end)
+          return false;
+        std::apply(
+          [&args](auto const &... fields) { args.append(fields...); }, *here);
+        ++here;
+        return true;
+      });
+  }
+
+  template<typename RANGE>
+  std::size_t insert_bulk(
+    std::string_view table, std::initializer_list<std::string_view> columns,
+    RANGE const &rows, std::string_view tail = {},
+    bulk_insert_limits const &limits = {})
+  {
+    return insert_bulk<std::initializer_list<std::string_view>, RANGE>(
+      table, columns, rows, tail, limits);
+  }
+
+  /// Query the rows of @c table whose @c column holds any of @c keys.
+  /** Executes <tt>SELECT columns FROM table WHERE column = ANY($1)</tt>,
+   * passing all of @c keys as a single array parameter (see
+   * @c prepare::make_array_param).  That's one short statement, however many
+   * keys there are, instead of a long @c IN list for the server to parse.
+   *
+   * The table and column names go into the SQL as they are.  Quote them with
+   * @c quote_name() as needed.
+   */
+  template<typename KEY>
+  result select_by_keys(
+    std::string_view table, std::string_view column,
+    std::vector<KEY> const &keys, std::string_view columns = "*")
+  {
+    std::string query;
+    query.append("SELECT ").append(columns).append(" FROM ").append(table);
+    query.append(" WHERE ").append(column).append(" = ANY($1)");
+    return exec_params(query, prepare::make_array_param(keys));
+  }
+
+  /// Delete the rows of @c table whose @c column holds any of @c keys.
+  /** Executes <tt>DELETE FROM table WHERE column = ANY($1)</tt>, passing the
+   * keys as an array parameter, as @c select_by_keys() does.
+   *
+   * If @c chunk is nonzero, this deletes at most that many keys per
+   * statement, so that no single statement gets too large.
+   *
+   * @return Total number of rows deleted.
+   */
+  template<typename KEY>
+  std::size_t delete_by_keys(
+    std::string_view table, std::string_view column,
+    std::vector<KEY> const &keys, std::size_t chunk = 0)
+  {
+    std::string query;
+    query.append("DELETE FROM ").append(table).append(" WHERE ");
+    query.append(column).append(" = ANY($1)");
+    if (chunk == 0 or std::size(keys) <= chunk)
+      return static_cast<std::size_t>(
+        exec_params(query, prepare::make_array_param(keys)).affected_rows());
+
+    std::size_t total{0};
+    std::vector<KEY> part;
+    part.reserve(chunk);
+    for (auto here{std::begin(keys)}; here != std::end(keys);)
+    {
+      auto const left{static_cast<std::size_t>(std::end(keys) - here)};
+      auto const next{
+        here + static_cast<std::ptrdiff_t>(std::min(chunk, left))};
+      part.assign(here, next);
+      total += static_cast<std::size_t>(
+        exec_params(query, prepare::make_array_param(part)).affected_rows());
+      here = next;
+    }
+    return total;
+  }
+
   //@}
 
   /**
@@ -463,6 +837,52 @@ public:
   /// The connection in which this transaction lives.
   [[nodiscard]] connection &conn() const { return m_conn; }
 
+#if defined(PQXX_HAVE_PMR)
+  /// Allocate statement parameters' memory from @c resource.
+  /** Parameters for @c exec_params, @c exec_prepared and their variants
+   * normally live in inline buffers, and go to the heap only if they don't
+   * fit.  Set a memory resource, and they go there instead.  A
+   * @c std::pmr::monotonic_buffer_resource arena, for instance, makes that
+   * overflow as cheap as bumping a pointer.
+   *
+   * The resource must outlive every statement you execute while it is set.
+   * Pass null to go back to the heap.
+   */
+  void set_memory_resource(std::pmr::memory_resource *resource) noexcept
+  {
+    m_memory_resource = resource;
+  }
+
+  /// The memory resource for statement parameters, or null for the heap.
+  [[nodiscard]] std::pmr::memory_resource *memory_resource() const noexcept
+  {
+    return m_memory_resource;
+  }
+#endif
+
+  /// Count this transaction's round trips, statements, and traffic.
+  /** From here on, @c stats() shows how much work the transaction has done.
+   *
+   * With @c limits and @c alert, you can also have the transaction call
+   * @c alert when it goes over a number of round trips, or runs the same
+   * query too many times.  That's how you find "N+1" query patterns, where
+   * a loop runs a query per row that a single query could have handled.
+   *
+   * Counting costs a little time per query: reading the clock, and looking
+   * up the query text.  To collect statistics in every transaction on a
+   * connection, see @c connection::collect_transaction_stats().
+   */
+  void collect_stats(stats_limits limits = {}, stats_alert alert = {});
+
+  /// Round trips, statements, and traffic so far.
+  /** All zero unless the transaction is collecting statistics.  See
+   * @c collect_stats().
+   */
+  [[nodiscard]] transaction_stats const &stats() const noexcept
+  {
+    return m_stats;
+  }
+
   /// Set session variable using SQL "SET" command.
   /** The new value is typically forgotten if the transaction aborts.
    * Not for nontransaction though: in that case the set value will be kept
@@ -506,6 +926,40 @@ protected:
   result direct_exec(std::string_view);
   result direct_exec(std::shared_ptr<std::string>);
 
+  /// Send the opening command along with the first statement, not right now.
+  /** The command must stay valid for as long as the transaction lives.
+   */
+  void defer_begin(char const command[]) noexcept;
+  /// Forget the deferred opening command, if it hasn't gone out yet.
+  /** @return Whether there was one.  If so, the transaction never started on
+   * the server, so there is nothing to end.
+   */
+  bool drop_deferred_begin() noexcept;
+  /// Send a savepoint command along with the next statement, not right now.
+  void defer_savepoint(std::string command);
+  /// Take back deferred savepoint @c command, if it hasn't gone out yet.
+  /** Only the most recently deferred command can be taken back.
+   * @return Whether it was taken back.
+   */
+  bool drop_deferred_savepoint(std::string_view command) noexcept;
+  /// Execute query and then @c COMMIT, sending both in one go.
+  /** Also sends the deferred opening command, if there is one.
+   */
+  result direct_exec_commit(std::shared_ptr<std::string>);
+
+  /// Did the user ask for the commit's position in the write-ahead log?
+  bool capturing_commit_lsn() const noexcept { return m_capture_lsn; }
+  /// Set the commit's position from its text, e.g. "16/B374D848".
+  void set_commit_lsn(std::string_view text);
+  /// Ask the server for its position in the write-ahead log, as the commit's.
+  /** Call this right after committing, on the same connection.
+   */
+  void read_commit_lsn();
+
+  /// Query for the server's current insert position in the write-ahead log.
+  static constexpr char const commit_lsn_query[]{
+    "SELECT pg_catalog.pg_current_wal_insert_lsn()"};
+
 private:
   enum class status
   {
@@ -517,6 +971,62 @@ private:
   };
 
   PQXX_PRIVATE void check_pending_error();
+  /// Explain why the transaction can't execute a query right now.
+  /** Only for when it can't.  This builds the error message, so that
+   * @c exec() does not have to on its path for queries that succeed.
+   */
+  [[noreturn]] PQXX_PRIVATE void
+  throw_cannot_exec(std::string const &desc) const;
+
+  /// Build statement parameters, using the memory resource if there is one.
+  template<typename... Args>
+  internal::params make_params(Args &&... args) const
+  {
+    if constexpr (
+      sizeof...(args) == 1 and
+      (std::is_same_v<std::decay_t<Args>, internal::params> and ...))
+    {
+      // Ready-made parameters.  Use them as they are.
+      return internal::params(std::forward<Args>(args)...);
+    }
+    else
+    {
+      internal::params p;
+#if defined(PQXX_HAVE_PMR)
+      p.set_memory_resource(m_memory_resource);
+#endif
+      p.append(std::forward<Args>(args)...);
+      return p;
+    }
+  }
+
+  /// Can @c for_query() run @c query as a @c COPY?
+  /** Errs on the side of "no": only for queries starting with @c SELECT,
+   * @c VALUES, or @c TABLE, and without semicolons or the word @c INTO.
+   */
+  static bool streams_as_copy(std::string_view query) noexcept;
+
+  /// Rows per chunk when @c for_query() uses a @c stream_query.
+  static constexpr int for_query_chunk_rows{1000};
+
+  /// Run @c query through a @c STREAM, calling @c func on each row.
+  /** @c STREAM is a template parameter so that the stream classes need not
+   * be complete until this gets used.
+   */
+  template<typename STREAM, typename... TYPE, typename CALLABLE>
+  void stream_each(std::string_view query, CALLABLE &func)
+  {
+    if constexpr (std::is_same_v<STREAM, stream_from>)
+    {
+      auto stream{STREAM::query(*this, query)};
+      stream.template for_each<TYPE...>(func);
+    }
+    else
+    {
+      STREAM stream{*this, query, for_query_chunk_rows};
+      stream.template for_each<TYPE...>(func);
+    }
+  }
 
   template<typename T> bool parm_is_null(T *p) const noexcept
   {
@@ -524,10 +1034,29 @@ private:
   }
   template<typename T> bool parm_is_null(T) const noexcept { return false; }
 
-  result internal_exec_prepared(zview statement, internal::params const &args);
+  result internal_exec_prepared(
+    zview statement, internal::params const &args,
+    format result_format = format::text);
+  result internal_exec_prepared(
+    std::shared_ptr<std::string> const &statement,
+    internal::params const &args, format result_format = format::text);
 
-  result
-  internal_exec_params(std::string const &query, internal::params const &args);
+  result internal_exec_prepared_mixed(
+    zview statement, internal::params const &args);
+
+  result internal_exec_params(
+    std::string const &query, internal::params const &args,
+    format result_format = format::text);
+
+  std::vector<result::size_type> internal_exec_prepared_bulk(
+    zview statement, std::function<bool(internal::params &)> const &next);
+
+  /// Execute multi-row INSERTs, calling @c next_row to add each row.
+  std::size_t internal_insert_bulk(
+    std::string_view table, std::string const &columns,
+    std::size_t num_columns, std::string_view tail,
+    bulk_insert_limits const &limits,
+    std::function<bool(internal::params &)> const &next_row);
 
   /// Throw unexpected_rows if prepared statement returned wrong no. of rows.
   void check_rowcount_prepared(
@@ -537,6 +1066,10 @@ private:
   /// Throw unexpected_rows if wrong row count from parameterised statement.
   void check_rowcount_params(size_t expected_rows, size_t actual_rows);
 
+  friend class pqxx::internal::gate::transaction_connection;
+  /// Add a query to the statistics, and check the limits.
+  PQXX_PRIVATE void count_query(query_stats const &) noexcept;
+
   friend class pqxx::internal::gate::transaction_transactionfocus;
   PQXX_PRIVATE void register_focus(internal::transactionfocus *);
   PQXX_PRIVATE void unregister_focus(internal::transactionfocus *) noexcept;
@@ -547,7 +1080,20 @@ private:
   internal::unique<internal::transactionfocus> m_focus;
   status m_status = status::active;
   bool m_registered = false;
+  bool m_capture_lsn = false;
+  lsn m_commit_lsn = 0;
   std::string m_pending_error;
+#if defined(PQXX_HAVE_PMR)
+  std::pmr::memory_resource *m_memory_resource = nullptr;
+#endif
+
+  transaction_stats m_stats;
+  stats_limits m_stats_limits;
+  stats_alert m_stats_alert;
+  /// Number of executions of each query and prepared statement, so far.
+  std::map<std::string, std::size_t, std::less<>> m_repeats;
+  /// Re-usable buffer for composing queries.
+  query_builder m_builder{m_conn};
 };
 } // namespace pqxx
 
@@ -580,4 +1126,8 @@ inline constexpr zview begin_cmd<serializable, write_policy::read_only>{
 } // namespace pqxx::internal
 
 #include "pqxx/internal/compiler-internal-post.hxx"
+
+// The streams which for_query() uses.
+#include "pqxx/stream_from.hxx"
+#include "pqxx/stream_query.hxx"
 #endif
@@ -14,6 +14,10 @@
 #include "pqxx/compiler-public.hxx"
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
+#include <chrono>
+#include <exception>
+#include <functional>
+
 #include "pqxx/connection.hxx"
 #include "pqxx/transaction.hxx"
 
@@ -63,6 +67,107 @@ namespace pqxx
  */
 //@{
 
+/// What @c perform tells you about a failed attempt, before retrying.
+struct retry_event
+{
+  /// Number of the attempt that failed.  The first attempt is number 1.
+  int attempt;
+  /// The error which made the attempt fail.
+  std::exception const &cause;
+  /// Time spent in @c perform so far, including earlier pauses.
+  std::chrono::steady_clock::duration elapsed;
+  /// How long @c perform will pause before the next attempt.
+  std::chrono::milliseconds delay;
+};
+
+
+/// How @c perform retries a failed transaction.
+/** Between attempts, @c perform pauses.  The first pause is @c base_delay,
+ * and each next one doubles, up to @c max_delay.  With @c jitter, each pause
+ * is a random length between zero and that delay, so that clients which
+ * failed at the same time don't all come back at the same time.
+ */
+struct retry_policy
+{
+  /// Maximum number of attempts.  Must be greater than zero.
+  int attempts = 3;
+  /// Pause before the first retry.  Zero means: retry right away, always.
+  std::chrono::milliseconds base_delay{10};
+  /// Longest pause between two attempts.
+  std::chrono::milliseconds max_delay{1000};
+  /// Randomise each pause, up to its nominal delay?
+  bool jitter = true;
+  /// Stop retrying if the next attempt would start after this much time.
+  /** Counts from the start of the first attempt.  Zero means no limit.
+   */
+  std::chrono::milliseconds budget{0};
+  /// Optional callback, which @c perform calls before each retry.
+  /** This is a good place to count retries, log their causes, and so on.
+   */
+  std::function<void(retry_event const &)> on_retry;
+};
+
+
+namespace internal
+{
+/// Prepare to retry a failed @c perform attempt, or rethrow its error.
+/** Call this only from within a @c catch block for the error.  Reports the
+ * retry, and pauses.  If the attempt was the last one, or the budget is
+ * exhausted, rethrows the error instead.
+ */
+PQXX_LIBEXPORT void wait_to_retry(
+  retry_policy const &, int attempt,
+  std::chrono::steady_clock::time_point start, std::exception const &cause);
+} // namespace internal
+
+
+/// Execute a transaction with automatic retry, as set out in a policy.
+/** Works like the other @c perform, but lets you control how it retries.
+ */
+template<typename TRANSACTION_CALLBACK>
+inline auto
+perform(TRANSACTION_CALLBACK const &callback, retry_policy const &policy)
+  -> decltype(callback())
+{
+  if (policy.attempts <= 0)
+    throw std::invalid_argument{
+      "Zero or negative number of attempts passed to pqxx::perform()."};
+
+  auto const start{std::chrono::steady_clock::now()};
+  for (int attempt{1};; ++attempt)
+  {
+    try
+    {
+      return callback();
+    }
+    catch (in_doubt_error const &)
+    {
+      // Not sure whether transaction went through or not.  The last thing in
+      // the world that we should do now is try again!
+      throw;
+    }
+    catch (statement_completion_unknown const &)
+    {
+      // Not sure whether our last statement succeeded.  Don't risk running it
+      // again.
+      throw;
+    }
+    catch (broken_connection const &e)
+    {
+      // Connection failed.  May be worth retrying, if the transactor opens its
+      // own connection.
+      internal::wait_to_retry(policy, attempt, start, e);
+    }
+    catch (transaction_rollback const &e)
+    {
+      // Some error that may well be transient, such as serialization failure
+      // or deadlock.  Worth retrying.
+      internal::wait_to_retry(policy, attempt, start, e);
+    }
+  }
+}
+
+
 /// Simple way to execute a transaction with automatic retry.
 /**
  * Executes your transaction code as a callback.  Repeats it until it completes
@@ -88,6 +193,9 @@ namespace pqxx
  * callback, and change your program's data state only after @c perform
  * completes successfully.
  *
+ * Between attempts, @c perform pauses for a short, randomised, growing time:
+ * see @c retry_policy for the details, and for more control.
+ *
  * @param callback Transaction code that can be called with no arguments.
  * @param attempts Maximum number of times to attempt performing callback.
  *	Must be greater than zero.
@@ -97,46 +205,9 @@ template<typename TRANSACTION_CALLBACK>
 inline auto perform(TRANSACTION_CALLBACK const &callback, int attempts = 3)
   -> decltype(callback())
 {
-  if (attempts <= 0)
-    throw std::invalid_argument{
-      "Zero or negative number of attempts passed to pqxx::perform()."};
-
-  for (; attempts > 0; --attempts)
-  {
-    try
-    {
-      return callback();
-    }
-    catch (in_doubt_error const &)
-    {
-      // Not sure whether transaction went through or not.  The last thing in
-      // the world that we should do now is try again!
-      throw;
-    }
-    catch (statement_completion_unknown const &)
-    {
-      // Not sure whether our last statement succeeded.  Don't risk running it
-      // again.
-      throw;
-    }
-    catch (broken_connection const &)
-    {
-      // Connection failed.  May be worth retrying, if the transactor opens its
-      // own connection.
-      if (attempts <= 1)
-        throw;
-      continue;
-    }
-    catch (transaction_rollback const &)
-    {
-      // Some error that may well be transient, such as serialization failure
-      // or deadlock.  Worth retrying.
-      if (attempts <= 1)
-        throw;
-      continue;
-    }
-  }
-  throw pqxx::internal_error{"No outcome reached on perform()."};
+  retry_policy policy;
+  policy.attempts = attempts;
+  return perform(callback, policy);
 }
 } // namespace pqxx
 //@}
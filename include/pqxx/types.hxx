@@ -32,10 +32,24 @@ using field_size_type = size_t;
 /// Number of bytes in a large object.
 using large_object_size_type = int64_t;
 
+/// A position in the write-ahead log: a "log sequence number."
+using lsn = std::uint64_t;
+
+
+/// Format for data going to or coming from the database: text or binary.
+/** The values match libpq's format codes.
+ */
+enum class format : int
+{
+  text = 0,
+  binary = 1,
+};
+
 
 // Forward declarations, to help break compilation dependencies.
 // These won't necessarily include all classes in libpqxx.
 class binarystring;
+template<typename T> struct column_batch;
 class connection;
 class const_result_iterator;
 class const_reverse_result_iterator;
@@ -43,12 +57,19 @@ class const_reverse_row_iterator;
 class const_row_iterator;
 class dbtransaction;
 class field;
+class field_ref;
 class largeobjectaccess;
 class notification_receiver;
+class pipeline;
 struct range_error;
+class reactor;
 class result;
+class result_snapshot;
 class row;
+class row_ref;
 class stream_from;
+class stream_query;
+class tracer;
 class transaction_base;
 } // namespace pqxx
 
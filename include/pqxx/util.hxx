@@ -15,8 +15,10 @@
 #include "pqxx/internal/compiler-internal-pre.hxx"
 
 #include <cctype>
+#include <cstddef>
 #include <cstdio>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -97,7 +99,8 @@ inline TO check_cast(FROM value, char const description[])
     constexpr auto to_max{static_cast<unsigned_to>((to_limits::max)())};
     if constexpr (from_max > to_max)
     {
-      if (static_cast<unsigned_from>(value) > to_max)
+      // (Negative values passed the underflow check already.)
+      if (value > 0 and static_cast<unsigned_from>(value) > to_max)
         throw range_error(std::string{"Cast overflow: "} + description);
     }
   }
@@ -177,6 +180,58 @@ struct PQXX_LIBEXPORT thread_safety_model
 
 /// The "null" oid.
 constexpr oid oid_none{0};
+
+
+/// Buffer size for hex-escaping @c binary_bytes bytes of binary data.
+/** PostgreSQL's hex format for @c bytea is a backslash and an "x", followed
+ * by two hex digits per byte.  This includes room for a terminating zero.
+ */
+[[nodiscard]] constexpr std::size_t
+size_esc_bin(std::size_t binary_bytes) noexcept
+{
+  return 2 + 2 * binary_bytes + 1;
+}
+
+
+/// Number of bytes that @c escaped_bytes of hex-escaped data decode to.
+[[nodiscard]] constexpr std::size_t
+size_unesc_bin(std::size_t escaped_bytes) noexcept
+{
+  return (escaped_bytes < 2) ? 0 : ((escaped_bytes - 2) / 2);
+}
+
+
+/// Hex-escape binary data, in PostgreSQL's format for @c bytea literals.
+/** Writes the escaped form, plus a terminating zero, into @c buffer, which
+ * must have room for @c size_esc_bin(binary_data.size()) bytes.
+ *
+ * This does not go through libpq, and it does not need a connection: all
+ * supported PostgreSQL versions accept the hex format.
+ */
+PQXX_LIBEXPORT void
+esc_bin(std::string_view binary_data, char buffer[]) noexcept;
+
+
+/// Hex-escape binary data, in PostgreSQL's format for @c bytea literals.
+[[nodiscard]] PQXX_LIBEXPORT std::string
+esc_bin(std::string_view binary_data);
+
+
+/// Decode hex-escaped @c bytea data into @c buffer.
+/** The buffer must have room for @c size_unesc_bin(escaped_data.size())
+ * bytes.  Throws @c argument_error if the data is not in the hex format, or
+ * contains anything other than pairs of hex digits.
+ *
+ * This is the format in which the server sends @c bytea values, unless you
+ * set its @c bytea_output to the old "escape" format.
+ */
+PQXX_LIBEXPORT void
+unesc_bin(std::string_view escaped_data, std::byte buffer[]);
+
+
+/// Decode hex-escaped @c bytea data.
+[[nodiscard]] PQXX_LIBEXPORT std::vector<std::byte>
+unesc_bin(std::string_view escaped_data);
 } // namespace pqxx
 
 
@@ -0,0 +1,109 @@
+/* Definition of the pqxx::uuid type.
+ *
+ * pqxx::uuid holds a UUID as 16 bytes.
+ *
+ * DO NOT INCLUDE THIS FILE DIRECTLY; include pqxx/uuid instead.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#ifndef PQXX_H_UUID
+#define PQXX_H_UUID
+
+#include "pqxx/compiler-public.hxx"
+#include "pqxx/internal/compiler-internal-pre.hxx"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "pqxx/binary_traits.hxx"
+#include "pqxx/strconv.hxx"
+
+
+namespace pqxx
+{
+/// A UUID, as 16 bytes in network order: the same as PostgreSQL's @c uuid.
+/** Converting one of these to or from text or binary costs no allocations.
+ */
+struct uuid
+{
+  std::array<std::uint8_t, 16> bytes{};
+
+  [[nodiscard]] friend bool operator==(uuid const &a, uuid const &b) noexcept
+  {
+    return a.bytes == b.bytes;
+  }
+  [[nodiscard]] friend bool operator!=(uuid const &a, uuid const &b) noexcept
+  {
+    return a.bytes != b.bytes;
+  }
+  /// Orders UUIDs the way PostgreSQL does: bytewise.
+  [[nodiscard]] friend bool operator<(uuid const &a, uuid const &b) noexcept
+  {
+    return a.bytes < b.bytes;
+  }
+};
+
+
+template<> struct nullness<uuid> : no_null<uuid>
+{};
+
+
+/// Converts a @c uuid to and from text.
+/** Writes the standard lowercase form, with hyphens.  Reads the forms that
+ * PostgreSQL accepts: upper or lower case hexadecimal, with or without the
+ * hyphens between groups of four digits, and optionally between braces.
+ */
+template<> struct string_traits<uuid>
+{
+  static PQXX_LIBEXPORT uuid from_string(std::string_view text);
+
+  static zview to_buf(char *begin, char *end, uuid const &value)
+  {
+    auto const stop{into_buf(begin, end, value)};
+    return zview{begin, static_cast<std::size_t>(stop - begin - 1)};
+  }
+
+  static PQXX_LIBEXPORT char *into_buf(char *begin, char *end, uuid const &);
+
+  static constexpr std::size_t size_buffer(uuid const &) noexcept
+  {
+    return 37;
+  }
+};
+
+
+template<> struct binary_traits<uuid>
+{
+  /// OID of @c uuid.
+  static constexpr oid type_oid{2950};
+
+  [[nodiscard]] static uuid from_binary(std::string_view data)
+  {
+    uuid value;
+    internal::check_binary_size(data, std::size(value.bytes), "uuid");
+    std::memcpy(value.bytes.data(), data.data(), std::size(value.bytes));
+    return value;
+  }
+
+  [[nodiscard]] static constexpr std::size_t
+  binary_size(uuid const &value) noexcept
+  {
+    return std::size(value.bytes);
+  }
+
+  static char *into_binary(char *begin, char *end, uuid const &value)
+  {
+    internal::check_binary_space(begin, end, std::size(value.bytes), "uuid");
+    std::memcpy(begin, value.bytes.data(), std::size(value.bytes));
+    return begin + std::size(value.bytes);
+  }
+};
+} // namespace pqxx
+
+#include "pqxx/internal/compiler-internal-post.hxx"
+#endif
@@ -15,23 +15,26 @@
 
 #include "pqxx/array"
 #include "pqxx/except"
+#include "pqxx/internal/encodings.hxx"
 
 
 namespace pqxx
 {
 /// Scan to next glyph in the buffer.  Assumes there is one.
+template<internal::encoding_group E>
 std::string::size_type
 array_parser::scan_glyph(std::string::size_type pos) const
 {
-  return m_scan(m_input.data(), m_input.size(), pos);
+  return internal::glyph_scanner<E>::call(m_input.data(), m_input.size(), pos);
 }
 
 
 /// Scan to next glyph in a substring.  Assumes there is one.
+template<internal::encoding_group E>
 std::string::size_type array_parser::scan_glyph(
   std::string::size_type pos, std::string::size_type end) const
 {
-  return m_scan(m_input.data(), end, pos);
+  return internal::glyph_scanner<E>::call(m_input.data(), end, pos);
 }
 
 
@@ -40,11 +43,12 @@ std::string::size_type array_parser::scan_glyph(
  *
  * Returns the offset of the first character after the closing quote.
  */
+template<internal::encoding_group E>
 std::string::size_type array_parser::scan_single_quoted_string() const
 {
-  auto here{m_pos}, next{scan_glyph(here)};
-  for (here = next, next = scan_glyph(here); here < m_input.size();
-       here = next, next = scan_glyph(here))
+  auto here{m_pos}, next{scan_glyph<E>(here)};
+  for (here = next, next = scan_glyph<E>(here); here < m_input.size();
+       here = next, next = scan_glyph<E>(here))
   {
     if (next - here == 1)
       switch (m_input[here])
@@ -56,7 +60,7 @@ std::string::size_type array_parser::scan_single_quoted_string() const
         here = next;
         // (We can read beyond this quote because the array will always end in
         // a closing brace.)
-        next = scan_glyph(here);
+        next = scan_glyph<E>(here);
 
         if ((here + 1 < next) or (m_input[here] != '\''))
         {
@@ -71,7 +75,7 @@ std::string::size_type array_parser::scan_single_quoted_string() const
       case '\\':
         // Backslash escape.  Skip ahead by one more character.
         here = next;
-        next = scan_glyph(here);
+        next = scan_glyph<E>(here);
         break;
       }
   }
@@ -80,38 +84,40 @@ std::string::size_type array_parser::scan_single_quoted_string() const
 
 
 /// Parse a single-quoted SQL string: un-quote it and un-escape it.
-std::string
-array_parser::parse_single_quoted_string(std::string::size_type end) const
+/** Writes the result to @c output, replacing its previous contents.
+ */
+template<internal::encoding_group E>
+void array_parser::parse_single_quoted_string(
+  std::string::size_type end, std::string &output) const
 {
-  std::string output;
+  output.clear();
   // Maximum output size is same as the input size, minus the opening and
   // closing quotes.  In the worst case, the real number could be half that.
   // Usually it'll be a pretty close estimate.
   output.reserve(end - m_pos - 2);
-  for (auto here = m_pos + 1, next = scan_glyph(here, end); here < end - 1;
-       here = next, next = scan_glyph(here, end))
+  for (auto here = m_pos + 1, next = scan_glyph<E>(here, end); here < end - 1;
+       here = next, next = scan_glyph<E>(here, end))
   {
     if (next - here == 1 and (m_input[here] == '\'' or m_input[here] == '\\'))
     {
       // Skip escape.
       here = next;
-      next = scan_glyph(here, end);
+      next = scan_glyph<E>(here, end);
     }
 
     output.append(m_input.data() + here, m_input.data() + next);
   }
-
-  return output;
 }
 
 
 /// Find the end of a double-quoted SQL string in an SQL array.
+template<internal::encoding_group E>
 std::string::size_type array_parser::scan_double_quoted_string() const
 {
   auto here{m_pos};
-  auto next{scan_glyph(here)};
-  for (here = next, next = scan_glyph(here); here < m_input.size();
-       here = next, next = scan_glyph(here))
+  auto next{scan_glyph<E>(here)};
+  for (here = next, next = scan_glyph<E>(here); here < m_input.size();
+       here = next, next = scan_glyph<E>(here))
   {
     if (next - here == 1)
       switch (m_input[here])
@@ -119,7 +125,7 @@ std::string::size_type array_parser::scan_double_quoted_string() const
       case '\\':
         // Backslash escape.  Skip ahead by one more character.
         here = next;
-        next = scan_glyph(here);
+        next = scan_glyph<E>(here);
         break;
 
       case '"':
@@ -132,44 +138,46 @@ std::string::size_type array_parser::scan_double_quoted_string() const
 
 
 /// Parse a double-quoted SQL string: un-quote it and un-escape it.
-std::string
-array_parser::parse_double_quoted_string(std::string::size_type end) const
+/** Writes the result to @c output, replacing its previous contents.
+ */
+template<internal::encoding_group E>
+void array_parser::parse_double_quoted_string(
+  std::string::size_type end, std::string &output) const
 {
-  std::string output;
+  output.clear();
   // Maximum output size is same as the input size, minus the opening and
   // closing quotes.  In the worst case, the real number could be half that.
   // Usually it'll be a pretty close estimate.
   output.reserve(std::size_t(end - m_pos - 2));
 
-  for (auto here{scan_glyph(m_pos, end)}, next{scan_glyph(here, end)};
-       here < end - 1; here = next, next = scan_glyph(here, end))
+  for (auto here{scan_glyph<E>(m_pos, end)}, next{scan_glyph<E>(here, end)};
+       here < end - 1; here = next, next = scan_glyph<E>(here, end))
   {
     if ((next - here == 1) and (m_input[here] == '\\'))
     {
       // Skip escape.
       here = next;
-      next = scan_glyph(here, end);
+      next = scan_glyph<E>(here, end);
     }
 
     output.append(m_input.data() + here, m_input.data() + next);
   }
-
-  return output;
 }
 
 
 /// Find the end of an unquoted string in an SQL array.
 /** Assumes UTF-8 or an ASCII-superset single-byte encoding.
  */
+template<internal::encoding_group E>
 std::string::size_type array_parser::scan_unquoted_string() const
 {
-  auto here{m_pos}, next{scan_glyph(here)};
+  auto here{m_pos}, next{scan_glyph<E>(here)};
 
   while ((next - here) > 1 or (m_input[here] != ',' and
                                m_input[here] != ';' and m_input[here] != '}'))
   {
     here = next;
-    next = scan_glyph(here);
+    next = scan_glyph<E>(here);
   }
   return here;
 }
@@ -179,24 +187,40 @@ std::string::size_type array_parser::scan_unquoted_string() const
 /** Here, the special unquoted value NULL means a null value, not a string
  * that happens to spell "NULL".
  */
-std::string
+std::string_view
 array_parser::parse_unquoted_string(std::string::size_type end) const
 {
-  return std::string{m_input.data() + m_pos, m_input.data() + end};
+  return m_input.substr(m_pos, end - m_pos);
 }
 
 
 array_parser::array_parser(
   std::string_view input, internal::encoding_group enc) :
         m_input(input),
-        m_scan(internal::get_glyph_scanner(enc)),
+        m_encoding(enc),
         m_pos(0)
 {}
 
 
 std::pair<array_parser::juncture, std::string> array_parser::get_next()
 {
-  std::string value;
+  auto const [found, value]{get_next_view()};
+  return std::make_pair(found, std::string{value});
+}
+
+
+std::pair<array_parser::juncture, std::string_view>
+array_parser::get_next_view()
+{
+  return internal::with_encoding(
+    m_encoding, [this](auto e) { return parse_next<decltype(e)::value>(); });
+}
+
+
+template<internal::encoding_group E>
+std::pair<array_parser::juncture, std::string_view> array_parser::parse_next()
+{
+  std::string_view value;
 
   if (m_pos >= m_input.size())
     return std::make_pair(juncture::done, value);
@@ -204,10 +228,10 @@ std::pair<array_parser::juncture, std::string> array_parser::get_next()
   juncture found;
   std::string::size_type end;
 
-  if (scan_glyph(m_pos) - m_pos > 1)
+  if (scan_glyph<E>(m_pos) - m_pos > 1)
   {
     // Non-ASCII unquoted string.
-    end = scan_unquoted_string();
+    end = scan_unquoted_string<E>();
     value = parse_unquoted_string(end);
     found = juncture::string_value;
   }
@@ -217,30 +241,32 @@ std::pair<array_parser::juncture, std::string> array_parser::get_next()
     case '\0': throw failure{"Unexpected zero byte in array."};
     case '{':
       found = juncture::row_start;
-      end = scan_glyph(m_pos);
+      end = scan_glyph<E>(m_pos);
       break;
     case '}':
       found = juncture::row_end;
-      end = scan_glyph(m_pos);
+      end = scan_glyph<E>(m_pos);
       break;
     case '\'':
       found = juncture::string_value;
-      end = scan_single_quoted_string();
-      value = parse_single_quoted_string(end);
+      end = scan_single_quoted_string<E>();
+      parse_single_quoted_string<E>(end, m_buffer);
+      value = m_buffer;
       break;
     case '"':
       found = juncture::string_value;
-      end = scan_double_quoted_string();
-      value = parse_double_quoted_string(end);
+      end = scan_double_quoted_string<E>();
+      parse_double_quoted_string<E>(end, m_buffer);
+      value = m_buffer;
       break;
     default:
-      end = scan_unquoted_string();
+      end = scan_unquoted_string<E>();
       value = parse_unquoted_string(end);
       if (value == "NULL")
       {
         // In this one situation, as a special case, NULL means a null field,
         // not a string that happens to spell "NULL".
-        value.clear();
+        value = std::string_view{};
         found = juncture::null_value;
       }
       else
@@ -255,7 +281,7 @@ std::pair<array_parser::juncture, std::string> array_parser::get_next()
   // Skip a trailing field separator, if present.
   if (end < m_input.size())
   {
-    auto next{scan_glyph(end)};
+    auto next{scan_glyph<E>(end)};
     if (next - end == 1 and (m_input[end] == ',' or m_input[end] == ';'))
       end = next;
   }
@@ -0,0 +1,392 @@
+/** Implementation of the pqxx::arrow_reader class.
+ *
+ * pqxx::arrow_reader turns a binary stream_from into Apache Arrow batches.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include "pqxx/arrow_reader"
+
+#include "pqxx/internal/gates/stream_from-arrow_reader.hxx"
+
+
+namespace
+{
+using pqxx::internal::arrow_format;
+using pqxx::internal::pg_epoch_days;
+using pqxx::internal::pg_epoch_micros;
+
+
+/// Does @c type have variable-width values, with an offsets buffer?
+constexpr bool is_variable(pqxx::arrow_type type) noexcept
+{
+  return type == pqxx::arrow_type::utf8 or type == pqxx::arrow_type::binary;
+}
+
+
+/// Memory for an exported schema.
+struct schema_data
+{
+  std::string name;
+  std::vector<ArrowSchema> children;
+  std::vector<ArrowSchema *> child_ptrs;
+
+  ~schema_data() noexcept
+  {
+    for (auto &child : children)
+      if (child.release != nullptr)
+        child.release(&child);
+  }
+};
+
+
+void release_schema(ArrowSchema *schema) noexcept
+{
+  delete static_cast<schema_data *>(schema->private_data);
+  schema->release = nullptr;
+}
+
+
+/// Memory for one exported column.
+struct column_data
+{
+  std::vector<std::uint8_t> validity;
+  std::vector<std::uint8_t> values;
+  std::vector<std::int32_t> offsets;
+  std::array<void const *, 3> buffers{};
+};
+
+
+void release_column(ArrowArray *array) noexcept
+{
+  delete static_cast<column_data *>(array->private_data);
+  array->release = nullptr;
+}
+
+
+/// Memory for an exported record batch.
+/** The consumer may move children out of the batch, and release them on
+ * their own.  So each child owns its own memory.
+ */
+struct batch_data
+{
+  std::vector<ArrowArray> children;
+  std::vector<ArrowArray *> child_ptrs;
+  /// A struct array has just one buffer: its validity bitmap.  No nulls.
+  std::array<void const *, 1> buffers{};
+
+  ~batch_data() noexcept
+  {
+    for (auto &child : children)
+      if (child.release != nullptr)
+        child.release(&child);
+  }
+};
+
+
+void release_batch(ArrowArray *array) noexcept
+{
+  delete static_cast<batch_data *>(array->private_data);
+  array->release = nullptr;
+}
+
+
+/// Append a fixed-width value to a values buffer.
+template<typename T> void put(std::vector<std::uint8_t> &values, T value)
+{
+  auto const here{std::size(values)};
+  values.resize(here + sizeof(value));
+  std::memcpy(values.data() + here, &value, sizeof(value));
+}
+
+
+/// Convert a PostgreSQL date or timestamp to the Unix epoch.
+/** Leaves infinities alone: PostgreSQL represents those as the lowest and
+ * highest values of the type.
+ */
+template<typename T> T from_pg_epoch(T value, T offset) noexcept
+{
+  if (
+    value == std::numeric_limits<T>::max() or
+    value == std::numeric_limits<T>::min())
+    return value;
+  return static_cast<T>(value + offset);
+}
+
+
+/// Builds one column of a record batch.
+class column_builder
+{
+public:
+  column_builder(pqxx::arrow_type type, std::size_t rows) :
+          m_type{type}, m_data{std::make_unique<column_data>()}
+  {
+    m_data->validity.reserve((rows + 7) / 8);
+    switch (type)
+    {
+    case pqxx::arrow_type::boolean:
+      m_data->values.reserve((rows + 7) / 8);
+      break;
+    case pqxx::arrow_type::int16: m_data->values.reserve(rows * 2); break;
+    case pqxx::arrow_type::int32:
+    case pqxx::arrow_type::float32:
+    case pqxx::arrow_type::date32: m_data->values.reserve(rows * 4); break;
+    case pqxx::arrow_type::utf8:
+    case pqxx::arrow_type::binary:
+      m_data->offsets.reserve(rows + 1);
+      m_data->offsets.push_back(0);
+      break;
+    default: m_data->values.reserve(rows * 8); break;
+    }
+  }
+
+  /// Add a field.  If @c not_null is false, @c field is meaningless.
+  void append(bool not_null, std::string_view field)
+  {
+    auto &d{*m_data};
+    auto const bit{static_cast<std::uint8_t>(1u << (m_rows % 8))};
+    if (m_rows % 8 == 0)
+    {
+      d.validity.push_back(0);
+      if (m_type == pqxx::arrow_type::boolean)
+        d.values.push_back(0);
+    }
+    ++m_rows;
+    if (not_null)
+      d.validity.back() |= bit;
+    else
+      ++m_nulls;
+
+    switch (m_type)
+    {
+    case pqxx::arrow_type::boolean:
+      if (not_null and pqxx::binary_traits<bool>::from_binary(field))
+        d.values.back() |= bit;
+      break;
+    case pqxx::arrow_type::int16:
+      put(
+        d.values,
+        not_null ? from_binary<std::int16_t>(field) : std::int16_t{0});
+      break;
+    case pqxx::arrow_type::int32:
+      put(d.values, not_null ? from_binary<std::int32_t>(field) : 0);
+      break;
+    case pqxx::arrow_type::int64:
+      put(d.values, not_null ? from_binary<std::int64_t>(field) : 0);
+      break;
+    case pqxx::arrow_type::float32:
+      put(d.values, not_null ? from_binary<float>(field) : 0.0f);
+      break;
+    case pqxx::arrow_type::float64:
+      put(d.values, not_null ? from_binary<double>(field) : 0.0);
+      break;
+    case pqxx::arrow_type::date32:
+      put(
+        d.values,
+        not_null ?
+          from_pg_epoch(from_binary<std::int32_t>(field), pg_epoch_days) :
+          0);
+      break;
+    case pqxx::arrow_type::timestamp:
+    case pqxx::arrow_type::timestamptz:
+      put(
+        d.values,
+        not_null ?
+          from_pg_epoch(from_binary<std::int64_t>(field), pg_epoch_micros) :
+          std::int64_t{0});
+      break;
+    case pqxx::arrow_type::utf8:
+    case pqxx::arrow_type::binary:
+      if (not_null)
+        d.values.insert(
+          std::end(d.values), std::begin(field), std::end(field));
+      d.offsets.push_back(
+        pqxx::check_cast<std::int32_t>(std::size(d.values), "Arrow offset"));
+      break;
+    }
+  }
+
+  /// Hand the column over to an Arrow array.
+  void export_to(ArrowArray &out)
+  {
+    auto &d{*m_data};
+    // Consumers may not accept null buffer pointers, even for empty buffers.
+    d.validity.reserve(1);
+    d.values.reserve(1);
+    d.buffers[0] = d.validity.data();
+    std::int64_t buffers{2};
+    if (is_variable(m_type))
+    {
+      d.buffers[1] = d.offsets.data();
+      d.buffers[2] = d.values.data();
+      buffers = 3;
+    }
+    else
+    {
+      d.buffers[1] = d.values.data();
+    }
+    out = ArrowArray{
+      static_cast<std::int64_t>(m_rows),
+      m_nulls,
+      0,
+      buffers,
+      0,
+      d.buffers.data(),
+      nullptr,
+      nullptr,
+      release_column,
+      nullptr};
+    out.private_data = m_data.release();
+  }
+
+private:
+  template<typename T> static T from_binary(std::string_view field)
+  {
+    return pqxx::binary_traits<T>::from_binary(field);
+  }
+
+  pqxx::arrow_type const m_type;
+  std::unique_ptr<column_data> m_data;
+  std::size_t m_rows = 0;
+  std::int64_t m_nulls = 0;
+};
+} // namespace
+
+
+char const *pqxx::internal::arrow_format(arrow_type type)
+{
+  switch (type)
+  {
+  case arrow_type::boolean: return "b";
+  case arrow_type::int16: return "s";
+  case arrow_type::int32: return "i";
+  case arrow_type::int64: return "l";
+  case arrow_type::float32: return "f";
+  case arrow_type::float64: return "g";
+  case arrow_type::utf8: return "u";
+  case arrow_type::binary: return "z";
+  case arrow_type::date32: return "tdD";
+  case arrow_type::timestamp: return "tsu:";
+  case arrow_type::timestamptz: return "tsu:UTC";
+  }
+  throw argument_error{"Unknown Arrow type."};
+}
+
+
+pqxx::arrow_reader::arrow_reader(
+  stream_from &stream, std::vector<arrow_field> fields) :
+        m_stream{stream}, m_fields{std::move(fields)}
+{
+  if (stream.data_format() != format::binary)
+    throw usage_error{"An arrow_reader needs a stream in binary format."};
+  if (std::empty(m_fields))
+    throw argument_error{"An arrow_reader needs at least one column."};
+  for (auto const &field : m_fields) arrow_format(field.type);
+}
+
+
+void pqxx::arrow_reader::export_schema(ArrowSchema *out) const
+{
+  auto const columns{std::size(m_fields)};
+  auto data{std::make_unique<schema_data>()};
+  data->children.resize(columns);
+  data->child_ptrs.reserve(columns);
+  for (std::size_t i{0}; i < columns; ++i)
+  {
+    auto child{std::make_unique<schema_data>()};
+    child->name = m_fields[i].name;
+    auto &schema{data->children[i]};
+    schema = ArrowSchema{
+      arrow_format(m_fields[i].type),
+      child->name.c_str(),
+      nullptr,
+      ARROW_FLAG_NULLABLE,
+      0,
+      nullptr,
+      nullptr,
+      release_schema,
+      nullptr};
+    schema.private_data = child.release();
+    data->child_ptrs.push_back(&schema);
+  }
+
+  *out = ArrowSchema{
+    "+s",
+    "",
+    nullptr,
+    0,
+    static_cast<std::int64_t>(columns),
+    data->child_ptrs.data(),
+    nullptr,
+    release_schema,
+    nullptr};
+  out->private_data = data.release();
+}
+
+
+std::size_t
+pqxx::arrow_reader::read_batch(std::size_t max_rows, ArrowArray *out)
+{
+  if (max_rows == 0)
+    throw argument_error{"Reading an Arrow batch of zero rows."};
+
+  auto const num_columns{std::size(m_fields)};
+  std::vector<column_builder> columns;
+  columns.reserve(num_columns);
+  for (auto const &field : m_fields)
+    columns.emplace_back(field.type, max_rows);
+
+  pqxx::internal::gate::stream_from_arrow_reader gate{m_stream};
+  std::size_t rows{0};
+  while (rows < max_rows and gate.get_binary_row())
+  {
+    if (gate.binary_fields() != num_columns)
+      throw usage_error{
+        "Arrow reader has " + to_string(num_columns) +
+        " column(s), but stream has a row of " +
+        to_string(gate.binary_fields()) + "."};
+    auto here{gate.binary_row_start()};
+    for (auto &column : columns)
+    {
+      std::string_view field;
+      bool const not_null{gate.next_binary_field(here, field)};
+      column.append(not_null, field);
+    }
+    ++rows;
+  }
+  if (rows == 0)
+    return 0;
+
+  auto batch{std::make_unique<batch_data>()};
+  batch->children.resize(num_columns);
+  batch->child_ptrs.reserve(num_columns);
+  for (std::size_t i{0}; i < num_columns; ++i)
+  {
+    columns[i].export_to(batch->children[i]);
+    batch->child_ptrs.push_back(&batch->children[i]);
+  }
+
+  *out = ArrowArray{
+    static_cast<std::int64_t>(rows),
+    0,
+    0,
+    1,
+    static_cast<std::int64_t>(num_columns),
+    batch->buffers.data(),
+    batch->child_ptrs.data(),
+    nullptr,
+    release_batch,
+    nullptr};
+  out->private_data = batch.release();
+  return rows;
+}
@@ -0,0 +1,367 @@
+/** Implementation of the pqxx::arrow_writer class.
+ *
+ * pqxx::arrow_writer writes Apache Arrow batches into a binary stream_to.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "pqxx/arrow_writer"
+
+#include "pqxx/internal/gates/stream_to-arrow_writer.hxx"
+
+
+namespace
+{
+using pqxx::arrow_type;
+using pqxx::internal::into_big_endian;
+
+
+/// The @c arrow_type for an Arrow format string.
+arrow_type type_of(std::string_view format)
+{
+  for (auto const type :
+       {arrow_type::boolean, arrow_type::int16, arrow_type::int32,
+        arrow_type::int64, arrow_type::float32, arrow_type::float64,
+        arrow_type::utf8, arrow_type::binary, arrow_type::date32,
+        arrow_type::timestamp, arrow_type::timestamptz})
+    if (format == pqxx::internal::arrow_format(type))
+      return type;
+
+  // Any time zone means the values are in UTC.
+  constexpr std::string_view micros{"tsu:"};
+  if (format.substr(0, std::size(micros)) == micros)
+    return arrow_type::timestamptz;
+
+  throw pqxx::argument_error{
+    "Arrow format '" + std::string{format} +
+    "' is not supported for writing to a stream."};
+}
+
+
+std::vector<arrow_type> types_of(ArrowSchema const &schema)
+{
+  if (std::string_view{schema.format} != "+s")
+    throw pqxx::argument_error{
+      "Schema for an arrow_writer must be a struct, not '" +
+      std::string{schema.format} + "'."};
+  std::vector<arrow_type> types;
+  types.reserve(static_cast<std::size_t>(schema.n_children));
+  for (std::int64_t i{0}; i < schema.n_children; ++i)
+  {
+    if (schema.children[i]->dictionary != nullptr)
+      throw pqxx::argument_error{
+        "Arrow writer does not support dictionary-encoded columns."};
+    types.push_back(type_of(schema.children[i]->format));
+  }
+  return types;
+}
+
+
+/// Is bit @c i set in an Arrow bitmap?
+inline bool bit(void const *bitmap, std::int64_t i) noexcept
+{
+  return (static_cast<std::uint8_t const *>(bitmap)[i / 8] >> (i % 8)) & 1u;
+}
+
+
+/// The validity bitmap of @c array, or null if it has no nulls.
+inline void const *validity(ArrowArray const &array) noexcept
+{
+  return (array.null_count == 0) ? nullptr : array.buffers[0];
+}
+
+
+/// Is element @c i valid, according to @c bitmap from @c validity()?
+inline bool is_valid(void const *bitmap, std::int64_t i) noexcept
+{
+  return bitmap == nullptr or bit(bitmap, i);
+}
+
+
+/// Load element @c i from a buffer of fixed-width values.
+template<typename T> inline T load(void const *values, std::int64_t i) noexcept
+{
+  T value;
+  std::memcpy(
+    &value, static_cast<char const *>(values) + i * std::int64_t{sizeof(T)},
+    sizeof(T));
+  return value;
+}
+
+
+/// Width of a fixed-width type's values in binary COPY, or zero if variable.
+constexpr std::size_t binary_width(arrow_type type) noexcept
+{
+  switch (type)
+  {
+  case arrow_type::boolean: return 1;
+  case arrow_type::int16: return 2;
+  case arrow_type::int32:
+  case arrow_type::float32:
+  case arrow_type::date32: return 4;
+  case arrow_type::int64:
+  case arrow_type::float64:
+  case arrow_type::timestamp:
+  case arrow_type::timestamptz: return 8;
+  case arrow_type::utf8:
+  case arrow_type::binary: return 0;
+  }
+  return 0;
+}
+
+
+/// Convert a date or timestamp from the Unix epoch to PostgreSQL's.
+/** Leaves the lowest and highest values alone: those are infinities.  Out of
+ * range values wrap around, and the server rejects them.
+ */
+template<typename T> T to_pg_epoch(T value, T offset) noexcept
+{
+  if (
+    value == std::numeric_limits<T>::max() or
+    value == std::numeric_limits<T>::min())
+    return value;
+  using unsigned_type = std::make_unsigned_t<T>;
+  return static_cast<T>(
+    static_cast<unsigned_type>(value) - static_cast<unsigned_type>(offset));
+}
+
+
+/// Write a column of fixed-width values into the rows at @c rows.
+/** Each entry in @c rows is the offset in @c data where the row's next field
+ * goes.  Moves them on to the next field.
+ */
+template<typename T, typename CONVERT>
+void write_fixed(
+  char *data, std::vector<std::size_t> &rows, ArrowArray const &column,
+  std::int64_t base, CONVERT convert)
+{
+  auto const bitmap{validity(column)};
+  auto const values{column.buffers[1]};
+  auto const num_rows{std::size(rows)};
+  for (std::size_t r{0}; r < num_rows; ++r)
+  {
+    auto const i{base + static_cast<std::int64_t>(r)};
+    char *here{data + rows[r]};
+    if (is_valid(bitmap, i))
+    {
+      auto const value{convert(load<T>(values, i))};
+      here = into_big_endian(here, std::int32_t{sizeof(value)});
+      here = into_big_endian(here, value);
+    }
+    else
+    {
+      here = into_big_endian(here, std::int32_t{-1});
+    }
+    rows[r] = static_cast<std::size_t>(here - data);
+  }
+}
+
+
+template<typename T> T same(T value) noexcept
+{
+  return value;
+}
+
+
+template<typename FLOAT, typename BITS> BITS float_bits(FLOAT value) noexcept
+{
+  static_assert(sizeof(FLOAT) == sizeof(BITS));
+  BITS bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+
+std::int32_t date_from_arrow(std::int32_t value) noexcept
+{
+  return to_pg_epoch(value, pqxx::internal::pg_epoch_days);
+}
+
+
+std::int64_t timestamp_from_arrow(std::int64_t value) noexcept
+{
+  return to_pg_epoch(value, pqxx::internal::pg_epoch_micros);
+}
+} // namespace
+
+
+pqxx::arrow_writer::arrow_writer(
+  stream_to &stream, std::vector<arrow_type> types) :
+        m_stream{stream}, m_types{std::move(types)}
+{
+  if (stream.data_format() != format::binary)
+    throw usage_error{"An arrow_writer needs a stream in binary format."};
+  if (std::empty(m_types))
+    throw argument_error{"An arrow_writer needs at least one column."};
+  if (std::size(m_types) > 32767)
+    throw argument_error{"Too many fields for binary COPY."};
+  for (auto const type : m_types) internal::arrow_format(type);
+}
+
+
+pqxx::arrow_writer::arrow_writer(
+  stream_to &stream, ArrowSchema const &schema) :
+        arrow_writer{stream, types_of(schema)}
+{}
+
+
+void pqxx::arrow_writer::write_batch(ArrowArray const &batch)
+{
+  if (not m_stream)
+    throw usage_error{"Writing an Arrow batch to a finished stream."};
+  if (batch.release == nullptr)
+    throw argument_error{"Writing an Arrow batch that was released."};
+  auto const num_columns{std::size(m_types)};
+  if (batch.n_children != static_cast<std::int64_t>(num_columns))
+    throw argument_error{
+      "Arrow writer has " + to_string(num_columns) +
+      " column(s), but batch has " + to_string(batch.n_children) + "."};
+  if (batch.null_count != 0 and batch.buffers[0] != nullptr)
+    throw argument_error{"Arrow batch has null rows."};
+  auto const num_rows{check_cast<std::size_t>(batch.length, "Arrow batch")};
+  if (num_rows == 0)
+    return;
+  for (std::size_t c{0}; c < num_columns; ++c)
+  {
+    auto const &column{*batch.children[c]};
+    if (column.length < batch.offset + batch.length)
+      throw argument_error{
+        "Arrow column " + to_string(c) + " is shorter than its batch."};
+    if (column.dictionary != nullptr)
+      throw argument_error{
+        "Arrow writer does not support dictionary-encoded columns."};
+  }
+
+  // Size each row: field count, length prefix for each field, and the data.
+  m_rows.assign(num_rows, 2 + 4 * num_columns);
+  for (std::size_t c{0}; c < num_columns; ++c)
+  {
+    auto const &column{*batch.children[c]};
+    auto const base{batch.offset + column.offset};
+    auto const bitmap{validity(column)};
+    auto const width{binary_width(m_types[c])};
+    if (width == 0)
+    {
+      auto const offsets{static_cast<std::int32_t const *>(column.buffers[1])};
+      for (std::size_t r{0}; r < num_rows; ++r)
+      {
+        auto const i{base + static_cast<std::int64_t>(r)};
+        if (is_valid(bitmap, i))
+          m_rows[r] += static_cast<std::size_t>(offsets[i + 1] - offsets[i]);
+      }
+    }
+    else
+    {
+      for (std::size_t r{0}; r < num_rows; ++r)
+        if (is_valid(bitmap, base + static_cast<std::int64_t>(r)))
+          m_rows[r] += width;
+    }
+  }
+
+  // Turn the sizes into write positions, and make room for all rows.
+  internal::gate::stream_to_arrow_writer gate{m_stream};
+  auto &buffer{gate.buffer()};
+  auto here{std::size(buffer)};
+  for (auto &row : m_rows) here += std::exchange(row, here);
+  buffer.resize(here);
+  char *const data{buffer.data()};
+
+  auto const fields{static_cast<std::int16_t>(num_columns)};
+  for (auto &row : m_rows)
+    row = static_cast<std::size_t>(
+      into_big_endian(data + row, fields) - data);
+
+  // Fill in the fields, one column at a time.
+  for (std::size_t c{0}; c < num_columns; ++c)
+  {
+    auto const &column{*batch.children[c]};
+    auto const base{batch.offset + column.offset};
+    switch (m_types[c])
+    {
+    case arrow_type::boolean:
+    {
+      auto const bitmap{validity(column)};
+      for (std::size_t r{0}; r < num_rows; ++r)
+      {
+        auto const i{base + static_cast<std::int64_t>(r)};
+        char *out{data + m_rows[r]};
+        if (is_valid(bitmap, i))
+        {
+          out = into_big_endian(out, std::int32_t{1});
+          *out++ = bit(column.buffers[1], i) ? '\1' : '\0';
+        }
+        else
+        {
+          out = into_big_endian(out, std::int32_t{-1});
+        }
+        m_rows[r] = static_cast<std::size_t>(out - data);
+      }
+    }
+    break;
+    case arrow_type::int16:
+      write_fixed<std::int16_t>(
+        data, m_rows, column, base, same<std::int16_t>);
+      break;
+    case arrow_type::int32:
+      write_fixed<std::int32_t>(
+        data, m_rows, column, base, same<std::int32_t>);
+      break;
+    case arrow_type::int64:
+      write_fixed<std::int64_t>(
+        data, m_rows, column, base, same<std::int64_t>);
+      break;
+    case arrow_type::float32:
+      write_fixed<float>(
+        data, m_rows, column, base, float_bits<float, std::uint32_t>);
+      break;
+    case arrow_type::float64:
+      write_fixed<double>(
+        data, m_rows, column, base, float_bits<double, std::uint64_t>);
+      break;
+    case arrow_type::date32:
+      write_fixed<std::int32_t>(data, m_rows, column, base, date_from_arrow);
+      break;
+    case arrow_type::timestamp:
+    case arrow_type::timestamptz:
+      write_fixed<std::int64_t>(
+        data, m_rows, column, base, timestamp_from_arrow);
+      break;
+    case arrow_type::utf8:
+    case arrow_type::binary:
+    {
+      auto const bitmap{validity(column)};
+      auto const offsets{static_cast<std::int32_t const *>(column.buffers[1])};
+      auto const values{static_cast<char const *>(column.buffers[2])};
+      for (std::size_t r{0}; r < num_rows; ++r)
+      {
+        auto const i{base + static_cast<std::int64_t>(r)};
+        char *out{data + m_rows[r]};
+        if (is_valid(bitmap, i))
+        {
+          auto const len{offsets[i + 1] - offsets[i]};
+          out = into_big_endian(out, len);
+          std::memcpy(out, values + offsets[i], static_cast<std::size_t>(len));
+          out += len;
+        }
+        else
+        {
+          out = into_big_endian(out, std::int32_t{-1});
+        }
+        m_rows[r] = static_cast<std::size_t>(out - data);
+      }
+    }
+    break;
+    }
+  }
+
+  gate.flush_if_full();
+}
@@ -9,6 +9,7 @@
 #include "pqxx-source.hxx"
 
 #include <cstdio>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
@@ -23,6 +24,8 @@ extern "C"
 #include "pqxx/binarystring"
 #include "pqxx/field"
 
+#include "pqxx/internal/gates/field-binarystring.hxx"
+
 
 namespace
 {
@@ -42,6 +45,32 @@ std::shared_ptr<unsigned char> copy_to_buffer(void const *data, size_t len)
 
 pqxx::binarystring::binarystring(field const &F)
 {
+  if (F.is_binary())
+  {
+    // Binary bytea data comes to us as-is.  Share the result's buffer, which
+    // libpq zero-terminates, instead of copying it.
+    m_size = F.size();
+    m_buf = std::shared_ptr<unsigned char>{
+      internal::gate::field_binarystring{F}.result_data(),
+      reinterpret_cast<unsigned char *>(const_cast<char *>(F.c_str()))};
+    return;
+  }
+
+  std::string_view const escaped{F.view()};
+  if (escaped.size() >= 2 and escaped[0] == '\\' and escaped[1] == 'x')
+  {
+    m_size = size_unesc_bin(escaped.size());
+    void *const output{std::malloc(m_size + 1)};
+    if (output == nullptr)
+      throw std::bad_alloc{};
+    m_buf = std::shared_ptr<unsigned char>{
+      static_cast<unsigned char *>(output), std::free};
+    unesc_bin(escaped, static_cast<std::byte *>(output));
+    m_buf.get()[m_size] = '\0';
+    return;
+  }
+
+  // Old "escape" format.
   unsigned char const *data{
     reinterpret_cast<unsigned char const *>(F.c_str())};
   m_buf =
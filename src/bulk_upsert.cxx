@@ -0,0 +1,111 @@
+/** Implementation of the pqxx::bulk_upsert class.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <string>
+#include <vector>
+
+#include "pqxx/bulk_upsert"
+#include "pqxx/except"
+#include "pqxx/pipeline"
+
+
+namespace
+{
+/// Create a staging table for @c columns of @c table.  Return its name.
+std::string make_staging(
+  pqxx::transaction_base &tx, std::string_view table,
+  std::string const &columns)
+{
+  auto name{tx.conn().adorn_name("pqxx_upsert")};
+  std::string query;
+  query.append("CREATE TEMP TABLE ").append(name);
+  query.append(" ON COMMIT DROP AS SELECT ");
+  query.append(std::empty(columns) ? std::string_view{"*"} : columns);
+  query.append(" FROM ").append(table).append(" WITH NO DATA");
+  tx.exec0(query);
+  return name;
+}
+
+
+/// The statement that merges the staging table into @c table.
+/** If @c key is not empty, the merge keeps only one row for each combination
+ * of values in those columns.
+ */
+std::string make_merge(
+  std::string_view table, std::string const &columns,
+  std::string const &staging, std::string_view conflict,
+  std::vector<pqxx::row_size_type> const &key)
+{
+  std::string query;
+  query.append("INSERT INTO ").append(table);
+  if (not std::empty(columns))
+    query.append(" (").append(columns).append(")");
+  query.append(" SELECT ");
+  if (not std::empty(key))
+  {
+    // DISTINCT ON takes output column numbers, counting from one.
+    query.append("DISTINCT ON (");
+    for (std::size_t i{0}; i < std::size(key); ++i)
+    {
+      if (i > 0)
+        query.push_back(',');
+      query.append(pqxx::to_string(key[i] + 1));
+    }
+    query.append(") ");
+  }
+  query.append(std::empty(columns) ? std::string_view{"*"} : columns)
+    .append(" FROM ")
+    .append(staging);
+  if (not std::empty(conflict))
+    query.append(" ").append(conflict);
+  return query;
+}
+} // namespace
+
+
+pqxx::bulk_upsert::bulk_upsert(
+  transaction_base &tx, std::string_view table, std::string &&columns,
+  std::string_view conflict, format data_format, std::nullptr_t) :
+        m_tx{tx},
+        m_columns{std::move(columns)},
+        m_staging{make_staging(tx, table, m_columns)},
+        m_table{table},
+        m_conflict{conflict},
+        m_stream{tx, m_staging, data_format}
+{}
+
+
+void pqxx::bulk_upsert::set_dedup(
+  std::vector<row_size_type> key, std::size_t max_memory)
+{
+  m_stream.set_dedup(key, max_memory);
+  m_key = std::move(key);
+}
+
+
+std::size_t pqxx::bulk_upsert::complete()
+{
+  if (m_done)
+    throw usage_error{"Completing a bulk_upsert twice."};
+  m_done = true;
+  m_stream.complete();
+
+  // Only if duplicates may have got through does the merge need to weed them
+  // out.  Otherwise, it can save itself the trouble.
+  static std::vector<row_size_type> const no_key;
+  auto const &key{m_stream.dedup_overflowed() ? m_key : no_key};
+  pipeline p{m_tx, "bulk_upsert"};
+  auto const merge{
+    p.insert(make_merge(m_table, m_columns, m_staging, m_conflict, key))};
+  p.insert("DROP TABLE " + m_staging);
+  auto const r{p.retrieve(merge)};
+  p.complete();
+  return static_cast<std::size_t>(r.affected_rows());
+}
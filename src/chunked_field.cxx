@@ -0,0 +1,137 @@
+/** Implementation of the pqxx::chunked_field_buf class.
+ *
+ * pqxx::chunked_field_buf reads one huge field value in chunks.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <cstddef>
+#include <exception>
+#include <limits>
+
+#include "pqxx/except"
+#include "pqxx/chunked_field"
+
+
+namespace
+{
+/// OID of the @c bytea type.
+constexpr pqxx::oid bytea_oid{17};
+} // namespace
+
+
+pqxx::chunked_field_buf::~chunked_field_buf() noexcept
+{
+  // Let the chunks in flight come in, so the transaction stays usable.
+  try
+  {
+    if (m_pipe)
+      finish();
+  }
+  catch (std::exception const &)
+  {}
+}
+
+
+void pqxx::chunked_field_buf::init(std::string_view query)
+{
+  if (m_chunks.chunk_size == 0 or
+      m_chunks.chunk_size >
+        static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    throw argument_error{
+      "Invalid field chunk size: " + to_string(m_chunks.chunk_size) + "."};
+
+  auto const first{std::size(m_params) + 1};
+  m_query = "SELECT pg_catalog.substr(v, $" + to_string(first) + ", $" +
+            to_string(first + 1) + ") FROM (";
+  m_query += query;
+  m_query += ") AS pqxx_field(v)";
+}
+
+
+void pqxx::chunked_field_buf::issue()
+{
+  while (not m_end and m_in_flight <= m_chunks.readahead)
+  {
+    internal::params chunk{m_params};
+    chunk.append(m_next, m_chunks.chunk_size);
+    m_pipe->insert_params(m_query, chunk);
+    m_next += m_chunks.chunk_size;
+    ++m_in_flight;
+  }
+}
+
+
+void pqxx::chunked_field_buf::finish()
+{
+  m_end = true;
+  while (m_in_flight > 0)
+  {
+    --m_in_flight;
+    m_pipe->retrieve();
+  }
+  m_pipe.reset();
+}
+
+
+pqxx::chunked_field_buf::int_type pqxx::chunked_field_buf::underflow()
+{
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+  if (m_end)
+    return traits_type::eof();
+
+  if (not m_pipe)
+  {
+    m_pipe.emplace(m_trans);
+    m_pipe->retain(0);
+  }
+  issue();
+
+  --m_in_flight;
+  m_current = m_pipe->retrieve().second;
+  ++m_fetches;
+  if (std::size(m_current) != 1)
+    throw unexpected_rows{
+      "Field stream query returned " + to_string(std::size(m_current)) +
+      " rows; expected 1."};
+
+  auto const f{m_current[0][0]};
+  std::string_view data;
+  if (f.is_null())
+  {
+    // Leave data empty.
+  }
+  else if (m_current.column_type(0) == bytea_oid)
+  {
+    auto const escaped{f.view()};
+    m_buffer.resize(size_unesc_bin(std::size(escaped)));
+    unesc_bin(escaped, reinterpret_cast<std::byte *>(std::data(m_buffer)));
+    data = m_buffer;
+  }
+  else
+  {
+    data = f.view();
+  }
+
+  // A chunk of text takes at least one byte per character.  So in bytes or
+  // in characters, a short chunk is the last one.
+  if (std::size(data) < m_chunks.chunk_size)
+    finish();
+  else
+    issue();
+
+  if (std::empty(data))
+    return traits_type::eof();
+
+  // The stream only reads from the get area, so we can point it right into
+  // the result or the buffer.
+  auto const begin{const_cast<char *>(std::data(data))};
+  setg(begin, begin, begin + std::size(data));
+  return traits_type::to_int_type(*gptr());
+}
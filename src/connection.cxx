@@ -16,11 +16,17 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <ctime>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <system_error>
+#include <tuple>
 
 // For WSAPoll():
 #if __has_include(<winsock2.h>)
@@ -33,6 +39,12 @@
 #  include <mstcpip.h>
 #endif
 
+// For looking up host addresses in connect_first():
+#if __has_include(<netdb.h>)
+#  include <netdb.h>
+#  include <sys/socket.h>
+#endif
+
 // For poll():
 #if __has_include(<poll.h>)
 #  include <poll.h>
@@ -66,30 +78,129 @@ extern "C"
 #include "pqxx/notification"
 #include "pqxx/pipeline"
 #include "pqxx/result"
+#include "pqxx/separated_list"
 #include "pqxx/strconv"
+#include "pqxx/tracer"
 #include "pqxx/transaction"
 
 #include "pqxx/internal/gates/errorhandler-connection.hxx"
 #include "pqxx/internal/gates/result-connection.hxx"
 #include "pqxx/internal/gates/result-creation.hxx"
+#include "pqxx/internal/gates/transaction-connection.hxx"
+#include "pqxx/internal/slow_query_log.hxx"
+#include "pqxx/internal/tracepoints.hxx"
 
 
 extern "C"
 {
-  // The PQnoticeProcessor that receives an error or warning from libpq and
-  // sends it to the appropriate connection for processing.
-  void pqxx_notice_processor(void *conn, char const *msg) noexcept
+  // The PQnoticeReceiver that receives an error or warning from libpq and
+  // sends it to the appropriate connection for processing.  The notice's
+  // fields all point into the PGresult, so there's nothing to allocate.
+  void pqxx_notice_receiver(void *conn, PGresult const *res) noexcept
   {
-    reinterpret_cast<pqxx::connection *>(conn)->process_notice(msg);
+    auto const field{[res](int code) noexcept {
+      auto const value{PQresultErrorField(res, code)};
+      return (value == nullptr) ? pqxx::zview{""} : pqxx::zview{value};
+    }};
+    pqxx::notice n;
+    n.message = pqxx::zview{PQresultErrorMessage(res)};
+#if defined(PG_DIAG_SEVERITY_NONLOCALIZED)
+    n.severity = field(PG_DIAG_SEVERITY_NONLOCALIZED);
+    if (n.severity.empty())
+#endif
+      n.severity = field(PG_DIAG_SEVERITY);
+    n.sqlstate = field(PG_DIAG_SQLSTATE);
+    n.primary = field(PG_DIAG_MESSAGE_PRIMARY);
+    n.detail = field(PG_DIAG_MESSAGE_DETAIL);
+    n.hint = field(PG_DIAG_MESSAGE_HINT);
+    reinterpret_cast<pqxx::connection *>(conn)->process_notice(n);
   }
 
 
-  // There's no way in libpq to disable a connection's notice processor.  So,
+  // There's no way in libpq to disable a connection's notice receiver.  So,
   // set an inert one to get the same effect.
-  void inert_notice_processor(void *, char const *) noexcept {}
+  void inert_notice_receiver(void *, PGresult const *) noexcept {}
 } // extern "C"
 
 
+namespace
+{
+/// Number of bytes of query text and parameters.
+std::size_t
+query_size(std::string_view query, pqxx::internal::params const *args)
+{
+  auto total{std::size(query)};
+  if (args != nullptr)
+    for (auto const len : args->lengths)
+      total += static_cast<std::size_t>(len);
+  return total;
+}
+
+
+/// Rows which a statement returned, or affected.
+pqxx::result_size_type rows_of(pqxx::result const &r)
+{
+  return std::empty(r) ? r.affected_rows() : std::size(r);
+}
+
+
+/// Number of parameter types to pass to libpq for @c s.
+int num_types(pqxx::prepare::statement const &s)
+{
+  return pqxx::check_cast<int>(std::size(s.types), "prepared statement types");
+}
+
+
+/// Is a value of this SQL type cheaper to decode in binary than in text?
+/** This is for types with a fixed, simple binary form, such as numbers.
+ */
+constexpr bool cheap_in_binary(pqxx::oid type) noexcept
+{
+  switch (type)
+  {
+  case 16:  // bool
+  case 17:  // bytea
+  case 20:  // int8
+  case 21:  // int2
+  case 23:  // int4
+  case 26:  // oid
+  case 700: // float4
+  case 701: // float8
+    return true;
+  default: return false;
+  }
+}
+
+
+/// Is a value of this SQL type the same in binary as in text?
+/** The server sends these as just their text, in either format.  (Like all
+ * fields, libpq terminates them with a zero byte.)
+ */
+constexpr bool same_in_binary(pqxx::oid type) noexcept
+{
+  switch (type)
+  {
+  case 19:   // name
+  case 25:   // text
+  case 114:  // json
+  case 142:  // xml
+  case 705:  // unknown
+  case 1042: // bpchar
+  case 1043: // varchar
+    return true;
+  default: return false;
+  }
+}
+
+
+/// Parameter types to pass to libpq for @c s.
+pqxx::oid const *types_of(pqxx::prepare::statement const &s) noexcept
+{
+  return std::empty(s.types) ? nullptr : std::data(s.types);
+}
+} // namespace
+
+
 std::string pqxx::encrypt_password(char const user[], char const password[])
 {
   std::unique_ptr<char, std::function<void(char *)>> p{
@@ -100,10 +211,50 @@ std::string pqxx::encrypt_password(char const user[], char const password[])
 
 pqxx::connection::connection(connection &&rhs) :
         m_conn{rhs.m_conn},
-        m_unique_id{rhs.m_unique_id}
+        m_cancel{rhs.m_cancel},
+        m_cancel_conn{rhs.m_cancel_conn},
+        m_reconnect{rhs.m_reconnect},
+        m_trust_encoding{rhs.m_trust_encoding},
+        m_session_statements{std::move(rhs.m_session_statements)},
+        m_session_variables{std::move(rhs.m_session_variables)},
+        m_last_query{std::move(rhs.m_last_query)},
+        m_statement_names{std::move(rhs.m_statement_names)},
+        m_descriptions{std::move(rhs.m_descriptions)},
+        m_tables{std::move(rhs.m_tables)},
+        m_unique_id{rhs.m_unique_id},
+        m_query_hook{std::move(rhs.m_query_hook)},
+        m_tracer{std::move(rhs.m_tracer)},
+        m_stats_defaults{std::move(rhs.m_stats_defaults)},
+        m_slow_log{std::move(rhs.m_slow_log)},
+        m_auto_prepare{std::move(rhs.m_auto_prepare)},
+        m_auto_lru{std::move(rhs.m_auto_lru)},
+        m_auto_prepare_runs{rhs.m_auto_prepare_runs},
+        m_auto_prepare_capacity{rhs.m_auto_prepare_capacity},
+        m_auto_prepared{rhs.m_auto_prepared},
+        m_result_size_limit{rhs.m_result_size_limit},
+        m_max_spin{rhs.m_max_spin},
+        m_spin_limit{rhs.m_spin_limit}
 {
   rhs.check_movable();
   rhs.m_conn = nullptr;
+  rhs.m_cancel = nullptr;
+  rhs.m_cancel_conn = nullptr;
+}
+
+
+pqxx::connection::connection(connect_mode, char const options[])
+{
+  check_version();
+  m_conn = PQconnectStart(options);
+  if (m_conn == nullptr)
+    throw std::bad_alloc{};
+  if (PQstatus(m_conn) == CONNECTION_BAD)
+  {
+    std::string const msg{PQerrorMessage(m_conn)};
+    PQfinish(m_conn);
+    m_conn = nullptr;
+    throw broken_connection{msg};
+  }
 }
 
 
@@ -114,10 +265,7 @@ void pqxx::connection::init(char const options[])
     throw std::bad_alloc{};
   try
   {
-    if (PQstatus(m_conn) != CONNECTION_OK)
-      throw broken_connection{PQerrorMessage(m_conn)};
-
-    set_up_state();
+    complete_init();
   }
   catch (std::exception const &)
   {
@@ -127,6 +275,57 @@ void pqxx::connection::init(char const options[])
 }
 
 
+void pqxx::connection::complete_init()
+{
+  if (PQstatus(m_conn) != CONNECTION_OK)
+    throw broken_connection{PQerrorMessage(m_conn)};
+
+  set_up_state();
+  PQXX_TRACE1(connection__open, this);
+}
+
+
+std::pair<bool, bool> pqxx::connection::poll_connect()
+{
+  switch (PQconnectPoll(m_conn))
+  {
+  case PGRES_POLLING_FAILED: throw broken_connection{err_msg()};
+  case PGRES_POLLING_READING: return std::make_pair(true, false);
+  case PGRES_POLLING_WRITING: return std::make_pair(false, true);
+  case PGRES_POLLING_OK:
+    if (not is_open())
+      throw broken_connection{err_msg()};
+    PQXX_TRACE1(connection__open, this);
+    return std::make_pair(false, false);
+  default:
+    // PGRES_POLLING_ACTIVE is obsolete; libpq no longer returns it.
+    throw internal_error{
+      "Nonblocking connection poll returned unexpected status."};
+  }
+}
+
+
+pqxx::connecting::connecting(zview options) :
+        m_conn{connection::connect_nonblocking, options.c_str()}
+{}
+
+
+void pqxx::connecting::process()
+{
+  std::tie(m_reading, m_writing) = m_conn.poll_connect();
+}
+
+
+pqxx::connection pqxx::connecting::produce() &&
+{
+  if (not done())
+    throw usage_error{
+      "Tried to produce a connection that was not done connecting."};
+  m_conn.complete_init();
+  return std::move(m_conn);
+}
+
+
 void pqxx::connection::check_movable() const
 {
   if (m_trans.get() != nullptr)
@@ -137,6 +336,8 @@ void pqxx::connection::check_movable() const
   if (not m_receivers.empty())
     throw pqxx::usage_error{
       "Moving a connection with notification receivers registered."};
+  if (m_batching_listens)
+    throw pqxx::usage_error{"Moving a connection with a receiver_batch open."};
 }
 
 
@@ -163,9 +364,32 @@ pqxx::connection &pqxx::connection::operator=(connection &&rhs)
   close();
 
   m_conn = rhs.m_conn;
+  m_cancel = rhs.m_cancel;
+  m_cancel_conn = rhs.m_cancel_conn;
   m_unique_id = rhs.m_unique_id;
+  m_query_hook = std::move(rhs.m_query_hook);
+  m_tracer = std::move(rhs.m_tracer);
+  m_stats_defaults = std::move(rhs.m_stats_defaults);
+  m_slow_log = std::move(rhs.m_slow_log);
+  m_auto_prepare = std::move(rhs.m_auto_prepare);
+  m_auto_lru = std::move(rhs.m_auto_lru);
+  m_auto_prepare_runs = rhs.m_auto_prepare_runs;
+  m_auto_prepare_capacity = rhs.m_auto_prepare_capacity;
+  m_auto_prepared = rhs.m_auto_prepared;
+  m_result_size_limit = rhs.m_result_size_limit;
+  m_max_spin = rhs.m_max_spin;
+  m_spin_limit = rhs.m_spin_limit;
+  m_reconnect = rhs.m_reconnect;
+  m_session_statements = std::move(rhs.m_session_statements);
+  m_session_variables = std::move(rhs.m_session_variables);
+  m_last_query = std::move(rhs.m_last_query);
+  m_statement_names = std::move(rhs.m_statement_names);
+  m_descriptions = std::move(rhs.m_descriptions);
+  m_tables = std::move(rhs.m_tables);
 
   rhs.m_conn = nullptr;
+  rhs.m_cancel = nullptr;
+  rhs.m_cancel_conn = nullptr;
 
   return *this;
 }
@@ -175,7 +399,7 @@ pqxx::result pqxx::connection::make_result(
   internal::pq::PGresult *rhs, std::shared_ptr<std::string> const &query)
 {
   return pqxx::internal::gate::result_creation::create(
-    rhs, query, internal::enc_group(encoding_id()));
+    rhs, query, enc_group());
 }
 
 
@@ -221,12 +445,19 @@ void pqxx::connection::set_variable(
   cmd.push_back('=');
   cmd.append(value);
   exec(cmd.c_str());
+  if (m_reconnect)
+    m_session_variables.insert_or_assign(std::string{var}, std::string{value});
 }
 
 
 std::string pqxx::connection::get_variable(std::string_view var)
 {
-  std::string cmd{"SHOW "};
+  // libpq tracks the variables which the server reports.  No round trip.
+  std::string cmd{var};
+  if (auto const reported{PQparameterStatus(m_conn, cmd.c_str())}; reported)
+    return reported;
+
+  cmd = "SHOW ";
   cmd.append(var);
   return exec(cmd.c_str()).at(0).at(0).as(std::string{});
 }
@@ -251,14 +482,20 @@ void pqxx::connection::set_up_state()
     throw feature_not_supported{
       "Unsupported server version; 9.0 is the minimum."};
 
-  // The default notice processor in libpq writes to stderr.  Ours does
+  // The default notice receiver in libpq writes to stderr.  Ours does
   // nothing.
-  // If the caller registers an error handler, this gets replaced with an
-  // error handler that walks down the connection's chain of handlers.  We
-  // don't do that by default because there's a danger: libpq may call the
-  // notice processor via a result object, even after the connection has been
+  // If the caller registers an error handler, this gets replaced with a
+  // receiver that walks down the connection's chain of handlers.  We don't
+  // do that by default because there's a danger: libpq may call the notice
+  // receiver via a result object, even after the connection has been
   // destroyed and the handlers list no longer exists.
-  PQsetNoticeProcessor(m_conn, inert_notice_processor, nullptr);
+  // After a reconnect, there may already be handlers.
+  if (m_errorhandlers.empty())
+    PQsetNoticeReceiver(m_conn, inert_notice_receiver, nullptr);
+  else
+    PQsetNoticeReceiver(m_conn, pqxx_notice_receiver, this);
+
+  make_cancel();
 }
 
 
@@ -268,6 +505,188 @@ void pqxx::connection::check_result(result const &r)
   if (not pqxx::internal::gate::result_connection{r})
     throw failure(err_msg());
   pqxx::internal::gate::result_creation{r}.check_status();
+  if (m_result_size_limit > 0)
+  {
+    auto const size{r.memory_usage()};
+    if (size > m_result_size_limit)
+      throw result_too_large{
+        "Query result takes " + to_string(size) + " bytes of memory; " +
+        "the connection's limit is " + to_string(m_result_size_limit) +
+        " bytes."};
+  }
+}
+
+
+void pqxx::connection::check_result(
+  result const &r, query_stats::kind what, std::string_view query,
+  std::size_t sent, std::chrono::steady_clock::time_point start,
+  std::size_t statements, internal::params const *args)
+{
+  if (not reporting())
+  {
+    check_result(r);
+    return;
+  }
+
+  query_stats stats;
+  stats.what = what;
+  stats.query = query;
+  stats.bytes_sent = sent;
+  stats.statements = statements;
+  try
+  {
+    check_result(r);
+  }
+  catch (std::exception const &)
+  {
+    stats.failed = true;
+    stats.elapsed = stats.first_result =
+      std::chrono::steady_clock::now() - start;
+    report_query(stats, args);
+    throw;
+  }
+  stats.elapsed = stats.first_result =
+    std::chrono::steady_clock::now() - start;
+  stats.bytes_received = r.memory_usage();
+
+  if (pqxx::internal::gate::result_connection{r}.starts_copy())
+  {
+    // Report once the COPY is done.
+    stats.what = query_stats::kind::copy;
+    m_copy_timing.emplace();
+    m_copy_timing->query = query;
+    m_copy_timing->start = start;
+    m_copy_timing->stats = stats;
+    m_copy_timing->blocked_before = m_copy_blocked;
+    return;
+  }
+
+  stats.rows = rows_of(r);
+  report_query(stats, args);
+}
+
+
+void pqxx::connection::report_query(
+  query_stats const &stats, internal::params const *args) noexcept
+{
+  if (m_counting)
+    if (auto const trans{m_trans.get()}; trans != nullptr)
+      pqxx::internal::gate::transaction_connection{*trans}.count_query(stats);
+  if (m_tracer)
+    m_tracer->record(
+      m_trans_span,
+      std::chrono::system_clock::now() -
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          stats.elapsed),
+      stats);
+  if (m_slow_log and stats.elapsed >= m_slow_log->threshold())
+    log_slow_query(stats, args);
+  if (not m_query_hook)
+    return;
+  try
+  {
+    m_query_hook(stats);
+  }
+  catch (std::exception const &e)
+  {
+    try
+    {
+      process_notice("Query hook failed: " + std::string{e.what()} + "\n");
+    }
+    catch (std::exception const &)
+    {}
+  }
+}
+
+
+void pqxx::connection::log_slow_query(
+  query_stats const &stats, internal::params const *args) noexcept
+{
+  try
+  {
+    // What to EXPLAIN, if this query gets sampled.
+    std::string_view definition;
+    switch (stats.what)
+    {
+    case query_stats::kind::query: definition = stats.query; break;
+    case query_stats::kind::prepared:
+      if (auto const here{m_session_statements.find(stats.query)};
+          here != std::end(m_session_statements))
+        definition = here->second.definition;
+      break;
+    default: break;
+    }
+    m_slow_log->record(stats, args, definition, *this);
+  }
+  catch (std::exception const &e)
+  {
+    try
+    {
+      process_notice(
+        "Could not log slow query: " + std::string{e.what()} + "\n");
+    }
+    catch (std::exception const &)
+    {}
+  }
+}
+
+
+void pqxx::connection::set_slow_query_log(slow_query_config config)
+{
+  m_slow_log = std::make_shared<internal::slow_query_log>(std::move(config));
+}
+
+
+void pqxx::connection::stop_slow_query_log() noexcept
+{
+  m_slow_log.reset();
+  if (not reporting())
+    m_copy_timing.reset();
+}
+
+
+std::vector<pqxx::slow_query> pqxx::connection::slow_queries() const
+{
+  if (not m_slow_log)
+    return {};
+  return m_slow_log->entries();
+}
+
+
+void pqxx::connection::time_copy_data(std::size_t sent, std::size_t received)
+{
+  auto &timing{*m_copy_timing};
+  if (received > 0 and not timing.got_data)
+  {
+    timing.stats.first_result =
+      std::chrono::steady_clock::now() - timing.start;
+    timing.got_data = true;
+  }
+  timing.stats.bytes_sent += sent;
+  timing.stats.bytes_received += received;
+}
+
+
+void pqxx::connection::end_copy_timing(result const *final) noexcept
+{
+  if (not m_copy_timing)
+    return;
+  auto &timing{*m_copy_timing};
+  auto &stats{timing.stats};
+  stats.query = timing.query;
+  stats.elapsed = std::chrono::steady_clock::now() - timing.start;
+  stats.blocked = m_copy_blocked - timing.blocked_before;
+  stats.failed = (final == nullptr);
+  if (final != nullptr)
+    try
+    {
+      // The result of a COPY says how many rows it copied.
+      stats.rows = final->affected_rows();
+    }
+    catch (std::exception const &)
+    {}
+  report_query(stats);
+  m_copy_timing.reset();
 }
 
 
@@ -309,10 +728,18 @@ void pqxx::connection::process_notice(zview msg) noexcept
     return;
   else if (msg[msg.size() - 1] == '\n')
     process_notice_raw(msg.c_str());
+  else if (msg.size() < 512)
+  {
+    // Add newline.  Most messages are short enough to do this on the stack.
+    char buf[512];
+    std::memcpy(buf, msg.data(), msg.size());
+    buf[msg.size()] = '\n';
+    buf[msg.size() + 1] = '\0';
+    process_notice_raw(buf);
+  }
   else
     try
     {
-      // Add newline.
       std::string buf;
       buf.reserve(msg.size() + 1);
       buf.assign(msg);
@@ -327,6 +754,17 @@ void pqxx::connection::process_notice(zview msg) noexcept
 }
 
 
+void pqxx::connection::process_notice(notice const &n) noexcept
+{
+  if (n.message.empty())
+    return;
+  auto const rbegin = m_errorhandlers.crbegin(),
+             rend = m_errorhandlers.crend();
+  for (auto i{rbegin}; (i != rend) and (*i)->on_notice(n); ++i)
+    ;
+}
+
+
 void pqxx::connection::trace(FILE *out) noexcept
 {
   if (m_conn)
@@ -339,6 +777,69 @@ void pqxx::connection::trace(FILE *out) noexcept
 }
 
 
+void pqxx::connection::set_query_hook(query_hook hook)
+{
+  m_query_hook = std::move(hook);
+  if (not reporting())
+    m_copy_timing.reset();
+}
+
+
+void pqxx::connection::set_tracer(std::shared_ptr<tracer> t)
+{
+  if (m_trans.get() != nullptr)
+    throw usage_error{
+      "Setting tracer while " + m_trans.get()->description() +
+      " is still open."};
+  m_tracer = std::move(t);
+  if (not reporting())
+    m_copy_timing.reset();
+}
+
+
+void pqxx::connection::collect_transaction_stats(
+  stats_limits limits, stats_alert alert)
+{
+  m_stats_defaults.emplace(limits, std::move(alert));
+}
+
+
+void pqxx::connection::stop_transaction_stats() noexcept
+{
+  m_stats_defaults.reset();
+}
+
+
+std::shared_ptr<std::string>
+pqxx::connection::query_text(std::string_view query)
+{
+  if (m_last_query == nullptr or *m_last_query != query)
+    m_last_query = std::make_shared<std::string>(query);
+  return m_last_query;
+}
+
+
+std::shared_ptr<std::string>
+pqxx::connection::statement_text(std::string_view name)
+{
+  if (auto const here{m_statement_names.find(name)};
+      here != std::end(m_statement_names))
+    return here->second;
+  return std::make_shared<std::string>(name);
+}
+
+
+char const *
+pqxx::connection::traced(std::string const &query, std::string &buf) const
+{
+  if (std::empty(m_trace_comment))
+    return query.c_str();
+  buf.reserve(std::size(m_trace_comment) + std::size(query));
+  buf.assign(m_trace_comment).append(query);
+  return buf.c_str();
+}
+
+
 void pqxx::connection::add_receiver(pqxx::notification_receiver *n)
 {
   if (n == nullptr)
@@ -348,12 +849,17 @@ void pqxx::connection::add_receiver(pqxx::notification_receiver *n)
   auto const p{m_receivers.find(n->channel())};
   auto const new_value{receiver_list::value_type{n->channel(), n}};
 
-  if (p == m_receivers.end())
+  if (p == m_receivers.end() and m_batching_listens)
+  {
+    queue_listen(n->channel(), true);
+    m_receivers.insert(new_value);
+  }
+  else if (p == m_receivers.end())
   {
     // Not listening on this event yet, start doing so.
     auto const lq{
       std::make_shared<std::string>("LISTEN " + quote_name(n->channel()))};
-    check_result(make_result(PQexec(m_conn, lq->c_str()), lq));
+    exec(lq);
     m_receivers.insert(new_value);
   }
   else
@@ -386,7 +892,9 @@ void pqxx::connection::remove_receiver(pqxx::notification_receiver *T) noexcept
       // come in and wreak havoc.  Thanks Dragan Milenkovic.
       bool const gone{R.second == ++R.first};
       m_receivers.erase(i);
-      if (gone)
+      if (gone and m_batching_listens)
+        queue_listen(needle.first, false);
+      else if (gone)
         exec(("UNLISTEN " + quote_name(needle.first)).c_str());
     }
   }
@@ -397,6 +905,41 @@ void pqxx::connection::remove_receiver(pqxx::notification_receiver *T) noexcept
 }
 
 
+void pqxx::connection::begin_listen_batch()
+{
+  if (m_batching_listens)
+    throw usage_error{"Starting a receiver_batch while one is still open."};
+  m_batching_listens = true;
+}
+
+
+void pqxx::connection::queue_listen(std::string const &channel, bool listen)
+{
+  auto const [here, fresh]{m_pending_listens.try_emplace(channel, listen)};
+  // A LISTEN and an UNLISTEN on the same channel cancel each other out.
+  if (not fresh and here->second != listen)
+    m_pending_listens.erase(here);
+}
+
+
+void pqxx::connection::end_listen_batch()
+{
+  m_batching_listens = false;
+  if (m_pending_listens.empty())
+    return;
+  auto const pending{std::exchange(m_pending_listens, {})};
+  auto const commands{std::make_shared<std::string>()};
+  for (auto const &[channel, listen] : pending)
+  {
+    if (not std::empty(*commands))
+      commands->push_back(';');
+    commands->append(listen ? "LISTEN " : "UNLISTEN ")
+      .append(quote_name(channel));
+  }
+  exec(commands);
+}
+
+
 bool pqxx::connection::consume_input() noexcept
 {
   return PQconsumeInput(m_conn) != 0;
@@ -409,18 +952,83 @@ bool pqxx::connection::is_busy() const noexcept
 }
 
 
+void pqxx::connection::make_cancel()
+{
+  drop_cancel();
+  m_cancel = PQgetCancel(m_conn);
+  if (m_cancel == nullptr)
+  {
+    if (not is_open())
+      throw broken_connection{"No connection."};
+    throw std::bad_alloc{};
+  }
+}
+
+
+void pqxx::connection::drop_cancel() noexcept
+{
+#if defined(PQXX_HAVE_PQ_CANCEL_CONN)
+  if (m_cancel_conn != nullptr)
+    PQcancelFinish(m_cancel_conn);
+#endif // PQXX_HAVE_PQ_CANCEL_CONN
+  m_cancel_conn = nullptr;
+  if (m_cancel != nullptr)
+    PQfreeCancel(m_cancel);
+  m_cancel = nullptr;
+}
+
+
 void pqxx::connection::cancel_query()
 {
-  using pointer = std::unique_ptr<PGcancel, std::function<void(PGcancel *)>>;
+  if (m_cancel == nullptr)
+    make_cancel();
+
   constexpr int buf_size{500};
   std::array<char, buf_size> errbuf;
-  pointer cancel{PQgetCancel(m_conn), PQfreeCancel};
-  if (cancel == nullptr)
-    throw std::bad_alloc{};
+  if (PQcancel(m_cancel, errbuf.data(), buf_size) == 0)
+    throw pqxx::sql_error{errbuf.data()};
+}
+
+
+bool pqxx::connection::start_cancel()
+{
+#if defined(PQXX_HAVE_PQ_CANCEL_CONN)
+  if (m_cancel_conn == nullptr)
+  {
+    m_cancel_conn = PQcancelCreate(m_conn);
+    if (m_cancel_conn == nullptr)
+      throw std::bad_alloc{};
+  }
+  else
+  {
+    // Re-use the cancel connection from last time.
+    PQcancelReset(m_cancel_conn);
+  }
+  if (PQcancelStart(m_cancel_conn) == 0)
+    throw pqxx::sql_error{PQcancelErrorMessage(m_cancel_conn)};
+  return poll_cancel();
+#else
+  cancel_query();
+  return true;
+#endif // PQXX_HAVE_PQ_CANCEL_CONN
+}
 
-  auto const c{PQcancel(cancel.get(), errbuf.data(), buf_size)};
-  if (c == 0)
-    throw pqxx::sql_error{std::string{errbuf.data(), errbuf.size()}};
+
+bool pqxx::connection::poll_cancel()
+{
+#if defined(PQXX_HAVE_PQ_CANCEL_CONN)
+  if (m_cancel_conn == nullptr)
+    return true;
+  switch (PQcancelPoll(m_cancel_conn))
+  {
+  case PGRES_POLLING_OK: return true;
+  case PGRES_POLLING_FAILED:
+    throw pqxx::sql_error{PQcancelErrorMessage(m_cancel_conn)};
+  default: return false;
+  }
+#else
+  return true;
+#endif // PQXX_HAVE_PQ_CANCEL_CONN
 }
 
 
@@ -430,6 +1038,12 @@ void pqxx::connection::set_verbosity(error_verbosity verbosity) noexcept
 }
 
 
+void pqxx::internal::pq_freemem(void const *ptr) noexcept
+{
+  PQfreemem(const_cast<void *>(ptr));
+}
+
+
 namespace
 {
 /// Unique pointer to PGnotify.
@@ -448,7 +1062,12 @@ int pqxx::connection::get_notifs()
 {
   if (not consume_input())
     throw broken_connection{"Connection lost."};
+  return deliver_notifs();
+}
+
 
+int pqxx::connection::deliver_notifs()
+{
   // Even if somehow we receive notifications during our transaction, don't
   // deliver them.
   if (m_trans.get() != nullptr)
@@ -459,10 +1078,10 @@ int pqxx::connection::get_notifs()
   {
     notifs++;
 
-    auto const Hit{m_receivers.equal_range(std::string{N->relname})};
+    auto const Hit{m_receivers.equal_range(std::string_view{N->relname})};
     for (auto i{Hit.first}; i != Hit.second; ++i) try
       {
-        (*i->second)(N->extra, N->be_pid);
+        i->second->receive(zview{N->extra}, N->be_pid);
       }
       catch (std::exception const &e)
       {
@@ -526,17 +1145,17 @@ char const *pqxx::connection::err_msg() const noexcept
 
 void pqxx::connection::register_errorhandler(errorhandler *handler)
 {
-  // Set notice processor on demand, i.e. only when the caller actually
+  // Set notice receiver on demand, i.e. only when the caller actually
   // registers an error handler.
   // We do this just to make it less likely that users fall into the trap
-  // where a result object may hold a notice processor derived from its parent
-  // connection which has already been destroyed.  Our notice processor goes
+  // where a result object may hold a notice receiver derived from its parent
+  // connection which has already been destroyed.  Our notice receiver goes
   // through the connection's list of error handlers.  If the connection object
   // has already been destroyed though, that list no longer exists.
-  // By setting the notice processor on demand, we absolve users who never
+  // By setting the notice receiver on demand, we absolve users who never
   // register an error handler from ahving to care about this nasty subtlety.
   if (m_errorhandlers.empty())
-    PQsetNoticeProcessor(m_conn, pqxx_notice_processor, this);
+    PQsetNoticeReceiver(m_conn, pqxx_notice_receiver, this);
   m_errorhandlers.push_back(handler);
 }
 
@@ -547,7 +1166,7 @@ void pqxx::connection::unregister_errorhandler(errorhandler *handler) noexcept
   // connection.
   m_errorhandlers.remove(handler);
   if (m_errorhandlers.empty())
-    PQsetNoticeProcessor(m_conn, inert_notice_processor, nullptr);
+    PQsetNoticeReceiver(m_conn, inert_notice_receiver, nullptr);
 }
 
 
@@ -560,14 +1179,25 @@ std::vector<pqxx::errorhandler *> pqxx::connection::get_errorhandlers() const
 
 pqxx::result pqxx::connection::exec(std::string_view query)
 {
-  return exec(std::make_shared<std::string>(query));
+  return exec(query_text(query));
 }
 
 
 pqxx::result pqxx::connection::exec(std::shared_ptr<std::string> query)
 {
-  auto const res{make_result(PQexec(m_conn, query->c_str()), query)};
-  check_result(res);
+  if (have_deferred())
+    return exec_bundled(query, nullptr, false, format::text, false);
+  auto const start{query_start()};
+  std::string buf;
+  PQXX_TRACE2(exec__start, this, query->c_str());
+  auto const text{traced(*query, buf)};
+  auto const res{make_result(
+    (m_max_spin.count() == 0) ? PQexec(m_conn, text) :
+                                spin_result(PQsendQuery(m_conn, text) != 0),
+    query)};
+  PQXX_TRACE2(exec__done, this, query->c_str());
+  check_result(
+    res, query_stats::kind::query, *query, std::size(*query), start);
   get_notifs();
   return res;
 }
@@ -599,12 +1229,129 @@ std::string pqxx::connection::encrypt_password(
 
 void pqxx::connection::prepare(char const name[], char const definition[])
 {
-  // Allocate once, re-use across invocations.
+  prepare(name, definition, std::vector<oid>{});
+}
+
+
+void pqxx::connection::prepare(
+  char const name[], char const definition[], std::vector<oid> const &types)
+{
+  // Allocate once, re-use across invocations.
   static auto const q{std::make_shared<std::string>("[PREPARE]")};
 
-  auto const r{
-    make_result(PQprepare(m_conn, name, definition, 0, nullptr), q)};
+  auto const r{make_result(
+    PQprepare(
+      m_conn, name, definition,
+      check_cast<int>(std::size(types), "prepared statement types"),
+      std::empty(types) ? nullptr : std::data(types)),
+    q)};
   check_result(r);
+  std::string_view const key{name};
+  forget_description(key);
+  if (not std::empty(key))
+  {
+    if (m_statement_names.find(key) == std::end(m_statement_names))
+      m_statement_names.emplace(key, std::make_shared<std::string>(key));
+    if (m_reconnect or m_slow_log)
+      m_session_statements.insert_or_assign(
+        name, prepare::statement{name, definition, types});
+  }
+}
+
+
+void pqxx::connection::prepare_all(
+  std::vector<prepare::statement> const &statements)
+{
+  static auto const q{std::make_shared<std::string>("[PREPARE]")};
+  for (auto const &s : statements)
+    if (std::empty(s.name))
+      throw argument_error{"Statement without a name in prepare_all()."};
+
+  // Statements the server has prepared so far, from the start of the list.
+  std::size_t done{0};
+  auto const remember{[this, &statements](std::size_t count) {
+    for (std::size_t i{0}; i < count; ++i)
+    {
+      auto const &s{statements[i]};
+      forget_description(s.name);
+      if (m_statement_names.find(s.name) == std::end(m_statement_names))
+        m_statement_names.emplace(
+          s.name, std::make_shared<std::string>(s.name));
+      if (m_reconnect or m_slow_log)
+        m_session_statements.insert_or_assign(s.name, s);
+    }
+  }};
+
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  enter_pipeline_mode();
+  std::exception_ptr err;
+  auto const accept{[this, &err, &done](internal::pq::PGresult *pq_result) {
+    auto const r{make_result(pq_result, q)};
+    if (not err)
+      try
+      {
+        check_result(r);
+        ++done;
+      }
+      catch (std::exception const &)
+      {
+        err = std::current_exception();
+      }
+  }};
+
+  try
+  {
+    std::size_t received{0};
+    for (std::size_t sent{0}; sent < std::size(statements);)
+    {
+      auto const &s{statements[sent]};
+      if (
+        PQsendPrepare(
+          m_conn, s.name.c_str(), s.definition.c_str(), num_types(s),
+          types_of(s)) == 0)
+        throw failure{err_msg()};
+      ++sent;
+      // As in exec_bulk(): take in results as we go.
+      if (not consume_input())
+        throw broken_connection{err_msg()};
+      while (received < sent and not is_busy())
+        if (auto const r{get_result()}; r != nullptr)
+        {
+          ++received;
+          accept(r);
+        }
+    }
+  }
+  catch (std::exception const &)
+  {
+    if (not err)
+      err = std::current_exception();
+  }
+  pipeline_sync();
+  drain_pipeline(accept);
+  remember(done);
+  if (err)
+    std::rethrow_exception(err);
+#else
+  try
+  {
+    for (auto const &s : statements)
+    {
+      check_result(make_result(
+        PQprepare(
+          m_conn, s.name.c_str(), s.definition.c_str(), num_types(s),
+          types_of(s)),
+        q));
+      ++done;
+    }
+  }
+  catch (std::exception const &)
+  {
+    remember(done);
+    throw;
+  }
+  remember(done);
+#endif // PQXX_HAVE_PQ_PIPELINE
 }
 
 
@@ -617,24 +1364,513 @@ void pqxx::connection::prepare(char const definition[])
 void pqxx::connection::unprepare(std::string_view name)
 {
   exec("DEALLOCATE " + quote_name(name));
+  if (auto const here{m_statement_names.find(name)};
+      here != std::end(m_statement_names))
+    m_statement_names.erase(here);
+  if (auto const here{m_session_statements.find(name)};
+      here != std::end(m_session_statements))
+    m_session_statements.erase(here);
+  forget_description(name);
+}
+
+
+pqxx::prepare::description const &
+pqxx::connection::describe_prepared(std::string_view name)
+{
+  if (auto const here{m_descriptions.find(name)};
+      here != std::end(m_descriptions))
+    return here->second;
+
+  static auto const q{std::make_shared<std::string>("[DESCRIBE PREPARED]")};
+  std::string const key{name};
+  auto const pq_result{PQdescribePrepared(m_conn, key.c_str())};
+  auto const r{make_result(pq_result, q)};
+  check_result(r);
+
+  prepare::description desc;
+  auto const params{PQnparams(pq_result)};
+  desc.param_types.reserve(static_cast<std::size_t>(params));
+  for (int i{0}; i < params; ++i)
+    desc.param_types.push_back(PQparamtype(pq_result, i));
+  auto const cols{r.columns()};
+  desc.column_names.reserve(static_cast<std::size_t>(cols));
+  desc.column_types.reserve(static_cast<std::size_t>(cols));
+  desc.column_formats.reserve(static_cast<std::size_t>(cols));
+  for (row_size_type c{0}; c < cols; ++c)
+  {
+    desc.column_names.emplace_back(r.column_name(c));
+    auto const type{r.column_type(c)};
+    desc.column_types.push_back(type);
+    desc.column_formats.push_back(
+      cheap_in_binary(type) ? format::binary : format::text);
+  }
+  return m_descriptions.emplace(key, std::move(desc)).first->second;
+}
+
+
+void pqxx::connection::forget_description(std::string_view name) noexcept
+{
+  if (auto const here{m_descriptions.find(name)};
+      here != std::end(m_descriptions))
+    m_descriptions.erase(here);
+}
+
+
+pqxx::table_description const &
+pqxx::connection::describe_table(std::string_view table)
+{
+  if (auto const here{m_tables.find(table)}; here != std::end(m_tables))
+    return here->second;
+
+  table_description desc;
+  desc.name = table;
+  auto const r{exec_params_now(
+    "SELECT attname, atttypid "
+    "FROM pg_catalog.pg_attribute "
+    "WHERE attrelid = $1::pg_catalog.regclass AND attnum > 0 "
+    "AND NOT attisdropped "
+    "ORDER BY attnum",
+    internal::params{table}, format::text)};
+  desc.column_names.reserve(std::size(r));
+  desc.column_types.reserve(std::size(r));
+  for (auto const row : r)
+  {
+    auto const name{row[0].view()};
+    desc.column_names.emplace_back(name);
+    desc.column_types.push_back(row[1].as<oid>());
+    if (not std::empty(desc.column_list))
+      desc.column_list.push_back(',');
+    desc.column_list += quote_name(name);
+  }
+  return m_tables.emplace(desc.name, std::move(desc)).first->second;
+}
+
+
+void pqxx::connection::forget_table(std::string_view table) noexcept
+{
+  if (auto const here{m_tables.find(table)}; here != std::end(m_tables))
+    m_tables.erase(here);
+}
+
+
+void pqxx::connection::set_reconnect(bool enable)
+{
+  m_reconnect = enable;
+  if (not enable)
+  {
+    m_session_statements.clear();
+    m_session_variables.clear();
+  }
+}
+
+
+void pqxx::connection::reconnect()
+{
+  if (m_conn == nullptr)
+    throw usage_error{"Can't reconnect: connection is closed."};
+  if (auto const trans{m_trans.get()}; trans != nullptr)
+    throw usage_error{
+      "Can't reconnect while " + trans->description() + " is open."};
+  reset_session();
+}
+
+
+void pqxx::connection::reset_session()
+{
+  // PQreset() keeps the connection options, and the notice receiver.  But
+  // we get a new backend, with a new cancel key.
+  drop_cancel();
+  m_descriptions.clear();
+  m_tables.clear();
+  PQreset(m_conn);
+  if (not is_open())
+    throw broken_connection{err_msg()};
+  make_cancel();
+  replay_session();
+}
+
+
+void pqxx::connection::replay_session()
+{
+  // The session's state, as commands: a statement name and definition to
+  // prepare, or just a command to execute.
+  std::vector<prepare::statement> prepares;
+  std::vector<std::string> commands;
+  for (auto const &[name, statement] : m_session_statements)
+    prepares.push_back(statement);
+  for (auto const &[query, entry] : m_auto_prepare)
+    if (not entry.name.empty())
+      prepares.push_back(prepare::statement{entry.name, query});
+  for (auto const &[var, value] : m_session_variables)
+    commands.push_back("SET " + var + "=" + value);
+  for (auto i{std::begin(m_receivers)}; i != std::end(m_receivers);
+       i = m_receivers.upper_bound(i->first))
+    commands.push_back("LISTEN " + quote_name(i->first));
+  // That covers any LISTENs a batch is holding back.  Its UNLISTENs are for
+  // channels the new session isn't listening on anyway.
+  m_pending_listens.clear();
+
+  if (prepares.empty() and commands.empty())
+    return;
+  auto const q{std::make_shared<std::string>("[RECONNECT]")};
+
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  enter_pipeline_mode();
+  std::exception_ptr err;
+  auto const accept{[this, &q, &err](internal::pq::PGresult *pq_result) {
+    auto const r{make_result(pq_result, q)};
+    if (not err)
+      try
+      {
+        check_result(r);
+      }
+      catch (std::exception const &)
+      {
+        err = std::current_exception();
+      }
+  }};
+
+  try
+  {
+    std::size_t sent{0}, received{0};
+    auto const sent_one{[&] {
+      ++sent;
+      // As in exec_bulk(): take in results as we go.
+      if (not consume_input())
+        throw broken_connection{err_msg()};
+      while (received < sent and not is_busy())
+        if (auto const r{get_result()}; r != nullptr)
+        {
+          ++received;
+          accept(r);
+        }
+    }};
+    for (auto const &s : prepares)
+    {
+      if (
+        PQsendPrepare(
+          m_conn, s.name.c_str(), s.definition.c_str(), num_types(s),
+          types_of(s)) == 0)
+        throw failure{err_msg()};
+      sent_one();
+    }
+    for (auto const &command : commands)
+    {
+      if (
+        PQsendQueryParams(
+          m_conn, command.c_str(), 0, nullptr, nullptr, nullptr, nullptr,
+          0) == 0)
+        throw failure{err_msg()};
+      sent_one();
+    }
+  }
+  catch (std::exception const &)
+  {
+    if (not err)
+      err = std::current_exception();
+  }
+  pipeline_sync();
+  drain_pipeline(accept);
+  if (err)
+    std::rethrow_exception(err);
+#else
+  // Without pipelining, the commands at least fit in one round trip.
+  for (auto const &s : prepares)
+    check_result(make_result(
+      PQprepare(
+        m_conn, s.name.c_str(), s.definition.c_str(), num_types(s),
+        types_of(s)),
+      q));
+  if (not commands.empty())
+    exec(separated_list(";", std::begin(commands), std::end(commands)));
+#endif // PQXX_HAVE_PQ_PIPELINE
+}
+
+
+void pqxx::connection::set_auto_prepare(std::size_t runs, std::size_t capacity)
+{
+  if (runs > 0 and capacity == 0)
+    throw argument_error{"Automatic preparation needs a nonzero capacity."};
+
+  m_auto_prepare_runs = runs;
+  m_auto_prepare_capacity = (runs == 0) ? 0 : capacity;
+  trim_auto_prepared();
+}
+
+
+void pqxx::connection::forget_auto_prepared() noexcept
+{
+  m_auto_prepare.clear();
+  m_auto_lru.clear();
+  m_auto_prepared = 0;
+}
+
+
+std::string const &pqxx::connection::auto_prepare(std::string_view query)
+{
+  auto here{m_auto_prepare.find(query)};
+  if (here == std::end(m_auto_prepare))
+  {
+    here = m_auto_prepare.emplace(query, auto_prepare_entry{}).first;
+    m_auto_lru.push_front(here->first);
+    here->second.lru = std::begin(m_auto_lru);
+  }
+  else
+  {
+    m_auto_lru.splice(
+      std::begin(m_auto_lru), m_auto_lru, here->second.lru);
+  }
+
+  auto &entry{here->second};
+  ++entry.runs;
+  if (std::empty(entry.name) and entry.runs >= m_auto_prepare_runs)
+  {
+    std::string name{adorn_name("pqxx_auto")};
+    prepare(name, here->first);
+    entry.name = std::move(name);
+    ++m_auto_prepared;
+  }
+  return entry.name;
+}
+
+
+void pqxx::connection::trim_auto_prepared()
+{
+  while (std::size(m_auto_prepare) > m_auto_prepare_capacity)
+  {
+    auto const victim{m_auto_prepare.find(m_auto_lru.back())};
+    if (not std::empty(victim->second.name))
+    {
+      unprepare(victim->second.name);
+      --m_auto_prepared;
+    }
+    m_auto_lru.pop_back();
+    m_auto_prepare.erase(victim);
+  }
 }
 
 
 pqxx::result pqxx::connection::exec_prepared(
-  std::string_view statement, internal::params const &args)
+  std::string_view statement, internal::params const &args,
+  format result_format)
+{
+  return exec_prepared(statement_text(statement), args, result_format);
+}
+
+
+pqxx::result pqxx::connection::exec_prepared(
+  std::shared_ptr<std::string> const &q, internal::params const &args,
+  format result_format)
 {
+  if (have_deferred())
+    return exec_bundled(q, &args, true, result_format, false);
+  auto const start{query_start()};
   auto const pointers{args.get_pointers()};
-  auto const q{std::make_shared<std::string>(statement)};
-  auto const pq_result = PQexecPrepared(
-    m_conn, q->c_str(), check_cast<int>(args.nonnulls.size(), "exec_prepared"),
-    pointers.data(), args.lengths.data(), args.binaries.data(), 0);
+  auto const nparams{check_cast<int>(args.nonnulls.size(), "exec_prepared")};
+  PQXX_TRACE2(exec__start, this, q->c_str());
+  auto const pq_result{
+    (m_max_spin.count() == 0) ?
+      PQexecPrepared(
+        m_conn, q->c_str(), nparams, pointers.data(), args.lengths.data(),
+        args.binaries.data(), static_cast<int>(result_format)) :
+      spin_result(
+        PQsendQueryPrepared(
+          m_conn, q->c_str(), nparams, pointers.data(), args.lengths.data(),
+          args.binaries.data(), static_cast<int>(result_format)) != 0)};
   auto const r{make_result(pq_result, q)};
-  check_result(r);
+  PQXX_TRACE2(exec__done, this, q->c_str());
+  check_result(
+    r, query_stats::kind::prepared, *q,
+    reporting() ? query_size(*q, &args) : 0, start, 1, &args);
   get_notifs();
   return r;
 }
 
 
+pqxx::result pqxx::connection::exec_autocommit(
+  std::string_view statement, internal::params const &args)
+{
+  if (auto const trans{m_trans.get()}; trans != nullptr)
+    throw usage_error{
+      "Attempt to execute autocommit statement while " +
+      trans->description() + " is open."};
+
+  // Without a transaction, there are no deferred commands to bundle in.
+  auto const q{statement_text(statement)};
+  auto const start{query_start()};
+  auto const pointers{args.get_pointers()};
+  auto const nparams{
+    check_cast<int>(args.nonnulls.size(), "exec_prepared_autocommit")};
+  PQXX_TRACE2(exec__start, this, q->c_str());
+  auto const pq_result{
+    (m_max_spin.count() == 0) ?
+      PQexecPrepared(
+        m_conn, q->c_str(), nparams, pointers.data(), args.lengths.data(),
+        args.binaries.data(), static_cast<int>(format::text)) :
+      spin_result(
+        PQsendQueryPrepared(
+          m_conn, q->c_str(), nparams, pointers.data(), args.lengths.data(),
+          args.binaries.data(), static_cast<int>(format::text)) != 0)};
+  auto const r{make_result(pq_result, q)};
+  PQXX_TRACE2(exec__done, this, q->c_str());
+  check_result(
+    r, query_stats::kind::prepared, *q,
+    reporting() ? query_size(*q, &args) : 0, start, 1, &args);
+  // PQexecPrepared has just read everything up to the end of the result, so
+  // there's no point in asking the socket for more input.
+  deliver_notifs();
+  return r;
+}
+
+
+pqxx::result pqxx::connection::exec_prepared_mixed(
+  std::string_view statement, internal::params const &args)
+{
+  // The protocol lets us ask for a format per column, but libpq doesn't.  So
+  // we ask for binary, if that's cheaper for any of the columns.  Columns
+  // whose binary form is just their text then pass for text.  If there's any
+  // other column for which text is cheaper, we stick to text.
+  auto const &desc{describe_prepared(statement)};
+  auto const cols{std::size(desc.column_types)};
+  std::vector<bool> as_text(cols);
+  bool binary{false};
+  for (std::size_t c{0}; c < cols; ++c)
+  {
+    if (desc.column_formats[c] == format::binary)
+      binary = true;
+    else if (same_in_binary(desc.column_types[c]))
+      as_text[c] = true;
+    else
+      return exec_prepared(statement, args, format::text);
+  }
+  if (not binary)
+    return exec_prepared(statement, args, format::text);
+
+  auto const r{exec_prepared(statement, args, format::binary)};
+  pqxx::internal::gate::result_creation{r}.read_as_text(std::move(as_text));
+  return r;
+}
+
+
+std::vector<pqxx::result_size_type> pqxx::connection::exec_prepared_bulk(
+  zview statement, std::function<bool(internal::params &)> const &next)
+{
+  std::vector<result_size_type> counts;
+  exec_bulk(
+    statement_text(statement), true, next,
+    [&counts](result const &r) { counts.push_back(r.affected_rows()); });
+  return counts;
+}
+
+
+std::vector<pqxx::result_size_type> pqxx::connection::exec_params_bulk(
+  std::shared_ptr<std::string> const &query,
+  std::function<bool(internal::params &)> const &next)
+{
+  std::vector<result_size_type> counts;
+  exec_bulk(query, false, next, [&counts](result const &r) {
+    counts.push_back(r.affected_rows());
+  });
+  return counts;
+}
+
+
+void pqxx::connection::exec_bulk(
+  std::shared_ptr<std::string> const &q, bool prepared,
+  std::function<bool(internal::params &)> const &next,
+  std::function<void(result const &)> const &sink, format result_format)
+{
+  flush_deferred();
+  internal::params args;
+
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  enter_pipeline_mode();
+
+  // The first error we run into.  Once that happens, the server skips the
+  // remaining statements, but we must still read everything up to the sync.
+  std::exception_ptr err;
+
+  std::size_t sent{0}, received{0};
+
+  // Statistics for the query hook, if we have one.
+  query_stats stats;
+  stats.what = query_stats::kind::batch;
+  stats.query = *q;
+  auto const start{query_start()};
+
+  auto const accept{[&](internal::pq::PGresult *pq_result) {
+    auto const r{make_result(pq_result, q)};
+    if (reporting() and received == 0)
+      stats.first_result = std::chrono::steady_clock::now() - start;
+    ++received;
+    if (not err)
+      try
+      {
+        check_result(r);
+        if (reporting())
+        {
+          stats.rows += rows_of(r);
+          stats.bytes_received += r.memory_usage();
+        }
+        sink(r);
+      }
+      catch (std::exception const &)
+      {
+        err = std::current_exception();
+      }
+  }};
+
+  try
+  {
+    while (not err and next(args))
+    {
+      if (prepared)
+        start_exec_prepared(q->c_str(), args, result_format);
+      else
+        start_exec_params(q->c_str(), args, result_format);
+      ++sent;
+      if (reporting())
+        stats.bytes_sent += query_size(*q, &args);
+
+      // Take in whatever results have arrived, so that the server never
+      // blocks on a full output buffer while we keep sending.
+      if (not consume_input())
+        throw broken_connection{err_msg()};
+      while (received < sent and not is_busy())
+        if (auto const r{get_result()}; r != nullptr)
+          accept(r);
+    }
+  }
+  catch (std::exception const &)
+  {
+    if (not err)
+      err = std::current_exception();
+  }
+  pipeline_sync();
+  drain_pipeline(accept);
+  get_notifs();
+
+  if (reporting() and sent > 0)
+  {
+    stats.elapsed = std::chrono::steady_clock::now() - start;
+    stats.statements = sent;
+    stats.failed = bool(err);
+    report_query(stats);
+  }
+
+  if (err)
+    std::rethrow_exception(err);
+#else
+  // Without pipeline mode, each execution is a round trip of its own.  We
+  // can still save on allocating parameter buffers.
+  while (next(args))
+    sink(
+      prepared ? exec_prepared(*q, args, result_format) :
+                 exec_params_now(*q, args, result_format));
+#endif // PQXX_HAVE_PQ_PIPELINE
+}
+
+
 void pqxx::connection::close()
 {
   try
@@ -648,6 +1884,7 @@ void pqxx::connection::close()
     {
       process_notice("Closing connection with outstanding receivers.");
       m_receivers.clear();
+      m_pending_listens.clear();
     }
 
     std::list<errorhandler *> old_handlers;
@@ -656,6 +1893,8 @@ void pqxx::connection::close()
     for (auto i{rbegin}; i != rend; ++i)
       pqxx::internal::gate::errorhandler_connection{**i}.unregister();
 
+    drop_cancel();
+    PQXX_TRACE1(connection__close, this);
     PQfinish(m_conn);
     m_conn = nullptr;
   }
@@ -673,101 +1912,840 @@ int pqxx::connection::status() const noexcept
 }
 
 
-void pqxx::connection::register_transaction(transaction_base *t)
+void pqxx::connection::register_transaction(transaction_base *t)
+{
+  if (m_reconnect and m_trans.get() == nullptr and not is_open() and
+      m_conn != nullptr)
+    reconnect();
+  m_trans.register_guest(t);
+  m_counting = false;
+  if (m_stats_defaults)
+    try
+    {
+      t->collect_stats(m_stats_defaults->first, m_stats_defaults->second);
+    }
+    catch (std::exception const &)
+    {
+      m_trans.unregister_guest(t);
+      throw;
+    }
+  if (m_tracer)
+  {
+    try
+    {
+      m_trans_span = m_tracer->start_transaction(t->classname(), t->name());
+      auto const context{m_tracer->context(m_trans_span)};
+      if (not std::empty(context) and context.find("*/") == std::string::npos)
+        m_trace_comment = "/*" + context + "*/ ";
+    }
+    catch (std::exception const &)
+    {
+      end_trace_span(false);
+      m_trans.unregister_guest(t);
+      throw;
+    }
+  }
+}
+
+
+void pqxx::connection::end_trace_span(bool committed) noexcept
+{
+  m_trace_comment.clear();
+  if (m_tracer and m_trans_span != nullptr)
+    m_tracer->end_transaction(std::exchange(m_trans_span, nullptr), committed);
+  m_trans_span = nullptr;
+}
+
+
+void pqxx::connection::unregister_transaction(transaction_base *t) noexcept
+{
+  m_counting = false;
+  m_deferred_begin = nullptr;
+  m_deferred_savepoints.clear();
+  end_trace_span(false);
+  try
+  {
+    m_trans.unregister_guest(t);
+  }
+  catch (std::exception const &e)
+  {
+    process_notice(e.what());
+  }
+}
+
+
+bool pqxx::connection::defer_close(std::string command)
+{
+  if (PQtransactionStatus(m_conn) != PQTRANS_INTRANS)
+    return false;
+  for (auto const &deferred : m_deferred_savepoints)
+    if (deferred.rfind("CLOSE ", 0) != 0)
+      return false;
+  m_deferred_savepoints.push_back(std::move(command));
+  return true;
+}
+
+
+void pqxx::connection::flush_deferred()
+{
+  if (not have_deferred())
+    return;
+  std::string text;
+  if (m_deferred_begin != nullptr)
+    text = std::exchange(m_deferred_begin, nullptr);
+  for (auto const &command : m_deferred_savepoints)
+  {
+    if (not std::empty(text))
+      text.append(";\n");
+    text.append(command);
+  }
+  m_deferred_savepoints.clear();
+  exec(std::make_shared<std::string>(std::move(text)));
+}
+
+
+pqxx::result pqxx::connection::exec_bundled(
+  std::shared_ptr<std::string> const &query, internal::params const *args,
+  bool prepared, format result_format, bool commit)
+{
+  char const *const begin{std::exchange(m_deferred_begin, nullptr)};
+  auto const savepoints{std::exchange(m_deferred_savepoints, {})};
+  auto const what{
+    prepared ? query_stats::kind::prepared : query_stats::kind::query};
+  auto const start{query_start()};
+  std::size_t bytes_sent{0};
+  if (reporting())
+  {
+    bytes_sent = query_size(*query, args) +
+                 ((begin == nullptr) ? 0u : std::strlen(begin));
+    for (auto const &command : savepoints) bytes_sent += std::size(command);
+  }
+  PQXX_TRACE2(exec__start, this, query->c_str());
+  result res;
+  try
+  {
+    if (args == nullptr)
+    {
+      // A plain query: send it all as a single multi-statement string.  The
+      // newlines end any comment at the end of the query.
+      std::string text{m_trace_comment};
+      if (begin != nullptr)
+        text.append(begin).append(";\n");
+      for (auto const &command : savepoints)
+        text.append(command).append(";\n");
+      text.append(*query);
+      if (commit)
+        text.append("\n;COMMIT");
+      if (PQsendQuery(m_conn, text.c_str()) == 0)
+        throw failure{err_msg()};
+
+      // After an error, the server skips the remaining statements.
+      std::vector<result> results;
+      for (auto r{get_result()}; r != nullptr; r = get_result())
+      {
+        auto const status{PQresultStatus(r)};
+        results.push_back(make_result(r, query));
+        if (
+          status == PGRES_COPY_IN or status == PGRES_COPY_OUT or
+          status == PGRES_COPY_BOTH)
+          break;
+      }
+      if (std::empty(results))
+        throw failure{err_msg()};
+      for (auto const &r : results) check_result(r);
+      // The query's result is the last one, or the one before the COMMIT.
+      std::size_t const skip{(commit and std::size(results) > 1) ? 2u : 1u};
+      res = results[std::size(results) - skip];
+    }
+    else
+    {
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+      // Parameters mean the extended query protocol, which takes only one
+      // statement at a time.  Pipeline them.
+      enter_pipeline_mode();
+      std::exception_ptr err;
+      try
+      {
+        if (
+          begin != nullptr and
+          PQsendQueryParams(
+            m_conn, begin, 0, nullptr, nullptr, nullptr, nullptr, 0) == 0)
+          throw failure{err_msg()};
+        for (auto const &command : savepoints)
+          if (
+            PQsendQueryParams(
+              m_conn, command.c_str(), 0, nullptr, nullptr, nullptr, nullptr,
+              0) == 0)
+            throw failure{err_msg()};
+        auto const pointers{args->get_pointers()};
+        auto const nonnulls{
+          check_cast<int>(args->nonnulls.size(), "statement parameters")};
+        auto const sent{
+          prepared ?
+            PQsendQueryPrepared(
+              m_conn, query->c_str(), nonnulls, pointers.data(),
+              args->lengths.data(), args->binaries.data(),
+              static_cast<int>(result_format)) :
+            PQsendQueryParams(
+              m_conn, query->c_str(), nonnulls, args->types.data(),
+              pointers.data(), args->lengths.data(), args->binaries.data(),
+              static_cast<int>(result_format))};
+        if (sent == 0)
+          throw failure{err_msg()};
+        if (
+          commit and
+          PQsendQueryParams(
+            m_conn, "COMMIT", 0, nullptr, nullptr, nullptr, nullptr, 0) == 0)
+          throw failure{err_msg()};
+      }
+      catch (std::exception const &)
+      {
+        err = std::current_exception();
+      }
+      pipeline_sync();
+
+      // Results come in the order in which we sent the statements, each
+      // followed by a null.  Two nulls in a row means trouble.
+      int const own_index{
+        ((begin == nullptr) ? 0 : 1) +
+        check_cast<int>(std::size(savepoints), "deferred savepoints")};
+      int index{0};
+      bool last_was_null{false};
+      for (;;)
+      {
+        auto const r{get_result()};
+        if (r == nullptr)
+        {
+          if (last_was_null)
+            throw broken_connection{
+              "Lost track of pipeline: expected more results."};
+          last_was_null = true;
+        }
+        else if (PQresultStatus(r) == PGRES_PIPELINE_SYNC)
+        {
+          internal::clear_result(r);
+          break;
+        }
+        else
+        {
+          last_was_null = false;
+          auto const here{make_result(r, query)};
+          if (index++ == own_index)
+            res = here;
+          if (not err)
+            try
+            {
+              check_result(here);
+            }
+            catch (std::exception const &)
+            {
+              err = std::current_exception();
+            }
+        }
+      }
+      exit_pipeline_mode();
+      if (err)
+        std::rethrow_exception(err);
+#else
+      // Without pipeline mode, there's nothing to bundle.
+      if (begin != nullptr)
+        exec(std::make_shared<std::string>(begin));
+      for (auto const &command : savepoints)
+        exec(std::make_shared<std::string>(command));
+      res = prepared ? exec_prepared(*query, *args, result_format) :
+                       exec_params_now(*query, *args, result_format);
+      if (commit)
+        exec(std::make_shared<std::string>("COMMIT"));
+#endif // PQXX_HAVE_PQ_PIPELINE
+    }
+  }
+  catch (std::exception const &)
+  {
+    PQXX_TRACE2(exec__done, this, query->c_str());
+    if (reporting())
+    {
+      query_stats stats;
+      stats.what = what;
+      stats.query = *query;
+      stats.elapsed = stats.first_result =
+        std::chrono::steady_clock::now() - start;
+      stats.bytes_sent = bytes_sent;
+      stats.failed = true;
+      report_query(stats, args);
+    }
+
+    // If the transaction failed before it got to the COMMIT, it's still open
+    // on the server.  End it, so that server and client agree on its state.
+    if (commit)
+      switch (PQtransactionStatus(m_conn))
+      {
+      case PQTRANS_INTRANS:
+      case PQTRANS_INERROR:
+        internal::clear_result(PQexec(m_conn, "ROLLBACK"));
+        break;
+      default: break;
+      }
+    throw;
+  }
+  PQXX_TRACE2(exec__done, this, query->c_str());
+  if (reporting())
+    check_result(
+      res, what, *query, bytes_sent, start,
+      1u + ((begin == nullptr) ? 0u : 1u) + std::size(savepoints) +
+        (commit ? 1u : 0u),
+      args);
+  get_notifs();
+  return res;
+}
+
+
+std::vector<pqxx::result> pqxx::connection::exec_all(std::string_view script)
+{
+  auto const query{query_text(script)};
+  char const *const begin{std::exchange(m_deferred_begin, nullptr)};
+  auto const savepoints{std::exchange(m_deferred_savepoints, {})};
+  auto const start{query_start()};
+
+  // The newlines end any comment at the end of a deferred command.
+  std::string text{m_trace_comment};
+  if (begin != nullptr)
+    text.append(begin).append(";\n");
+  for (auto const &command : savepoints) text.append(command).append(";\n");
+  text.append(*query);
+  std::size_t const skip{
+    ((begin == nullptr) ? 0u : 1u) + std::size(savepoints)};
+
+  PQXX_TRACE2(exec__start, this, query->c_str());
+  if (PQsendQuery(m_conn, text.c_str()) == 0)
+    throw failure{err_msg()};
+
+  // After an error, the server skips the remaining statements.
+  std::vector<result> results;
+  for (auto r{get_result()}; r != nullptr; r = get_result())
+  {
+    auto const status{PQresultStatus(r)};
+    results.push_back(make_result(r, query));
+    if (
+      status == PGRES_COPY_IN or status == PGRES_COPY_OUT or
+      status == PGRES_COPY_BOTH)
+      break;
+  }
+  PQXX_TRACE2(exec__done, this, query->c_str());
+  if (std::size(results) <= skip)
+    throw failure{err_msg()};
+
+  // Check the last result separately, so it can report the whole script to
+  // the query hook.
+  auto const statements{std::size(results)};
+  try
+  {
+    for (std::size_t i{0}; i + 1 < statements; ++i) check_result(results[i]);
+  }
+  catch (std::exception const &)
+  {
+    if (reporting())
+    {
+      query_stats stats;
+      stats.query = *query;
+      stats.elapsed = stats.first_result =
+        std::chrono::steady_clock::now() - start;
+      stats.bytes_sent = std::size(text);
+      stats.statements = statements;
+      stats.failed = true;
+      report_query(stats);
+    }
+    throw;
+  }
+  check_result(
+    results.back(), query_stats::kind::query, *query, std::size(text), start,
+    statements);
+  get_notifs();
+
+  results.erase(
+    std::begin(results),
+    std::begin(results) + static_cast<std::ptrdiff_t>(skip));
+  return results;
+}
+
+
+bool pqxx::connection::read_copy_line(std::string &line)
+{
+  auto const [buf, size]{read_copy_line()};
+  if (buf)
+    line.assign(buf.get(), size);
+  else
+    line.erase();
+  return bool(buf);
+}
+
+
+std::pair<pqxx::internal::pq_buffer, std::size_t>
+pqxx::connection::read_copy_line()
+{
+  char *buf{nullptr};
+  auto line_len{PQgetCopyData(m_conn, &buf, true)};
+  if (line_len == 0)
+  {
+    // There's no complete line in libpq's buffer.  Wait for one, and count
+    // the time.  If there is, as there usually is, that costs no clock reads.
+    auto const start{std::chrono::steady_clock::now()};
+    line_len = PQgetCopyData(m_conn, &buf, false);
+    m_copy_blocked += std::chrono::steady_clock::now() - start;
+  }
+  switch (line_len)
+  {
+  case -2:
+    throw failure{"Reading of table data failed: " + std::string{err_msg()}};
+
+  case -1:
+    end_copy_read();
+    return {internal::pq_buffer{nullptr, internal::pq_freemem}, 0u};
+
+  case 0: throw internal_error{"table read inexplicably went asynchronous"};
+
+  default:
+    PQXX_TRACE2(copy__read, this, static_cast<std::size_t>(line_len));
+    if (m_copy_timing)
+      time_copy_data(0, static_cast<std::size_t>(line_len));
+    return {
+      internal::pq_buffer{buf, internal::pq_freemem},
+      static_cast<std::size_t>(line_len)};
+  }
+}
+
+
+std::pair<pqxx::internal::pq_buffer, std::size_t>
+pqxx::connection::try_read_copy_line(bool &done)
+{
+  done = false;
+  char *buf{nullptr};
+  auto line_len{PQgetCopyData(m_conn, &buf, true)};
+  if (line_len == 0)
+  {
+    // Nothing buffered yet.  See if any more data has arrived.
+    if (not consume_input())
+      throw failure{"Reading of table data failed: " + std::string{err_msg()}};
+    line_len = PQgetCopyData(m_conn, &buf, true);
+  }
+
+  switch (line_len)
+  {
+  case -2:
+    throw failure{"Reading of table data failed: " + std::string{err_msg()}};
+  case -1: done = true; [[fallthrough]];
+  case 0: return {internal::pq_buffer{nullptr, internal::pq_freemem}, 0u};
+  default:
+    PQXX_TRACE2(copy__read, this, static_cast<std::size_t>(line_len));
+    if (m_copy_timing)
+      time_copy_data(0, static_cast<std::size_t>(line_len));
+    return {
+      internal::pq_buffer{buf, internal::pq_freemem},
+      static_cast<std::size_t>(line_len)};
+  }
+}
+
+
+void pqxx::connection::end_copy_read()
+{
+  // Allocate once, re-use across invocations.
+  static auto const q{std::make_shared<std::string>("[END COPY]")};
+  try
+  {
+    for (auto R{make_result(PQgetResult(m_conn), q)};
+         pqxx::internal::gate::result_connection(R);
+         R = make_result(PQgetResult(m_conn), q))
+    {
+      check_result(R);
+      end_copy_timing(&R);
+    }
+  }
+  catch (std::exception const &)
+  {
+    end_copy_timing(nullptr);
+    throw;
+  }
+}
+
+
+bool pqxx::connection::try_end_copy_read()
+{
+  static auto const q{std::make_shared<std::string>("[END COPY]")};
+  if (not consume_input())
+    throw failure{"Reading of table data failed: " + std::string{err_msg()}};
+  while (not is_busy())
+  {
+    auto const R{make_result(PQgetResult(m_conn), q)};
+    if (not pqxx::internal::gate::result_connection(R))
+      return true;
+    try
+    {
+      check_result(R);
+    }
+    catch (std::exception const &)
+    {
+      end_copy_timing(nullptr);
+      throw;
+    }
+    end_copy_timing(&R);
+  }
+  return false;
+}
+
+
+void pqxx::connection::write_copy_line(std::string_view line)
+{
+  static std::string const err_prefix{"Error writing to table: "};
+  auto const size{check_cast<int>(line.size(), "write_copy_line()")};
+  auto const start{std::chrono::steady_clock::now()};
+  if (PQputCopyData(m_conn, line.data(), size) <= 0)
+    throw failure{err_prefix + err_msg()};
+  if (PQputCopyData(m_conn, "\n", 1) <= 0)
+    throw failure{err_prefix + err_msg()};
+  m_copy_blocked += std::chrono::steady_clock::now() - start;
+  PQXX_TRACE2(copy__write, this, std::size(line) + 1);
+  if (m_copy_timing)
+    time_copy_data(std::size(line) + 1, 0);
+}
+
+
+void pqxx::connection::write_copy_data(std::string_view data)
+{
+  auto const size{check_cast<int>(data.size(), "write_copy_data()")};
+  // Streams call this for large chunks of data, so timing it is cheap.
+  auto const start{std::chrono::steady_clock::now()};
+  if (PQputCopyData(m_conn, data.data(), size) <= 0)
+    throw failure{"Error writing to table: " + std::string{err_msg()}};
+  m_copy_blocked += std::chrono::steady_clock::now() - start;
+  PQXX_TRACE2(copy__write, this, std::size(data));
+  if (m_copy_timing)
+    time_copy_data(std::size(data), 0);
+}
+
+
+void pqxx::connection::send_copy_message(std::string_view message)
+{
+  auto const size{check_cast<int>(message.size(), "send_copy_message()")};
+  if (PQputCopyData(m_conn, message.data(), size) <= 0 or PQflush(m_conn) != 0)
+    throw failure{"Error sending COPY message: " + std::string{err_msg()}};
+}
+
+
+void pqxx::connection::end_copy_both(bool server_done)
+{
+  if (PQputCopyEnd(m_conn, nullptr) != 1 or PQflush(m_conn) != 0)
+    throw failure{"Could not end COPY: " + std::string{err_msg()}};
+  // The server may still be sending data.  We no longer want it.
+  while (not server_done)
+  {
+    char *buf{nullptr};
+    auto const len{PQgetCopyData(m_conn, &buf, false)};
+    if (len == -2)
+      throw failure{"Could not end COPY: " + std::string{err_msg()}};
+    server_done = (len == -1);
+    internal::pq_freemem(buf);
+  }
+  end_copy_read();
+}
+
+
+void pqxx::connection::end_copy_write()
+{
+  // Until the server has processed all the data, we're just waiting.
+  auto const start{std::chrono::steady_clock::now()};
+  int res{PQputCopyEnd(m_conn, nullptr)};
+  switch (res)
+  {
+  case -1: throw failure{"Write to table failed: " + std::string{err_msg()}};
+  case 0: throw internal_error{"table write is inexplicably asynchronous"};
+  case 1:
+    // Normal termination.  Retrieve result object.
+    break;
+
+  default:
+    throw internal_error{"unexpected result " + to_string(res) +
+                         " from PQputCopyEnd()"};
+  }
+
+  static auto const q{std::make_shared<std::string>("[END COPY]")};
+  auto const r{make_result(PQgetResult(m_conn), q)};
+  m_copy_blocked += std::chrono::steady_clock::now() - start;
+  try
+  {
+    check_result(r);
+  }
+  catch (std::exception const &)
+  {
+    end_copy_timing(nullptr);
+    throw;
+  }
+  end_copy_timing(&r);
+}
+
+
+void pqxx::connection::set_nonblocking(bool enable)
+{
+  if (not enable)
+    drain_output();
+  if (PQsetnonblocking(m_conn, enable ? 1 : 0) != 0)
+    throw failure{
+      "Could not switch to " + std::string{enable ? "non-" : ""} +
+      "blocking mode: " + std::string{err_msg()}};
+}
+
+
+bool pqxx::connection::flush_output()
+{
+  auto const res{PQflush(m_conn)};
+  if (res < 0)
+    throw failure{"Could not send data: " + std::string{err_msg()}};
+  return res == 0;
+}
+
+
+std::chrono::steady_clock::duration pqxx::connection::drain_output()
+{
+  // Only start the clock if we actually have to wait.
+  if (flush_output())
+    return {};
+  auto const start{std::chrono::steady_clock::now()};
+  do internal::wait_write(m_conn);
+  while (not flush_output());
+  return std::chrono::steady_clock::now() - start;
+}
+
+
+void pqxx::connection::start_exec(char const query[])
+{
+  flush_deferred();
+  if (PQsendQuery(m_conn, query) == 0)
+    throw failure{err_msg()};
+}
+
+
+void pqxx::connection::start_exec_params(
+  char const query[], internal::params const &args, format result_format)
+{
+  flush_deferred();
+  auto const pointers{args.get_pointers()};
+  auto const nonnulls{
+    check_cast<int>(args.nonnulls.size(), "start_exec_params() parameters")};
+  if (
+    PQsendQueryParams(
+      m_conn, query, nonnulls, args.types.data(), pointers.data(),
+      args.lengths.data(), args.binaries.data(),
+      static_cast<int>(result_format)) == 0)
+    throw failure{err_msg()};
+}
+
+
+void pqxx::connection::start_exec_prepared(
+  char const statement[], internal::params const &args, format result_format)
+{
+  flush_deferred();
+  auto const pointers{args.get_pointers()};
+  auto const nonnulls{
+    check_cast<int>(args.nonnulls.size(), "start_exec_prepared() parameters")};
+  if (
+    PQsendQueryPrepared(
+      m_conn, statement, nonnulls, pointers.data(), args.lengths.data(),
+      args.binaries.data(), static_cast<int>(result_format)) == 0)
+    throw failure{err_msg()};
+}
+
+
+void pqxx::connection::set_single_row_mode()
+{
+  if (PQsetSingleRowMode(m_conn) != 1)
+    throw failure{"Could not switch to single-row mode."};
+}
+
+
+void pqxx::connection::set_chunked_rows_mode(int rows)
 {
-  m_trans.register_guest(t);
+  if (rows < 1)
+    throw range_error{
+      "Chunked rows mode needs at least 1 row per chunk, not " +
+      to_string(rows) + "."};
+#if defined(PQXX_HAVE_PQ_CHUNKED_ROWS)
+  if (PQsetChunkedRowsMode(m_conn, rows) != 1)
+    throw failure{"Could not switch to chunked rows mode."};
+#else
+  // This libpq can't do chunks.  Single rows are the next best thing.
+  set_single_row_mode();
+#endif // PQXX_HAVE_PQ_CHUNKED_ROWS
 }
 
 
-void pqxx::connection::unregister_transaction(transaction_base *t) noexcept
+void pqxx::connection::drain_pipeline(
+  std::function<void(internal::pq::PGresult *)> const &accept)
 {
-  try
-  {
-    m_trans.unregister_guest(t);
-  }
-  catch (std::exception const &e)
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  // Each statement's result ends in a null.  But two nulls in a row means
+  // we're not getting anything more from this connection.
+  bool last_was_null{false};
+  for (;;)
   {
-    process_notice(e.what());
+    auto const r{get_result()};
+    if (r == nullptr)
+    {
+      if (last_was_null)
+        throw broken_connection{
+          "Lost track of pipeline: expected more results."};
+      last_was_null = true;
+    }
+    else if (PQresultStatus(r) == PGRES_PIPELINE_SYNC)
+    {
+      internal::clear_result(r);
+      break;
+    }
+    else
+    {
+      last_was_null = false;
+      accept(r);
+    }
   }
+  exit_pipeline_mode();
+#else
+  ignore_unused(accept);
+  throw feature_not_supported{
+    "Pipeline mode is not available: libpqxx was built against a libpq "
+    "older than 14."};
+#endif // PQXX_HAVE_PQ_PIPELINE
 }
 
 
-bool pqxx::connection::read_copy_line(std::string &line)
+void pqxx::connection::enter_pipeline_mode()
 {
-  line.erase();
-  char *buf{nullptr};
-
-  // Allocate once, re-use across invocations.
-  static auto const q{std::make_shared<std::string>("[END COPY]")};
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  flush_deferred();
+  if (PQenterPipelineMode(m_conn) != 1)
+    throw failure{"Could not enter pipeline mode: " + std::string{err_msg()}};
+#else
+  throw feature_not_supported{
+    "Pipeline mode is not available: libpqxx was built against a libpq "
+    "older than 14."};
+#endif // PQXX_HAVE_PQ_PIPELINE
+}
 
-  auto const line_len{PQgetCopyData(m_conn, &buf, false)};
-  switch (line_len)
-  {
-  case -2:
-    throw failure{"Reading of table data failed: " + std::string{err_msg()}};
 
-  case -1:
-    for (auto R{make_result(PQgetResult(m_conn), q)};
-         pqxx::internal::gate::result_connection(R);
-         R = make_result(PQgetResult(m_conn), q))
-      check_result(R);
-    return false;
+void pqxx::connection::exit_pipeline_mode()
+{
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  if (PQexitPipelineMode(m_conn) != 1)
+    throw failure{"Could not leave pipeline mode: " + std::string{err_msg()}};
+#else
+  throw feature_not_supported{
+    "Pipeline mode is not available: libpqxx was built against a libpq "
+    "older than 14."};
+#endif // PQXX_HAVE_PQ_PIPELINE
+}
 
-  case 0: throw internal_error{"table read inexplicably went asynchronous"};
 
-  default:
-    if (buf)
-    {
-      std::unique_ptr<char, std::function<void(char *)>> PQA(buf, PQfreemem);
-      line.assign(buf, unsigned(line_len));
-    }
-    return true;
-  }
+void pqxx::connection::pipeline_sync()
+{
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  if (PQpipelineSync(m_conn) != 1)
+    throw failure{err_msg()};
+#else
+  throw feature_not_supported{
+    "Pipeline mode is not available: libpqxx was built against a libpq "
+    "older than 14."};
+#endif // PQXX_HAVE_PQ_PIPELINE
 }
 
 
-void pqxx::connection::write_copy_line(std::string_view line)
+pqxx::internal::pq::PGresult *pqxx::connection::get_result()
 {
-  static std::string const err_prefix{"Error writing to table: "};
-  auto const size{check_cast<int>(line.size(), "write_copy_line()")};
-  if (PQputCopyData(m_conn, line.data(), size) <= 0)
-    throw failure{err_prefix + err_msg()};
-  if (PQputCopyData(m_conn, "\n", 1) <= 0)
-    throw failure{err_prefix + err_msg()};
+  return PQgetResult(m_conn);
 }
 
 
-void pqxx::connection::end_copy_write()
+pqxx::internal::pq::PGresult *pqxx::connection::spin_result(bool sent)
 {
-  int res{PQputCopyEnd(m_conn, nullptr)};
-  switch (res)
+  using namespace std::chrono;
+  if (not sent)
+    return nullptr;
+
+  // Poll for the result until it's in, or we've spun for as long as we're
+  // prepared to.  PQconsumeInput() doesn't block.  If it fails, we leave it
+  // to PQgetResult() to report the problem.
+  auto const start{steady_clock::now()};
+  auto const deadline{start + m_spin_limit};
+  bool ready{false};
+  for (auto now{start}; now <= deadline; now = steady_clock::now())
   {
-  case -1: throw failure{"Write to table failed: " + std::string{err_msg()}};
-  case 0: throw internal_error{"table write is inexplicably asynchronous"};
-  case 1:
-    // Normal termination.  Retrieve result object.
-    break;
+    if (PQconsumeInput(m_conn) == 0)
+      break;
+    if (PQisBusy(m_conn) == 0)
+    {
+      ready = true;
+      break;
+    }
+  }
 
-  default:
-    throw internal_error{"unexpected result " + to_string(res) +
-                         " from PQputCopyEnd()"};
+  // PQgetResult() blocks if the result still isn't in.  Like PQexec(), keep
+  // the last result, except an error stays in place once we have one.  A
+  // COPY is the end of the line, because its data comes next.
+  internal::pq::PGresult *last{nullptr};
+  for (auto res{PQgetResult(m_conn)}; res != nullptr;
+       res = PQgetResult(m_conn))
+  {
+    if (last != nullptr)
+    {
+      if (PQresultStatus(last) == PGRES_FATAL_ERROR)
+      {
+        PQclear(res);
+        continue;
+      }
+      PQclear(last);
+    }
+    last = res;
+    auto const status{PQresultStatus(res)};
+    if (
+      status == PGRES_COPY_IN or status == PGRES_COPY_OUT or
+      status == PGRES_COPY_BOTH or PQstatus(m_conn) == CONNECTION_BAD)
+      break;
   }
 
-  static auto const q{std::make_shared<std::string>("[END COPY]")};
-  check_result(make_result(PQgetResult(m_conn), q));
+  // Adapt the spin limit.  Spin a bit longer than the time that results
+  // take to come back, so long as that's within the maximum.  If it isn't,
+  // back off, but keep measuring, so we notice when results speed up again.
+  auto const took{duration_cast<microseconds>(steady_clock::now() - start)};
+  if (ready or took <= m_max_spin)
+    m_spin_limit = std::clamp(2 * took, microseconds{1}, m_max_spin);
+  else
+    m_spin_limit /= 2;
+  return last;
 }
 
 
-void pqxx::connection::start_exec(char const query[])
+pqxx::result
+pqxx::connection::receive_result(std::shared_ptr<std::string> const &query)
 {
-  if (PQsendQuery(m_conn, query) == 0)
-    throw failure{err_msg()};
+  auto const pq_result{get_result()};
+  if (pq_result == nullptr)
+    throw failure{"No result for query: " + *query};
+  auto const res{make_result(pq_result, query)};
+  // One query, one result.  Read the null after it, so that the connection
+  // is ready for the next query.
+  while (auto const extra{get_result()}) internal::clear_result(extra);
+  check_result(res);
+  get_notifs();
+  return res;
 }
 
 
-pqxx::internal::pq::PGresult *pqxx::connection::get_result()
+std::vector<pqxx::result>
+pqxx::connection::receive_results(std::shared_ptr<std::string> const &query)
 {
-  return PQgetResult(m_conn);
+  std::vector<result> results;
+  while (auto const pq_result{get_result()})
+    results.push_back(make_result(pq_result, query));
+  // Only check once we've read everything, so that an error leaves the
+  // connection ready for the next query.
+  for (auto const &res : results) check_result(res);
+  get_notifs();
+  return results;
 }
 
 
@@ -782,31 +2760,71 @@ size_t pqxx::connection::esc_to_buf(std::string_view text, char *buf) const
 }
 
 
+namespace
+{
+/// Throw @c conversion_overrun unless [begin, end) holds @c needed bytes.
+void check_escape_space(
+  char const *begin, char const *end, std::size_t needed, char const what[])
+{
+  if (end < begin or static_cast<std::size_t>(end - begin) < needed)
+    throw pqxx::conversion_overrun{
+      std::string{"Buffer too small to "} + what + ": need " +
+      pqxx::to_string(needed) + " bytes, have " +
+      pqxx::to_string(end - begin) + "."};
+}
+} // namespace
+
+
 std::string pqxx::connection::esc(std::string_view text) const
 {
   std::string buf;
-  buf.resize(2 * text.size() + 1);
+  buf.resize(size_esc(text));
   auto const copied{esc_to_buf(text, buf.data())};
   buf.resize(copied);
   return buf;
 }
 
 
+char *
+pqxx::connection::esc_into(std::string_view text, char *begin, char *end) const
+{
+  check_escape_space(begin, end, size_esc(text), "escape string");
+  return begin + esc_to_buf(text, begin) + 1;
+}
+
+
 std::string
 pqxx::connection::esc_raw(unsigned char const bin[], size_t len) const
 {
-  size_t bytes = 0;
-
-  std::unique_ptr<unsigned char, std::function<void(unsigned char *)>> buf{
-    PQescapeByteaConn(m_conn, bin, len, &bytes), PQfreemem};
-  if (buf.get() == nullptr)
-    throw std::bad_alloc{};
-  return std::string{reinterpret_cast<char *>(buf.get())};
+  // With standard_conforming_strings off, a backslash in a string literal
+  // needs escaping.  Let libpq deal with that one.
+  auto const conforming{
+    PQparameterStatus(m_conn, "standard_conforming_strings")};
+  if (conforming != nullptr and std::strcmp(conforming, "off") == 0)
+  {
+    size_t bytes = 0;
+    std::unique_ptr<unsigned char, std::function<void(unsigned char *)>> buf{
+      PQescapeByteaConn(m_conn, bin, len, &bytes), PQfreemem};
+    if (buf.get() == nullptr)
+      throw std::bad_alloc{};
+    return std::string{reinterpret_cast<char *>(buf.get())};
+  }
+  return esc_bin(std::string_view{reinterpret_cast<char const *>(bin), len});
 }
 
 
 std::string pqxx::connection::unesc_raw(char const text[]) const
 {
+  if (text[0] == '\\' and text[1] == 'x')
+  {
+    std::string_view const escaped{text};
+    std::string buf;
+    buf.resize(size_unesc_bin(escaped.size()));
+    unesc_bin(escaped, reinterpret_cast<std::byte *>(buf.data()));
+    return buf;
+  }
+
+  // Old "escape" format.
   size_t len;
   auto bytes{const_cast<unsigned char *>(
     reinterpret_cast<unsigned char const *>(text))};
@@ -831,30 +2849,67 @@ std::string pqxx::connection::quote(binarystring const &b) const
 
 std::string pqxx::connection::quote_name(std::string_view identifier) const
 {
-  std::unique_ptr<char, std::function<void(char *)>> buf{
-    PQescapeIdentifier(m_conn, identifier.data(), identifier.size()),
-    PQfreemem};
-  if (buf.get() == nullptr)
-    throw failure{err_msg()};
-  return std::string{buf.get()};
+  std::string buf;
+  buf.resize(size_quote_name(identifier));
+  auto const end{
+    quote_name_into(identifier, buf.data(), buf.data() + buf.size())};
+  buf.resize(static_cast<std::size_t>(end - buf.data() - 1));
+  return buf;
+}
+
+
+char *pqxx::connection::quote_name_into(
+  std::string_view identifier, char *begin, char *end) const
+{
+  check_escape_space(
+    begin, end, size_quote_name(identifier), "quote identifier");
+  // No multibyte character in any client encoding contains a byte that looks
+  // like a double quote, so we only need to go glyph by glyph to check that
+  // the text is valid.
+  auto here{begin};
+  *here++ = '"';
+  internal::for_glyphs(
+    enc_group(),
+    [&here](char const *gbegin, char const *gend) {
+      if (*gbegin == '"')
+        *here++ = '"';
+      for (; gbegin != gend; ++gbegin) *here++ = *gbegin;
+    },
+    identifier.data(), identifier.size());
+  *here++ = '"';
+  *here++ = '\0';
+  return here;
 }
 
 
 std::string
 pqxx::connection::esc_like(std::string_view text, char escape_char) const
 {
-  std::string out;
-  out.reserve(text.size());
+  std::string buf;
+  buf.resize(size_esc_like(text));
+  auto const end{
+    esc_like_into(text, buf.data(), buf.data() + buf.size(), escape_char)};
+  buf.resize(static_cast<std::size_t>(end - buf.data() - 1));
+  return buf;
+}
+
+
+char *pqxx::connection::esc_like_into(
+  std::string_view text, char *begin, char *end, char escape_char) const
+{
+  check_escape_space(begin, end, size_esc_like(text), "LIKE-escape string");
+  auto here{begin};
   internal::for_glyphs(
-    internal::enc_group(encoding_id()),
-    [&out, escape_char](char const *gbegin, char const *gend) {
+    enc_group(),
+    [&here, escape_char](char const *gbegin, char const *gend) {
       if ((gend - gbegin == 1) and (*gbegin == '_' or *gbegin == '%'))
-        out.push_back(escape_char);
+        *here++ = escape_char;
 
-      for (; gbegin != gend; ++gbegin) out.push_back(*gbegin);
+      for (; gbegin != gend; ++gbegin) *here++ = *gbegin;
     },
     text.data(), text.size());
-  return out;
+  *here++ = '\0';
+  return here;
 }
 
 
@@ -871,24 +2926,46 @@ namespace
 }
 
 
+/// Throw if waiting for a socket failed, other than by being interrupted.
+/** Call this right after the wait, passing the function's return value.  An
+ * interrupted wait is harmless: our callers check whether they have what
+ * they were waiting for, and wait again if not.
+ */
+void check_wait(char const op[], int result)
+{
+  if (result >= 0)
+    return;
+#if defined(_WIN32) && (_WIN32_WINNT >= 0x0600)
+  int const err{WSAGetLastError()};
+  if (err == WSAEINTR)
+    return;
+#else
+  int const err{errno};
+  if (err == EINTR)
+    return;
+#endif
+  throw pqxx::broken_connection{
+    std::string{op} + " failed: " + std::system_category().message(err)};
+}
+
+
 /// Wait for an fd to become free for reading/writing.  Optional timeout.
 void wait_fd(int fd, bool forwrite = false, timeval *tv = nullptr)
 {
   if (fd < 0)
     throw pqxx::broken_connection{"No connection."};
+  PQXX_TRACE2(wait__start, fd, static_cast<int>(forwrite));
 
 // WSAPoll is available in winsock2.h only for versions of Windows >= 0x0600
 #if defined(_WIN32) && (_WIN32_WINNT >= 0x0600)
   short const events{forwrite ? POLLWRNORM : POLLRDNORM};
   WSAPOLLFD fdarray{SOCKET(fd), events, 0};
-  WSAPoll(&fdarray, 1, tv_milliseconds(tv));
-  // TODO: Check for errors.
+  check_wait("WSAPoll()", WSAPoll(&fdarray, 1, tv_milliseconds(tv)));
 #elif defined(PQXX_HAVE_POLL)
   auto const events{static_cast<short>(
     POLLERR | POLLHUP | POLLNVAL | (forwrite ? POLLOUT : POLLIN))};
   pollfd pfd{fd, events, 0};
-  poll(&pfd, 1, tv_milliseconds(tv));
-  // TODO: Check for errors.
+  check_wait("poll()", poll(&pfd, 1, tv_milliseconds(tv)));
 #else
   // No poll()?  Our last option is select().
   fd_set read_fds;
@@ -905,8 +2982,80 @@ void wait_fd(int fd, bool forwrite = false, timeval *tv = nullptr)
   FD_ZERO(&except_fds);
   FD_SET(fd, &except_fds);
 
-  select(fd + 1, &read_fds, &write_fds, &except_fds, tv);
-  // TODO: Check for errors.
+  check_wait(
+    "select()", select(fd + 1, &read_fds, &write_fds, &except_fds, tv));
+#endif
+  PQXX_TRACE1(wait__done, fd);
+}
+
+
+/// A socket to wait for, in @c wait_sockets().
+struct socket_wait
+{
+  int fd;
+  bool for_write;
+  /// Output: is the socket ready?
+  bool ready = false;
+};
+
+
+/// Wait until at least one of several sockets is ready.
+/** Gives up after @c timeout_ms milliseconds, unless that's negative.
+ */
+void wait_sockets(std::vector<socket_wait> &sockets, int timeout_ms = -1)
+{
+  for (auto const &w : sockets)
+    if (w.fd < 0)
+      throw pqxx::broken_connection{"No connection."};
+
+#if defined(_WIN32) && (_WIN32_WINNT >= 0x0600)
+  std::vector<WSAPOLLFD> fds;
+  fds.reserve(std::size(sockets));
+  for (auto const &w : sockets)
+  {
+    short const events{w.for_write ? POLLWRNORM : POLLRDNORM};
+    fds.push_back(WSAPOLLFD{SOCKET(w.fd), events, 0});
+  }
+  check_wait(
+    "WSAPoll()",
+    WSAPoll(fds.data(), static_cast<ULONG>(std::size(fds)), timeout_ms));
+  for (std::size_t i{0}; i < std::size(sockets); ++i)
+    sockets[i].ready = (fds[i].revents != 0);
+#elif defined(PQXX_HAVE_POLL)
+  std::vector<pollfd> fds;
+  fds.reserve(std::size(sockets));
+  for (auto const &w : sockets)
+  {
+    auto const events{static_cast<short>(
+      POLLERR | POLLHUP | POLLNVAL | (w.for_write ? POLLOUT : POLLIN))};
+    fds.push_back(pollfd{w.fd, events, 0});
+  }
+  check_wait(
+    "poll()",
+    poll(fds.data(), static_cast<nfds_t>(std::size(fds)), timeout_ms));
+  for (std::size_t i{0}; i < std::size(sockets); ++i)
+    sockets[i].ready = (fds[i].revents != 0);
+#else
+  fd_set read_fds, write_fds, except_fds;
+  FD_ZERO(&read_fds);
+  FD_ZERO(&write_fds);
+  FD_ZERO(&except_fds);
+  int max_fd{0};
+  for (auto const &w : sockets)
+  {
+    FD_SET(w.fd, w.for_write ? &write_fds : &read_fds);
+    FD_SET(w.fd, &except_fds);
+    max_fd = std::max(max_fd, w.fd);
+  }
+  timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+  check_wait(
+    "select()",
+    select(
+      max_fd + 1, &read_fds, &write_fds, &except_fds,
+      (timeout_ms < 0) ? nullptr : &tv));
+  for (auto &w : sockets)
+    w.ready = FD_ISSET(w.fd, w.for_write ? &write_fds : &read_fds) or
+              FD_ISSET(w.fd, &except_fds);
 #endif
 }
 } // namespace
@@ -937,6 +3086,296 @@ void pqxx::internal::wait_write(internal::pq::PGconn const *c)
 }
 
 
+void pqxx::internal::wait_socket(int fd, bool for_write)
+{
+  wait_fd(fd, for_write);
+}
+
+
+std::vector<pqxx::connection>
+pqxx::connect_all(std::vector<std::string> const &options)
+{
+  std::vector<connecting> pending;
+  pending.reserve(std::size(options));
+  for (auto const &opt : options) pending.emplace_back(opt);
+
+  std::vector<socket_wait> waits;
+  waits.reserve(std::size(pending));
+  for (;;)
+  {
+    waits.clear();
+    for (auto const &c : pending)
+      if (not c.done())
+        waits.push_back(socket_wait{c.sock(), c.wait_to_write()});
+    if (std::empty(waits))
+      break;
+
+    wait_sockets(waits);
+
+    // The sockets we waited for are in the same order as the connections
+    // which were not done.
+    auto w{std::begin(waits)};
+    for (auto &c : pending)
+      if (not c.done() and (w++)->ready)
+        c.process();
+  }
+
+  std::vector<connection> conns;
+  conns.reserve(std::size(pending));
+  for (auto &c : pending) conns.push_back(std::move(c).produce());
+  return conns;
+}
+
+
+std::vector<pqxx::connection>
+pqxx::connect_all(zview options, std::size_t count)
+{
+  return connect_all(std::vector<std::string>(count, std::string{options}));
+}
+
+
+namespace
+{
+/// Addresses that a host name resolved to, and until when they're good.
+struct cached_addresses
+{
+  std::vector<std::string> addresses;
+  std::chrono::steady_clock::time_point expiry;
+};
+
+
+std::mutex address_cache_mutex;
+std::map<std::string, cached_addresses, std::less<>> address_cache;
+
+
+/// Look up a host name's numeric addresses, or use the ones we cached.
+/** Returns nothing if the lookup fails.  The attempt to connect will then
+ * use the name, so that libpq reports the error.
+ */
+std::vector<std::string>
+host_addresses(std::string const &host, std::chrono::seconds ttl)
+{
+  auto const now{std::chrono::steady_clock::now()};
+  {
+    std::lock_guard const lock{address_cache_mutex};
+    auto const here{address_cache.find(host)};
+    if (here != std::end(address_cache) and here->second.expiry > now)
+      return here->second.addresses;
+  }
+
+  std::vector<std::string> addresses;
+#if __has_include(<netdb.h>) || __has_include(<ws2tcpip.h>)
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *found{nullptr};
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &found) == 0)
+  {
+    for (auto a{found}; a != nullptr; a = a->ai_next)
+    {
+      // Big enough for any numeric address; this is NI_MAXHOST.
+      char text[1025];
+      if (
+        getnameinfo(
+          a->ai_addr, static_cast<socklen_t>(a->ai_addrlen), text,
+          sizeof(text), nullptr, 0, NI_NUMERICHOST) == 0 and
+        std::find(std::begin(addresses), std::end(addresses), text) ==
+          std::end(addresses))
+        addresses.emplace_back(text);
+    }
+    freeaddrinfo(found);
+  }
+#endif
+
+  if (not std::empty(addresses))
+  {
+    std::lock_guard const lock{address_cache_mutex};
+    address_cache[host] = cached_addresses{addresses, now + ttl};
+  }
+  return addresses;
+}
+
+
+/// Append "key='value'" to a connection string, quoted and escaped.
+void append_option(
+  std::string &options, char const key[], std::string_view value)
+{
+  if (not std::empty(options))
+    options.push_back(' ');
+  options.append(key).append("='");
+  for (char const c : value)
+  {
+    if (c == '\'' or c == '\\')
+      options.push_back('\\');
+    options.push_back(c);
+  }
+  options.push_back('\'');
+}
+
+
+/// Split a comma-separated connection option, such as a list of hosts.
+std::vector<std::string> split_option(std::string_view value)
+{
+  std::vector<std::string> parts;
+  for (;;)
+  {
+    auto const comma{value.find(',')};
+    parts.emplace_back(value.substr(0, comma));
+    if (comma == std::string_view::npos)
+      return parts;
+    value.remove_prefix(comma + 1);
+  }
+}
+
+
+/// Connection strings for each host, and each address of each host.
+std::vector<std::string>
+connect_attempts(pqxx::zview options, std::chrono::seconds address_ttl)
+{
+  char *err{nullptr};
+  std::unique_ptr<PQconninfoOption, void (*)(PQconninfoOption *)> const
+    params{PQconninfoParse(options.c_str(), &err), PQconninfoFree};
+  if (params == nullptr)
+  {
+    if (err == nullptr)
+      throw std::bad_alloc{};
+    std::string const msg{err};
+    PQfreemem(err);
+    throw pqxx::broken_connection{msg};
+  }
+
+  std::string common;
+  std::vector<std::string> hosts, hostaddrs, ports;
+  for (auto p{params.get()}; p->keyword != nullptr; ++p)
+  {
+    if (p->val == nullptr)
+      continue;
+    std::string_view const key{p->keyword};
+    if (key == "host")
+      hosts = split_option(p->val);
+    else if (key == "hostaddr")
+      hostaddrs = split_option(p->val);
+    else if (key == "port")
+      ports = split_option(p->val);
+    else
+      append_option(common, p->keyword, p->val);
+  }
+
+  std::vector<std::string> attempts;
+  auto const count{std::max(std::size(hosts), std::size(hostaddrs))};
+  for (std::size_t i{0}; i < count; ++i)
+  {
+    std::string const host{(i < std::size(hosts)) ? hosts[i] : ""},
+      hostaddr{(i < std::size(hostaddrs)) ? hostaddrs[i] : ""},
+      port{
+        (std::size(ports) == 1) ? ports[0] :
+        (i < std::size(ports))  ? ports[i] :
+                                  ""};
+    auto const attempt{[&](std::string const &addr) {
+      auto opts{common};
+      if (not std::empty(host))
+        append_option(opts, "host", host);
+      if (not std::empty(addr))
+        append_option(opts, "hostaddr", addr);
+      if (not std::empty(port))
+        append_option(opts, "port", port);
+      attempts.push_back(std::move(opts));
+    }};
+
+    // A name starting with a slash or an at-sign is a Unix socket.
+    bool const lookup{
+      std::empty(hostaddr) and not std::empty(host) and host[0] != '/' and
+      host[0] != '@'};
+    auto const addresses{
+      lookup ? host_addresses(host, address_ttl) :
+               std::vector<std::string>{}};
+    if (std::empty(addresses))
+      attempt(hostaddr);
+    else
+      for (auto const &addr : addresses) attempt(addr);
+  }
+
+  // No hosts: libpq's defaults, or the environment, decide.
+  if (std::empty(attempts))
+    attempts.emplace_back(options.c_str());
+  return attempts;
+}
+} // namespace
+
+
+pqxx::connection
+pqxx::connect_first(zview options, connect_first_config const &config)
+{
+  using clock = std::chrono::steady_clock;
+  auto const attempts{connect_attempts(options, config.address_ttl)};
+
+  std::vector<connecting> running;
+  std::vector<socket_wait> waits;
+  std::size_t next{0};
+  auto next_start{clock::now()};
+  std::exception_ptr error;
+  for (;;)
+  {
+    // Start another attempt when it's time, or when nothing else is going.
+    if (
+      next < std::size(attempts) and
+      (std::empty(running) or clock::now() >= next_start))
+    {
+      try
+      {
+        running.emplace_back(attempts[next]);
+      }
+      catch (broken_connection const &)
+      {
+        error = std::current_exception();
+      }
+      ++next;
+      next_start = clock::now() + config.stagger;
+      continue;
+    }
+    if (std::empty(running))
+      std::rethrow_exception(error);
+
+    waits.clear();
+    for (auto const &c : running)
+      waits.push_back(socket_wait{c.sock(), c.wait_to_write()});
+    int timeout_ms{-1};
+    if (next < std::size(attempts))
+      timeout_ms = static_cast<int>(std::clamp<long long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+          next_start - clock::now())
+          .count(),
+        0, std::numeric_limits<int>::max()));
+    wait_sockets(waits, timeout_ms);
+
+    // Go backwards, so that dropping a failed attempt doesn't move the ones
+    // we have yet to look at.
+    for (auto i{std::size(running)}; i-- > 0;)
+      if (waits[i].ready)
+        try
+        {
+          running[i].process();
+          if (running[i].done())
+            return std::move(running[i]).produce();
+        }
+        catch (broken_connection const &)
+        {
+          error = std::current_exception();
+          running.erase(std::begin(running) + static_cast<std::ptrdiff_t>(i));
+          // No need to wait for the stagger: start the next one now.
+          next_start = clock::now();
+        }
+  }
+}
+
+
+void pqxx::forget_host_addresses() noexcept
+{
+  std::lock_guard const lock{address_cache_mutex};
+  address_cache.clear();
+}
+
+
 void pqxx::connection::wait_read() const
 {
   internal::wait_read(m_conn);
@@ -1024,18 +3463,70 @@ int pqxx::connection::encoding_id() const
 }
 
 
+pqxx::internal::encoding_group pqxx::connection::enc_group() const
+{
+  // The ID is cheap to get, but mapping it to a group is a name lookup.
+  if (auto const enc{encoding_id()}; enc != m_enc_id)
+  {
+    m_enc_group = internal::enc_group(enc);
+    m_enc_id = enc;
+  }
+  if (m_trust_encoding and internal::is_ascii_safe(m_enc_group))
+    return internal::encoding_group::MONOBYTE;
+  return m_enc_group;
+}
+
+
 pqxx::result pqxx::connection::exec_params(
-  std::string_view query, internal::params const &args)
+  std::string_view query, internal::params const &args, format result_format)
 {
+  // A prepared statement's parameter types are fixed, so typed parameters
+  // could clash with those of an earlier execution.  Don't auto-prepare.
+  if (m_auto_prepare_runs > 0 and not args.has_types())
+  {
+    auto const &name{auto_prepare(query)};
+    auto const r{
+      std::empty(name) ? exec_params_now(query, args, result_format) :
+                         exec_prepared(name, args, result_format)};
+    // Only now that the query has succeeded, deallocate anything that fell
+    // out of the cache.  Otherwise an error in the transaction would show up
+    // as a failure to deallocate.
+    trim_auto_prepared();
+    return r;
+  }
+  return exec_params_now(query, args, result_format);
+}
+
+
+pqxx::result pqxx::connection::exec_params_now(
+  std::string_view query, internal::params const &args, format result_format)
+{
+  auto const q{query_text(query)};
+  if (have_deferred())
+    return exec_bundled(q, &args, false, result_format, false);
+  auto const start{query_start()};
   auto const pointers{args.get_pointers()};
-  auto const q{std::make_shared<std::string>(query)};
   auto const nonnulls{
     check_cast<int>(args.nonnulls.size(), "exec_params() parameters")};
-  auto const pq_result{PQexecParams(
-    m_conn, q->c_str(), nonnulls, nullptr, pointers.data(),
-    args.lengths.data(), args.binaries.data(), 0)};
+  std::string buf;
+  auto const text{traced(*q, buf)};
+  PQXX_TRACE2(exec__start, this, q->c_str());
+  auto const pq_result{
+    (m_max_spin.count() == 0) ?
+      PQexecParams(
+        m_conn, text, nonnulls, args.types.data(), pointers.data(),
+        args.lengths.data(), args.binaries.data(),
+        static_cast<int>(result_format)) :
+      spin_result(
+        PQsendQueryParams(
+          m_conn, text, nonnulls, args.types.data(), pointers.data(),
+          args.lengths.data(), args.binaries.data(),
+          static_cast<int>(result_format)) != 0)};
   auto const r{make_result(pq_result, q)};
-  check_result(r);
+  PQXX_TRACE2(exec__done, this, q->c_str());
+  check_result(
+    r, query_stats::kind::query, *q, reporting() ? query_size(*q, &args) : 0,
+    start, 1, &args);
   get_notifs();
   return r;
 }
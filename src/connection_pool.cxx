@@ -0,0 +1,617 @@
+/** Implementation of the pqxx::connection_pool class.
+ *
+ * pqxx::connection_pool shares a set of connections between threads.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+
+#include "pqxx/connection_pool"
+#include "pqxx/nontransaction"
+
+
+pqxx::pooled_connection &
+pqxx::pooled_connection::operator=(pooled_connection &&rhs) noexcept
+{
+  if (&rhs != this)
+  {
+    give_back();
+    m_pool = rhs.m_pool;
+    m_conn = std::move(rhs.m_conn);
+    m_num_prepared = rhs.m_num_prepared;
+    m_priority = rhs.m_priority;
+  }
+  return *this;
+}
+
+
+void pqxx::pooled_connection::give_back() noexcept
+{
+  if (m_conn)
+    m_pool->give_back(std::move(m_conn), m_num_prepared, m_priority);
+}
+
+
+pqxx::connection_pool::connection_pool(
+  std::string options, connection_pool_config const &config) :
+        m_options{std::move(options)},
+        m_config{config},
+        m_shards(std::max(config.shards, std::size_t{1}))
+{
+  if (m_config.max_size == 0)
+    throw argument_error{"A connection pool needs room for a connection."};
+  if (m_config.min_size > m_config.max_size)
+    throw argument_error{
+      "Connection pool's minimum size (" + to_string(m_config.min_size) +
+      ") exceeds its maximum size (" + to_string(m_config.max_size) + ")."};
+  if (m_config.shards == 0)
+    throw argument_error{"A connection pool needs at least one shard."};
+  if (m_config.min_idle > m_config.max_size)
+    throw argument_error{
+      "Connection pool's minimum idle connections (" +
+      to_string(m_config.min_idle) + ") exceeds its maximum size (" +
+      to_string(m_config.max_size) + ")."};
+  bool const maintenance{
+    m_config.min_idle > 0 or m_config.heartbeat.count() > 0};
+  if (maintenance and m_config.maintenance_interval.count() <= 0)
+    throw argument_error{"Connection pool maintenance interval must be > 0."};
+
+  // Bring up the minimum number of connections concurrently.
+  auto conns{connect_all(zview{m_options}, m_config.min_size)};
+  auto const now{clock::now()};
+  for (auto &s : m_shards) s.idle.reserve(m_config.max_size);
+  // Spread them out over the shards.
+  for (std::size_t i{0}; i < std::size(conns); ++i)
+    m_shards[i % std::size(m_shards)].idle.push_back(idle_connection{
+      std::make_unique<connection>(std::move(conns[i])), 0, now, now});
+  m_open = std::size(conns);
+
+  if (maintenance)
+    m_maintenance = std::thread{[this] { maintenance_loop(); }};
+}
+
+
+pqxx::connection_pool::~connection_pool() noexcept
+{
+  if (m_maintenance.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> const lock{m_mutex};
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_maintenance.join();
+  }
+}
+
+
+pqxx::connection_pool::shard &pqxx::connection_pool::home_shard() noexcept
+{
+  // Number each thread the first time it gets here.
+  static std::atomic<std::size_t> threads{0};
+  thread_local std::size_t const thread_number{threads++};
+  return m_shards[thread_number % std::size(m_shards)];
+}
+
+
+bool pqxx::connection_pool::take_idle(
+  idle_connection &out, std::vector<std::unique_ptr<connection>> &doomed)
+{
+  auto const home{
+    static_cast<std::size_t>(&home_shard() - std::data(m_shards))};
+  for (std::size_t i{0}; i < std::size(m_shards); ++i)
+  {
+    auto &s{m_shards[(home + i) % std::size(m_shards)]};
+    std::lock_guard<std::mutex> const lock{s.mutex};
+    while (not std::empty(s.idle))
+    {
+      // From our own shard, take the most recently returned connection.
+      // From another, take the least recently returned one, leaving that
+      // shard's own threads the connections they used last.
+      auto const pos{(i == 0) ? std::end(s.idle) - 1 : std::begin(s.idle)};
+      auto entry{std::move(*pos)};
+      s.idle.erase(pos);
+      if (entry.conn->is_open())
+      {
+        out = std::move(entry);
+        return true;
+      }
+      // Broken.  Drop it, and try the next one.  Others may be broken as
+      // well, so let the maintenance thread (if any) check.
+      doomed.push_back(std::move(entry.conn));
+      std::lock_guard<std::mutex> const pool_lock{m_mutex};
+      --m_open;
+      ++m_returns;
+      m_returned.notify_all();
+      m_wake.notify_one();
+    }
+  }
+  return false;
+}
+
+
+bool pqxx::connection_pool::may_go(
+  std::uint64_t ticket, pool_priority priority) const noexcept
+{
+  auto const &interactive{m_queue[std::size_t(pool_priority::interactive)]};
+  if (priority == pool_priority::interactive)
+    return interactive.front() == ticket;
+  auto const &batch{m_queue[std::size_t(pool_priority::batch)]};
+  return std::empty(interactive) and batch.front() == ticket and
+         (m_config.max_batch == 0 or m_batch_busy < m_config.max_batch);
+}
+
+
+void pqxx::connection_pool::leave_queue(
+  std::uint64_t ticket, pool_priority priority) noexcept
+{
+  auto &queue{m_queue[std::size_t(priority)]};
+  queue.erase(std::find(std::begin(queue), std::end(queue), ticket));
+  // Whoever is next in line may now have a go.
+  ++m_returns;
+  m_returned.notify_all();
+}
+
+
+pqxx::pooled_connection pqxx::connection_pool::get(
+  pool_priority priority, std::chrono::milliseconds timeout)
+{
+  // Declared first, so we close these after letting go of any locks.
+  std::vector<std::unique_ptr<connection>> doomed;
+  evict(doomed);
+
+  auto const start{clock::now()};
+  auto const deadline{start + timeout};
+  bool const batch{priority == pool_priority::batch};
+  auto &stats{m_stats[std::size_t(priority)]};
+
+  std::unique_lock<std::mutex> lock{m_mutex};
+  auto const ticket{m_next_ticket++};
+  m_queue[std::size_t(priority)].push_back(ticket);
+  bool waited{false};
+
+  // Done waiting, one way or another.  Call with the lock held.
+  auto const done{[&](bool success) {
+    leave_queue(ticket, priority);
+    if (waited)
+    {
+      --stats.waiting;
+      auto const wait{clock::now() - start};
+      stats.total_wait += wait;
+      stats.max_wait = std::max(stats.max_wait, wait);
+      if (success)
+        ++stats.waits;
+    }
+    if (success)
+    {
+      ++stats.checkouts;
+      if (batch)
+        ++m_batch_busy;
+    }
+  }};
+
+  // Counts m_returns at our last attempt, if we made one.
+  std::optional<std::size_t> tried;
+  for (;;)
+  {
+    auto const ready{[this, ticket, priority, &tried] {
+      return may_go(ticket, priority) and m_returns != tried;
+    }};
+    if (not ready())
+    {
+      if (not waited)
+      {
+        auto const waiting{m_stats[0].waiting + m_stats[1].waiting};
+        if (m_config.max_waiting != 0 and waiting >= m_config.max_waiting)
+        {
+          leave_queue(ticket, priority);
+          ++stats.rejections;
+          throw failure{"Too many callers waiting for a pooled connection."};
+        }
+        waited = true;
+        ++stats.waiting;
+      }
+      if (timeout.count() == 0)
+      {
+        m_returned.wait(lock, ready);
+      }
+      else if (not m_returned.wait_until(lock, deadline, ready))
+      {
+        done(false);
+        ++stats.timeouts;
+        throw failure{"Timed out waiting for a pooled connection."};
+      }
+    }
+    tried = m_returns;
+
+    // Look for an idle connection.  That takes the shard locks, which come
+    // before m_mutex.
+    lock.unlock();
+    idle_connection entry;
+    bool const found{take_idle(entry, doomed)};
+    lock.lock();
+    if (found)
+    {
+      done(true);
+      lock.unlock();
+      try
+      {
+        auto const num_prepared{
+          prepare_missing(*entry.conn, entry.num_prepared)};
+        return pooled_connection{
+          *this, std::move(entry.conn), num_prepared, priority};
+      }
+      catch (std::exception const &)
+      {
+        // The connection goes away, so give up its slot.
+        entry.conn.reset();
+        lock.lock();
+        --m_open;
+        if (batch)
+          --m_batch_busy;
+        ++m_returns;
+        m_returned.notify_all();
+        throw;
+      }
+    }
+
+    if (m_open < m_config.max_size)
+    {
+      // Reserve a slot, but don't hold the lock while connecting.
+      ++m_open;
+      done(true);
+      lock.unlock();
+      try
+      {
+        auto conn{std::make_unique<connection>(m_options)};
+        auto const num_prepared{prepare_missing(*conn, 0)};
+        return pooled_connection{
+          *this, std::move(conn), num_prepared, priority};
+      }
+      catch (std::exception const &)
+      {
+        lock.lock();
+        --m_open;
+        if (batch)
+          --m_batch_busy;
+        ++m_returns;
+        m_returned.notify_all();
+        throw;
+      }
+    }
+    // Nothing available.  Wait for something to change.
+  }
+}
+
+
+pqxx::pool_queue_stats
+pqxx::connection_pool::stats(pool_priority priority) const
+{
+  std::lock_guard<std::mutex> const lock{m_mutex};
+  return m_stats[std::size_t(priority)];
+}
+
+
+void pqxx::connection_pool::prepare(
+  std::string const &name, std::string const &definition)
+{
+  std::lock_guard<std::mutex> const lock{m_mutex};
+  m_statements.push_back(prepare::statement{name, definition});
+}
+
+
+void pqxx::connection_pool::prepare_all(
+  std::vector<prepare::statement> const &statements)
+{
+  std::lock_guard<std::mutex> const lock{m_mutex};
+  m_statements.insert(
+    std::end(m_statements), std::begin(statements), std::end(statements));
+}
+
+
+std::size_t pqxx::connection_pool::size() const
+{
+  std::lock_guard<std::mutex> const lock{m_mutex};
+  return m_open;
+}
+
+
+std::size_t pqxx::connection_pool::idle() const
+{
+  std::size_t total{0};
+  for (auto const &s : m_shards)
+  {
+    std::lock_guard<std::mutex> const lock{s.mutex};
+    total += std::size(s.idle);
+  }
+  return total;
+}
+
+
+void pqxx::connection_pool::give_back(
+  std::unique_ptr<connection> conn, std::size_t num_prepared,
+  pool_priority priority)
+{
+  // Reset the session outside the lock; it takes a round trip.
+  if (conn->is_open() and m_config.reset == pool_reset::discard_all)
+    try
+    {
+      nontransaction tx{*conn};
+      tx.exec0("DISCARD ALL");
+      tx.commit();
+      num_prepared = 0;
+      conn->forget_auto_prepared();
+    }
+    catch (std::exception const &)
+    {
+      // Whatever went wrong, we don't want this connection anymore.
+      conn->close();
+    }
+
+  // Declared first, so we close these after letting go of any locks.
+  std::vector<std::unique_ptr<connection>> doomed;
+  if (conn->is_open())
+  {
+    auto &s{home_shard()};
+    auto const now{clock::now()};
+    std::lock_guard<std::mutex> const lock{s.mutex};
+    s.idle.push_back(idle_connection{std::move(conn), num_prepared, now, now});
+  }
+  else
+  {
+    doomed.push_back(std::move(conn));
+  }
+
+  {
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    if (not std::empty(doomed))
+      --m_open;
+    if (priority == pool_priority::batch)
+      --m_batch_busy;
+    ++m_returns;
+    // Wake all waiters.  Only the one at the head of the line will go.
+    m_returned.notify_all();
+  }
+  evict(doomed);
+}
+
+
+void pqxx::connection_pool::evict(
+  shard &s, std::vector<std::unique_ptr<connection>> &doomed)
+{
+  std::lock_guard<std::mutex> const lock{s.mutex};
+  if (std::empty(s.idle))
+    return;
+  std::lock_guard<std::mutex> const pool_lock{m_mutex};
+
+  // The least recently returned connections are at the front.
+  auto const cutoff{clock::now() - m_config.max_idle};
+  std::size_t stale{0};
+  while (stale < std::size(s.idle) and s.idle[stale].since < cutoff and
+         m_open - stale > m_config.min_size)
+    ++stale;
+  if (stale == 0)
+    return;
+
+  for (std::size_t i{0}; i < stale; ++i)
+    doomed.push_back(std::move(s.idle[i].conn));
+  s.idle.erase(std::begin(s.idle), std::begin(s.idle) + stale);
+  m_open -= stale;
+  ++m_returns;
+  m_returned.notify_all();
+}
+
+
+void pqxx::connection_pool::evict(
+  std::vector<std::unique_ptr<connection>> &doomed)
+{
+  auto &home{home_shard()};
+  evict(home, doomed);
+  if (std::size(m_shards) > 1)
+  {
+    // Check one other shard as well, taking turns, so that shards whose
+    // threads have gone quiet don't keep their idle connections forever.
+    auto &other{m_shards[m_evict_next++ % std::size(m_shards)]};
+    if (&other != &home)
+      evict(other, doomed);
+  }
+}
+
+
+std::size_t pqxx::connection_pool::prepare_missing(
+  connection &conn, std::size_t num_prepared) const
+{
+  // Copy the missing definitions, so we don't prepare under the lock.
+  std::vector<prepare::statement> missing;
+  {
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    missing.assign(
+      std::begin(m_statements) + static_cast<std::ptrdiff_t>(num_prepared),
+      std::end(m_statements));
+  }
+  if (not missing.empty())
+    conn.prepare_all(missing);
+  return num_prepared + std::size(missing);
+}
+
+
+void pqxx::connection_pool::maintain()
+{
+  // Declared first, so we close these after letting go of any locks.
+  std::vector<std::unique_ptr<connection>> doomed;
+  for (auto &s : m_shards) evict(s, doomed);
+  if (m_config.heartbeat.count() > 0)
+    heartbeat(doomed);
+  top_up();
+}
+
+
+void pqxx::connection_pool::restore(
+  shard &s, std::vector<idle_connection> &entries)
+{
+  if (std::empty(entries))
+    return;
+  std::lock_guard<std::mutex> const lock{s.mutex};
+  auto const old_size{static_cast<std::ptrdiff_t>(std::size(s.idle))};
+  s.idle.insert(
+    std::end(s.idle), std::make_move_iterator(std::begin(entries)),
+    std::make_move_iterator(std::end(entries)));
+  // Keep the least recently returned connections at the front.
+  std::inplace_merge(
+    std::begin(s.idle), std::begin(s.idle) + old_size, std::end(s.idle),
+    [](idle_connection const &lhs, idle_connection const &rhs) {
+      return lhs.since < rhs.since;
+    });
+  entries.clear();
+}
+
+
+void pqxx::connection_pool::heartbeat(
+  std::vector<std::unique_ptr<connection>> &doomed)
+{
+  auto const cutoff{clock::now() - m_config.heartbeat};
+  std::vector<idle_connection> due;
+  for (auto &s : m_shards)
+  {
+    // Take the connections out of the shard, so we don't hold its lock
+    // while we wait for the server.
+    {
+      std::lock_guard<std::mutex> const lock{s.mutex};
+      auto const first{std::stable_partition(
+        std::begin(s.idle), std::end(s.idle),
+        [cutoff](idle_connection const &c) { return c.checked >= cutoff; })};
+      due.assign(
+        std::make_move_iterator(first),
+        std::make_move_iterator(std::end(s.idle)));
+      s.idle.erase(first, std::end(s.idle));
+    }
+
+    std::size_t lost{0};
+    for (auto &entry : due)
+    {
+      try
+      {
+        nontransaction tx{*entry.conn};
+        tx.exec0("");
+        entry.checked = clock::now();
+      }
+      catch (std::exception const &)
+      {
+        // Whatever went wrong, we don't want this connection anymore.
+        try
+        {
+          entry.conn->close();
+        }
+        catch (std::exception const &)
+        {}
+      }
+      if (not entry.conn->is_open())
+      {
+        doomed.push_back(std::move(entry.conn));
+        ++lost;
+      }
+    }
+    due.erase(
+      std::remove_if(
+        std::begin(due), std::end(due),
+        [](idle_connection const &c) { return not c.conn; }),
+      std::end(due));
+    restore(s, due);
+
+    if (lost > 0)
+    {
+      std::lock_guard<std::mutex> const lock{m_mutex};
+      m_open -= lost;
+      ++m_returns;
+      m_returned.notify_all();
+    }
+  }
+}
+
+
+void pqxx::connection_pool::top_up()
+{
+  if (m_config.min_idle == 0)
+    return;
+  auto const idle_now{idle()};
+  std::size_t count;
+  {
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    if (idle_now >= m_config.min_idle)
+      return;
+    count = std::min(m_config.min_idle - idle_now, m_config.max_size - m_open);
+    // Reserve the slots, but don't hold the lock while connecting.
+    m_open += count;
+  }
+  if (count == 0)
+    return;
+
+  std::vector<idle_connection> fresh;
+  fresh.reserve(count);
+  try
+  {
+    // After a failover, this may be a lot of connections.  Open them all in
+    // parallel.
+    auto conns{connect_all(zview{m_options}, count)};
+    for (auto &c : conns)
+    {
+      auto conn{std::make_unique<connection>(std::move(c))};
+      auto const num_prepared{prepare_missing(*conn, 0)};
+      auto const now{clock::now()};
+      fresh.push_back(
+        idle_connection{std::move(conn), num_prepared, now, now});
+    }
+  }
+  catch (std::exception const &)
+  {
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    m_open -= count;
+    ++m_returns;
+    m_returned.notify_all();
+    throw;
+  }
+
+  // Spread them out over the shards.
+  std::vector<idle_connection> batch;
+  for (std::size_t i{0}; i < std::size(m_shards); ++i)
+  {
+    for (auto j{i}; j < std::size(fresh); j += std::size(m_shards))
+      batch.push_back(std::move(fresh[j]));
+    restore(m_shards[i], batch);
+  }
+
+  std::lock_guard<std::mutex> const lock{m_mutex};
+  ++m_returns;
+  m_returned.notify_all();
+}
+
+
+void pqxx::connection_pool::maintenance_loop() noexcept
+{
+  std::unique_lock<std::mutex> lock{m_mutex};
+  while (not m_stopping)
+  {
+    lock.unlock();
+    try
+    {
+      maintain();
+    }
+    catch (std::exception const &)
+    {
+      // Try again next round.
+    }
+    lock.lock();
+    // No predicate: a wakeup, e.g. because get() found a broken connection,
+    // means it's time for another round.
+    if (not m_stopping)
+      m_wake.wait_for(lock, m_config.maintenance_interval);
+  }
+}
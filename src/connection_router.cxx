@@ -0,0 +1,270 @@
+/** Implementation of the pqxx::connection_router class.
+ *
+ * pqxx::connection_router sends read-only work to replicas.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <thread>
+
+#include "pqxx/connection_router"
+#include "pqxx/except"
+#include "pqxx/nontransaction"
+#include "pqxx/replication_stream"
+
+
+namespace
+{
+/// Pool settings for a replica: like the primary's, but connect lazily.
+pqxx::connection_pool_config
+replica_config(pqxx::connection_pool_config config) noexcept
+{
+  config.min_size = 0;
+  return config;
+}
+
+
+/// How far the server has replayed the write-ahead log, as text.
+/** A server that's not a replica has everything that was ever committed on
+ * it, so for that we take its current position.
+ */
+constexpr std::string_view replayed_lsn{
+  "COALESCE(CASE WHEN pg_catalog.pg_is_in_recovery() "
+  "THEN pg_catalog.pg_last_wal_replay_lsn() "
+  "ELSE pg_catalog.pg_current_wal_insert_lsn() END, '0/0')::text"};
+} // namespace
+
+
+/// A replica's pool, and what we know about it.
+struct pqxx::connection_router::replica_state
+{
+  replica_state(std::string options, connection_pool_config const &config) :
+          pool{options, replica_config(config)}
+  {
+    status.options = std::move(options);
+  }
+
+  connection_pool pool;
+  /// Protected by the router's mutex.
+  replica_status status;
+  /// Have we measured the latency yet?
+  bool measured = false;
+  /// When connecting to this replica last failed.
+  std::chrono::steady_clock::time_point down_since;
+};
+
+
+pqxx::connection_router::connection_router(
+  std::string primary, std::vector<std::string> const &replicas,
+  connection_router_config const &config) :
+        m_config{config}, m_primary{std::move(primary), config.pool}
+{
+  m_replicas.reserve(std::size(replicas));
+  for (auto const &options : replicas)
+    m_replicas.push_back(
+      std::make_unique<replica_state>(options, config.pool));
+}
+
+
+pqxx::connection_router::~connection_router() noexcept = default;
+
+
+pqxx::pooled_connection pqxx::connection_router::primary()
+{
+  return m_primary.get();
+}
+
+
+pqxx::pooled_connection pqxx::connection_router::replica()
+{
+  probe_if_due();
+  for (auto const state : candidates()) try
+    {
+      return state->pool.get();
+    }
+    catch (failure const &)
+    {
+      // Down, or too busy to hand out a connection.  Try the next one.
+      mark_down(*state);
+    }
+  return primary();
+}
+
+
+pqxx::pooled_connection pqxx::connection_router::replica(lsn commit)
+{
+  if (commit == 0)
+    return replica();
+
+  probe_if_due();
+  auto const fit{candidates()};
+  for (auto const state : fit)
+  {
+    {
+      std::lock_guard const lock{m_mutex};
+      if (state->status.replayed < commit)
+        continue;
+    }
+    try
+    {
+      return state->pool.get();
+    }
+    catch (failure const &)
+    {
+      mark_down(*state);
+    }
+  }
+
+  // No replica is known to have the commit.  Give the best one a moment.
+  if (m_config.causal_wait.count() > 0)
+    for (auto const state : fit) try
+      {
+        auto conn{state->pool.get()};
+        if (catch_up(*state, *conn, commit))
+          return conn;
+        break;
+      }
+      catch (failure const &)
+      {
+        mark_down(*state);
+      }
+  return primary();
+}
+
+
+void pqxx::connection_router::probe()
+{
+  for (auto const &state : m_replicas) probe(*state);
+  std::lock_guard const lock{m_mutex};
+  m_last_probe = std::chrono::steady_clock::now();
+}
+
+
+std::vector<pqxx::connection_router::replica_status>
+pqxx::connection_router::replicas() const
+{
+  std::lock_guard const lock{m_mutex};
+  std::vector<replica_status> statuses;
+  statuses.reserve(std::size(m_replicas));
+  for (auto const &state : m_replicas) statuses.push_back(state->status);
+  return statuses;
+}
+
+
+void pqxx::connection_router::probe_if_due()
+{
+  {
+    std::lock_guard const lock{m_mutex};
+    if (
+      m_probing or
+      (m_last_probe and std::chrono::steady_clock::now() - *m_last_probe <
+                          m_config.probe_interval))
+      return;
+    m_probing = true;
+  }
+  // The probe itself never throws; it marks replicas as down instead.
+  probe();
+  std::lock_guard const lock{m_mutex};
+  m_probing = false;
+}
+
+
+void pqxx::connection_router::probe(replica_state &state)
+{
+  using clock = std::chrono::steady_clock;
+  {
+    std::lock_guard const lock{m_mutex};
+    if (
+      not state.status.up and
+      clock::now() - state.down_since < m_config.retry_interval)
+      return;
+  }
+
+  try
+  {
+    auto conn{state.pool.get()};
+    nontransaction tx{*conn};
+    auto const start{clock::now()};
+    static std::string const query{
+      "SELECT CASE WHEN pg_catalog.pg_is_in_recovery() THEN "
+      "COALESCE(EXTRACT(EPOCH FROM "
+      "clock_timestamp() - pg_catalog.pg_last_xact_replay_timestamp()), 0) "
+      "ELSE 0 END, " +
+      std::string{replayed_lsn}};
+    auto const row{tx.exec1(query)};
+    auto const latency{
+      std::chrono::duration_cast<std::chrono::microseconds>(
+        clock::now() - start)};
+    auto const lag{row[0].as<double>()};
+    auto const replayed{parse_lsn(row[1].view())};
+
+    std::lock_guard const lock{m_mutex};
+    state.status.up = true;
+    state.status.replayed = std::max(state.status.replayed, replayed);
+    state.status.lag = std::chrono::milliseconds{
+      static_cast<std::chrono::milliseconds::rep>(lag * 1000)};
+    state.status.latency =
+      state.measured ? (3 * state.status.latency + latency) / 4 : latency;
+    state.measured = true;
+  }
+  catch (std::exception const &)
+  {
+    mark_down(state);
+  }
+}
+
+
+std::vector<pqxx::connection_router::replica_state *>
+pqxx::connection_router::candidates() const
+{
+  std::vector<replica_state *> fit;
+  std::lock_guard const lock{m_mutex};
+  for (auto const &state : m_replicas)
+    if (state->status.up and state->status.lag <= m_config.max_lag)
+      fit.push_back(state.get());
+  std::stable_sort(
+    std::begin(fit), std::end(fit),
+    [](replica_state const *lhs, replica_state const *rhs) {
+      return lhs->status.latency < rhs->status.latency;
+    });
+  return fit;
+}
+
+
+bool pqxx::connection_router::catch_up(
+  replica_state &state, connection &cx, lsn commit)
+{
+  using clock = std::chrono::steady_clock;
+  auto const deadline{clock::now() + m_config.causal_wait};
+  auto delay{std::chrono::microseconds{500}};
+  for (;;)
+  {
+    static std::string const query{"SELECT " + std::string{replayed_lsn}};
+    nontransaction tx{cx};
+    auto const replayed{parse_lsn(tx.query_value<std::string>(query))};
+    {
+      std::lock_guard const lock{m_mutex};
+      state.status.replayed = std::max(state.status.replayed, replayed);
+    }
+    if (replayed >= commit)
+      return true;
+    if (clock::now() + delay > deadline)
+      return false;
+    std::this_thread::sleep_for(delay);
+    delay = std::min(delay * 2, std::chrono::microseconds{4000});
+  }
+}
+
+
+void pqxx::connection_router::mark_down(replica_state &state)
+{
+  std::lock_guard const lock{m_mutex};
+  state.status.up = false;
+  state.down_since = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,325 @@
+/** Implementation of the pqxx::csv_loader class.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "pqxx/csv_loader"
+#include "pqxx/except"
+
+#include "pqxx/internal/gates/stream_to-csv_loader.hxx"
+#include "pqxx/internal/mapped_file.hxx"
+
+
+namespace
+{
+/// Split @c data into chunks of about @c chunk_size, at record boundaries.
+/** We start outside quotes, and every quote character toggles that state:
+ * quotes only occur around quoted fields, and doubled inside them.  So the
+ * number of quotes before a point in a chunk tells us whether we're inside
+ * a quoted field there.  Counting them is a lot cheaper than parsing.
+ */
+std::vector<std::string_view>
+split_chunks(std::string_view data, std::size_t chunk_size, char quote)
+{
+  std::vector<std::string_view> chunks;
+  std::size_t start{0};
+  while (start < std::size(data))
+  {
+    auto stop{std::min(start + chunk_size, std::size(data))};
+    bool quoted{
+      std::count(
+        std::begin(data) + static_cast<std::ptrdiff_t>(start),
+        std::begin(data) + static_cast<std::ptrdiff_t>(stop), quote) %
+        2 !=
+      0};
+    // Extend the chunk to the end of the record.
+    for (; stop < std::size(data); ++stop)
+    {
+      if (data[stop] == quote)
+      {
+        quoted = not quoted;
+      }
+      else if (data[stop] == '\n' and not quoted)
+      {
+        ++stop;
+        break;
+      }
+    }
+    chunks.push_back(data.substr(start, stop - start));
+    start = stop;
+  }
+  return chunks;
+}
+
+
+/// Undo the doubling of quotes in quoted fields, into @c workspace.
+void unquote_fields(
+  std::vector<pqxx::internal::csv_field> &fields, char quote,
+  std::string &workspace)
+{
+  auto const needs_work{[quote](pqxx::internal::csv_field const &f) {
+    return f.quoted and f.text.find(quote) != std::string_view::npos;
+  }};
+  std::size_t total{0};
+  for (auto const &f : fields)
+    if (needs_work(f))
+      total += std::size(f.text);
+  if (total == 0)
+    return;
+
+  // Reserve all the space up front, so the views into it stay valid.
+  workspace.clear();
+  workspace.reserve(total);
+  for (auto &f : fields)
+  {
+    if (not needs_work(f))
+      continue;
+    auto const start{std::size(workspace)};
+    for (std::size_t i{0}; i < std::size(f.text); ++i)
+    {
+      workspace.push_back(f.text[i]);
+      // The parser already checked that quotes come in pairs.
+      if (f.text[i] == quote)
+        ++i;
+    }
+    f.text = std::string_view{
+      std::data(workspace) + start, std::size(workspace) - start};
+  }
+}
+} // namespace
+
+
+bool pqxx::internal::next_csv_record(
+  std::string_view data, std::size_t &here, csv_options const &options,
+  std::vector<csv_field> &fields, std::string &workspace)
+{
+  fields.clear();
+  auto const size{std::size(data)};
+  if (here >= size)
+    return false;
+
+  auto const delimiter{options.delimiter}, quote{options.quote};
+  for (;;)
+  {
+    if (here < size and data[here] == quote)
+    {
+      // Quoted field: runs up to a quote that is not doubled.
+      auto const start{++here};
+      for (;;)
+      {
+        auto const end{data.find(quote, here)};
+        if (end == std::string_view::npos)
+          throw conversion_error{"Unterminated quoted field in CSV."};
+        here = end + 1;
+        if (here < size and data[here] == quote)
+        {
+          ++here;
+          continue;
+        }
+        fields.push_back({data.substr(start, end - start), true});
+        break;
+      }
+    }
+    else
+    {
+      // Unquoted field: runs up to a delimiter or newline.
+      auto end{here};
+      for (; end < size and data[end] != delimiter and data[end] != '\n';
+           ++end)
+        if (data[end] == quote)
+          throw conversion_error{"Quote in unquoted CSV field."};
+      auto text{data.substr(here, end - here)};
+      if (
+        (end == size or data[end] == '\n') and not text.empty() and
+        text.back() == '\r')
+        text.remove_suffix(1);
+      fields.push_back({text, false});
+      here = end;
+    }
+
+    // What comes after a field: another field, or the end of the record.
+    if (here >= size)
+      break;
+    char const next{data[here]};
+    if (next == delimiter)
+    {
+      ++here;
+    }
+    else if (next == '\n')
+    {
+      ++here;
+      break;
+    }
+    else if (next == '\r' and here + 1 < size and data[here + 1] == '\n')
+    {
+      here += 2;
+      break;
+    }
+    else
+    {
+      throw conversion_error{"Unexpected text after quoted CSV field."};
+    }
+  }
+
+  unquote_fields(fields, quote, workspace);
+  return true;
+}
+
+
+pqxx::csv_loader::csv_loader(stream_to &target, csv_options const &options) :
+        csv_loader{std::vector<stream_to *>{&target}, options}
+{}
+
+
+pqxx::csv_loader::csv_loader(
+  std::vector<stream_to *> targets, csv_options const &options) :
+        m_targets{std::move(targets)}, m_options{options}
+{
+  if (m_targets.empty())
+    throw usage_error{"A csv_loader needs at least one stream to write to."};
+  for (auto const *target : m_targets)
+    if (target == nullptr or target->data_format() != format::text)
+      throw usage_error{"A csv_loader can only write to text-format streams."};
+  if (m_options.chunk_size == 0)
+    throw usage_error{"A csv_loader needs a nonzero chunk size."};
+}
+
+
+std::size_t
+pqxx::csv_loader::run(std::string_view path, internal::csv_encoder encode)
+{
+  internal::mapped_file const file{std::string{path}};
+  auto data{file.data()};
+  if (m_options.header)
+  {
+    std::vector<internal::csv_field> fields;
+    std::string workspace;
+    std::size_t here{0};
+    internal::next_csv_record(data, here, m_options, fields, workspace);
+    data.remove_prefix(here);
+  }
+
+  auto const chunks{
+    split_chunks(data, m_options.chunk_size, m_options.quote)};
+  if (chunks.empty())
+    return 0;
+  std::size_t threads{m_options.threads};
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, std::size(chunks));
+
+  // Converted chunks, waiting to be sent.  Chunk i goes into slot i % window.
+  // Keeping their number limited also limits how far ahead of the streams
+  // the threads can get, and so how much memory they take.
+  struct slot
+  {
+    std::string out;
+    std::size_t records = 0;
+    std::exception_ptr error;
+    bool ready = false;
+  };
+  std::size_t const window{2 * threads};
+  std::vector<slot> slots(window);
+  std::mutex lock;
+  std::condition_variable changed;
+  std::size_t next_chunk{0}, next_send{0};
+  bool cancelled{false};
+
+  auto const work{[&] {
+    for (;;)
+    {
+      std::unique_lock<std::mutex> guard{lock};
+      auto const index{next_chunk};
+      if (index >= std::size(chunks))
+        return;
+      ++next_chunk;
+      changed.wait(
+        guard, [&] { return cancelled or index < next_send + window; });
+      if (cancelled)
+        return;
+      guard.unlock();
+
+      // Until it's ready, only this thread touches this slot.
+      auto &s{slots[index % window]};
+      try
+      {
+        encode(chunks[index], m_options, s.out, s.records);
+      }
+      catch (...)
+      {
+        s.error = std::current_exception();
+      }
+      guard.lock();
+      s.ready = true;
+      changed.notify_all();
+    }
+  }};
+
+  std::vector<std::thread> pool;
+  auto const stop{[&]() noexcept {
+    {
+      std::lock_guard<std::mutex> guard{lock};
+      cancelled = true;
+      changed.notify_all();
+    }
+    for (auto &t : pool) t.join();
+  }};
+
+  std::size_t total{0};
+  try
+  {
+    pool.reserve(threads);
+    for (std::size_t i{0}; i < threads; ++i) pool.emplace_back(work);
+
+    for (std::size_t index{0}; index < std::size(chunks); ++index)
+    {
+      auto &s{slots[index % window]};
+      {
+        std::unique_lock<std::mutex> guard{lock};
+        changed.wait(guard, [&s] { return s.ready; });
+      }
+      if (s.error)
+      {
+        try
+        {
+          std::rethrow_exception(s.error);
+        }
+        catch (conversion_error const &e)
+        {
+          throw conversion_error{
+            "CSV record " + to_string(total + s.records + 1) + ": " +
+            e.what()};
+        }
+      }
+      internal::gate::stream_to_csv_loader{
+        *m_targets[index % std::size(m_targets)]}
+        .send_raw_data(s.out);
+      total += s.records;
+
+      s.out.clear();
+      s.records = 0;
+      s.ready = false;
+      std::lock_guard<std::mutex> guard{lock};
+      ++next_send;
+      changed.notify_all();
+    }
+  }
+  catch (...)
+  {
+    stop();
+    throw;
+  }
+  stop();
+  return total;
+}
@@ -10,6 +10,7 @@
  */
 #include "pqxx-source.hxx"
 
+#include <algorithm>
 #include <iterator>
 
 #include "pqxx/cursor"
@@ -73,6 +74,71 @@ pqxx::result pqxx::internal::stateless_cursor_retrieve(
 }
 
 
+pqxx::internal::stateless_cursor_cache::stateless_cursor_cache(
+  difference_type block_rows, std::size_t max_blocks) :
+        m_block_rows{block_rows},
+        m_max_blocks{std::max(max_blocks, std::size_t{1})}
+{
+  if (m_block_rows <= 0)
+    throw argument_error{"Cursor cache needs a positive block size."};
+}
+
+
+pqxx::result const *
+pqxx::internal::stateless_cursor_cache::find(difference_type block) noexcept
+{
+  auto const here{std::find_if(
+    std::begin(m_blocks), std::end(m_blocks),
+    [block](auto const &entry) { return entry.first == block; })};
+  if (here == std::end(m_blocks))
+    return nullptr;
+  m_blocks.splice(std::begin(m_blocks), m_blocks, here);
+  return &m_blocks.front().second;
+}
+
+
+void pqxx::internal::stateless_cursor_cache::store(
+  difference_type block, result const &rows)
+{
+  if (std::size(m_blocks) >= m_max_blocks)
+    m_blocks.pop_back();
+  m_blocks.emplace_front(block, rows);
+}
+
+
+pqxx::result pqxx::internal::stateless_cursor_cache::retrieve(
+  sql_cursor &cur, difference_type size, difference_type begin_pos,
+  difference_type end_pos)
+{
+  // Is this request for exactly one block?  The last block may be short.
+  bool const whole_block{
+    begin_pos >= 0 and begin_pos < size and begin_pos % m_block_rows == 0 and
+    end_pos == std::min(begin_pos + m_block_rows, size)};
+  if (not whole_block)
+    return stateless_cursor_retrieve(cur, size, begin_pos, end_pos);
+
+  auto const block{begin_pos / m_block_rows};
+  auto const last{(size - 1) / m_block_rows};
+  bool const backwards{block < m_last_block};
+  m_last_block = block;
+  if (auto const cached{find(block)}; cached != nullptr)
+    return *cached;
+
+  // Read ahead one block in the direction we're going, if there is one.
+  auto const ahead{backwards ? (block - 1) : (block + 1)};
+  std::vector<std::pair<difference_type, difference_type>> ranges{
+    {begin_pos, m_block_rows}};
+  if (ahead >= 0 and ahead <= last and find(ahead) == nullptr)
+    ranges.emplace_back(ahead * m_block_rows, m_block_rows);
+  auto const blocks{cur.fetch_ranges(ranges)};
+
+  if (std::size(blocks) > 1)
+    store(ahead, blocks[1]);
+  store(block, blocks[0]);
+  return blocks[0];
+}
+
+
 pqxx::icursorstream::icursorstream(
   transaction_base &context, std::string_view query, std::string_view basename,
   difference_type sstride) :
@@ -83,6 +149,7 @@ pqxx::icursorstream::icursorstream(
               cursor_base::read_only,
               cursor_base::owned,
               false},
+        m_ahead{context, m_cur},
         m_stride{sstride},
         m_realpos{0},
         m_reqpos{0},
@@ -97,6 +164,7 @@ pqxx::icursorstream::icursorstream(
   transaction_base &context, field const &cname, difference_type sstride,
   cursor_base::ownership_policy op) :
         m_cur{context, cname.c_str(), op},
+        m_ahead{context, m_cur},
         m_stride{sstride},
         m_realpos{0},
         m_reqpos{0},
@@ -113,21 +181,95 @@ void pqxx::icursorstream::set_stride(difference_type stride)
     throw argument_error{"Attempt to set cursor stride to " +
                          to_string(stride)};
   m_stride = stride;
+  m_adaptive.reset();
+}
+
+
+void pqxx::icursorstream::set_stride(adaptive_stride const &policy)
+{
+  if (policy.min_stride < 1 or policy.max_stride < policy.min_stride)
+    throw argument_error{
+      "Bad adaptive cursor stride range: " + to_string(policy.min_stride) +
+      " to " + to_string(policy.max_stride) + "."};
+  if (policy.block_bytes == 0)
+    throw argument_error{"Adaptive cursor stride needs a block size."};
+  m_adaptive = policy;
+  m_stride = std::clamp(m_stride, policy.min_stride, policy.max_stride);
+}
+
+
+void pqxx::icursorstream::adapt_stride(
+  result const &block, std::chrono::steady_clock::duration elapsed)
+{
+  auto const &policy{*m_adaptive};
+  auto const rows{static_cast<double>(std::size(block))};
+  m_sampled_rows += rows;
+  m_sampled_bytes += static_cast<double>(block.memory_usage());
+  double target{
+    static_cast<double>(policy.block_bytes) * m_sampled_rows /
+    std::max(m_sampled_bytes, 1.0)};
+
+  if (elapsed.count() > 0)
+  {
+    m_timed_rows += rows;
+    m_timed += elapsed;
+  }
+  if (policy.max_latency.count() > 0 and m_timed.count() > 0)
+    target = std::min(
+      target, std::chrono::duration<double>{policy.max_latency}.count() *
+                m_timed_rows / m_timed.count());
+
+  // Convert carefully: the target may be larger than any stride.
+  m_stride =
+    (target >= static_cast<double>(policy.max_stride)) ?
+      policy.max_stride :
+      std::max(policy.min_stride, static_cast<difference_type>(target));
 }
 
 
 pqxx::result pqxx::icursorstream::fetchblock()
 {
-  result const r{m_cur.fetch(m_stride)};
+  using clock = std::chrono::steady_clock;
+  bool const prefetched{m_ahead.pending()};
+  auto const requested{prefetched ? m_ahead.rows() : m_stride};
+  auto const start{clock::now()};
+  result const r{prefetched ? m_ahead.finish() : m_cur.fetch(m_stride)};
   m_realpos += r.size();
   if (r.empty())
+  {
     m_done = true;
+    return r;
+  }
+
+  if (m_adaptive)
+    adapt_stride(
+      r, prefetched ? clock::duration::zero() : (clock::now() - start));
+  // A short block means we've hit the end.  Only go looking for more rows if
+  // there may be some.
+  if (m_prefetch and r.size() >= requested)
+    m_ahead.start(m_stride);
   return r;
 }
 
 
 pqxx::icursorstream &pqxx::icursorstream::ignore(std::streamsize n)
 {
+  if (m_ahead.pending())
+  {
+    // We can't skip rows without also skipping the ones before them.
+    if (n < m_ahead.rows())
+      throw usage_error{
+        "Can't ignore " + to_string(n) + " rows in icursorstream while a " +
+        to_string(m_ahead.rows()) + "-row block is in flight."};
+    auto const block{static_cast<difference_type>(m_ahead.finish().size())};
+    m_realpos += block;
+    if (block < m_ahead.rows())
+    {
+      m_done = true;
+      return *this;
+    }
+    n -= block;
+  }
   auto offset{m_cur.move(difference_type(n))};
   m_realpos += offset;
   if (offset < n)
@@ -136,6 +278,46 @@ pqxx::icursorstream &pqxx::icursorstream::ignore(std::streamsize n)
 }
 
 
+pqxx::internal::cursor_prefetch::~cursor_prefetch() noexcept
+{
+  if (pending())
+  {
+    // The connection can't do anything else until we've read the rows.
+    try
+    {
+      finish();
+    }
+    catch (std::exception const &)
+    {}
+  }
+}
+
+
+void pqxx::internal::cursor_prefetch::start(difference_type rows)
+{
+  register_me();
+  try
+  {
+    m_cur.start_fetch(rows);
+  }
+  catch (std::exception const &)
+  {
+    unregister_me();
+    throw;
+  }
+  m_rows = rows;
+}
+
+
+pqxx::result pqxx::internal::cursor_prefetch::finish()
+{
+  // Whatever happens, the FETCH is no longer in flight.
+  unregister_me();
+  difference_type displacement{0};
+  return m_cur.finish_fetch(m_rows, displacement);
+}
+
+
 pqxx::icursorstream::size_type pqxx::icursorstream::forward(size_type n)
 {
   m_reqpos += difference_type(n) * m_stride;
@@ -0,0 +1,272 @@
+/** Implementation of the pqxx::decimal conversions.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <limits>
+
+#include "pqxx/decimal"
+#include "pqxx/except"
+
+
+namespace
+{
+constexpr std::uint64_t uint64_max{std::numeric_limits<std::uint64_t>::max()};
+
+/// Largest magnitude of a negative @c int64_t, as an unsigned value.
+constexpr std::uint64_t negative_max{std::uint64_t{1} << 63};
+
+
+/// Powers of ten, for as far as they fit in 64 bits.
+constexpr std::uint64_t pow10[]{1ULL,
+                                10ULL,
+                                100ULL,
+                                1'000ULL,
+                                10'000ULL,
+                                100'000ULL,
+                                1'000'000ULL,
+                                10'000'000ULL,
+                                100'000'000ULL,
+                                1'000'000'000ULL,
+                                10'000'000'000ULL,
+                                100'000'000'000ULL,
+                                1'000'000'000'000ULL,
+                                10'000'000'000'000ULL,
+                                100'000'000'000'000ULL,
+                                1'000'000'000'000'000ULL,
+                                10'000'000'000'000'000ULL,
+                                100'000'000'000'000'000ULL,
+                                1'000'000'000'000'000'000ULL,
+                                10'000'000'000'000'000'000ULL};
+
+
+// Sign words in binary numeric.
+constexpr std::uint16_t numeric_pos{0x0000}, numeric_neg{0x4000};
+
+
+[[noreturn]] void out_of_range()
+{
+  throw pqxx::range_error{"Numeric value out of range for decimal."};
+}
+
+
+/// Compute @c a * @c b + @c c, throwing @c range_error on overflow.
+std::uint64_t
+multiply_add(std::uint64_t a, std::uint64_t b, std::uint64_t c = 0)
+{
+  if (b != 0 and a > (uint64_max - c) / b)
+    out_of_range();
+  return a * b + c;
+}
+
+
+/// Apply a sign to a magnitude, checking that it fits in @c int64_t.
+std::int64_t signed_value(std::uint64_t magnitude, bool negative)
+{
+  if (negative)
+  {
+    if (magnitude > negative_max)
+      out_of_range();
+    return static_cast<std::int64_t>(0u - magnitude);
+  }
+  if (magnitude >= negative_max)
+    out_of_range();
+  return static_cast<std::int64_t>(magnitude);
+}
+
+
+/// Unsigned magnitude of @c units.
+constexpr std::uint64_t magnitude_of(std::int64_t units) noexcept
+{
+  auto const bits{static_cast<std::uint64_t>(units)};
+  return (units < 0) ? 0u - bits : bits;
+}
+
+
+/// Write @c magnitude's decimal digits, most significant first.
+/** Returns the number of digits: at least 1.
+ */
+int digits_of(std::uint64_t magnitude, char (&digits)[20]) noexcept
+{
+  char reversed[20];
+  int len{0};
+  do
+  {
+    reversed[len++] = static_cast<char>(magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0);
+  for (int i{0}; i < len; ++i) digits[i] = reversed[len - 1 - i];
+  return len;
+}
+
+
+/// Round down to a multiple of 4, then divide by 4.
+constexpr int floor_div4(int value) noexcept
+{
+  return (value >= 0) ? (value / 4) : -((3 - value) / 4);
+}
+} // namespace
+
+
+std::int64_t pqxx::internal::parse_decimal(std::string_view text, int scale)
+{
+  auto const fail{[text] {
+    throw conversion_error{
+      "Could not convert '" + std::string{text} + "' to decimal."};
+  }};
+
+  std::size_t here{0};
+  bool const negative{not text.empty() and text[0] == '-'};
+  if (negative or (not text.empty() and text[0] == '+'))
+    ++here;
+
+  std::uint64_t magnitude{0};
+  bool point{false};
+  int digits{0}, fraction{0};
+  for (; here < text.size(); ++here)
+  {
+    char const c{text[here]};
+    if (c == '.' and not point)
+    {
+      point = true;
+      continue;
+    }
+    if (c < '0' or c > '9')
+      fail();
+    ++digits;
+    if (point)
+    {
+      if (fraction == scale)
+      {
+        // Trailing zeroes beyond the scale are harmless.
+        if (c != '0')
+          throw conversion_error{
+            "Value '" + std::string{text} + "' has more than " +
+            to_string(scale) + " digit(s) after the decimal point."};
+        continue;
+      }
+      ++fraction;
+    }
+    magnitude = multiply_add(magnitude, 10, static_cast<unsigned>(c - '0'));
+  }
+  if (digits == 0)
+    fail();
+
+  magnitude = multiply_add(magnitude, pow10[scale - fraction]);
+  return signed_value(magnitude, negative);
+}
+
+
+char *pqxx::internal::write_decimal(
+  char *begin, char *end, std::int64_t units, int scale)
+{
+  if (end - begin < 23)
+    throw conversion_overrun{
+      "Not enough buffer space to write decimal.  " +
+      state_buffer_overrun(end - begin, 23)};
+
+  char digits[20];
+  auto len{digits_of(magnitude_of(units), digits)};
+
+  char *here{begin};
+  if (units < 0)
+    *here++ = '-';
+  // Digits before the decimal point; at least a zero.
+  auto const whole{len - scale};
+  if (whole <= 0)
+    *here++ = '0';
+  for (int i{0}; i < whole; ++i) *here++ = static_cast<char>('0' + digits[i]);
+  if (scale > 0)
+  {
+    *here++ = '.';
+    for (int i{whole}; i < 0; ++i) *here++ = '0';
+    for (int i{std::max(whole, 0)}; i < len; ++i)
+      *here++ = static_cast<char>('0' + digits[i]);
+  }
+  *here++ = '\0';
+  return here;
+}
+
+
+std::int64_t
+pqxx::internal::decimal_from_binary(std::string_view data, int scale)
+{
+  if (data.size() < 8)
+    throw_binary_size_mismatch("numeric", data.size());
+  auto const ndigits{from_big_endian<std::int16_t>(data.data())};
+  auto const weight{from_big_endian<std::int16_t>(data.data() + 2)};
+  auto const sign{from_big_endian<std::uint16_t>(data.data() + 4)};
+  if (ndigits < 0 or data.size() != 8u + 2u * static_cast<unsigned>(ndigits))
+    throw_binary_size_mismatch("numeric", data.size());
+  if (sign != numeric_pos and sign != numeric_neg)
+    throw conversion_error{"Numeric NaN or infinity has no decimal value."};
+
+  std::uint64_t magnitude{0};
+  for (int i{0}; i < ndigits; ++i)
+  {
+    auto const digit{from_big_endian<std::uint16_t>(data.data() + 8 + 2 * i)};
+    if (digit > 9999)
+      throw conversion_error{"Invalid digit in binary numeric."};
+    if (digit == 0)
+      continue;
+    // This digit stands for digit * 10^exponent units.
+    auto const exponent{4 * (weight - i) + scale};
+    if (exponent >= 0)
+    {
+      if (exponent >= static_cast<int>(std::size(pow10)))
+        out_of_range();
+      magnitude = multiply_add(digit, pow10[exponent], magnitude);
+    }
+    else
+    {
+      auto const divisor{exponent <= -4 ? 10000u : pow10[-exponent]};
+      if (digit % divisor != 0)
+        throw conversion_error{
+          "Numeric value has more than " + to_string(scale) +
+          " digit(s) after the decimal point."};
+      magnitude = multiply_add(1, digit / divisor, magnitude);
+    }
+  }
+  return signed_value(magnitude, sign == numeric_neg);
+}
+
+
+char *pqxx::internal::decimal_into_binary(
+  char *begin, char *end, std::int64_t units, int scale)
+{
+  // Base-10000 digits, most significant first.
+  std::uint16_t groups[7]{};
+  int ngroups{0}, weight{0};
+  if (units != 0)
+  {
+    char digits[20];
+    auto const len{digits_of(magnitude_of(units), digits)};
+    // Digit i stands for digits[i] * 10^(len - 1 - i - scale).
+    auto const top{len - 1 - scale};
+    weight = floor_div4(top);
+    for (int i{0}; i < len; ++i)
+    {
+      auto const exponent{top - i};
+      auto const group{floor_div4(exponent)};
+      groups[weight - group] = static_cast<std::uint16_t>(
+        groups[weight - group] + digits[i] * pow10[exponent - 4 * group]);
+    }
+    ngroups = weight - floor_div4(top - (len - 1)) + 1;
+    while (groups[ngroups - 1] == 0) --ngroups;
+  }
+
+  auto const size{8 + 2 * static_cast<std::size_t>(ngroups)};
+  check_binary_space(begin, end, size, "numeric");
+  auto here{into_big_endian(begin, static_cast<std::int16_t>(ngroups))};
+  here = into_big_endian(here, static_cast<std::int16_t>(weight));
+  here = into_big_endian(here, (units < 0) ? numeric_neg : numeric_pos);
+  here = into_big_endian(here, static_cast<std::int16_t>(scale));
+  for (int i{0}; i < ngroups; ++i) here = into_big_endian(here, groups[i]);
+  return here;
+}
@@ -8,6 +8,7 @@
  */
 #include "pqxx-source.hxx"
 
+#include <cstdint>
 #include <cstring>
 #include <iomanip>
 #include <map>
@@ -158,26 +159,6 @@ std::string::size_type next_seq_for_sjislike(
 // Implement template specializations first.
 namespace pqxx::internal
 {
-template<encoding_group> struct glyph_scanner
-{
-  static std::string::size_type call(
-    char const buffer[], std::string::size_type buffer_len,
-    std::string::size_type start);
-};
-
-template<> struct glyph_scanner<encoding_group::MONOBYTE>
-{
-  static constexpr std::string::size_type call(
-    char const /* buffer */[], std::string::size_type buffer_len,
-    std::string::size_type start) noexcept
-  {
-    if (start >= buffer_len)
-      return std::string::npos;
-    else
-      return start + 1;
-  }
-};
-
 // https://en.wikipedia.org/wiki/Big5#Organization
 template<>
 std::string::size_type glyph_scanner<encoding_group::BIG5>::call(
@@ -523,18 +504,11 @@ std::string::size_type glyph_scanner<encoding_group::UHC>::call(
 }
 
 // https://en.wikipedia.org/wiki/UTF-8#Description
-template<>
-std::string::size_type glyph_scanner<encoding_group::UTF8>::call(
+std::string::size_type glyph_scanner<encoding_group::UTF8>::call_multibyte(
   char const buffer[], std::string::size_type buffer_len,
   std::string::size_type start)
 {
-  if (start >= buffer_len)
-    return std::string::npos;
-
   auto const byte1{get_byte(buffer, start)};
-  if (byte1 < 0x80)
-    return start + 1;
-
   if (start + 2 > buffer_len)
     throw_for_encoding_error("UTF8", buffer, start, buffer_len - start);
 
@@ -687,20 +661,123 @@ glyph_scanner_func *get_glyph_scanner(encoding_group enc)
 }
 
 
+/// Find a character, going through the text glyph by glyph.
+template<encoding_group E>
+constexpr std::string::size_type find_char_by_glyph(
+  std::string_view haystack, char needle, std::string::size_type start)
+{
+  auto const buffer{haystack.data()};
+  auto const size{haystack.size()};
+  for (auto here{start}; here + 1 <= size;
+       here = glyph_scanner<E>::call(buffer, size, here))
+  {
+    if (haystack[here] == needle)
+      return here;
+  }
+  return std::string::npos;
+}
+
+
+/// Find a string, going through the text glyph by glyph.
+template<encoding_group E>
+std::string::size_type find_string_by_glyph(
+  std::string_view haystack, std::string_view needle,
+  std::string::size_type start)
+{
+  auto const buffer{haystack.data()};
+  auto const size{haystack.size()};
+  auto const needle_size{needle.size()};
+  for (auto here{start}; here + needle_size <= size;
+       here = glyph_scanner<E>::call(buffer, size, here))
+  {
+    if (std::memcmp(buffer + here, needle.data(), needle_size) == 0)
+      return here;
+  }
+  return std::string::npos;
+}
+
+
 template<encoding_group E> struct char_finder
 {
   constexpr static std::string::size_type
   call(std::string_view haystack, char needle, std::string::size_type start)
   {
-    auto const buffer{haystack.data()};
-    auto const size{haystack.size()};
-    for (auto here{start}; here + 1 <= size;
-         here = glyph_scanner<E>::call(buffer, size, here))
-    {
-      if (haystack[here] == needle)
-        return here;
-    }
-    return std::string::npos;
+    return find_char_by_glyph<E>(haystack, needle, start);
+  }
+};
+
+
+/// Skip past a run of ASCII bytes, 8 at a time.
+/** Returns the offset of the first non-ASCII byte at or after @c here, or
+ * @c end if there is none.
+ */
+inline std::string::size_type skip_ascii(
+  char const buffer[], std::string::size_type here,
+  std::string::size_type end) noexcept
+{
+  constexpr std::uint64_t high_bits{0x8080808080808080};
+  for (; here + 8 <= end; here += 8)
+  {
+    std::uint64_t word;
+    std::memcpy(&word, buffer + here, sizeof(word));
+    if ((word & high_bits) != 0)
+      break;
+  }
+  while (here < end and get_byte(buffer, here) < 0x80) ++here;
+  return here;
+}
+
+
+/// Check that the UTF-8 text in [@c begin, @c end) is valid.
+/** Skips ASCII in blocks of 8 bytes.  The glyph scanner checks the rest.
+ * Throws @c argument_error on the first invalid sequence.
+ */
+inline void validate_utf8(
+  std::string_view text, std::string::size_type begin,
+  std::string::size_type end)
+{
+  auto const buffer{text.data()};
+  auto const size{text.size()};
+  for (auto here{begin}; here < end;)
+  {
+    here = skip_ascii(buffer, here, end);
+    if (here < end)
+      here = glyph_scanner<encoding_group::UTF8>::call_multibyte(
+        buffer, size, here);
+  }
+}
+
+
+/// In a single-byte encoding, every byte is a character of its own.
+template<> struct char_finder<encoding_group::MONOBYTE>
+{
+  static std::string::size_type call(
+    std::string_view haystack, char needle,
+    std::string::size_type start) noexcept
+  {
+    return haystack.find(needle, start);
+  }
+};
+
+
+/// In UTF-8, an ASCII byte can only ever be that ASCII character.
+/** So to find an ASCII character, we can just search for the byte.  We only
+ * need to look at glyphs to check that the text before it is valid.
+ */
+template<> struct char_finder<encoding_group::UTF8>
+{
+  static std::string::size_type
+  call(std::string_view haystack, char needle, std::string::size_type start)
+  {
+    if (static_cast<unsigned char>(needle) >= 0x80)
+      return find_char_by_glyph<encoding_group::UTF8>(haystack, needle, start);
+    if (start >= haystack.size())
+      return std::string::npos;
+    auto const found{haystack.find(needle, start)};
+    validate_utf8(
+      haystack, start,
+      (found == std::string::npos) ? haystack.size() : found);
+    return found;
   }
 };
 
@@ -711,16 +788,33 @@ template<encoding_group E> struct string_finder
     std::string_view haystack, std::string_view needle,
     std::string::size_type start)
   {
-    auto const buffer{haystack.data()};
-    auto const size{haystack.size()};
-    auto const needle_size{needle.size()};
-    for (auto here{start}; here + needle_size <= size;
-         here = glyph_scanner<E>::call(buffer, size, here))
-    {
-      if (std::memcmp(buffer + here, needle.data(), needle_size) == 0)
-        return here;
-    }
-    return std::string::npos;
+    return find_string_by_glyph<E>(haystack, needle, start);
+  }
+};
+
+
+/// In UTF-8, a match starting with an ASCII byte is at a glyph boundary.
+/** So for such a needle, we can search for the bytes, and just check that
+ * the text before the match is valid.
+ */
+template<> struct string_finder<encoding_group::UTF8>
+{
+  static std::string::size_type call(
+    std::string_view haystack, std::string_view needle,
+    std::string::size_type start)
+  {
+    if (needle.empty() or static_cast<unsigned char>(needle[0]) >= 0x80)
+      return find_string_by_glyph<encoding_group::UTF8>(
+        haystack, needle, start);
+    if (start + needle.size() > haystack.size())
+      return std::string::npos;
+    auto const found{haystack.find(needle, start)};
+    // Check the same glyphs that a glyph-by-glyph search would have seen.
+    validate_utf8(
+      haystack, start,
+      (found == std::string::npos) ? (haystack.size() - needle.size() + 1) :
+                                     found);
+    return found;
   }
 };
 
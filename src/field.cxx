@@ -47,6 +47,12 @@ pqxx::oid pqxx::field::type() const
 }
 
 
+bool pqxx::field::is_binary() const noexcept
+{
+  return home().column_format(col()) == format::binary;
+}
+
+
 pqxx::oid pqxx::field::table() const
 {
   return home().column_table(col());
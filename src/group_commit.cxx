@@ -0,0 +1,160 @@
+/** Implementation of the pqxx::group_commit class.
+ *
+ * pqxx::group_commit runs small writes from many threads in shared
+ * transactions.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+#include "pqxx/except"
+#include "pqxx/group_commit"
+#include "pqxx/subtransaction"
+#include "pqxx/transaction"
+
+
+pqxx::group_commit::group_commit(
+  connection &cx, group_commit_policy policy) :
+        m_conn{cx}, m_policy{policy}, m_thread{[this] { run(); }}
+{}
+
+
+pqxx::group_commit::~group_commit() noexcept
+{
+  {
+    std::lock_guard const lock{m_mutex};
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  m_thread.join();
+}
+
+
+std::future<void> pqxx::group_commit::submit(write w)
+{
+  queued entry{
+    std::move(w), std::promise<void>{}, std::chrono::steady_clock::now()};
+  auto done{entry.done.get_future()};
+  bool full{false};
+  {
+    std::lock_guard const lock{m_mutex};
+    m_queue.push_back(std::move(entry));
+    full = (std::size(m_queue) == 1) or
+           (m_policy.max_writes > 0 and
+            std::size(m_queue) >= m_policy.max_writes);
+  }
+  // Wake the thread for the first write, so it starts the clock, and for the
+  // one that fills a batch.
+  if (full)
+    m_wake.notify_one();
+  return done;
+}
+
+
+std::size_t pqxx::group_commit::pending() const
+{
+  std::lock_guard const lock{m_mutex};
+  return std::size(m_queue);
+}
+
+
+std::size_t pqxx::group_commit::batches() const
+{
+  std::lock_guard const lock{m_mutex};
+  return m_batches;
+}
+
+
+void pqxx::group_commit::run() noexcept
+{
+  auto const ready{[this] {
+    return m_stop or (m_policy.max_writes > 0 and
+                      std::size(m_queue) >= m_policy.max_writes);
+  }};
+
+  std::unique_lock lock{m_mutex};
+  for (;;)
+  {
+    m_wake.wait(lock, [this] { return m_stop or not std::empty(m_queue); });
+    if (std::empty(m_queue))
+      // We're stopping, and there's nothing left to do.
+      return;
+    // New writes only join at the back, so the oldest stays at the front.
+    m_wake.wait_until(
+      lock, m_queue.front().since + m_policy.max_delay, ready);
+
+    std::vector<queued> batch;
+    auto const take{
+      (m_policy.max_writes > 0) ?
+        std::min(m_policy.max_writes, std::size(m_queue)) :
+        std::size(m_queue)};
+    auto const split{std::begin(m_queue) + static_cast<std::ptrdiff_t>(take)};
+    batch.assign(
+      std::make_move_iterator(std::begin(m_queue)),
+      std::make_move_iterator(split));
+    m_queue.erase(std::begin(m_queue), split);
+
+    lock.unlock();
+    commit_batch(batch);
+    lock.lock();
+    ++m_batches;
+  }
+}
+
+
+void pqxx::group_commit::commit_batch(std::vector<queued> &batch) noexcept
+{
+  // Errors of writes that failed on their own, in isolate mode.
+  std::vector<std::exception_ptr> errors(std::size(batch));
+  try
+  {
+    work tx{m_conn};
+    for (std::size_t i{0}; i < std::size(batch); ++i)
+    {
+      if (m_policy.on_failure == group_failure::all_or_nothing)
+      {
+        batch[i].w(tx);
+        continue;
+      }
+      try
+      {
+        subtransaction sub{tx};
+        batch[i].w(sub);
+        sub.commit();
+      }
+      catch (broken_connection const &)
+      {
+        // Nothing else in the batch is going to work either.
+        throw;
+      }
+      catch (...)
+      {
+        errors[i] = std::current_exception();
+      }
+    }
+    tx.commit();
+  }
+  catch (...)
+  {
+    auto const error{std::current_exception()};
+    for (std::size_t i{0}; i < std::size(batch); ++i)
+      batch[i].done.set_exception((errors[i] == nullptr) ? error : errors[i]);
+    return;
+  }
+
+  for (std::size_t i{0}; i < std::size(batch); ++i)
+    if (errors[i] == nullptr)
+      batch[i].done.set_value();
+    else
+      batch[i].done.set_exception(errors[i]);
+}
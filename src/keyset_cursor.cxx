@@ -0,0 +1,147 @@
+/** Implementation of the pqxx::keyset_cursor class.
+ *
+ * pqxx::keyset_cursor pages through a query's results by sort key.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+
+#include "pqxx/connection"
+#include "pqxx/except"
+#include "pqxx/keyset_cursor"
+#include "pqxx/prepared_statement"
+#include "pqxx/result"
+#include "pqxx/transaction_base"
+
+
+pqxx::keyset_cursor::keyset_cursor(
+  connection &cx, std::string_view query, std::vector<std::string> key,
+  size_type page_size, keyset_order order) :
+        m_key{std::move(key)}, m_page_size{page_size}
+{
+  if (std::empty(m_key))
+    throw argument_error{"Keyset cursor needs at least one key column."};
+  if (page_size <= 0)
+    throw argument_error{"Keyset cursor needs a positive page size."};
+
+  std::string columns, params;
+  for (std::size_t i{0}; i < std::size(m_key); ++i)
+  {
+    if (i > 0)
+    {
+      columns += ", ";
+      params += ", ";
+    }
+    columns += cx.quote_name(m_key[i]);
+    params += "$" + to_string(i + 1);
+  }
+  bool const desc{order == keyset_order::descending};
+  std::string const select{
+    "SELECT * FROM (" + std::string{query} + ") AS pqxx_keyset"};
+  std::string order_by{" ORDER BY "};
+  for (std::size_t i{0}; i < std::size(m_key); ++i)
+  {
+    if (i > 0)
+      order_by += ", ";
+    order_by += cx.quote_name(m_key[i]);
+    if (desc)
+      order_by += " DESC";
+  }
+
+  m_first_query = select + order_by + " LIMIT $1";
+  m_seek_query = select + " WHERE (" + columns + ")" + (desc ? " < " : " > ") +
+                 "(" + params + ")" + order_by + " LIMIT $" +
+                 to_string(std::size(m_key) + 1);
+}
+
+
+void pqxx::keyset_cursor::seek(std::vector<std::string> position)
+{
+  if (not std::empty(position) and std::size(position) != std::size(m_key))
+    throw argument_error{
+      "Keyset cursor position has " + to_string(std::size(position)) +
+      " value(s), but the key has " + to_string(std::size(m_key)) + "."};
+  m_position = std::move(position);
+  m_buffer.clear();
+  m_buffered = 0;
+  m_exhausted = false;
+  m_done = false;
+}
+
+
+void pqxx::keyset_cursor::set_prefetch(size_type pages)
+{
+  if (pages < 0)
+    throw argument_error{"Negative prefetch for keyset cursor."};
+  m_prefetch = pages;
+}
+
+
+void pqxx::keyset_cursor::prepare(connection &cx, std::string const &name)
+{
+  cx.prepare(name, m_seek_query);
+  cx.prepare(name + "_first", m_first_query);
+  use_prepared(name);
+}
+
+
+void pqxx::keyset_cursor::use_prepared(std::string name)
+{
+  m_statement = std::move(name);
+}
+
+
+pqxx::result
+pqxx::keyset_cursor::fetch(transaction_base &tx, size_type limit)
+{
+  if (std::empty(m_position))
+  {
+    if (std::empty(m_statement))
+      return tx.exec_params(m_first_query, limit);
+    else
+      return tx.exec_prepared(m_statement + "_first", limit);
+  }
+  auto const key{prepare::make_dynamic_params(m_position)};
+  if (std::empty(m_statement))
+    return tx.exec_params(m_seek_query, key, limit);
+  else
+    return tx.exec_prepared(m_statement, key, limit);
+}
+
+
+pqxx::keyset_page pqxx::keyset_cursor::next(transaction_base &tx)
+{
+  if (m_buffered == std::size(m_buffer))
+  {
+    if (m_done)
+      return {};
+    auto const limit{check_cast<size_type>(
+      static_cast<long long>(m_page_size) * (m_prefetch + 1),
+      "keyset cursor fetch size")};
+    m_buffer = fetch(tx, limit);
+    m_buffered = 0;
+    m_exhausted = (std::size(m_buffer) < limit);
+  }
+
+  auto const begin{m_buffered},
+    end{std::min(m_buffered + m_page_size, std::size(m_buffer))};
+  m_buffered = end;
+  if (end > begin)
+  {
+    auto const last{m_buffer[end - 1]};
+    std::vector<std::string> position;
+    position.reserve(std::size(m_key));
+    for (auto const &column : m_key)
+      position.emplace_back(last[column].view());
+    m_position = std::move(position);
+  }
+  if (m_exhausted and m_buffered == std::size(m_buffer))
+    m_done = true;
+  return keyset_page{m_buffer, begin, end};
+}
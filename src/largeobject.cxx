@@ -12,6 +12,10 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 
 extern "C"
@@ -259,6 +263,136 @@ pqxx::largeobjectaccess::read(char buf[], size_t len)
 }
 
 
+size_t pqxx::largeobjectaccess::check_chunk_size(size_t chunk_size)
+{
+  if (chunk_size == 0)
+    throw argument_error{"Large object chunk size must be positive."};
+  // The server functions take an int for the size.
+  return std::min(
+    chunk_size, static_cast<size_t>(std::numeric_limits<int>::max()));
+}
+
+
+size_t pqxx::largeobjectaccess::remaining()
+{
+  auto const here{tell()}, end{seek(0, std::ios::end)};
+  seek(here, std::ios::beg);
+  return (end > here) ? static_cast<size_t>(end - here) : 0u;
+}
+
+
+void pqxx::largeobjectaccess::read_chunks(
+  size_t total, size_t chunk_size,
+  std::function<void(std::string_view)> const &sink)
+{
+  // With a descriptor, loread() reads on from wherever the last one left
+  // off.  So we can send all the reads at once.
+  auto const query{
+    std::make_shared<std::string>("SELECT pg_catalog.loread($1, $2)")};
+  size_t requested{0};
+  internal::gate::connection_largeobject{m_trans.conn()}.exec_params_bulk(
+    query,
+    [this, total, chunk_size, &requested](internal::params &args) {
+      if (requested >= total)
+        return false;
+      auto const len{std::min(chunk_size, total - requested)};
+      args.assign(m_fd, len);
+      requested += len;
+      return true;
+    },
+    [&sink](result const &r) { sink(r[0][0].view()); }, format::binary);
+}
+
+
+void pqxx::largeobjectaccess::write_chunks(
+  std::function<std::string_view()> const &next)
+{
+  auto const query{
+    std::make_shared<std::string>("SELECT pg_catalog.lowrite($1, $2)")};
+  // Sizes of the chunks whose results we haven't seen yet, in order.
+  std::deque<size_t> pending;
+  internal::gate::connection_largeobject{m_trans.conn()}.exec_params_bulk(
+    query,
+    [this, &next, &pending](internal::params &args) {
+      auto const chunk{next()};
+      if (std::empty(chunk))
+        return false;
+      args.assign(m_fd, internal::binary_param<std::string_view>{chunk});
+      pending.push_back(std::size(chunk));
+      return true;
+    },
+    [this, &pending](result const &r) {
+      auto const expected{pending.front()};
+      pending.pop_front();
+      if (r[0][0].as<size_t>() != expected)
+        throw failure{
+          "Wanted to write " + to_string(expected) +
+          " bytes to large object #" + to_string(id()) +
+          "; could only write " + r[0][0].as<std::string>() + "."};
+    });
+}
+
+
+std::string pqxx::largeobjectaccess::read_all(size_t chunk_size)
+{
+  chunk_size = check_chunk_size(chunk_size);
+  auto const total{remaining()};
+  std::string data;
+  data.reserve(total);
+  read_chunks(
+    total, chunk_size, [&data](std::string_view chunk) { data += chunk; });
+  return data;
+}
+
+
+void pqxx::largeobjectaccess::write_all(
+  std::string_view data, size_t chunk_size)
+{
+  chunk_size = check_chunk_size(chunk_size);
+  write_chunks([&data, chunk_size] {
+    auto const chunk{data.substr(0, chunk_size)};
+    data.remove_prefix(std::size(chunk));
+    return chunk;
+  });
+}
+
+
+void pqxx::largeobjectaccess::read_to_file(
+  std::string_view file, size_t chunk_size)
+{
+  chunk_size = check_chunk_size(chunk_size);
+  std::ofstream out{std::string{file}, std::ios::binary | std::ios::trunc};
+  if (not out)
+    throw failure{"Could not open file '" + std::string{file} + "'."};
+  read_chunks(remaining(), chunk_size, [&out, file](std::string_view chunk) {
+    if (not out.write(
+          std::data(chunk), static_cast<std::streamsize>(std::size(chunk))))
+      throw failure{"Error writing to file '" + std::string{file} + "'."};
+  });
+  if (not out.flush())
+    throw failure{"Error writing to file '" + std::string{file} + "'."};
+}
+
+
+void pqxx::largeobjectaccess::write_from_file(
+  std::string_view file, size_t chunk_size)
+{
+  chunk_size = check_chunk_size(chunk_size);
+  std::ifstream in{std::string{file}, std::ios::binary};
+  if (not in)
+    throw failure{"Could not open file '" + std::string{file} + "'."};
+  std::string buffer;
+  write_chunks([&in, &buffer, file, chunk_size] {
+    buffer.resize(chunk_size);
+    in.read(std::data(buffer), static_cast<std::streamsize>(chunk_size));
+    if (in.bad())
+      throw failure{"Error reading file '" + std::string{file} + "'."};
+    buffer.resize(static_cast<size_t>(in.gcount()));
+    return std::string_view{buffer};
+  });
+}
+
+
 void pqxx::largeobjectaccess::open(openmode mode)
 {
   m_fd = lo_open(raw_connection(), id(), std_mode_to_pq_mode(mode));
@@ -301,3 +435,240 @@ void pqxx::largeobjectaccess::process_notice(std::string const &s) noexcept
 {
   m_trans.process_notice(s);
 }
+
+
+pqxx::largeobject_view::largeobject_view(
+  dbtransaction &t, largeobject obj, size_type page_size,
+  std::size_t cache_pages) :
+        m_trans{t},
+        m_id{obj.id()},
+        m_page_size{page_size},
+        m_capacity{cache_pages}
+{
+  if (m_id == oid_none)
+    throw argument_error{"Large object view on a null large object."};
+  if (page_size <= 0 or page_size > std::numeric_limits<int>::max())
+    throw argument_error{
+      "Invalid large object page size: " + to_string(page_size) + "."};
+  if (cache_pages == 0)
+    throw argument_error{"Large object view needs room for at least 1 page."};
+}
+
+
+pqxx::largeobject_view::size_type pqxx::largeobject_view::size()
+{
+  if (m_size < 0)
+  {
+    largeobjectaccess obj{m_trans, m_id, std::ios::in};
+    m_size = obj.seek(0, std::ios::end);
+  }
+  return m_size;
+}
+
+
+std::size_t
+pqxx::largeobject_view::read(size_type offset, char buf[], std::size_t len)
+{
+  if (offset < 0)
+    throw argument_error{
+      "Negative offset in large object: " + to_string(offset) + "."};
+  if (len == 0)
+    return 0;
+  auto const last{
+    (offset + static_cast<size_type>(len) - 1) / m_page_size};
+  std::size_t done{0};
+  while (done < len)
+  {
+    auto const pos{offset + static_cast<size_type>(done)};
+    auto const index{pos / m_page_size};
+    auto const p{page(index, last)};
+    if (not p)
+      break;
+    auto const skip{static_cast<std::size_t>(pos - index * m_page_size)};
+    if (skip >= std::size(*p))
+      break;
+    auto const n{std::min(len - done, std::size(*p) - skip)};
+    std::copy_n(std::data(*p) + skip, n, buf + done);
+    done += n;
+  }
+  return done;
+}
+
+
+std::string pqxx::largeobject_view::read(size_type offset, std::size_t len)
+{
+  std::string data;
+  data.resize(len);
+  data.resize(read(offset, std::data(data), len));
+  return data;
+}
+
+
+void pqxx::largeobject_view::clear() noexcept
+{
+  m_pages.clear();
+  m_lru.clear();
+  m_last_page = -1;
+}
+
+
+pqxx::largeobject_view::page_ptr
+pqxx::largeobject_view::cached(size_type index) noexcept
+{
+  auto const here{m_pages.find(index)};
+  if (here == std::end(m_pages))
+    return {};
+  m_lru.splice(std::begin(m_lru), m_lru, here->second);
+  return here->second->second;
+}
+
+
+pqxx::largeobject_view::page_ptr
+pqxx::largeobject_view::page(size_type index, size_type last)
+{
+  auto found{cached(index)};
+  if (not found)
+  {
+    if (m_size >= 0 and index * m_page_size >= m_size)
+      return {};
+
+    // Fetch the whole run of missing pages that this read needs, in one go.
+    // If we're reading sequentially, fetch some more pages beyond that.
+    if (index == m_last_page + 1)
+      last += static_cast<size_type>(m_readahead);
+    auto const most{std::min(
+      static_cast<size_type>(m_capacity),
+      std::numeric_limits<int>::max() / m_page_size)};
+    size_type count{1};
+    while (count < most and index + count <= last and
+           m_pages.find(index + count) == std::end(m_pages) and
+           (m_size < 0 or (index + count) * m_page_size < m_size))
+      ++count;
+    fetch(index, count);
+    found = cached(index);
+  }
+  m_last_page = index;
+  return found;
+}
+
+
+void pqxx::largeobject_view::fetch(size_type first, size_type count)
+{
+  auto const offset{first * m_page_size};
+  auto const bytes{static_cast<int>(count * m_page_size)};
+  auto const r{m_trans.exec_params_binary(
+    "SELECT pg_catalog.lo_get($1, $2, $3)", m_id, offset, bytes)};
+  ++m_fetches;
+  auto const data{r[0][0].view()};
+  if (std::size(data) < static_cast<std::size_t>(bytes))
+    m_size = offset + static_cast<size_type>(std::size(data));
+
+  auto const page_size{static_cast<std::size_t>(m_page_size)};
+  for (std::size_t start{0}; start < std::size(data); start += page_size)
+  {
+    auto const index{first + static_cast<size_type>(start / page_size)};
+    auto contents{
+      std::make_shared<std::string const>(data.substr(start, page_size))};
+    auto const here{m_pages.find(index)};
+    if (here == std::end(m_pages))
+    {
+      m_lru.emplace_front(index, std::move(contents));
+      m_pages.emplace(index, std::begin(m_lru));
+    }
+    else
+    {
+      here->second->second = std::move(contents);
+      m_lru.splice(std::begin(m_lru), m_lru, here->second);
+    }
+  }
+
+  while (std::size(m_lru) > m_capacity)
+  {
+    m_pages.erase(m_lru.back().first);
+    m_lru.pop_back();
+  }
+}
+
+
+pqxx::largeobject_view::size_type
+pqxx::largeobject_view_buf::position() const noexcept
+{
+  if (m_page)
+    return m_base + static_cast<largeobject_view::size_type>(gptr() - eback());
+  else
+    return m_base;
+}
+
+
+pqxx::largeobject_view_buf::pos_type
+pqxx::largeobject_view_buf::jump(largeobject_view::size_type pos)
+{
+  m_page.reset();
+  setg(nullptr, nullptr, nullptr);
+  m_base = pos;
+  return pos_type(off_type(pos));
+}
+
+
+pqxx::largeobject_view_buf::int_type pqxx::largeobject_view_buf::underflow()
+{
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+
+  auto const pos{position()};
+  auto const index{pos / m_view.m_page_size};
+  auto next{m_view.page(index, index)};
+  auto const skip{
+    static_cast<std::size_t>(pos - index * m_view.m_page_size)};
+  if (not next or skip >= std::size(*next))
+  {
+    jump(pos);
+    return traits_type::eof();
+  }
+
+  // The stream only reads from the get area, so we can point it right into
+  // the cached page.
+  m_page = std::move(next);
+  m_base = index * m_view.m_page_size;
+  auto const begin{const_cast<char *>(std::data(*m_page))};
+  setg(begin, begin + skip, begin + std::size(*m_page));
+  return traits_type::to_int_type(*gptr());
+}
+
+
+std::streamsize
+pqxx::largeobject_view_buf::xsgetn(char_type *buf, std::streamsize len)
+{
+  if (len <= 0)
+    return 0;
+  // Let the view fetch any missing pages for the whole range in one go.
+  auto const pos{position()};
+  auto const n{m_view.read(pos, buf, static_cast<std::size_t>(len))};
+  jump(pos + static_cast<largeobject_view::size_type>(n));
+  return static_cast<std::streamsize>(n);
+}
+
+
+pqxx::largeobject_view_buf::pos_type pqxx::largeobject_view_buf::seekoff(
+  off_type offset, std::ios::seekdir dir, std::ios::openmode)
+{
+  largeobject_view::size_type base{0};
+  switch (dir)
+  {
+  case std::ios::beg: break;
+  case std::ios::cur: base = position(); break;
+  case std::ios::end: base = m_view.size(); break;
+  default: return pos_type(off_type(-1));
+  }
+  auto const target{base + static_cast<largeobject_view::size_type>(offset)};
+  if (target < 0)
+    return pos_type(off_type(-1));
+  return jump(target);
+}
+
+
+pqxx::largeobject_view_buf::pos_type
+pqxx::largeobject_view_buf::seekpos(pos_type pos, std::ios::openmode mode)
+{
+  return seekoff(off_type(pos), std::ios::beg, mode);
+}
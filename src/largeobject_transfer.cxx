@@ -0,0 +1,88 @@
+/** Implementation of bulk large object transfers.
+ *
+ * Moves many large objects to or from local files, in parallel.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <atomic>
+
+#include "pqxx/largeobject_transfer"
+#include "pqxx/parallel_result"
+#include "pqxx/transaction"
+
+
+namespace
+{
+/// Call @c transfer(conn, index) for each index, in several threads.
+/** Each thread borrows one connection from the pool, and takes the next
+ * index that nobody has worked on yet, until there are none left.
+ */
+template<typename TRANSFER>
+void run_transfers(
+  pqxx::connection_pool &pool, std::size_t count, std::size_t threads,
+  TRANSFER const &transfer)
+{
+  if (count == 0)
+    return;
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> stop{false};
+  pqxx::internal::run_chunks(
+    pqxx::internal::parallel_threads(
+      pqxx::check_cast<pqxx::result_size_type>(count, "large objects"),
+      threads),
+    stop, [&](std::size_t) {
+      auto conn{pool.get()};
+      for (auto index{next++}; index < count and not stop.load();
+           index = next++)
+        transfer(*conn, index);
+    });
+}
+} // namespace
+
+
+void pqxx::export_large_objects(
+  connection_pool &pool, std::vector<large_object_file> const &objects,
+  std::size_t threads, std::size_t chunk_size)
+{
+  using read_tx =
+    transaction<isolation_level::read_committed, write_policy::read_only>;
+  run_transfers(
+    pool, std::size(objects), threads,
+    [&objects, chunk_size](connection &conn, std::size_t index) {
+      auto const &object{objects[index]};
+      read_tx tx{conn};
+      {
+        largeobjectaccess access{tx, object.id, std::ios::in};
+        access.read_to_file(object.path, chunk_size);
+      }
+      tx.commit();
+    });
+}
+
+
+void pqxx::import_large_objects(
+  connection_pool &pool, std::vector<large_object_file> &files,
+  std::size_t threads, std::size_t chunk_size)
+{
+  for (auto &file : files) file.id = oid_none;
+  run_transfers(
+    pool, std::size(files), threads,
+    [&files, chunk_size](connection &conn, std::size_t index) {
+      auto &file{files[index]};
+      work tx{conn};
+      oid id{oid_none};
+      {
+        largeobjectaccess access{tx, std::ios::out};
+        access.write_from_file(file.path, chunk_size);
+        id = access.id();
+      }
+      tx.commit();
+      file.id = id;
+    });
+}
@@ -0,0 +1,94 @@
+/** Implementation of pqxx::internal::mapped_file.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <cerrno>
+#include <system_error>
+
+#if __has_include(<sys/mman.h>)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#else
+#  include <fstream>
+#  include <iterator>
+#endif
+
+#include "pqxx/except"
+#include "pqxx/internal/mapped_file.hxx"
+
+
+#if __has_include(<sys/mman.h>)
+namespace
+{
+[[noreturn]] void
+fail(char const *what, std::string const &path, int err = errno)
+{
+  throw pqxx::failure{
+    "Could not " + std::string{what} + " '" + path +
+    "': " + std::system_category().message(err)};
+}
+
+
+/// Closes a file descriptor on destruction.
+struct fd_closer
+{
+  int fd;
+  ~fd_closer() noexcept { ::close(fd); }
+};
+} // namespace
+
+
+pqxx::internal::mapped_file::mapped_file(std::string const &path)
+{
+  int const fd{::open(path.c_str(), O_RDONLY)};
+  if (fd < 0)
+    fail("open", path);
+  // Once mapped, the data stays accessible after we close the file.
+  fd_closer const closer{fd};
+  struct stat info;
+  if (::fstat(fd, &info) != 0)
+    fail("examine", path);
+  if (info.st_size == 0)
+    return;
+
+  auto const size{static_cast<std::size_t>(info.st_size)};
+  void *const map{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+  if (map == MAP_FAILED)
+    fail("map", path);
+#  if defined(MADV_SEQUENTIAL)
+  ::madvise(map, size, MADV_SEQUENTIAL);
+#  endif
+  m_map = map;
+  m_data = std::string_view{static_cast<char const *>(map), size};
+}
+
+
+pqxx::internal::mapped_file::~mapped_file() noexcept
+{
+  if (m_map != nullptr)
+    ::munmap(m_map, m_data.size());
+}
+#else
+pqxx::internal::mapped_file::mapped_file(std::string const &path)
+{
+  std::ifstream in{path, std::ios::binary};
+  if (not in)
+    throw failure{"Could not open file '" + path + "'."};
+  m_contents.assign(
+    std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+  if (in.bad())
+    throw failure{"Error reading file '" + path + "'."};
+  m_data = m_contents;
+}
+
+
+pqxx::internal::mapped_file::~mapped_file() noexcept = default;
+#endif
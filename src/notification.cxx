@@ -11,6 +11,7 @@
 #include "pqxx-source.hxx"
 
 #include <string>
+#include <utility>
 
 #include "pqxx/internal/gates/connection-notification_receiver.hxx"
 
@@ -31,3 +32,41 @@ pqxx::notification_receiver::~notification_receiver()
   pqxx::internal::gate::connection_notification_receiver{this->conn()}
     .remove_receiver(this);
 }
+
+
+void pqxx::notification_receiver::operator()(std::string const &, int) {}
+
+
+void pqxx::notification_receiver::receive(zview payload, int backend_pid)
+{
+  (*this)(std::string{payload}, backend_pid);
+}
+
+
+pqxx::receiver_batch::receiver_batch(connection &c) : m_conn{c}
+{
+  pqxx::internal::gate::connection_notification_receiver{c}
+    .begin_listen_batch();
+}
+
+
+pqxx::receiver_batch::~receiver_batch() noexcept
+{
+  try
+  {
+    complete();
+  }
+  catch (std::exception const &e)
+  {
+    m_conn.process_notice(e.what());
+  }
+}
+
+
+void pqxx::receiver_batch::complete()
+{
+  if (std::exchange(m_done, true))
+    return;
+  pqxx::internal::gate::connection_notification_receiver{m_conn}
+    .end_listen_batch();
+}
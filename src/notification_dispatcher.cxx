@@ -0,0 +1,248 @@
+/** Implementation of the pqxx::notification_dispatcher class.
+ *
+ * pqxx::notification_dispatcher delivers notifications from worker threads.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "pqxx/except"
+#include "pqxx/notification"
+#include "pqxx/notification_dispatcher"
+
+
+/// Receiver on the dispatcher's connection, for one channel.
+class pqxx::notification_dispatcher::receiver final
+        : public notification_receiver
+{
+public:
+  receiver(
+    notification_dispatcher &home, connection &conn,
+    channel_map::value_type &channel) :
+          notification_receiver{conn, channel.first},
+          m_home{home},
+          m_channel{channel}
+  {}
+
+  void receive(zview payload, int backend_pid) override
+  {
+    m_home.enqueue(
+      m_channel, notification{
+                   m_channel.first, std::string{payload}, backend_pid,
+                   std::chrono::steady_clock::now()});
+  }
+
+private:
+  notification_dispatcher &m_home;
+  channel_map::value_type &m_channel;
+};
+
+
+pqxx::notification_dispatcher::notification_dispatcher(
+  std::string const &options, std::size_t threads,
+  std::chrono::milliseconds poll_interval) :
+        m_conn{options}, m_poll_interval{poll_interval}
+{
+  if (m_poll_interval.count() <= 0)
+    throw argument_error{"Notification poll interval must be positive."};
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  try
+  {
+    m_listener = std::thread{[this] { listen_loop(); }};
+    m_workers.reserve(threads);
+    for (std::size_t i{0}; i < threads; ++i)
+      m_workers.emplace_back([this] { work_loop(); });
+  }
+  catch (...)
+  {
+    halt();
+    throw;
+  }
+}
+
+
+pqxx::notification_dispatcher::~notification_dispatcher() noexcept
+{
+  halt();
+}
+
+
+void pqxx::notification_dispatcher::listen(
+  std::string_view channel, handler callback)
+{
+  std::unique_lock lock{m_mutex};
+  if (m_stopping or m_error)
+    throw usage_error{"Notification dispatcher has stopped."};
+
+  auto const [here, inserted]{m_channels.try_emplace(std::string{channel})};
+  auto &state{here->second};
+  state.handlers.push_back(std::move(callback));
+  if (inserted)
+    m_new_channels.push_back(&*here);
+
+  m_listened.wait(
+    lock, [this, &state] { return state.listening or m_stopping or m_error; });
+  if (not state.listening)
+  {
+    if (m_error)
+      std::rethrow_exception(m_error);
+    throw usage_error{"Notification dispatcher stopped before listening."};
+  }
+}
+
+
+pqxx::notification_dispatcher::statistics
+pqxx::notification_dispatcher::stats() const
+{
+  std::lock_guard const lock{m_mutex};
+  auto result{m_stats};
+  result.queue_depth = result.received - result.delivered;
+  return result;
+}
+
+
+void pqxx::notification_dispatcher::stop()
+{
+  halt();
+  std::lock_guard const lock{m_mutex};
+  if (m_error)
+    std::rethrow_exception(std::exchange(m_error, nullptr));
+}
+
+
+void pqxx::notification_dispatcher::halt() noexcept
+{
+  {
+    std::lock_guard const lock{m_mutex};
+    m_stopping = true;
+  }
+  m_wake_workers.notify_all();
+  m_listened.notify_all();
+  if (m_listener.joinable())
+    m_listener.join();
+  for (auto &worker : m_workers)
+    if (worker.joinable())
+      worker.join();
+}
+
+
+void pqxx::notification_dispatcher::listen_loop()
+{
+  // Only this thread touches the connection, and these receivers.
+  std::vector<std::unique_ptr<receiver>> receivers;
+  auto const seconds{
+    static_cast<long>(m_poll_interval.count() / 1000)},
+    microseconds{static_cast<long>((m_poll_interval.count() % 1000) * 1000)};
+  try
+  {
+    for (;;)
+    {
+      std::vector<channel_map::value_type *> fresh;
+      {
+        std::lock_guard const lock{m_mutex};
+        if (m_stopping)
+          break;
+        fresh.swap(m_new_channels);
+      }
+      if (not fresh.empty())
+      {
+        receiver_batch batch{m_conn};
+        for (auto const channel : fresh)
+          receivers.push_back(
+            std::make_unique<receiver>(*this, m_conn, *channel));
+        batch.complete();
+        {
+          std::lock_guard const lock{m_mutex};
+          for (auto const channel : fresh) channel->second.listening = true;
+        }
+        m_listened.notify_all();
+      }
+      m_conn.await_notification(seconds, microseconds);
+    }
+  }
+  catch (std::exception const &)
+  {
+    {
+      std::lock_guard const lock{m_mutex};
+      m_error = std::current_exception();
+    }
+    m_listened.notify_all();
+  }
+}
+
+
+void pqxx::notification_dispatcher::enqueue(
+  channel_map::value_type &channel, notification &&incoming)
+{
+  std::lock_guard const lock{m_mutex};
+  ++m_stats.received;
+  auto &state{channel.second};
+  state.pending.push_back(std::move(incoming));
+  if (not state.scheduled)
+  {
+    state.scheduled = true;
+    m_ready.push_back(&channel);
+    m_wake_workers.notify_one();
+  }
+}
+
+
+void pqxx::notification_dispatcher::work_loop()
+{
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  std::unique_lock lock{m_mutex};
+  for (;;)
+  {
+    m_wake_workers.wait(
+      lock, [this] { return m_stopping or not m_ready.empty(); });
+    if (m_stopping)
+      return;
+
+    // Take everything that has piled up for this channel.  The channel stays
+    // scheduled, so no other worker delivers for it in the meantime.
+    auto &channel{*m_ready.front()};
+    m_ready.pop_front();
+    std::vector<notification> batch;
+    batch.swap(channel.second.pending);
+    auto const handlers{channel.second.handlers};
+    lock.unlock();
+
+    auto const start{std::chrono::steady_clock::now()};
+    std::size_t failures{0};
+    for (auto const &callback : handlers) try
+      {
+        callback(batch);
+      }
+      catch (...)
+      {
+        ++failures;
+      }
+
+    lock.lock();
+    for (auto const &item : batch)
+    {
+      auto const delay{duration_cast<microseconds>(start - item.received)};
+      m_stats.total_delay += delay;
+      m_stats.max_delay = std::max(m_stats.max_delay, delay);
+    }
+    m_stats.delivered += std::size(batch);
+    ++m_stats.batches;
+    m_stats.failures += failures;
+    if (channel.second.pending.empty())
+      channel.second.scheduled = false;
+    else
+      m_ready.push_back(&channel);
+  }
+}
@@ -0,0 +1,80 @@
+/** Implementation of the pqxx::notification_publisher class.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <memory>
+
+#include "pqxx/notification_publisher"
+
+#include "pqxx/internal/gates/connection-notification_publisher.hxx"
+
+
+pqxx::notification_publisher::notification_publisher(
+  connection &c, publish_policy policy) :
+        m_conn{c}, m_policy{policy}
+{}
+
+
+pqxx::notification_publisher::~notification_publisher() noexcept
+{
+  try
+  {
+    flush();
+  }
+  catch (std::exception const &e)
+  {
+    m_conn.process_notice(e.what());
+  }
+}
+
+
+void pqxx::notification_publisher::publish(
+  std::string_view channel, std::string_view payload)
+{
+  auto const now{std::chrono::steady_clock::now()};
+  if (m_pending.empty())
+    m_oldest = now;
+  m_pending.emplace_back(channel, payload);
+  if (
+    (m_policy.max_pending > 0 and
+     std::size(m_pending) >= m_policy.max_pending) or
+    (m_policy.max_delay.count() > 0 and now - m_oldest >= m_policy.max_delay))
+    flush();
+}
+
+
+std::size_t pqxx::notification_publisher::flush()
+{
+  if (m_pending.empty())
+    return 0;
+  static auto const query{
+    std::make_shared<std::string>("SELECT pg_notify($1, $2)")};
+  auto here{std::begin(m_pending)};
+  auto const end{std::end(m_pending)};
+  auto const count{std::size(m_pending)};
+  try
+  {
+    internal::gate::connection_notification_publisher{m_conn}.exec_bulk(
+      query, [&here, end](internal::params &args) {
+        if (here == end)
+          return false;
+        args.assign(here->first, here->second);
+        ++here;
+        return true;
+      });
+  }
+  catch (std::exception const &)
+  {
+    m_pending.clear();
+    throw;
+  }
+  // Keep the vector's capacity for the next batch.
+  m_pending.clear();
+  return count;
+}
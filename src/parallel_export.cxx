@@ -0,0 +1,118 @@
+/** Implementation of the pqxx::parallel_export class.
+ *
+ * pqxx::parallel_export reads a table over several connections at once.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include "pqxx/parallel_export"
+
+
+pqxx::parallel_export::parallel_export(
+  std::string connection_string, std::string_view table,
+  std::string_view columns, std::vector<std::string> partitions) :
+        m_connection_string{std::move(connection_string)},
+        m_table{table},
+        m_columns{columns},
+        m_partitions{std::move(partitions)}
+{
+  if (m_partitions.empty())
+    throw usage_error{"A parallel_export needs at least one partition."};
+}
+
+
+std::string pqxx::parallel_export::partition_query(std::size_t index) const
+{
+  auto const &condition{m_partitions.at(index)};
+  constexpr std::string_view select{"SELECT "}, from{" FROM "},
+    where{" WHERE "};
+  std::string query;
+  query.reserve(
+    select.size() + m_columns.size() + from.size() + m_table.size() +
+    where.size() + condition.size());
+  query += select;
+  query += m_columns;
+  query += from;
+  query += m_table;
+  if (not condition.empty())
+  {
+    query += where;
+    query += condition;
+  }
+  return query;
+}
+
+
+std::vector<std::string> pqxx::parallel_export::ctid_partitions(
+  transaction_base &tx, std::string_view table, std::size_t count)
+{
+  if (count == 0)
+    throw usage_error{"Can't split a table into zero partitions."};
+  auto const pages{tx.query_value<std::size_t>(
+    "SELECT pg_relation_size(" + tx.quote(std::string{table}) +
+    ") / current_setting('block_size')::bigint")};
+  // Pages per partition, rounded up.
+  auto const step{(pages + count - 1) / count};
+
+  std::vector<std::string> partitions;
+  partitions.reserve(count);
+  auto const bound{
+    [](std::size_t page) { return "'(" + to_string(page) + ",0)'::tid"; }};
+  for (std::size_t i{0}; i < count; ++i)
+  {
+    std::string condition;
+    if (i > 0)
+      condition += "ctid >= " + bound(i * step);
+    if (i > 0 and i + 1 < count)
+      condition += " AND ";
+    if (i + 1 < count)
+      condition += "ctid < " + bound((i + 1) * step);
+    partitions.push_back(std::move(condition));
+  }
+  return partitions;
+}
+
+
+std::vector<std::string> pqxx::parallel_export::key_partitions(
+  transaction_base &tx, std::string_view key,
+  std::vector<std::string> const &bounds)
+{
+  std::string const k{key};
+  std::vector<std::string> partitions;
+  partitions.reserve(bounds.size() + 1);
+  for (std::size_t i{0}; i <= bounds.size(); ++i)
+  {
+    std::string condition;
+    if (i > 0)
+      condition += k + " >= " + tx.quote(bounds[i - 1]);
+    if (i > 0 and i < bounds.size())
+      condition += " AND ";
+    if (i < bounds.size())
+      condition += k + " < " + tx.quote(bounds[i]);
+    if (i == bounds.size())
+    {
+      // The last partition also gets the nulls.
+      condition = (i == 0) ? "" : ("(" + condition + " OR " + k + " IS NULL)");
+    }
+    partitions.push_back(std::move(condition));
+  }
+  return partitions;
+}
+
+
+std::string pqxx::parallel_export::export_snapshot(transaction_base &tx)
+{
+  return tx.query_value<std::string>("SELECT pg_export_snapshot()");
+}
+
+
+void pqxx::parallel_export::import_snapshot(
+  transaction_base &tx, std::string const &snapshot)
+{
+  tx.exec0("SET TRANSACTION SNAPSHOT " + tx.quote(snapshot));
+}
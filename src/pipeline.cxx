@@ -10,28 +10,148 @@
  */
 #include "pqxx-source.hxx"
 
-#include <iterator>
+#include <algorithm>
+#include <exception>
+#include <utility>
 
+extern "C"
+{
+#include <libpq-fe.h>
+}
+
+#include "pqxx/config-internal-libpq.h"
 #include "pqxx/dbtransaction"
+#include "pqxx/nontransaction"
 #include "pqxx/pipeline"
-#include "pqxx/separated_list"
 
 #include "pqxx/internal/gates/connection-pipeline.hxx"
 #include "pqxx/internal/gates/result-creation.hxx"
 #include "pqxx/internal/gates/result-pipeline.hxx"
+#include "pqxx/internal/tracepoints.hxx"
 
 
 namespace
 {
+using clock = std::chrono::steady_clock;
+
 std::string const theSeparator{"; "};
 std::string const theDummyValue{"1"};
 std::string const theDummyQuery{"SELECT " + theDummyValue + theSeparator};
+
+
+/// Handler for a query whose result nobody needs.  Only errors matter.
+void discard_result(
+  pqxx::pipeline::query_id, pqxx::result const &, std::exception_ptr err)
+{
+  if (err)
+    std::rethrow_exception(err);
+}
+
+
+/// Do we use libpq's native pipeline mode?
+/** If not, we fall back to sending batches of queries as single strings.
+ */
+constexpr bool native_pipeline
+{
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  true
+#else
+  false
+#endif
+};
+
+
+/// Is this a pipeline synchronisation point, as opposed to a query result?
+[[maybe_unused]] bool is_sync(pqxx::internal::pq::PGresult const *r) noexcept
+{
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  return PQresultStatus(r) == PGRES_PIPELINE_SYNC;
+#else
+  pqxx::ignore_unused(r);
+  return false;
+#endif
+}
+
+
+/// Does this result report a failed, or skipped, statement?
+bool is_failure(pqxx::internal::pq::PGresult const *r) noexcept
+{
+  switch (PQresultStatus(r))
+  {
+  case PGRES_BAD_RESPONSE:
+  case PGRES_NONFATAL_ERROR:
+  case PGRES_FATAL_ERROR: return true;
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  case PGRES_PIPELINE_ABORTED: return true;
+#endif
+  default: return false;
+  }
+}
 } // namespace
 
 
+pqxx::pipeline::Query *
+pqxx::pipeline::QueryRing::find(query_id qid) noexcept
+{
+  return contains(qid) ? &*slot(qid) : nullptr;
+}
+
+
+bool pqxx::pipeline::QueryRing::contains(query_id qid) const noexcept
+{
+  return qid >= m_base and qid < end_id() and m_slots[index(qid)].has_value();
+}
+
+
+void pqxx::pipeline::QueryRing::push_back(query_id qid, Query &&q)
+{
+  if (qid != end_id())
+    throw pqxx::internal_error{"Pipeline query ids out of sequence."};
+
+  if (m_size == m_slots.size())
+  {
+    // Full.  Move the queries into a bigger array, oldest first.
+    std::vector<std::optional<Query>> bigger(
+      std::max(m_slots.size() * 2, std::size_t{16}));
+    for (std::size_t i{0}; i < m_size; ++i)
+      bigger[i] = std::move(m_slots[(m_head + i) & (m_slots.size() - 1)]);
+    m_slots = std::move(bigger);
+    m_head = 0;
+  }
+
+  ++m_size;
+  slot(qid).emplace(std::move(q));
+}
+
+
+void pqxx::pipeline::QueryRing::erase(query_id qid) noexcept
+{
+  if (qid < m_base or qid >= end_id())
+    return;
+  slot(qid).reset();
+
+  // Recycle any empty slots at the front.
+  while (m_size > 0 and not m_slots[m_head].has_value())
+  {
+    m_head = (m_head + 1) & (m_slots.size() - 1);
+    --m_size;
+    ++m_base;
+  }
+}
+
+
+void pqxx::pipeline::QueryRing::clear() noexcept
+{
+  for (auto &s : m_slots) s.reset();
+  m_base = end_id();
+  m_head = 0;
+  m_size = 0;
+}
+
+
 void pqxx::pipeline::init()
 {
-  m_issuedrange = make_pair(m_queries.end(), m_queries.end());
+  m_issuedrange = std::make_pair(m_queries.end_id(), m_queries.end_id());
   attach();
 }
 
@@ -44,45 +164,145 @@ pqxx::pipeline::~pipeline() noexcept
   }
   catch (std::exception const &)
   {}
-  detach();
+  try
+  {
+    detach();
+  }
+  catch (std::exception const &)
+  {}
 }
 
 
 void pqxx::pipeline::attach()
 {
   if (not registered())
+  {
     register_me();
+    if constexpr (native_pipeline)
+    {
+      try
+      {
+        pqxx::internal::gate::connection_pipeline{m_trans.conn()}
+          .enter_pipeline_mode();
+      }
+      catch (std::exception const &)
+      {
+        unregister_me();
+        throw;
+      }
+    }
+    if (m_nonblocking)
+    {
+      try
+      {
+        pqxx::internal::gate::connection_pipeline{m_trans.conn()}
+          .set_nonblocking(true);
+      }
+      catch (std::exception const &)
+      {
+        if constexpr (native_pipeline)
+          pqxx::internal::gate::connection_pipeline{m_trans.conn()}
+            .exit_pipeline_mode();
+        unregister_me();
+        throw;
+      }
+    }
+  }
 }
 
 
 void pqxx::pipeline::detach()
 {
   if (registered())
+  {
+    if constexpr (native_pipeline)
+    {
+      try
+      {
+        drain_native();
+        pqxx::internal::gate::connection_pipeline{m_trans.conn()}
+          .exit_pipeline_mode();
+      }
+      catch (std::exception const &)
+      {
+        unregister_me();
+        throw;
+      }
+    }
+    if (m_nonblocking)
+    {
+      try
+      {
+        pqxx::internal::gate::connection_pipeline{m_trans.conn()}
+          .set_nonblocking(false);
+      }
+      catch (std::exception const &)
+      {
+        unregister_me();
+        throw;
+      }
+    }
     unregister_me();
+  }
 }
 
 
 pqxx::pipeline::query_id pqxx::pipeline::insert(std::string_view q)
 {
+  return insert_query(Query{q});
+}
+
+
+pqxx::pipeline::query_id
+pqxx::pipeline::insert(std::string_view q, result_callback callback)
+{
+  auto const qid{insert(q)};
+  on_result(qid, std::move(callback));
+  return qid;
+}
+
+
+pqxx::pipeline::query_id pqxx::pipeline::insert_discard(std::string_view q)
+{
+  Query query{q};
+  query.set_handler(discard_result);
+  return insert_query(std::move(query));
+}
+
+
+pqxx::pipeline::query_id pqxx::pipeline::insert_query(Query &&q)
+{
+  if (m_discard and not q.get_handler())
+    q.set_handler(discard_result);
   attach();
   query_id const qid{generate_id()};
-  auto const i{m_queries.insert(std::make_pair(qid, Query(q))).first};
-
-  if (m_issuedrange.second == m_queries.end())
+  // If all earlier queries have been issued, m_issuedrange.second already
+  // points at this one: the first query waiting to be issued.
+  auto const size{q.size()};
+  m_queries.push_back(qid, std::move(q));
+  if (m_num_waiting++ == 0)
+    m_waiting_since = clock::now();
+  m_waiting_bytes += size;
+
+  if (m_batching)
   {
-    m_issuedrange.second = i;
-    if (m_issuedrange.first == m_queries.end())
-      m_issuedrange.first = i;
+    if (have_pending())
+      receive_if_available();
+    if (want_issue())
+    {
+      make_room();
+      issue();
+    }
   }
-  m_num_waiting++;
-
-  if (m_num_waiting > m_retain)
+  else if (m_num_waiting > m_retain)
   {
     if (have_pending())
       receive_if_available();
-    if (not have_pending())
+    // In pipeline mode we can keep sending while results trickle in.
+    if (native_pipeline or not have_pending())
       issue();
   }
+  run_handlers();
 
   return qid;
 }
@@ -90,13 +310,29 @@ pqxx::pipeline::query_id pqxx::pipeline::insert(std::string_view q)
 
 void pqxx::pipeline::complete()
 {
-  if (have_pending())
-    receive(m_issuedrange.second);
-  if (m_num_waiting and (m_error == qid_limit()))
+  do
   {
-    issue();
-    receive(m_queries.end());
-  }
+    if constexpr (native_pipeline)
+    {
+      if (m_num_waiting and (m_error == qid_limit()))
+        issue();
+      if (have_pending())
+        receive(m_queries.end_id());
+    }
+    else
+    {
+      if (have_pending())
+        receive(m_issuedrange.second);
+      // A batch may stop short of the end, at a query with parameters.
+      while (m_num_waiting and (m_error == qid_limit()))
+      {
+        issue();
+        receive(m_issuedrange.second);
+      }
+    }
+    // Handlers may insert more queries.
+    run_handlers();
+  } while (have_pending() or (m_num_waiting and (m_error == qid_limit())));
   detach();
 }
 
@@ -107,10 +343,13 @@ void pqxx::pipeline::flush()
   {
     if (have_pending())
       receive(m_issuedrange.second);
-    m_issuedrange.first = m_issuedrange.second = m_queries.end();
     m_num_waiting = 0;
+    m_waiting_bytes = 0;
+    m_timed_qid = 0;
     m_dummy_pending = false;
     m_queries.clear();
+    m_issuedrange.first = m_issuedrange.second = m_queries.end_id();
+    m_in_doubt.clear();
   }
   detach();
 }
@@ -118,23 +357,40 @@ void pqxx::pipeline::flush()
 
 void pqxx::pipeline::cancel()
 {
-  while (have_pending())
+  if constexpr (native_pipeline)
   {
-    pqxx::internal::gate::connection_pipeline(m_trans.conn()).cancel_query();
-    auto canceled_query{m_issuedrange.first};
-    ++m_issuedrange.first;
-    m_queries.erase(canceled_query);
+    if (have_pending())
+    {
+      pqxx::internal::gate::connection_pipeline(m_trans.conn()).cancel_query();
+      // Whatever the outcome, the issued queries' results are of no further
+      // interest.  But they must be read, or the connection stays busy.
+      drain_native();
+      for (auto i{m_issuedrange.first}; i != m_issuedrange.second; ++i)
+        m_queries.erase(i);
+      m_issuedrange.first = m_issuedrange.second;
+    }
+  }
+  else
+  {
+    while (have_pending())
+    {
+      pqxx::internal::gate::connection_pipeline(m_trans.conn())
+        .cancel_query();
+      m_queries.erase(m_issuedrange.first);
+      ++m_issuedrange.first;
+    }
   }
+  m_timed_qid = 0;
 }
 
 
 bool pqxx::pipeline::is_finished(pipeline::query_id q) const
 {
-  if (m_queries.find(q) == m_queries.end())
+  if (not m_queries.contains(q))
     throw std::logic_error{"Requested status for unknown query '" +
                            to_string(q) + "'."};
-  return (QueryMap::const_iterator(m_issuedrange.first) == m_queries.end()) or
-         (q < m_issuedrange.first->first and q < m_error);
+  return (m_issuedrange.first == m_queries.end_id()) or
+         (q < m_issuedrange.first and q < m_error);
 }
 
 
@@ -142,7 +398,8 @@ std::pair<pqxx::pipeline::query_id, pqxx::result> pqxx::pipeline::retrieve()
 {
   if (m_queries.empty())
     throw std::logic_error{"Attempt to retrieve result from empty pipeline."};
-  return retrieve(std::begin(m_queries));
+  auto const oldest{m_queries.begin_id()};
+  return retrieve(oldest, &m_queries.at(oldest));
 }
 
 
@@ -154,6 +411,7 @@ int pqxx::pipeline::retain(int retain_max)
 
   int const oldvalue{m_retain};
   m_retain = retain_max;
+  m_batching.reset();
 
   if (m_num_waiting >= m_retain)
     resume();
@@ -162,15 +420,189 @@ int pqxx::pipeline::retain(int retain_max)
 }
 
 
+void pqxx::pipeline::retain(pipeline_batching const &policy)
+{
+  if (policy.max_in_flight < 0)
+    throw range_error{"Attempt to limit pipeline to " +
+                      to_string(policy.max_in_flight) +
+                      " queries in flight."};
+  m_batching = policy;
+  if (want_issue())
+    resume();
+}
+
+
+void pqxx::pipeline::set_resubmit(bool enable)
+{
+  if (enable)
+  {
+    if constexpr (not native_pipeline)
+      throw feature_not_supported{
+        "Resubmitting pipelined queries requires libpq pipeline mode."};
+    if (dynamic_cast<nontransaction *>(&m_trans) == nullptr)
+      throw usage_error{
+        "Pipeline can only resubmit queries in a nontransaction, not in " +
+        m_trans.description() + "."};
+  }
+  m_resubmit = enable;
+}
+
+
+void pqxx::pipeline::set_nonblocking(bool enable)
+{
+  if (enable == m_nonblocking)
+    return;
+  if (registered())
+    pqxx::internal::gate::connection_pipeline{m_trans.conn()}.set_nonblocking(
+      enable);
+  m_nonblocking = enable;
+}
+
+
+void pqxx::pipeline::mark_idempotent(query_id qid)
+{
+  auto const q{m_queries.find(qid)};
+  if (q == nullptr)
+    throw std::logic_error{
+      "Attempt to mark unknown query '" + to_string(qid) + "' idempotent."};
+  q->set_idempotent();
+}
+
+
+bool pqxx::pipeline::want_issue() const
+{
+  if (m_num_waiting == 0 or m_error < qid_limit())
+    return false;
+
+  // Don't let the server go idle.
+  if (not have_pending())
+    return true;
+
+  if (m_waiting_bytes >= m_batching->max_bytes)
+    return true;
+
+  // Waiting for the batch in flight would cost more than sending these now.
+  return m_rtt.count() > 0 and (clock::now() - m_waiting_since) >= m_rtt;
+}
+
+
+void pqxx::pipeline::make_room()
+{
+  if (not have_pending())
+    return;
+
+  if constexpr (not native_pipeline)
+  {
+    // Only one batch can be in flight at a time.
+    receive(m_issuedrange.second);
+  }
+  else
+  {
+    auto const limit{m_batching->max_in_flight};
+    if (limit == 0)
+      return;
+    auto const excess{in_flight() + m_num_waiting - limit};
+    if (excess > 0)
+      receive(m_issuedrange.first + std::min(excess, in_flight()));
+  }
+}
+
+
+void pqxx::pipeline::note_received() noexcept
+{
+  if (m_timed_qid == 0 or m_issuedrange.first <= m_timed_qid)
+    return;
+
+  // Exponential moving average, so one slow batch doesn't throw us off.
+  auto const sample{clock::now() - m_timed_start};
+  m_rtt = (m_rtt.count() == 0) ? sample : (m_rtt * 7 + sample) / 8;
+  m_timed_qid = 0;
+}
+
+
+void pqxx::pipeline::time_result(result const &res, bool failed)
+{
+  // The result is for the query just before m_issuedrange.first.  Batches
+  // that ended before it won't get any more results.
+  pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
+  auto const now{clock::now()};
+  auto const qid{m_issuedrange.first - 1};
+  while (not std::empty(m_batch_timing))
+  {
+    auto &batch{m_batch_timing.front()};
+    auto &stats{batch.stats};
+    if (qid < batch.stop)
+    {
+      if (stats.first_result.count() == 0)
+        stats.first_result = now - batch.start;
+      if (failed)
+        stats.failed = true;
+      else
+        stats.rows += std::empty(res) ? res.affected_rows() : std::size(res);
+      stats.bytes_received += res.memory_usage();
+      if (qid + 1 < batch.stop)
+        return;
+    }
+    stats.query = *batch.query;
+    stats.elapsed = now - batch.start;
+    gate.report_query(stats);
+    m_batch_timing.pop_front();
+  }
+}
+
+
+pqxx::pipeline::query_id pqxx::pipeline::issue_limit() const noexcept
+{
+  auto const end{m_queries.end_id()};
+  if (not m_batching or m_batching->max_in_flight == 0)
+    return end;
+  // Always issue at least one query, or we'd never make progress.
+  auto const room{std::max(
+    query_id{m_batching->max_in_flight} - in_flight(), query_id{1})};
+  return std::min(end, m_issuedrange.second + room);
+}
+
+
+void pqxx::pipeline::mark_issued(query_id oldest, query_id stop)
+{
+  std::size_t sent{0};
+  for (auto i{oldest}; i != stop; ++i) sent += m_queries.at(i).size();
+  m_waiting_bytes -= sent;
+  m_num_waiting -= check_cast<int>(stop - oldest, "pipeline issue()");
+  PQXX_TRACE3(pipeline__issue, this, oldest, stop - oldest);
+
+  auto const start{
+    pqxx::internal::gate::connection_pipeline{m_trans.conn()}.query_start()};
+  if (start != clock::time_point{})
+  {
+    batch_timing batch{stop, start, m_queries.at(oldest).get_query(), {}};
+    batch.stats.what = query_stats::kind::batch;
+    batch.stats.statements = static_cast<std::size_t>(stop - oldest);
+    batch.stats.bytes_sent = sent;
+    m_batch_timing.push_back(std::move(batch));
+  }
+
+  auto const now{clock::now()};
+  if (m_num_waiting > 0)
+    m_waiting_since = now;
+  if (m_timed_qid == 0)
+  {
+    m_timed_qid = stop - 1;
+    m_timed_start = now;
+  }
+}
+
+
 void pqxx::pipeline::resume()
 {
   if (have_pending())
     receive_if_available();
-  if (not have_pending() and m_num_waiting)
+  if ((native_pipeline or not have_pending()) and m_num_waiting)
   {
     issue();
     receive_if_available();
   }
+  run_handlers();
 }
 
 
@@ -185,6 +617,64 @@ pqxx::pipeline::query_id pqxx::pipeline::generate_id()
 
 void pqxx::pipeline::issue()
 {
+  if constexpr (native_pipeline)
+  {
+    // Don't issue anything if we've encountered an error.
+    if (m_error < qid_limit())
+      return;
+
+    // Queries may need issuing after the pipeline detached, e.g. when a
+    // caller retrieves results after a flush.  That takes pipeline mode.
+    attach();
+
+    auto const oldest{m_issuedrange.second}, stop{issue_limit()};
+    if (oldest == stop)
+      return;
+
+    // Each query goes out as a statement of its own, with no need to glue
+    // them all together into one big string.
+    pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
+    internal::params const no_params{};
+    auto sent{oldest};
+    try
+    {
+      for (; sent != stop; ++sent)
+      {
+        auto const &q{m_queries.at(sent)};
+        auto const text{q.get_query()->c_str()};
+        auto const args{q.get_params()};
+        if (q.is_prepared())
+          gate.start_exec_prepared(text, *args);
+        else
+          gate.start_exec_params(text, (args == nullptr) ? no_params : *args);
+      }
+      gate.pipeline_sync();
+    }
+    catch (std::exception const &)
+    {
+      if (not lost_connection())
+        throw;
+      // Whatever we sent may have reached the server.  The rest can wait
+      // for the next issue().
+      if (sent != oldest)
+      {
+        if (not have_pending())
+          m_issuedrange.first = oldest;
+        m_issuedrange.second = sent;
+        mark_issued(oldest, sent);
+      }
+      resubmit();
+      return;
+    }
+    ++m_pending_syncs;
+
+    if (not have_pending())
+      m_issuedrange.first = oldest;
+    m_issuedrange.second = stop;
+    mark_issued(oldest, stop);
+    return;
+  }
+
   // Retrieve that null result for the last query, if needed.
   obtain_result();
 
@@ -193,26 +683,61 @@ void pqxx::pipeline::issue()
     return;
 
   // Start with oldest query (lowest id) not in previous issue range.
-  auto oldest{m_issuedrange.second};
+  auto const oldest{m_issuedrange.second}, end{issue_limit()};
+  if (oldest == end)
+    return;
 
-  // Construct cumulative query string for entire batch.
-  auto cum{separated_list(
-    theSeparator, oldest, m_queries.end(),
-    [](QueryMap::const_iterator i) { return i->second.get_query(); })};
-  auto const num_issued{
-    QueryMap::size_type(std::distance(oldest, m_queries.end()))};
-  bool const prepend_dummy{num_issued > 1};
-  if (prepend_dummy)
-    cum = theDummyQuery + cum;
+  pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
 
-  pqxx::internal::gate::connection_pipeline{m_trans.conn()}.start_exec(
-    cum.c_str());
+  // A query with parameters can't share a query string with others, so it
+  // goes out on its own.  Plain queries batch up until the next one.
+  auto stop{oldest};
+  query_id num_issued{0};
+  auto const &first{m_queries.at(oldest)};
+  if (auto const args{first.get_params()}; args != nullptr)
+  {
+    auto const text{first.get_query()->c_str()};
+    if (first.is_prepared())
+      gate.start_exec_prepared(text, *args);
+    else
+      gate.start_exec_params(text, *args);
+    ++stop;
+    num_issued = 1;
+  }
+  else
+  {
+    std::size_t budget{0};
+    while (stop != end and m_queries.at(stop).get_params() == nullptr)
+    {
+      budget += std::size(*m_queries.at(stop).get_query());
+      ++stop;
+      ++num_issued;
+    }
+
+    // Construct cumulative query string for entire batch.
+    std::string cum;
+    if (num_issued > 1)
+    {
+      cum.reserve(
+        std::size(theDummyQuery) + budget +
+        std::size(theSeparator) * static_cast<std::size_t>(num_issued - 1));
+      cum = theDummyQuery;
+    }
+    for (auto i{oldest}; i != stop; ++i)
+    {
+      if (i != oldest)
+        cum += theSeparator;
+      cum += *m_queries.at(i).get_query();
+    }
+
+    gate.start_exec(cum.c_str());
+  }
 
   // Since we managed to send out these queries, update state to reflect this.
-  m_dummy_pending = prepend_dummy;
+  m_dummy_pending = (num_issued > 1);
   m_issuedrange.first = oldest;
-  m_issuedrange.second = m_queries.end();
-  m_num_waiting -= check_cast<int>(num_issued, "pipeline issue()");
+  m_issuedrange.second = stop;
+  mark_issued(oldest, stop);
 }
 
 
@@ -231,34 +756,215 @@ bool pqxx::pipeline::obtain_result(bool expect_none)
   {
     if (have_pending() and not expect_none)
     {
-      set_error_at(m_issuedrange.first->first);
+      set_error_at(m_issuedrange.first);
       m_issuedrange.second = m_issuedrange.first;
     }
     return false;
   }
 
+  auto const oldest{m_queries.begin_id()};
   result const res{pqxx::internal::gate::result_creation::create(
-    r, std::begin(m_queries)->second.get_query(),
-    internal::enc_group(m_trans.conn().encoding_id()))};
+    r, m_queries.at(oldest).get_query(),
+    m_trans.conn().enc_group())};
 
   if (not have_pending())
   {
-    set_error_at(std::begin(m_queries)->first);
+    set_error_at(oldest);
     throw std::logic_error{
       "Got more results from pipeline than there were queries."};
   }
 
   // Must be the result for the oldest pending query.
-  if (not m_issuedrange.first->second.get_result().empty())
+  auto &q{m_queries.at(m_issuedrange.first)};
+  if (not q.get_result().empty())
+    internal_error("Multiple results for one query.");
+
+  q.set_result(res);
+  PQXX_TRACE2(pipeline__receive, this, m_issuedrange.first);
+  ++m_issuedrange.first;
+  note_received();
+  if (not std::empty(m_batch_timing))
+    time_result(res, is_failure(r));
+
+  return true;
+}
+
+
+bool pqxx::pipeline::obtain_native_result(bool wait)
+{
+  if (not have_pending())
+    return false;
+
+  pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
+
+  // Skip past any synchronisation points from earlier batches.
+  auto r{gate.get_result()};
+  while (r != nullptr and is_sync(r))
+  {
+    internal::clear_result(r);
+    --m_pending_syncs;
+    if (not wait and gate.is_busy())
+      return false;
+    r = gate.get_result();
+  }
+
+  if (r == nullptr)
+  {
+    if (lost_connection())
+    {
+      resubmit();
+      return true;
+    }
+    set_error_at(m_issuedrange.first);
+    m_issuedrange.second = m_issuedrange.first;
+    return false;
+  }
+
+  bool const failed{is_failure(r)};
+  if (failed and lost_connection())
+  {
+    // This is not the query's own failure.  We just can't reach the server.
+    internal::clear_result(r);
+    resubmit();
+    return true;
+  }
+
+  auto const qid{m_issuedrange.first};
+  auto &q{m_queries.at(qid)};
+  result const res{pqxx::internal::gate::result_creation::create(
+    r, q.get_query(), m_trans.conn().enc_group())};
+
+  // In pipeline mode, each statement's results end in a null.
+  if (auto const tail{gate.get_result()}; tail != nullptr)
+  {
+    internal::clear_result(tail);
+    internal_error("Multiple results for one query.");
+  }
+
+  if (not q.get_result().empty())
     internal_error("Multiple results for one query.");
 
-  m_issuedrange.first->second.set_result(res);
+  q.set_result(res);
+  PQXX_TRACE2(pipeline__receive, this, m_issuedrange.first);
   ++m_issuedrange.first;
+  skip_in_doubt();
+  note_received();
+  if (not std::empty(m_batch_timing))
+    time_result(res, failed);
+
+  // Nothing after a failed statement gets executed.  The server tells us so
+  // by reporting the remainder of the batch as aborted.
+  if (failed)
+    set_error_at(qid + 1);
 
   return true;
 }
 
 
+void pqxx::pipeline::drain_native()
+{
+  pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
+  bool last_was_null{false};
+  while (m_pending_syncs > 0)
+  {
+    auto const r{gate.get_result()};
+    if (r == nullptr)
+    {
+      // A null ends each statement's results.  But two in a row means we're
+      // not getting anything more from this connection.
+      if (last_was_null)
+      {
+        m_pending_syncs = 0;
+        throw broken_connection{
+          "Lost track of pipeline: expected more results."};
+      }
+      last_was_null = true;
+    }
+    else
+    {
+      last_was_null = false;
+      if (is_sync(r))
+        --m_pending_syncs;
+      internal::clear_result(r);
+    }
+  }
+  m_issuedrange.first = m_issuedrange.second;
+  m_timed_qid = 0;
+}
+
+
+bool pqxx::pipeline::lost_connection() const noexcept
+{
+  return m_resubmit and (m_error == qid_limit()) and
+         not m_trans.conn().is_open();
+}
+
+
+void pqxx::pipeline::resubmit()
+{
+  // Nothing more is coming in from the old connection.
+  m_pending_syncs = 0;
+  m_batch_timing.clear();
+  m_timed_qid = 0;
+
+  // A query that was in flight may or may not have executed.
+  std::vector<query_id> again;
+  for (auto i{m_issuedrange.first}; i != m_issuedrange.second; ++i)
+  {
+    auto &q{m_queries.at(i)};
+    if (q.is_idempotent())
+    {
+      again.push_back(i);
+    }
+    else
+    {
+      q.set_in_doubt();
+      m_in_doubt.push_back(i);
+    }
+  }
+
+  pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
+  try
+  {
+    gate.reset_session();
+    gate.enter_pipeline_mode();
+    if (m_nonblocking)
+      gate.set_nonblocking(true);
+    internal::params const no_params{};
+    for (auto const i : again)
+    {
+      auto const &q{m_queries.at(i)};
+      auto const text{q.get_query()->c_str()};
+      auto const args{q.get_params()};
+      if (q.is_prepared())
+        gate.start_exec_prepared(text, *args);
+      else
+        gate.start_exec_params(text, (args == nullptr) ? no_params : *args);
+    }
+    if (not std::empty(again))
+    {
+      gate.pipeline_sync();
+      ++m_pending_syncs;
+    }
+  }
+  catch (std::exception const &)
+  {
+    // No use going on without a connection.
+    set_error_at(m_issuedrange.first);
+    m_issuedrange.second = m_issuedrange.first;
+    throw;
+  }
+  skip_in_doubt();
+}
+
+
+void pqxx::pipeline::skip_in_doubt() noexcept
+{
+  while (have_pending() and m_queries.at(m_issuedrange.first).is_in_doubt())
+    ++m_issuedrange.first;
+}
+
+
 void pqxx::pipeline::obtain_dummy()
 {
   pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
@@ -274,7 +980,7 @@ void pqxx::pipeline::obtain_dummy()
     std::make_shared<std::string>("[DUMMY PIPELINE QUERY]")};
 
   result R{pqxx::internal::gate::result_creation::create(
-    r, text, internal::enc_group(m_trans.conn().encoding_id()))};
+    r, text, m_trans.conn().enc_group())};
 
   bool OK{false};
   try
@@ -304,7 +1010,7 @@ void pqxx::pipeline::obtain_dummy()
   // First, give the whole batch the same syntax error message, in case all
   // else is going to fail.
   for (auto i{m_issuedrange.first}; i != m_issuedrange.second; ++i)
-    i->second.set_result(R);
+    m_queries.at(i).set_result(R);
 
   // Remember where the end of this batch was
   auto const stop{m_issuedrange.second};
@@ -313,51 +1019,52 @@ void pqxx::pipeline::obtain_dummy()
   obtain_result(true);
 
   // Reset internal state to forget botched batch attempt
-  m_num_waiting += check_cast<int>(
-    std::distance(m_issuedrange.first, stop), "pipeline obtain_dummy()");
+  m_num_waiting +=
+    check_cast<int>(stop - m_issuedrange.first, "pipeline obtain_dummy()");
   m_issuedrange.second = m_issuedrange.first;
 
-  // Issue queries in failed batch one at a time.
+  // Issue queries in failed batch one at a time.  Their timings would only
+  // throw off round-trip time measurement.
+  m_timed_qid = 0;
   unregister_me();
   try
   {
     do
     {
       m_num_waiting--;
-      auto const query{*m_issuedrange.first->second.get_query()};
+      auto &q{m_queries.at(m_issuedrange.first)};
+      auto const query{*q.get_query()};
       result const res{m_trans.exec(query)};
-      m_issuedrange.first->second.set_result(res);
+      q.set_result(res);
       pqxx::internal::gate::result_creation{res}.check_status();
       ++m_issuedrange.first;
     } while (m_issuedrange.first != stop);
   }
   catch (std::exception const &)
   {
-    auto const thud{m_issuedrange.first->first};
     ++m_issuedrange.first;
     m_issuedrange.second = m_issuedrange.first;
-    auto q{m_issuedrange.first};
-    set_error_at((q == m_queries.end()) ? thud + 1 : q->first);
+    set_error_at(m_issuedrange.first);
   }
 }
 
 
 std::pair<pqxx::pipeline::query_id, pqxx::result>
-pqxx::pipeline::retrieve(pipeline::QueryMap::iterator q)
+pqxx::pipeline::retrieve(query_id qid, Query *q)
 {
-  if (q == m_queries.end())
+  if (q == nullptr)
     throw std::logic_error{"Attempt to retrieve result for unknown query."};
 
-  if (q->first >= m_error)
+  if (qid >= m_error)
     throw std::runtime_error{
       "Could not complete query in pipeline due to error in earlier query."};
 
-  // If query hasn't issued yet, do it now.
-  if (
-    m_issuedrange.second != m_queries.end() and
-    (q->first >= m_issuedrange.second->first))
+  // If query hasn't issued yet, do it now.  Without native pipeline mode,
+  // that may take several batches.
+  while (m_issuedrange.second != m_queries.end_id() and
+         (qid >= m_issuedrange.second) and (m_error == qid_limit()))
   {
-    if (have_pending())
+    if (not native_pipeline and have_pending())
       receive(m_issuedrange.second);
     if (m_error == qid_limit())
       issue();
@@ -366,42 +1073,162 @@ pqxx::pipeline::retrieve(pipeline::QueryMap::iterator q)
   // If result not in yet, get it; else get at least whatever's convenient.
   if (have_pending())
   {
-    if (q->first >= m_issuedrange.first->first)
-    {
-      auto suc{q};
-      ++suc;
-      receive(suc);
-    }
+    if (qid >= m_issuedrange.first)
+      receive(qid + 1);
     else
-    {
       receive_if_available();
-    }
   }
 
-  if (q->first >= m_error)
+  if (qid >= m_error)
     throw std::runtime_error{
       "Could not complete query in pipeline due to error in earlier query."};
 
   // Don't leave the backend idle if there are queries waiting to be issued.
-  if (m_num_waiting and not have_pending() and (m_error == qid_limit()))
+  if (
+    m_num_waiting and (native_pipeline or not have_pending()) and
+    (m_error == qid_limit()))
     issue();
 
-  result const R{q->second.get_result()};
-  auto const P{std::make_pair(q->first, R)};
+  if (q->is_in_doubt())
+  {
+    m_queries.erase(qid);
+    throw in_doubt_error{
+      "Lost connection while query " + to_string(qid) +
+      " was in flight.  It may or may not have executed."};
+  }
 
-  m_queries.erase(q);
+  result const R{q->get_result()};
+  auto const P{std::make_pair(qid, R)};
+
+  m_queries.erase(qid);
 
   pqxx::internal::gate::result_creation{R}.check_status();
   return P;
 }
 
 
+void pqxx::pipeline::on_result(query_id qid, result_callback callback)
+{
+  set_handler(
+    qid, [callback = std::move(callback)](
+           query_id id, result const &r, std::exception_ptr err) {
+      if (err)
+        std::rethrow_exception(err);
+      callback(id, r);
+    });
+  run_handlers();
+}
+
+
+std::future<pqxx::result> pqxx::pipeline::get_future(query_id qid)
+{
+  // A std::function must be copyable, so share the promise.
+  auto const promise{std::make_shared<std::promise<result>>()};
+  auto future{promise->get_future()};
+  set_handler(
+    qid, [promise](query_id, result const &r, std::exception_ptr err) {
+      if (err)
+        promise->set_exception(err);
+      else
+        promise->set_value(r);
+    });
+  run_handlers();
+  return future;
+}
+
+
+void pqxx::pipeline::set_handler(query_id qid, handler &&h)
+{
+  auto const q{m_queries.find(qid)};
+  if (q == nullptr)
+    throw std::logic_error{
+      "Attempt to await result for unknown query '" + to_string(qid) + "'."};
+  q->set_handler(std::move(h));
+  // The result may already be in.  Make sure run_handlers() looks again.
+  if (qid < m_handler_scan)
+    m_handler_scan = qid;
+}
+
+
+void pqxx::pipeline::run_handlers()
+{
+  // A handler may call back into the pipeline, which may call this function
+  // again.  Leave the work to the outer invocation.
+  if (m_running_handlers)
+    return;
+  m_running_handlers = true;
+  try
+  {
+    for (;;)
+    {
+      // Results are in up to the start of the issued range.  After an
+      // error, nothing beyond it will ever complete; but wait until the
+      // queries that are in flight are no longer pending.
+      auto const stop{
+        ((m_error == qid_limit()) or have_pending()) ? m_issuedrange.first :
+                                                       m_queries.end_id()};
+      auto const qid{std::max(m_handler_scan, m_queries.begin_id())};
+      if (qid >= stop)
+        break;
+      m_handler_scan = qid + 1;
+
+      auto const q{m_queries.find(qid)};
+      if (q == nullptr or not q->get_handler())
+        continue;
+
+      handler const h{std::move(q->get_handler())};
+      result const r{q->get_result()};
+      m_queries.erase(qid);
+
+      std::exception_ptr err;
+      if (q->is_in_doubt())
+        err = std::make_exception_ptr(in_doubt_error{
+          "Lost connection while query " + to_string(qid) +
+          " was in flight.  It may or may not have executed."});
+      else if (qid >= m_error)
+        err = std::make_exception_ptr(std::runtime_error{
+          "Could not complete query in pipeline due to error in earlier "
+          "query."});
+      else
+        try
+        {
+          pqxx::internal::gate::result_creation{r}.check_status();
+        }
+        catch (std::exception const &)
+        {
+          err = std::current_exception();
+        }
+      h(qid, r, err);
+    }
+  }
+  catch (...)
+  {
+    m_running_handlers = false;
+    throw;
+  }
+  m_running_handlers = false;
+}
+
+
 void pqxx::pipeline::get_further_available_results()
 {
   pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
-  while (not gate.is_busy() and obtain_result())
-    if (not gate.consume_input())
-      throw broken_connection{};
+  if constexpr (native_pipeline)
+  {
+    while (not gate.is_busy() and obtain_native_result(false))
+      if (not gate.consume_input())
+      {
+        if (not lost_connection())
+          throw broken_connection{};
+        resubmit();
+      }
+  }
+  else
+  {
+    while (not gate.is_busy() and obtain_result())
+      if (not gate.consume_input())
+        throw broken_connection{};
+  }
 }
 
 
@@ -409,7 +1236,12 @@ void pqxx::pipeline::receive_if_available()
 {
   pqxx::internal::gate::connection_pipeline gate{m_trans.conn()};
   if (not gate.consume_input())
-    throw broken_connection{};
+  {
+    if (not lost_connection())
+      throw broken_connection{};
+    resubmit();
+    return;
+  }
   if (gate.is_busy())
     return;
 
@@ -420,16 +1252,24 @@ void pqxx::pipeline::receive_if_available()
 }
 
 
-void pqxx::pipeline::receive(pipeline::QueryMap::const_iterator stop)
+void pqxx::pipeline::receive(query_id stop)
 {
-  if (m_dummy_pending)
-    obtain_dummy();
+  if constexpr (native_pipeline)
+  {
+    // Resubmission may skip past stop, if the query there is in doubt.
+    while (obtain_native_result(true) and m_issuedrange.first < stop)
+      ;
+  }
+  else
+  {
+    if (m_dummy_pending)
+      obtain_dummy();
 
-  while (obtain_result() and
-         QueryMap::const_iterator{m_issuedrange.first} != stop)
-    ;
+    while (obtain_result() and m_issuedrange.first != stop)
+      ;
+  }
 
   // Also haul in any remaining "targets of opportunity".
-  if (QueryMap::const_iterator{m_issuedrange.first} == stop)
+  if (m_issuedrange.first >= stop)
     get_further_available_results();
 }
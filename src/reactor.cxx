@@ -0,0 +1,785 @@
+/** Implementation of the pqxx::reactor class.
+ *
+ * pqxx::reactor drives queries and notifications on many connections.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#if __has_include(<sys/epoll.h>)
+// For epoll, on Linux.
+#  include <sys/epoll.h>
+#  include <unistd.h>
+#elif __has_include(<sys/event.h>)
+// For kqueue, on the BSDs and macOS.
+#  include <sys/types.h>
+#  include <sys/event.h>
+#  include <sys/time.h>
+#  include <unistd.h>
+#elif defined(_WIN32) && (_WIN32_WINNT >= 0x0600)
+// For WSAPoll().
+#  include <winsock2.h>
+#elif __has_include(<poll.h>)
+#  include <poll.h>
+#else
+// No poll()?  Our last option is select().
+#  if __has_include(<sys/select.h>)
+#    include <sys/select.h>
+#  endif
+#  if __has_include(<sys/types.h>)
+#    include <sys/types.h>
+#  endif
+#  if __has_include(<sys/time.h>)
+#    include <sys/time.h>
+#  endif
+#endif
+
+#include "pqxx/reactor"
+
+#include "pqxx/internal/gates/connection-reactor.hxx"
+#include "pqxx/internal/gates/result-creation.hxx"
+
+
+namespace
+{
+/// Throw an exception for error code @c err, which occurred in @c op.
+[[noreturn]] void throw_wait_error(char const op[], int err)
+{
+  throw pqxx::broken_connection{
+    std::string{op} + " failed: " + std::system_category().message(err)};
+}
+
+
+/// How often to follow up on a non-blocking cancel request.
+/** The reactor doesn't watch the cancel request's socket, so it checks back
+ * on its progress at this interval instead.
+ */
+constexpr std::chrono::milliseconds cancel_poll_interval{5};
+
+
+[[maybe_unused]] int to_milliseconds(std::chrono::milliseconds timeout)
+{
+  if (timeout.count() < 0)
+    return -1;
+  return pqxx::check_cast<int>(timeout.count(), "reactor timeout");
+}
+} // namespace
+
+
+/// Platform-specific way of waiting for many sockets at once.
+/** Watches sockets for reading.  Each socket has a "key" pointer, which the
+ * backend hands back when that socket is ready.
+ */
+class PQXX_PRIVATE pqxx::reactor::backend
+{
+public:
+  backend();
+  backend(backend const &) = delete;
+  ~backend() noexcept;
+  backend &operator=(backend const &) = delete;
+
+  void add(int fd, void *key);
+  /// Stop watching @c fd.  Does not complain if it was already closed.
+  void remove(int fd) noexcept;
+
+  /// Wait for sockets to become readable.  Replaces @c ready with their keys.
+  void wait(std::chrono::milliseconds timeout, std::vector<void *> &ready);
+
+private:
+#if __has_include(<sys/epoll.h>)
+  int m_epoll;
+  std::vector<epoll_event> m_events;
+#elif __has_include(<sys/event.h>)
+  int m_kqueue;
+  std::vector<struct kevent> m_events;
+#else
+  std::vector<int> m_fds;
+  std::vector<void *> m_keys;
+#endif
+};
+
+
+#if __has_include(<sys/epoll.h>)
+
+pqxx::reactor::backend::backend() : m_epoll{epoll_create1(EPOLL_CLOEXEC)}
+{
+  if (m_epoll < 0)
+    throw_wait_error("epoll_create1()", errno);
+}
+
+
+pqxx::reactor::backend::~backend() noexcept
+{
+  close(m_epoll);
+}
+
+
+void pqxx::reactor::backend::add(int fd, void *key)
+{
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.ptr = key;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0)
+    throw_wait_error("epoll_ctl()", errno);
+  m_events.resize(std::size(m_events) + 1);
+}
+
+
+void pqxx::reactor::backend::remove(int fd) noexcept
+{
+  // If libpq has closed the socket, epoll has already forgotten it.
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+  if (not std::empty(m_events))
+    m_events.pop_back();
+}
+
+
+void pqxx::reactor::backend::wait(
+  std::chrono::milliseconds timeout, std::vector<void *> &ready)
+{
+  ready.clear();
+  if (std::empty(m_events))
+    return;
+  int const n{epoll_wait(
+    m_epoll, m_events.data(), static_cast<int>(std::size(m_events)),
+    to_milliseconds(timeout))};
+  if (n < 0)
+  {
+    if (errno == EINTR)
+      return;
+    throw_wait_error("epoll_wait()", errno);
+  }
+  for (int i{0}; i < n; ++i)
+    ready.push_back(m_events[std::size_t(i)].data.ptr);
+}
+
+#elif __has_include(<sys/event.h>)
+
+pqxx::reactor::backend::backend() : m_kqueue{kqueue()}
+{
+  if (m_kqueue < 0)
+    throw_wait_error("kqueue()", errno);
+}
+
+
+pqxx::reactor::backend::~backend() noexcept
+{
+  close(m_kqueue);
+}
+
+
+void pqxx::reactor::backend::add(int fd, void *key)
+{
+  struct kevent ev;
+  EV_SET(&ev, fd, EVFILT_READ, EV_ADD, 0, 0, key);
+  if (kevent(m_kqueue, &ev, 1, nullptr, 0, nullptr) < 0)
+    throw_wait_error("kevent()", errno);
+  m_events.resize(std::size(m_events) + 1);
+}
+
+
+void pqxx::reactor::backend::remove(int fd) noexcept
+{
+  // If libpq has closed the socket, kqueue has already forgotten it.
+  struct kevent ev;
+  EV_SET(&ev, fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+  kevent(m_kqueue, &ev, 1, nullptr, 0, nullptr);
+  if (not std::empty(m_events))
+    m_events.pop_back();
+}
+
+
+void pqxx::reactor::backend::wait(
+  std::chrono::milliseconds timeout, std::vector<void *> &ready)
+{
+  ready.clear();
+  if (std::empty(m_events))
+    return;
+  auto const secs{
+    std::chrono::duration_cast<std::chrono::seconds>(timeout)};
+  auto const nsecs{
+    std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - secs)};
+  timespec const ts{
+    static_cast<decltype(timespec::tv_sec)>(secs.count()),
+    static_cast<decltype(timespec::tv_nsec)>(nsecs.count())};
+  int const n{kevent(
+    m_kqueue, nullptr, 0, m_events.data(),
+    static_cast<int>(std::size(m_events)),
+    (timeout.count() < 0) ? nullptr : &ts)};
+  if (n < 0)
+  {
+    if (errno == EINTR)
+      return;
+    throw_wait_error("kevent()", errno);
+  }
+  for (int i{0}; i < n; ++i) ready.push_back(m_events[std::size_t(i)].udata);
+}
+
+#else
+
+pqxx::reactor::backend::backend() = default;
+pqxx::reactor::backend::~backend() noexcept = default;
+
+
+void pqxx::reactor::backend::add(int fd, void *key)
+{
+  m_fds.push_back(fd);
+  m_keys.push_back(key);
+}
+
+
+void pqxx::reactor::backend::remove(int fd) noexcept
+{
+  auto const here{std::find(std::begin(m_fds), std::end(m_fds), fd)};
+  if (here == std::end(m_fds))
+    return;
+  auto const i{std::distance(std::begin(m_fds), here)};
+  m_keys.erase(std::begin(m_keys) + i);
+  m_fds.erase(here);
+}
+
+
+void pqxx::reactor::backend::wait(
+  std::chrono::milliseconds timeout, std::vector<void *> &ready)
+{
+  ready.clear();
+  if (std::empty(m_fds))
+    return;
+
+#  if defined(_WIN32) && (_WIN32_WINNT >= 0x0600)
+  std::vector<WSAPOLLFD> fds;
+  fds.reserve(std::size(m_fds));
+  for (auto const fd : m_fds)
+    fds.push_back(WSAPOLLFD{SOCKET(fd), POLLRDNORM, 0});
+  if (
+    WSAPoll(fds.data(), static_cast<ULONG>(std::size(fds)),
+      to_milliseconds(timeout)) < 0)
+  {
+    int const err{WSAGetLastError()};
+    if (err == WSAEINTR)
+      return;
+    throw_wait_error("WSAPoll()", err);
+  }
+  for (std::size_t i{0}; i < std::size(fds); ++i)
+    if (fds[i].revents != 0)
+      ready.push_back(m_keys[i]);
+#  elif __has_include(<poll.h>)
+  std::vector<pollfd> fds;
+  fds.reserve(std::size(m_fds));
+  for (auto const fd : m_fds) fds.push_back(pollfd{fd, POLLIN, 0});
+  if (
+    ::poll(fds.data(), static_cast<nfds_t>(std::size(fds)),
+      to_milliseconds(timeout)) < 0)
+  {
+    if (errno == EINTR)
+      return;
+    throw_wait_error("poll()", errno);
+  }
+  for (std::size_t i{0}; i < std::size(fds); ++i)
+    if (fds[i].revents != 0)
+      ready.push_back(m_keys[i]);
+#  else
+  fd_set read_fds;
+  FD_ZERO(&read_fds);
+  int max_fd{0};
+  for (auto const fd : m_fds)
+  {
+    FD_SET(fd, &read_fds);
+    max_fd = std::max(max_fd, fd);
+  }
+  auto const secs{
+    std::chrono::duration_cast<std::chrono::seconds>(timeout)};
+  auto const usecs{
+    std::chrono::duration_cast<std::chrono::microseconds>(timeout - secs)};
+  timeval tv{
+    static_cast<decltype(timeval::tv_sec)>(secs.count()),
+    static_cast<decltype(timeval::tv_usec)>(usecs.count())};
+  if (
+    select(
+      max_fd + 1, &read_fds, nullptr, nullptr,
+      (timeout.count() < 0) ? nullptr : &tv) < 0)
+  {
+    if (errno == EINTR)
+      return;
+    throw_wait_error("select()", errno);
+  }
+  for (std::size_t i{0}; i < std::size(m_fds); ++i)
+    if (FD_ISSET(m_fds[i], &read_fds))
+      ready.push_back(m_keys[i]);
+#  endif
+}
+
+#endif
+
+
+pqxx::reactor::reactor() : m_backend{std::make_unique<backend>()} {}
+
+
+pqxx::reactor::~reactor() noexcept = default;
+
+
+pqxx::reactor::watched &pqxx::reactor::find(connection &c)
+{
+  for (auto &w : m_watched)
+    if (w->conn == &c)
+      return *w;
+  throw usage_error{"Connection is not registered with this reactor."};
+}
+
+
+void pqxx::reactor::add(connection &c)
+{
+  for (auto const &w : m_watched)
+    if (w->conn == &c)
+      throw usage_error{"Connection is already registered with reactor."};
+  int const fd{c.sock()};
+  if (fd < 0)
+    throw broken_connection{"No connection."};
+
+  m_watched.push_back(std::make_unique<watched>(watched{&c, fd}));
+  try
+  {
+    m_backend->add(fd, m_watched.back().get());
+  }
+  catch (std::exception const &)
+  {
+    m_watched.pop_back();
+    throw;
+  }
+}
+
+
+void pqxx::reactor::remove(connection &c)
+{
+  auto &w{find(c)};
+  if (not std::empty(w.queries) and not w.broken)
+    throw usage_error{
+      "Can't remove connection from reactor while it has queries pending."};
+  forget(w);
+}
+
+
+void pqxx::reactor::forget(watched &w) noexcept
+{
+  if (not w.broken)
+    m_backend->remove(w.fd);
+  // Don't destroy the object just yet: we may be iterating over keys that
+  // point to it.  The next poll() cleans it up.
+  w.conn = nullptr;
+  m_stale = true;
+}
+
+
+void pqxx::reactor::sweep()
+{
+  if (not m_stale)
+    return;
+  m_watched.erase(
+    std::remove_if(
+      std::begin(m_watched), std::end(m_watched),
+      [](auto const &w) { return w->conn == nullptr; }),
+    std::end(m_watched));
+  m_stale = false;
+}
+
+
+std::size_t pqxx::reactor::size() const noexcept
+{
+  return static_cast<std::size_t>(std::count_if(
+    std::begin(m_watched), std::end(m_watched),
+    [](auto const &w) { return w->conn != nullptr; }));
+}
+
+
+void pqxx::reactor::exec(
+  connection &c, std::string query, query_callback callback)
+{
+  enqueue(
+    c, queued_query{
+         std::make_shared<std::string>(std::move(query)),
+         std::move(callback)});
+}
+
+
+pqxx::query_future
+pqxx::reactor::async_exec(connection &c, std::string query)
+{
+  auto [future, callback]{make_future()};
+  exec(c, std::move(query), std::move(callback));
+  return future;
+}
+
+
+std::pair<pqxx::query_future, pqxx::reactor::query_callback>
+pqxx::reactor::make_future()
+{
+  auto const s{std::make_shared<query_future::state>()};
+  return {query_future{*this, s}, [s](result const &r, std::exception_ptr e) {
+            s->res = r;
+            s->error = std::move(e);
+            s->done = true;
+          }};
+}
+
+
+void pqxx::reactor::enqueue(connection &c, queued_query &&q)
+{
+  auto &w{find(c)};
+  if (w.broken)
+    throw broken_connection{"Connection lost."};
+  if (w.query_timeout.count() > 0)
+    q.deadline = clock::now() + w.query_timeout;
+
+  bool const idle{std::empty(w.queries) and not w.cancelling};
+  w.queries.push_back(std::move(q));
+  ++m_pending;
+  if (idle)
+    try
+    {
+      send(w);
+    }
+    catch (std::exception const &)
+    {
+      w.queries.pop_back();
+      --m_pending;
+      throw;
+    }
+}
+
+
+void pqxx::reactor::set_query_timeout(
+  connection &c, std::chrono::milliseconds timeout)
+{
+  find(c).query_timeout = std::max(timeout, std::chrono::milliseconds{0});
+  if (timeout.count() > 0)
+    m_deadlines = true;
+}
+
+
+void pqxx::reactor::cancel_after(
+  connection &c, std::chrono::milliseconds timeout)
+{
+  auto &w{find(c)};
+  if (timeout.count() > 0)
+  {
+    w.cancel_at = clock::now() + timeout;
+    m_deadlines = true;
+  }
+  else
+  {
+    w.cancel_at = clock::time_point::max();
+  }
+}
+
+
+void pqxx::reactor::on_readable(connection &c, ready_callback callback)
+{
+  find(c).on_readable = std::move(callback);
+}
+
+
+void pqxx::reactor::once_readable(connection &c, ready_callback callback)
+{
+  find(c).once_readable = std::move(callback);
+}
+
+
+void pqxx::reactor::send(watched &w)
+{
+  auto const &q{w.queries.front()};
+  pqxx::internal::gate::connection_reactor gate{*w.conn};
+  if (q.args == nullptr)
+    gate.start_exec(q.text->c_str());
+  else if (q.prepared)
+    gate.start_exec_prepared(q.text->c_str(), *q.args);
+  else
+    gate.start_exec_params(q.text->c_str(), *q.args);
+  w.running = true;
+}
+
+
+void pqxx::reactor::start_next(watched &w)
+{
+  // Don't let a cancel request that's still on its way hit the next query.
+  if (w.cancelling)
+    return;
+  while (not std::empty(w.queries)) try
+    {
+      send(w);
+      return;
+    }
+    catch (std::exception const &)
+    {
+      m_done.push_back(
+        {std::move(w.queries.front().callback), result{},
+         std::current_exception()});
+      w.queries.pop_front();
+    }
+}
+
+
+void pqxx::reactor::receive(watched &w)
+{
+  pqxx::internal::gate::connection_reactor gate{*w.conn};
+  while (not std::empty(w.queries) and not gate.is_busy())
+  {
+    auto &q{w.queries.front()};
+    auto const r{gate.get_result()};
+    if (r == nullptr)
+    {
+      // That's the last result for this query.
+      m_done.push_back(
+        {std::move(q.callback), std::move(w.last), std::move(w.error)});
+      w.last = result{};
+      w.error = nullptr;
+      w.queries.pop_front();
+      w.running = false;
+      start_next(w);
+    }
+    else
+    {
+      auto const res{pqxx::internal::gate::result_creation::create(
+        r, q.text, gate.enc_group())};
+      if (not w.error)
+        try
+        {
+          pqxx::internal::gate::result_creation{res}.check_status();
+          w.last = res;
+        }
+        catch (std::exception const &)
+        {
+          w.error = std::current_exception();
+        }
+    }
+  }
+}
+
+
+void pqxx::reactor::break_connection(watched &w, std::exception_ptr err)
+{
+  m_backend->remove(w.fd);
+  w.broken = true;
+  for (auto &q : w.queries)
+    m_done.push_back({std::move(q.callback), result{}, err});
+  w.queries.clear();
+  w.last = result{};
+  w.error = nullptr;
+  w.running = false;
+  w.cancelling = false;
+}
+
+
+void pqxx::reactor::dispatch(watched &w)
+{
+  if (w.once_readable)
+  {
+    // Move the callback out first: it may register a new one.
+    auto const callback{std::move(w.once_readable)};
+    w.once_readable = nullptr;
+    callback(*w.conn);
+    return;
+  }
+  if (w.on_readable)
+  {
+    // Call a copy, in case the callback replaces or clears itself.
+    auto const callback{w.on_readable};
+    callback(*w.conn);
+    return;
+  }
+
+  if (not pqxx::internal::gate::connection_reactor{*w.conn}.consume_input())
+  {
+    break_connection(
+      w, std::make_exception_ptr(broken_connection{"Connection lost."}));
+    return;
+  }
+  receive(w);
+  w.conn->get_notifs();
+}
+
+
+void pqxx::reactor::cancel(watched &w)
+{
+  try
+  {
+    w.cancelling =
+      not pqxx::internal::gate::connection_reactor{*w.conn}.start_cancel();
+  }
+  catch (std::exception const &)
+  {
+    w.cancelling = false;
+    // If there's a query, it reports the failure once it completes.
+    if (not w.running)
+      throw;
+    if (not w.error)
+      w.error = std::current_exception();
+  }
+}
+
+
+void pqxx::reactor::expire()
+{
+  auto const now{clock::now()};
+  for (auto &ptr : m_watched)
+  {
+    auto &w{*ptr};
+    if (w.conn == nullptr or w.broken)
+      continue;
+
+    bool due{false};
+    if (now >= w.cancel_at)
+    {
+      w.cancel_at = clock::time_point::max();
+      due = true;
+    }
+    if (w.running and now >= w.queries.front().deadline)
+    {
+      auto &q{w.queries.front()};
+      q.deadline = clock::time_point::max();
+      if (not w.error)
+        w.error = std::make_exception_ptr(
+          sql_error{"Query timed out.", *q.text, "57014"});
+      due = true;
+    }
+
+    if (w.cancelling)
+    {
+      // A cancel request is in flight already.  See how it's getting on.
+      try
+      {
+        w.cancelling =
+          not pqxx::internal::gate::connection_reactor{*w.conn}.poll_cancel();
+      }
+      catch (std::exception const &)
+      {
+        w.cancelling = false;
+        if (not w.running)
+          throw;
+        if (not w.error)
+          w.error = std::current_exception();
+      }
+      if (not w.cancelling and not w.running)
+        start_next(w);
+    }
+    else if (due)
+    {
+      cancel(w);
+    }
+  }
+}
+
+
+std::chrono::milliseconds
+pqxx::reactor::until_deadline(std::chrono::milliseconds timeout) const
+{
+  auto next{clock::time_point::max()};
+  bool cancelling{false};
+  for (auto const &w : m_watched)
+  {
+    if (w->conn == nullptr or w->broken)
+      continue;
+    next = std::min(next, w->cancel_at);
+    if (w->running)
+      next = std::min(next, w->queries.front().deadline);
+    cancelling = cancelling or w->cancelling;
+  }
+
+  if (cancelling and (timeout.count() < 0 or timeout > cancel_poll_interval))
+    timeout = cancel_poll_interval;
+  if (next == clock::time_point::max())
+    return timeout;
+  auto const left{std::max(
+    std::chrono::ceil<std::chrono::milliseconds>(next - clock::now()),
+    std::chrono::milliseconds{0})};
+  return (timeout.count() < 0) ? left : std::min(timeout, left);
+}
+
+
+void pqxx::reactor::deliver()
+{
+  while (not std::empty(m_done))
+  {
+    // Take the completion off the list before calling it, so that if the
+    // callback throws, we're still in a consistent state.
+    auto const done{std::move(m_done.front())};
+    m_done.pop_front();
+    --m_pending;
+    if (done.callback)
+      done.callback(done.res, done.error);
+  }
+}
+
+
+std::size_t pqxx::reactor::poll(std::chrono::milliseconds timeout)
+{
+  sweep();
+
+  // If an earlier callback threw, there may still be completions waiting for
+  // delivery.  In that case, don't keep them waiting any longer.
+  if (not std::empty(m_done))
+  {
+    timeout = std::chrono::milliseconds{0};
+    deliver();
+  }
+  if (m_deadlines)
+    timeout = until_deadline(timeout);
+
+  m_backend->wait(timeout, m_ready);
+  std::size_t handled{0};
+  while (not std::empty(m_ready))
+  {
+    auto &w{*static_cast<watched *>(m_ready.back())};
+    m_ready.pop_back();
+    // A callback may have removed this connection in the meantime.
+    if (w.conn == nullptr or w.broken)
+      continue;
+    ++handled;
+    dispatch(w);
+    deliver();
+  }
+  if (m_deadlines)
+  {
+    expire();
+    deliver();
+  }
+  return handled;
+}
+
+
+void pqxx::reactor::run()
+{
+  while (m_pending > 0) poll(std::chrono::milliseconds{-1});
+}
+
+
+pqxx::result pqxx::query_future::get()
+{
+  while (not m_state->done) m_reactor->poll(std::chrono::milliseconds{-1});
+  if (m_state->error)
+    std::rethrow_exception(m_state->error);
+  return m_state->res;
+}
+
+
+bool pqxx::query_future::wait_for(std::chrono::milliseconds timeout)
+{
+  using clock = std::chrono::steady_clock;
+  auto const deadline{clock::now() + timeout};
+  while (not m_state->done)
+  {
+    auto const left{std::chrono::ceil<std::chrono::milliseconds>(
+      deadline - clock::now())};
+    if (left.count() <= 0)
+      break;
+    m_reactor->poll(left);
+  }
+  return m_state->done;
+}
@@ -0,0 +1,278 @@
+/** Implementation of the pqxx::replication_stream class.
+ *
+ * pqxx::replication_stream consumes a logical replication stream.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "pqxx/binary_traits"
+#include "pqxx/except"
+#include "pqxx/replication_stream"
+
+#include "pqxx/internal/gates/connection-replication_stream.hxx"
+
+
+namespace
+{
+/// PostgreSQL's epoch, 2000-01-01 00:00 UTC, as a Unix time.
+constexpr std::chrono::seconds postgres_epoch{946'684'800};
+
+
+/// Convert a server timestamp: microseconds since PostgreSQL's epoch.
+std::chrono::system_clock::time_point from_server_time(std::int64_t micros)
+{
+  return std::chrono::system_clock::time_point{
+    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+      postgres_epoch + std::chrono::microseconds{micros})};
+}
+
+
+/// The current time, as the server counts it.
+std::int64_t server_time_now()
+{
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  return static_cast<std::int64_t>(
+    duration_cast<microseconds>(
+      std::chrono::system_clock::now().time_since_epoch() - postgres_epoch)
+      .count());
+}
+
+
+/// Parse one half of an LSN: up to 8 hex digits.
+std::uint32_t parse_lsn_half(std::string_view text, std::string_view whole)
+{
+  if (text.empty() or std::size(text) > 8)
+    throw pqxx::conversion_error{
+      "Could not parse LSN: '" + std::string{whole} + "'."};
+  std::uint32_t value{0};
+  for (char const c : text)
+  {
+    unsigned digit;
+    if (c >= '0' and c <= '9')
+      digit = static_cast<unsigned>(c - '0');
+    else if (c >= 'A' and c <= 'F')
+      digit = static_cast<unsigned>(c - 'A' + 10);
+    else if (c >= 'a' and c <= 'f')
+      digit = static_cast<unsigned>(c - 'a' + 10);
+    else
+      throw pqxx::conversion_error{
+        "Could not parse LSN: '" + std::string{whole} + "'."};
+    value = (value << 4) | digit;
+  }
+  return value;
+}
+} // namespace
+
+
+pqxx::lsn pqxx::parse_lsn(std::string_view text)
+{
+  auto const slash{text.find('/')};
+  if (slash == std::string_view::npos)
+    throw conversion_error{
+      "Could not parse LSN: '" + std::string{text} + "'."};
+  auto const high{parse_lsn_half(text.substr(0, slash), text)},
+    low{parse_lsn_half(text.substr(slash + 1), text)};
+  return (lsn{high} << 32) | low;
+}
+
+
+std::string pqxx::lsn_to_string(lsn position)
+{
+  static constexpr char digits[]{"0123456789ABCDEF"};
+  // Two halves of up to 8 hex digits, without leading zeroes.
+  auto const half{[](std::string &out, std::uint32_t value) {
+    char buf[8];
+    int len{0};
+    do
+    {
+      buf[len++] = digits[value & 0xfu];
+      value >>= 4;
+    } while (value != 0);
+    while (len > 0) out.push_back(buf[--len]);
+  }};
+  std::string text;
+  half(text, static_cast<std::uint32_t>(position >> 32));
+  text.push_back('/');
+  half(text, static_cast<std::uint32_t>(position));
+  return text;
+}
+
+
+bool pqxx::internal::parse_replication_message(
+  std::string_view message, replication_message &out, bool &reply_requested)
+{
+  auto const data{std::data(message)};
+  if (message.empty())
+    throw failure{"Empty message in replication stream."};
+  switch (message[0])
+  {
+  case 'w':
+    // XLogData: start, server end, send time, and the data itself.
+    if (std::size(message) < 25)
+      throw failure{"Truncated data message in replication stream."};
+    out.start = from_big_endian<std::uint64_t>(data + 1);
+    out.server_end = from_big_endian<std::uint64_t>(data + 9);
+    out.sent = from_server_time(from_big_endian<std::int64_t>(data + 17));
+    out.data = message.substr(25);
+    return true;
+
+  case 'k':
+    // Primary keepalive: server end, send time, and "reply requested."
+    if (std::size(message) < 18)
+      throw failure{"Truncated keepalive message in replication stream."};
+    out.server_end = from_big_endian<std::uint64_t>(data + 1);
+    reply_requested = (data[17] != 0);
+    return false;
+
+  default:
+    throw failure{
+      "Unexpected message type in replication stream: '" +
+      std::string{message[0]} + "'."};
+  }
+}
+
+
+pqxx::replication_stream::replication_stream(
+  connection &c, std::string_view slot, lsn start,
+  std::string_view plugin_options, std::chrono::milliseconds status_interval) :
+        m_conn{c},
+        m_status_interval{status_interval},
+        m_received{start},
+        m_confirmed{start},
+        m_last_status{std::chrono::steady_clock::now()}
+{
+  if (status_interval.count() <= 0)
+    throw argument_error{"Replication status interval must be positive."};
+  auto const query{std::make_shared<std::string>(
+    "START_REPLICATION SLOT " + c.quote_name(slot) + " LOGICAL " +
+    lsn_to_string(start))};
+  if (not plugin_options.empty())
+    query->append(" (").append(plugin_options).append(")");
+  internal::gate::connection_replication_stream{c}.exec(query);
+}
+
+
+pqxx::replication_stream::~replication_stream() noexcept
+{
+  try
+  {
+    complete();
+  }
+  catch (std::exception const &e)
+  {
+    m_conn.process_notice(e.what());
+  }
+}
+
+
+bool pqxx::replication_stream::read(replication_message &message)
+{
+  while (not try_read(message))
+  {
+    if (m_done)
+      return false;
+    auto const wait{time_to_status().count()};
+    internal::gate::connection_replication_stream{m_conn}.wait_read(
+      static_cast<long>(wait / 1'000'000),
+      static_cast<long>(wait % 1'000'000));
+  }
+  return true;
+}
+
+
+bool pqxx::replication_stream::try_read(replication_message &message)
+{
+  if (m_done)
+    return false;
+  keep_up();
+  internal::gate::connection_replication_stream gate{m_conn};
+  for (;;)
+  {
+    bool done{false};
+    auto [buf, size]{gate.try_read_copy_line(done)};
+    if (done)
+    {
+      // The server ended the stream.
+      m_done = true;
+      m_buffer.reset();
+      gate.end_copy_both(true);
+      return false;
+    }
+    if (not buf)
+      return false;
+    // Keep the buffer alive for as long as the caller's view into it.
+    m_buffer = std::move(buf);
+    if (accept(message, size))
+      return true;
+  }
+}
+
+
+bool pqxx::replication_stream::accept(
+  replication_message &message, std::size_t size)
+{
+  bool reply{false};
+  if (internal::parse_replication_message(
+        std::string_view{m_buffer.get(), size}, message, reply))
+  {
+    m_received = std::max(m_received, message.start);
+    return true;
+  }
+  if (reply)
+    send_status();
+  return false;
+}
+
+
+void pqxx::replication_stream::send_status()
+{
+  // Standby status update: written, flushed, and applied positions, our
+  // clock, and whether we want a reply.
+  char buf[34];
+  buf[0] = 'r';
+  auto here{internal::into_big_endian(buf + 1, m_received)};
+  here = internal::into_big_endian(here, m_confirmed);
+  here = internal::into_big_endian(here, m_confirmed);
+  here = internal::into_big_endian(here, server_time_now());
+  *here = '\0';
+  internal::gate::connection_replication_stream{m_conn}.send_copy_message(
+    std::string_view{buf, sizeof(buf)});
+  m_last_status = std::chrono::steady_clock::now();
+}
+
+
+void pqxx::replication_stream::keep_up()
+{
+  if (time_to_status().count() == 0)
+    send_status();
+}
+
+
+std::chrono::microseconds pqxx::replication_stream::time_to_status() const
+{
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  auto const left{
+    m_status_interval - (std::chrono::steady_clock::now() - m_last_status)};
+  return std::max(microseconds{0}, duration_cast<microseconds>(left));
+}
+
+
+void pqxx::replication_stream::complete()
+{
+  if (std::exchange(m_done, true))
+    return;
+  send_status();
+  m_buffer.reset();
+  internal::gate::connection_replication_stream{m_conn}.end_copy_both(false);
+}
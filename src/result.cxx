@@ -10,15 +10,24 @@
  */
 #include "pqxx-source.hxx"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 extern "C"
 {
 #include <libpq-fe.h>
 }
 
+#include "pqxx/config-internal-libpq.h"
 #include "pqxx/except"
 #include "pqxx/result"
 
@@ -38,13 +47,75 @@ void pqxx::internal::clear_result(pq::PGresult const *data)
 }
 
 
+/// Lazily built index mapping column names to column numbers.
+/** Built at most once, even if several threads look up names at once.
+ */
+struct pqxx::internal::column_index
+{
+  std::once_flag built;
+  /// Column names point into the result set.  First occurrence wins.
+  std::unordered_map<std::string_view, pqxx::row_size_type> names;
+  /// Binary columns that we report as text.  Empty if there are none.
+  /** Set only while the result is new, so it needs no locking.
+   */
+  std::vector<bool> as_text;
+};
+
+
+namespace
+{
+/// A result set, together with its column index.
+struct result_holder
+{
+  explicit result_holder(pqxx::internal::pq::PGresult const *res) noexcept :
+          data{res}
+  {}
+  ~result_holder() { pqxx::internal::clear_result(data); }
+
+  pqxx::internal::pq::PGresult const *const data;
+  pqxx::internal::column_index columns;
+};
+
+
+/// Would PQfnumber() read this name as anything other than its exact text?
+/** It folds unquoted names to lower case, and strips double quotes.
+ */
+bool needs_folding(std::string_view name) noexcept
+{
+  for (auto const c : name)
+    if (c == '"' or (c >= 'A' and c <= 'Z'))
+      return true;
+  return false;
+}
+} // namespace
+
+
 pqxx::result::result(
   pqxx::internal::pq::PGresult *rhs, std::shared_ptr<std::string> query,
   internal::encoding_group enc) :
-        m_data{make_data_pointer(rhs)},
         m_query{query},
         m_encoding(enc)
-{}
+{
+  if (rhs == nullptr)
+  {
+    m_data = make_data_pointer();
+    return;
+  }
+
+  std::shared_ptr<result_holder> holder;
+  try
+  {
+    holder = std::make_shared<result_holder>(rhs);
+  }
+  catch (std::exception const &)
+  {
+    internal::clear_result(rhs);
+    throw;
+  }
+  // Share ownership with the holder, but point to the result set itself.
+  m_data = data_pointer{holder, holder->data};
+  m_columns = &holder->columns;
+}
 
 
 bool pqxx::result::operator==(result const &rhs) const noexcept
@@ -127,6 +198,7 @@ void pqxx::result::swap(result &rhs) noexcept
 {
   m_data.swap(rhs.m_data);
   m_query.swap(rhs.m_query);
+  std::swap(m_columns, rhs.m_columns);
 }
 
 
@@ -255,6 +327,18 @@ void pqxx::result::check_status() const
 }
 
 
+bool pqxx::result::starts_copy() const noexcept
+{
+  switch (PQresultStatus(m_data.get()))
+  {
+  case PGRES_COPY_IN:
+  case PGRES_COPY_OUT:
+  case PGRES_COPY_BOTH: return true;
+  default: return false;
+  }
+}
+
+
 std::string pqxx::result::StatusError() const
 {
   if (m_data.get() == nullptr)
@@ -268,12 +352,29 @@ std::string pqxx::result::StatusError() const
   case PGRES_COMMAND_OK:  // Successful completion of a command returning no
                           // data
   case PGRES_TUPLES_OK:   // The query successfully executed
+  case PGRES_SINGLE_TUPLE: // One row of a result, in single-row mode
+    break;
+
+#if defined(PQXX_HAVE_PQ_CHUNKED_ROWS)
+  case PGRES_TUPLES_CHUNK: // Several rows of a result, in chunked rows mode
+    break;
+#endif // PQXX_HAVE_PQ_CHUNKED_ROWS
+
+  case PGRES_COPY_OUT:  // Copy Out (from server) data transfer started
+  case PGRES_COPY_IN:   // Copy In (to server) data transfer started
+  case PGRES_COPY_BOTH: // Copy In/Out data transfer started
     break;
 
-  case PGRES_COPY_OUT: // Copy Out (from server) data transfer started
-  case PGRES_COPY_IN:  // Copy In (to server) data transfer started
+#if defined(PQXX_HAVE_PQ_PIPELINE)
+  case PGRES_PIPELINE_SYNC: // Synchronisation point in pipeline mode
     break;
 
+  case PGRES_PIPELINE_ABORTED: // Statement skipped after an earlier error
+    err = "Statement not executed: an earlier statement in the pipeline "
+          "failed.";
+    break;
+#endif // PQXX_HAVE_PQ_PIPELINE
+
   case PGRES_BAD_RESPONSE: // The server's response was not understood
   case PGRES_NONFATAL_ERROR:
   case PGRES_FATAL_ERROR: err = PQresultErrorMessage(m_data.get()); break;
@@ -292,6 +393,70 @@ char const *pqxx::result::cmd_status() const noexcept
 }
 
 
+pqxx::result pqxx::result::empty_copy() const
+{
+  auto const copy{PQcopyResult(m_data.get(), PG_COPYRES_ATTRS)};
+  if (copy == nullptr)
+    throw std::bad_alloc{};
+  return result{copy, m_query, m_encoding};
+}
+
+
+pqxx::result
+pqxx::result::compact(std::vector<row_size_type> const &cols) const
+{
+  if (std::empty(cols))
+    throw argument_error{"Compacting a result down to no columns."};
+  auto const data{const_cast<internal::pq::PGresult *>(m_data.get())};
+  auto const width{columns()};
+  std::vector<PGresAttDesc> attrs;
+  attrs.reserve(std::size(cols));
+  for (auto const col : cols)
+  {
+    if (col < 0 or col >= width)
+      throw range_error{"Invalid column number: " + to_string(col) + "."};
+    attrs.push_back(PGresAttDesc{
+      PQfname(data, col), PQftable(data, col), PQftablecol(data, col),
+      PQfformat(data, col), PQftype(data, col), PQfsize(data, col),
+      PQfmod(data, col)});
+  }
+
+  // PQsetvalue() copies each value into the new result's own memory blocks.
+  std::unique_ptr<internal::pq::PGresult, void (*)(internal::pq::PGresult *)>
+    copy{PQmakeEmptyPGresult(nullptr, PQresultStatus(data)), PQclear};
+  if (
+    copy == nullptr or
+    PQsetResultAttrs(
+      copy.get(), check_cast<int>(std::size(attrs), "columns"),
+      std::data(attrs)) == 0)
+    throw std::bad_alloc{};
+  auto const rows{size()};
+  for (size_type row{0}; row < rows; ++row)
+    for (std::size_t i{0}; i < std::size(cols); ++i)
+    {
+      auto const col{cols[i]};
+      auto const null{PQgetisnull(data, row, col) != 0};
+      if (
+        PQsetvalue(
+          copy.get(), row, static_cast<int>(i),
+          null ? nullptr : PQgetvalue(data, row, col),
+          null ? -1 : PQgetlength(data, row, col)) == 0)
+        throw std::bad_alloc{};
+    }
+
+  result compacted{copy.release(), m_query, m_encoding};
+  if (m_columns != nullptr and not std::empty(m_columns->as_text))
+  {
+    std::vector<bool> as_text;
+    as_text.reserve(std::size(cols));
+    for (auto const col : cols)
+      as_text.push_back(m_columns->as_text[static_cast<std::size_t>(col)]);
+    compacted.read_as_text(std::move(as_text));
+  }
+  return compacted;
+}
+
+
 std::string const &pqxx::result::query() const noexcept
 {
   return (m_query.get() == nullptr) ? s_empty_string : *m_query;
@@ -336,6 +501,44 @@ pqxx::field::size_type pqxx::result::get_length(
 }
 
 
+pqxx::result::size_type pqxx::result::validity_bitmap(
+  row_size_type col, std::uint8_t *bits) const
+{
+  if ((col < 0) or (col >= columns()))
+    throw range_error{"Invalid column number: " + to_string(col) + "."};
+  auto const data{m_data.get()};
+  auto const rows{size()};
+  size_type nulls{0};
+  for (size_type base{0}; base < rows; base += 8)
+  {
+    // Build up each byte in a register, and store it just once.
+    auto const stop{std::min(base + 8, rows)};
+    unsigned byte{0};
+    for (size_type row{base}; row < stop; ++row)
+    {
+      auto const null{PQgetisnull(data, row, col)};
+      nulls += null;
+      byte |= unsigned(null == 0) << (row - base);
+    }
+    bits[base / 8] = static_cast<std::uint8_t>(byte);
+  }
+  return nulls;
+}
+
+
+void pqxx::result::field_lengths(
+  row_size_type col, field_size_type *lengths) const
+{
+  if ((col < 0) or (col >= columns()))
+    throw range_error{"Invalid column number: " + to_string(col) + "."};
+  auto const data{m_data.get()};
+  auto const rows{size()};
+  // For a null, PQgetlength() returns zero.
+  for (size_type row{0}; row < rows; ++row)
+    lengths[row] = static_cast<field_size_type>(PQgetlength(data, row, col));
+}
+
+
 pqxx::oid pqxx::result::column_type(row::size_type col_num) const
 {
   oid const t{PQftype(m_data.get(), col_num)};
@@ -346,8 +549,67 @@ pqxx::oid pqxx::result::column_type(row::size_type col_num) const
 }
 
 
+std::size_t pqxx::result::memory_usage() const noexcept
+{
+  auto const data{m_data.get()};
+  if (data == nullptr)
+    return 0;
+#if defined(PQXX_HAVE_PQRESULTMEMORYSIZE)
+  return PQresultMemorySize(data);
+#else
+  // Estimate: the column names, and the fields with their terminating
+  // zeroes, plus a pointer per field in libpq's row arrays.
+  auto const rows{PQntuples(data)}, cols{PQnfields(data)};
+  std::size_t total{0};
+  for (int c{0}; c < cols; ++c) total += std::strlen(PQfname(data, c)) + 1;
+  for (int r{0}; r < rows; ++r)
+    for (int c{0}; c < cols; ++c)
+      total += static_cast<std::size_t>(PQgetlength(data, r, c)) + 1 +
+               sizeof(char *);
+  return total;
+#endif
+}
+
+
+pqxx::format pqxx::result::column_format(row::size_type col_num) const
+  noexcept
+{
+  if (
+    m_columns != nullptr and
+    static_cast<std::size_t>(col_num) < std::size(m_columns->as_text) and
+    m_columns->as_text[static_cast<std::size_t>(col_num)])
+    return format::text;
+  return static_cast<format>(PQfformat(m_data.get(), col_num));
+}
+
+
+void pqxx::result::read_as_text(std::vector<bool> columns) const
+{
+  if (m_columns == nullptr)
+    throw internal_error{"Marking columns on a result without columns."};
+  m_columns->as_text = std::move(columns);
+}
+
+
 pqxx::row::size_type pqxx::result::column_number(char const col_name[]) const
 {
+  std::string_view const name{col_name};
+  if (m_columns != nullptr and not needs_folding(name))
+  {
+    auto &index{*m_columns};
+    std::call_once(index.built, [this, &index] {
+      auto const cols{columns()};
+      index.names.reserve(static_cast<std::size_t>(cols));
+      for (row_size_type c{0}; c < cols; ++c)
+        index.names.emplace(PQfname(m_data.get(), c), c);
+    });
+    auto const here{index.names.find(name)};
+    if (here == std::end(index.names))
+      throw argument_error{"Unknown column name: '" + std::string{name} +
+                           "'."};
+    return here->second;
+  }
+
   auto const n{
     PQfnumber(const_cast<internal::pq::PGresult *>(m_data.get()), col_name)};
   if (n == -1)
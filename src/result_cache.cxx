@@ -0,0 +1,149 @@
+/** Implementation of the pqxx::result_cache class.
+ *
+ * pqxx::result_cache remembers the results of prepared statements.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <iterator>
+
+#include "pqxx/notification"
+#include "pqxx/result_cache"
+
+
+/// Receiver which drops cached results when a notification comes in.
+class PQXX_PRIVATE pqxx::result_cache::invalidator final
+        : public notification_receiver
+{
+public:
+  invalidator(
+    result_cache &cache, std::string_view channel, std::string statement) :
+          notification_receiver{cache.m_listener, channel},
+          m_cache{cache},
+          m_statement{std::move(statement)}
+  {}
+
+  void receive(zview, int) override
+  {
+    if (std::empty(m_statement))
+      m_cache.clear();
+    else
+      m_cache.invalidate(m_statement);
+  }
+
+private:
+  result_cache &m_cache;
+  std::string const m_statement;
+};
+
+
+pqxx::result_cache::result_cache(
+  connection &listener, result_cache_config const &config) :
+        m_listener{listener}, m_config{config}
+{}
+
+
+pqxx::result_cache::~result_cache() noexcept = default;
+
+
+void pqxx::result_cache::invalidate_on(
+  std::string_view channel, std::string statement)
+{
+  m_invalidators.push_back(
+    std::make_unique<invalidator>(*this, channel, std::move(statement)));
+}
+
+
+void pqxx::result_cache::invalidate(std::string_view statement)
+{
+  // All keys for the statement start with its name, and a zero byte.
+  std::string prefix{statement};
+  prefix.push_back('\0');
+  auto const begin{m_entries.lower_bound(prefix)};
+  prefix.back() = '\1';
+  drop(begin, m_entries.lower_bound(prefix), m_stats.invalidations);
+}
+
+
+void pqxx::result_cache::clear() noexcept
+{
+  drop(std::begin(m_entries), std::end(m_entries), m_stats.invalidations);
+}
+
+
+void pqxx::result_cache::drop(
+  entry_map::iterator begin, entry_map::iterator end,
+  std::size_t &counter) noexcept
+{
+  while (begin != end)
+  {
+    m_bytes -= begin->second.bytes;
+    m_lru.erase(begin->second.lru);
+    begin = m_entries.erase(begin);
+    ++counter;
+  }
+}
+
+
+void pqxx::result_cache::trim() noexcept
+{
+  auto const too_many{[this] {
+    return m_config.max_entries > 0 and
+           std::size(m_entries) > m_config.max_entries;
+  }};
+  auto const too_big{[this] {
+    return m_config.max_bytes > 0 and m_bytes > m_config.max_bytes;
+  }};
+  while (not std::empty(m_lru) and (too_many() or too_big()))
+  {
+    auto const victim{m_entries.find(m_lru.back())};
+    drop(victim, std::next(victim), m_stats.evictions);
+  }
+}
+
+
+pqxx::result pqxx::result_cache::exec(
+  transaction_base &tx, zview statement, internal::params const &args)
+{
+  // Let any pending invalidations take effect first.
+  if (not std::empty(m_invalidators))
+    m_listener.get_notifs();
+
+  m_key.assign(statement);
+  m_key.push_back('\0');
+  args.encode(m_key);
+
+  using clock = std::chrono::steady_clock;
+  bool const expiring{m_config.ttl.count() > 0};
+  auto const now{expiring ? clock::now() : clock::time_point{}};
+  if (auto const here{m_entries.find(m_key)}; here != std::end(m_entries))
+  {
+    if (not expiring or now < here->second.expires)
+    {
+      ++m_stats.hits;
+      m_lru.splice(std::begin(m_lru), m_lru, here->second.lru);
+      return here->second.res;
+    }
+    drop(here, std::next(here), m_stats.evictions);
+  }
+
+  ++m_stats.misses;
+  auto const res{tx.exec_prepared(statement, args)};
+  auto const bytes{res.memory_usage()};
+  if (m_config.max_bytes > 0 and bytes > m_config.max_bytes)
+    return res;
+
+  auto const here{
+    m_entries.emplace(m_key, entry{res, bytes, now + m_config.ttl, {}})
+      .first};
+  m_lru.push_front(here->first);
+  here->second.lru = std::begin(m_lru);
+  m_bytes += bytes;
+  trim();
+  return res;
+}
@@ -0,0 +1,275 @@
+/** Implementation of the pqxx::result_snapshot class.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "pqxx/except"
+#include "pqxx/result"
+#include "pqxx/result_snapshot"
+
+#include "pqxx/internal/gates/result-snapshot.hxx"
+#include "pqxx/internal/mapped_file.hxx"
+
+
+/* File layout.  All numbers are in the byte order of the machine that wrote
+ * the file, and each part starts at a multiple of 8 bytes:
+ *
+ *  1. Header: magic, version, byte-order mark, rows, columns, encoding group,
+ *     and the size of the field data.
+ *  2. Column table: for each column, its type, format, the offset of its name
+ *     in the names, and the name's length.  Four 32-bit numbers each.
+ *  3. Column names, each with a terminating zero.
+ *  4. Null bitmap: one bit per field, row by row.  Set means null.
+ *  5. Offsets: for each field, a 64-bit offset of its value in the field
+ *     data; plus one more for the end of the data.
+ *  6. Field data: each field's value, with a terminating zero.  A null is
+ *     just the zero.
+ */
+namespace
+{
+constexpr char magic[8]{'P', 'Q', 'X', 'X', 'S', 'N', 'A', 'P'};
+constexpr std::uint32_t byte_order_mark{0x01020304u};
+constexpr std::size_t header_size{40};
+constexpr std::size_t column_entry_size{16};
+
+
+/// Round @c n up to a multiple of 8.
+constexpr std::size_t align8(std::size_t n) noexcept
+{
+  return (n + 7) & ~std::size_t{7};
+}
+
+
+template<typename T> void put(std::string &out, T value)
+{
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+
+template<typename T> T get(char const *here) noexcept
+{
+  T value;
+  std::memcpy(&value, here, sizeof(T));
+  return value;
+}
+
+
+void pad(std::string &out)
+{
+  out.resize(align8(std::size(out)), '\0');
+}
+
+
+[[noreturn]] void bad_snapshot(std::string const &path, char const why[])
+{
+  throw pqxx::failure{
+    "Not a valid result snapshot: '" + path + "' (" + why + ")."};
+}
+} // namespace
+
+
+std::string pqxx::result_snapshot::serialize(result const &res)
+{
+  auto const rows{static_cast<std::size_t>(res.size())};
+  auto const cols{static_cast<std::size_t>(res.columns())};
+  auto const cells{rows * cols};
+
+  std::string names;
+  std::string out;
+  out.append(magic, sizeof(magic));
+  put(out, version);
+  put(out, byte_order_mark);
+  put(out, std::uint64_t{rows});
+  put(out, static_cast<std::uint32_t>(cols));
+  put(
+    out, static_cast<std::uint32_t>(
+           internal::gate::result_snapshot{res}.encoding()));
+  // The data size goes here, once we know it.
+  auto const data_size_at{std::size(out)};
+  put(out, std::uint64_t{0});
+
+  for (row_size_type col{0}; col < res.columns(); ++col)
+  {
+    std::string_view const name{res.column_name(col)};
+    put(out, static_cast<std::uint32_t>(res.column_type(col)));
+    put(out, static_cast<std::uint32_t>(res.column_format(col)));
+    put(out, static_cast<std::uint32_t>(std::size(names)));
+    put(out, static_cast<std::uint32_t>(std::size(name)));
+    names.append(name).push_back('\0');
+  }
+  out.append(names);
+  pad(out);
+
+  auto const nulls_at{std::size(out)};
+  out.resize(align8(nulls_at + (cells + 7) / 8), '\0');
+  std::uint64_t offset{0};
+  std::size_t cell{0};
+  for (auto const &r : res)
+    for (auto const &f : r)
+    {
+      if (f.is_null())
+        out[nulls_at + cell / 8] |= static_cast<char>(1 << (cell % 8));
+      put(out, offset);
+      offset += f.size() + 1;
+      ++cell;
+    }
+  put(out, offset);
+
+  auto const data_at{std::size(out)};
+  out.reserve(data_at + offset);
+  for (auto const &r : res)
+    for (auto const &f : r) out.append(f.view()).push_back('\0');
+
+  std::memcpy(&out[data_size_at], &offset, sizeof(offset));
+  return out;
+}
+
+
+void pqxx::result_snapshot::save(result const &res, std::string const &path)
+{
+  auto const data{serialize(res)};
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(std::data(data), static_cast<std::streamsize>(std::size(data)));
+  file.close();
+  if (not file)
+    throw failure{"Could not write result snapshot '" + path + "'."};
+}
+
+
+pqxx::result_snapshot::result_snapshot(std::string const &path) :
+        m_file{std::make_unique<internal::mapped_file>(path)}
+{
+  auto const data{m_file->data()};
+  auto const size{std::size(data)};
+  auto const base{std::data(data)};
+  if (size < header_size or std::memcmp(base, magic, sizeof(magic)) != 0)
+    bad_snapshot(path, "no snapshot header");
+  if (get<std::uint32_t>(base + 8) != version)
+    bad_snapshot(path, "wrong version");
+  if (get<std::uint32_t>(base + 12) != byte_order_mark)
+    bad_snapshot(path, "wrong byte order");
+
+  auto const rows{get<std::uint64_t>(base + 16)};
+  auto const cols{get<std::uint32_t>(base + 24)};
+  auto const data_size{get<std::uint64_t>(base + 32)};
+  constexpr auto max_rows{std::numeric_limits<size_type>::max()};
+  constexpr auto max_cols{std::numeric_limits<row_size_type>::max()};
+  if (
+    rows > static_cast<std::uint64_t>(max_rows) or
+    cols > static_cast<std::uint32_t>(max_cols))
+    bad_snapshot(path, "too big");
+  m_rows = static_cast<size_type>(rows);
+  m_columns = static_cast<row_size_type>(cols);
+  m_encoding =
+    static_cast<internal::encoding_group>(get<std::uint32_t>(base + 28));
+
+  auto const cells{static_cast<std::size_t>(rows) * cols};
+  auto here{header_size};
+  m_column_table = base + here;
+  here += cols * column_entry_size;
+  if (here > size)
+    bad_snapshot(path, "truncated");
+
+  std::size_t names_size{0};
+  for (std::uint32_t col{0}; col < cols; ++col)
+  {
+    auto const entry{m_column_table + col * column_entry_size};
+    names_size = std::max(
+      names_size, std::size_t{get<std::uint32_t>(entry + 8)} +
+                    get<std::uint32_t>(entry + 12) + 1);
+  }
+  m_names = base + here;
+  here = align8(here + names_size);
+  m_nulls = base + here;
+  here = align8(here + (cells + 7) / 8);
+  m_offsets = base + here;
+  here += (cells + 1) * sizeof(std::uint64_t);
+  m_data = base + here;
+  if (here > size or here + data_size != size or offset(cells) != data_size)
+    bad_snapshot(path, "inconsistent sizes");
+}
+
+
+pqxx::result_snapshot::~result_snapshot() noexcept = default;
+
+
+std::uint64_t pqxx::result_snapshot::offset(std::size_t index) const noexcept
+{
+  return get<std::uint64_t>(m_offsets + index * sizeof(std::uint64_t));
+}
+
+
+pqxx::row_size_type
+pqxx::result_snapshot::column_number(std::string_view name) const
+{
+  for (row_size_type col{0}; col < m_columns; ++col)
+    if (name == column_name(col))
+      return col;
+  throw argument_error{"Unknown column name: '" + std::string{name} + "'."};
+}
+
+
+char const *pqxx::result_snapshot::column_name(row_size_type col) const
+{
+  if (col < 0 or col >= m_columns)
+    throw range_error{"Column number out of range: " + to_string(col) + "."};
+  auto const entry{
+    m_column_table + static_cast<std::size_t>(col) * column_entry_size};
+  return m_names + get<std::uint32_t>(entry + 8);
+}
+
+
+pqxx::oid pqxx::result_snapshot::column_type(row_size_type col) const
+{
+  if (col < 0 or col >= m_columns)
+    throw range_error{"Column number out of range: " + to_string(col) + "."};
+  return static_cast<oid>(get<std::uint32_t>(
+    m_column_table + static_cast<std::size_t>(col) * column_entry_size));
+}
+
+
+pqxx::format
+pqxx::result_snapshot::column_format(row_size_type col) const noexcept
+{
+  return static_cast<format>(get<std::uint32_t>(
+    m_column_table + static_cast<std::size_t>(col) * column_entry_size + 4));
+}
+
+
+pqxx::result_snapshot::row_view
+pqxx::result_snapshot::at(size_type row) const
+{
+  if (row < 0 or row >= m_rows)
+    throw range_error{"Row number out of range: " + to_string(row) + "."};
+  return (*this)[row];
+}
+
+
+pqxx::result_snapshot::field_view
+pqxx::result_snapshot::row_view::at(row_size_type col) const
+{
+  if (col < 0 or col >= size())
+    throw range_error{"Column number out of range: " + to_string(col) + "."};
+  return (*this)[col];
+}
+
+
+void pqxx::result_snapshot::row_view::check_size(std::size_t expected) const
+{
+  if (static_cast<std::size_t>(size()) != expected)
+    throw usage_error{
+      "Tried to extract " + to_string(expected) + " field(s) from a row of " +
+      to_string(size()) + "."};
+}
@@ -11,7 +11,9 @@
 #include "pqxx-source.hxx"
 
 #include <chrono>
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <thread>
 #include <unordered_map>
@@ -58,11 +60,10 @@ std::unordered_map<std::string, tx_stat, initial_hash> const statuses{
 };
 
 
-tx_stat query_status(std::string const &xid, std::string const &conn_str)
+tx_stat query_status(std::string const &xid, pqxx::connection &c)
 {
   static std::string const name{"robusttxck"};
   auto const query{"SELECT txid_status(" + xid + ")"};
-  pqxx::connection c{conn_str};
   pqxx::nontransaction w{c, name};
   auto const status_text{w.query_value<std::string>(query)};
   if (status_text.empty())
@@ -82,7 +83,8 @@ pqxx::internal::basic_robusttransaction::basic_robusttransaction(
         m_conn_string{c.connection_string()}
 {
   m_backendpid = c.backendpid();
-  direct_exec(begin_command);
+  // Send the BEGIN along with the transaction ID query, in one round trip.
+  defer_begin(begin_command);
   direct_exec("SELECT txid_current()")[0][0].to(m_xid);
 }
 
@@ -92,19 +94,11 @@ pqxx::internal::basic_robusttransaction::~basic_robusttransaction() = default;
 
 void pqxx::internal::basic_robusttransaction::do_commit()
 {
-  // Check constraints before sending the COMMIT to the database, so as to
-  // minimise our in-doubt window.
-  try
-  {
-    direct_exec("SET CONSTRAINTS ALL IMMEDIATE");
-  }
-  catch (std::exception const &)
-  {
-    do_abort();
-    throw;
-  }
-
-  // Here comes the in-doubt window.  If we lose our connection here, we'll be
+  // Check constraints before committing, so as to minimise our in-doubt
+  // window.  We bundle the check with the COMMIT, so it costs no extra round
+  // trip: if the check fails, the server never gets to the COMMIT.
+  //
+  // Then comes the in-doubt window.  If we lose our connection here, we'll be
   // left clueless as to what happened on the backend.  It may have received
   // the commit command and completed the transaction, and ended up with a
   // success it could not report back to us.  Or it may have noticed the broken
@@ -115,7 +109,10 @@ void pqxx::internal::basic_robusttransaction::do_commit()
   // robusttransaction what it is.
   try
   {
-    direct_exec("COMMIT");
+    direct_exec_commit(
+      std::make_shared<std::string>("SET CONSTRAINTS ALL IMMEDIATE"));
+    if (capturing_commit_lsn())
+      read_commit_lsn();
 
     // If we make it here, great.  Normal, successful commit.
     return;
@@ -127,40 +124,43 @@ void pqxx::internal::basic_robusttransaction::do_commit()
   }
   catch (std::exception const &)
   {
+    // Commit failed, for some other reason.  The connection has already
+    // rolled back the transaction, if the server had not done so itself.
     if (conn().is_open())
-    {
-      // Commit failed, for some other reason.
-      do_abort();
       throw;
-    }
     // Otherwise, fall through to in-doubt handling.
   }
 
-  // If we get here, we're in doubt.  Figure out what happened.
-
-  auto const delay{std::chrono::milliseconds(300)};
-  int const max_attempts{500};
-  static_assert(max_attempts > 0);
-
-  tx_stat stat;
-  for (int attempts{0}; attempts < max_attempts;
-       ++attempts, std::this_thread::sleep_for(delay))
+  // If we get here, we're in doubt.  Figure out what happened.  Reconnect
+  // once, and keep polling on that connection, backing off as we go.  Only if
+  // we lose that connection as well do we reconnect again.
+  using clock = std::chrono::steady_clock;
+  auto const patience{std::chrono::seconds(150)};
+  auto const max_delay{std::chrono::milliseconds(2000)};
+  auto delay{std::chrono::milliseconds(10)};
+  auto const deadline{clock::now() + patience};
+
+  std::unique_ptr<connection> checker;
+  for (;;)
   {
-    stat = tx_unknown;
+    tx_stat stat{tx_unknown};
     try
     {
-      stat = query_status(m_xid, m_conn_string);
+      if (not checker)
+        checker = std::make_unique<connection>(m_conn_string);
+      stat = query_status(m_xid, *checker);
     }
     catch (pqxx::broken_connection const &)
     {
-      // Swallow the error.  Pause and retry.
+      // Swallow the error.  Pause, reconnect, and retry.
+      checker.reset();
     }
     switch (stat)
     {
     case tx_unknown:
       // We were unable to reconnect and query transaction status.
       // Stay in it for another attempt.
-      return;
+      break;
     case tx_committed:
       // Success!  We're done.
       return;
@@ -173,6 +173,11 @@ void pqxx::internal::basic_robusttransaction::do_commit()
       // transpires.
       break;
     }
+
+    if (clock::now() + delay > deadline)
+      break;
+    std::this_thread::sleep_for(delay);
+    delay = std::min(delay * 2, max_delay);
   }
 
   // Okay, this has taken too long.  Give up, report in-doubt state.
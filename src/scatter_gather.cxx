@@ -0,0 +1,131 @@
+/** Implementation of the pqxx::scatter_gather class.
+ *
+ * pqxx::scatter_gather runs the same query on many shards at once.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <memory>
+
+#include "pqxx/except"
+#include "pqxx/scatter_gather"
+
+
+pqxx::scatter_gather::scatter_gather(std::vector<connection *> const &shards) :
+        m_shards{shards}
+{
+  for (auto const c : m_shards)
+    if (c == nullptr)
+      throw argument_error{"Null connection passed to scatter_gather."};
+  add_shards();
+}
+
+
+pqxx::scatter_gather::scatter_gather(
+  std::vector<connection_pool *> const &shards)
+{
+  m_borrowed.reserve(std::size(shards));
+  m_shards.reserve(std::size(shards));
+  for (auto const pool : shards)
+  {
+    if (pool == nullptr)
+      throw argument_error{"Null pool passed to scatter_gather."};
+    m_borrowed.push_back(pool->get());
+    m_shards.push_back(&*m_borrowed.back());
+  }
+  add_shards();
+}
+
+
+pqxx::scatter_gather::~scatter_gather() noexcept
+{
+  for (auto const c : m_shards) try
+    {
+      m_reactor.remove(*c);
+    }
+    catch (std::exception const &)
+    {}
+}
+
+
+void pqxx::scatter_gather::add_shards()
+{
+  for (auto const c : m_shards) m_reactor.add(*c);
+}
+
+
+void pqxx::scatter_gather::set_timeout(std::chrono::milliseconds timeout)
+{
+  for (auto const c : m_shards) m_reactor.set_query_timeout(*c, timeout);
+}
+
+
+void pqxx::scatter_gather::scatter(
+  issue_func const &issue, result_callback const &on_result)
+{
+  // The reactor's callbacks fill this in.  It's shared with them, so that
+  // they stay safe to call even if we leave early because the wait fails.
+  struct outcome
+  {
+    /// Shards' results that have arrived, but have not been delivered.
+    std::vector<std::pair<std::size_t, result>> arrived;
+    /// Each shard's error, if it failed.
+    std::vector<std::exception_ptr> errors;
+    std::size_t completed = 0;
+  };
+  auto const shards{size()};
+  auto const state{std::make_shared<outcome>()};
+  state->arrived.reserve(shards);
+  state->errors.resize(shards);
+
+  std::size_t issued{0};
+  for (std::size_t index{0}; index < shards; ++index) try
+    {
+      issue(
+        *m_shards[index],
+        [state, index](result const &res, std::exception_ptr error) {
+          if (error)
+            state->errors[index] = std::move(error);
+          else
+            state->arrived.emplace_back(index, res);
+          ++state->completed;
+        });
+      ++issued;
+    }
+    catch (std::exception const &)
+    {
+      state->errors[index] = std::current_exception();
+    }
+
+  std::exception_ptr callback_error;
+  std::vector<std::pair<std::size_t, result>> batch;
+  batch.reserve(shards);
+  while (state->completed < issued or not std::empty(state->arrived))
+  {
+    if (std::empty(state->arrived))
+      m_reactor.poll(std::chrono::milliseconds{-1});
+    batch.swap(state->arrived);
+    if (not callback_error)
+      for (auto const &[index, res] : batch) try
+        {
+          on_result(index, res);
+        }
+        catch (...)
+        {
+          callback_error = std::current_exception();
+          break;
+        }
+    batch.clear();
+  }
+
+  if (callback_error)
+    std::rethrow_exception(callback_error);
+  for (auto const &error : state->errors)
+    if (error)
+      std::rethrow_exception(error);
+}
@@ -0,0 +1,132 @@
+/** Implementation of the slow query log.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include "pqxx/except"
+#include "pqxx/nontransaction"
+#include "pqxx/result"
+
+#include "pqxx/internal/slow_query_log.hxx"
+
+
+pqxx::internal::slow_query_log::slow_query_log(slow_query_config config) :
+        m_config{std::move(config)}
+{
+  if (m_config.capacity == 0)
+    throw argument_error{"Slow query log needs a capacity of at least 1."};
+}
+
+
+pqxx::internal::slow_query_log::~slow_query_log() noexcept = default;
+
+
+void pqxx::internal::slow_query_log::record(
+  query_stats const &stats, params const *args, std::string_view definition,
+  connection const &home)
+{
+  slow_query *entry;
+  if (std::size(m_ring) < m_config.capacity)
+  {
+    entry = &m_ring.emplace_back();
+  }
+  else
+  {
+    entry = &m_ring[m_next];
+    m_next = (m_next + 1) % std::size(m_ring);
+  }
+
+  entry->what = stats.what;
+  entry->query.assign(stats.query);
+  entry->when = std::chrono::system_clock::now();
+  entry->elapsed = stats.elapsed;
+  entry->rows = stats.rows;
+  entry->failed = stats.failed;
+  entry->plan.clear();
+
+  auto &values{entry->parameters};
+  if (args == nullptr)
+  {
+    values.clear();
+  }
+  else
+  {
+    auto const count{args->size()};
+    values.resize(count);
+    auto const pointers{args->get_pointers()};
+    for (std::size_t i{0}; i < count; ++i)
+    {
+      if (args->nonnulls[i] == 0)
+      {
+        values[i].reset();
+        continue;
+      }
+      std::string_view const value{
+        pointers[i], static_cast<std::size_t>(args->lengths[i])};
+      if (args->binaries[i] != 0)
+        values[i] = esc_bin(value);
+      else if (values[i].has_value())
+        values[i]->assign(value);
+      else
+        values[i].emplace(value);
+    }
+  }
+
+  if (m_config.explain_every > 0 and m_seen++ % m_config.explain_every == 0)
+    explain(*entry, args, definition, home);
+}
+
+
+void pqxx::internal::slow_query_log::explain(
+  slow_query &entry, params const *args, std::string_view definition,
+  connection const &home)
+{
+  if (std::empty(definition))
+  {
+    entry.plan = "No statement to explain.";
+    return;
+  }
+  try
+  {
+    if (not m_side)
+      m_side = std::make_unique<connection>(
+        std::empty(m_config.explain_options) ? home.connection_string() :
+                                               m_config.explain_options);
+    nontransaction tx{*m_side};
+    // Always use the extended query protocol.  It refuses query strings
+    // with more than one statement, so EXPLAIN can't run anything else.
+    std::string const query{
+      "EXPLAIN (ANALYZE off) " + std::string{definition}};
+    auto const res{
+      (args == nullptr) ? tx.exec_params(query) :
+                          tx.exec_params(query, *args)};
+    for (auto const &row : res)
+      entry.plan.append(row[0].view()).push_back('\n');
+  }
+  catch (std::exception const &e)
+  {
+    entry.plan = std::string{"EXPLAIN failed: "} + e.what();
+    if (m_side and not m_side->is_open())
+      m_side.reset();
+  }
+}
+
+
+std::vector<pqxx::slow_query>
+pqxx::internal::slow_query_log::entries() const
+{
+  std::vector<slow_query> out;
+  out.reserve(std::size(m_ring));
+  out.insert(
+    std::end(out), std::begin(m_ring) + static_cast<std::ptrdiff_t>(m_next),
+    std::end(m_ring));
+  out.insert(
+    std::end(out), std::begin(m_ring),
+    std::begin(m_ring) + static_cast<std::ptrdiff_t>(m_next));
+  return out;
+}
@@ -0,0 +1,316 @@
+/** Implementation of the pqxx::spilled_result class.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <system_error>
+
+#include "pqxx/except"
+#include "pqxx/result"
+#include "pqxx/spilled_result"
+#include "pqxx/stream_query"
+
+#include "pqxx/internal/mapped_file.hxx"
+
+
+namespace
+{
+/// Length that marks a null field.
+constexpr std::uint32_t null_field{0xffffffffu};
+
+/// Write buffered rows to the spill file once they reach this size.
+constexpr std::size_t spill_buffer{1024 * 1024};
+
+
+/// Read the length of the field at @c here, and return a pointer past it.
+char const *read_length(char const *here, std::uint32_t &len) noexcept
+{
+  std::memcpy(&len, here, sizeof(len));
+  return here + sizeof(len);
+}
+
+
+/// Return a pointer past the field at @c here.
+char const *skip_field(char const *here) noexcept
+{
+  std::uint32_t len;
+  here = read_length(here, len);
+  return (len == null_field) ? here : here + len + 1;
+}
+
+
+/// Invent a name for a new spill file in @c directory.
+std::string spill_path(std::string const &directory)
+{
+  std::filesystem::path dir{directory};
+  if (std::empty(directory))
+    dir = std::filesystem::temp_directory_path();
+  std::random_device random;
+  return (dir / ("pqxx-spill-" + pqxx::to_string(random()) + "-" +
+                 pqxx::to_string(random())))
+    .string();
+}
+} // namespace
+
+
+/// Receives the rows, and stores them in memory or in the spill file.
+class pqxx::spilled_result::writer
+{
+public:
+  writer(spilled_result &home, spill_config const &config) :
+          m_home{home}, m_config{config}
+  {}
+
+  ~writer() noexcept
+  {
+    if (m_out.is_open())
+    {
+      m_out.close();
+      std::remove(m_path.c_str());
+    }
+  }
+
+  /// Store a row.
+  void add(row const &r)
+  {
+    if (m_home.m_rows % index_step == 0)
+      m_home.m_index.push_back(m_offset);
+    auto &buf{m_home.m_memory};
+    auto const before{std::size(buf)};
+    for (row_size_type col{0}; col < r.size(); ++col)
+    {
+      auto const f{r[col]};
+      if (f.is_null())
+      {
+        append_length(buf, null_field);
+      }
+      else
+      {
+        auto const text{f.view()};
+        if (std::size(text) >= null_field)
+          throw failure{"Field too large to spill to disk."};
+        append_length(buf, static_cast<std::uint32_t>(std::size(text)));
+        buf.append(text).push_back('\0');
+      }
+    }
+    m_offset += std::size(buf) - before;
+    ++m_home.m_rows;
+
+    if (m_out.is_open())
+    {
+      if (std::size(buf) >= spill_buffer)
+        flush();
+    }
+    else if (std::size(buf) > m_config.memory_limit)
+    {
+      m_path = spill_path(m_config.directory);
+      m_out.open(m_path, std::ios::binary | std::ios::trunc);
+      if (not m_out)
+        throw failure{"Could not create spill file '" + m_path + "'."};
+      flush();
+    }
+  }
+
+  /// Write any buffered rows to the spill file.
+  void flush()
+  {
+    auto &buf{m_home.m_memory};
+    m_out.write(std::data(buf), static_cast<std::streamsize>(std::size(buf)));
+    if (not m_out)
+      throw failure{"Could not write spill file '" + m_path + "'."};
+    buf.clear();
+  }
+
+  /// Close the spill file, and return its path.  Empty if there is none.
+  std::string close()
+  {
+    if (not m_out.is_open())
+      return {};
+    flush();
+    m_out.close();
+    if (not m_out)
+      throw failure{"Could not write spill file '" + m_path + "'."};
+    // Free the buffer, if the last flush left it big.
+    std::string{}.swap(m_home.m_memory);
+    return std::move(m_path);
+  }
+
+private:
+  static void append_length(std::string &buf, std::uint32_t len)
+  {
+    char bytes[sizeof(len)];
+    std::memcpy(bytes, &len, sizeof(len));
+    buf.append(bytes, sizeof(bytes));
+  }
+
+  spilled_result &m_home;
+  spill_config const &m_config;
+  /// Offset of the next row in the row data.
+  std::size_t m_offset = 0;
+  std::string m_path;
+  std::ofstream m_out;
+};
+
+
+pqxx::spilled_result::spilled_result(
+  transaction_base &tx, std::string_view query, spill_config config)
+{
+  writer out{*this, config};
+  stream_query stream{tx, query, config.chunk_rows};
+  for (auto chunk{stream.read_chunk()}; not std::empty(chunk);
+       chunk = stream.read_chunk())
+  {
+    if (std::empty(m_names))
+    {
+      auto const cols{chunk.columns()};
+      m_names.reserve(static_cast<std::size_t>(cols));
+      m_types.reserve(static_cast<std::size_t>(cols));
+      for (row_size_type col{0}; col < cols; ++col)
+      {
+        m_names.emplace_back(chunk.column_name(col));
+        m_types.push_back(chunk.column_type(col));
+      }
+    }
+    for (auto const &r : chunk) out.add(r);
+  }
+  finish(out);
+}
+
+
+void pqxx::spilled_result::finish(writer &out)
+{
+  auto path{out.close()};
+  if (std::empty(path))
+  {
+    m_data = m_memory;
+    return;
+  }
+
+  m_path = std::move(path);
+  try
+  {
+    m_file = std::make_unique<internal::mapped_file>(m_path);
+  }
+  catch (std::exception const &)
+  {
+    std::remove(m_path.c_str());
+    throw;
+  }
+  m_data = m_file->data();
+  // A mapping outlives its file, where there is a mapping at all.  Where
+  // deleting an open file fails, try again in the destructor.
+  if (std::remove(m_path.c_str()) == 0)
+    m_path.clear();
+}
+
+
+pqxx::spilled_result::~spilled_result() noexcept
+{
+  m_file.reset();
+  if (not std::empty(m_path))
+    std::remove(m_path.c_str());
+}
+
+
+std::string const &
+pqxx::spilled_result::column_name(row_size_type col) const
+{
+  if (col < 0 or col >= columns())
+    throw range_error{"Column number out of range: " + to_string(col) + "."};
+  return m_names[static_cast<std::size_t>(col)];
+}
+
+
+pqxx::oid pqxx::spilled_result::column_type(row_size_type col) const
+{
+  if (col < 0 or col >= columns())
+    throw range_error{"Column number out of range: " + to_string(col) + "."};
+  return m_types[static_cast<std::size_t>(col)];
+}
+
+
+pqxx::spilled_result::row_view
+pqxx::spilled_result::operator[](size_type row) const
+{
+  auto const step{static_cast<std::size_t>(row / index_step)};
+  char const *here{std::data(m_data) + m_index[step]};
+  auto const cols{columns()};
+  for (auto skip{row % index_step}; skip > 0; --skip)
+    for (row_size_type col{0}; col < cols; ++col) here = skip_field(here);
+  return row_view{here, cols};
+}
+
+
+pqxx::spilled_result::row_view
+pqxx::spilled_result::at(size_type row) const
+{
+  if (row < 0 or row >= m_rows)
+    throw range_error{"Row number out of range: " + to_string(row) + "."};
+  return (*this)[row];
+}
+
+
+pqxx::spilled_result::const_iterator &
+pqxx::spilled_result::const_iterator::operator++() noexcept
+{
+  for (row_size_type col{0}; col < m_columns; ++col)
+    m_here = skip_field(m_here);
+  return *this;
+}
+
+
+char const *pqxx::spilled_result::row_view::find(
+  row_size_type col, std::uint32_t &len) const
+{
+  if (col < 0 or col >= m_columns)
+    throw range_error{"Column number out of range: " + to_string(col) + "."};
+  char const *here{m_data};
+  for (row_size_type skip{0}; skip < col; ++skip) here = skip_field(here);
+  here = read_length(here, len);
+  return (len == null_field) ? nullptr : here;
+}
+
+
+bool pqxx::spilled_result::row_view::is_null(row_size_type col) const
+{
+  std::uint32_t len;
+  return find(col, len) == nullptr;
+}
+
+
+std::string_view
+pqxx::spilled_result::row_view::view(row_size_type col) const
+{
+  std::uint32_t len;
+  auto const text{find(col, len)};
+  return (text == nullptr) ? std::string_view{} :
+                             std::string_view{text, len};
+}
+
+
+pqxx::zview pqxx::spilled_result::row_view::c_str(row_size_type col) const
+{
+  std::uint32_t len;
+  auto const text{find(col, len)};
+  return (text == nullptr) ? zview{} : zview{text, len};
+}
+
+
+void pqxx::spilled_result::row_view::check_size(std::size_t expected) const
+{
+  if (static_cast<std::size_t>(m_columns) != expected)
+    throw usage_error{
+      "Tried to extract " + to_string(expected) + " field(s) from a row of " +
+      to_string(m_columns) + "."};
+}
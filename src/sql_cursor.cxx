@@ -11,11 +11,13 @@
 #include "pqxx-source.hxx"
 
 #include <iterator>
+#include <utility>
 
 #include "pqxx/cursor"
 
 #include "pqxx/internal/encodings.hxx"
 #include "pqxx/internal/gates/connection-sql_cursor.hxx"
+#include "pqxx/internal/gates/result-sql_cursor.hxx"
 #include "pqxx/internal/gates/transaction-sql_cursor.hxx"
 
 
@@ -57,9 +59,12 @@ find_query_end(std::string_view query, pqxx::internal::encoding_group enc)
   auto const text{query.data()};
   auto const size{query.size()};
   std::string::size_type end;
-  if (enc == pqxx::internal::encoding_group::MONOBYTE)
+  if (
+    enc == pqxx::internal::encoding_group::MONOBYTE or
+    enc == pqxx::internal::encoding_group::UTF8)
   {
-    // This is an encoding where we can scan backwards from the end.
+    // This is an encoding where we can scan backwards from the end: no byte
+    // of a multibyte character looks like whitespace or a semicolon.
     for (end = query.size(); end > 0 and useless_trail(text[end - 1]); --end)
       ;
   }
@@ -89,7 +94,10 @@ pqxx::internal::sql_cursor::sql_cursor(
   cursor_base::ownership_policy op, bool hold) :
         cursor_base{t.conn(), cname},
         m_home{t.conn()},
+        m_trans{gate::connection_sql_cursor{t.conn()}.transaction()},
         m_adopted{false},
+        m_ownership{op},
+        m_hold{hold},
         m_at_end{-1},
         m_pos{0}
 {
@@ -98,43 +106,35 @@ pqxx::internal::sql_cursor::sql_cursor(
 
   if (query.empty())
     throw usage_error{"Cursor has empty query."};
-  auto const enc{enc_group(t.conn().encoding_id())};
+  auto const enc{t.conn().enc_group()};
   auto const qend{find_query_end(query, enc)};
   if (qend == 0)
     throw usage_error{"Cursor has effectively empty query."};
 
-  std::stringstream cq, qn;
-
-  cq << "DECLARE " << t.quote_name(name()) << " ";
-
+  m_declare = "DECLARE " + t.quote_name(name()) + " ";
   if (ap == cursor_base::forward_only)
-    cq << "NO ";
-  cq << "SCROLL ";
-
-  cq << "CURSOR ";
-
+    m_declare += "NO ";
+  m_declare += "SCROLL CURSOR ";
   if (hold)
-    cq << "WITH HOLD ";
-
-  cq << "FOR ";
-  cq.write(query.data(), std::streamsize(qend));
-  cq << ' ';
-
+    m_declare += "WITH HOLD ";
+  m_declare += "FOR ";
+  m_declare.append(query.data(), qend);
   if (up != cursor_base::update)
-    cq << "FOR READ ONLY ";
+    m_declare += " FOR READ ONLY";
   else
-    cq << "FOR UPDATE ";
+    m_declare += " FOR UPDATE";
 
-  qn << "[DECLARE " << name() << ']';
-  t.exec(cq, qn.str());
-
-  // Now that we're here in the starting position, keep a copy of an empty
-  // result.  That may come in handy later, because we may not be able to
-  // construct an empty result with all the right metadata due to the weird
-  // meaning of "FETCH 0."
-  init_empty_result(t);
-
-  m_ownership = op;
+  // A cursor WITH HOLD may outlive the transaction, so it must exist before
+  // the transaction ends.  Any other cursor can wait for its first use.
+  if (hold)
+  {
+    // Keep a copy of an empty result.  That may come in handy later, because
+    // we may not be able to construct an empty result with all the right
+    // metadata due to the weird meaning of "FETCH 0."
+    m_empty_result = t.exec(
+      std::exchange(m_declare, {}) + ";\n" + fetch_query(0),
+      "[DECLARE " + name() + "]");
+  }
 }
 
 
@@ -143,37 +143,72 @@ pqxx::internal::sql_cursor::sql_cursor(
   cursor_base::ownership_policy op) :
         cursor_base{t.conn(), cname, false},
         m_home{t.conn()},
+        m_trans{gate::connection_sql_cursor{t.conn()}.transaction()},
         m_empty_result{},
         m_adopted{true},
+        m_ownership{op},
+        m_hold{false},
         m_at_end{0},
         m_pos{-1}
-{
-  m_adopted = true;
-  m_ownership = op;
-}
+{}
 
 
 void pqxx::internal::sql_cursor::close() noexcept
 {
   if (m_ownership == cursor_base::owned)
   {
-    try
-    {
-      gate::connection_sql_cursor{m_home}.exec(
-        ("CLOSE " + m_home.quote_name(name())).c_str());
-    }
-    catch (std::exception const &)
-    {}
+    // If the DECLARE never went out, there's nothing to close.
+    if (std::empty(m_declare))
+      try
+      {
+        gate::connection_sql_cursor gate{m_home};
+        auto command{"CLOSE " + m_home.quote_name(name())};
+        // A cursor without HOLD closes at the end of its transaction.  Until
+        // then, the CLOSE can wait for the transaction's next statement.
+        bool const deferred{
+          not m_hold and not m_adopted and gate.transaction() == m_trans and
+          gate.defer_close(command)};
+        if (not deferred)
+          gate.exec(command.c_str());
+      }
+      catch (std::exception const &)
+      {}
+    m_declare.clear();
     m_ownership = cursor_base::loose;
   }
 }
 
 
-void pqxx::internal::sql_cursor::init_empty_result(transaction_base &t)
+pqxx::result pqxx::internal::sql_cursor::exec(std::string query)
+{
+  gate::connection_sql_cursor gate{m_home};
+  if (not std::empty(m_declare))
+  {
+    if (gate.transaction() != m_trans)
+      throw usage_error{
+        "Cursor " + name() + " used after its transaction ended."};
+    // Declare the cursor in the same round trip.
+    query = std::exchange(m_declare, {}) + ";\n" + query;
+  }
+  return gate.exec(query.c_str());
+}
+
+
+void pqxx::internal::sql_cursor::declare()
+{
+  if (not std::empty(m_declare))
+  {
+    if (pos() != 0)
+      throw internal_error{"Declaring cursor from bad pos()."};
+    m_empty_result = exec(fetch_query(0));
+  }
+}
+
+
+pqxx::result const &pqxx::internal::sql_cursor::empty_result()
 {
-  if (pos() != 0)
-    throw internal_error{"init_empty_result() from bad pos()."};
-  m_empty_result = t.exec("FETCH 0 IN " + m_home.quote_name(name()));
+  declare();
+  return m_empty_result;
 }
 
 
@@ -248,16 +283,80 @@ pqxx::result pqxx::internal::sql_cursor::fetch(
   if (rows == 0)
   {
     displacement = 0;
-    return m_empty_result;
+    return empty_result();
   }
-  auto const query{"FETCH " + stridestring(rows) + " IN " +
-                   m_home.quote_name(name())};
-  auto const r{gate::connection_sql_cursor{m_home}.exec(query.c_str())};
+  bool const first{not std::empty(m_declare)};
+  auto const r{exec(fetch_query(rows))};
+  // The first FETCH saves us a round trip for the empty result.
+  if (first)
+    m_empty_result = gate::result_sql_cursor{r}.empty_copy();
+  displacement = adjust(rows, difference_type(r.size()));
+  return r;
+}
+
+
+void pqxx::internal::sql_cursor::start_fetch(difference_type rows)
+{
+  declare();
+  gate::connection_sql_cursor{m_home}.start_exec(fetch_query(rows).c_str());
+}
+
+
+pqxx::result pqxx::internal::sql_cursor::finish_fetch(
+  difference_type rows, difference_type &displacement)
+{
+  auto const r{gate::connection_sql_cursor{m_home}.receive_result(
+    std::make_shared<std::string>(fetch_query(rows)))};
   displacement = adjust(rows, difference_type(r.size()));
   return r;
 }
 
 
+std::vector<pqxx::result> pqxx::internal::sql_cursor::fetch_ranges(
+  std::vector<std::pair<difference_type, difference_type>> const &ranges)
+{
+  declare();
+  auto const cname{m_home.quote_name(name())};
+  std::string query;
+  for (auto const &[first, rows] : ranges)
+  {
+    if (first < 0 or rows <= 0)
+      throw internal_error{"Bad cursor range."};
+    query += "MOVE ABSOLUTE " + to_string(first) + " IN " + cname +
+             ";FETCH FORWARD " + stridestring(rows) + " IN " + cname + ";";
+  }
+  gate::connection_sql_cursor gate{m_home};
+  gate.start_exec(query.c_str());
+  auto const results{
+    gate.receive_results(std::make_shared<std::string>(query))};
+  if (std::size(results) != 2 * std::size(ranges))
+    throw internal_error{
+      "Expected " + to_string(2 * std::size(ranges)) +
+      " results from cursor, got " + to_string(std::size(results)) + "."};
+
+  std::vector<result> blocks;
+  blocks.reserve(std::size(ranges));
+  for (std::size_t i{0}; i < std::size(ranges); ++i)
+  {
+    auto const &[first, rows]{ranges[i]};
+    auto const &block{results[2 * i + 1]};
+    // The MOVE ABSOLUTE put us right before the range's first row.
+    m_pos = first;
+    m_at_end = (first == 0) ? -1 : 0;
+    adjust(rows, difference_type(block.size()));
+    blocks.push_back(block);
+  }
+  return blocks;
+}
+
+
+std::string
+pqxx::internal::sql_cursor::fetch_query(difference_type rows) const
+{
+  return "FETCH " + stridestring(rows) + " IN " + m_home.quote_name(name());
+}
+
+
 pqxx::cursor_base::difference_type pqxx::internal::sql_cursor::move(
   difference_type rows, difference_type &displacement)
 {
@@ -267,9 +366,9 @@ pqxx::cursor_base::difference_type pqxx::internal::sql_cursor::move(
     return 0;
   }
 
-  auto const query{"MOVE " + stridestring(rows) + " IN " +
-                   m_home.quote_name(name())};
-  auto const r{gate::connection_sql_cursor{m_home}.exec(query.c_str())};
+  declare();
+  auto const r{
+    exec("MOVE " + stridestring(rows) + " IN " + m_home.quote_name(name()))};
   auto d{static_cast<difference_type>(r.affected_rows())};
   displacement = adjust(rows, d);
   return d;
@@ -9,12 +9,17 @@
 #include "pqxx-source.hxx"
 
 #include <algorithm>
+#include <cerrno>
+#include <clocale>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <limits>
 #include <locale>
+#include <sstream>
 #include <string_view>
 #include <system_error>
 
@@ -22,6 +27,7 @@
 #  include <cxxabi.h>
 #endif
 
+#include "pqxx/binary_traits"
 #include "pqxx/except"
 #include "pqxx/strconv"
 
@@ -128,13 +134,14 @@ wrap_to_chars(char *begin, char *end, T const &value)
     {
     case std::errc::value_too_large:
       throw pqxx::conversion_overrun{
-        "Could not convert " + pqxx::type_name<T> +
+        "Could not convert " + std::string{pqxx::name_type<T>()} +
         " to string: "
         "buffer too small (" +
         pqxx::to_string(end - begin) + " bytes)."};
     default:
-      throw pqxx::conversion_error{"Could not convert " + pqxx::type_name<T> +
-                                   " to string."};
+      throw pqxx::conversion_error{
+        "Could not convert " + std::string{pqxx::name_type<T>()} +
+        " to string."};
     }
   // No need to check for overrun here: we never even told to_chars about that
   // last byte in the buffer, so it didn't get used up.
@@ -155,7 +162,7 @@ zview integral_traits<T>::to_buf(char *begin, char *end, T const &value)
     need{static_cast<ptrdiff_t>(string_traits<T>::size_buffer(value))};
   if (space < need)
     throw conversion_overrun{
-      "Could not convert " + type_name<T> +
+      "Could not convert " + std::string{name_type<T>()} +
       " to string: "
       "buffer too small.  " +
       pqxx::internal::state_buffer_overrun(space, need)};
@@ -238,9 +245,25 @@ std::string demangle_type_name(char const raw[])
 #endif
 }
 
-void throw_null_conversion(std::string const &type)
+void throw_null_conversion(std::string_view type)
 {
-  throw conversion_error{"Attempt to convert null to " + type + "."};
+  throw conversion_error{
+    "Attempt to convert null to " + std::string{type} + "."};
+}
+
+
+void throw_binary_overrun(char const type[])
+{
+  throw conversion_overrun{
+    "Not enough buffer space for binary " + std::string{type} + "."};
+}
+
+
+void throw_binary_size_mismatch(char const type[], std::size_t size)
+{
+  throw conversion_error{
+    "Binary " + std::string{type} + " of unexpected size: " +
+    pqxx::to_string(size) + " bytes."};
 }
 
 
@@ -285,7 +308,7 @@ template<typename TYPE>
   auto const base{"Could not convert '" + std::string(in) +
                   "' "
                   "to " +
-                  pqxx::type_name<TYPE>};
+                  std::string{pqxx::name_type<TYPE>()}};
   if (msg.empty())
     throw pqxx::conversion_error{base + "."};
   else
@@ -375,7 +398,7 @@ template<typename T>
 {
   if (text.size() == 0)
     throw pqxx::conversion_error{"Attempt to convert empty string to " +
-                                 pqxx::type_name<T> + "."};
+                                 std::string{pqxx::name_type<T>()} + "."};
 
   char const initial{text.data()[0]};
   std::size_t i{0};
@@ -390,7 +413,7 @@ template<typename T>
   {
     if constexpr (not std::is_signed_v<T>)
       throw pqxx::conversion_error{"Attempt to convert negative value to " +
-                                   pqxx::type_name<T> + "."};
+                                   std::string{pqxx::name_type<T>()} + "."};
 
     for (++i; isdigit(text.data()[i]); ++i)
       result = absorb_digit_negative(result, digit_to_number(text.data()[i]));
@@ -398,7 +421,7 @@ template<typename T>
   else
   {
     throw pqxx::conversion_error{"Could not convert string to " +
-                                 pqxx::type_name<T> +
+                                 std::string{pqxx::name_type<T>()} +
                                  ": "
                                  "'" +
                                  std::string{text} + "'."};
@@ -406,7 +429,7 @@ template<typename T>
 
   if (i < text.size())
     throw pqxx::conversion_error{"Unexpected text after " +
-                                 pqxx::type_name<T> +
+                                 std::string{pqxx::name_type<T>()} +
                                  ": "
                                  "'" +
                                  std::string{text} + "'."};
@@ -467,9 +490,81 @@ inline bool from_dumb_stringstream(
 }
 
 
+/// Does the C library's current locale use a plain "." as decimal point?
+/** If so, we can use the C library's fast, correctly rounded conversions.
+ * Otherwise, we fall back to a stream with the classic locale.
+ */
+inline bool c_decimal_point_is_dot() noexcept
+{
+  auto const point{std::localeconv()->decimal_point};
+  return point[0] == '.' and point[1] == '\0';
+}
+
+
+inline void c_strto(char const *text, char **end, float &out)
+{
+  out = std::strtof(text, end);
+}
+inline void c_strto(char const *text, char **end, double &out)
+{
+  out = std::strtod(text, end);
+}
+inline void c_strto(char const *text, char **end, long double &out)
+{
+  out = std::strtold(text, end);
+}
+
+
+/// Parse a finite number using the C library.  Returns success.
+/** The caller must already have checked for a "." decimal point.  Accepts
+ * only plain decimal notation: no whitespace, no hexadecimal.
+ */
+template<typename F>
+inline bool from_c_library(F &result, std::string_view text)
+{
+  if (text.empty())
+    return false;
+  for (auto const c : text)
+    if (not(std::isdigit(static_cast<unsigned char>(c)) or c == '.' or
+            c == '-' or c == '+' or c == 'e' or c == 'E'))
+      return false;
+
+  // The C functions need a terminating zero.  Avoid allocating for this if
+  // we can: the numbers we get from the database are generally short.
+  char buf[64];
+  std::string long_text;
+  char const *start{buf};
+  if (text.size() < sizeof(buf))
+  {
+    text.copy(buf, text.size());
+    buf[text.size()] = '\0';
+  }
+  else
+  {
+    long_text = text;
+    start = long_text.c_str();
+  }
+
+  char *stop{nullptr};
+  errno = 0;
+  c_strto(start, &stop, result);
+  if (stop != start + text.size())
+    return false;
+  // Overflow.  (On underflow we accept the closest value we can represent.)
+  if (errno == ERANGE and std::isinf(result))
+    return false;
+  return true;
+}
+
+
 // These are hard, and popular compilers do not yet implement std::from_chars.
 template<typename T> inline T from_string_awful_float(std::string_view text)
 {
+  if (text.empty())
+    throw pqxx::conversion_error{
+      "Attempt to convert empty string to " +
+      std::string{pqxx::name_type<T>()} + "."};
+
   bool ok{false};
   T result;
 
@@ -496,6 +591,10 @@ template<typename T> inline T from_string_awful_float(std::string_view text)
       ok = true;
       result = -std::numeric_limits<T>::infinity();
     }
+    else if (c_decimal_point_is_dot())
+    {
+      ok = from_c_library(result, text);
+    }
     else
     {
       if (have_thread_local)
@@ -587,6 +686,7 @@ template char *
 float_traits<long double>::into_buf(char *, char *, long double const &);
 
 
+#if !defined(PQXX_HAVE_CHARCONV_FLOAT)
 template<typename F>
 inline std::string to_dumb_stringstream(dumb_stringstream<F> &s, F value)
 {
@@ -596,6 +696,29 @@ inline std::string to_dumb_stringstream(dumb_stringstream<F> &s, F value)
 }
 
 
+/// Format a floating-point number using the C library.
+/** Produces the same text as @c to_dumb_stringstream() would, but without
+ * the stream overhead.  Only works when the C locale's decimal point is ".".
+ */
+template<typename F> inline std::string to_c_library(F value)
+{
+  // Enough for the digits, sign, decimal point, and exponent.
+  char buf[std::numeric_limits<F>::max_digits10 + 16];
+  constexpr int precision{std::numeric_limits<F>::max_digits10};
+  int len;
+  if constexpr (std::is_same_v<F, long double>)
+    len = std::snprintf(buf, sizeof(buf), "%.*Lg", precision, value);
+  else
+    len = std::snprintf(
+      buf, sizeof(buf), "%.*g", precision, static_cast<double>(value));
+  if (len < 0 or static_cast<std::size_t>(len) >= sizeof(buf))
+    throw conversion_error{
+      "Could not convert floating-point number to string."};
+  return std::string{buf, static_cast<std::size_t>(len)};
+}
+#endif
+
+
 /// Floating-point implementations for @c pqxx::to_string().
 template<typename T> std::string to_string_float(T value)
 {
@@ -614,7 +737,11 @@ template<typename T> std::string to_string_float(T value)
     // In this rare case, we can convert to std::string but not to a simple
     // buffer.  So, implement to_buf in terms of to_string instead of the other
     // way around.
-    if (have_thread_local)
+    if (c_decimal_point_is_dot())
+    {
+      return to_c_library(value);
+    }
+    else if (have_thread_local)
     {
       thread_local dumb_stringstream<T> s;
       return to_dumb_stringstream(s, value);
@@ -630,10 +757,125 @@ template<typename T> std::string to_string_float(T value)
 } // namespace pqxx::internal
 
 
+namespace
+{
+/// Read 8 bytes as a little-endian 64-bit word, on any platform.
+/** Compilers turn this into a single load where the platform is
+ * little-endian.
+ */
+inline std::uint64_t load_eight(char const *text) noexcept
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  std::uint64_t word;
+  std::memcpy(&word, text, sizeof(word));
+  return word;
+#else
+  std::uint64_t word{0};
+  for (int i{0}; i < 8; ++i)
+    word |= std::uint64_t{static_cast<unsigned char>(text[i])} << (8 * i);
+  return word;
+#endif
+}
+
+
+/// Are all 8 bytes in @c word ASCII digits?
+constexpr bool all_digits(std::uint64_t word) noexcept
+{
+  constexpr std::uint64_t high_nibbles{0xf0f0f0f0f0f0f0f0},
+    zeroes{0x3030303030303030}, sixes{0x0606060606060606};
+  // Each byte must be 0x3X, and still be so after adding 6 (so X <= 9).
+  return ((word & high_nibbles) == zeroes) and
+         (((word + sixes) & high_nibbles) == zeroes);
+}
+
+
+/// Parse 8 ASCII digits, loaded through @c load_eight(), in one go.
+/** Combines pairs of adjacent digits, then pairs of those, and so on: three
+ * multiplications instead of eight.
+ */
+constexpr std::uint32_t parse_eight(std::uint64_t word) noexcept
+{
+  constexpr std::uint64_t zeroes{0x3030303030303030},
+    mask{0x000000ff000000ff}, mul1{100 + (1000000ull << 32)},
+    mul2{1 + (10000ull << 32)};
+  word -= zeroes;
+  word = (word * 10) + (word >> 8);
+  return static_cast<std::uint32_t>(
+    (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32);
+}
+
+
+/// Quickly parse a plain decimal integer of up to 19 digits.
+/** Handles only the common, simple case: an optional minus sign, then one or
+ * more digits, and nothing else.  Returns @c false for anything else,
+ * including values that don't fit in @c T, so that the caller can fall back
+ * to the full conversion and its error reporting.
+ */
+template<typename T>
+inline bool parse_integer_fast(std::string_view text, T &out) noexcept
+{
+  auto here{std::data(text)};
+  auto const end{here + std::size(text)};
+  bool const negative{here != end and *here == '-'};
+  if constexpr (not std::is_signed_v<T>)
+    if (negative)
+      return false;
+  if (negative)
+    ++here;
+  auto const digits{end - here};
+  if (digits <= 0 or digits > 19)
+    return false;
+
+  // With at most 19 digits, this can't overflow.
+  std::uint64_t value{0};
+  for (; end - here >= 8; here += 8)
+  {
+    auto const word{load_eight(here)};
+    if (not all_digits(word))
+      return false;
+    value = value * 100000000u + parse_eight(word);
+  }
+  for (; here != end; ++here)
+  {
+    auto const digit{static_cast<unsigned char>(*here - '0')};
+    if (digit > 9)
+      return false;
+    value = value * 10u + digit;
+  }
+
+  using limits = std::numeric_limits<T>;
+  if constexpr (std::is_signed_v<T>)
+  {
+    if (negative)
+    {
+      if (value == 0)
+      {
+        out = 0;
+        return true;
+      }
+      // The magnitude of the lowest value, computed without overflowing.
+      constexpr auto lowest{std::uint64_t(-(limits::min() + 1)) + 1u};
+      if (value > lowest)
+        return false;
+      out = static_cast<T>(-static_cast<long long>(value - 1) - 1);
+      return true;
+    }
+  }
+  if (value > static_cast<std::uint64_t>(limits::max()))
+    return false;
+  out = static_cast<T>(value);
+  return true;
+}
+} // namespace
+
+
 namespace pqxx::internal
 {
 template<typename T> T integral_traits<T>::from_string(std::string_view text)
 {
+  T value;
+  if (parse_integer_fast(text, value))
+    return value;
 #if defined(PQXX_HAVE_CHARCONV_INT)
   return from_string_arithmetic<T>(text);
 #else
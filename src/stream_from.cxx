@@ -10,10 +10,35 @@
  */
 #include "pqxx-source.hxx"
 
+#include <atomic>
+#include <cerrno>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// For the vectorised scan in find_delimiter():
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+// For writing to file descriptors in to_fd().
+#if __has_include(<sys/uio.h>)
+#  include <climits>
+#  include <sys/uio.h>
+#endif
+#if __has_include(<unistd.h>)
+#  include <unistd.h>
+#elif __has_include(<io.h>)
+#  include <io.h>
+#endif
+
 #include "pqxx/stream_from"
 
 #include "pqxx/internal/encodings.hxx"
 #include "pqxx/internal/gates/connection-stream_from.hxx"
+#include "pqxx/internal/spsc_queue.hxx"
 
 
 namespace
@@ -22,7 +47,7 @@ namespace
 /** If not found, returns line.size() rather than string::npos.
  */
 std::string::size_type find_tab(
-  pqxx::internal::encoding_group enc, std::string const &line,
+  pqxx::internal::encoding_group enc, std::string_view line,
   std::string::size_type start)
 {
   auto here{pqxx::internal::find_with_encoding(enc, line, '\t', start)};
@@ -30,14 +55,278 @@ std::string::size_type find_tab(
 }
 
 
-void begin_copy(
-  pqxx::transaction_base &trans, std::string_view table,
-  std::string const &columns)
+/// Find first tab, newline, or backslash at or after start.
+/** Only valid for ASCII-safe encodings.  Returns the line's size if there is
+ * no such character.  Where possible, checks 16 bytes at a time.
+ */
+std::string::size_type
+find_delimiter(std::string_view line, std::string::size_type start) noexcept
+{
+  auto i{start};
+  auto const size{line.size()};
+  char const *const data{line.data()};
+#if defined(__SSE2__)
+  __m128i const tab{_mm_set1_epi8('\t')}, newline{_mm_set1_epi8('\n')},
+    backslash{_mm_set1_epi8('\\')};
+  for (; i + 16 <= size; i += 16)
+  {
+    __m128i const chunk{
+      _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i))};
+    __m128i const hits{_mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmpeq_epi8(chunk, newline)),
+      _mm_cmpeq_epi8(chunk, backslash))};
+    auto const mask{static_cast<unsigned>(_mm_movemask_epi8(hits))};
+    if (mask != 0)
+      return i + static_cast<std::string::size_type>(__builtin_ctz(mask));
+  }
+#endif
+  for (; i < size; ++i)
+    if (data[i] == '\t' or data[i] == '\n' or data[i] == '\\')
+      return i;
+  return size;
+}
+
+
+/// The character that a COPY escape sequence "\\c" stands for.
+constexpr char unescape_char(char c) noexcept
+{
+  switch (c)
+  {
+  case 'b': return '\b'; // Backspace
+  case 'f': return '\f'; // Form feed
+  case 'n': return '\n'; // Newline
+  case 'r': return '\r'; // Carriage return
+  case 't': return '\t'; // Tab
+  case 'v': return '\v'; // Vertical tab
+  default: return c;     // Self-escaped character
+  }
+}
+
+
+/// Extract a field from a line in an ASCII-safe encoding.
+/** This is the fast path for @c stream_from::extract_field.  A field without
+ * escape sequences comes out as a view on the line itself.  Otherwise, this
+ * unescapes the field into @c s, copying runs of plain text in bulk.
+ */
+bool extract_ascii_safe_field(
+  std::string_view line, std::string::size_type &i, std::string &s,
+  std::string_view &field)
+{
+  auto stop{find_delimiter(line, i)};
+  if (stop >= line.size() or line[stop] != '\\')
+  {
+    // No escapes.  This is what nearly all fields look like.
+    field = line.substr(i, stop - i);
+    i = stop + 1;
+    return true;
+  }
+
+  s.clear();
+  bool is_null{false};
+  for (;;)
+  {
+    s.append(line.data() + i, stop - i);
+    i = stop;
+    if (i >= line.size() or line[i] != '\\')
+      break;
+
+    // Escape sequence.
+    if (i + 1 >= line.size())
+      throw pqxx::failure{"Row ends in backslash"};
+    char const n{line[i + 1]};
+    i += 2;
+    if (n == 'N')
+    {
+      // Null value
+      if (not s.empty())
+        throw pqxx::failure{"Null sequence found in nonempty field"};
+      is_null = true;
+    }
+    else
+    {
+      s += unescape_char(n);
+    }
+    stop = find_delimiter(line, i);
+  }
+
+  // Skip field separator, or the newline at the end of the row.
+  i += 1;
+
+  field = s;
+  return not is_null;
+}
+
+
+/// Does the field from @c i to @c stop contain any escapes or newlines?
+template<pqxx::internal::encoding_group E>
+bool needs_unescaping(
+  std::string_view line, std::string::size_type i,
+  std::string::size_type stop)
+{
+  while (i < stop)
+  {
+    auto const glyph_end{pqxx::internal::glyph_scanner<E>::call(
+      line.data(), line.size(), i)};
+    if (glyph_end - i == 1 and (line[i] == '\\' or line[i] == '\n'))
+      return true;
+    i = glyph_end;
+  }
+  return false;
+}
+
+
+/// Extract a field from a line, going through it glyph by glyph.
+/** This is the slow path for @c stream_from::extract_field, for encodings
+ * where a byte in the ASCII range may be part of a multibyte character.  As
+ * in the fast path, a field without escapes comes out as a view on the line.
+ */
+template<pqxx::internal::encoding_group E>
+bool extract_glyph_field(
+  std::string_view line, std::string::size_type &i, std::string &s,
+  std::string_view &field)
+{
+  auto stop{find_tab(E, line, i)};
+  if (not needs_unescaping<E>(line, i, stop))
+  {
+    field = line.substr(i, stop - i);
+    i = stop + 1;
+    return true;
+  }
+
+  s.clear();
+  bool is_null{false};
+  while (i < stop)
+  {
+    auto glyph_end{pqxx::internal::glyph_scanner<E>::call(
+      line.data(), line.size(), i)};
+    if (auto seq_len{glyph_end - i}; seq_len == 1)
+    {
+      switch (line[i])
+      {
+      case '\n':
+        // End-of-row; shouldn't happen, but we may get old-style
+        // newline-terminated lines.
+        i = stop;
+        break;
+
+      case '\\':
+      {
+        // Escape sequence.
+        if (glyph_end >= line.size())
+          throw pqxx::failure{"Row ends in backslash"};
+        char n{line[glyph_end++]};
+        if (n == 'N')
+        {
+          // Null value
+          if (not s.empty())
+            throw pqxx::failure{"Null sequence found in nonempty field"};
+          is_null = true;
+        }
+        else
+        {
+          s += unescape_char(n);
+        }
+      }
+      break;
+
+      default: s += line[i]; break;
+      }
+    }
+    else
+    {
+      // Multi-byte sequence.  Never treated specially, so just append.
+      s.append(line.data() + i, seq_len);
+    }
+
+    i = glyph_end;
+  }
+
+  // Skip field separator
+  i += 1;
+
+  field = s;
+  return not is_null;
+}
+
+
+/// Throw @c failure for a failed write to a file descriptor.
+[[noreturn]] void throw_write_error(int err)
+{
+  throw pqxx::failure{
+    "Could not write COPY data: " + std::system_category().message(err)};
+}
+
+
+#if __has_include(<sys/uio.h>)
+/// Most rows to gather into one @c writev() call.
+#  if defined(IOV_MAX) && IOV_MAX < 256
+constexpr std::size_t gather_rows{IOV_MAX};
+#  else
+constexpr std::size_t gather_rows{256};
+#  endif
+
+
+/// Write all of @c iov to @c fd, coping with short writes.
+void write_gathered(int fd, iovec *iov, int count)
+{
+  while (count > 0)
+  {
+    auto const written{::writev(fd, iov, count)};
+    if (written < 0)
+    {
+      int const err{errno};
+      if (err == EINTR)
+        continue;
+      throw_write_error(err);
+    }
+    // Skip whatever got written, and resume where it stopped.
+    auto left{static_cast<std::size_t>(written)};
+    for (; count > 0 and left >= iov->iov_len; ++iov, --count)
+      left -= iov->iov_len;
+    if (count > 0)
+    {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+}
+#endif
+
+
+/// Write all of @c data to @c fd, coping with short writes.
+void write_all(int fd, std::string_view data)
+{
+  while (not data.empty())
+  {
+#  if __has_include(<unistd.h>)
+    auto const written{::write(fd, data.data(), data.size())};
+#  else
+    auto const written{
+      ::_write(fd, data.data(), static_cast<unsigned>(data.size()))};
+#  endif
+    if (written < 0)
+    {
+      int const err{errno};
+      if (err == EINTR)
+        continue;
+      throw_write_error(err);
+    }
+    data.remove_prefix(static_cast<std::size_t>(written));
+  }
+}
+
+
+/// Compose a COPY command to read a table.
+std::string copy_table(
+  std::string_view table, std::string const &columns,
+  pqxx::format data_format)
 {
-  constexpr std::string_view copy{"COPY "}, to_stdout{" TO STDOUT"};
+  constexpr std::string_view copy{"COPY "}, to_stdout{" TO STDOUT"},
+    binary{" (FORMAT binary)"};
   std::string query;
   query.reserve(
-    copy.size() + table.size() + columns.size() + 2 + to_stdout.size());
+    copy.size() + table.size() + columns.size() + 2 + to_stdout.size() +
+    binary.size());
   query += copy;
   query += table;
 
@@ -49,12 +338,215 @@ void begin_copy(
   }
 
   query += to_stdout;
+  if (data_format == pqxx::format::binary)
+    query += binary;
+  return query;
+}
+
+
+/// Compose a COPY command to read the results of a query.
+std::string copy_query(std::string_view select, pqxx::format data_format)
+{
+  constexpr std::string_view copy{"COPY ("}, to_stdout{") TO STDOUT"},
+    binary{" (FORMAT binary)"};
+  std::string query;
+  query.reserve(
+    copy.size() + select.size() + to_stdout.size() + binary.size());
+  query += copy;
+  query += select;
+  query += to_stdout;
+  if (data_format == pqxx::format::binary)
+    query += binary;
+  return query;
+}
+
 
-  trans.exec0(query);
+/// Signature at the start of binary COPY data.
+constexpr std::string_view binary_signature{"PGCOPY\n\377\r\n\0", 11};
+
+
+/// Parse the header of binary COPY data.  Returns the offset just past it.
+std::string::size_type skip_binary_header(std::string_view data)
+{
+  // Signature, 32-bit flags field, 32-bit header extension length.
+  constexpr auto fixed_size{binary_signature.size() + 4 + 4};
+  if (data.size() < fixed_size or data.substr(0, 11) != binary_signature)
+    throw pqxx::failure{"Binary COPY data has no valid header."};
+  auto const flags{pqxx::internal::from_big_endian<std::uint32_t>(
+    data.data() + binary_signature.size())};
+  // The low 16 bits are for optional flags; the high ones are critical.
+  if ((flags & 0xffff0000u) != 0)
+    throw pqxx::failure{"Binary COPY data uses unknown critical flags."};
+  auto const extension{pqxx::internal::from_big_endian<std::uint32_t>(
+    data.data() + binary_signature.size() + 4)};
+  if (data.size() - fixed_size < extension)
+    throw pqxx::failure{"Binary COPY header is truncated."};
+  return fixed_size + extension;
+}
+
+
+/// Is @c line the trailer of binary COPY data?
+/** If there were no rows, the header comes along with the trailer.
+ */
+bool is_binary_trailer(std::string_view line)
+{
+  constexpr std::string_view trailer{"\377\377", 2};
+  if (line.size() < 2 or line.substr(line.size() - 2) != trailer)
+    return false;
+  return line.size() == 2 or
+         (line.substr(0, binary_signature.size()) == binary_signature and
+          line.size() == skip_binary_header(line) + 2);
 }
 } // namespace
 
 
+namespace pqxx::internal
+{
+/// Thread that reads a @c stream_from's COPY data ahead of its consumer.
+/** The chunks go round between two queues: the reader takes empty ones from
+ * @c m_free, fills them, and puts them on @c m_full.  The consumer takes them
+ * off @c m_full, and puts them back on @c m_free once it's done with them.
+ * Each queue has room for all chunks, so a push never fails.  A side that
+ * finds its queue empty sleeps until the other side pushes.
+ */
+class copy_reader
+{
+public:
+  copy_reader(connection &cx, std::size_t chunks, std::size_t chunk_size) :
+          m_full{chunks}, m_free{chunks}, m_chunk_size{chunk_size}
+  {
+    for (std::size_t i{0}; i < chunks; ++i)
+    {
+      auto c{std::make_unique<chunk>()};
+      c->data.reserve(chunk_size);
+      m_free.try_push(c);
+    }
+    m_blocked = gate::connection_stream_from{cx}.copy_blocked().count();
+    m_thread = std::thread{[this, &cx] { run(cx); }};
+  }
+
+  ~copy_reader() noexcept { stop(); }
+
+  /// Stop reading, and wait for the thread to finish.
+  void stop() noexcept
+  {
+    m_stop = true;
+    m_free.wake();
+    if (m_thread.joinable())
+      m_thread.join();
+  }
+
+  /// Read the next line.  Returns @c false at the end.
+  /** Rethrows any error that the reader thread ran into.
+   */
+  bool next_line(std::string_view &line)
+  {
+    while (not m_current or m_next == std::size(m_current->ends))
+    {
+      if (m_current and m_current->last)
+      {
+        stop();
+        if (m_current->error)
+          std::rethrow_exception(m_current->error);
+        return false;
+      }
+      if (m_current)
+      {
+        m_current->data.clear();
+        m_current->ends.clear();
+        m_free.push(m_current, never);
+      }
+      // The reader always ends with a "last" chunk, so this won't hang.
+      m_full.pop(m_current, never);
+      m_next = 0;
+    }
+    auto const begin{(m_next == 0) ? 0u : m_current->ends[m_next - 1]};
+    line = std::string_view{
+      std::data(m_current->data) + begin, m_current->ends[m_next] - begin};
+    ++m_next;
+    return true;
+  }
+
+  /// The connection's total COPY waiting time, as of the last chunk.
+  std::chrono::steady_clock::duration blocked() const noexcept
+  {
+    return std::chrono::steady_clock::duration{
+      m_blocked.load(std::memory_order_relaxed)};
+  }
+
+private:
+  struct chunk
+  {
+    /// The lines, back to back.
+    std::string data;
+    /// Offset in @c data where each line ends.
+    std::vector<std::size_t> ends;
+    /// Is this the end of the data?
+    bool last = false;
+    /// Whatever went wrong, if anything.  Comes after the lines.
+    std::exception_ptr error;
+  };
+
+  void run(connection &cx) noexcept
+  {
+    gate::connection_stream_from gate{cx};
+    std::unique_ptr<chunk> c;
+    while (not m_stop)
+    {
+      if (not m_free.pop(c, [this] { return m_stop.load(); }))
+        break;
+      try
+      {
+        // Wait for one line, then take whatever else has already come in.
+        auto [buf, size]{gate.read_copy_line()};
+        c->last = not buf;
+        while (buf)
+        {
+          c->data.append(buf.get(), size);
+          c->ends.push_back(std::size(c->data));
+          if (std::size(c->data) >= m_chunk_size)
+            break;
+          bool done{false};
+          std::tie(buf, size) = gate.try_read_copy_line(done);
+          if (done)
+          {
+            gate.end_copy_read();
+            c->last = true;
+          }
+        }
+      }
+      catch (...)
+      {
+        c->error = std::current_exception();
+        c->last = true;
+      }
+      m_blocked.store(gate.copy_blocked().count(), std::memory_order_relaxed);
+      bool const last{c->last};
+      m_full.push(c, never);
+      if (last)
+        break;
+    }
+  }
+
+  /// Stop condition for waits that never need to give up.
+  static bool never() noexcept { return false; }
+
+  spsc_queue<std::unique_ptr<chunk>> m_full, m_free;
+  std::size_t const m_chunk_size;
+  std::atomic<bool> m_stop{false};
+  std::atomic<std::chrono::steady_clock::rep> m_blocked{0};
+  std::thread m_thread;
+
+  // From here on, only the consuming thread touches these.
+
+  /// The chunk that the consumer is reading from.
+  std::unique_ptr<chunk> m_current;
+  /// Index of the next line in @c m_current.
+  std::size_t m_next = 0;
+};
+} // namespace pqxx::internal
+
+
 pqxx::stream_from::stream_from(
   transaction_base &tb, std::string_view table_name) :
         namedclass{"stream_from", table_name},
@@ -64,6 +556,37 @@ pqxx::stream_from::stream_from(
 }
 
 
+pqxx::stream_from::stream_from(
+  transaction_base &tb, std::string_view table_name, format data_format) :
+        namedclass{"stream_from", table_name},
+        transactionfocus{tb},
+        m_format{data_format}
+{
+  set_up(tb, table_name);
+}
+
+
+pqxx::stream_from::stream_from(
+  transaction_base &tb, table_description const &table, format data_format) :
+        namedclass{"stream_from", table.name},
+        transactionfocus{tb},
+        m_format{data_format}
+{
+  set_up(tb, table.name, table.column_list);
+}
+
+
+pqxx::stream_from::stream_from(
+  transaction_base &tb, from_query_t, std::string_view query,
+  format data_format) :
+        namedclass{"stream_from"},
+        transactionfocus{tb},
+        m_format{data_format}
+{
+  start_copy(tb, copy_query(query, m_format));
+}
+
+
 pqxx::stream_from::~stream_from() noexcept
 {
   try
@@ -79,13 +602,48 @@ pqxx::stream_from::~stream_from() noexcept
 
 bool pqxx::stream_from::get_raw_line(std::string &line)
 {
-  internal::gate::connection_stream_from gate{m_trans.conn()};
+  std::string_view view;
+  get_raw_line(view);
+  line.assign(view);
+  return *this;
+}
+
+
+bool pqxx::stream_from::get_raw_line(std::string_view &line)
+{
   if (*this)
   {
+    internal::gate::connection_stream_from gate{m_trans.conn()};
     try
     {
-      if (not gate.read_copy_line(line))
+      if (m_reader)
+      {
+        if (m_reader->next_line(m_line))
+          count_line();
+        else
+          close();
+      }
+      else if (m_draining)
+      {
+        // A non-blocking read already saw the end of the data.
+        m_line_buf.reset();
+        gate.end_copy_read();
         close();
+      }
+      else
+      {
+        auto [buf, size]{gate.read_copy_line()};
+        m_line_buf = std::move(buf);
+        if (m_line_buf)
+        {
+          m_line = std::string_view{m_line_buf.get(), size};
+          count_line();
+        }
+        else
+        {
+          close();
+        }
+      }
     }
     catch (std::exception const &)
     {
@@ -93,6 +651,9 @@ bool pqxx::stream_from::get_raw_line(std::string &line)
       throw;
     }
   }
+  if (not *this)
+    m_line = std::string_view{};
+  line = m_line;
   return *this;
 }
 
@@ -107,19 +668,268 @@ void pqxx::stream_from::set_up(
 void pqxx::stream_from::set_up(
   transaction_base &tb, std::string_view table_name,
   std::string const &columns)
+{
+  start_copy(tb, copy_table(table_name, columns, m_format));
+}
+
+
+void pqxx::stream_from::start_copy(
+  transaction_base &tb, std::string const &copy_command)
 {
   // Get the encoding before starting the COPY, otherwise reading the
   // variable will interrupt it.
-  m_copy_encoding = internal::enc_group(m_trans.conn().encoding_id());
-  begin_copy(tb, table_name, columns);
+  m_copy_encoding = m_trans.conn().enc_group();
+  tb.exec0(copy_command);
+  m_start = std::chrono::steady_clock::now();
+  m_blocked_before =
+    internal::gate::connection_stream_from{m_trans.conn()}.copy_blocked();
   register_me();
 }
 
 
+void pqxx::stream_from::count_line() noexcept
+{
+  m_stats.bytes += m_line.size();
+  try
+  {
+    if (m_format == format::text or not is_binary_trailer(m_line))
+      ++m_stats.rows;
+  }
+  catch (std::exception const &)
+  {
+    // A bad header.  Reading the row will report that.
+  }
+}
+
+
+pqxx::stream_stats pqxx::stream_from::stats() const noexcept
+{
+  return m_finished ? m_stats : live_stats();
+}
+
+
+pqxx::stream_stats pqxx::stream_from::live_stats() const noexcept
+{
+  auto current{m_stats};
+  current.elapsed = std::chrono::steady_clock::now() - m_start;
+  current.blocked =
+    (m_reader ? m_reader->blocked() :
+                internal::gate::connection_stream_from{m_trans.conn()}
+                  .copy_blocked()) -
+    m_blocked_before;
+  return current;
+}
+
+
+void pqxx::stream_from::read_in_background(
+  std::size_t chunks, std::size_t chunk_size)
+{
+  if (m_finished)
+    throw usage_error{"Stream has already finished."};
+  if (m_reader)
+    throw usage_error{"Stream is already reading in the background."};
+  if (m_draining)
+  {
+    // A non-blocking read already saw the end of the data.  Nothing left.
+    return;
+  }
+  if (chunks == 0 or chunk_size == 0)
+    throw argument_error{"Background stream_from reader needs some space."};
+  m_reader = std::make_shared<internal::copy_reader>(
+    m_trans.conn(), chunks, chunk_size);
+}
+
+
+pqxx::stream_from::read_status
+pqxx::stream_from::try_get_raw_line(std::string_view &line)
+{
+  line = m_line = std::string_view{};
+  if (not *this)
+    return read_status::done;
+
+  if (m_reader)
+    throw usage_error{
+      "Can't read without blocking from a stream_from that is reading in "
+      "the background."};
+
+  internal::gate::connection_stream_from gate{m_trans.conn()};
+  try
+  {
+    if (not m_draining)
+    {
+      auto [buf, size]{gate.try_read_copy_line(m_draining)};
+      m_line_buf = std::move(buf);
+      if (m_line_buf)
+      {
+        line = m_line = std::string_view{m_line_buf.get(), size};
+        count_line();
+        return read_status::row;
+      }
+      if (not m_draining)
+        return read_status::would_block;
+    }
+    if (not gate.try_end_copy_read())
+      return read_status::would_block;
+  }
+  catch (std::exception const &)
+  {
+    close();
+    throw;
+  }
+  close();
+  return read_status::done;
+}
+
+
+int pqxx::stream_from::sock() const noexcept
+{
+  return m_trans.conn().sock();
+}
+
+
+bool pqxx::stream_from::get_binary_row()
+{
+  while (get_raw_line(m_line))
+    if (parse_binary_row())
+      return true;
+  return false;
+}
+
+
+bool pqxx::stream_from::parse_binary_row()
+{
+  std::string::size_type here{0};
+  if (not m_binary_header_done)
+  {
+    here = skip_binary_header(m_line);
+    m_binary_header_done = true;
+  }
+  if (m_line.size() - here < 2)
+    throw failure{"Binary COPY row is truncated."};
+  auto const fields{
+    internal::from_big_endian<std::int16_t>(m_line.data() + here)};
+
+  // A "row" of -1 fields marks the end of the data.  The server should
+  // signal the end of the stream right after.
+  if (fields < 0)
+    return false;
+  m_binary_fields = static_cast<std::size_t>(fields);
+  m_binary_row_start = here + 2;
+  return true;
+}
+
+
+std::size_t pqxx::stream_from::to_fd(int fd)
+{
+  std::size_t total{0};
+  std::string_view line;
+#if __has_include(<sys/uio.h>)
+  // Lines from a background reader don't stay valid long enough to gather
+  // them.  Copy those into a buffer, below.
+  if (not m_reader)
+  {
+    // Hold on to each batch of libpq's buffers until we've written them.
+    std::vector<internal::pq_buffer> lines;
+    lines.reserve(gather_rows);
+    iovec iov[gather_rows];
+    for (bool more{true}; more;)
+    {
+      std::size_t count{0};
+      while (count < gather_rows and (more = get_raw_line(line)))
+      {
+        iov[count].iov_base = const_cast<char *>(line.data());
+        iov[count].iov_len = line.size();
+        total += line.size();
+        lines.push_back(std::move(m_line_buf));
+        ++count;
+      }
+      m_line = std::string_view{};
+      write_gathered(fd, iov, static_cast<int>(count));
+      lines.clear();
+    }
+    return total;
+  }
+#endif
+  // Collect lines into a big buffer, and write that in one go.
+  constexpr std::size_t buffer_size{1024 * 1024};
+  std::string buffer;
+  buffer.reserve(buffer_size);
+  for (bool more{true}; more;)
+  {
+    while (buffer.size() < buffer_size and (more = get_raw_line(line)))
+      buffer += line;
+    write_all(fd, buffer);
+    total += buffer.size();
+    buffer.clear();
+  }
+  return total;
+}
+
+
+bool pqxx::stream_from::get_raw_row(std::string_view &row)
+{
+  if (m_format == format::text)
+    return get_raw_line(row);
+  if (not get_binary_row())
+    return false;
+  // Include the field count, which parse_binary_row() skipped.
+  row = m_line.substr(m_binary_row_start - 2);
+  return true;
+}
+
+
+void pqxx::stream_from::check_binary_fields(std::size_t fields) const
+{
+  if (m_binary_fields != fields)
+    throw usage_error{
+      "Tried to extract " + to_string(fields) + " field(s) from a row of " +
+      to_string(m_binary_fields) + "."};
+}
+
+
+void pqxx::stream_from::check_line_end(
+  std::string_view line, std::string::size_type here)
+{
+  if (
+    here < line.size() and
+    not(here == line.size() - 1 and line[here] == '\n'))
+    throw usage_error{"Not all fields extracted from stream_from line"};
+}
+
+
+bool pqxx::stream_from::next_binary_field(
+  std::string::size_type &here, std::string_view &data) const
+{
+  if (m_line.size() - here < 4)
+    throw failure{"Binary COPY row is truncated."};
+  auto const len{
+    internal::from_big_endian<std::int32_t>(m_line.data() + here)};
+  here += 4;
+  if (len < 0)
+    return false;
+  auto const size{static_cast<std::string::size_type>(len)};
+  if (m_line.size() - here < size)
+    throw failure{"Binary COPY field is truncated."};
+  data = std::string_view{m_line.data() + here, size};
+  here += size;
+  return true;
+}
+
+
 void pqxx::stream_from::close()
 {
   if (!m_finished)
   {
+    if (m_reader)
+    {
+      m_reader->stop();
+      m_stats = live_stats();
+      m_reader.reset();
+    }
+    else
+    {
+      m_stats = live_stats();
+    }
     m_finished = true;
     unregister_me();
   }
@@ -134,7 +944,7 @@ void pqxx::stream_from::complete()
   {
     // Flush any remaining lines - libpq will automatically close the stream
     // when it hits the end.
-    std::string s;
+    std::string_view s;
     while (get_raw_line(s))
       ;
   }
@@ -152,93 +962,26 @@ void pqxx::stream_from::complete()
 
 
 bool pqxx::stream_from::extract_field(
-  std::string const &line, std::string::size_type &i, std::string &s) const
+  std::string_view line, std::string::size_type &i, std::string &s,
+  std::string_view &field) const
 {
   if (i >= line.size())
     throw usage_error{"Too few fields to extract from stream_from line."};
-  auto const next_seq{get_glyph_scanner(m_copy_encoding)};
-  s.clear();
-  bool is_null{false};
-  auto stop{find_tab(m_copy_encoding, line, i)};
-  while (i < stop)
-  {
-    auto glyph_end{next_seq(line.c_str(), line.size(), i)};
-    if (auto seq_len{glyph_end - i}; seq_len == 1)
-    {
-      switch (line[i])
-      {
-      case '\n':
-        // End-of-row; shouldn't happen, but we may get old-style
-        // newline-terminated lines.
-        i = stop;
-        break;
-
-      case '\\':
-      {
-        // Escape sequence.
-        if (glyph_end >= line.size())
-          throw failure{"Row ends in backslash"};
-        char n{line[glyph_end++]};
-        switch (n)
-        {
-        case 'N':
-          // Null value
-          if (not s.empty())
-            throw failure{"Null sequence found in nonempty field"};
-          is_null = true;
-          break;
-
-        case 'b': // Backspace
-          s += '\b';
-          break;
-        case 'f': // Vertical tab
-          s += '\f';
-          break;
-        case 'n': // Form feed
-          s += '\n';
-          break;
-        case 'r': // Newline
-          s += '\r';
-          break;
-        case 't': // Tab
-          s += '\t';
-          break;
-        case 'v': // Carriage return
-          s += '\v';
-          break;
-
-        default:
-          // Self-escaped character
-          s += n;
-          break;
-        }
-      }
-      break;
-
-      default: s += line[i]; break;
-      }
-    }
-    else
-    {
-      // Multi-byte sequence.  Never treated specially, so just append.
-      s.insert(s.size(), line.c_str() + i, seq_len);
-    }
+  if (pqxx::internal::is_ascii_safe(m_copy_encoding))
+    return extract_ascii_safe_field(line, i, s, field);
 
-    i = glyph_end;
-  }
-
-  // Skip field separator
-  i += 1;
-
-  return not is_null;
+  return pqxx::internal::with_encoding(m_copy_encoding, [&](auto e) {
+    return extract_glyph_field<decltype(e)::value>(line, i, s, field);
+  });
 }
 
 template<>
 void pqxx::stream_from::extract_value<std::nullptr_t>(
-  std::string const &line, std::nullptr_t &, std::string::size_type &here,
+  std::string_view line, std::nullptr_t &, std::string::size_type &here,
   std::string &workspace) const
 {
-  if (extract_field(line, here, workspace))
-    throw pqxx::conversion_error{"Attempt to convert non-null '" + workspace +
-                                 "' to null"};
+  std::string_view field;
+  if (extract_field(line, here, workspace, field))
+    throw pqxx::conversion_error{
+      "Attempt to convert non-null '" + std::string{field} + "' to null"};
 }
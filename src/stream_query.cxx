@@ -0,0 +1,154 @@
+/** Implementation of the pqxx::stream_query class.
+ *
+ * pqxx::stream_query reads the results of a query one row at a time.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include "pqxx/stream_query"
+
+#include "pqxx/internal/gates/connection-stream_query.hxx"
+#include "pqxx/internal/gates/result-creation.hxx"
+
+
+pqxx::stream_query::stream_query(
+  transaction_base &tb, std::string_view query) :
+        namedclass{"stream_query"},
+        transactionfocus{tb},
+        m_query{std::make_shared<std::string>(query)}
+{
+  set_up(0);
+}
+
+
+pqxx::stream_query::stream_query(
+  transaction_base &tb, std::string_view query, int chunk_rows) :
+        namedclass{"stream_query"},
+        transactionfocus{tb},
+        m_query{std::make_shared<std::string>(query)}
+{
+  if (chunk_rows < 1)
+    throw range_error{
+      "Streaming query in chunks of " + to_string(chunk_rows) + " rows."};
+  set_up(chunk_rows);
+}
+
+
+pqxx::stream_query::~stream_query() noexcept
+{
+  try
+  {
+    complete();
+  }
+  catch (std::exception const &e)
+  {
+    reg_pending_error(e.what());
+  }
+}
+
+
+void pqxx::stream_query::set_up(int chunk_rows)
+{
+  internal::gate::connection_stream_query gate{m_trans.conn()};
+  // Get the encoding before starting the query; we can't ask once it's
+  // running.
+  m_encoding = gate.enc_group();
+  register_me();
+  try
+  {
+    gate.start_exec(m_query->c_str());
+  }
+  catch (std::exception const &)
+  {
+    close();
+    throw;
+  }
+
+  // If we can't switch modes, the query will still produce a result.  We
+  // must read it, or the connection stays busy.
+  try
+  {
+    if (chunk_rows > 1)
+      gate.set_chunked_rows_mode(chunk_rows);
+    else
+      gate.set_single_row_mode();
+  }
+  catch (std::exception const &)
+  {
+    while (auto const r{gate.get_result()})
+      internal::clear_result(r);
+    close();
+    throw;
+  }
+}
+
+
+void pqxx::stream_query::close()
+{
+  if (not m_finished)
+  {
+    m_finished = true;
+    m_chunk.clear();
+    m_chunk_row = 0;
+    unregister_me();
+  }
+}
+
+
+void pqxx::stream_query::complete()
+{
+  if (m_finished)
+    return;
+  try
+  {
+    while (not read_chunk().empty())
+      ;
+  }
+  catch (std::exception const &)
+  {
+    close();
+    throw;
+  }
+}
+
+
+pqxx::result pqxx::stream_query::read_chunk()
+{
+  internal::gate::connection_stream_query gate{m_trans.conn()};
+  while (not m_finished)
+  {
+    auto const r{gate.get_result()};
+    if (r == nullptr)
+    {
+      // A null result marks the end of the query's results.
+      close();
+      break;
+    }
+
+    result const res{
+      internal::gate::result_creation::create(r, m_query, m_encoding)};
+    try
+    {
+      internal::gate::result_creation{res}.check_status();
+    }
+    catch (std::exception const &)
+    {
+      // Read the rest of the results, so the connection becomes usable
+      // again.
+      while (auto const tail{gate.get_result()})
+        internal::clear_result(tail);
+      close();
+      throw;
+    }
+
+    // The final result, which tells us that the query is done, has no rows.
+    if (not res.empty())
+      return res;
+  }
+  return result{};
+}
@@ -10,22 +10,34 @@
  */
 #include "pqxx-source.hxx"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+// For the vectorised scan in find_copy_special():
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 #include "pqxx/stream_from.hxx"
 #include "pqxx/stream_to.hxx"
 
 #include "pqxx/internal/gates/connection-stream_to.hxx"
+#include "pqxx/internal/mapped_file.hxx"
 
 
 namespace
 {
 void begin_copy(
   pqxx::transaction_base &trans, std::string_view table,
-  std::string const &columns)
+  std::string const &columns, pqxx::format data_format)
 {
-  constexpr std::string_view copy{"COPY "}, from_stdin{" FROM STDIN"};
+  constexpr std::string_view copy{"COPY "}, from_stdin{" FROM STDIN"},
+    binary{" (FORMAT binary)"};
   std::string query;
   query.reserve(
-    copy.size() + table.size() + 2 + columns.size() + from_stdin.size());
+    copy.size() + table.size() + 2 + columns.size() + from_stdin.size() +
+    binary.size());
 
   query += copy;
   query += table;
@@ -36,12 +48,300 @@ void begin_copy(
     query.push_back(')');
   }
   query += from_stdin;
+  if (data_format == pqxx::format::binary)
+    query += binary;
 
   trans.exec0(query);
 }
+
+
+/// Header for binary COPY data: signature, flags, header extension length.
+constexpr std::string_view binary_header{
+  "PGCOPY\n\377\r\n\0"
+  "\0\0\0\0"
+  "\0\0\0\0",
+  19};
+
+/// Trailer for binary COPY data: a row with -1 fields.
+constexpr std::string_view binary_trailer{"\377\377", 2};
+
+
+/// The letter for escaping c in COPY text format ("\\n" etc.), or zero.
+constexpr char escape_letter(unsigned char c) noexcept
+{
+  switch (c)
+  {
+  case '\b': return 'b';  // Backspace
+  case '\f': return 'f';  // Form feed
+  case '\n': return 'n';  // Newline
+  case '\r': return 'r';  // Carriage return
+  case '\t': return 't';  // Tab
+  case '\v': return 'v';  // Vertical tab
+  case '\\': return '\\'; // Backslash
+  default: return '\0';
+  }
+}
+
+
+/// Does c need escaping in COPY text format?
+constexpr bool is_copy_special(unsigned char c) noexcept
+{
+  // This covers all the characters in escape_letter(), except backslash.
+  return c < ' ' or c > '~' or c == '\\';
+}
+
+
+/// Find the offset of the first byte in data that needs escaping.
+/** Returns size if there is no such byte.  Most text needs no escaping at
+ * all, so where possible, we check 16 bytes at a time.
+ */
+std::size_t find_copy_special(char const data[], std::size_t size) noexcept
+{
+  std::size_t i{0};
+#if defined(__SSE2__)
+  // Compare as signed bytes: anything from 0x80 up counts as less than ' '.
+  __m128i const space{_mm_set1_epi8(' ')}, tilde{_mm_set1_epi8('~')},
+    backslash{_mm_set1_epi8('\\')};
+  for (; i + 16 <= size; i += 16)
+  {
+    __m128i const chunk{
+      _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i))};
+    __m128i const special{_mm_or_si128(
+      _mm_or_si128(_mm_cmplt_epi8(chunk, space), _mm_cmpgt_epi8(chunk, tilde)),
+      _mm_cmpeq_epi8(chunk, backslash))};
+    auto const mask{static_cast<unsigned>(_mm_movemask_epi8(special))};
+    if (mask != 0)
+      return i + static_cast<std::size_t>(__builtin_ctz(mask));
+  }
+#endif
+  for (; i < size; ++i)
+    if (is_copy_special(static_cast<unsigned char>(data[i])))
+      return i;
+  return size;
+}
 } // namespace
 
 
+namespace pqxx::internal
+{
+/// Set of the keys of COPY rows, for weeding out duplicates.
+/** An open-addressing hash table with linear probing.  The keys themselves
+ * live one after the other in a single string, so there's no allocation per
+ * key.  The table and the keys together stay within a memory limit.
+ */
+class copy_key_set
+{
+public:
+  copy_key_set(std::vector<row_size_type> key, std::size_t max_memory) :
+          m_key{std::move(key)},
+          m_fields(
+            static_cast<std::size_t>(
+              *std::max_element(std::begin(m_key), std::end(m_key))) +
+            1),
+          m_max_memory{max_memory}
+  {}
+
+  /// Does @c row have the same key as an earlier row?
+  /** If not, remember its key, if there's room.
+   */
+  bool seen(std::string_view row, format data_format)
+  {
+    if (not make_key(row, data_format))
+      return false;
+    auto const hash{std::hash<std::string_view>{}(m_scratch)};
+    auto index{find(m_scratch, hash)};
+    if (index == found)
+    {
+      ++m_duplicates;
+      return true;
+    }
+    if (m_overflowed)
+      return false;
+    if ((m_count + 1) * 2 > std::size(m_slots))
+    {
+      if (not grow())
+        return overflow();
+      index = find(m_scratch, hash);
+    }
+    if (not make_room(std::size(m_scratch)))
+      return overflow();
+    m_slots[index] = {hash, std::size(m_arena), std::size(m_scratch)};
+    m_arena += m_scratch;
+    ++m_count;
+    return false;
+  }
+
+  [[nodiscard]] std::size_t duplicates() const noexcept
+  {
+    return m_duplicates;
+  }
+  [[nodiscard]] bool overflowed() const noexcept { return m_overflowed; }
+
+private:
+  struct slot
+  {
+    std::size_t hash;
+    /// Where the key starts in @c m_arena, or @c empty if the slot is free.
+    std::size_t offset = empty;
+    std::size_t size = 0;
+  };
+  static constexpr std::size_t empty{std::string::npos};
+  /// What @c find() returns when it finds the key.
+  static constexpr std::size_t found{std::string::npos};
+  /// Number of slots the table starts out with.
+  static constexpr std::size_t initial_slots{1024};
+
+  /// Compose the key of @c row in @c m_scratch.  False if it has a null.
+  /** Each key field goes in with its length in front, so that there's no
+   * confusing the boundaries between fields.
+   */
+  bool make_key(std::string_view row, format data_format)
+  {
+    if (data_format == format::text)
+      split_text(row);
+    else
+      split_binary(row);
+    m_scratch.clear();
+    for (auto const k : m_key)
+    {
+      auto const field{m_fields[static_cast<std::size_t>(k)]};
+      if (field.data() == nullptr)
+        return false;
+      auto const size{static_cast<std::uint32_t>(std::size(field))};
+      m_scratch.append(reinterpret_cast<char const *>(&size), sizeof(size));
+      m_scratch.append(field);
+    }
+    return true;
+  }
+
+  /// Find the fields of a row in COPY's text format.  Null is a null view.
+  void split_text(std::string_view row)
+  {
+    if (not std::empty(row) and row.back() == '\n')
+      row.remove_suffix(1);
+    std::size_t here{0};
+    for (std::size_t f{0}; f < std::size(m_fields); ++f)
+    {
+      if (here > std::size(row))
+        throw_short(f);
+      auto const tab{std::min(row.find('\t', here), std::size(row))};
+      auto const field{row.substr(here, tab - here)};
+      m_fields[f] = (field == "\\N") ? std::string_view{} : field;
+      here = tab + 1;
+    }
+  }
+
+  /// Find the fields of a row in COPY's binary format.
+  void split_binary(std::string_view row)
+  {
+    auto const count{
+      static_cast<std::size_t>(from_big_endian<std::int16_t>(row.data()))};
+    if (count < std::size(m_fields))
+      throw_short(count);
+    std::size_t here{2};
+    for (auto &field : m_fields)
+    {
+      auto const size{from_big_endian<std::int32_t>(row.data() + here)};
+      here += 4;
+      if (size < 0)
+      {
+        field = std::string_view{};
+      }
+      else
+      {
+        field = row.substr(here, static_cast<std::size_t>(size));
+        here += static_cast<std::size_t>(size);
+      }
+    }
+  }
+
+  [[noreturn]] void throw_short(std::size_t fields) const
+  {
+    throw usage_error{
+      "Deduplicating rows on field " + to_string(std::size(m_fields) - 1) +
+      ", but a row has only " + to_string(fields) + " field(s)."};
+  }
+
+  /// Index of the slot holding @c key, or else of the free slot for it.
+  /** Returns @c found if @c key is in the set.
+   */
+  std::size_t find(std::string_view key, std::size_t hash) const noexcept
+  {
+    if (std::empty(m_slots))
+      return 0;
+    auto const mask{std::size(m_slots) - 1};
+    for (auto i{hash & mask};; i = (i + 1) & mask)
+    {
+      auto const &s{m_slots[i]};
+      if (s.offset == empty)
+        return i;
+      if (s.hash == hash and key == std::string_view{m_arena}.substr(
+                                       s.offset, s.size))
+        return found;
+    }
+  }
+
+  [[nodiscard]] std::size_t table_memory(std::size_t slots) const noexcept
+  {
+    return slots * sizeof(slot);
+  }
+
+  /// Double the number of slots, if the memory limit allows.
+  bool grow()
+  {
+    auto const slots{std::max(initial_slots, 2 * std::size(m_slots))};
+    if (table_memory(slots) + m_arena.capacity() > m_max_memory)
+      return false;
+    std::vector<slot> old{slots};
+    old.swap(m_slots);
+    auto const mask{slots - 1};
+    for (auto const &s : old)
+      if (s.offset != empty)
+      {
+        auto i{s.hash & mask};
+        while (m_slots[i].offset != empty) i = (i + 1) & mask;
+        m_slots[i] = s;
+      }
+    return true;
+  }
+
+  /// Make sure @c m_arena can take @c bytes more, within the memory limit.
+  bool make_room(std::size_t bytes)
+  {
+    auto const need{std::size(m_arena) + bytes};
+    auto const capacity{m_arena.capacity()};
+    if (need <= capacity)
+      return true;
+    auto const table{table_memory(std::size(m_slots))};
+    if (table + need > m_max_memory)
+      return false;
+    m_arena.reserve(
+      std::min(std::max(need, 2 * capacity), m_max_memory - table));
+    return true;
+  }
+
+  bool overflow() noexcept
+  {
+    m_overflowed = true;
+    return false;
+  }
+
+  std::vector<row_size_type> const m_key;
+  /// The fields of the current row, up to the last one in the key.
+  std::vector<std::string_view> m_fields;
+  std::size_t const m_max_memory;
+  std::vector<slot> m_slots;
+  std::size_t m_count = 0;
+  /// All keys in the set, one after the other.
+  std::string m_arena;
+  /// The current row's key.
+  std::string m_scratch;
+  std::size_t m_duplicates = 0;
+  bool m_overflowed = false;
+};
+} // namespace pqxx::internal
+
+
 pqxx::stream_to::stream_to(transaction_base &tb, std::string_view table_name) :
         namedclass{"stream_to", table_name},
         internal::transactionfocus{tb}
@@ -50,6 +350,26 @@ pqxx::stream_to::stream_to(transaction_base &tb, std::string_view table_name) :
 }
 
 
+pqxx::stream_to::stream_to(
+  transaction_base &tb, std::string_view table_name, format data_format) :
+        namedclass{"stream_to", table_name},
+        internal::transactionfocus{tb},
+        m_format{data_format}
+{
+  set_up(tb, table_name);
+}
+
+
+pqxx::stream_to::stream_to(
+  transaction_base &tb, table_description const &table, format data_format) :
+        namedclass{"stream_to", table.name},
+        internal::transactionfocus{tb},
+        m_format{data_format}
+{
+  set_up(tb, table.name, table.column_list);
+}
+
+
 pqxx::stream_to::~stream_to() noexcept
 {
   try
@@ -65,17 +385,181 @@ pqxx::stream_to::~stream_to() noexcept
 
 void pqxx::stream_to::write_raw_line(std::string_view line)
 {
-  internal::gate::connection_stream_to{m_trans.conn()}.write_copy_line(line);
+  auto const start{m_buffer.size()};
+  m_buffer.reserve(start + line.size() + 1);
+  m_buffer += line;
+  m_buffer.push_back('\n');
+  end_row(start);
+}
+
+
+void pqxx::stream_to::set_dedup(
+  std::vector<row_size_type> key, std::size_t max_memory)
+{
+  if (std::empty(key))
+    throw argument_error{"Deduplicating a stream_to on an empty key."};
+  for (auto const k : key)
+    if (k < 0)
+      throw argument_error{"Negative field number in stream_to dedup key."};
+  m_keys =
+    std::make_shared<internal::copy_key_set>(std::move(key), max_memory);
+}
+
+
+std::size_t pqxx::stream_to::duplicates() const noexcept
+{
+  return m_keys ? m_keys->duplicates() : 0;
+}
+
+
+bool pqxx::stream_to::dedup_overflowed() const noexcept
+{
+  return m_keys and m_keys->overflowed();
+}
+
+
+pqxx::stream_stats pqxx::stream_to::stats() const noexcept
+{
+  return m_finished ? m_stats : live_stats();
+}
+
+
+pqxx::stream_stats pqxx::stream_to::live_stats() const noexcept
+{
+  auto current{m_stats};
+  current.elapsed = std::chrono::steady_clock::now() - m_start;
+  current.blocked =
+    internal::gate::connection_stream_to{m_trans.conn()}.copy_blocked() -
+    m_blocked_before;
+  return current;
+}
+
+
+void pqxx::stream_to::send_copy_data(std::string_view data)
+{
+  internal::gate::connection_stream_to gate{m_trans.conn()};
+  gate.write_copy_data(data);
+  m_stats.bytes += std::size(data);
+  if (m_max_pending > 0)
+  {
+    // We don't know how much of this libpq has managed to send already, so
+    // this may wait sooner than needed.  But not by more than max_pending.
+    m_pending += std::size(data);
+    if (m_pending >= m_max_pending)
+    {
+      gate.drain_copy_output();
+      m_pending = 0;
+    }
+  }
+}
+
+
+void pqxx::stream_to::set_nonblocking(std::size_t max_pending)
+{
+  if (m_finished)
+    throw usage_error{"Setting non-blocking mode on a finished stream_to."};
+  if (max_pending == 0)
+    throw argument_error{"Non-blocking stream_to needs room for some data."};
+  if (m_max_pending == 0)
+    internal::gate::connection_stream_to{m_trans.conn()}.set_nonblocking(
+      true);
+  m_max_pending = max_pending;
+}
+
+
+bool pqxx::stream_to::try_flush()
+{
+  flush();
+  if (m_max_pending == 0)
+    return true;
+  bool const done{
+    internal::gate::connection_stream_to{m_trans.conn()}.flush_output()};
+  if (done)
+    m_pending = 0;
+  return done;
+}
+
+
+bool pqxx::stream_to::drop_duplicate(std::size_t start)
+{
+  std::string_view const row{
+    std::data(m_buffer) + start, std::size(m_buffer) - start};
+  bool duplicate;
+  try
+  {
+    duplicate = m_keys->seen(row, m_format);
+  }
+  catch (std::exception const &)
+  {
+    m_buffer.resize(start);
+    throw;
+  }
+  if (duplicate)
+    m_buffer.resize(start);
+  return duplicate;
+}
+
+
+void pqxx::stream_to::write_raw_data(std::string_view data)
+{
+  m_buffer += data;
+  flush_if_full();
+}
+
+
+void pqxx::stream_to::send_raw_data(std::string_view data)
+{
+  flush();
+  send_copy_data(data);
+}
+
+
+std::size_t pqxx::stream_to::from_file(std::string_view path)
+{
+  if (m_format != format::text)
+    throw usage_error{"stream_to::from_file() only works in text format."};
+  if (m_finished)
+    throw usage_error{"Loading a file into a stream_to that has finished."};
+
+  // Send the file in chunks of this size, so that libpq's buffer for
+  // outgoing data does not have to grow to the size of the file.
+  constexpr std::size_t chunk_size{1024 * 1024};
+  internal::mapped_file const file{std::string{path}};
+  auto const data{file.data()};
+  flush();
+  for (std::size_t here{0}; here < std::size(data); here += chunk_size)
+    send_copy_data(data.substr(here, chunk_size));
+  if (data.empty() or data.back() == '\n')
+    return std::size(data);
+  send_copy_data("\n");
+  return std::size(data) + 1;
+}
+
+
+void pqxx::stream_to::flush()
+{
+  if (not m_buffer.empty())
+  {
+    send_copy_data(m_buffer);
+    // Keep the allocated memory around for the next batch.
+    m_buffer.clear();
+  }
 }
 
 
 pqxx::stream_to &pqxx::stream_to::operator<<(stream_from &tr)
 {
-  std::string line;
-  while (tr)
+  if (m_format != format::text or tr.data_format() != format::text)
+    throw usage_error{
+      "Streaming a stream_from into a stream_to only works in text format."};
+  std::string_view line;
+  while (tr.get_raw_line(line))
   {
-    tr.get_raw_line(line);
-    write_raw_line(line);
+    // Lines normally come with their newline, but be prepared for either.
+    if (not line.empty() and line.back() == '\n')
+      write_raw_data(line);
+    else
+      write_raw_line(line);
   }
   return *this;
 }
@@ -91,8 +575,13 @@ void pqxx::stream_to::set_up(
   transaction_base &tb, std::string_view table_name,
   std::string const &columns)
 {
-  begin_copy(tb, table_name, columns);
+  begin_copy(tb, table_name, columns, m_format);
+  m_start = std::chrono::steady_clock::now();
+  m_blocked_before =
+    internal::gate::connection_stream_to{m_trans.conn()}.copy_blocked();
   register_me();
+  if (m_format == format::binary)
+    write_raw_data(binary_header);
 }
 
 
@@ -100,41 +589,85 @@ void pqxx::stream_to::complete()
 {
   if (!m_finished)
   {
+    if (m_format == format::binary)
+      m_buffer += binary_trailer;
     m_finished = true;
     unregister_me();
-    internal::gate::connection_stream_to{m_trans.conn()}.end_copy_write();
+    // Even if the COPY fails, keep the numbers up to the point of failure.
+    try
+    {
+      flush();
+      internal::gate::connection_stream_to gate{m_trans.conn()};
+      if (m_max_pending > 0)
+      {
+        m_max_pending = 0;
+        gate.drain_copy_output();
+        gate.set_nonblocking(false);
+      }
+      gate.end_copy_write();
+    }
+    catch (std::exception const &)
+    {
+      m_stats = live_stats();
+      throw;
+    }
+    m_stats = live_stats();
   }
 }
 
 
 std::string pqxx::internal::copy_string_escape(std::string_view s)
 {
-  if (s.empty())
-    return std::string{};
+  std::string escaped{s};
+  copy_escape_tail(escaped, 0);
+  return escaped;
+}
 
-  std::string escaped;
-  escaped.reserve(s.size() + 1);
 
-  for (auto c : s) switch (c)
+void pqxx::internal::copy_escape_tail(std::string &buf, std::size_t start)
+{
+  auto const old_end{buf.size()};
+  auto const first{
+    start + find_copy_special(buf.data() + start, old_end - start)};
+  // In the common case, where nothing needs escaping, that's all we do.
+  if (first == old_end)
+    return;
+
+  // Figure out how much longer the escaped text will be, skipping over runs
+  // of plain text.
+  std::size_t extra{0};
+  for (auto i{first}; i < old_end;
+       i += find_copy_special(buf.data() + i, old_end - i))
+  {
+    auto const c{static_cast<unsigned char>(buf[i++])};
+    extra += (escape_letter(c) == '\0') ? 3 : 1;
+  }
+
+  // Expand the text in place, working backwards from the end so we never
+  // overwrite text we haven't moved yet.  Everything before the first special
+  // character stays where it is.
+  buf.resize(old_end + extra);
+  char *const data{buf.data()};
+  auto out{old_end + extra};
+  for (auto in{old_end}; in > first;)
+  {
+    auto const c{static_cast<unsigned char>(data[--in])};
+    if (not is_copy_special(c))
     {
-    case '\b': escaped += "\\b"; break;  // Backspace
-    case '\f': escaped += "\\f"; break;  // Vertical tab
-    case '\n': escaped += "\\n"; break;  // Form feed
-    case '\r': escaped += "\\r"; break;  // Newline
-    case '\t': escaped += "\\t"; break;  // Tab
-    case '\v': escaped += "\\v"; break;  // Carriage return
-    case '\\': escaped += "\\\\"; break; // Backslash
-    default:
-      if (c < ' ' or c > '~')
-      {
-        escaped += "\\";
-        for (auto i = 2; i >= 0; --i)
-          escaped += number_to_digit((c >> (3 * i)) & 0x07);
-      }
-      else
-        escaped += c;
-      break;
+      data[--out] = static_cast<char>(c);
+      continue;
     }
-
-  return escaped;
+    auto const letter{escape_letter(c)};
+    if (letter != '\0')
+    {
+      data[--out] = letter;
+    }
+    else
+    {
+      data[--out] = number_to_digit(c & 0x07);
+      data[--out] = number_to_digit((c >> 3) & 0x07);
+      data[--out] = number_to_digit((c >> 6) & 0x07);
+    }
+    data[--out] = '\\';
+  }
 }
@@ -22,7 +22,9 @@ pqxx::subtransaction::subtransaction(
         transactionfocus{t},
         dbtransaction(t.conn())
 {
-  direct_exec("SAVEPOINT " + quoted_name());
+  // The savepoint goes out along with the first statement.  If there isn't
+  // one, it never needs to go out at all.
+  defer_savepoint(savepoint_command());
 }
 
 
@@ -38,13 +40,23 @@ pqxx::subtransaction::subtransaction(
 {}
 
 
+std::string pqxx::subtransaction::savepoint_command() const
+{
+  return "SAVEPOINT " + quoted_name();
+}
+
+
 void pqxx::subtransaction::do_commit()
 {
-  direct_exec("RELEASE SAVEPOINT " + quoted_name());
+  // Statements execute in order, so the release still takes effect before
+  // anything that comes after this subtransaction.
+  if (not drop_deferred_savepoint(savepoint_command()))
+    defer_savepoint("RELEASE SAVEPOINT " + quoted_name());
 }
 
 
 void pqxx::subtransaction::do_abort()
 {
-  direct_exec("ROLLBACK TO SAVEPOINT " + quoted_name());
+  if (not drop_deferred_savepoint(savepoint_command()))
+    defer_savepoint("ROLLBACK TO SAVEPOINT " + quoted_name());
 }
@@ -0,0 +1,173 @@
+/** Implementation of the pqxx::table_copy class.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "pqxx/except"
+#include "pqxx/table_copy"
+
+#include "pqxx/internal/gates/stream_from-table_copy.hxx"
+#include "pqxx/internal/gates/stream_to-table_copy.hxx"
+
+
+namespace
+{
+/// Hand-off point between the reader thread and the writer.
+/** The reader fills one buffer while the writer sends the other.  When the
+ * reader's buffer is full, it waits for the writer to finish with the other
+ * one, and then they swap.  So there are only ever two buffers, and their
+ * memory gets re-used all the way through.
+ */
+struct handoff
+{
+  std::mutex lock;
+  std::condition_variable changed;
+
+  /// Data for the writer to send.  Only the writer touches it while @c full.
+  std::string data;
+  bool full = false;
+  /// The reader has handed off its last buffer.
+  bool done = false;
+  /// The writer failed; the reader should stop.
+  bool cancelled = false;
+  std::exception_ptr error;
+
+  /// Reader: pass @c buffer to the writer, and take back an empty one.
+  /** Returns @c false if the writer has given up.
+   */
+  bool pass(std::string &buffer)
+  {
+    std::unique_lock<std::mutex> guard{lock};
+    changed.wait(guard, [this] { return cancelled or not full; });
+    if (cancelled)
+      return false;
+    data.swap(buffer);
+    full = true;
+    changed.notify_all();
+    guard.unlock();
+    buffer.clear();
+    return true;
+  }
+
+  /// Reader: there is no more data, possibly because of @c failure.
+  void finish(std::exception_ptr failure = nullptr)
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    error = failure;
+    done = true;
+    changed.notify_all();
+  }
+
+  /// Writer: wait for data.  Returns @c false if there is none coming.
+  bool wait()
+  {
+    std::unique_lock<std::mutex> guard{lock};
+    changed.wait(guard, [this] { return full or done; });
+    return full;
+  }
+
+  /// Writer: done with @c data, the reader can have it back.
+  void release()
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    data.clear();
+    full = false;
+    changed.notify_all();
+  }
+
+  /// Writer: give up, and let the reader know.
+  void cancel() noexcept
+  {
+    std::lock_guard<std::mutex> guard{lock};
+    cancelled = true;
+    changed.notify_all();
+  }
+};
+} // namespace
+
+
+pqxx::table_copy::table_copy(
+  stream_from &source, stream_to &target, std::size_t buffer_size) :
+        m_source{source}, m_target{target}, m_buffer_size{buffer_size}
+{
+  if (source.data_format() != target.data_format())
+    throw usage_error{
+      "Can't copy between streams with different data formats."};
+  if (
+    &internal::gate::stream_from_table_copy{source}.conn() ==
+    &internal::gate::stream_to_table_copy{target}.conn())
+    throw usage_error{
+      "Can't copy between streams on the same connection.  "
+      "Use a query instead."};
+  if (buffer_size == 0)
+    throw usage_error{"A table_copy needs a nonzero buffer size."};
+}
+
+
+std::size_t pqxx::table_copy::run()
+{
+  bool const text{m_source.data_format() == format::text};
+  handoff shared;
+  std::size_t rows{0};
+
+  // The reader thread: fill a buffer with rows, and pass it on.
+  std::thread reader{[this, text, &shared, &rows] {
+    try
+    {
+      internal::gate::stream_from_table_copy source{m_source};
+      std::string buffer;
+      buffer.reserve(m_buffer_size);
+      std::string_view row;
+      while (source.get_raw_row(row))
+      {
+        buffer += row;
+        // Text rows normally come with their newline, but may not.
+        if (text and (row.empty() or row.back() != '\n'))
+          buffer.push_back('\n');
+        ++rows;
+        if (std::size(buffer) >= m_buffer_size and not shared.pass(buffer))
+          return;
+      }
+      if (not buffer.empty() and not shared.pass(buffer))
+        return;
+      shared.finish();
+    }
+    catch (...)
+    {
+      shared.finish(std::current_exception());
+    }
+  }};
+
+  // The writer, in this thread: send each buffer as it comes in.
+  try
+  {
+    internal::gate::stream_to_table_copy target{m_target};
+    while (shared.wait())
+    {
+      target.send_raw_data(shared.data);
+      m_bytes += std::size(shared.data);
+      shared.release();
+    }
+  }
+  catch (...)
+  {
+    shared.cancel();
+    reader.join();
+    throw;
+  }
+  reader.join();
+  if (shared.error)
+    std::rethrow_exception(shared.error);
+  return rows;
+}
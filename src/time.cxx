@@ -0,0 +1,464 @@
+/** Implementation of conversions for std::chrono date and time types.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <cstring>
+#include <limits>
+
+#include "pqxx/except"
+#include "pqxx/time"
+
+
+namespace
+{
+constexpr std::int64_t micros_per_second{1'000'000};
+constexpr std::int64_t micros_per_minute{60 * micros_per_second};
+constexpr std::int64_t micros_per_hour{60 * micros_per_minute};
+constexpr std::int64_t micros_per_day{24 * micros_per_hour};
+
+constexpr std::int64_t int64_max{std::numeric_limits<std::int64_t>::max()};
+constexpr std::int64_t int64_min{std::numeric_limits<std::int64_t>::min()};
+
+
+/// Days since 1970-01-01 for a date in the proleptic Gregorian calendar.
+/** This is Howard Hinnant's @c days_from_civil algorithm.  Year zero is
+ * 1 BC.
+ */
+constexpr std::int64_t
+days_from_civil(std::int64_t year, unsigned month, unsigned day) noexcept
+{
+  year -= (month <= 2);
+  auto const era{(year >= 0 ? year : year - 399) / 400};
+  auto const yoe{static_cast<unsigned>(year - era * 400)};
+  auto const mp{month > 2 ? month - 3 : month + 9};
+  auto const doy{(153 * mp + 2) / 5 + day - 1};
+  auto const doe{yoe * 365 + yoe / 4 - yoe / 100 + doy};
+  return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+static_assert(days_from_civil(2000, 1, 1) == pqxx::internal::pg_epoch_days);
+
+
+struct civil_date
+{
+  std::int64_t year;
+  unsigned month, day;
+};
+
+
+/// The date @c days after 1970-01-01: Hinnant's @c civil_from_days.
+constexpr civil_date civil_from_days(std::int64_t days) noexcept
+{
+  days += 719468;
+  auto const era{(days >= 0 ? days : days - 146096) / 146097};
+  auto const doe{static_cast<unsigned>(days - era * 146097)};
+  auto const yoe{(doe - doe / 1460 + doe / 36524 - doe / 146096) / 365};
+  auto const doy{doe - (365 * yoe + yoe / 4 - yoe / 100)};
+  auto const mp{(5 * doy + 2) / 153};
+  auto const day{doy - (153 * mp + 2) / 5 + 1};
+  auto const month{mp < 10 ? mp + 3 : mp - 9};
+  return {static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2), month,
+          day};
+}
+
+
+constexpr unsigned days_in_month(std::int64_t year, unsigned month) noexcept
+{
+  constexpr unsigned char days[]{31, 28, 31, 30, 31, 30,
+                                 31, 31, 30, 31, 30, 31};
+  bool const leap{year % 4 == 0 and (year % 100 != 0 or year % 400 == 0)};
+  return (month == 2 and leap) ? 29u : days[month - 1];
+}
+
+
+/// Minimal cursor for parsing date and time text.
+class scanner
+{
+public:
+  scanner(std::string_view text, char const type[]) noexcept :
+          m_text{text}, m_type{type}
+  {}
+
+  [[nodiscard]] bool done() const noexcept { return m_here == m_text.size(); }
+
+  /// Skip over @c c if it's next.
+  bool skip(char c) noexcept
+  {
+    if (done() or m_text[m_here] != c)
+      return false;
+    ++m_here;
+    return true;
+  }
+
+  /// Skip over @c word if it's next.
+  bool skip(std::string_view word) noexcept
+  {
+    if (m_text.substr(m_here, word.size()) != word)
+      return false;
+    m_here += word.size();
+    return true;
+  }
+
+  void expect(char c)
+  {
+    if (not skip(c))
+      fail();
+  }
+
+  /// Is the next character a digit?
+  [[nodiscard]] bool at_digit() const noexcept
+  {
+    return not done() and m_text[m_here] >= '0' and m_text[m_here] <= '9';
+  }
+
+  /// Read a decimal number of @c min_digits to @c max_digits digits.
+  std::int64_t number(std::size_t min_digits, std::size_t max_digits)
+  {
+    std::int64_t value{0};
+    std::size_t digits{0};
+    for (; digits < max_digits and at_digit(); ++digits)
+      value = value * 10 + (m_text[m_here++] - '0');
+    if (digits < min_digits or at_digit())
+      fail();
+    return value;
+  }
+
+  /// Read a fraction of a second, as microseconds.  Ignores extra digits.
+  std::int64_t fraction()
+  {
+    if (not at_digit())
+      fail();
+    std::int64_t micros{0}, scale{micros_per_second};
+    for (; at_digit(); ++m_here)
+    {
+      scale /= 10;
+      micros += (m_text[m_here] - '0') * scale;
+    }
+    return micros;
+  }
+
+  /// Read "HH:MM[:SS[.ffffff]]" as microseconds, with hours up to @c max.
+  std::int64_t time_of_day(std::size_t hour_digits, std::int64_t max_hours)
+  {
+    auto const hours{number(hour_digits == 2 ? 2 : 1, hour_digits)};
+    expect(':');
+    auto const minutes{number(2, 2)};
+    std::int64_t seconds{0}, micros{0};
+    if (skip(':'))
+    {
+      seconds = number(2, 2);
+      if (skip('.'))
+        micros = fraction();
+    }
+    if (hours > max_hours or minutes > 59 or seconds > 59)
+      fail();
+    if (hour_digits == 2 and hours == 24 and (minutes | seconds | micros) != 0)
+      fail();
+    return hours * micros_per_hour + minutes * micros_per_minute +
+           seconds * micros_per_second + micros;
+  }
+
+  /// Read a "YYYY-MM-DD" date, with an optional " BC" suffix at the end.
+  /** Returns days since the Unix epoch.  The suffix comes at the very end of
+   * the text, so this checks for it there, and strips it off.
+   */
+  std::int64_t date()
+  {
+    constexpr std::string_view bc{" BC"};
+    bool const is_bc{
+      m_text.size() >= bc.size() and
+      m_text.substr(m_text.size() - bc.size()) == bc};
+    if (is_bc)
+      m_text.remove_suffix(bc.size());
+
+    auto year{number(4, 7)};
+    expect('-');
+    auto const month{static_cast<unsigned>(number(2, 2))};
+    expect('-');
+    auto const day{static_cast<unsigned>(number(2, 2))};
+    if (is_bc)
+    {
+      if (year == 0)
+        fail();
+      year = 1 - year;
+    }
+    if (month < 1 or month > 12 or day < 1 or day > days_in_month(year, month))
+      fail();
+    return days_from_civil(year, month, day);
+  }
+
+  [[noreturn]] void fail() const
+  {
+    throw pqxx::conversion_error{
+      "Could not parse " + std::string{m_type} + ": '" + std::string{m_text} +
+      "'."};
+  }
+
+private:
+  std::string_view m_text;
+  std::size_t m_here = 0;
+  char const *const m_type;
+};
+
+
+/// Write @c value as decimal, zero-padded to at least @c width digits.
+char *write_number(char *here, std::uint64_t value, int width) noexcept
+{
+  char digits[20];
+  int len{0};
+  do
+  {
+    digits[len++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  for (; width > len; --width) *here++ = '0';
+  while (len > 0) *here++ = digits[--len];
+  return here;
+}
+
+
+/// Write ".ffffff", without trailing zeroes, unless @c micros is zero.
+char *write_fraction(char *here, std::int64_t micros) noexcept
+{
+  if (micros == 0)
+    return here;
+  *here++ = '.';
+  int digits{6};
+  while (micros % 10 == 0)
+  {
+    micros /= 10;
+    --digits;
+  }
+  return write_number(here, static_cast<std::uint64_t>(micros), digits);
+}
+
+
+/// Write "HH:MM:SS[.ffffff]" for @c micros into the day.
+char *write_time(char *here, std::uint64_t micros) noexcept
+{
+  auto const us{static_cast<std::uint64_t>(micros_per_second)};
+  auto const seconds{micros / us};
+  here = write_number(here, seconds / 3600, 2);
+  *here++ = ':';
+  here = write_number(here, seconds / 60 % 60, 2);
+  *here++ = ':';
+  here = write_number(here, seconds % 60, 2);
+  return write_fraction(here, static_cast<std::int64_t>(micros % us));
+}
+
+
+/// Write "YYYY-MM-DD", plus a " BC" to go at the end, if needed.
+char *write_civil(char *here, std::int64_t days, char const *&suffix) noexcept
+{
+  auto const date{civil_from_days(days)};
+  bool const bc{date.year <= 0};
+  here = write_number(
+    here, static_cast<std::uint64_t>(bc ? 1 - date.year : date.year), 4);
+  *here++ = '-';
+  here = write_number(here, date.month, 2);
+  *here++ = '-';
+  here = write_number(here, date.day, 2);
+  suffix = bc ? " BC" : "";
+  return here;
+}
+
+
+/// Check that a text buffer is big enough for the worst case.
+void check_space(char *begin, char *end, std::size_t need, char const type[])
+{
+  if (end - begin < static_cast<std::ptrdiff_t>(need))
+    throw pqxx::conversion_overrun{
+      "Not enough buffer space to write " + std::string{type} + ".  " +
+      pqxx::internal::state_buffer_overrun(end - begin, need)};
+}
+
+
+/// Copy a zero-terminated @c text to @c here, including the zero.
+char *write_text(char *here, char const text[]) noexcept
+{
+  auto const len{std::strlen(text) + 1};
+  std::memcpy(here, text, len);
+  return here + len;
+}
+
+
+/// Add @c b to @c a, throwing @c range_error on overflow.
+std::int64_t add(std::int64_t a, std::int64_t b)
+{
+  if ((b > 0 and a > int64_max - b) or (b < 0 and a < int64_min - b))
+    throw pqxx::range_error{"Time value out of range."};
+  return a + b;
+}
+
+
+/// Multiply @c a by @c factor, throwing @c range_error on overflow.
+std::int64_t multiply(std::int64_t a, std::int64_t factor)
+{
+  if (a > int64_max / factor or a < int64_min / factor)
+    throw pqxx::range_error{"Time value out of range."};
+  return a * factor;
+}
+} // namespace
+
+
+std::int64_t pqxx::internal::parse_timestamp(std::string_view text)
+{
+  if (text == "infinity")
+    return int64_max;
+  if (text == "-infinity")
+    return int64_min;
+
+  scanner s{text, "timestamp"};
+  auto const days{s.date()};
+  std::int64_t micros{0};
+  if (s.skip(' ') or s.skip('T'))
+  {
+    micros = s.time_of_day(2, 24);
+    bool const negative{s.skip('-')};
+    if (negative or s.skip('+'))
+    {
+      auto offset{s.number(2, 2) * micros_per_hour};
+      s.skip(':');
+      if (s.at_digit())
+      {
+        offset += s.number(2, 2) * micros_per_minute;
+        if (s.skip(':'))
+          offset += s.number(2, 2) * micros_per_second;
+      }
+      micros -= negative ? -offset : offset;
+    }
+    else
+    {
+      s.skip('Z');
+    }
+  }
+  if (not s.done())
+    s.fail();
+  return add(multiply(days, micros_per_day), micros);
+}
+
+
+char *pqxx::internal::write_timestamp(
+  char *begin, char *end, std::int64_t micros)
+{
+  check_space(begin, end, timestamp_buffer, "timestamp");
+  if (micros == int64_max)
+    return write_text(begin, "infinity");
+  if (micros == int64_min)
+    return write_text(begin, "-infinity");
+
+  auto days{micros / micros_per_day};
+  auto time{micros % micros_per_day};
+  if (time < 0)
+  {
+    --days;
+    time += micros_per_day;
+  }
+  char const *suffix;
+  auto here{write_civil(begin, days, suffix)};
+  *here++ = ' ';
+  here = write_time(here, static_cast<std::uint64_t>(time));
+  *here++ = '+';
+  *here++ = '0';
+  *here++ = '0';
+  return write_text(here, suffix);
+}
+
+
+std::int32_t pqxx::internal::parse_date(std::string_view text)
+{
+  scanner s{text, "date"};
+  auto const days{s.date()};
+  if (not s.done())
+    s.fail();
+  return check_cast<std::int32_t>(days, "date");
+}
+
+
+char *pqxx::internal::write_date(char *begin, char *end, std::int32_t days)
+{
+  check_space(begin, end, date_buffer, "date");
+  char const *suffix;
+  auto const here{write_civil(begin, days, suffix)};
+  return write_text(here, suffix);
+}
+
+
+std::int64_t pqxx::internal::parse_interval(std::string_view text)
+{
+  scanner s{text, "interval"};
+  std::int64_t total{0};
+  bool first{true};
+  while (not s.done())
+  {
+    if (not first)
+      s.expect(' ');
+    first = false;
+    bool const negative{s.skip('-')};
+    if (not negative)
+      s.skip('+');
+
+    // Is this a count of some unit, or a time of day?
+    std::int64_t micros;
+    scanner probe{s};
+    probe.number(1, 18);
+    if (probe.skip(':'))
+    {
+      micros = s.time_of_day(18, int64_max / micros_per_hour - 1);
+    }
+    else
+    {
+      auto const count{s.number(1, 18)};
+      s.expect(' ');
+      if (s.skip("days") or s.skip("day"))
+        micros = multiply(count, micros_per_day);
+      else if (
+        s.skip("years") or s.skip("year") or s.skip("mons") or s.skip("mon"))
+        throw conversion_error{
+          "Interval with months or years has no fixed length: '" +
+          std::string{text} + "'."};
+      else
+        s.fail();
+    }
+    total = add(total, negative ? -micros : micros);
+  }
+  if (first)
+    s.fail();
+  return total;
+}
+
+
+char *
+pqxx::internal::write_interval(char *begin, char *end, std::int64_t micros)
+{
+  check_space(begin, end, interval_buffer, "interval");
+  auto here{begin};
+  auto magnitude{static_cast<std::uint64_t>(micros)};
+  if (micros < 0)
+  {
+    *here++ = '-';
+    magnitude = 0u - magnitude;
+  }
+  here = write_time(here, magnitude);
+  *here++ = '\0';
+  return here;
+}
+
+
+std::int64_t pqxx::internal::interval_from_binary(std::string_view data)
+{
+  check_binary_size(data, 16, "interval");
+  auto const micros{from_big_endian<std::int64_t>(data.data())};
+  auto const days{from_big_endian<std::int32_t>(data.data() + 8)};
+  auto const months{from_big_endian<std::int32_t>(data.data() + 12)};
+  if (months != 0)
+    throw conversion_error{
+      "Interval with months or years has no fixed length."};
+  return add(micros, multiply(days, micros_per_day));
+}
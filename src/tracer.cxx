@@ -0,0 +1,22 @@
+/** Implementation of pqxx::tracer.
+ *
+ * pqxx::tracer lets a tracing system see transactions and queries as spans.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include "pqxx/tracer"
+
+
+pqxx::tracer::~tracer() noexcept = default;
+
+
+std::string pqxx::tracer::context(void *)
+{
+  return {};
+}
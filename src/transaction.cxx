@@ -18,12 +18,40 @@
 
 
 pqxx::internal::basic_transaction::basic_transaction(
-  connection &c, char const begin_command[]) :
+  connection &c, char const begin_command[], begin_policy policy) :
         namedclass{"transaction"},
         dbtransaction(c)
 {
   register_transaction();
-  direct_exec(begin_command);
+  if (policy == begin_policy::deferred)
+    defer_begin(begin_command);
+  else
+    direct_exec(begin_command);
+}
+
+
+pqxx::result
+pqxx::internal::basic_transaction::commit_with(std::string_view query)
+{
+  m_commit_query = std::make_shared<std::string>(query);
+  try
+  {
+    commit();
+  }
+  catch (std::exception const &)
+  {
+    // Don't leave the query lying around for a later commit().
+    m_commit_query.reset();
+    throw;
+  }
+  if (m_commit_query)
+  {
+    // The transaction was committed already, so we never got to the query.
+    m_commit_query.reset();
+    throw usage_error{
+      "Attempt to execute query in committed " + description() + "."};
+  }
+  return std::move(m_commit_result);
 }
 
 
@@ -32,7 +60,27 @@ void pqxx::internal::basic_transaction::do_commit()
   static auto const commit{std::make_shared<std::string>("COMMIT")};
   try
   {
-    direct_exec(commit);
+    if (m_commit_query)
+    {
+      m_commit_result = direct_exec_commit(std::move(m_commit_query));
+      if (capturing_commit_lsn())
+        read_commit_lsn();
+    }
+    else if (drop_deferred_begin())
+    {
+      // The transaction never started, so there's nothing to commit.
+    }
+    else if (capturing_commit_lsn())
+    {
+      // Ask for the commit's position in the same round trip.
+      static std::string const commit_and_lsn{
+        std::string{"COMMIT;\n"} + commit_lsn_query};
+      set_commit_lsn(exec_all(commit_and_lsn).back()[0][0].view());
+    }
+    else
+    {
+      direct_exec(commit);
+    }
   }
   catch (statement_completion_unknown const &e)
   {
@@ -78,5 +126,6 @@ void pqxx::internal::basic_transaction::do_commit()
 void pqxx::internal::basic_transaction::do_abort()
 {
   static auto const rollback{std::make_shared<std::string>("ROLLBACK")};
-  direct_exec(rollback);
+  if (not drop_deferred_begin())
+    direct_exec(rollback);
 }
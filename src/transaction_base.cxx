@@ -11,10 +11,15 @@
  */
 #include "pqxx-source.hxx"
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
+#include <limits>
+#include <numeric>
 #include <stdexcept>
 
 #include "pqxx/connection"
+#include "pqxx/replication_stream"
 #include "pqxx/result"
 #include "pqxx/transaction_base"
 
@@ -66,6 +71,59 @@ void pqxx::transaction_base::register_transaction()
 }
 
 
+void pqxx::transaction_base::collect_stats(
+  stats_limits limits, stats_alert alert)
+{
+  m_stats_limits = limits;
+  m_stats_alert = std::move(alert);
+  pqxx::internal::gate::connection_transaction{conn()}.count_stats(true);
+}
+
+
+void pqxx::transaction_base::count_query(query_stats const &query) noexcept
+{
+  ++m_stats.round_trips;
+  m_stats.statements += query.statements;
+  m_stats.bytes_sent += query.bytes_sent;
+  m_stats.bytes_received += query.bytes_received;
+
+  std::size_t runs{0};
+  try
+  {
+    auto here{m_repeats.find(query.query)};
+    if (here == std::end(m_repeats))
+      here = m_repeats.emplace(std::string{query.query}, 0).first;
+    runs = ++here->second;
+  }
+  catch (std::exception const &)
+  {
+    // Out of memory.  Leave this query out of the repeat counts.
+  }
+  m_stats.most_repeats = std::max(m_stats.most_repeats, runs);
+
+  if (not m_stats_alert)
+    return;
+  auto const &limits{m_stats_limits};
+  bool const too_many_trips{
+    limits.round_trips > 0 and m_stats.round_trips == limits.round_trips + 1};
+  bool const too_many_runs{limits.repeats > 0 and runs == limits.repeats + 1};
+  if (too_many_trips or too_many_runs)
+    try
+    {
+      m_stats_alert(*this, m_stats, query.query);
+    }
+    catch (std::exception const &e)
+    {
+      try
+      {
+        process_notice("Stats alert failed: " + std::string{e.what()} + "\n");
+      }
+      catch (std::exception const &)
+      {}
+    }
+}
+
+
 void pqxx::transaction_base::commit()
 {
   check_pending_error();
@@ -198,7 +256,27 @@ pqxx::result
 pqxx::transaction_base::exec(std::string_view query, std::string const &desc)
 {
   check_pending_error();
+  if (m_focus.get() != nullptr or m_status != status::active)
+    throw_cannot_exec(desc);
+
+  // TODO: Pass desc to direct_exec(), and from there on down.
+  return pqxx::internal::gate::connection_transaction{conn()}.exec(query);
+}
 
+
+std::vector<pqxx::result> pqxx::transaction_base::exec_all(
+  std::string_view script, std::string const &desc)
+{
+  check_pending_error();
+  if (m_focus.get() != nullptr or m_status != status::active)
+    throw_cannot_exec(desc);
+  return pqxx::internal::gate::connection_transaction{conn()}.exec_all(
+    script);
+}
+
+
+void pqxx::transaction_base::throw_cannot_exec(std::string const &desc) const
+{
   std::string const n{desc.empty() ? "" : "'" + desc + "' "};
 
   if (m_focus.get() != nullptr)
@@ -207,7 +285,6 @@ pqxx::transaction_base::exec(std::string_view query, std::string const &desc)
                       "with " +
                       m_focus.get()->description() + " still open."};
 
-
   switch (m_status)
   {
   case status::nascent:
@@ -215,8 +292,6 @@ pqxx::transaction_base::exec(std::string_view query, std::string const &desc)
                       ": "
                       "transaction startup failed."};
 
-  case status::active: break;
-
   case status::committed:
   case status::aborted:
   case status::in_doubt:
@@ -224,11 +299,9 @@ pqxx::transaction_base::exec(std::string_view query, std::string const &desc)
                       ": "
                       "transaction is already closed."};
 
+  case status::active: // Should not have got here.
   default: throw internal_error{"pqxx::transaction: invalid status code."};
   }
-
-  // TODO: Pass desc to direct_exec(), and from there on down.
-  return direct_exec(query);
 }
 
 
@@ -248,6 +321,51 @@ pqxx::result pqxx::transaction_base::exec_n(
 }
 
 
+namespace
+{
+/// Lower-case an ASCII letter.  Leaves other bytes alone.
+constexpr char ascii_lower(char c) noexcept
+{
+  return (c >= 'A' and c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+
+/// Does @c text start with @c word, ignoring case, and then end or a space?
+bool starts_with_word(std::string_view text, std::string_view word) noexcept
+{
+  if (std::size(text) < std::size(word))
+    return false;
+  for (std::size_t i{0}; i < std::size(word); ++i)
+    if (ascii_lower(text[i]) != word[i])
+      return false;
+  return std::size(text) == std::size(word) or
+         std::isspace(static_cast<unsigned char>(text[std::size(word)]));
+}
+} // namespace
+
+
+bool pqxx::transaction_base::streams_as_copy(std::string_view query) noexcept
+{
+  auto const start{query.find_first_not_of(" \t\n\r\f\v")};
+  if (start == std::string_view::npos)
+    return false;
+  query.remove_prefix(start);
+  if (
+    not starts_with_word(query, "select") and
+    not starts_with_word(query, "values") and
+    not starts_with_word(query, "table"))
+    return false;
+
+  // A semicolon may mean several statements, which COPY won't take; and
+  // COPY rejects "SELECT ... INTO".  Either may also just be part of a
+  // string, but then the query merely takes the slower path.
+  for (std::size_t i{0}; i < std::size(query); ++i)
+    if (query[i] == ';' or starts_with_word(query.substr(i), "into"))
+      return false;
+  return true;
+}
+
+
 void pqxx::transaction_base::check_rowcount_prepared(
   std::string const &statement, result::size_type expected_rows,
   result::size_type actual_rows)
@@ -277,18 +395,144 @@ void pqxx::transaction_base::check_rowcount_params(
 
 
 pqxx::result pqxx::transaction_base::internal_exec_prepared(
-  zview statement, internal::params const &args)
+  zview statement, internal::params const &args, format result_format)
+{
+  return pqxx::internal::gate::connection_transaction{conn()}.exec_prepared(
+    statement, args, result_format);
+}
+
+
+pqxx::result pqxx::transaction_base::internal_exec_prepared(
+  std::shared_ptr<std::string> const &statement, internal::params const &args,
+  format result_format)
 {
   return pqxx::internal::gate::connection_transaction{conn()}.exec_prepared(
-    statement, args);
+    statement, args, result_format);
+}
+
+
+pqxx::result pqxx::transaction_base::internal_exec_prepared_mixed(
+  zview statement, internal::params const &args)
+{
+  return pqxx::internal::gate::connection_transaction{conn()}
+    .exec_prepared_mixed(statement, args);
+}
+
+
+std::vector<pqxx::result::size_type>
+pqxx::transaction_base::internal_exec_prepared_bulk(
+  zview statement, std::function<bool(internal::params &)> const &next)
+{
+  return pqxx::internal::gate::connection_transaction{conn()}
+    .exec_prepared_bulk(statement, next);
+}
+
+
+namespace
+{
+/// Write a multi-row INSERT statement with @c rows rows of placeholders.
+void build_insert(
+  std::string &query, std::string_view head, std::size_t num_columns,
+  std::size_t rows, std::string_view tail)
+{
+  // Room for the biggest parameter number, and a trailing zero.
+  char num[std::numeric_limits<std::size_t>::digits10 + 2];
+  query.assign(head);
+  std::size_t param{1};
+  for (std::size_t row{0}; row < rows; ++row)
+  {
+    if (row > 0)
+      query.push_back(',');
+    query.push_back('(');
+    for (std::size_t column{0}; column < num_columns; ++column, ++param)
+    {
+      if (column > 0)
+        query.push_back(',');
+      query.push_back('$');
+      auto const end{pqxx::string_traits<std::size_t>::into_buf(
+        num, num + std::size(num), param)};
+      query.append(num, end - 1);
+    }
+    query.push_back(')');
+  }
+  if (not std::empty(tail))
+  {
+    query.push_back(' ');
+    query.append(tail);
+  }
+}
+} // namespace
+
+
+std::size_t pqxx::transaction_base::internal_insert_bulk(
+  std::string_view table, std::string const &columns, std::size_t num_columns,
+  std::string_view tail, bulk_insert_limits const &limits,
+  std::function<bool(internal::params &)> const &next_row)
+{
+  // The protocol has room for no more than this many parameters.
+  constexpr std::size_t protocol_max{65535};
+  if (num_columns == 0)
+    throw usage_error{"insert_bulk() needs at least one column."};
+  auto const max_params{std::min(limits.max_params, protocol_max)};
+  if (num_columns > max_params)
+    throw usage_error{
+      "insert_bulk() got " + to_string(num_columns) +
+      " columns, but statements can have only " + to_string(max_params) +
+      " parameters."};
+  auto const max_rows{max_params / num_columns};
+
+  std::string const head{
+    "INSERT INTO " + std::string{table} + " (" + columns + ") VALUES "};
+  auto const query{std::make_shared<std::string>()};
+  // Number of rows in the current query text.
+  std::size_t query_rows{0};
+  bool done{false};
+
+  auto const counts{
+    pqxx::internal::gate::connection_transaction{conn()}.exec_params_bulk(
+      query, [&](internal::params &args) {
+        args.clear();
+        std::size_t rows{0};
+        while (not done and rows < max_rows and
+               args.value_bytes() < limits.max_bytes)
+        {
+          if (next_row(args))
+          {
+            ++rows;
+            if (args.size() != rows * num_columns)
+              throw usage_error{
+                "insert_bulk() got a row with the wrong number of fields: "
+                "expected " +
+                to_string(num_columns) + "."};
+          }
+          else
+          {
+            done = true;
+          }
+        }
+        if (rows == 0)
+          return false;
+        if (rows != query_rows)
+        {
+          build_insert(*query, head, num_columns, rows, tail);
+          query_rows = rows;
+        }
+        return true;
+      })};
+  return std::accumulate(
+    std::begin(counts), std::end(counts), std::size_t{0},
+    [](std::size_t total, result::size_type count) {
+      return total + static_cast<std::size_t>(count);
+    });
 }
 
 
 pqxx::result pqxx::transaction_base::internal_exec_params(
-  std::string const &query, internal::params const &args)
+  std::string const &query, internal::params const &args,
+  format result_format)
 {
   return pqxx::internal::gate::connection_transaction{conn()}.exec_params(
-    query, args);
+    query, args, result_format);
 }
 
 
@@ -318,28 +562,31 @@ void pqxx::transaction_base::close() noexcept
       m_conn.process_notice(e.what());
     }
 
-    if (m_registered)
+    if (m_status == status::active)
     {
-      m_registered = false;
-      pqxx::internal::gate::connection_transaction{conn()}
-        .unregister_transaction(this);
-    }
-
-    if (m_status != status::active)
-      return;
+      if (m_focus.get() != nullptr)
+        m_conn.process_notice(
+          "Closing " + description() + "  with " +
+          m_focus.get()->description() + " still open.\n");
 
-    if (m_focus.get() != nullptr)
-      m_conn.process_notice(
-        "Closing " + description() + "  with " + m_focus.get()->description() +
-        " still open.\n");
-
-    try
-    {
-      abort();
+      // Abort while still registered, so the rollback is part of the
+      // transaction.  This comes back here to unregister.
+      try
+      {
+        abort();
+      }
+      catch (std::exception const &e)
+      {
+        m_conn.process_notice(e.what());
+      }
     }
-    catch (std::exception const &e)
+
+    if (m_registered)
     {
-      m_conn.process_notice(e.what());
+      m_registered = false;
+      pqxx::internal::gate::connection_transaction gate{conn()};
+      gate.end_trace_span(m_status == status::committed);
+      gate.unregister_transaction(this);
     }
   }
   catch (std::exception const &e)
@@ -389,6 +636,54 @@ pqxx::transaction_base::direct_exec(std::shared_ptr<std::string> c)
 }
 
 
+void pqxx::transaction_base::defer_begin(char const command[]) noexcept
+{
+  pqxx::internal::gate::connection_transaction{conn()}.defer_begin(command);
+}
+
+
+bool pqxx::transaction_base::drop_deferred_begin() noexcept
+{
+  return pqxx::internal::gate::connection_transaction{conn()}
+    .drop_deferred_begin();
+}
+
+
+void pqxx::transaction_base::defer_savepoint(std::string command)
+{
+  pqxx::internal::gate::connection_transaction{conn()}.defer_savepoint(
+    std::move(command));
+}
+
+
+bool pqxx::transaction_base::drop_deferred_savepoint(
+  std::string_view command) noexcept
+{
+  return pqxx::internal::gate::connection_transaction{conn()}
+    .drop_deferred_savepoint(command);
+}
+
+
+pqxx::result
+pqxx::transaction_base::direct_exec_commit(std::shared_ptr<std::string> c)
+{
+  check_pending_error();
+  return pqxx::internal::gate::connection_transaction{conn()}.exec_commit(c);
+}
+
+
+void pqxx::transaction_base::set_commit_lsn(std::string_view text)
+{
+  m_commit_lsn = parse_lsn(text);
+}
+
+
+void pqxx::transaction_base::read_commit_lsn()
+{
+  set_commit_lsn(direct_exec(commit_lsn_query)[0][0].view());
+}
+
+
 void pqxx::transaction_base::register_pending_error(
   std::string const &err) noexcept
 {
@@ -0,0 +1,60 @@
+/** Implementation of the retry logic in pqxx::perform.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+#include "pqxx/transactor"
+
+
+namespace
+{
+/// Nominal pause before retrying after the given attempt.
+std::chrono::milliseconds
+backoff(pqxx::retry_policy const &policy, int attempt) noexcept
+{
+  auto delay{policy.base_delay};
+  for (int i{1}; i < attempt and delay < policy.max_delay; ++i) delay *= 2;
+  return std::min(delay, policy.max_delay);
+}
+
+
+/// Random pause between zero and the given delay.
+std::chrono::milliseconds jitter(std::chrono::milliseconds delay)
+{
+  thread_local std::minstd_rand engine{std::random_device{}()};
+  std::uniform_int_distribution<std::chrono::milliseconds::rep> pick{
+    0, delay.count()};
+  return std::chrono::milliseconds{pick(engine)};
+}
+} // namespace
+
+
+void pqxx::internal::wait_to_retry(
+  retry_policy const &policy, int attempt,
+  std::chrono::steady_clock::time_point start, std::exception const &cause)
+{
+  if (attempt >= policy.attempts)
+    throw;
+
+  auto delay{backoff(policy, attempt)};
+  if (policy.jitter and delay.count() > 0)
+    delay = jitter(delay);
+
+  auto const elapsed{std::chrono::steady_clock::now() - start};
+  if (policy.budget.count() > 0 and elapsed + delay > policy.budget)
+    throw;
+
+  if (policy.on_retry)
+    policy.on_retry(retry_event{attempt, cause, elapsed, delay});
+  if (delay.count() > 0)
+    std::this_thread::sleep_for(delay);
+}
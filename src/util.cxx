@@ -14,12 +14,17 @@
 #include <cstring>
 #include <new>
 
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 extern "C"
 {
 #include <libpq-fe.h>
 }
 
 #include "pqxx/except"
+#include "pqxx/strconv"
 #include "pqxx/util"
 
 
@@ -89,3 +94,166 @@ void pqxx::internal::check_unique_unregistration(
                       old_ptr->description()};
   }
 }
+
+
+namespace
+{
+constexpr char hex_digits[]{"0123456789abcdef"};
+
+
+/// Value of a hex digit, or -1 if @c c is not a hex digit.
+constexpr int nibble(char c) noexcept
+{
+  if (c >= '0' and c <= '9')
+    return c - '0';
+  else if (c >= 'a' and c <= 'f')
+    return c - 'a' + 10;
+  else if (c >= 'A' and c <= 'F')
+    return c - 'A' + 10;
+  else
+    return -1;
+}
+
+
+[[noreturn]] void throw_bad_hex(std::string_view escaped, std::size_t at)
+{
+  throw pqxx::argument_error{
+    "Invalid hex-escaped binary data at byte " + pqxx::to_string(at) + " of " +
+    pqxx::to_string(escaped.size()) + "."};
+}
+
+
+#if defined(__SSE2__)
+/// Turn 16 nibble values (0-15) into their lower-case hex digits.
+inline __m128i hex_chars(__m128i nibbles) noexcept
+{
+  // '0' + n, plus another 'a' - '0' - 10 if n > 9.
+  __m128i const letter{_mm_and_si128(
+    _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10))};
+  return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letter);
+}
+
+
+/// Decode 16 hex digits into 8 bytes, in the low halves of 16-bit lanes.
+/** Returns false if any of the characters is not a hex digit.
+ */
+inline bool hex_values(__m128i chars, __m128i &values) noexcept
+{
+  // Bytes of 0x80 and up count as negative, so they fail both range checks.
+  __m128i const digit{_mm_and_si128(
+    _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+    _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)))};
+  __m128i const lower{_mm_or_si128(chars, _mm_set1_epi8(0x20))};
+  __m128i const letter{_mm_and_si128(
+    _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+    _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)))};
+  if (_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xffff)
+    return false;
+
+  __m128i const nibbles{_mm_or_si128(
+    _mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+    _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))))};
+
+  // Each 16-bit lane holds a high nibble, then a low nibble.
+  __m128i const high{_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff))};
+  __m128i const low{_mm_srli_epi16(nibbles, 8)};
+  values = _mm_or_si128(_mm_slli_epi16(high, 4), low);
+  return true;
+}
+#endif
+} // namespace
+
+
+void pqxx::esc_bin(std::string_view binary_data, char buffer[]) noexcept
+{
+  auto const size{binary_data.size()};
+  auto const data{binary_data.data()};
+  auto here{buffer};
+  *here++ = '\\';
+  *here++ = 'x';
+
+  std::size_t i{0};
+#if defined(__SSE2__)
+  for (; i + 16 <= size; i += 16)
+  {
+    __m128i const bytes{
+      _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i))};
+    __m128i const mask{_mm_set1_epi8(0x0f)};
+    __m128i const high{
+      hex_chars(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask))};
+    __m128i const low{hex_chars(_mm_and_si128(bytes, mask))};
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i *>(here), _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i *>(here + 16), _mm_unpackhi_epi8(high, low));
+    here += 32;
+  }
+#endif
+  for (; i < size; ++i)
+  {
+    auto const byte{static_cast<unsigned char>(data[i])};
+    *here++ = hex_digits[byte >> 4];
+    *here++ = hex_digits[byte & 0x0f];
+  }
+  *here = '\0';
+}
+
+
+std::string pqxx::esc_bin(std::string_view binary_data)
+{
+  std::string buf;
+  buf.resize(size_esc_bin(binary_data.size()));
+  esc_bin(binary_data, buf.data());
+  // Strip off the terminating zero.
+  buf.resize(buf.size() - 1);
+  return buf;
+}
+
+
+void pqxx::unesc_bin(std::string_view escaped_data, std::byte buffer[])
+{
+  auto const size{escaped_data.size()};
+  auto const data{escaped_data.data()};
+  if (size < 2 or data[0] != '\\' or data[1] != 'x')
+    throw argument_error{
+      "Escaped binary data is not in hex format.  (Is the server's "
+      "bytea_output set to 'escape'?)"};
+  if (size % 2 != 0)
+    throw argument_error{"Hex-escaped binary data has an odd length."};
+
+  auto here{buffer};
+  std::size_t i{2};
+#if defined(__SSE2__)
+  for (; i + 32 <= size; i += 32)
+  {
+    __m128i first, second;
+    if (not hex_values(
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i)),
+          first) or
+        not hex_values(
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i + 16)),
+          second))
+      break;
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i *>(here), _mm_packus_epi16(first, second));
+    here += 16;
+  }
+#endif
+  for (; i < size; i += 2)
+  {
+    auto const high{nibble(data[i])}, low{nibble(data[i + 1])};
+    if (high < 0)
+      throw_bad_hex(escaped_data, i);
+    if (low < 0)
+      throw_bad_hex(escaped_data, i + 1);
+    *here++ = static_cast<std::byte>((high << 4) | low);
+  }
+}
+
+
+std::vector<std::byte> pqxx::unesc_bin(std::string_view escaped_data)
+{
+  std::vector<std::byte> buf(size_unesc_bin(escaped_data.size()));
+  unesc_bin(escaped_data, buf.data());
+  return buf;
+}
@@ -0,0 +1,88 @@
+/** Implementation of the pqxx::uuid conversions.
+ *
+ * Copyright (c) 2000-2020, Jeroen T. Vermeulen.
+ *
+ * See COPYING for copyright license.  If you did not receive a file called
+ * COPYING with this source code, please notify the distributor of this
+ * mistake, or contact the author.
+ */
+#include "pqxx-source.hxx"
+
+#include "pqxx/except"
+#include "pqxx/uuid"
+
+
+namespace
+{
+/// Value of hexadecimal digit @c c, or -1 if it isn't one.
+constexpr int hex_value(char c) noexcept
+{
+  if (c >= '0' and c <= '9')
+    return c - '0';
+  else if (c >= 'a' and c <= 'f')
+    return c - 'a' + 10;
+  else if (c >= 'A' and c <= 'F')
+    return c - 'A' + 10;
+  else
+    return -1;
+}
+
+
+[[noreturn]] void bad_uuid(std::string_view text)
+{
+  throw pqxx::conversion_error{
+    "Could not parse uuid: '" + std::string{text} + "'."};
+}
+} // namespace
+
+
+pqxx::uuid pqxx::string_traits<pqxx::uuid>::from_string(std::string_view text)
+{
+  auto inner{text};
+  if (not inner.empty() and inner.front() == '{')
+  {
+    if (inner.back() != '}')
+      bad_uuid(text);
+    inner = inner.substr(1, inner.size() - 2);
+  }
+
+  uuid value;
+  std::size_t here{0};
+  for (std::size_t i{0}; i < std::size(value.bytes); ++i)
+  {
+    // PostgreSQL allows a hyphen after any group of four digits.
+    if (i > 0 and i % 2 == 0 and here < inner.size() and inner[here] == '-')
+      ++here;
+    if (here + 2 > inner.size())
+      bad_uuid(text);
+    auto const high{hex_value(inner[here])}, low{hex_value(inner[here + 1])};
+    if (high < 0 or low < 0)
+      bad_uuid(text);
+    value.bytes[i] = static_cast<std::uint8_t>((high << 4) | low);
+    here += 2;
+  }
+  if (here != inner.size())
+    bad_uuid(text);
+  return value;
+}
+
+
+char *pqxx::string_traits<pqxx::uuid>::into_buf(
+  char *begin, char *end, uuid const &value)
+{
+  if (end - begin < 37)
+    throw conversion_overrun{
+      "Not enough buffer space to write uuid.  " +
+      internal::state_buffer_overrun(end - begin, 37)};
+  constexpr char digits[]{"0123456789abcdef"};
+  char *here{begin};
+  for (std::size_t i{0}; i < std::size(value.bytes); ++i)
+  {
+    if (i == 4 or i == 6 or i == 8 or i == 10)
+      *here++ = '-';
+    *here++ = digits[value.bytes[i] >> 4];
+    *here++ = digits[value.bytes[i] & 0xf];
+  }
+  *here++ = '\0';
+  return here;
+}
@@ -269,6 +269,28 @@ inline void check_bounds(
 }
 
 
+// Number of heap allocations this thread has made so far.
+/** Counts calls to the global @c operator new, which the test runners
+ * replace.  Use @c PQXX_CHECK_ALLOCATIONS to hold a hot path to a budget.
+ */
+std::size_t allocations() noexcept;
+
+
+// Verify that an action makes no more than "budget" heap allocations.
+#define PQXX_CHECK_ALLOCATIONS(action, budget, desc)                          \
+  {                                                                           \
+    auto const pqxx_allocations_before_{pqxx::test::allocations()};           \
+    action;                                                                   \
+    auto const pqxx_allocations_made_{                                        \
+      pqxx::test::allocations() - pqxx_allocations_before_};                  \
+    pqxx::test::check_less_equal(                                             \
+      __FILE__, __LINE__, pqxx_allocations_made_,                             \
+      "allocations in \"" #action "\"", std::size_t(budget), #budget,         \
+      (desc));                                                                \
+  }                                                                           \
+  pqxx::test::internal::end_of_statement()
+
+
 // Report expected exception
 void expected_exception(std::string const &);
 
@@ -1,6 +1,7 @@
 /* main() definition for libpqxx test runners.
  */
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
 #include <list>
 #include <new>
@@ -8,6 +9,44 @@
 
 #include "test_helpers.hxx"
 
+namespace
+{
+/// Heap allocations made by the current thread.
+thread_local std::size_t allocation_count{0};
+} // namespace
+
+
+// Replace the global allocation functions, so tests can count allocations.
+// The other forms of operator new and operator delete call these ones.
+void *operator new(std::size_t size)
+{
+  ++allocation_count;
+  if (size == 0)
+    size = 1;
+  for (;;)
+  {
+    if (void *const ptr{std::malloc(size)}; ptr != nullptr)
+      return ptr;
+    auto const handler{std::get_new_handler()};
+    if (handler == nullptr)
+      throw std::bad_alloc{};
+    handler();
+  }
+}
+
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+
 namespace
 {
 inline std::string deref_field(pqxx::field const &f)
@@ -53,6 +92,12 @@ void check(
 }
 
 
+std::size_t allocations() noexcept
+{
+  return allocation_count;
+}
+
+
 void expected_exception(std::string const &message)
 {
   std::cout << "(Expected) " << message << std::endl;
@@ -0,0 +1,232 @@
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include <pqxx/nontransaction>
+#include <pqxx/separated_list>
+#include <pqxx/stream_from>
+#include <pqxx/stream_to>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+// These tests hold hot paths to an allocation budget, so that work to avoid
+// heap allocations per row or per field can't silently regress.
+
+namespace
+{
+void test_allocation_counting()
+{
+  PQXX_CHECK_ALLOCATIONS(
+    auto const *p{new int{9}}; delete p, 1u, "Counted a 'new' twice.");
+  PQXX_CHECK_THROWS(
+    PQXX_CHECK_ALLOCATIONS(std::string(100, 'x'), 0u, "Expected failure."),
+    pqxx::test::test_failure, "Allocation budget was not enforced.");
+}
+
+
+void test_conversion_allocations()
+{
+  std::array<char, 100> buf;
+  PQXX_CHECK_ALLOCATIONS(
+    pqxx::string_traits<int>::into_buf(
+      std::begin(buf), std::end(buf), 123456),
+    0u, "into_buf() allocated.");
+  PQXX_CHECK_ALLOCATIONS(
+    pqxx::string_traits<long long>::into_buf(
+      std::begin(buf), std::end(buf), -9876543210LL),
+    0u, "into_buf() allocated.");
+  PQXX_CHECK_ALLOCATIONS(
+    pqxx::string_traits<int>::to_buf(std::begin(buf), std::end(buf), 1),
+    0u, "to_buf() allocated.");
+
+  int i{0};
+  long l{0};
+  bool b{false};
+  PQXX_CHECK_ALLOCATIONS(
+    i = pqxx::from_string<int>("-4321"), 0u, "from_string<int>() allocated.");
+  PQXX_CHECK_ALLOCATIONS(
+    l = pqxx::from_string<long>("1234567890"), 0u,
+    "from_string<long>() allocated.");
+  PQXX_CHECK_ALLOCATIONS(
+    b = pqxx::from_string<bool>("true"), 0u, "from_string<bool>() allocated.");
+  PQXX_CHECK_EQUAL(i, -4321, "Bad int parse.");
+  PQXX_CHECK_EQUAL(l, 1234567890L, "Bad long parse.");
+  PQXX_CHECK(b, "Bad bool parse.");
+
+  // Re-using a string for conversions does not allocate once it is big.
+  std::string out;
+  pqxx::into_string(1L, out);
+  PQXX_CHECK_ALLOCATIONS(
+    pqxx::into_string(-1234567890123L, out), 0u,
+    "into_string() allocated despite having capacity.");
+}
+
+
+void test_field_allocations()
+{
+  pqxx::connection conn;
+  pqxx::nontransaction tx{conn};
+  auto const r{
+    tx.exec("SELECT n, 'text ' || n, NULL FROM generate_series(1, 100) AS n")};
+
+  int total{0};
+  PQXX_CHECK_ALLOCATIONS(
+    for (auto const &row : r) total += row[0].as<int>(), 0u,
+    "Reading int fields allocated.");
+  PQXX_CHECK_EQUAL(total, 5050, "Wrong total.");
+
+  std::size_t bytes{0};
+  PQXX_CHECK_ALLOCATIONS(
+    for (auto const &row : r) bytes += row[1].view().size() + row[1].size(),
+    0u, "Viewing text fields allocated.");
+  PQXX_CHECK_ALLOCATIONS(
+    for (auto const &row : r) bytes += row[2].is_null(), 0u,
+    "Checking for nulls allocated.");
+  PQXX_CHECK_ALLOCATIONS(
+    for (auto const &row : r) bytes += row[2].get<int>().has_value(), 0u,
+    "Reading a null field allocated.");
+  PQXX_CHECK_ALLOCATIONS(
+    bytes += r[7]["?column?"].size(), 0u, "Looking up a column allocated.");
+}
+
+
+void test_exec_allocations()
+{
+  pqxx::connection conn;
+  pqxx::nontransaction tx{conn};
+  auto r{tx.exec("SELECT 1")};
+  // One for the query text the result keeps, and one for the result itself.
+  PQXX_CHECK_ALLOCATIONS(
+    r = tx.exec("SELECT 2"), 2u, "Too many allocations for a short exec().");
+  PQXX_CHECK_EQUAL(r[0][0].as<int>(), 2, "Wrong result.");
+}
+
+
+void test_stream_to_allocations()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE alloc_to (n integer, word text)");
+  pqxx::stream_to stream{tx, "alloc_to"};
+  // Small buffer, so the measured rows will include some flushes.
+  stream.set_buffer_size(1024);
+
+  // Warm up: let the buffer grow to its full size.
+  for (int n{0}; n < 1000; ++n) stream << std::make_tuple(n, "word");
+  PQXX_CHECK_ALLOCATIONS(
+    for (int n{0}; n < 1000; ++n) stream << std::make_tuple(n, "word"), 0u,
+    "stream_to::operator<<() allocated.");
+  stream.complete();
+}
+
+
+void test_stream_from_allocations()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT n, n * 2 FROM generate_series(1, 1000) AS n")};
+  std::tuple<int, long> row;
+  stream >> row;
+
+  long total{0};
+  PQXX_CHECK_ALLOCATIONS(
+    while (stream >> row) total += std::get<1>(row), 0u,
+    "stream_from::operator>>() allocated.");
+  stream.complete();
+  PQXX_CHECK_EQUAL(total, 1000L * 1001L - 2, "Wrong total.");
+}
+
+
+void test_stream_from_escape_allocations()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  // Every row has a field that needs unescaping.
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT n, repeat(E'x\\t', 50) FROM generate_series(1, 1000) AS n")};
+  std::tuple<int, std::string> row;
+  stream >> row;
+
+  std::size_t total{0};
+  PQXX_CHECK_ALLOCATIONS(
+    while (stream >> row) total += std::size(std::get<1>(row)), 0u,
+    "Unescaping in stream_from allocated.");
+  stream.complete();
+  PQXX_CHECK_EQUAL(total, 99'900u, "Wrong total.");
+}
+
+
+void test_stream_iteration_allocations()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT n, repeat('x', 100) FROM generate_series(1, 1000) AS n")};
+  auto rows{stream.iter<int, std::string>()};
+  auto i{std::begin(rows)};
+  auto const end{std::end(rows)};
+
+  // The first row gives the string its storage; the rest re-use it.
+  std::size_t total{std::size(std::get<1>(*i))};
+  PQXX_CHECK_ALLOCATIONS(
+    for (++i; i != end; ++i) total += std::size(std::get<1>(*i)), 0u,
+    "Stream iteration allocated.");
+  PQXX_CHECK_EQUAL(total, 100'000u, "Wrong total.");
+}
+
+
+#if defined(PQXX_HAVE_PMR)
+void test_memory_resource_allocations()
+{
+  // An arena that can't fall back on the heap.
+  std::array<std::byte, 8192> space;
+  std::pmr::monotonic_buffer_resource arena{
+    std::data(space), std::size(space), std::pmr::null_memory_resource()};
+
+  std::pmr::string text{&arena};
+  PQXX_CHECK_ALLOCATIONS(
+    text = pqxx::to_string(-1234567890123L, &arena), 0u,
+    "to_string() with a memory resource allocated.");
+  PQXX_CHECK_EQUAL(text, "-1234567890123", "Bad to_string().");
+
+  std::vector<int> const nums{1, 22, 333, 4444, 55555, 666666, 7777777};
+  PQXX_CHECK_ALLOCATIONS(
+    text = pqxx::separated_list(&arena, ", ", nums), 0u,
+    "separated_list() with a memory resource allocated.");
+  PQXX_CHECK_EQUAL(
+    text, "1, 22, 333, 4444, 55555, 666666, 7777777",
+    "Bad separated_list().");
+
+  pqxx::connection conn;
+  pqxx::nontransaction tx{conn};
+  tx.set_memory_resource(&arena);
+  PQXX_CHECK(tx.memory_resource() == &arena, "Memory resource did not stick.");
+
+  // More parameter text than a params object has room for inline.
+  std::string const big(1000, 'x');
+  auto const r{tx.exec_params("SELECT $1 || $2", big, big)};
+  std::pmr::string field{&arena};
+  PQXX_CHECK(r[0][0].to(field), "Field came out null.");
+  PQXX_CHECK_EQUAL(std::size(field), 2000u, "Wrong field size.");
+  PQXX_CHECK(
+    field.get_allocator().resource() == &arena,
+    "Reading a field lost the string's memory resource.");
+  tx.set_memory_resource(nullptr);
+}
+#endif
+
+
+PQXX_REGISTER_TEST(test_allocation_counting);
+PQXX_REGISTER_TEST(test_conversion_allocations);
+PQXX_REGISTER_TEST(test_field_allocations);
+PQXX_REGISTER_TEST(test_exec_allocations);
+PQXX_REGISTER_TEST(test_stream_to_allocations);
+PQXX_REGISTER_TEST(test_stream_from_allocations);
+PQXX_REGISTER_TEST(test_stream_from_escape_allocations);
+PQXX_REGISTER_TEST(test_stream_iteration_allocations);
+#if defined(PQXX_HAVE_PMR)
+PQXX_REGISTER_TEST(test_memory_resource_allocations);
+#endif
+} // namespace
@@ -395,6 +395,94 @@ void test_nested_array_with_multiple_entries()
 }
 
 
+void test_multibyte_encodings()
+{
+  using pqxx::internal::encoding_group;
+  using junc = pqxx::array_parser::juncture;
+
+  // In SJIS, the second byte of this character looks like a backslash.
+  std::string const sjis{"{\"\x95\x5c\",x}"};
+  pqxx::array_parser sjis_parser{sjis, encoding_group::SJIS};
+  PQXX_CHECK_EQUAL(
+    sjis_parser.get_next().first, junc::row_start, "Bad SJIS array start.");
+  auto const sjis_value{sjis_parser.get_next()};
+  PQXX_CHECK_EQUAL(
+    sjis_value.first, junc::string_value, "Bad SJIS string value.");
+  PQXX_CHECK_EQUAL(
+    sjis_value.second, "\x95\x5c", "SJIS character got mangled.");
+  PQXX_CHECK_EQUAL(
+    sjis_parser.get_next().second, "x", "Lost track after SJIS value.");
+
+  pqxx::array_parser utf8_parser{
+    "{\"caf\xc3\xa9\",NULL}", encoding_group::UTF8};
+  PQXX_CHECK_EQUAL(
+    utf8_parser.get_next().first, junc::row_start, "Bad UTF-8 array start.");
+  PQXX_CHECK_EQUAL(
+    utf8_parser.get_next().second, "caf\xc3\xa9", "Bad UTF-8 value.");
+  PQXX_CHECK_EQUAL(
+    utf8_parser.get_next().first, junc::null_value, "Bad UTF-8 null.");
+}
+
+
+void test_array_views()
+{
+  using junc = pqxx::array_parser::juncture;
+  std::string const input{"{123,\"a\\\"b\",NULL,x}"};
+  pqxx::array_parser parser{input};
+  PQXX_CHECK_EQUAL(
+    parser.get_next_view().first, junc::row_start, "Bad array start.");
+
+  auto const unquoted{parser.get_next_view()};
+  PQXX_CHECK(unquoted.second == "123", "Bad unquoted value.");
+  PQXX_CHECK(
+    unquoted.second.data() == input.data() + 1,
+    "Unquoted value was copied, not viewed in place.");
+
+  auto const quoted{parser.get_next_view()};
+  PQXX_CHECK_EQUAL(quoted.first, junc::string_value, "Bad quoted juncture.");
+  PQXX_CHECK(quoted.second == "a\"b", "Quoted value was not unescaped.");
+
+  auto const null{parser.get_next_view()};
+  PQXX_CHECK_EQUAL(null.first, junc::null_value, "Null went missing.");
+  PQXX_CHECK(null.second.empty(), "Null has a value.");
+
+  PQXX_CHECK(parser.get_next_view().second == "x", "Lost track of values.");
+  PQXX_CHECK_EQUAL(
+    parser.get_next_view().first, junc::row_end, "Bad array end.");
+  PQXX_CHECK_EQUAL(
+    parser.get_next_view().first, junc::done, "Array did not end.");
+}
+
+
+void test_parse_array_elements()
+{
+  pqxx::array_parser parser{"{{1,2},{},{NULL,4}}"};
+  PQXX_CHECK_EQUAL(
+    parser.get_next_view().first, pqxx::array_parser::juncture::row_start,
+    "Bad array start.");
+  std::vector<std::vector<std::optional<int>>> out;
+  pqxx::internal::parse_array_elements(parser, out);
+  PQXX_CHECK_EQUAL(std::size(out), 3u, "Wrong number of nested arrays.");
+  PQXX_CHECK_EQUAL(std::size(out[0]), 2u, "Wrong size for first array.");
+  PQXX_CHECK_EQUAL(*out[0][1], 2, "Wrong value in nested array.");
+  PQXX_CHECK(out[1].empty(), "Empty nested array has values.");
+  PQXX_CHECK(not out[2][0].has_value(), "Null came out as a value.");
+
+  pqxx::array_parser nulls{"{1,NULL}"};
+  pqxx::ignore_unused(nulls.get_next_view());
+  std::vector<int> ints;
+  PQXX_CHECK_THROWS(
+    pqxx::internal::parse_array_elements(nulls, ints),
+    pqxx::conversion_error, "Null went into a non-nullable element.");
+
+  pqxx::array_parser nested{"{{1}}"};
+  pqxx::ignore_unused(nested.get_next_view());
+  PQXX_CHECK_THROWS(
+    pqxx::internal::parse_array_elements(nested, ints),
+    pqxx::conversion_error, "Nested array went into a flat container.");
+}
+
+
 void test_array_parse()
 {
   test_empty_arrays();
@@ -407,6 +495,9 @@ void test_array_parse()
   test_multiple_values();
   test_nested_array();
   test_nested_array_with_multiple_entries();
+  test_multibyte_encodings();
+  test_array_views();
+  test_parse_array_elements();
 }
 
 
@@ -517,7 +608,44 @@ void test_array_roundtrip()
 }
 
 
+void test_parse_array()
+{
+  pqxx::connection c;
+  pqxx::work w{c};
+  auto const r{w.exec1(
+    "SELECT ARRAY[1, 33, -40000000000]::int8[], "
+    "ARRAY['plain', 'with space', 'with \"quote', NULL]::text[], "
+    "ARRAY[[1, 2], [3, 4]]")};
+
+  auto const ints{pqxx::parse_array<std::vector<long long>>(r[0])};
+  PQXX_CHECK_EQUAL(std::size(ints), 3u, "Wrong number of int8 elements.");
+  PQXX_CHECK_EQUAL(ints[2], -40000000000LL, "Wrong int8 element.");
+  PQXX_CHECK(
+    r[0].as<std::vector<long long>>() == ints,
+    "as<std::vector>() disagrees with parse_array().");
+
+  auto const texts{
+    pqxx::parse_array<std::vector<std::optional<std::string>>>(r[1])};
+  PQXX_CHECK_EQUAL(std::size(texts), 4u, "Wrong number of text elements.");
+  PQXX_CHECK_EQUAL(*texts[1], "with space", "Wrong text element.");
+  PQXX_CHECK_EQUAL(*texts[2], "with \"quote", "Bad unescaping.");
+  PQXX_CHECK(not texts[3].has_value(), "Null text element has a value.");
+
+  auto const matrix{pqxx::parse_array<std::vector<std::vector<int>>>(r[2])};
+  PQXX_CHECK_EQUAL(matrix[1][0], 3, "Wrong element in 2-D array.");
+
+  auto const nothing{w.exec1("SELECT NULL::integer[], 'x'::text")};
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::parse_array<std::vector<int>>(nothing[0])),
+    pqxx::conversion_error, "Null array did not throw.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::parse_array<std::vector<int>>(nothing[1])),
+    pqxx::conversion_error, "Non-array parsed as array.");
+}
+
+
 PQXX_REGISTER_TEST(test_array_parse);
 PQXX_REGISTER_TEST(test_array_generate);
 PQXX_REGISTER_TEST(test_array_roundtrip);
+PQXX_REGISTER_TEST(test_parse_array);
 } // namespace
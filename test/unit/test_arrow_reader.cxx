@@ -0,0 +1,160 @@
+#include <cstdint>
+#include <cstring>
+
+#include <pqxx/arrow_reader>
+#include <pqxx/stream_from>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+/// Is row @c i of an Arrow array non-null, according to its validity bitmap?
+bool is_valid(ArrowArray const &array, std::size_t i)
+{
+  auto const bits{static_cast<std::uint8_t const *>(array.buffers[0])};
+  return (bits[i / 8] >> (i % 8)) & 1u;
+}
+
+
+/// Read value @c i from a fixed-width Arrow array.
+template<typename T> T value_at(ArrowArray const &array, std::size_t i)
+{
+  T value;
+  std::memcpy(
+    &value, static_cast<char const *>(array.buffers[1]) + i * sizeof(T),
+    sizeof(T));
+  return value;
+}
+
+
+/// Read string @c i from a utf8 or binary Arrow array.
+std::string string_at(ArrowArray const &array, std::size_t i)
+{
+  auto const offsets{static_cast<std::int32_t const *>(array.buffers[1])};
+  auto const values{static_cast<char const *>(array.buffers[2])};
+  auto const size{static_cast<std::size_t>(offsets[i + 1] - offsets[i])};
+  return std::string(values + offsets[i], size);
+}
+
+
+void test_arrow_reader_schema()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT 1::bigint, 'x'::text", pqxx::format::binary)};
+  pqxx::arrow_reader reader{
+    stream, {{"n", pqxx::arrow_type::int64}, {"s", pqxx::arrow_type::utf8}}};
+
+  ArrowSchema schema;
+  reader.export_schema(&schema);
+  PQXX_CHECK_EQUAL(std::string{schema.format}, "+s", "Bad top-level format.");
+  PQXX_CHECK_EQUAL(schema.n_children, 2, "Wrong number of schema children.");
+  PQXX_CHECK_EQUAL(
+    std::string{schema.children[0]->format}, "l", "Bad int64 format.");
+  PQXX_CHECK_EQUAL(
+    std::string{schema.children[1]->name}, "s", "Bad column name.");
+  PQXX_CHECK(
+    schema.children[1]->flags & ARROW_FLAG_NULLABLE, "Column not nullable.");
+  schema.release(&schema);
+  PQXX_CHECK(schema.release == nullptr, "Schema release did not mark it.");
+  stream.complete();
+
+  auto text{pqxx::stream_from::query(tx, "SELECT 1")};
+  PQXX_CHECK_THROWS(
+    pqxx::arrow_reader(text, {{"n", pqxx::arrow_type::int32}}),
+    pqxx::usage_error, "Arrow reader accepted a text stream.");
+  text.complete();
+}
+
+
+void test_arrow_reader_batches()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx,
+    "SELECT n::bigint, "
+    "CASE WHEN n % 3 = 0 THEN NULL ELSE 'v' || n END, "
+    "n % 2 = 0, "
+    "n::float8 / 2, "
+    "DATE '1970-01-01' + n, "
+    "TIMESTAMP '1970-01-01' + n * INTERVAL '1 second' "
+    "FROM generate_series(1, 10) AS n",
+    pqxx::format::binary)};
+  pqxx::arrow_reader reader{
+    stream,
+    {{"n", pqxx::arrow_type::int64},
+     {"s", pqxx::arrow_type::utf8},
+     {"even", pqxx::arrow_type::boolean},
+     {"half", pqxx::arrow_type::float64},
+     {"day", pqxx::arrow_type::date32},
+     {"at", pqxx::arrow_type::timestamp}}};
+
+  ArrowArray batch;
+  PQXX_CHECK_EQUAL(reader.read_batch(8, &batch), 8u, "Bad first batch.");
+  PQXX_CHECK_EQUAL(batch.length, 8, "Wrong batch length.");
+  PQXX_CHECK_EQUAL(batch.n_children, 6, "Wrong number of children.");
+
+  auto const &n{*batch.children[0]};
+  auto const &s{*batch.children[1]};
+  auto const &even{*batch.children[2]};
+  PQXX_CHECK_EQUAL(n.null_count, 0, "Unexpected nulls.");
+  PQXX_CHECK_EQUAL(value_at<std::int64_t>(n, 6), 7, "Bad int64 value.");
+  PQXX_CHECK_EQUAL(s.n_buffers, 3, "String array has wrong buffers.");
+  PQXX_CHECK_EQUAL(s.null_count, 2, "Wrong string null count.");
+  PQXX_CHECK(is_valid(s, 0), "Non-null string came out null.");
+  PQXX_CHECK(not is_valid(s, 2), "Null string came out non-null.");
+  PQXX_CHECK_EQUAL(string_at(s, 3), "v4", "Bad string value.");
+  PQXX_CHECK_EQUAL(string_at(s, 2), "", "Null string has data.");
+  PQXX_CHECK(is_valid(even, 0), "Non-null boolean came out null.");
+  auto const even_bits{static_cast<std::uint8_t const *>(even.buffers[1])};
+  PQXX_CHECK_EQUAL(int{even_bits[0]}, 0xaa, "Bad boolean bits.");
+  PQXX_CHECK_BOUNDS(
+    value_at<double>(*batch.children[3], 4), 2.4999, 2.5001,
+    "Bad float64 value.");
+  PQXX_CHECK_EQUAL(
+    value_at<std::int32_t>(*batch.children[4], 0), 1, "Bad date32 value.");
+  PQXX_CHECK_EQUAL(
+    value_at<std::int64_t>(*batch.children[5], 1), 2'000'000,
+    "Bad timestamp value.");
+
+  // A consumer may take a child out of the batch, and release it separately.
+  ArrowArray column{*batch.children[1]};
+  batch.children[1]->release = nullptr;
+  batch.release(&batch);
+  PQXX_CHECK(batch.release == nullptr, "Batch release did not mark it.");
+  PQXX_CHECK_EQUAL(string_at(column, 7), "v8", "Column died with batch.");
+  column.release(&column);
+
+  PQXX_CHECK_EQUAL(reader.read_batch(8, &batch), 2u, "Bad last batch.");
+  PQXX_CHECK_EQUAL(
+    value_at<std::int64_t>(*batch.children[0], 1), 10, "Bad last row.");
+  batch.release(&batch);
+
+  batch.release = nullptr;
+  PQXX_CHECK_EQUAL(reader.read_batch(8, &batch), 0u, "Read past end.");
+  PQXX_CHECK(batch.release == nullptr, "Empty read touched the batch.");
+  stream.complete();
+}
+
+
+void test_arrow_reader_checks_columns()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT 1::integer, 2::integer", pqxx::format::binary)};
+  pqxx::arrow_reader reader{stream, {{"n", pqxx::arrow_type::int32}}};
+  ArrowArray batch;
+  PQXX_CHECK_THROWS(
+    reader.read_batch(10, &batch), pqxx::usage_error,
+    "Arrow reader did not notice wrong number of columns.");
+}
+
+
+PQXX_REGISTER_TEST(test_arrow_reader_schema);
+PQXX_REGISTER_TEST(test_arrow_reader_batches);
+PQXX_REGISTER_TEST(test_arrow_reader_checks_columns);
+} // namespace
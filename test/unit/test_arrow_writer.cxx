@@ -0,0 +1,160 @@
+#include <cstdint>
+#include <vector>
+
+#include <pqxx/arrow_reader>
+#include <pqxx/arrow_writer>
+#include <pqxx/stream_from>
+#include <pqxx/stream_to>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void no_release(ArrowArray *array)
+{
+  array->release = nullptr;
+}
+
+
+void test_arrow_writer_writes_batch()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE arrow_in (n bigint, s text, b boolean)");
+
+  // A hand-made batch of 3 rows, with an offset of 1 into its columns.
+  std::vector<std::int64_t> const numbers{0, 10, 20, 30};
+  std::vector<std::uint8_t> const number_validity{0x0b};
+  std::vector<std::int32_t> const offsets{0, 1, 3, 3, 6};
+  std::string const chars{"xabdef"};
+  std::vector<std::uint8_t> const bools{0x02};
+
+  void const *n_buffers[]{number_validity.data(), numbers.data()};
+  void const *s_buffers[]{nullptr, offsets.data(), chars.data()};
+  void const *b_buffers[]{nullptr, bools.data()};
+  ArrowArray n{
+    4, 1, 0, 2, 0, n_buffers, nullptr, nullptr, no_release, nullptr};
+  ArrowArray s{
+    4, 0, 0, 3, 0, s_buffers, nullptr, nullptr, no_release, nullptr};
+  ArrowArray b{
+    4, 0, 0, 2, 0, b_buffers, nullptr, nullptr, no_release, nullptr};
+  ArrowArray *children[]{&n, &s, &b};
+  void const *batch_buffers[]{nullptr};
+  ArrowArray batch{
+    3, 0, 1, 1, 3, batch_buffers, children, nullptr, no_release, nullptr};
+
+  pqxx::stream_to stream{tx, "arrow_in", pqxx::format::binary};
+  pqxx::arrow_writer writer{
+    stream,
+    {pqxx::arrow_type::int64, pqxx::arrow_type::utf8,
+     pqxx::arrow_type::boolean}};
+  writer.write_batch(batch);
+  writer.write_batch(batch);
+  stream.complete();
+
+  auto const r{tx.exec("SELECT n, s, b FROM arrow_in")};
+  PQXX_CHECK_EQUAL(std::size(r), 6, "Wrong number of rows.");
+  PQXX_CHECK_EQUAL(r[0][0].as<long>(), 10L, "Bad first value.");
+  PQXX_CHECK_EQUAL(r[0][1].as<std::string>(), "ab", "Bad first string.");
+  PQXX_CHECK(r[0][2].as<bool>(), "Bad first boolean.");
+  PQXX_CHECK(r[1][0].is_null(), "Null came out non-null.");
+  PQXX_CHECK_EQUAL(r[1][1].as<std::string>(), "", "Bad empty string.");
+  PQXX_CHECK(not r[1][2].as<bool>(), "Bad second boolean.");
+  PQXX_CHECK_EQUAL(r[2][0].as<long>(), 30L, "Bad last value.");
+  PQXX_CHECK_EQUAL(r[2][1].as<std::string>(), "def", "Bad last string.");
+}
+
+
+void test_arrow_writer_round_trip()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0(
+    "CREATE TEMP TABLE arrow_copy "
+    "(i integer, f double precision, d date, t timestamp, z bytea)");
+  tx.exec0(
+    "INSERT INTO arrow_copy SELECT n, n / 4.0, "
+    "DATE '2020-01-01' + n, TIMESTAMP '1999-12-31 23:59:59' + n * "
+    "INTERVAL '1 minute', CASE WHEN n % 2 = 0 THEN NULL ELSE '\\x00ff' END "
+    "FROM generate_series(1, 100) AS n");
+  tx.exec0("INSERT INTO arrow_copy (d) VALUES ('infinity')");
+  tx.exec0("CREATE TEMP TABLE arrow_paste (LIKE arrow_copy)");
+
+  auto from{pqxx::stream_from::query(
+    tx, "SELECT * FROM arrow_copy", pqxx::format::binary)};
+  pqxx::arrow_reader reader{
+    from,
+    {{"i", pqxx::arrow_type::int32},
+     {"f", pqxx::arrow_type::float64},
+     {"d", pqxx::arrow_type::date32},
+     {"t", pqxx::arrow_type::timestamp},
+     {"z", pqxx::arrow_type::binary}}};
+  ArrowSchema schema;
+  reader.export_schema(&schema);
+  std::vector<ArrowArray> batches;
+  ArrowArray batch;
+  while (reader.read_batch(30, &batch) > 0) batches.push_back(batch);
+  from.complete();
+
+  pqxx::stream_to to{tx, "arrow_paste", pqxx::format::binary};
+  pqxx::arrow_writer writer{to, schema};
+  schema.release(&schema);
+  for (auto &b : batches)
+  {
+    writer.write_batch(b);
+    b.release(&b);
+  }
+  to.complete();
+
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>(
+      "SELECT count(*) FROM ("
+      "(SELECT * FROM arrow_copy EXCEPT SELECT * FROM arrow_paste) UNION ALL "
+      "(SELECT * FROM arrow_paste EXCEPT SELECT * FROM arrow_copy)) AS x"),
+    0, "Round trip through Arrow changed the data.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM arrow_paste"), 101,
+    "Wrong number of rows.");
+}
+
+
+void test_arrow_writer_checks_input()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE arrow_bad (n integer)");
+  {
+    pqxx::stream_to text{tx, "arrow_bad"};
+    PQXX_CHECK_THROWS(
+      pqxx::arrow_writer(text, {pqxx::arrow_type::int32}), pqxx::usage_error,
+      "Arrow writer accepted a text stream.");
+    text.complete();
+  }
+
+  pqxx::stream_to stream{tx, "arrow_bad", pqxx::format::binary};
+  ArrowSchema duration{
+    "tDu", "n", nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr};
+  ArrowSchema schema{
+    "+s", "", nullptr, 0, 1, nullptr, nullptr, nullptr, nullptr};
+  ArrowSchema *children[]{&duration};
+  schema.children = children;
+  PQXX_CHECK_THROWS(
+    pqxx::arrow_writer(stream, schema), pqxx::argument_error,
+    "Arrow writer accepted an unsupported type.");
+
+  pqxx::arrow_writer writer{
+    stream, {pqxx::arrow_type::int32, pqxx::arrow_type::int32}};
+  ArrowArray batch{
+    1, 0, 0, 1, 1, nullptr, nullptr, nullptr, no_release, nullptr};
+  PQXX_CHECK_THROWS(
+    writer.write_batch(batch), pqxx::argument_error,
+    "Arrow writer accepted a batch with the wrong number of columns.");
+  stream.complete();
+}
+
+
+PQXX_REGISTER_TEST(test_arrow_writer_writes_batch);
+PQXX_REGISTER_TEST(test_arrow_writer_round_trip);
+PQXX_REGISTER_TEST(test_arrow_writer_checks_input);
+} // namespace
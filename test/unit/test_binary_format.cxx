@@ -0,0 +1,250 @@
+#include "../test_helpers.hxx"
+
+#include <pqxx/binarystring>
+#include <pqxx/transaction>
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+using namespace std::literals;
+
+
+void test_binary_traits_decode_integers()
+{
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<int>::from_binary("\x00\x2a"sv), 42,
+    "Bad binary smallint.");
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<int>::from_binary("\xff\xff\xff\xfe"sv), -2,
+    "Bad negative binary integer.");
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<long long>::from_binary(
+      "\x01\x00\x00\x00\x00\x00\x00\x00"sv),
+    72057594037927936LL, "Bad binary bigint.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::binary_traits<short>::from_binary(
+      "\x00\x01\x00\x00"sv)),
+    pqxx::range_error, "Binary integer overflow went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::binary_traits<unsigned>::from_binary("\xff\xff\xff\xff"sv)),
+    pqxx::range_error, "Negative binary integer became unsigned.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::binary_traits<int>::from_binary("\x01\x02\x03"sv)),
+    pqxx::conversion_error, "Odd-sized binary integer went unnoticed.");
+}
+
+
+void test_binary_traits_decode_other_types()
+{
+  PQXX_CHECK_BOUNDS(
+    pqxx::binary_traits<double>::from_binary(
+      "\x40\x09\x21\xfb\x54\x44\x2d\x18"sv),
+    3.14159, 3.14160, "Bad binary double precision.");
+  PQXX_CHECK_BOUNDS(
+    pqxx::binary_traits<float>::from_binary("\x3f\xc0\x00\x00"sv), 1.499f,
+    1.501f, "Bad binary real.");
+  PQXX_CHECK(
+    pqxx::binary_traits<bool>::from_binary("\x01"sv), "Bad binary true.");
+  PQXX_CHECK(
+    not pqxx::binary_traits<bool>::from_binary("\x00"sv),
+    "Bad binary false.");
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<std::string>::from_binary("a\0b"sv), "a\0b"s,
+    "Binary string lost bytes.");
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<std::optional<int>>::from_binary("\x00\x07"sv).value(),
+    7, "Bad binary optional.");
+
+  PQXX_CHECK(pqxx::has_binary_traits<int>, "int has no binary traits.");
+  PQXX_CHECK(
+    not pqxx::has_binary_traits<char const *>,
+    "Unexpected binary traits for C string.");
+  PQXX_CHECK(
+    not pqxx::has_binary_traits<std::optional<char const *>>,
+    "Unexpected binary traits for optional C string.");
+}
+
+
+template<typename T> std::string to_binary(T const &value)
+{
+  std::string buf;
+  buf.resize(pqxx::binary_traits<T>::binary_size(value));
+  auto const end{pqxx::binary_traits<T>::into_binary(
+    buf.data(), buf.data() + buf.size(), value)};
+  PQXX_CHECK(
+    end == buf.data() + buf.size(), "binary_size() did not match output.");
+  return buf;
+}
+
+
+void test_binary_traits_encode()
+{
+  PQXX_CHECK_EQUAL(to_binary(short{-2}), "\xff\xfe"s, "Bad binary short.");
+  PQXX_CHECK_EQUAL(to_binary(42), "\0\0\0\x2a"s, "Bad binary int.");
+  PQXX_CHECK_EQUAL(
+    to_binary(1LL << 56), "\1\0\0\0\0\0\0\0"s, "Bad binary long long.");
+  PQXX_CHECK_EQUAL(to_binary(1.5f), "\x3f\xc0\0\0"s, "Bad binary float.");
+  PQXX_CHECK_EQUAL(
+    to_binary(3.141592653589793), "\x40\x09\x21\xfb\x54\x44\x2d\x18"s,
+    "Bad binary double.");
+  PQXX_CHECK_EQUAL(to_binary(true), "\1"s, "Bad binary bool.");
+  PQXX_CHECK_EQUAL(to_binary("x\0y"s), "x\0y"s, "Bad binary string.");
+  PQXX_CHECK_EQUAL(
+    to_binary(std::optional<int>{7}), "\0\0\0\7"s, "Bad binary optional.");
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<long>::from_binary(to_binary(-123456789L)),
+    -123456789L, "Binary long did not round-trip.");
+
+  char buf[3];
+  PQXX_CHECK_THROWS(
+    pqxx::binary_traits<int>::into_binary(buf, buf + sizeof(buf), 1),
+    pqxx::conversion_overrun, "Binary buffer overrun went unnoticed.");
+
+  PQXX_CHECK(
+    not pqxx::has_binary_output<unsigned>, "Unsigned should be read-only.");
+  PQXX_CHECK(
+    pqxx::has_binary_output<char const *>, "C string has no binary output.");
+}
+
+
+void test_binary_arrays()
+{
+  std::vector<std::optional<int>> const ints{5, std::nullopt, -1};
+  auto const wire{to_binary(ints)};
+  PQXX_CHECK_EQUAL(
+    wire,
+    // One dimension, has nulls, integer elements.
+    "\0\0\0\1"
+    "\0\0\0\1"
+    "\0\0\0\x17"
+    // Three elements, starting at index 1.
+    "\0\0\0\3"
+    "\0\0\0\1"
+    // The elements: 5, null, -1.
+    "\0\0\0\4\0\0\0\5"
+    "\xff\xff\xff\xff"
+    "\0\0\0\4\xff\xff\xff\xff"s,
+    "Bad binary array.");
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<std::vector<int>>::type_oid, 1007u,
+    "Wrong OID for integer array.");
+
+  auto const back{
+    pqxx::binary_traits<std::vector<std::optional<long>>>::from_binary(wire)};
+  PQXX_CHECK_EQUAL(std::size(back), 3u, "Binary array changed size.");
+  PQXX_CHECK_EQUAL(*back[2], -1L, "Binary array element changed.");
+  PQXX_CHECK(not back[1].has_value(), "Null array element got a value.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::binary_traits<std::vector<int>>::from_binary(wire)),
+    pqxx::conversion_error, "Null went into a non-nullable element.");
+
+  std::array<double, 2> const doubles{0.5, 1e100};
+  auto const fixed{pqxx::binary_traits<std::array<double, 2>>::from_binary(
+    to_binary(doubles))};
+  PQXX_CHECK_BOUNDS(
+    fixed[1], 0.9999e100, 1.0001e100, "std::array did not round-trip.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::binary_traits<std::array<double, 3>>::from_binary(
+        to_binary(doubles))),
+    pqxx::conversion_error, "Binary array size mismatch went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::binary_traits<std::vector<double>>::from_binary(
+      to_binary(doubles).substr(0, 30))),
+    pqxx::conversion_error, "Truncated binary array went unnoticed.");
+
+  auto const empty{to_binary(std::vector<bool>{})};
+  PQXX_CHECK_EQUAL(empty.size(), 12u, "Bad size for empty binary array.");
+  PQXX_CHECK(
+    pqxx::binary_traits<std::vector<bool>>::from_binary(empty).empty(),
+    "Empty binary array came back nonempty.");
+
+  PQXX_CHECK(
+    not pqxx::has_binary_output<std::vector<std::string>>,
+    "Text arrays should be read-only in binary.");
+  PQXX_CHECK(
+    pqxx::has_binary_traits<std::vector<std::string>>,
+    "Can't read text arrays in binary.");
+}
+
+
+void test_binary_array_roundtrip()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  std::vector<double> in(10000);
+  for (std::size_t i{0}; i < std::size(in); ++i) in[i] = 0.25 * double(i);
+
+  auto const r{tx.exec_params_binary(
+    "SELECT $1::float8[], ARRAY['a', NULL]::text[]",
+    pqxx::prepare::make_binary_param(in))};
+  auto const out{r[0][0].as<std::vector<double>>()};
+  PQXX_CHECK(out == in, "Binary float8 array did not round-trip.");
+  auto const texts{r[0][1].as<std::vector<std::optional<std::string>>>()};
+  PQXX_CHECK_EQUAL(std::size(texts), 2u, "Bad binary text array size.");
+  PQXX_CHECK_EQUAL(*texts[0], "a", "Bad binary text array element.");
+  PQXX_CHECK(not texts[1].has_value(), "Bad null in binary text array.");
+}
+
+
+void test_exec_params_binary()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const r{tx.exec_params_binary(
+    "SELECT $1::bigint, 2.5::float8, true, 'xyz'::text, NULL::integer, "
+    "'\\x0001ff'::bytea",
+    1234567890123LL)};
+  auto const row{r.at(0)};
+  PQXX_CHECK(row[0].is_binary(), "Result was not in binary format.");
+  PQXX_CHECK_EQUAL(
+    row[0].as<long long>(), 1234567890123LL, "Bad binary bigint.");
+  PQXX_CHECK_BOUNDS(
+    row[1].as<double>(), 2.4999, 2.5001, "Bad binary float8.");
+  PQXX_CHECK(row[2].as<bool>(), "Bad binary boolean.");
+  PQXX_CHECK_EQUAL(row[3].as<std::string>(), "xyz", "Bad binary text.");
+  PQXX_CHECK(
+    not row[4].get<int>().has_value(), "Binary null did not come out null.");
+  pqxx::binarystring const bytes{row[5]};
+  PQXX_CHECK_EQUAL(bytes.size(), 3u, "Bad binary bytea size.");
+  PQXX_CHECK_EQUAL(int(bytes[2]), 0xff, "Bad binary bytea contents.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(row[0].as<char const *>()), pqxx::conversion_error,
+    "Binary field converted to C string.");
+}
+
+
+void test_exec_prepared_binary()
+{
+  pqxx::connection conn;
+  conn.prepare("binstmt", "SELECT $1::integer * 2");
+  pqxx::work tx{conn};
+  auto const r{tx.exec_prepared_binary("binstmt", 21)};
+  PQXX_CHECK(r[0][0].is_binary(), "Prepared result not in binary format.");
+  PQXX_CHECK_EQUAL(r[0][0].as<int>(), 42, "Bad binary prepared result.");
+
+  // The text-format variant still works as before.
+  PQXX_CHECK(
+    not tx.exec_prepared("binstmt", 1)[0][0].is_binary(),
+    "Text result came back binary.");
+}
+
+
+PQXX_REGISTER_TEST(test_binary_traits_decode_integers);
+PQXX_REGISTER_TEST(test_binary_traits_decode_other_types);
+PQXX_REGISTER_TEST(test_binary_traits_encode);
+PQXX_REGISTER_TEST(test_binary_arrays);
+PQXX_REGISTER_TEST(test_binary_array_roundtrip);
+PQXX_REGISTER_TEST(test_exec_params_binary);
+PQXX_REGISTER_TEST(test_exec_prepared_binary);
+} // namespace
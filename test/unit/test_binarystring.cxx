@@ -1,3 +1,6 @@
+#include <cstddef>
+#include <cstring>
+
 #include "../test_helpers.hxx"
 
 
@@ -100,5 +103,81 @@ void test_binarystring()
 }
 
 
+void test_esc_bin_unesc_bin()
+{
+  PQXX_CHECK_EQUAL(pqxx::esc_bin(""), "\\x", "Bad escape for empty data.");
+  PQXX_CHECK_EQUAL(
+    pqxx::esc_bin(std::string{"\x00\x7f\x80\xff", 4}), "\\x007f80ff",
+    "Bad hex escaping.");
+  PQXX_CHECK_EQUAL(
+    pqxx::size_esc_bin(3), 9u, "Wrong buffer size for escaping.");
+
+  // Long enough for the 16 and 32-byte blocks, and for a tail.
+  for (std::size_t size{0}; size < 100; ++size)
+  {
+    std::string data;
+    for (std::size_t i{0}; i < size; ++i)
+      data.push_back(static_cast<char>((i * 37 + size) & 0xff));
+    auto const escaped{pqxx::esc_bin(data)};
+    PQXX_CHECK_EQUAL(
+      escaped.size() + 1, pqxx::size_esc_bin(size), "Bad escaped size.");
+    auto const back{pqxx::unesc_bin(escaped)};
+    PQXX_CHECK_EQUAL(
+      std::size(back), size, "Binary data changed size in round trip.");
+    PQXX_CHECK(
+      std::memcmp(back.data(), data.data(), size) == 0,
+      "Binary data changed in round trip.");
+  }
+
+  std::string upper{"\\x"};
+  for (int i{0}; i < 20; ++i) upper += "ABCDEF";
+  auto const decoded{pqxx::unesc_bin(upper)};
+  PQXX_CHECK(
+    decoded[0] == std::byte{0xab} and decoded[59] == std::byte{0xef},
+    "Upper-case hex decoded wrong.");
+
+  // A bad digit anywhere, in the block-wise part or the tail.
+  for (std::size_t pos{2}; pos < std::size(upper); pos += 7)
+  {
+    auto bad{upper};
+    bad[pos] = 'g';
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(pqxx::unesc_bin(bad)), pqxx::argument_error,
+      "Invalid hex digit went unnoticed.");
+  }
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::unesc_bin("\\x123")), pqxx::argument_error,
+    "Odd-length hex went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::unesc_bin("abc\\000")), pqxx::argument_error,
+    "Escape-format data passed as hex.");
+}
+
+
+void test_binarystring_shares_binary_result()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const r{tx.exec_params_binary("SELECT '\\x00ff01'::bytea")};
+  pqxx::binarystring const b{r[0][0]};
+  PQXX_CHECK_EQUAL(b.size(), 3u, "Bad size for binary bytea.");
+  PQXX_CHECK(
+    b.get() == r[0][0].c_str(), "Binary bytea was copied, not shared.");
+
+  // The binarystring keeps the result's data alive.
+  auto const copy{[&tx] {
+    return pqxx::binarystring{
+      tx.exec_params_binary("SELECT '\\x616263'::bytea")[0][0]};
+  }()};
+  PQXX_CHECK_EQUAL(copy.str(), "abc", "Shared bytea outlived its data.");
+
+  PQXX_CHECK_EQUAL(
+    tx.unesc_raw(tx.esc_raw(std::string{"\0\1x", 3})),
+    (std::string{"\0\1x", 3}), "esc_raw()/unesc_raw() did not round-trip.");
+}
+
+
 PQXX_REGISTER_TEST(test_binarystring);
+PQXX_REGISTER_TEST(test_esc_bin_unesc_bin);
+PQXX_REGISTER_TEST(test_binarystring_shares_binary_result);
 } // namespace
@@ -0,0 +1,98 @@
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <pqxx/bulk_upsert>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_bulk_upsert()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0(
+    "CREATE TEMP TABLE item "
+    "(id integer PRIMARY KEY, price integer NOT NULL, note text)");
+  tx.exec0("INSERT INTO item (id, price, note) VALUES (1, 10, 'old')");
+
+  pqxx::bulk_upsert up{
+    tx, "item", {"id", "price"},
+    "ON CONFLICT (id) DO UPDATE SET price = excluded.price"};
+  for (int i{1}; i <= 100; ++i) up << std::tuple{i, i * 100};
+  PQXX_CHECK_EQUAL(up.complete(), 100u, "Wrong number of rows merged.");
+  PQXX_CHECK_THROWS(
+    up.complete(), pqxx::usage_error, "Completing twice did not fail.");
+
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM item"), 100,
+    "Wrong number of rows after upsert.");
+  auto const [price, note]{
+    tx.exec1("SELECT price, note FROM item WHERE id = 1")
+      .as<int, std::string>()};
+  PQXX_CHECK_EQUAL(price, 100, "Upsert did not update.");
+  PQXX_CHECK_EQUAL(note, "old", "Upsert touched a column it should not.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>(
+      "SELECT count(*) FROM pg_class WHERE relname LIKE 'pqxx_upsert%'"),
+    0, "Staging table was not dropped.");
+}
+
+
+void test_bulk_upsert_binary()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE counter (id bigint PRIMARY KEY, n bigint)");
+  tx.exec0("INSERT INTO counter VALUES (1, 1), (2, 2)");
+
+  std::vector<std::string> const columns{"id", "n"};
+  pqxx::bulk_upsert up{
+    tx, "counter", columns, "ON CONFLICT (id) DO NOTHING",
+    pqxx::format::binary};
+  up << std::tuple{2LL, 20LL} << std::tuple{3LL, 30LL};
+  PQXX_CHECK_EQUAL(
+    up.complete(), 1u, "Conflicting row should not have counted.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<long long>("SELECT sum(n) FROM counter"), 33LL,
+    "Binary upsert went wrong.");
+}
+
+
+void test_bulk_upsert_dedup()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE item (id integer PRIMARY KEY, price integer)");
+
+  // Without dedup, this would try to update the same row twice.
+  pqxx::bulk_upsert up{
+    tx, "item", {"id", "price"},
+    "ON CONFLICT (id) DO UPDATE SET price = excluded.price"};
+  up.set_dedup({0});
+  up << std::tuple{1, 10} << std::tuple{2, 20} << std::tuple{1, 11};
+  PQXX_CHECK_EQUAL(up.complete(), 2u, "Wrong number of rows merged.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT price FROM item WHERE id = 1"), 10,
+    "First row did not win.");
+
+  // When the stream can't hold the keys, the merge weeds out duplicates.
+  pqxx::bulk_upsert spill{
+    tx, "item", {"id", "price"},
+    "ON CONFLICT (id) DO UPDATE SET price = excluded.price"};
+  spill.set_dedup({0}, 0);
+  spill << std::tuple{3, 30} << std::tuple{3, 31} << std::tuple{4, 40};
+  PQXX_CHECK(spill.stream().dedup_overflowed(), "Dedup did not overflow.");
+  PQXX_CHECK_EQUAL(spill.complete(), 2u, "Spilled dedup went wrong.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM item"), 4,
+    "Wrong number of rows after spilled dedup.");
+}
+
+
+PQXX_REGISTER_TEST(test_bulk_upsert);
+PQXX_REGISTER_TEST(test_bulk_upsert_dedup);
+PQXX_REGISTER_TEST(test_bulk_upsert_binary);
+} // namespace
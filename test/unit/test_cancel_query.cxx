@@ -18,5 +18,22 @@ void test_cancel_query()
 }
 
 
+void test_cancel_query_reuses_handle()
+{
+  pqxx::connection conn;
+  conn.cancel_query();
+  PQXX_CHECK_ALLOCATIONS(
+    conn.cancel_query(), 0u, "cancel_query() allocated a cancel handle.");
+
+  // After reconnecting, the cancel handle is for the new backend.
+  conn.reconnect();
+  conn.cancel_query();
+  PQXX_CHECK_EQUAL(
+    pqxx::nontransaction{conn}.exec1("SELECT 1")[0].as<int>(), 1,
+    "Connection unusable after cancelling on new backend.");
+}
+
+
 PQXX_REGISTER_TEST(test_cancel_query);
+PQXX_REGISTER_TEST(test_cancel_query_reuses_handle);
 } // namespace
@@ -0,0 +1,80 @@
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+#include <pqxx/chunked_field>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_chunked_field_bytea()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+
+  // 10,000 bytes, counting up from zero and wrapping around.
+  std::string expected;
+  for (std::size_t i{0}; i < 10000; ++i)
+    expected.push_back(static_cast<char>(i % 256));
+
+  pqxx::field_chunks chunks;
+  chunks.chunk_size = 1000;
+  chunks.readahead = 2;
+  pqxx::chunked_field_stream in{
+    tx, chunks,
+    "SELECT pg_catalog.decode(pg_catalog.string_agg("
+    "pg_catalog.lpad(pg_catalog.to_hex(i % 256), 2, '0'), '' ORDER BY i), "
+    "'hex') "
+    "FROM pg_catalog.generate_series(0, $1 - 1) AS i",
+    10000};
+  std::string const got{
+    std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+  PQXX_CHECK_EQUAL(std::size(got), std::size(expected), "Wrong size.");
+  PQXX_CHECK(got == expected, "Wrong bytea contents.");
+  PQXX_CHECK(in.fetches() >= 10, "Read more than a chunk at a time.");
+
+  // Once the stream is done, the transaction is free again.
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 1"), 1, "Transaction unusable after stream.");
+}
+
+
+void test_chunked_field_text()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+
+  pqxx::field_chunks chunks;
+  chunks.chunk_size = 1000;
+  std::string got;
+  {
+    pqxx::chunked_field_stream in{
+      tx, chunks, "SELECT pg_catalog.repeat($1, 3001)", "xyz"};
+    std::getline(in, got, '\0');
+  }
+  PQXX_CHECK_EQUAL(std::size(got), 9003u, "Wrong text size.");
+  PQXX_CHECK_EQUAL(got.substr(0, 6), "xyzxyz", "Wrong text.");
+
+  // Stopping early does not leave the transaction in a mess.
+  {
+    pqxx::chunked_field_stream in{
+      tx, chunks, "SELECT pg_catalog.repeat('abc', 10000)"};
+    char c{};
+    in.get(c);
+    PQXX_CHECK(c == 'a', "Wrong first character.");
+  }
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 2"), 2, "Transaction unusable after stream.");
+
+  pqxx::chunked_field_stream null{tx, "SELECT NULL::text"};
+  PQXX_CHECK(
+    std::istreambuf_iterator<char>{null} == std::istreambuf_iterator<char>{},
+    "Null value did not read as empty.");
+}
+
+
+PQXX_REGISTER_TEST(test_chunked_field_bytea);
+PQXX_REGISTER_TEST(test_chunked_field_text);
+} // namespace
@@ -1,3 +1,8 @@
+#include <chrono>
+#include <thread>
+
+#include <pqxx/stream_from>
+
 #include "../test_helpers.hxx"
 
 namespace
@@ -86,8 +91,263 @@ void test_connection_string()
 }
 
 
+void test_connecting()
+{
+  pqxx::connecting nbc{pqxx::zview{""}};
+  while (not nbc.done())
+  {
+    pqxx::internal::wait_socket(nbc.sock(), nbc.wait_to_write());
+    nbc.process();
+  }
+  auto c{std::move(nbc).produce()};
+  pqxx::work tx{c};
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 10"), 10,
+    "Asynchronously established connection does not work.");
+}
+
+
+void test_connect_all()
+{
+  auto conns{pqxx::connect_all(pqxx::zview{""}, 4)};
+  PQXX_CHECK_EQUAL(std::size(conns), 4u, "Wrong number of connections.");
+  for (auto &c : conns)
+  {
+    pqxx::nontransaction tx{c};
+    PQXX_CHECK_EQUAL(
+      tx.query_value<int>("SELECT 1"), 1, "Concurrent connection broken.");
+  }
+}
+
+
+void test_connect_all_failure()
+{
+  PQXX_CHECK(
+    std::empty(pqxx::connect_all(std::vector<std::string>{})),
+    "Connecting nothing produced connections.");
+
+  // A failure to connect shows up as an exception.
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::connect_all(
+      std::vector<std::string>{"host=/nonexistent/pqxx/socket/dir"})),
+    pqxx::broken_connection, "Failed concurrent connection did not throw.");
+}
+
+
+void test_connect_first()
+{
+  auto c{pqxx::connect_first(pqxx::zview{""})};
+  pqxx::nontransaction tx{c};
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 1"), 1, "Raced connection broken.");
+}
+
+
+void test_connect_first_skips_bad_hosts()
+{
+  std::string host, port;
+  {
+    pqxx::connection const c;
+    host = c.hostname();
+    port = c.port();
+  }
+  pqxx::connect_first_config config;
+  config.stagger = std::chrono::milliseconds{10};
+  std::string const options{
+    "host=/nonexistent/pqxx/socket/dir," + host + " port=" + port};
+  auto c{pqxx::connect_first(pqxx::zview{options}, config)};
+  PQXX_CHECK_EQUAL(
+    std::string{c.hostname()}, host, "Connected to the wrong host.");
+
+  pqxx::forget_host_addresses();
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::connect_first(
+      pqxx::zview{"host=/nonexistent/pqxx/socket/dir"}, config)),
+    pqxx::broken_connection, "Failed connect_first() did not throw.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::connect_first(pqxx::zview{"nonsense"}, config)),
+    pqxx::broken_connection, "Bad connection string did not throw.");
+}
+
+
+void test_result_size_limit()
+{
+  pqxx::connection c;
+  PQXX_CHECK_EQUAL(c.result_size_limit(), 0u, "Connection starts limited.");
+  pqxx::nontransaction tx{c};
+  auto const small{tx.exec("SELECT 1")};
+  PQXX_CHECK(small.memory_usage() > 0u, "Result takes no memory.");
+  auto const big{tx.exec("SELECT repeat('x', 100000)")};
+  PQXX_CHECK(
+    big.memory_usage() > 100000u, "Big result's memory went unnoticed.");
+
+  c.set_result_size_limit(big.memory_usage() / 2);
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 1"), 1, "Limit stopped a small result.");
+  PQXX_CHECK_THROWS(
+    tx.exec("SELECT repeat('x', 100000)"), pqxx::result_too_large,
+    "Result size limit did not stop a big result.");
+
+  c.set_result_size_limit(0);
+  PQXX_CHECK_EQUAL(
+    std::size(tx.exec("SELECT repeat('x', 100000)")), 1,
+    "Removing the limit did not work.");
+}
+
+
+void test_spin_wait()
+{
+  using namespace std::chrono_literals;
+  pqxx::connection c;
+  PQXX_CHECK(c.spin_wait() == 0us, "Connection spins by default.");
+  c.set_spin_wait(50us);
+  PQXX_CHECK(c.spin_wait() == 50us, "Spin limit did not stick.");
+
+  pqxx::nontransaction tx{c};
+  for (int i{0}; i < 20; ++i)
+    PQXX_CHECK_EQUAL(
+      tx.query_value<int>("SELECT " + pqxx::to_string(i)), i,
+      "Wrong result while spinning.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 1; SELECT 2"), 2,
+    "Multi-statement query did not return its last result.");
+  PQXX_CHECK_EQUAL(
+    tx.exec_params1("SELECT $1 + 1", 41)[0].as<int>(), 42,
+    "Parameterised query went wrong while spinning.");
+  c.prepare("spin", "SELECT $1::int * 2");
+  PQXX_CHECK_EQUAL(
+    tx.exec_prepared1("spin", 21)[0].as<int>(), 42,
+    "Prepared statement went wrong while spinning.");
+  PQXX_CHECK_THROWS(
+    tx.exec("SELECT nonexistent_column_xyz"), pqxx::sql_error,
+    "Error went unnoticed while spinning.");
+  PQXX_CHECK_THROWS(
+    tx.exec("SELECT pg_sleep(0.01); SELECT 1/0; SELECT 3"), pqxx::sql_error,
+    "Error in the middle of a multi-statement query got lost.");
+
+  // A slow query makes the connection block, but still works.
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 7 FROM pg_sleep(0.01)"), 7,
+    "Slow query went wrong while spinning.");
+
+  c.set_spin_wait(0us);
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 8"), 8, "Turning off spinning broke things.");
+}
+
+
+class reconnect_receiver final : public pqxx::notification_receiver
+{
+public:
+  using pqxx::notification_receiver::notification_receiver;
+  void receive(pqxx::zview, int) override { ++calls; }
+  int calls = 0;
+};
+
+
+void test_reconnect()
+{
+  pqxx::connection c;
+  PQXX_CHECK(not c.reconnect_enabled(), "Reconnect mode is on by default.");
+  c.set_reconnect();
+  c.prepare("pqxx_reconnect_stmt", "SELECT 2 * $1::integer");
+  c.prepare("pqxx_reconnect_gone", "SELECT 1");
+  c.unprepare("pqxx_reconnect_gone");
+  c.set_variable("application_name", "'pqxx_reconnect'");
+  reconnect_receiver receiver{c, "pqxx_reconnect_channel"};
+
+  // Kill our backend from another connection.
+  auto const old_pid{c.backendpid()};
+  {
+    pqxx::connection killer;
+    pqxx::nontransaction tx{killer};
+    tx.exec_params0("SELECT pg_terminate_backend($1)", old_pid);
+  }
+  PQXX_CHECK_THROWS(
+    pqxx::nontransaction{c}.exec("SELECT 1"), pqxx::broken_connection,
+    "Terminated backend still answered.");
+
+  // Starting a transaction on the broken connection reconnects it.
+  pqxx::work tx{c};
+  PQXX_CHECK(c.backendpid() != old_pid, "Did not get a new backend.");
+  PQXX_CHECK_EQUAL(
+    tx.exec_prepared1("pqxx_reconnect_stmt", 21)[0].as<int>(), 42,
+    "Prepared statement did not survive reconnect.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<std::string>("SHOW application_name"),
+    "pqxx_reconnect", "Variable did not survive reconnect.");
+  PQXX_CHECK_THROWS(
+    tx.exec_prepared("pqxx_reconnect_gone"), pqxx::sql_error,
+    "Unprepared statement came back.");
+  tx.abort();
+
+  PQXX_CHECK_THROWS(
+    [&c] {
+      pqxx::work busy{c};
+      c.reconnect();
+    }(),
+    pqxx::usage_error, "Reconnected inside a transaction.");
+
+  c.reconnect();
+  pqxx::nontransaction{c}.exec0("NOTIFY pqxx_reconnect_channel");
+  for (int i{0}; i < 20 and receiver.calls == 0; ++i)
+    if (c.get_notifs() == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds{50});
+  PQXX_CHECK_EQUAL(receiver.calls, 1, "LISTEN did not survive reconnect.");
+
+  c.set_reconnect(false);
+  PQXX_CHECK(not c.reconnect_enabled(), "Could not turn reconnect off.");
+}
+
+
+void test_reported_variables()
+{
+  pqxx::connection conn;
+  conn.set_variable("TimeZone", "'UTC'");
+  PQXX_CHECK_EQUAL(
+    conn.get_variable("TimeZone"), "UTC", "Reported variable is stale.");
+  conn.set_client_encoding("LATIN1");
+  PQXX_CHECK(
+    conn.enc_group() == pqxx::internal::encoding_group::MONOBYTE,
+    "Encoding group did not follow encoding change.");
+  conn.set_client_encoding("UTF8");
+  PQXX_CHECK(
+    conn.enc_group() == pqxx::internal::encoding_group::UTF8,
+    "Encoding group did not change back.");
+
+  // Unreported variables still work, through a query.
+  conn.set_variable("work_mem", "'2MB'");
+  PQXX_CHECK_EQUAL(
+    conn.get_variable("work_mem"), "2MB", "Unreported variable is wrong.");
+
+  // A reported variable needs no query, so it works in the middle of COPY.
+  pqxx::work tx{conn};
+  pqxx::stream_from s{tx, pqxx::from_query, "SELECT 1"};
+  PQXX_CHECK_EQUAL(
+    conn.get_variable("client_encoding"), "UTF8", "Wrong client encoding.");
+  s.complete();
+}
+
+
+void test_result_memory_offline()
+{
+  PQXX_CHECK_EQUAL(
+    pqxx::result{}.memory_usage(), 0u, "Empty result object takes memory.");
+}
+
+
 PQXX_REGISTER_TEST(test_move_constructor);
 PQXX_REGISTER_TEST(test_move_assign);
 PQXX_REGISTER_TEST(test_encrypt_password);
 PQXX_REGISTER_TEST(test_connection_string);
+PQXX_REGISTER_TEST(test_connecting);
+PQXX_REGISTER_TEST(test_connect_all);
+PQXX_REGISTER_TEST(test_connect_all_failure);
+PQXX_REGISTER_TEST(test_connect_first);
+PQXX_REGISTER_TEST(test_connect_first_skips_bad_hosts);
+PQXX_REGISTER_TEST(test_result_size_limit);
+PQXX_REGISTER_TEST(test_spin_wait);
+PQXX_REGISTER_TEST(test_result_memory_offline);
+PQXX_REGISTER_TEST(test_reconnect);
+PQXX_REGISTER_TEST(test_reported_variables);
 } // namespace
@@ -0,0 +1,305 @@
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pqxx/connection_pool>
+#include <pqxx/nontransaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_connection_pool_config()
+{
+  pqxx::connection_pool_config config;
+  config.max_size = 0;
+  PQXX_CHECK_THROWS(
+    pqxx::connection_pool("", config), pqxx::argument_error,
+    "Pool without room for connections was accepted.");
+
+  config.max_size = 1;
+  config.min_size = 2;
+  PQXX_CHECK_THROWS(
+    pqxx::connection_pool("", config), pqxx::argument_error,
+    "Pool with minimum size above its maximum was accepted.");
+
+  config.min_size = 0;
+  config.shards = 0;
+  PQXX_CHECK_THROWS(
+    pqxx::connection_pool("", config), pqxx::argument_error,
+    "Pool without shards was accepted.");
+  config.shards = 4;
+
+  // With no minimum size, the pool doesn't connect until it needs to.
+  pqxx::connection_pool pool{"host=/nonexistent/pqxx/socket/dir", config};
+  PQXX_CHECK_EQUAL(pool.size(), 0u, "Pool opened connections up front.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pool.get()), pqxx::broken_connection,
+    "Pool hid a failure to connect.");
+  PQXX_CHECK_EQUAL(
+    pool.size(), 0u, "Failed connection still counts towards pool size.");
+}
+
+
+void test_connection_pool()
+{
+  pqxx::connection_pool_config config;
+  config.min_size = 1;
+  config.max_size = 2;
+  config.checkout_timeout = std::chrono::milliseconds{100};
+  pqxx::connection_pool pool{"", config};
+  PQXX_CHECK_EQUAL(pool.size(), 1u, "Pool did not open minimum connections.");
+  PQXX_CHECK_EQUAL(pool.idle(), 1u, "Initial connection is not idle.");
+
+  pool.prepare("pool_double", "SELECT 2 * $1::integer");
+  {
+    auto a{pool.get()};
+    auto b{pool.get()};
+    PQXX_CHECK_EQUAL(pool.size(), 2u, "Pool did not grow.");
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(pool.get()), pqxx::failure,
+      "Pool went over its maximum size.");
+
+    for (auto *c : {&a, &b})
+    {
+      pqxx::nontransaction tx{**c};
+      PQXX_CHECK_EQUAL(
+        tx.exec_prepared1("pool_double", 21)[0].as<int>(), 42,
+        "Pooled connection lacks prepared statement.");
+    }
+  }
+  PQXX_CHECK_EQUAL(pool.idle(), 2u, "Connections did not come back.");
+
+  // A broken connection does not go back into the pool.
+  {
+    auto c{pool.get()};
+    c->close();
+  }
+  PQXX_CHECK_EQUAL(pool.size(), 1u, "Broken connection stayed in the pool.");
+
+  // Threads can share the pool.
+  std::vector<std::thread> threads;
+  std::vector<int> results(8);
+  for (std::size_t i{0}; i < std::size(results); ++i)
+    threads.emplace_back([&pool, &results, i] {
+      auto c{pool.get()};
+      pqxx::nontransaction tx{*c};
+      results[i] = tx.exec_prepared1("pool_double", int(i))[0].as<int>();
+    });
+  for (auto &t : threads) t.join();
+  for (std::size_t i{0}; i < std::size(results); ++i)
+    PQXX_CHECK_EQUAL(results[i], 2 * int(i), "Wrong result from pool.");
+}
+
+
+void test_connection_pool_reset()
+{
+  pqxx::connection_pool_config config;
+  config.max_size = 1;
+  config.reset = pqxx::pool_reset::discard_all;
+  pqxx::connection_pool pool{"", config};
+  pool.prepare("pool_answer", "SELECT 42");
+
+  {
+    auto c{pool.get()};
+    c->set_variable("application_name", "'pqxx_pool_test'");
+  }
+
+  auto c{pool.get()};
+  PQXX_CHECK_NOT_EQUAL(
+    c->get_variable("application_name"), std::string{"pqxx_pool_test"},
+    "Pool did not reset session.");
+  pqxx::nontransaction tx{*c};
+  PQXX_CHECK_EQUAL(
+    tx.exec_prepared1("pool_answer")[0].as<int>(), 42,
+    "Prepared statement did not survive session reset.");
+}
+
+
+
+void test_connection_pool_bad_statement()
+{
+  pqxx::connection_pool_config config;
+  config.max_size = 1;
+  config.checkout_timeout = std::chrono::milliseconds{100};
+  pqxx::connection_pool pool{"", config};
+  pqxx::ignore_unused(pool.get());
+  PQXX_CHECK_EQUAL(pool.idle(), 1u, "Connection did not go idle.");
+
+  // Preparing this on the idle connection fails.  That must not cost us the
+  // pool's only slot.
+  pool.prepare("pool_broken", "SELECT * FROM pqxx_no_such_table");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pool.get()), pqxx::sql_error,
+    "Broken statement went unnoticed.");
+  PQXX_CHECK_EQUAL(
+    pool.size(), 0u, "Connection with failed statement still counts.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pool.get()), pqxx::sql_error,
+    "Pool lost a slot to a failed statement.");
+  PQXX_CHECK_EQUAL(pool.size(), 0u, "Pool leaked a slot.");
+}
+
+void test_connection_pool_shards()
+{
+  pqxx::connection_pool_config config;
+  config.min_size = 2;
+  config.max_size = 3;
+  config.shards = 2;
+  config.checkout_timeout = std::chrono::milliseconds{100};
+  pqxx::connection_pool pool{"", config};
+  PQXX_CHECK_EQUAL(pool.idle(), 2u, "Initial connections went missing.");
+
+  {
+    // One thread's shard holds only one of the connections.  For the second,
+    // the thread takes one from the other shard, rather than open a new one.
+    auto a{pool.get()};
+    auto b{pool.get()};
+    PQXX_CHECK_EQUAL(pool.size(), 2u, "Pool did not take from other shard.");
+    auto c{pool.get()};
+    PQXX_CHECK_EQUAL(pool.size(), 3u, "Pool did not grow.");
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(pool.get()), pqxx::failure,
+      "Sharded pool went over its maximum size.");
+  }
+  PQXX_CHECK_EQUAL(pool.idle(), 3u, "Connections did not come back.");
+
+  // A connection comes back to the shard of the thread that returns it, and
+  // threads waiting on another shard still get it.
+  std::vector<std::thread> threads;
+  std::vector<int> results(12);
+  for (std::size_t i{0}; i < std::size(results); ++i)
+    threads.emplace_back([&pool, &results, i] {
+      auto c{pool.get()};
+      pqxx::nontransaction tx{*c};
+      results[i] = tx.exec1("SELECT " + pqxx::to_string(i))[0].as<int>();
+    });
+  for (auto &t : threads) t.join();
+  for (std::size_t i{0}; i < std::size(results); ++i)
+    PQXX_CHECK_EQUAL(results[i], int(i), "Wrong result from sharded pool.");
+  PQXX_CHECK_EQUAL(pool.size(), pool.idle(), "Connections went missing.");
+}
+
+
+
+void test_connection_pool_maintenance()
+{
+  pqxx::connection_pool_config config;
+  config.max_size = 2;
+  config.min_idle = 2;
+  config.heartbeat = std::chrono::milliseconds{1};
+  // Long enough that only our own calls to maintain() matter.
+  config.maintenance_interval = std::chrono::hours{1};
+  config.checkout_timeout = std::chrono::milliseconds{100};
+  pqxx::connection_pool pool{"", config};
+  pool.prepare("pool_triple", "SELECT 3 * $1::integer");
+
+  pool.maintain();
+  PQXX_CHECK_EQUAL(pool.idle(), 2u, "Pool did not prewarm connections.");
+
+  // Kill one of the pool's connections from the outside.
+  int pid;
+  {
+    auto c{pool.get()};
+    pqxx::nontransaction tx{*c};
+    pid = tx.exec1("SELECT pg_backend_pid()")[0].as<int>();
+  }
+  {
+    pqxx::connection killer;
+    pqxx::nontransaction tx{killer};
+    tx.exec1("SELECT pg_terminate_backend(" + pqxx::to_string(pid) + ")");
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+  // The heartbeat finds the dead connection, and the pool replaces it.
+  pool.maintain();
+  PQXX_CHECK_EQUAL(pool.size(), 2u, "Pool did not replace dead connection.");
+  PQXX_CHECK_EQUAL(pool.idle(), 2u, "Replacement is not idle.");
+  for (int i{0}; i < 2; ++i)
+  {
+    auto c{pool.get()};
+    pqxx::nontransaction tx{*c};
+    PQXX_CHECK_NOT_EQUAL(
+      tx.exec1("SELECT pg_backend_pid()")[0].as<int>(), pid,
+      "Pool handed out a dead connection.");
+    PQXX_CHECK_EQUAL(
+      tx.exec_prepared1("pool_triple", 14)[0].as<int>(), 42,
+      "Prewarmed connection lacks prepared statement.");
+  }
+
+  config.min_idle = 3;
+  PQXX_CHECK_THROWS(
+    pqxx::connection_pool("", config), pqxx::argument_error,
+    "Pool with minimum idle connections above its maximum was accepted.");
+}
+
+
+void test_connection_pool_priority()
+{
+  pqxx::connection_pool_config config;
+  config.max_size = 1;
+  config.max_waiting = 2;
+  pqxx::connection_pool pool{"", config};
+  auto const interactive{pqxx::pool_priority::interactive},
+    batch{pqxx::pool_priority::batch};
+
+  auto held{pool.get()};
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pool.get(batch, std::chrono::milliseconds{10})),
+    pqxx::failure, "Checkout did not time out.");
+  PQXX_CHECK_EQUAL(pool.stats(batch).timeouts, 1u, "Timeout not counted.");
+
+  // Wait until the pool has this many callers in line.
+  auto const await_waiting{[&pool](pqxx::pool_priority p, std::size_t n) {
+    for (int i{0}; pool.stats(p).waiting != n; ++i)
+    {
+      PQXX_CHECK(i < 1000, "Caller never joined the queue.");
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+  }};
+
+  std::mutex mutex;
+  std::vector<std::string> order;
+  auto const borrow{[&pool, &mutex, &order](
+                      pqxx::pool_priority p, std::string name) {
+    auto c{pool.get(p, std::chrono::milliseconds{0})};
+    std::lock_guard<std::mutex> const lock{mutex};
+    order.push_back(name);
+  }};
+
+  // A batch caller gets in line first, but the interactive one goes first.
+  std::thread first{borrow, batch, "batch"};
+  await_waiting(batch, 1);
+  std::thread second{borrow, interactive, "interactive"};
+  await_waiting(interactive, 1);
+
+  // The queue is full.
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pool.get()), pqxx::failure,
+    "Wait queue was not bounded.");
+  PQXX_CHECK_EQUAL(
+    pool.stats(interactive).rejections, 1u, "Rejection not counted.");
+
+  held.give_back();
+  first.join();
+  second.join();
+  PQXX_CHECK_EQUAL(std::size(order), 2u, "Lost a caller.");
+  PQXX_CHECK_EQUAL(order[0], "interactive", "Priority was not respected.");
+  PQXX_CHECK_EQUAL(order[1], "batch", "Batch caller went missing.");
+
+  auto const stats{pool.stats(batch)};
+  PQXX_CHECK_EQUAL(stats.checkouts, 1u, "Wrong checkout count.");
+  PQXX_CHECK_EQUAL(stats.waits, 1u, "Wrong wait count.");
+  PQXX_CHECK_EQUAL(stats.waiting, 0u, "Caller still waiting.");
+  PQXX_CHECK(stats.max_wait.count() > 0, "No wait time recorded.");
+}
+
+PQXX_REGISTER_TEST(test_connection_pool_config);
+PQXX_REGISTER_TEST(test_connection_pool);
+PQXX_REGISTER_TEST(test_connection_pool_reset);
+PQXX_REGISTER_TEST(test_connection_pool_bad_statement);
+PQXX_REGISTER_TEST(test_connection_pool_shards);
+PQXX_REGISTER_TEST(test_connection_pool_maintenance);
+PQXX_REGISTER_TEST(test_connection_pool_priority);
+} // namespace
@@ -0,0 +1,115 @@
+#include <pqxx/connection_router>
+#include <pqxx/nontransaction>
+#include <pqxx/robusttransaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+static_assert(
+  pqxx::internal::is_read_only_transaction<pqxx::read_transaction>);
+static_assert(not pqxx::internal::is_read_only_transaction<pqxx::work>);
+static_assert(
+  not pqxx::internal::is_read_only_transaction<pqxx::robusttransaction<>>);
+static_assert(
+  not pqxx::internal::is_read_only_transaction<pqxx::nontransaction>);
+
+
+void test_connection_router_offline()
+{
+  std::string const nowhere{"host=/nonexistent/pqxx/socket/dir"};
+  pqxx::connection_router router{nowhere, {nowhere, nowhere}};
+  PQXX_CHECK_EQUAL(std::size(router.replicas()), 2u, "Lost replicas.");
+  for (auto const &status : router.replicas())
+    PQXX_CHECK(status.up, "Replica starts out as down.");
+
+  // Both replicas fail, and so does the fallback to the primary.
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(router.get<pqxx::read_transaction>()),
+    pqxx::broken_connection, "Router hid a failure to connect.");
+  for (auto const &status : router.replicas())
+    PQXX_CHECK(not status.up, "Unreachable replica is still up.");
+}
+
+
+void test_connection_router()
+{
+  std::string const nowhere{"host=/nonexistent/pqxx/socket/dir"};
+  pqxx::connection_router router{"", {"", nowhere}};
+
+  {
+    auto conn{router.get<pqxx::read_transaction>()};
+    pqxx::read_transaction tx{*conn};
+    PQXX_CHECK_EQUAL(
+      tx.query_value<int>("SELECT 1"), 1, "Replica connection is useless.");
+  }
+  auto const statuses{router.replicas()};
+  PQXX_CHECK(statuses[0].up, "Working replica is down.");
+  PQXX_CHECK(statuses[0].latency.count() > 0, "Latency was not measured.");
+  PQXX_CHECK(not statuses[1].up, "Broken replica is up.");
+
+  {
+    auto conn{router.get<pqxx::work>()};
+    pqxx::work tx{*conn};
+    PQXX_CHECK_EQUAL(
+      tx.query_value<int>("SELECT 2"), 2, "Primary connection is useless.");
+  }
+
+  // With no replica fit for work, reads go to the primary.
+  pqxx::connection_router_config config;
+  config.max_lag = std::chrono::milliseconds{-1};
+  pqxx::connection_router strict{"", {""}, config};
+  auto conn{strict.replica()};
+  pqxx::read_transaction tx{*conn};
+  PQXX_CHECK_EQUAL(tx.query_value<int>("SELECT 3"), 3, "No fallback.");
+}
+
+
+void test_connection_router_read_your_writes()
+{
+  pqxx::connection_router router{"", {""}};
+
+  pqxx::lsn commit;
+  {
+    auto conn{router.primary()};
+    pqxx::work tx{*conn};
+    tx.capture_commit_lsn();
+    tx.exec0("CREATE TEMP TABLE pqxx_ryw (x integer)");
+    PQXX_CHECK_EQUAL(tx.commit_lsn(), 0u, "Commit position before commit.");
+    tx.commit();
+    commit = tx.commit_lsn();
+    PQXX_CHECK(commit != 0u, "Did not capture commit position.");
+  }
+
+  {
+    // A transaction that never talked to the database has nothing to wait
+    // for.
+    auto conn{router.primary()};
+    pqxx::work tx{*conn, pqxx::begin_policy::deferred};
+    tx.capture_commit_lsn();
+    tx.commit();
+    PQXX_CHECK_EQUAL(tx.commit_lsn(), 0u, "Empty transaction got position.");
+  }
+
+  {
+    auto conn{router.primary()};
+    pqxx::nontransaction tx{*conn};
+    tx.capture_commit_lsn();
+    tx.commit();
+    PQXX_CHECK(
+      tx.commit_lsn() >= commit, "Nontransaction went back in the WAL.");
+  }
+
+  auto conn{router.get<pqxx::read_transaction>(commit)};
+  pqxx::read_transaction tx{*conn};
+  PQXX_CHECK_EQUAL(tx.query_value<int>("SELECT 4"), 4, "Bad connection.");
+  PQXX_CHECK(
+    router.replicas()[0].replayed >= commit,
+    "Router did not see the replica catch up.");
+}
+
+
+PQXX_REGISTER_TEST(test_connection_router_offline);
+PQXX_REGISTER_TEST(test_connection_router);
+PQXX_REGISTER_TEST(test_connection_router_read_your_writes);
+} // namespace
@@ -0,0 +1,130 @@
+#include <tuple>
+#include <vector>
+
+#include <pqxx/coroutine>
+#include <pqxx/nontransaction>
+#include <pqxx/stream_from>
+
+#include "../test_helpers.hxx"
+
+// These tests only exist when the tests build with coroutine support.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+namespace
+{
+/// The exception that escaped from the last @c task, if any.
+std::exception_ptr task_failure;
+
+
+/// Minimal coroutine type: starts right away, and runs as far as it can.
+struct task
+{
+  struct promise_type
+  {
+    task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept
+    {
+      task_failure = std::current_exception();
+    }
+  };
+};
+
+
+/// Run the reactor until it's done, and rethrow any failure in a task.
+void finish(pqxx::reactor &r)
+{
+  r.run();
+  if (task_failure)
+    std::rethrow_exception(std::exchange(task_failure, nullptr));
+}
+
+
+task query_all(pqxx::reactor &r, pqxx::connection &c, std::vector<int> &got)
+{
+  got.push_back((co_await pqxx::async_exec(r, c, "SELECT 1"))[0][0].as<int>());
+  got.push_back(
+    (co_await pqxx::async_exec_params(r, c, "SELECT $1::integer", 2))[0][0]
+      .as<int>());
+  got.push_back(
+    (co_await pqxx::async_exec_prepared(r, c, "coro_triple", 1))[0][0]
+      .as<int>());
+}
+
+
+void test_coroutine_exec()
+{
+  pqxx::connection c;
+  c.prepare("coro_triple", "SELECT 3 * $1::integer");
+  pqxx::reactor r;
+  r.add(c);
+
+  std::vector<int> got;
+  query_all(r, c, got);
+  finish(r);
+  PQXX_CHECK_EQUAL(std::size(got), 3u, "Coroutine did not finish.");
+  PQXX_CHECK_EQUAL(got[0], 1, "Bad result from async_exec().");
+  PQXX_CHECK_EQUAL(got[1], 2, "Bad result from async_exec_params().");
+  PQXX_CHECK_EQUAL(got[2], 3, "Bad result from async_exec_prepared().");
+}
+
+
+task query_error(pqxx::reactor &r, pqxx::connection &c, bool &caught)
+{
+  try
+  {
+    co_await pqxx::async_exec(r, c, "SELECT nonexistent_column_in_coro_test");
+  }
+  catch (pqxx::sql_error const &)
+  {
+    caught = true;
+  }
+}
+
+
+void test_coroutine_error()
+{
+  pqxx::connection c;
+  pqxx::reactor r;
+  r.add(c);
+
+  bool caught{false};
+  query_error(r, c, caught);
+  finish(r);
+  PQXX_CHECK(caught, "Failing query did not throw into the coroutine.");
+}
+
+
+task read_stream(
+  pqxx::reactor &r, pqxx::connection &c, pqxx::stream_from &s, int &total)
+{
+  std::tuple<int> row;
+  while (co_await pqxx::async_read(r, c, s, row)) total += std::get<0>(row);
+  s.complete();
+}
+
+
+void test_coroutine_stream()
+{
+  pqxx::connection c;
+  pqxx::nontransaction tx{c};
+  auto s{pqxx::stream_from::query(tx, "SELECT * FROM generate_series(1, 10)")};
+  pqxx::reactor r;
+  r.add(c);
+
+  int total{0};
+  read_stream(r, c, s, total);
+  while (s and not task_failure) r.poll(std::chrono::milliseconds{100});
+  finish(r);
+  PQXX_CHECK_EQUAL(total, 55, "Coroutine read wrong data from stream.");
+}
+
+
+PQXX_REGISTER_TEST(test_coroutine_exec);
+PQXX_REGISTER_TEST(test_coroutine_error);
+PQXX_REGISTER_TEST(test_coroutine_stream);
+} // namespace
+
+#endif
@@ -0,0 +1,185 @@
+#include <cstdio>
+#include <fstream>
+#include <optional>
+
+#include <pqxx/csv_loader>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+/// Parse a record without doubled quotes, so it needs no workspace.
+std::vector<pqxx::internal::csv_field>
+parse_record(std::string_view text, pqxx::csv_options const &options = {})
+{
+  std::vector<pqxx::internal::csv_field> fields;
+  std::string workspace;
+  std::size_t here{0};
+  PQXX_CHECK(
+    pqxx::internal::next_csv_record(text, here, options, fields, workspace),
+    "No CSV record found.");
+  PQXX_CHECK_EQUAL(here, text.size(), "CSV record did not end at the end.");
+  return fields;
+}
+
+
+void test_next_csv_record()
+{
+  auto const plain{parse_record("1,abc,\n")};
+  PQXX_CHECK_EQUAL(plain.size(), 3u, "Wrong number of fields.");
+  PQXX_CHECK_EQUAL(std::string{plain[0].text}, "1", "Bad first field.");
+  PQXX_CHECK_EQUAL(std::string{plain[1].text}, "abc", "Bad middle field.");
+  PQXX_CHECK(plain[2].text.empty(), "Empty field was not empty.");
+  PQXX_CHECK(not plain[2].quoted, "Empty field was quoted.");
+
+  auto const crlf{parse_record("a,\"b\"\r\n")};
+  PQXX_CHECK_EQUAL(crlf.size(), 2u, "CRLF confused the parser.");
+  PQXX_CHECK_EQUAL(std::string{crlf[1].text}, "b", "Bad field before CRLF.");
+  PQXX_CHECK(crlf[1].quoted, "Quoted field was not marked.");
+
+  auto const last{parse_record("x,y\r")};
+  PQXX_CHECK_EQUAL(std::string{last[1].text}, "y", "Trailing CR stayed.");
+
+  std::string const tricky{"\"a,b\",\"say \"\"hi\"\"\",\"\",\"1\n2\"\n"};
+  std::vector<pqxx::internal::csv_field> fields;
+  std::string workspace;
+  std::size_t here{0};
+  PQXX_CHECK(
+    pqxx::internal::next_csv_record(tricky, here, {}, fields, workspace),
+    "Quoted CSV record not found.");
+  PQXX_CHECK_EQUAL(here, tricky.size(), "Quoted record ended early.");
+  PQXX_CHECK_EQUAL(fields.size(), 4u, "Wrong number of quoted fields.");
+  PQXX_CHECK_EQUAL(std::string{fields[0].text}, "a,b", "Quoted delimiter.");
+  PQXX_CHECK_EQUAL(
+    std::string{fields[1].text}, "say \"hi\"", "Doubled quotes went wrong.");
+  PQXX_CHECK(
+    fields[2].text.empty() and fields[2].quoted, "Quoted empty field.");
+  PQXX_CHECK_EQUAL(std::string{fields[3].text}, "1\n2", "Quoted newline.");
+  PQXX_CHECK(
+    not pqxx::internal::next_csv_record(tricky, here, {}, fields, workspace),
+    "Found a record past the end.");
+
+  pqxx::csv_options tsv;
+  tsv.delimiter = '\t';
+  auto const tabs{parse_record("a\tb,c\n", tsv)};
+  PQXX_CHECK_EQUAL(tabs.size(), 2u, "Tab delimiter went wrong.");
+  PQXX_CHECK_EQUAL(std::string{tabs[1].text}, "b,c", "Comma in TSV field.");
+
+  for (std::string_view bad : {"\"abc\n", "ab\"c\n", "\"ab\"c\n"})
+  {
+    std::size_t start{0};
+    PQXX_CHECK_THROWS(
+      pqxx::internal::next_csv_record(bad, start, {}, fields, workspace),
+      pqxx::conversion_error, "Malformed CSV went unnoticed.");
+  }
+}
+
+
+void test_encode_csv_chunk()
+{
+  std::string out;
+  std::size_t records{0};
+  pqxx::internal::encode_csv_chunk<int, std::string, std::optional<double>>(
+    "1,a\tb,2.5\n2,\"x\\y\",\n", {}, out, records);
+  PQXX_CHECK_EQUAL(records, 2u, "Wrong record count.");
+  PQXX_CHECK_EQUAL(
+    out, "1\ta\\tb\t2.5\n2\tx\\\\y\t\\N\n", "Bad COPY encoding of CSV.");
+
+  out.clear();
+  records = 0;
+  PQXX_CHECK_THROWS(
+    (pqxx::internal::encode_csv_chunk<int, int>(
+      "1,2\n3,x\n", {}, out, records)),
+    pqxx::conversion_error, "Bad integer went unnoticed.");
+  PQXX_CHECK_EQUAL(records, 1u, "Wrong count of records before error.");
+  PQXX_CHECK_THROWS(
+    (pqxx::internal::encode_csv_chunk<int, int>("1\n", {}, out, records)),
+    pqxx::conversion_error, "Missing field went unnoticed.");
+  PQXX_CHECK_THROWS(
+    (pqxx::internal::encode_csv_chunk<int>(",\n", {}, out, records)),
+    pqxx::conversion_error, "Null in non-nullable type went unnoticed.");
+}
+
+
+void test_csv_loader()
+{
+  char const name[]{"pqxx-test-csv-loader.csv"};
+  std::string csv{"id,name\n"};
+  for (int n{1}; n <= 5000; ++n)
+    csv += pqxx::to_string(n) + ((n % 10 == 0) ? std::string{",\n"} :
+                                                 ",\"n,\"\"" +
+                                                   pqxx::to_string(n) +
+                                                   "\"\"\"\n");
+  std::ofstream{name, std::ios::binary} << csv;
+
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE csv_in (id integer, name text)");
+  pqxx::csv_options options;
+  options.header = true;
+  options.threads = 4;
+  // Small chunks, so each thread gets plenty of them.
+  options.chunk_size = 1000;
+
+  std::size_t loaded{0};
+  try
+  {
+    pqxx::stream_to stream{tx, "csv_in"};
+    loaded = pqxx::csv_loader{stream, options}.load<int, std::string>(name);
+    stream.complete();
+  }
+  catch (...)
+  {
+    std::remove(name);
+    throw;
+  }
+  std::remove(name);
+
+  PQXX_CHECK_EQUAL(loaded, 5000u, "Wrong number of records loaded.");
+  auto const check{tx.exec1(
+    "SELECT count(*), sum(id), count(name), "
+    "count(*) FILTER (WHERE name = 'n,\"' || id || '\"') FROM csv_in")};
+  PQXX_CHECK_EQUAL(check[0].as<int>(), 5000, "Wrong row count.");
+  PQXX_CHECK_EQUAL(check[1].as<long>(), 12502500L, "Wrong ids.");
+  PQXX_CHECK_EQUAL(check[2].as<int>(), 4500, "Wrong nulls.");
+  PQXX_CHECK_EQUAL(check[3].as<int>(), 4500, "Wrong names.");
+}
+
+
+void test_csv_loader_reports_record()
+{
+  char const name[]{"pqxx-test-csv-loader-bad.csv"};
+  std::string csv;
+  for (int n{1}; n <= 1000; ++n)
+    csv += (n == 777) ? std::string{"x\n"} : pqxx::to_string(n) + "\n";
+  std::ofstream{name, std::ios::binary} << csv;
+
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE csv_bad (id integer)");
+  pqxx::stream_to stream{tx, "csv_bad"};
+  pqxx::csv_options options;
+  options.threads = 3;
+  options.chunk_size = 100;
+  std::string message;
+  try
+  {
+    pqxx::csv_loader{stream, options}.load<int>(name);
+  }
+  catch (pqxx::conversion_error const &e)
+  {
+    message = e.what();
+  }
+  std::remove(name);
+  PQXX_CHECK(
+    message.find("CSV record 777:") != std::string::npos,
+    "Error did not name the bad record: '" + message + "'.");
+}
+
+
+PQXX_REGISTER_TEST(test_next_csv_record);
+PQXX_REGISTER_TEST(test_encode_csv_chunk);
+PQXX_REGISTER_TEST(test_csv_loader);
+PQXX_REGISTER_TEST(test_csv_loader_reports_record);
+} // namespace
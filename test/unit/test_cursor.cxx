@@ -1,3 +1,5 @@
+#include <chrono>
+
 #include "../test_helpers.hxx"
 
 namespace
@@ -36,11 +38,133 @@ void test_stateless_cursor_ignores_trailing_semicolon(
 }
 
 
+void test_icursorstream_prefetch(pqxx::connection_base &conn)
+{
+  pqxx::work tx{conn};
+  pqxx::icursorstream stream{
+    tx, "SELECT * FROM generate_series(1, 10)", "prefetch", 3};
+  PQXX_CHECK(not stream.prefetch(), "Prefetching is on by default.");
+  stream.set_prefetch();
+
+  pqxx::result block;
+  stream >> block;
+  PQXX_CHECK_EQUAL(block.size(), 3, "Wrong first block.");
+  PQXX_CHECK_EQUAL(block[0][0].as<int>(), 1, "Bad first row.");
+  PQXX_CHECK_THROWS(
+    tx.exec("SELECT 1"), pqxx::usage_error,
+    "Could execute a query while a block was in flight.");
+  PQXX_CHECK_THROWS(
+    stream.ignore(2), pqxx::usage_error,
+    "Could ignore part of a block in flight.");
+
+  stream.ignore(3);
+  stream >> block;
+  PQXX_CHECK_EQUAL(block.size(), 3, "Wrong block after ignore().");
+  PQXX_CHECK_EQUAL(block[0][0].as<int>(), 7, "Bad row after ignore().");
+
+  stream >> block;
+  PQXX_CHECK_EQUAL(block.size(), 1, "Wrong last block.");
+  PQXX_CHECK_EQUAL(block[0][0].as<int>(), 10, "Bad last row.");
+  PQXX_CHECK(stream, "Stream ended early.");
+  stream >> block;
+  PQXX_CHECK(block.empty(), "Read past the end.");
+  PQXX_CHECK(not stream, "Stream did not end.");
+
+  // With no block in flight, the transaction works again.
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 2"), 2, "Transaction stuck after prefetch.");
+
+  // Destroying a stream with a block in flight frees up the connection.
+  {
+    pqxx::icursorstream early{
+      tx, "SELECT * FROM generate_series(1, 10)", "early", 2};
+    early.set_prefetch();
+    early >> block;
+  }
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 3"), 3, "Connection stuck after prefetch.");
+}
+
+
+void test_icursorstream_adaptive_stride(pqxx::connection_base &conn)
+{
+  pqxx::work tx{conn};
+  pqxx::icursorstream stream{
+    tx, "SELECT n, repeat('x', 1000) FROM generate_series(1, 500) AS n",
+    "adaptive", 1};
+
+  pqxx::adaptive_stride policy;
+  policy.block_bytes = 50000;
+  policy.max_latency = std::chrono::steady_clock::duration::zero();
+  policy.max_stride = 200;
+  stream.set_stride(policy);
+
+  pqxx::result block;
+  stream >> block;
+  PQXX_CHECK_EQUAL(block.size(), 1, "First block ignored initial stride.");
+  PQXX_CHECK(stream.stride() > 1, "Stride did not grow.");
+  PQXX_CHECK(stream.stride() < 100, "Stride ignored the row size.");
+
+  int total{block[0][0].as<int>()};
+  int rows{1};
+  while (stream >> block, not block.empty())
+  {
+    rows += block.size();
+    for (auto const r : block) total += r[0].as<int>();
+  }
+  PQXX_CHECK_EQUAL(rows, 500, "Adaptive stride lost rows.");
+  PQXX_CHECK_EQUAL(total, 500 * 501 / 2, "Adaptive stride mixed up rows.");
+
+  PQXX_CHECK_THROWS(
+    stream.set_stride(pqxx::adaptive_stride{1000, {}, 10, 5}),
+    pqxx::argument_error, "Accepted empty stride range.");
+  stream.set_stride(7);
+  PQXX_CHECK_EQUAL(stream.stride(), 7, "Could not go back to fixed stride.");
+}
+
+
+void test_stateless_cursor_cache(pqxx::connection_base &conn)
+{
+  pqxx::work tx{conn};
+  pqxx::stateless_cursor<
+    pqxx::cursor_base::read_only, pqxx::cursor_base::owned>
+    c{tx, "SELECT * FROM generate_series(0, 24)", "cached", false};
+  c.set_cache(10, 2);
+
+  auto const check{[&c](int begin, int end) {
+    auto const r{c.retrieve(begin, end)};
+    PQXX_CHECK_EQUAL(r.size(), end - begin, "Wrong number of rows.");
+    for (int i{0}; i < end - begin; ++i)
+      PQXX_CHECK_EQUAL(r[i][0].as<int>(), begin + i, "Wrong row.");
+  }};
+
+  // Going forward, every other block comes from the cache.
+  check(0, 10);
+  check(10, 20);
+  check(20, 25);
+  // Going back over the blocks we have in the cache.
+  check(10, 20);
+  // Something that's not a block goes straight to the cursor.
+  check(5, 15);
+  // Going back, it reads ahead backwards.
+  check(0, 10);
+  check(20, 25);
+
+  c.set_cache(0);
+  check(3, 7);
+  PQXX_CHECK_THROWS(
+    c.set_cache(-1), pqxx::argument_error, "Accepted negative block size.");
+}
+
+
 void test_cursor()
 {
   pqxx::connection conn;
   test_stateless_cursor_provides_random_access(conn);
   test_stateless_cursor_ignores_trailing_semicolon(conn);
+  test_icursorstream_prefetch(conn);
+  test_icursorstream_adaptive_stride(conn);
+  test_stateless_cursor_cache(conn);
 }
 
 
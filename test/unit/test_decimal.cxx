@@ -0,0 +1,129 @@
+#include <pqxx/decimal>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+using namespace std::literals;
+
+namespace
+{
+using money = pqxx::decimal<2>;
+
+
+void test_decimal_text()
+{
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<money>("123.45").units(), 12345LL, "Bad parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<money>("-0.5").units(), -50LL, "Bad negative parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<money>("7").units(), 700LL, "Bad whole number.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<money>("1.2300").units(), 123LL,
+    "Trailing zeroes beyond the scale did not parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<money>("-92233720368547758.08").units(),
+    std::numeric_limits<long long>::min(), "Bad lowest value.");
+
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(money::from_units(12345)), "123.45", "Bad to_string.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(money::from_units(-5)), "-0.05", "Bad small negative.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(pqxx::decimal<0>::from_units(-42)), "-42",
+    "Bad decimal without fraction.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(
+      pqxx::decimal<18>::from_units(std::numeric_limits<long long>::min())),
+    "-9.223372036854775808", "Bad extreme decimal.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<money>("1.234")),
+    pqxx::conversion_error, "Lost precision went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<money>("92233720368547758.08")),
+    pqxx::range_error, "Overflow went unnoticed.");
+  for (auto const bad : {"", "-", ".", "1.2.3", "NaN", "1e5", " 1"})
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(pqxx::from_string<money>(bad)),
+      pqxx::conversion_error, "Bad decimal went unnoticed.");
+}
+
+
+/// Encode @c value in binary, and decode it again.
+template<int SCALE> std::string to_binary(pqxx::decimal<SCALE> value)
+{
+  using traits = pqxx::binary_traits<pqxx::decimal<SCALE>>;
+  std::string buf(traits::binary_size(value), '\0');
+  auto const end{
+    traits::into_binary(buf.data(), buf.data() + buf.size(), value)};
+  PQXX_CHECK(
+    end == buf.data() + buf.size(), "Binary size was not what we wrote.");
+  PQXX_CHECK(
+    traits::from_binary(buf) == value,
+    "Binary decimal did not round-trip.");
+  return buf;
+}
+
+
+void test_decimal_binary()
+{
+  // 12345.67 is base-10000 digits 1, 2345, 6700, with weight 1.
+  PQXX_CHECK_EQUAL(
+    to_binary(money::from_units(1234567)),
+    "\0\3\0\1\0\0\0\2\0\1\x09\x29\x1a\x2c"s, "Bad binary numeric.");
+  PQXX_CHECK_EQUAL(
+    to_binary(money::from_units(0)), "\0\0\0\0\0\0\0\2"s,
+    "Bad binary zero.");
+  // -0.05 is the digit 500, with weight -1.
+  PQXX_CHECK_EQUAL(
+    to_binary(money::from_units(-5)), "\0\1\xff\xff\x40\0\0\2\x01\xf4"s,
+    "Bad negative binary numeric.");
+  // 10000 (scale 0) is digit 1 with weight 1; the zero group gets dropped.
+  PQXX_CHECK_EQUAL(
+    to_binary(pqxx::decimal<0>::from_units(10000)), "\0\1\0\1\0\0\0\0\0\1"s,
+    "Bad binary numeric with trailing zero digit.");
+  for (auto const units :
+       {std::numeric_limits<long long>::min(),
+        std::numeric_limits<long long>::max(), 1LL, -1LL})
+  {
+    to_binary(pqxx::decimal<0>::from_units(units));
+    to_binary(pqxx::decimal<3>::from_units(units));
+    to_binary(pqxx::decimal<18>::from_units(units));
+  }
+
+  // 0.123 does not fit in two decimal places.
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::binary_traits<money>::from_binary(
+      "\0\1\xff\xff\0\0\0\3\x04\xce"sv)),
+    pqxx::conversion_error, "Binary precision loss went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::binary_traits<money>::from_binary("\0\0\0\0\xc0\0\0\0"sv)),
+    pqxx::conversion_error, "Binary NaN went unnoticed.");
+}
+
+
+void test_decimal_from_server()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const r{tx.exec_params_binary(
+    "SELECT 12345.67::numeric, $1::numeric(20, 2), -0.01::numeric(5, 2)",
+    money::from_units(-98765))};
+  PQXX_CHECK_EQUAL(
+    r[0][0].as<money>().units(), 1234567LL, "Bad binary numeric.");
+  PQXX_CHECK_EQUAL(
+    r[0][1].as<money>().units(), -98765LL, "Bad numeric parameter.");
+  PQXX_CHECK_EQUAL(
+    r[0][2].as<money>().units(), -1LL, "Bad small numeric.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<money>("SELECT 1.50::numeric(10, 2)").units(), 150LL,
+    "Bad text numeric.");
+}
+
+
+PQXX_REGISTER_TEST(test_decimal_text);
+PQXX_REGISTER_TEST(test_decimal_binary);
+PQXX_REGISTER_TEST(test_decimal_from_server);
+} // namespace
@@ -99,6 +99,100 @@ void test_for_glyphs_utf8()
 }
 
 
+void test_find_utf8()
+{
+  using pqxx::internal::encoding_group;
+  using pqxx::internal::find_with_encoding;
+  auto const utf8{encoding_group::UTF8};
+
+  // Long enough to take the 8-bytes-at-a-time path, with multibyte
+  // characters on either side of block boundaries.
+  std::string const text{
+    "abcdefghijklmno\xe0\xb8\x95pqrstuvwxyz\xc3\xa9\tend"};
+  PQXX_CHECK_EQUAL(
+    find_with_encoding(utf8, text, '\t'), text.find('\t'),
+    "Wrong position for tab.");
+  PQXX_CHECK_EQUAL(
+    find_with_encoding(utf8, text, '\t', text.find('\t') + 1),
+    std::string::npos, "Found nonexistent tab.");
+  PQXX_CHECK_EQUAL(
+    find_with_encoding(utf8, text, std::string_view{"xyz"}), text.find("xyz"),
+    "Wrong position for string.");
+  PQXX_CHECK_EQUAL(
+    find_with_encoding(utf8, text, std::string_view{"\xc3\xa9"}),
+    text.find("\xc3\xa9"), "Wrong position for multibyte string.");
+
+  // Invalid UTF-8 before the needle still gets noticed.
+  std::string const bad{"abcdefghijklmnop\xc3xyz\t"};
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(find_with_encoding(utf8, bad, '\t')),
+    pqxx::argument_error, "Invalid UTF-8 went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      find_with_encoding(utf8, bad, std::string_view{"yz"})),
+    pqxx::argument_error, "Invalid UTF-8 went unnoticed in string search.");
+
+  PQXX_CHECK_EQUAL(
+    find_with_encoding(encoding_group::MONOBYTE, bad, '\t'), bad.size() - 1,
+    "Wrong position in single-byte encoding.");
+}
+
+
+void test_with_encoding()
+{
+  using pqxx::internal::encoding_group;
+  auto const group{pqxx::internal::with_encoding(
+    encoding_group::EUC_KR, [](auto e) { return decltype(e)::value; })};
+  PQXX_CHECK(
+    group == encoding_group::EUC_KR,
+    "with_encoding() passed the wrong encoding group.");
+
+  std::string const text{"a\xc3\xa9z"};
+  std::string::size_type glyphs{0};
+  pqxx::internal::for_glyphs<encoding_group::UTF8>(
+    [&glyphs](char const *, char const *) { ++glyphs; }, text.data(),
+    text.size());
+  PQXX_CHECK_EQUAL(glyphs, 3u, "Specialised for_glyphs() miscounted.");
+  PQXX_CHECK_EQUAL(
+    pqxx::internal::glyph_scanner<encoding_group::UTF8>::call(
+      text.data(), text.size(), 1),
+    3u, "Inline UTF-8 scanner got multibyte character wrong.");
+}
+
+
+void test_trusted_encoding()
+{
+  using pqxx::internal::encoding_group;
+  PQXX_CHECK(
+    pqxx::internal::is_ascii_safe(encoding_group::UTF8),
+    "UTF-8 is not ASCII-safe.");
+  PQXX_CHECK(
+    not pqxx::internal::is_ascii_safe(encoding_group::SJIS),
+    "SJIS is ASCII-safe.");
+
+  pqxx::connection conn;
+  PQXX_CHECK(not conn.trusts_encoding(), "Connection starts out trusting.");
+  conn.set_client_encoding("UTF8");
+  conn.trust_encoding();
+  PQXX_CHECK(conn.trusts_encoding(), "trust_encoding() did not stick.");
+
+  // Parsing still finds the right delimiters around multibyte characters.
+  pqxx::work tx{conn};
+  auto const r{tx.exec1("SELECT ARRAY['\xc3\xa9t\xc3\xa9', 'x,y']")};
+  auto parser{r[0].as_array()};
+  PQXX_CHECK(
+    parser.get_next().first == pqxx::array_parser::juncture::row_start,
+    "Array did not start.");
+  PQXX_CHECK_EQUAL(
+    parser.get_next().second, "\xc3\xa9t\xc3\xa9",
+    "Bad multibyte element.");
+  PQXX_CHECK_EQUAL(parser.get_next().second, "x,y", "Bad quoted element.");
+
+  conn.trust_encoding(false);
+  PQXX_CHECK(not conn.trusts_encoding(), "Could not stop trusting.");
+}
+
+
 void test_encodings()
 {
   test_scan_ascii();
@@ -106,8 +200,11 @@ void test_encodings()
   test_for_glyphs_empty();
   test_for_glyphs_ascii();
   test_for_glyphs_utf8();
+  test_find_utf8();
+  test_with_encoding();
 }
 
 
 PQXX_REGISTER_TEST(test_encodings);
+PQXX_REGISTER_TEST(test_trusted_encoding);
 } // namespace
@@ -199,6 +199,55 @@ void test_get_errorhandlers(pqxx::connection_base &c)
 }
 
 
+class NoticeFieldsHandler final : public pqxx::errorhandler
+{
+public:
+  explicit NoticeFieldsHandler(pqxx::connection_base &c) :
+          pqxx::errorhandler(c)
+  {}
+  bool operator()(char const msg[]) noexcept override
+  {
+    message = msg;
+    return true;
+  }
+  bool on_notice(pqxx::notice const &n) noexcept override
+  {
+    severity = n.severity;
+    sqlstate = n.sqlstate;
+    primary = n.primary;
+    hint = n.hint;
+    return errorhandler::on_notice(n);
+  }
+
+  std::string message, severity, sqlstate, primary, hint;
+};
+
+
+void test_notice_fields(pqxx::connection_base &c)
+{
+  NoticeFieldsHandler handler{c};
+  pqxx::nontransaction tx{c};
+  tx.exec0(
+    "DO $$ BEGIN RAISE NOTICE 'Hello' USING HINT = 'Wave back.'; END $$");
+  PQXX_CHECK_EQUAL(handler.severity, "NOTICE", "Wrong severity.");
+  PQXX_CHECK_EQUAL(handler.sqlstate, "00000", "Wrong SQLSTATE.");
+  PQXX_CHECK_EQUAL(handler.primary, "Hello", "Wrong primary message.");
+  PQXX_CHECK_EQUAL(handler.hint, "Wave back.", "Wrong hint.");
+  PQXX_CHECK(
+    handler.message.find("Hello") != std::string::npos,
+    "Full message did not reach the errorhandler.");
+  PQXX_CHECK(
+    handler.message.back() == '\n', "Full message does not end in newline.");
+
+  // A message without newline gets one, and a client-side message doesn't go
+  // through on_notice().
+  handler.severity.clear();
+  c.process_notice("No newline");
+  PQXX_CHECK_EQUAL(handler.message, "No newline\n", "Bad newline handling.");
+  PQXX_CHECK_EQUAL(handler.severity, "", "Client notice went to on_notice.");
+}
+
+
 void test_errorhandler()
 {
   pqxx::connection conn;
@@ -208,6 +257,7 @@ void test_errorhandler()
   test_destroyed_error_handlers_are_not_called(conn);
   test_destroying_connection_unregisters_handlers();
   test_get_errorhandlers(conn);
+  test_notice_fields(conn);
 }
 
 
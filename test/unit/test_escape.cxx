@@ -1,4 +1,5 @@
 #include <iostream>
+#include <vector>
 
 #include "../test_helpers.hxx"
 
@@ -108,6 +109,49 @@ void test_esc_like(pqxx::transaction_base &tx)
 }
 
 
+void test_escape_into(pqxx::connection &c)
+{
+  std::vector<char> buf(1000);
+  auto const begin{buf.data()}, end{begin + std::size(buf)};
+
+  auto here{c.quote_into(42, begin, end)};
+  here[-1] = ',';
+  here = c.quote_into(std::string{"it's"}, here, end);
+  here[-1] = ',';
+  here = c.quote_into(nullptr, here, end);
+  PQXX_CHECK_EQUAL(
+    std::string(begin), "'42','it''s',NULL",
+    "quote_into() does not compose.");
+  PQXX_CHECK_EQUAL(
+    std::string(begin, here - 1),
+    c.quote(42) + "," + c.quote("it's") + ",NULL",
+    "quote_into() differs from quote().");
+
+  here = c.esc_into("a'b", begin, end);
+  PQXX_CHECK_EQUAL(std::string(begin), c.esc("a'b"), "Bad esc_into().");
+  PQXX_CHECK(here == begin + 5, "Bad esc_into() return value.");
+
+  c.quote_name_into("x\"y", begin, end);
+  PQXX_CHECK_EQUAL(
+    std::string(begin), c.quote_name("x\"y"), "Bad quote_name_into().");
+  PQXX_CHECK_EQUAL(
+    std::string(begin), "\"x\"\"y\"", "Bad identifier quoting.");
+
+  c.esc_like_into("a%b_", begin, end);
+  PQXX_CHECK_EQUAL(std::string(begin), "a\\%b\\_", "Bad esc_like_into().");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(c.quote_into(123456789, begin, begin + 5)),
+    pqxx::conversion_overrun, "quote_into() overran its buffer.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(c.esc_into("abc", begin, begin + 3)),
+    pqxx::conversion_overrun, "esc_into() overran its buffer.");
+  PQXX_CHECK_EQUAL(
+    pqxx::connection::size_quote(std::string{"xyz"}), 9u,
+    "Unexpected size_quote().");
+}
+
+
 void test_escaping()
 {
   pqxx::connection conn;
@@ -117,6 +161,7 @@ void test_escaping()
   test_quote_name(tx);
   test_esc_raw_unesc_raw(tx);
   test_esc_like(tx);
+  test_escape_into(conn);
 }
 
 
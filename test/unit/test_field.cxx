@@ -45,5 +45,48 @@ void test_field()
 }
 
 
+void test_field_views()
+{
+  pqxx::connection c;
+  pqxx::work tx{c};
+  auto const r{tx.exec("SELECT 'abc', NULL")};
+  auto const f{r[0][0]};
+
+  auto const sv{f.as<std::string_view>()};
+  PQXX_CHECK(sv == "abc", "as<string_view>() is broken.");
+  PQXX_CHECK(std::data(sv) == f.c_str(), "string_view copied its data.");
+
+  auto const zv{f.as<pqxx::zview>()};
+  PQXX_CHECK_EQUAL(std::string{zv.c_str()}, "abc", "as<zview>() is broken.");
+
+  PQXX_CHECK(
+    not r[0][1].get<std::string_view>().has_value(),
+    "Null did not become an empty optional<string_view>.");
+  PQXX_CHECK(
+    *f.get<std::string_view>() == "abc", "get<string_view>() is broken.");
+
+  auto const [a, b]{r[0].as<std::string_view, std::optional<pqxx::zview>>()};
+  PQXX_CHECK(a == "abc", "row::as<string_view>() is broken.");
+  PQXX_CHECK(not b.has_value(), "row::as<optional<zview>>() is broken.");
+}
+
+
+void test_string_view_from_string()
+{
+  std::string const text{"view me"};
+  auto const sv{pqxx::from_string<std::string_view>(text)};
+  PQXX_CHECK(sv == text, "Conversion to string_view is broken.");
+  PQXX_CHECK(
+    std::data(sv) == std::data(text), "Conversion to string_view copied.");
+  auto const zv{pqxx::from_string<pqxx::zview>(text)};
+  PQXX_CHECK(zv.c_str() == text.c_str(), "Conversion to zview copied.");
+  PQXX_CHECK(
+    *pqxx::from_string<std::optional<std::string_view>>(text) == text,
+    "Conversion to optional<string_view> is broken.");
+}
+
+
 PQXX_REGISTER_TEST(test_field);
+PQXX_REGISTER_TEST(test_field_views);
+PQXX_REGISTER_TEST(test_string_view_from_string);
 } // namespace
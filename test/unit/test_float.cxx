@@ -1,3 +1,6 @@
+#include <cmath>
+#include <limits>
+
 #include "../test_helpers.hxx"
 
 namespace
@@ -84,6 +87,54 @@ void test_bug_262()
 }
 
 
+/// Check that a value survives conversion to text and back, exactly.
+template<typename T> void round_trip(T value)
+{
+  auto const text{pqxx::to_string(value)};
+  // The bounds are a half-open range, so this only accepts the exact value.
+  PQXX_CHECK_BOUNDS(
+    pqxx::from_string<T>(text), value,
+    std::nextafter(value, std::numeric_limits<T>::infinity()),
+    "Floating-point value changed in conversion to '" + text + "'.");
+}
+
+
+template<typename T> void conversion_test()
+{
+  round_trip(T(0));
+  round_trip(T(-1.5));
+  round_trip(T(0.1));
+  round_trip(T(1) / T(3));
+  round_trip(std::numeric_limits<T>::max());
+  round_trip(std::numeric_limits<T>::min());
+
+  PQXX_CHECK_BOUNDS(
+    pqxx::from_string<T>("2.5e3"), T(2499.9), T(2500.1),
+    "Bad exponent parsing.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<T>("1.5x")),
+    pqxx::conversion_error, "Trailing garbage went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<T>(" 1.5")),
+    pqxx::conversion_error, "Leading whitespace went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<T>("0x10")),
+    pqxx::conversion_error, "Hexadecimal float went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<T>("")),
+    pqxx::conversion_error, "Empty string converted to a number.");
+}
+
+
+void test_float_conversion()
+{
+  conversion_test<float>();
+  conversion_test<double>();
+  conversion_test<long double>();
+}
+
+
 PQXX_REGISTER_TEST(test_infinities);
 PQXX_REGISTER_TEST(test_bug_262);
+PQXX_REGISTER_TEST(test_float_conversion);
 } // namespace
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pqxx/group_commit>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_group_commit()
+{
+  pqxx::connection setup;
+  pqxx::nontransaction{setup}.exec0(
+    "CREATE TABLE IF NOT EXISTS pqxx_group_commit (n integer)");
+  pqxx::nontransaction{setup}.exec0("TRUNCATE pqxx_group_commit");
+
+  std::size_t batches{0};
+  {
+    pqxx::connection cx;
+    pqxx::group_commit_policy policy;
+    policy.max_writes = 10;
+    policy.max_delay = std::chrono::milliseconds{50};
+    pqxx::group_commit group{cx, policy};
+
+    std::vector<std::future<void>> done;
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    for (int t{0}; t < 4; ++t)
+      threads.emplace_back([&group, &done, &lock, t] {
+        for (int i{0}; i < 5; ++i)
+        {
+          auto f{group.submit([n = t * 10 + i](pqxx::transaction_base &tx) {
+            tx.exec_params0("INSERT INTO pqxx_group_commit VALUES ($1)", n);
+          })};
+          std::lock_guard const guard{lock};
+          done.push_back(std::move(f));
+        }
+      });
+    for (auto &t : threads) t.join();
+    for (auto &f : done) f.get();
+    batches = group.batches();
+    PQXX_CHECK_EQUAL(group.pending(), 0u, "Writes left over.");
+  }
+
+  PQXX_CHECK(batches >= 2u, "20 writes fit in a 10-write batch.");
+  PQXX_CHECK(batches < 20u, "Writes did not get grouped.");
+  PQXX_CHECK_EQUAL(
+    pqxx::nontransaction{setup}.query_value<int>(
+      "SELECT count(*) FROM pqxx_group_commit"),
+    20, "Wrong number of rows written.");
+  pqxx::nontransaction{setup}.exec0("DROP TABLE pqxx_group_commit");
+}
+
+
+void test_group_commit_failures()
+{
+  pqxx::connection cx;
+  pqxx::group_commit_policy policy;
+  policy.max_delay = std::chrono::milliseconds{20};
+  {
+    pqxx::group_commit group{cx, policy};
+    auto good{group.submit(
+      [](pqxx::transaction_base &tx) { tx.exec0("SELECT 1"); })};
+    auto bad{group.submit(
+      [](pqxx::transaction_base &tx) { tx.exec0("SELECT nonexistent"); })};
+    PQXX_CHECK_THROWS(
+      bad.get(), pqxx::sql_error, "Failing write did not fail.");
+    good.get();
+  }
+
+  // Without savepoints, one failure takes down the whole batch.
+  policy.on_failure = pqxx::group_failure::all_or_nothing;
+  pqxx::group_commit group{cx, policy};
+  auto good{
+    group.submit([](pqxx::transaction_base &tx) { tx.exec0("SELECT 1"); })};
+  auto bad{group.submit(
+    [](pqxx::transaction_base &tx) { tx.exec0("SELECT nonexistent"); })};
+  PQXX_CHECK_THROWS(bad.get(), pqxx::sql_error, "Failing write succeeded.");
+  PQXX_CHECK_THROWS(
+    good.get(), pqxx::sql_error, "Write in failed batch succeeded.");
+}
+
+
+void test_group_commit_delay()
+{
+  pqxx::connection cx;
+  pqxx::group_commit_policy policy;
+  policy.max_writes = 2;
+  policy.max_delay = std::chrono::milliseconds{500};
+  pqxx::group_commit group{cx, policy};
+
+  // The first batch takes a while.  The write left over from it has been
+  // waiting all that time, so it should not have to wait a full max_delay
+  // more after that.
+  auto const start{std::chrono::steady_clock::now()};
+  auto slow{group.submit(
+    [](pqxx::transaction_base &tx) { tx.exec0("SELECT pg_sleep(0.5)"); })};
+  auto quick{group.submit(
+    [](pqxx::transaction_base &tx) { tx.exec0("SELECT 1"); })};
+  auto leftover{group.submit(
+    [](pqxx::transaction_base &tx) { tx.exec0("SELECT 2"); })};
+  slow.get();
+  quick.get();
+  leftover.get();
+  PQXX_CHECK(
+    std::chrono::steady_clock::now() - start < std::chrono::milliseconds{900},
+    "Leftover write waited for max_delay all over again.");
+}
+
+
+PQXX_REGISTER_TEST(test_group_commit);
+PQXX_REGISTER_TEST(test_group_commit_failures);
+PQXX_REGISTER_TEST(test_group_commit_delay);
+} // namespace
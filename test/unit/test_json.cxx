@@ -0,0 +1,88 @@
+#include <pqxx/json>
+#include <pqxx/stream_to>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+using namespace std::literals;
+
+namespace
+{
+void test_json_view_conversions()
+{
+  std::string const text{R"({"a": [1, 2]})"};
+  auto const view{pqxx::from_string<pqxx::json_view>(text)};
+  PQXX_CHECK(view.data() == text.data(), "json_view copied its text.");
+  PQXX_CHECK_EQUAL(view.size(), std::size(text), "Wrong json_view size.");
+  PQXX_CHECK_EQUAL(pqxx::to_string(view), text, "Bad json_view to string.");
+
+  // A binary jsonb starts with a version byte, which the view leaves out.
+  auto const jsonb{"\1"s + text};
+  auto const bin{pqxx::binary_traits<pqxx::json_view>::from_binary(jsonb)};
+  PQXX_CHECK_EQUAL(std::string{bin.text()}, text, "Bad binary jsonb.");
+  PQXX_CHECK_EQUAL(
+    std::string{
+      pqxx::binary_traits<pqxx::json_view>::from_binary(text).text()},
+    text, "Bad binary json.");
+
+  using traits = pqxx::binary_traits<pqxx::json_view>;
+  std::string buf(traits::binary_size(view), 'x');
+  auto const end{traits::into_binary(
+    buf.data(), buf.data() + std::size(buf), view)};
+  PQXX_CHECK(end == buf.data() + std::size(buf), "Wrong binary jsonb size.");
+  PQXX_CHECK_EQUAL(buf, jsonb, "Bad binary jsonb output.");
+
+  std::string padded_buf;
+  auto const padded{view.padded(padded_buf, 32)};
+  PQXX_CHECK_EQUAL(std::string{padded}, text, "Padded json is wrong.");
+  PQXX_CHECK_EQUAL(
+    std::size(padded_buf), std::size(text) + 32, "Wrong padding.");
+  PQXX_CHECK_EQUAL(int{padded_buf.back()}, 0, "Padding is not zero.");
+}
+
+
+void test_json_view_from_server()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+
+  // The view points into the result, so keep the result around.
+  auto const row{tx.exec1(R"(SELECT '{"x":1}'::json)")};
+  PQXX_CHECK_EQUAL(
+    std::string{row[0].as<pqxx::json_view>().text()}, R"({"x":1})",
+    "Bad text json.");
+
+  auto const r{tx.exec_params_binary(
+    "SELECT $1::jsonb, '[1]'::json",
+    pqxx::json_view{pqxx::zview{R"({"y": true})"}})};
+  PQXX_CHECK_EQUAL(
+    std::string{r[0][0].as<pqxx::json_view>().text()}, R"({"y": true})",
+    "Bad binary jsonb from server.");
+  PQXX_CHECK_EQUAL(
+    std::string{r[0][1].as<pqxx::json_view>().text()}, "[1]",
+    "Bad binary json from server.");
+
+  // As a binary parameter, a json_view is a jsonb.
+  PQXX_CHECK_EQUAL(
+    tx.exec_params1(
+        "SELECT pg_typeof($1)::text",
+        pqxx::prepare::make_binary_param(pqxx::json_view{pqxx::zview{"{}"}}))
+      .front()
+      .as<std::string>(),
+    "jsonb", "Binary json_view did not go in as jsonb.");
+
+  tx.exec0("CREATE TEMP TABLE pqxx_json (doc jsonb)");
+  {
+    pqxx::stream_to out{tx, "pqxx_json"};
+    out << std::make_tuple(pqxx::json_view{pqxx::zview{R"({"z": 2})"}});
+    out.complete();
+  }
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT (doc->>'z')::int FROM pqxx_json"), 2,
+    "json_view did not stream.");
+}
+
+
+PQXX_REGISTER_TEST(test_json_view_conversions);
+PQXX_REGISTER_TEST(test_json_view_from_server);
+} // namespace
@@ -0,0 +1,74 @@
+#include <string>
+#include <vector>
+
+#include <pqxx/keyset_cursor>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+constexpr char const query[]{
+  "SELECT n / 10 AS a, n % 10 AS b, n FROM generate_series(0, 94) AS n"};
+
+
+/// Read all pages from @c cur, one transaction per page.
+std::vector<int> read_all(pqxx::connection &conn, pqxx::keyset_cursor &cur)
+{
+  std::vector<int> got;
+  while (not cur.done())
+  {
+    pqxx::work tx{conn};
+    auto const page{cur.next(tx)};
+    PQXX_CHECK(page.size() <= 10, "Page too big.");
+    for (auto const &row : page) got.push_back(row[2].as<int>());
+    tx.commit();
+  }
+  return got;
+}
+
+
+void test_keyset_cursor()
+{
+  pqxx::connection conn;
+  pqxx::keyset_cursor cur{conn, query, {"a", "b"}, 10};
+  PQXX_CHECK(std::empty(cur.position()), "Cursor starts with a position.");
+  auto const got{read_all(conn, cur)};
+  PQXX_CHECK_EQUAL(std::size(got), 95u, "Wrong number of rows.");
+  for (std::size_t i{0}; i < std::size(got); ++i)
+    PQXX_CHECK_EQUAL(got[i], static_cast<int>(i), "Rows out of order.");
+  PQXX_CHECK_EQUAL(
+    cur.position(), (std::vector<std::string>{"9", "4"}), "Bad position.");
+
+  // Resume from a saved position.
+  cur.seek({"3", "9"});
+  pqxx::work tx{conn};
+  auto const page{cur.next(tx)};
+  PQXX_CHECK_EQUAL(page.size(), 10, "Wrong page size after seek.");
+  PQXX_CHECK_EQUAL(page[0][2].as<int>(), 40, "Seek went to the wrong row.");
+  PQXX_CHECK_THROWS(
+    cur.seek({"1"}), pqxx::argument_error, "Bad position went unnoticed.");
+}
+
+
+void test_keyset_cursor_prefetch_and_prepare()
+{
+  pqxx::connection conn;
+  pqxx::keyset_cursor cur{
+    conn, query, {"n"}, 10, pqxx::keyset_order::descending};
+  cur.set_prefetch(3);
+  cur.prepare(conn, "keyset_test");
+  auto const got{read_all(conn, cur)};
+  PQXX_CHECK_EQUAL(std::size(got), 95u, "Wrong number of rows.");
+  PQXX_CHECK_EQUAL(got.front(), 94, "Descending order starts wrong.");
+  PQXX_CHECK_EQUAL(got.back(), 0, "Descending order ends wrong.");
+
+  cur.rewind();
+  pqxx::work tx{conn};
+  PQXX_CHECK_EQUAL(cur.next(tx)[0][2].as<int>(), 94, "Rewind failed.");
+}
+
+
+PQXX_REGISTER_TEST(test_keyset_cursor);
+PQXX_REGISTER_TEST(test_keyset_cursor_prefetch_and_prepare);
+} // namespace
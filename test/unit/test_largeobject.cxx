@@ -0,0 +1,160 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pqxx/connection_pool>
+#include <pqxx/largeobject>
+#include <pqxx/largeobject_transfer>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_largeobject_read_write_all()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::largeobjectaccess obj{tx};
+
+  std::string data;
+  for (int i{0}; i < 1000; ++i) data += pqxx::to_string(i) + '\0';
+  obj.write_all(data, 100);
+  PQXX_CHECK_EQUAL(
+    obj.tell(), pqxx::largeobjectaccess::size_type(std::size(data)),
+    "write_all() left us in the wrong place.");
+
+  obj.seek(0, std::ios::beg);
+  PQXX_CHECK(obj.read_all(7) == data, "read_all() got wrong data.");
+  PQXX_CHECK(obj.read_all().empty(), "Read past the end of the object.");
+
+  obj.seek(10, std::ios::beg);
+  PQXX_CHECK(
+    obj.read_all() == data.substr(10), "read_all() ignored the position.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(obj.read_all(0)), pqxx::argument_error,
+    "Accepted zero chunk size.");
+
+  pqxx::ilostream stream{tx, obj.id()};
+  std::stringstream contents;
+  contents << stream.rdbuf();
+  PQXX_CHECK(
+    contents.str() == data, "Stream with default buffer read wrong data.");
+
+  obj.remove(tx);
+}
+
+
+void test_largeobject_view()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::largeobjectaccess obj{tx};
+  std::string data;
+  for (int i{0}; i < 2000; ++i) data += pqxx::to_string(i) + ',';
+  obj.write_all(data);
+
+  pqxx::largeobject_view view{tx, obj, 1000, 4};
+  view.set_readahead(0);
+  PQXX_CHECK(view.read(0, 10) == data.substr(0, 10), "Bad first read.");
+  PQXX_CHECK_EQUAL(view.fetches(), 1u, "Wrong number of fetches.");
+  PQXX_CHECK(view.read(5, 10) == data.substr(5, 10), "Bad cached read.");
+  PQXX_CHECK_EQUAL(view.fetches(), 1u, "Cached read went to the server.");
+
+  PQXX_CHECK(
+    view.read(2500, 1000) == data.substr(2500, 1000), "Bad multi-page read.");
+  PQXX_CHECK_EQUAL(view.fetches(), 2u, "Missing pages took several fetches.");
+
+  view.set_readahead(2);
+  PQXX_CHECK(view.read(4000, 10) == data.substr(4000, 10), "Bad readahead.");
+  PQXX_CHECK_EQUAL(view.fetches(), 3u, "Wrong number of fetches.");
+  PQXX_CHECK(
+    view.read(5000, 1500) == data.substr(5000, 1500),
+    "Bad read after readahead.");
+  PQXX_CHECK_EQUAL(view.fetches(), 3u, "Readahead did not read ahead.");
+  PQXX_CHECK(view.cached_pages() <= 4u, "Cache outgrew its limit.");
+
+  auto const size{static_cast<pqxx::largeobject_view::size_type>(
+    std::size(data))};
+  PQXX_CHECK(
+    view.read(size - 10, 100) == data.substr(std::size(data) - 10),
+    "Bad read at end of object.");
+  PQXX_CHECK(view.read(size + 10, 100).empty(), "Read beyond end of object.");
+  PQXX_CHECK_EQUAL(view.size(), size, "Wrong size.");
+
+  pqxx::largeobject_view_buf buf{view};
+  std::istream in{&buf};
+  in.seekg(1234);
+  std::string chunk(100, ' ');
+  in.read(std::data(chunk), 100);
+  PQXX_CHECK(chunk == data.substr(1234, 100), "Bad read through stream.");
+  in.seekg(0);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  PQXX_CHECK(contents.str() == data, "Bad stream contents.");
+
+  obj.remove(tx);
+}
+
+
+/// Read a whole local file.
+std::string slurp(std::string const &path)
+{
+  std::ifstream in{path, std::ios::binary};
+  return {
+    std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+
+void test_large_object_transfer()
+{
+  pqxx::connection_pool pool{""};
+  std::vector<std::string> contents;
+  std::vector<pqxx::large_object_file> files;
+  for (int i{0}; i < 5; ++i)
+  {
+    contents.push_back(std::string(std::size_t(i) * 1000, char('a' + i)));
+    auto path{"pqxx_lo_transfer_" + pqxx::to_string(i) + ".bin"};
+    std::ofstream{path, std::ios::binary} << contents.back();
+    files.push_back({pqxx::oid_none, std::move(path)});
+  }
+
+  pqxx::import_large_objects(pool, files, 3, 700);
+  for (auto const &file : files)
+  {
+    PQXX_CHECK(file.id != pqxx::oid_none, "Import did not set oid.");
+    std::remove(file.path.c_str());
+  }
+
+  pqxx::export_large_objects(pool, files, 2, 300);
+  {
+    auto conn{pool.get()};
+    pqxx::work tx{*conn};
+    for (std::size_t i{0}; i < std::size(files); ++i)
+    {
+      PQXX_CHECK(
+        slurp(files[i].path) == contents[i], "Round trip changed data.");
+      std::remove(files[i].path.c_str());
+      pqxx::largeobject{files[i].id}.remove(tx);
+    }
+    tx.commit();
+  }
+
+  std::vector<pqxx::large_object_file> missing{
+    {pqxx::oid_none, "/nonexistent/pqxx/file"}};
+  PQXX_CHECK_THROWS(
+    pqxx::import_large_objects(pool, missing), pqxx::failure,
+    "Importing a nonexistent file did not fail.");
+  PQXX_CHECK(
+    missing[0].id == pqxx::oid_none, "Failed import still set an oid.");
+}
+
+
+PQXX_REGISTER_TEST(test_largeobject_read_write_all);
+PQXX_REGISTER_TEST(test_largeobject_view);
+PQXX_REGISTER_TEST(test_large_object_transfer);
+} // namespace
@@ -1,5 +1,7 @@
 #include <chrono>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "../test_helpers.hxx"
 
@@ -26,6 +28,25 @@ public:
 };
 
 
+/// Receiver which takes its payloads as views.
+class ViewReceiver final : public pqxx::notification_receiver
+{
+public:
+  int calls{0};
+  std::string last;
+
+  ViewReceiver(pqxx::connection_base &c, std::string const &channel_name) :
+          pqxx::notification_receiver(c, channel_name)
+  {}
+
+  void receive(pqxx::zview payload, int) override
+  {
+    ++calls;
+    last = payload;
+  }
+};
+
+
 void test_receive(
   pqxx::transaction_base &t, std::string const &channel,
   char const payload[] = nullptr)
@@ -74,5 +95,70 @@ void test_notification()
 }
 
 
+void test_notification_receive_view()
+{
+  pqxx::connection conn;
+  ViewReceiver viewer{conn, "pqxx_view_channel"};
+  TestReceiver plain{conn, "pqxx_view_channel"};
+  pqxx::nontransaction tx{conn};
+  tx.exec0("NOTIFY pqxx_view_channel, 'viewed'");
+
+  for (int i{0}; (i < 10) and (viewer.calls == 0); ++i)
+  {
+    conn.get_notifs();
+    if (viewer.calls == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  PQXX_CHECK_EQUAL(viewer.calls, 1, "receive() override was not called.");
+  PQXX_CHECK_EQUAL(viewer.last, "viewed", "Bad payload view.");
+  PQXX_CHECK_EQUAL(plain.payload, "viewed", "Default receive() lost data.");
+}
+
+
+void test_receiver_batch()
+{
+  pqxx::connection conn;
+  auto const listening{[&conn] {
+    pqxx::nontransaction tx{conn};
+    return tx.query_value<int>("SELECT count(*) FROM pg_listening_channels()");
+  }};
+
+  std::vector<std::unique_ptr<TestReceiver>> receivers;
+  {
+    pqxx::receiver_batch batch{conn};
+    PQXX_CHECK_THROWS(
+      pqxx::receiver_batch{conn}, pqxx::usage_error,
+      "Opening a second receiver_batch did not fail.");
+    for (int i{0}; i < 100; ++i)
+      receivers.push_back(std::make_unique<TestReceiver>(
+        conn, "pqxx_batch_" + pqxx::to_string(i)));
+    // A channel that comes and goes within the batch never gets a LISTEN.
+    TestReceiver{conn, "pqxx_batch_gone"};
+    batch.complete();
+  }
+  PQXX_CHECK_EQUAL(listening(), 100, "Wrong number of channels after batch.");
+
+  {
+    pqxx::receiver_batch batch{conn};
+    receivers.resize(10);
+    batch.complete();
+  }
+  PQXX_CHECK_EQUAL(listening(), 10, "Batched UNLISTEN went wrong.");
+
+  pqxx::nontransaction tx{conn};
+  tx.exec0("NOTIFY pqxx_batch_3, 'batched'");
+  for (int i{0}; (i < 10) and (receivers[3]->payload.empty()); ++i)
+  {
+    conn.get_notifs();
+    if (receivers[3]->payload.empty())
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  PQXX_CHECK_EQUAL(
+    receivers[3]->payload, "batched", "Batched receiver did not receive.");
+}
+
+
 PQXX_REGISTER_TEST(test_notification);
+PQXX_REGISTER_TEST(test_notification_receive_view);
+PQXX_REGISTER_TEST(test_receiver_batch);
 } // namespace
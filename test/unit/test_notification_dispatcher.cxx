@@ -0,0 +1,90 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pqxx/nontransaction>
+#include <pqxx/notification_dispatcher>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_notification_dispatcher_config()
+{
+  PQXX_CHECK_THROWS(
+    pqxx::notification_dispatcher{"host=/nonexistent/pqxx/socket/dir"},
+    pqxx::broken_connection, "Dispatcher hid a failure to connect.");
+}
+
+
+/// Wait until @c done returns true, for at most a few seconds.
+template<typename DONE> bool wait_for(DONE const &done)
+{
+  for (int i{0}; i < 500 and not done(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  return done();
+}
+
+
+void test_notification_dispatcher()
+{
+  pqxx::notification_dispatcher dispatcher{
+    "", 2, std::chrono::milliseconds{20}};
+  PQXX_CHECK_THROWS(
+    pqxx::notification_dispatcher("", 1, std::chrono::milliseconds{0}),
+    pqxx::argument_error, "Accepted zero poll interval.");
+
+  std::mutex lock;
+  std::vector<std::string> payloads;
+  std::atomic<int> calls{0};
+  dispatcher.listen(
+    "pqxx_dispatch", [&](auto const &batch) {
+      std::lock_guard const guard{lock};
+      ++calls;
+      for (auto const &item : batch)
+      {
+        PQXX_CHECK_EQUAL(item.channel, "pqxx_dispatch", "Wrong channel.");
+        payloads.push_back(item.payload);
+      }
+    });
+  dispatcher.listen("pqxx_dispatch_fail", [](auto const &) {
+    throw std::runtime_error{"Failing handler."};
+  });
+
+  pqxx::connection conn;
+  {
+    pqxx::nontransaction tx{conn};
+    for (int i{0}; i < 20; ++i)
+      tx.exec0("NOTIFY pqxx_dispatch, '" + pqxx::to_string(i) + "'");
+    tx.exec0("NOTIFY pqxx_dispatch_fail");
+  }
+
+  PQXX_CHECK(
+    wait_for([&dispatcher] { return dispatcher.stats().delivered == 21; }),
+    "Notifications did not arrive.");
+  auto const stats{dispatcher.stats()};
+  PQXX_CHECK_EQUAL(stats.received, 21u, "Wrong number received.");
+  PQXX_CHECK_EQUAL(stats.queue_depth, 0u, "Queue did not drain.");
+  PQXX_CHECK_EQUAL(stats.failures, 1u, "Handler failure went uncounted.");
+  PQXX_CHECK(stats.batches <= 21u, "More batches than notifications.");
+  PQXX_CHECK(calls.load() >= 1, "Handler was not called.");
+
+  std::lock_guard const guard{lock};
+  PQXX_CHECK_EQUAL(std::size(payloads), 20u, "Wrong number of payloads.");
+  for (std::size_t i{0}; i < std::size(payloads); ++i)
+    PQXX_CHECK_EQUAL(payloads[i], pqxx::to_string(i), "Out of order.");
+
+  dispatcher.stop();
+  PQXX_CHECK_THROWS(
+    dispatcher.listen("pqxx_dispatch", [](auto const &) {}),
+    pqxx::usage_error, "Listening on a stopped dispatcher.");
+}
+
+
+PQXX_REGISTER_TEST(test_notification_dispatcher_config);
+PQXX_REGISTER_TEST(test_notification_dispatcher);
+} // namespace
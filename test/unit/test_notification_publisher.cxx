@@ -0,0 +1,71 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pqxx/notification>
+#include <pqxx/notification_publisher>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+class collector final : public pqxx::notification_receiver
+{
+public:
+  std::vector<std::string> payloads;
+
+  collector(pqxx::connection &c, std::string const &channel) :
+          pqxx::notification_receiver{c, channel}
+  {}
+
+  void receive(pqxx::zview payload, int) override
+  {
+    payloads.emplace_back(payload);
+  }
+};
+
+
+void test_notification_publisher()
+{
+  pqxx::connection listener, sender;
+  collector received{listener, "pqxx_publish"};
+
+  pqxx::publish_policy policy;
+  policy.max_pending = 3;
+  policy.max_delay = std::chrono::milliseconds{0};
+  pqxx::notification_publisher publisher{sender, policy};
+
+  publisher.publish("pqxx_publish", "1");
+  publisher.publish("pqxx_publish", "2");
+  PQXX_CHECK_EQUAL(publisher.pending(), 2u, "Publisher flushed too early.");
+  publisher.publish("pqxx_publish", "3");
+  PQXX_CHECK_EQUAL(publisher.pending(), 0u, "Publisher did not flush.");
+
+  {
+    // Inside a transaction, the notifications wait for the commit.
+    pqxx::work tx{sender};
+    publisher.publish("pqxx_publish", "4");
+    PQXX_CHECK_EQUAL(publisher.flush(), 1u, "Wrong flush count.");
+    tx.commit();
+  }
+  PQXX_CHECK_EQUAL(publisher.flush(), 0u, "Empty flush sent something.");
+
+  for (int i{0}; i < 50 and std::size(received.payloads) < 4; ++i)
+  {
+    listener.get_notifs();
+    if (std::size(received.payloads) < 4)
+      std::this_thread::sleep_for(std::chrono::milliseconds{100});
+  }
+  PQXX_CHECK_EQUAL(
+    std::size(received.payloads), 4u, "Wrong number of notifications.");
+  for (std::size_t i{0}; i < std::size(received.payloads); ++i)
+    PQXX_CHECK_EQUAL(
+      received.payloads[i], pqxx::to_string(i + 1),
+      "Notifications out of order.");
+}
+
+
+PQXX_REGISTER_TEST(test_notification_publisher);
+} // namespace
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+#include <pqxx/parallel_export>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_parallel_export_queries()
+{
+  pqxx::parallel_export const exporter{
+    "", "mytable", "a, b", {"", "a < 10", "a >= 10"}};
+  PQXX_CHECK_EQUAL(exporter.size(), 3u, "Wrong number of partitions.");
+  PQXX_CHECK_EQUAL(
+    exporter.partition_query(0), "SELECT a, b FROM mytable",
+    "Bad query for unconditional partition.");
+  PQXX_CHECK_EQUAL(
+    exporter.partition_query(2), "SELECT a, b FROM mytable WHERE a >= 10",
+    "Bad partition query.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(exporter.partition_query(3)), std::out_of_range,
+    "Partition index out of range went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::parallel_export("", "mytable", "*", {}), pqxx::usage_error,
+    "Exporter without partitions went unnoticed.");
+}
+
+
+void test_parallel_export()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0(
+    "CREATE TABLE pqxx_parallel_export AS "
+    "SELECT n FROM generate_series(1, 1000) AS n");
+  tx.commit();
+
+  try
+  {
+    pqxx::read_transaction rtx{conn};
+    auto const ctids{
+      pqxx::parallel_export::ctid_partitions(rtx, "pqxx_parallel_export", 3)};
+    PQXX_CHECK_EQUAL(ctids.size(), 3u, "Wrong number of ctid partitions.");
+    auto const keys{pqxx::parallel_export::key_partitions(
+      rtx, "n", {"250", "500", "750"})};
+    PQXX_CHECK_EQUAL(keys.size(), 4u, "Wrong number of key partitions.");
+    rtx.commit();
+
+    for (auto const &partitions : {ctids, keys})
+    {
+      pqxx::parallel_export exporter{
+        conn.connection_string(), "pqxx_parallel_export", "n", partitions};
+      std::mutex lock;
+      std::set<int> seen;
+      std::atomic<long> rows{0};
+      exporter.run<int>([&](std::size_t, std::tuple<int> const &row) {
+        ++rows;
+        std::lock_guard<std::mutex> guard{lock};
+        seen.insert(std::get<0>(row));
+      });
+      PQXX_CHECK_EQUAL(rows.load(), 1000L, "Parallel export lost rows.");
+      PQXX_CHECK_EQUAL(seen.size(), 1000u, "Parallel export duplicated rows.");
+    }
+
+    // Scan more partitions than threads, through cursors.
+    pqxx::connection_pool pool{conn.connection_string()};
+    pqxx::parallel_export scanner{
+      conn.connection_string(), "pqxx_parallel_export", "n", keys};
+    std::mutex lock;
+    std::set<int> seen;
+    std::set<std::size_t> partitions;
+    scanner.scan(
+      pool,
+      [&](std::size_t partition, pqxx::result const &block) {
+        std::lock_guard<std::mutex> guard{lock};
+        partitions.insert(partition);
+        for (auto const row : block) seen.insert(row[0].as<int>());
+      },
+      100, 2);
+    PQXX_CHECK_EQUAL(seen.size(), 1000u, "Parallel scan lost rows.");
+    PQXX_CHECK_EQUAL(partitions.size(), 4u, "Parallel scan lost partitions.");
+
+    PQXX_CHECK_THROWS(
+      scanner.scan(
+        pool,
+        [](std::size_t, pqxx::result const &) {
+          throw std::runtime_error{"Stop."};
+        },
+        10, 3),
+      std::runtime_error, "Error in parallel scan went unnoticed.");
+    PQXX_CHECK_EQUAL(pool.idle(), pool.size(), "Scan kept connections.");
+  }
+  catch (std::exception const &)
+  {
+    pqxx::nontransaction{conn}.exec0("DROP TABLE pqxx_parallel_export");
+    throw;
+  }
+  pqxx::nontransaction{conn}.exec0("DROP TABLE pqxx_parallel_export");
+}
+
+
+PQXX_REGISTER_TEST(test_parallel_export_queries);
+PQXX_REGISTER_TEST(test_parallel_export);
+} // namespace
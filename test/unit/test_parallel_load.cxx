@@ -0,0 +1,143 @@
+#include <atomic>
+#include <thread>
+
+#include <pqxx/parallel_load>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_spsc_queue()
+{
+  pqxx::internal::spsc_queue<int> queue{3};
+  int value{0};
+  PQXX_CHECK(not queue.try_pop(value), "Popped from empty queue.");
+
+  // Go around the ring a few times.
+  for (int round{0}; round < 5; ++round)
+  {
+    for (int i{0}; i < 3; ++i)
+    {
+      int v{round * 10 + i};
+      PQXX_CHECK(queue.try_push(v), "Could not push into queue.");
+    }
+    int extra{99};
+    PQXX_CHECK(not queue.try_push(extra), "Pushed into full queue.");
+    PQXX_CHECK_EQUAL(extra, 99, "Failed push moved from its value.");
+    for (int i{0}; i < 3; ++i)
+    {
+      PQXX_CHECK(queue.try_pop(value), "Could not pop from queue.");
+      PQXX_CHECK_EQUAL(value, round * 10 + i, "Queue lost its ordering.");
+    }
+    PQXX_CHECK(not queue.try_pop(value), "Queue did not empty.");
+  }
+
+  // Now with a real producer thread.
+  constexpr int count{100000};
+  pqxx::internal::spsc_queue<int> shared{16};
+  std::thread producer{[&shared] {
+    for (int i{0}; i < count; ++i)
+      while (not shared.try_push(i)) std::this_thread::yield();
+  }};
+  int expected{0};
+  while (expected < count)
+  {
+    if (shared.try_pop(value))
+    {
+      if (value != expected)
+        break;
+      ++expected;
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  PQXX_CHECK_EQUAL(expected, count, "Threaded queue lost or reordered items.");
+}
+
+
+void test_spsc_queue_blocking()
+{
+  // A tiny queue, so both sides will have to wait for each other.
+  constexpr int count{100000};
+  pqxx::internal::spsc_queue<int> shared{2};
+  auto const never{[] { return false; }};
+  std::thread producer{[&shared, &never] {
+    for (int i{0}; i < count; ++i) shared.push(i, never);
+  }};
+  int value{0}, expected{0};
+  while (expected < count and shared.pop(value, never) and value == expected)
+    ++expected;
+  producer.join();
+  PQXX_CHECK_EQUAL(expected, count, "Blocking queue lost or reordered items.");
+
+  // A thread waiting on an empty queue gives up when told to.
+  std::atomic<bool> stop{false};
+  bool popped{true};
+  std::thread consumer{[&] {
+    popped = shared.pop(value, [&stop] { return stop.load(); });
+  }};
+  stop = true;
+  shared.wake();
+  consumer.join();
+  PQXX_CHECK(not popped, "Stopped pop() returned a value.");
+}
+
+
+void test_parallel_load()
+{
+  pqxx::connection conn;
+  pqxx::nontransaction{conn}.exec0(
+    "CREATE TABLE pqxx_parallel_load (n integer, t text)");
+
+  try
+  {
+    {
+      pqxx::parallel_load<int, std::string> load{
+        conn.connection_string(), "pqxx_parallel_load", {"n", "t"}, 4,
+        pqxx::commit_policy::together, 8};
+      PQXX_CHECK_EQUAL(load.size(), 4u, "Wrong number of connections.");
+      for (int n{1}; n <= 1000; ++n) load << std::make_tuple(n, "row");
+      load.complete();
+    }
+    pqxx::read_transaction tx{conn};
+    PQXX_CHECK_EQUAL(
+      tx.query_value<int>("SELECT count(DISTINCT n) FROM pqxx_parallel_load"),
+      1000, "Parallel load lost rows.");
+    tx.commit();
+
+    {
+      // Abandoning a load commits nothing.
+      pqxx::parallel_load<int, std::string> load{
+        conn.connection_string(), "pqxx_parallel_load", {}, 2};
+      load << std::make_tuple(5000, "abandoned");
+    }
+    // A single failing row is enough to cancel the whole load.
+    pqxx::parallel_load<std::string, std::string> bad{
+      conn.connection_string(), "pqxx_parallel_load", {"n", "t"}, 2};
+    bad << std::make_tuple(std::string{"1"}, std::string{"ok"});
+    bad << std::make_tuple(std::string{"not a number"}, std::string{"bad"});
+    PQXX_CHECK_THROWS_EXCEPTION(
+      bad.complete(), "Failure in parallel_load went unnoticed.");
+
+    pqxx::read_transaction tx2{conn};
+    PQXX_CHECK_EQUAL(
+      tx2.query_value<int>("SELECT count(*) FROM pqxx_parallel_load"), 1000,
+      "Failed or abandoned parallel load committed rows.");
+    tx2.commit();
+  }
+  catch (std::exception const &)
+  {
+    pqxx::nontransaction{conn}.exec0("DROP TABLE pqxx_parallel_load");
+    throw;
+  }
+  pqxx::nontransaction{conn}.exec0("DROP TABLE pqxx_parallel_load");
+}
+
+
+PQXX_REGISTER_TEST(test_spsc_queue);
+PQXX_REGISTER_TEST(test_spsc_queue_blocking);
+PQXX_REGISTER_TEST(test_parallel_load);
+} // namespace
@@ -0,0 +1,69 @@
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#include <pqxx/parallel_result>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_parallel_for_each_row()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const r{tx.exec("SELECT n FROM generate_series(1, 1000) AS n")};
+
+  std::atomic<long> total{0};
+  pqxx::parallel_for_each_row(
+    r, [&total](pqxx::row_ref row) { total += row[0].as<long>(); }, 4);
+  PQXX_CHECK_EQUAL(total.load(), 500500L, "Rows went missing, or doubled.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::parallel_for_each_row(
+      r,
+      [](pqxx::row_ref row) {
+        if (row[0].as<int>() == 700)
+          throw std::runtime_error{"Row 700."};
+      },
+      3),
+    std::runtime_error, "Exception in worker thread went unnoticed.");
+}
+
+
+void test_parallel_transform()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const r{tx.exec("SELECT n, 'x' || n FROM generate_series(1, 99) AS n")};
+
+  auto const texts{pqxx::parallel_transform(
+    r, [](pqxx::row_ref row) { return row["?column?"].as<std::string>(); },
+    8)};
+  PQXX_CHECK_EQUAL(std::size(texts), 99u, "Wrong number of results.");
+  for (std::size_t i{0}; i < std::size(texts); ++i)
+    PQXX_CHECK_EQUAL(
+      texts[i], "x" + pqxx::to_string(i + 1), "Results out of order.");
+}
+
+
+void test_parallel_empty_result()
+{
+  pqxx::result const r;
+  int calls{0};
+  pqxx::parallel_for_each_row(r, [&calls](pqxx::row_ref) { ++calls; });
+  PQXX_CHECK_EQUAL(calls, 0, "Called back for rows that aren't there.");
+  PQXX_CHECK(
+    pqxx::parallel_transform(r, [](pqxx::row_ref) { return 1; }).empty(),
+    "Got results for rows that aren't there.");
+  PQXX_CHECK_EQUAL(
+    pqxx::internal::parallel_threads(3, 100), 3u, "More threads than rows.");
+  PQXX_CHECK_EQUAL(
+    pqxx::internal::parallel_threads(0, 0), 1u, "No thread for no rows.");
+}
+
+
+PQXX_REGISTER_TEST(test_parallel_for_each_row);
+PQXX_REGISTER_TEST(test_parallel_transform);
+PQXX_REGISTER_TEST(test_parallel_empty_result);
+} // namespace
@@ -1,4 +1,6 @@
 #include <chrono>
+#include <thread>
+#include <vector>
 
 #include "../test_helpers.hxx"
 
@@ -55,6 +57,291 @@ void test_pipeline()
     std::chrono::duration_cast<std::chrono::seconds>(finish - start).count()};
   PQXX_CHECK_LESS(seconds, 5, "Canceling a sleep took suspiciously long.");
 }
+
+
+void test_pipeline_overlapping_batches()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::pipeline pipe{tx};
+
+  // With retain(0), every query goes out as soon as we insert it, even while
+  // earlier ones are still in progress.
+  pipe.retain(0);
+  std::vector<pqxx::pipeline::query_id> ids;
+  for (int i{0}; i < 10; ++i)
+    ids.push_back(pipe.insert("SELECT " + pqxx::to_string(i)));
+
+  // Retrieve one result out of order, then the rest in order.
+  PQXX_CHECK_EQUAL(
+    pipe.retrieve(ids[5]).at(0).at(0).as<int>(), 5,
+    "Out-of-order pipeline retrieval went wrong.");
+  for (int i{0}; i < 10; ++i)
+    if (i != 5)
+      PQXX_CHECK_EQUAL(
+        pipe.retrieve(ids[std::size_t(i)]).at(0).at(0).as<int>(), i,
+        "Pipeline returned wrong result.");
+  PQXX_CHECK(pipe.empty(), "Pipeline not empty after retrieving everything.");
+
+  // Once the pipeline completes, the transaction is usable again.
+  pipe.complete();
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 99"), 99,
+    "Transaction broken after pipeline completed.");
+}
+
+
+void test_pipeline_params()
+{
+  pqxx::connection conn;
+  // Prepare before the pipeline starts; it has the connection to itself.
+  conn.prepare("pipe_double", "SELECT 2 * $1::integer");
+  pqxx::work tx{conn};
+  pqxx::pipeline pipe{tx};
+
+  auto const plain{pipe.insert("SELECT 1")};
+  auto const params{pipe.insert_params("SELECT $1::integer, $2", 5, "x")};
+  auto const prepared{pipe.insert_prepared("pipe_double", 21)};
+  auto const next{pipe.insert("SELECT 3")};
+  pipe.complete();
+
+  PQXX_CHECK_EQUAL(
+    pipe.retrieve(plain).at(0).at(0).as<int>(), 1,
+    "Plain query in pipeline went wrong.");
+  auto const r{pipe.retrieve(params)};
+  PQXX_CHECK_EQUAL(
+    r.at(0).at(0).as<int>(), 5, "Parameterised query in pipeline went wrong.");
+  PQXX_CHECK_EQUAL(
+    r.at(0).at(1).as<std::string>(), "x",
+    "String parameter in pipeline went wrong.");
+  PQXX_CHECK_EQUAL(
+    pipe.retrieve(prepared).at(0).at(0).as<int>(), 42,
+    "Prepared statement in pipeline went wrong.");
+  PQXX_CHECK_EQUAL(
+    pipe.retrieve(next).at(0).at(0).as<int>(), 3,
+    "Query after parameterised ones went wrong.");
+}
+
+
+
+void test_pipeline_temporary_bytes()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::pipeline pipe{tx};
+
+  // The vector is gone before the query goes out.
+  auto const id{pipe.insert_params(
+    "SELECT length($1), get_byte($1, 2)",
+    std::vector<std::byte>{std::byte{'a'}, std::byte{0}, std::byte{0xff}})};
+  pipe.complete();
+
+  auto const r{pipe.retrieve(id)};
+  PQXX_CHECK_EQUAL(
+    r.at(0).at(0).as<int>(), 3, "Temporary bytes came out wrong length.");
+  PQXX_CHECK_EQUAL(
+    r.at(0).at(1).as<int>(), 0xff, "Temporary bytes came out garbled.");
+}
+
+void test_pipeline_adaptive_batching()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::pipeline pipe{tx};
+
+  pqxx::pipeline_batching policy;
+  policy.max_in_flight = -1;
+  PQXX_CHECK_THROWS(
+    pipe.retain(policy), pqxx::range_error,
+    "Negative in-flight limit was accepted.");
+
+  policy.max_bytes = 100;
+  policy.max_in_flight = 3;
+  pipe.retain(policy);
+
+  // Mix small queries with big ones, which fill up a batch by themselves.
+  std::string const big(200, 'x');
+  std::vector<pqxx::pipeline::query_id> ids;
+  for (int i{0}; i < 20; ++i)
+    ids.push_back(
+      (i % 5 == 0) ?
+        pipe.insert_params("SELECT length($1) + $2::integer", big, i) :
+        pipe.insert("SELECT " + pqxx::to_string(200 + i)));
+
+  for (int i{0}; i < 20; ++i)
+    PQXX_CHECK_EQUAL(
+      pipe.retrieve(ids[std::size_t(i)]).at(0).at(0).as<int>(), 200 + i,
+      "Adaptive batching broke pipeline results.");
+  PQXX_CHECK(pipe.empty(), "Pipeline not empty after retrieving everything.");
+  PQXX_CHECK(
+    pipe.round_trip() > std::chrono::steady_clock::duration::zero(),
+    "Pipeline did not measure round-trip time.");
+
+  // Going back to a fixed count works as before.
+  pipe.retain(0);
+  auto const last{pipe.insert("SELECT 1")};
+  PQXX_CHECK_EQUAL(
+    pipe.retrieve(last).at(0).at(0).as<int>(), 1,
+    "Pipeline broke after leaving adaptive batching.");
+}
+
+
+void test_pipeline_nonblocking()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::pipeline pipe{tx};
+  PQXX_CHECK(not pipe.nonblocking(), "Pipeline is non-blocking by default.");
+  pipe.set_nonblocking();
+  PQXX_CHECK(pipe.nonblocking(), "set_nonblocking() did not stick.");
+
+  // Enough big queries to fill up the socket's send buffer.
+  pipe.retain(500);
+  std::string const padding(1000, ' ');
+  std::vector<pqxx::pipeline::query_id> ids;
+  for (int i{0}; i < 500; ++i)
+    ids.push_back(pipe.insert("SELECT " + pqxx::to_string(i) + padding));
+  pipe.complete();
+  for (int i{0}; i < 500; ++i)
+    PQXX_CHECK_EQUAL(
+      pipe.retrieve(ids[static_cast<std::size_t>(i)])[0][0].as<int>(), i,
+      "Non-blocking pipeline returned wrong result.");
+
+  // Once the pipeline is done, the connection is back to normal.
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 7"), 7, "Query after pipeline went wrong.");
+  pipe.set_nonblocking(false);
+  PQXX_CHECK(not pipe.nonblocking(), "Could not switch back to blocking.");
+}
+
+
+void test_pipeline_callbacks()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::pipeline pipe{tx};
+  pipe.retain(0);
+
+  // Each result goes to its callback, which may insert dependent queries.
+  std::vector<int> values;
+  pipe.insert("SELECT 1", [&](auto, pqxx::result const &r) {
+    values.push_back(r.at(0).at(0).as<int>());
+    pipe.insert(
+      "SELECT " + pqxx::to_string(values.back() + 1),
+      [&](auto, pqxx::result const &r2) {
+        values.push_back(r2.at(0).at(0).as<int>());
+      });
+  });
+
+  auto const params{pipe.insert_params("SELECT $1::integer", 10)};
+  auto future{pipe.get_future(params)};
+
+  pipe.complete();
+
+  PQXX_CHECK_EQUAL(std::size(values), 2u, "Wrong number of callbacks.");
+  PQXX_CHECK_EQUAL(values[0], 1, "Wrong result in callback.");
+  PQXX_CHECK_EQUAL(values[1], 2, "Wrong result in dependent callback.");
+  PQXX_CHECK_EQUAL(
+    future.get().at(0).at(0).as<int>(), 10, "Wrong result in future.");
+  PQXX_CHECK(pipe.empty(), "Delivered results remained in pipeline.");
+
+  // A future stores the error from a failed query.
+  auto failed{pipe.get_future(pipe.insert("SELECT nonexistent_column"))};
+  pipe.complete();
+  PQXX_CHECK_THROWS(
+    failed.get(), pqxx::sql_error, "Future did not report failed query.");
+}
+
+
+void test_pipeline_discard()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE pqxx_discard (x integer)");
+  pqxx::pipeline pipe{tx};
+  pipe.retain(10);
+
+  for (int i{0}; i < 100; ++i)
+    pipe.insert_discard(
+      "INSERT INTO pqxx_discard VALUES (" + pqxx::to_string(i) + ")");
+  PQXX_CHECK(not pipe.discarding_results(), "Discarding is on by default.");
+  pipe.discard_results();
+  for (int i{100}; i < 200; ++i)
+    pipe.insert_params("INSERT INTO pqxx_discard VALUES ($1)", i);
+  // A future takes the place of the discarding.
+  auto count{
+    pipe.get_future(pipe.insert("SELECT count(*) FROM pqxx_discard"))};
+  pipe.complete();
+  PQXX_CHECK(pipe.empty(), "Discarded results stayed in the pipeline.");
+  PQXX_CHECK_EQUAL(
+    count.get().at(0).at(0).as<int>(), 200, "Discarded queries did not run.");
+
+  // A failure still comes out.
+  pipe.insert("SELECT nonexistent_column");
+  PQXX_CHECK_THROWS(
+    pipe.complete(), pqxx::sql_error, "Discarding hid an error.");
+}
+
+
+void test_pipeline_resubmit()
+{
+  pqxx::connection conn, killer;
+  {
+    pqxx::work tx{conn};
+    pqxx::pipeline pipe{tx};
+    PQXX_CHECK_THROWS(
+      pipe.set_resubmit(), pqxx::usage_error,
+      "Pipeline resubmitted queries in a regular transaction.");
+  }
+
+  pqxx::nontransaction tx{conn};
+  pqxx::pipeline pipe{tx};
+  try
+  {
+    pipe.set_resubmit();
+  }
+  catch (pqxx::feature_not_supported const &)
+  {
+    // No pipeline mode in this libpq.
+    return;
+  }
+  PQXX_CHECK(pipe.resubmit_enabled(), "Resubmission did not enable.");
+  pipe.retain(10);
+
+  // Break the connection, then issue queries into the void.
+  pqxx::ignore_unused(pqxx::nontransaction{killer}.exec1(
+    "SELECT pg_terminate_backend(" + pqxx::to_string(conn.backendpid()) +
+    ")"));
+  std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+  auto const safe{pipe.insert("SELECT 1")};
+  pipe.mark_idempotent(safe);
+  auto const unsafe{pipe.insert("SELECT 2")};
+  auto const later{pipe.insert_params("SELECT $1::integer", 3)};
+  pipe.mark_idempotent(later);
+  pipe.resume();
+
+  PQXX_CHECK_EQUAL(
+    pipe.retrieve(safe).at(0).at(0).as<int>(), 1,
+    "Idempotent query was not resubmitted.");
+  PQXX_CHECK_THROWS(
+    pipe.retrieve(unsafe), pqxx::in_doubt_error,
+    "Non-idempotent query was not in doubt.");
+  PQXX_CHECK_EQUAL(
+    pipe.retrieve(later).at(0).at(0).as<int>(), 3,
+    "Query after in-doubt one was lost.");
+  PQXX_CHECK_EQUAL(std::size(pipe.in_doubt()), 1u, "Wrong in-doubt count.");
+  PQXX_CHECK_EQUAL(pipe.in_doubt()[0], unsafe, "Wrong query in doubt.");
+  PQXX_CHECK(conn.is_open(), "Pipeline did not reconnect.");
+}
 } // namespace
 
 PQXX_REGISTER_TEST(test_pipeline);
+PQXX_REGISTER_TEST(test_pipeline_nonblocking);
+PQXX_REGISTER_TEST(test_pipeline_adaptive_batching);
+PQXX_REGISTER_TEST(test_pipeline_callbacks);
+PQXX_REGISTER_TEST(test_pipeline_discard);
+PQXX_REGISTER_TEST(test_pipeline_overlapping_batches);
+PQXX_REGISTER_TEST(test_pipeline_params);
+PQXX_REGISTER_TEST(test_pipeline_resubmit);
+PQXX_REGISTER_TEST(test_pipeline_temporary_bytes);
@@ -1,7 +1,12 @@
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <list>
+#include <optional>
+#include <tuple>
+#include <vector>
 
 #include "../test_helpers.hxx"
 
@@ -170,6 +175,46 @@ void test_binary()
   PQXX_CHECK_EQUAL(
     pqxx::binarystring(rw.front()).str(), input,
     "Binary string came out damaged.");
+
+  std::vector<std::uint8_t> const raw(std::begin(input), std::end(input));
+  PQXX_CHECK_EQUAL(
+    pqxx::binarystring(tx.exec_prepared1("EchoBin", raw).front()).str(),
+    input, "Raw binary parameter came out damaged.");
+}
+
+
+void test_binary_params()
+{
+  using pqxx::prepare::make_binary_param;
+  pqxx::connection c;
+  pqxx::work tx{c};
+
+  // In exec_params, a binary parameter tells the server its type.
+  auto const sum{
+    tx.exec_params1("SELECT $1 + $2", make_binary_param(40), 2)[0]};
+  PQXX_CHECK_EQUAL(sum.as<int>(), 42, "Binary integer came out wrong.");
+  auto const types{tx.exec_params1(
+    "SELECT pg_typeof($1)::text, pg_typeof($2)::text, pg_typeof($3)::text",
+    make_binary_param(short{1}), make_binary_param(2.5),
+    make_binary_param(true))};
+  PQXX_CHECK_EQUAL(types[0].as<std::string>(), "smallint", "Bad type.");
+  PQXX_CHECK_EQUAL(
+    types[1].as<std::string>(), "double precision", "Bad type.");
+  PQXX_CHECK_EQUAL(types[2].as<std::string>(), "boolean", "Bad type.");
+
+  // In a prepared statement, it must match the parameter's type exactly.
+  c.prepare("BinTwice", "SELECT 2 * $1::bigint, $2::double precision");
+  auto const r{tx.exec_prepared1(
+    "BinTwice", make_binary_param(-21LL), make_binary_param(0.25))};
+  PQXX_CHECK_EQUAL(r[0].as<long long>(), -42LL, "Binary bigint went wrong.");
+  PQXX_CHECK_BOUNDS(
+    r[1].as<double>(), 0.2499, 0.2501, "Binary double went wrong.");
+
+  std::optional<int> const none;
+  PQXX_CHECK(
+    tx.exec_params1("SELECT $1::integer", make_binary_param(none))[0]
+      .is_null(),
+    "Null binary parameter did not come out as null.");
 }
 
 
@@ -217,6 +262,507 @@ void test_optional()
 }
 
 
+void test_bulk()
+{
+  pqxx::connection c;
+  pqxx::work tx{c};
+  tx.exec0("CREATE TEMP TABLE bulk (id integer, name text)");
+  c.prepare("bulk_insert", "INSERT INTO bulk (id, name) VALUES ($1, $2)");
+
+  std::vector<std::tuple<int, std::optional<std::string>>> rows;
+  for (int i{0}; i < 1000; ++i)
+    rows.emplace_back(
+      i, (i % 7 == 0) ? std::optional<std::string>{} : pqxx::to_string(i));
+  auto const counts{tx.exec_prepared_bulk("bulk_insert", rows)};
+  PQXX_CHECK_EQUAL(std::size(counts), std::size(rows), "Wrong count.");
+  for (auto const n : counts)
+    PQXX_CHECK_EQUAL(n, 1, "Bulk insert affected wrong number of rows.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM bulk WHERE name IS NULL"), 143,
+    "Nulls went wrong in bulk execution.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT sum(id) FROM bulk"), 999 * 1000 / 2,
+    "Wrong data after bulk execution.");
+
+  c.prepare("bulk_update", "UPDATE bulk SET id = id + $2 WHERE id < $1");
+  std::vector<std::pair<int, int>> const limits{{10, 0}, {0, 0}};
+  PQXX_CHECK(
+    tx.exec_prepared_bulk("bulk_update", limits) ==
+      (std::vector<pqxx::result::size_type>{10, 0}),
+    "Bulk execution reported wrong affected rows.");
+
+  PQXX_CHECK(
+    std::empty(tx.exec_prepared_bulk(
+      "bulk_insert", std::vector<std::tuple<int, std::string>>{})),
+    "Empty bulk execution produced results.");
+
+  std::vector<std::tuple<std::string, int>> const bad{
+    {"1", 0}, {"x", 0}, {"3", 0}};
+  PQXX_CHECK_THROWS(
+    tx.exec_prepared_bulk("bulk_update", bad), pqxx::sql_error,
+    "Failing bulk execution did not throw.");
+}
+
+
+void test_insert_bulk()
+{
+  pqxx::connection c;
+  pqxx::work tx{c};
+  tx.exec0("CREATE TEMP TABLE upsert (id integer PRIMARY KEY, name text)");
+
+  std::vector<std::tuple<int, std::optional<std::string>>> rows;
+  for (int i{0}; i < 1000; ++i)
+    rows.emplace_back(
+      i, (i % 7 == 0) ? std::optional<std::string>{} : pqxx::to_string(i));
+
+  // Force several statements, of different sizes.
+  pqxx::bulk_insert_limits const limits{300, 1000};
+  PQXX_CHECK_EQUAL(
+    tx.insert_bulk("upsert", {"id", "name"}, rows, "", limits), 1000u,
+    "Wrong number of rows inserted.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM upsert WHERE name IS NULL"),
+    143, "Nulls went wrong in bulk insert.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT sum(id) FROM upsert"), 999 * 1000 / 2,
+    "Wrong data after bulk insert.");
+
+  std::vector<std::string> const columns{"id", "name"};
+  std::vector<std::pair<int, std::string>> const updates{
+    {1, "one"}, {1000, "thousand"}};
+  PQXX_CHECK_EQUAL(
+    tx.insert_bulk(
+      "upsert", columns, updates,
+      "ON CONFLICT (id) DO UPDATE SET name = excluded.name"),
+    2u, "Upsert affected wrong number of rows.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<std::string>("SELECT name FROM upsert WHERE id = 1"),
+    "one", "Upsert did not update.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM upsert"), 1001,
+    "Upsert did not insert.");
+
+  PQXX_CHECK_EQUAL(
+    tx.insert_bulk(
+      "upsert", columns, std::vector<std::tuple<int, std::string>>{}),
+    0u, "Empty bulk insert affected rows.");
+  PQXX_CHECK_THROWS(
+    tx.insert_bulk("upsert", {"id"}, updates), pqxx::usage_error,
+    "Bulk insert accepted rows with the wrong number of fields.");
+}
+
+
+/// Count the server-side prepared statements in the session.
+int count_prepared(pqxx::transaction_base &tx)
+{
+  return tx.query_value<int>("SELECT count(*) FROM pg_prepared_statements");
+}
+
+
+void test_auto_prepare()
+{
+  pqxx::connection c;
+  c.set_auto_prepare(2, 2);
+  pqxx::work tx{c};
+  int const base{count_prepared(tx)};
+
+  PQXX_CHECK_EQUAL(
+    tx.exec_params1("SELECT $1::integer + 1", 1)[0].as<int>(), 2,
+    "Bad result before automatic preparation.");
+  PQXX_CHECK_EQUAL(c.auto_prepared(), 0u, "Prepared query too early.");
+
+  PQXX_CHECK_EQUAL(
+    tx.exec_params1("SELECT $1::integer + 1", 2)[0].as<int>(), 3,
+    "Bad result from automatically prepared query.");
+  PQXX_CHECK_EQUAL(c.auto_prepared(), 1u, "Query was not prepared.");
+  PQXX_CHECK_EQUAL(count_prepared(tx), base + 1, "No statement on server.");
+
+  // Two more queries push the first one out of the cache.
+  tx.exec_params("SELECT $1::integer + 2", 1);
+  tx.exec_params("SELECT $1::integer + 3", 1);
+  PQXX_CHECK_EQUAL(c.auto_prepared(), 0u, "Evicted query stayed prepared.");
+  PQXX_CHECK_EQUAL(count_prepared(tx), base, "Evicted query not deallocated.");
+
+  tx.exec_params("SELECT $1::integer + 3", 1);
+  PQXX_CHECK_EQUAL(c.auto_prepared(), 1u, "Query was not prepared.");
+  c.set_auto_prepare(0);
+  PQXX_CHECK_EQUAL(c.auto_prepared(), 0u, "Disabling left statements.");
+  PQXX_CHECK_EQUAL(count_prepared(tx), base, "Disabling did not deallocate.");
+
+  PQXX_CHECK_THROWS(
+    c.set_auto_prepare(1, 0), pqxx::argument_error,
+    "Auto-prepare accepted zero capacity.");
+}
+
+
+/// Check how parameters encode, without running any statements.
+void test_params_encoding()
+{
+  std::string const big(1000, 'x');
+  std::vector<int> many(40);
+  for (std::size_t i{0}; i < std::size(many); ++i)
+    many[i] = static_cast<int>(i);
+
+  pqxx::internal::params const p{
+    1,
+    nullptr,
+    std::string{"two"},
+    std::optional<int>{},
+    pqxx::zview{"three"},
+    big,
+    pqxx::internal::dynamic_params{std::begin(many), std::end(many)}};
+  // Copying must not invalidate anything, even though values are inline.
+  auto const copy{p};
+  auto const pointers{copy.get_pointers()};
+  PQXX_CHECK_EQUAL(std::size(copy.lengths), 46u, "Wrong parameter count.");
+
+  PQXX_CHECK_EQUAL(std::string{pointers[0]}, "1", "Bad int parameter.");
+  PQXX_CHECK_EQUAL(copy.lengths[0], 1, "Bad length.");
+  PQXX_CHECK(pointers[1] == nullptr, "Null parameter is not null.");
+  PQXX_CHECK_EQUAL(copy.nonnulls[1], 0, "Null parameter marked non-null.");
+  PQXX_CHECK_EQUAL(std::string{pointers[2]}, "two", "Bad string.");
+  PQXX_CHECK(pointers[3] == nullptr, "Empty optional is not null.");
+  PQXX_CHECK_EQUAL(std::string{pointers[4]}, "three", "Bad zview.");
+  PQXX_CHECK_EQUAL(std::string{pointers[5]}, big, "Bad long string.");
+  PQXX_CHECK_EQUAL(copy.lengths[5], 1000, "Bad long string length.");
+  PQXX_CHECK_EQUAL(std::string{pointers[45]}, "39", "Bad dynamic param.");
+
+  std::optional<double> const half{0.5};
+  pqxx::internal::params const bin{
+    pqxx::prepare::make_binary_param(258), 1,
+    pqxx::prepare::make_binary_param(half)};
+  PQXX_CHECK_EQUAL(bin.binaries[0], 1, "Binary param not marked binary.");
+  PQXX_CHECK_EQUAL(bin.lengths[0], 4, "Wrong binary int size.");
+  PQXX_CHECK_EQUAL(bin.types[0], 23u, "Wrong type for binary int.");
+  PQXX_CHECK_EQUAL(bin.binaries[1], 0, "Text param marked binary.");
+  PQXX_CHECK_EQUAL(bin.types[1], 0u, "Text param has a type.");
+  PQXX_CHECK_EQUAL(bin.types[2], 701u, "Wrong type for binary double.");
+  PQXX_CHECK(bin.has_types(), "Typed params not recognised.");
+  PQXX_CHECK(not copy.has_types(), "Untyped params have types.");
+  auto const bytes{bin.get_pointers()[0]};
+  PQXX_CHECK_EQUAL(
+    std::string(bytes, 4), (std::string{"\0\0\1\2", 4}),
+    "Binary int not in network byte order.");
+
+  auto reused{copy};
+  reused.assign(7);
+  PQXX_CHECK_EQUAL(std::size(reused.lengths), 1u, "assign() did not reset.");
+  PQXX_CHECK_EQUAL(
+    std::string{reused.get_pointers()[0]}, "7", "Bad reassigned value.");
+
+  reused.append(nullptr, "eight");
+  PQXX_CHECK_EQUAL(reused.size(), 3u, "append() did not add parameters.");
+  PQXX_CHECK_EQUAL(
+    std::string{reused.get_pointers()[0]}, "7", "append() lost a value.");
+  PQXX_CHECK(reused.get_pointers()[1] == nullptr, "append() lost a null.");
+  PQXX_CHECK_EQUAL(
+    std::string{reused.get_pointers()[2]}, "eight", "Bad appended value.");
+  PQXX_CHECK_EQUAL(reused.value_bytes(), 8u, "Wrong value_bytes().");
+  reused.clear();
+  PQXX_CHECK_EQUAL(reused.size(), 0u, "clear() left parameters.");
+}
+
+
+/// Raw binary parameters point to the caller's data, instead of copying it.
+void test_borrowed_params()
+{
+  std::vector<std::byte> const blob{
+    std::byte{'a'}, std::byte{0}, std::byte{0xff}};
+  std::vector<std::uint8_t> const empty;
+
+  pqxx::internal::params const p{"x", blob, 2, empty, nullptr, blob};
+  PQXX_CHECK_EQUAL(p.size(), 6u, "Wrong parameter count.");
+  auto const pointers{p.get_pointers()};
+  PQXX_CHECK(
+    pointers[1] == reinterpret_cast<char const *>(std::data(blob)),
+    "Raw binary parameter was copied.");
+  PQXX_CHECK_EQUAL(p.lengths[1], 3, "Wrong raw binary length.");
+  PQXX_CHECK_EQUAL(p.binaries[1], 1, "Raw binary param not marked binary.");
+  PQXX_CHECK_EQUAL(std::string{pointers[2]}, "2", "Value after raw is off.");
+  PQXX_CHECK(pointers[3] != nullptr, "Empty raw binary became null.");
+  PQXX_CHECK_EQUAL(p.lengths[3], 0, "Empty raw binary has a length.");
+  PQXX_CHECK(pointers[4] == nullptr, "Null after raw binary is off.");
+  PQXX_CHECK(
+    pointers[5] == reinterpret_cast<char const *>(std::data(blob)),
+    "Second raw binary parameter is off.");
+  PQXX_CHECK_EQUAL(p.value_bytes(), 10u, "Wrong value_bytes().");
+
+  // Same values, same encoding, even if they're in different places.
+  auto const other_blob{blob};
+  pqxx::internal::params const q{"x", other_blob, 2, empty, nullptr, blob};
+  std::string p_key, q_key;
+  p.encode(p_key);
+  q.encode(q_key);
+  PQXX_CHECK_EQUAL(p_key, q_key, "Borrowed parameters encode differently.");
+
+  // Once it owns its values, a params object no longer points to ours.
+  auto owned{p};
+  owned.own();
+  auto const owned_pointers{owned.get_pointers()};
+  PQXX_CHECK(
+    owned_pointers[1] != reinterpret_cast<char const *>(std::data(blob)),
+    "own() did not copy raw binary parameter.");
+  PQXX_CHECK_EQUAL(
+    std::string(owned_pointers[1], 3), (std::string{"a\0\xff", 3}),
+    "own() garbled raw binary parameter.");
+  PQXX_CHECK_EQUAL(
+    std::string{owned_pointers[0]}, "x", "own() garbled value before raw.");
+  PQXX_CHECK_EQUAL(
+    std::string{owned_pointers[2]}, "2", "own() garbled value after raw.");
+  PQXX_CHECK(owned_pointers[3] != nullptr, "own() made empty raw null.");
+  PQXX_CHECK_EQUAL(owned.lengths[3], 0, "own() gave empty raw a length.");
+  PQXX_CHECK(owned_pointers[4] == nullptr, "own() lost a null.");
+  PQXX_CHECK_EQUAL(owned.value_bytes(), p.value_bytes() + 3, "Bad size.");
+  std::string owned_key;
+  owned.encode(owned_key);
+  PQXX_CHECK_EQUAL(owned_key, p_key, "own() changed the encoding.");
+}
+
+
+void test_shared_query_text()
+{
+  pqxx::connection conn;
+  pqxx::nontransaction tx{conn};
+
+  auto const r1{tx.exec("SELECT 1")}, r2{tx.exec("SELECT 1")};
+  PQXX_CHECK(
+    &r1.query() == &r2.query(), "Identical queries did not share text.");
+  auto const r3{tx.exec("SELECT 2")};
+  PQXX_CHECK_EQUAL(r3.query(), "SELECT 2", "Wrong query text.");
+  PQXX_CHECK_EQUAL(r1.query(), "SELECT 1", "Shared query text changed.");
+
+  conn.prepare("shared_name", "SELECT $1::integer");
+  auto const p1{tx.exec_prepared("shared_name", 1)};
+  tx.exec("SELECT 3");
+  auto const p2{tx.exec_prepared("shared_name", 2)};
+  PQXX_CHECK(
+    &p1.query() == &p2.query(), "Prepared statement name was not interned.");
+  PQXX_CHECK_EQUAL(p2.query(), "shared_name", "Wrong statement name.");
+  conn.unprepare("shared_name");
+  PQXX_CHECK_EQUAL(
+    p1.query(), "shared_name", "Unprepare broke an existing result.");
+}
+
+
+void test_prepare_all()
+{
+  pqxx::connection conn;
+  conn.set_reconnect(true);
+  // The type oid for bigint is 20.
+  conn.prepare_all({
+    {"all_answer", "SELECT 42"},
+    {"all_double", "SELECT 2 * $1", {20}},
+  });
+  {
+    pqxx::work tx{conn};
+    PQXX_CHECK_EQUAL(
+      tx.exec_prepared1("all_answer")[0].as<int>(), 42,
+      "Batch-prepared statement gave the wrong answer.");
+    PQXX_CHECK_EQUAL(
+      tx.exec_prepared1("all_double", 21)[0].as<long long>(), 42LL,
+      "Batch-prepared statement with types went wrong.");
+    PQXX_CHECK_EQUAL(
+      tx.query_value<std::string>(
+        "SELECT parameter_types::text FROM pg_prepared_statements "
+        "WHERE name = 'all_double'"),
+      "{bigint}", "Parameter type did not make it to the server.");
+  }
+
+  // A bad statement stops the batch, but the ones before it are prepared.
+  PQXX_CHECK_THROWS(
+    conn.prepare_all({
+      {"all_good", "SELECT 1"},
+      {"all_bad", "SELECT * FROM nonexistent_table"},
+      {"all_skipped", "SELECT 2"},
+    }),
+    pqxx::sql_error, "Bad statement in batch did not fail.");
+  pqxx::work tx{conn};
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>(
+      "SELECT count(*) FROM pg_prepared_statements "
+      "WHERE name IN ('all_good', 'all_bad', 'all_skipped')"),
+    1, "Wrong statements prepared after failure.");
+  tx.commit();
+
+  // Statements come back on reconnect, with their types.
+  conn.reconnect();
+  pqxx::work tx2{conn};
+  PQXX_CHECK_EQUAL(
+    tx2.exec_prepared1("all_double", 4)[0].as<long long>(), 8LL,
+    "Batch-prepared statement did not survive reconnect.");
+}
+
+
+void test_by_keys()
+{
+  pqxx::connection c;
+  pqxx::work tx{c};
+  tx.exec0(
+    "CREATE TEMP TABLE keyed AS "
+    "SELECT n AS id, 'x' || n AS name FROM generate_series(1, 100) AS n");
+
+  std::vector<int> const ids{3, 5, 7, 1000};
+  auto const r{tx.select_by_keys("keyed", "id", ids, "id, name")};
+  PQXX_CHECK_EQUAL(std::size(r), 3, "Wrong number of rows selected by key.");
+  PQXX_CHECK_EQUAL(
+    tx.select_by_keys("keyed", "id", std::vector<long long>{}).size(), 0,
+    "Empty key list selected rows.");
+
+  // Text keys go as a text array.
+  std::vector<std::string> const names{"x10", "x20", "x'\"\\"};
+  PQXX_CHECK_EQUAL(
+    std::size(tx.select_by_keys("keyed", "name", names)), 2,
+    "Wrong number of rows selected by text key.");
+
+  std::vector<long long> doomed;
+  for (long long i{1}; i <= 50; ++i) doomed.push_back(i);
+  PQXX_CHECK_EQUAL(
+    tx.delete_by_keys("keyed", "id", doomed, 7), 50u,
+    "Chunked delete by keys deleted wrong number of rows.");
+  PQXX_CHECK_EQUAL(
+    tx.delete_by_keys("keyed", "name", names), 0u,
+    "Deleted already-deleted rows.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT min(id) FROM keyed"), 51,
+    "Delete by keys deleted the wrong rows.");
+}
+
+
+void test_typed_prepare_and_describe()
+{
+  pqxx::connection conn;
+  conn.prepare(
+    "typed", "SELECT $1 + 1 AS next, $2 AS label",
+    pqxx::prepare::types<long long, pqxx::oid>());
+
+  auto const &desc{conn.describe_prepared("typed")};
+  PQXX_CHECK_EQUAL(
+    std::size(desc.param_types), 2u, "Wrong number of parameter types.");
+  // The type oids for bigint and oid are 20 and 26.
+  PQXX_CHECK_EQUAL(desc.param_types[0], 20u, "Parameter type got lost.");
+  PQXX_CHECK_EQUAL(desc.param_types[1], 26u, "Second parameter type wrong.");
+  PQXX_CHECK_EQUAL(
+    std::size(desc.column_names), 2u, "Wrong number of columns.");
+  PQXX_CHECK_EQUAL(desc.column_names[0], "next", "Wrong column name.");
+  PQXX_CHECK((desc.binary_matches<long long, pqxx::oid>()), "No match.");
+  PQXX_CHECK(
+    not(desc.binary_matches<int, pqxx::oid>()), "Wrong type matched.");
+  PQXX_CHECK(not(desc.binary_matches<long long>()), "Wrong width matched.");
+  PQXX_CHECK(
+    &conn.describe_prepared("typed") == &desc, "Description not cached.");
+
+  pqxx::work tx{conn};
+  auto const r{tx.exec_prepared_as<long long, pqxx::oid>("typed", 41, 7)};
+  PQXX_CHECK(r[0][0].is_binary(), "Matching types did not get binary.");
+  for (auto [next, label] : r.iter<long long, pqxx::oid>())
+  {
+    PQXX_CHECK_EQUAL(next, 42LL, "Wrong binary value.");
+    PQXX_CHECK_EQUAL(label, 7u, "Wrong second binary value.");
+  }
+  auto const t{tx.exec_prepared_as<std::string, int>("typed", 41, 7)};
+  PQXX_CHECK(not t[0][0].is_binary(), "Mismatched types got binary.");
+  PQXX_CHECK_EQUAL(t[0][0].as<std::string>(), "42", "Wrong text value.");
+  tx.commit();
+
+  conn.unprepare("typed");
+  PQXX_CHECK_THROWS(
+    std::ignore = conn.describe_prepared("typed"), pqxx::sql_error,
+    "Description outlived its statement.");
+}
+
+
+void test_prepared_handle()
+{
+  pqxx::connection conn;
+  auto add{conn.prepare<int, long long, std::string>(
+    "handle_add", "SELECT $1 + $2, $3 || '!', pg_typeof($1)::text")};
+  PQXX_CHECK_EQUAL(add.name(), "handle_add", "Wrong statement name.");
+
+  pqxx::work tx{conn};
+  for (int i{0}; i < 3; ++i)
+  {
+    auto const r{tx.exec_prepared(add, i, 10LL, "hi")};
+    PQXX_CHECK_EQUAL(r[0][0].as<long long>(), i + 10LL, "Bad sum.");
+    PQXX_CHECK_EQUAL(r[0][1].as<std::string>(), "hi!", "Bad text param.");
+    PQXX_CHECK_EQUAL(
+      r[0][2].as<std::string>(), "integer", "Handle did not declare type.");
+  }
+
+  // The handle's buffer gets the arguments in the right formats.
+  auto const &p{add.bind(1, 2LL, "x")};
+  PQXX_CHECK_EQUAL(p.binaries[0], 1, "int argument not binary.");
+  PQXX_CHECK_EQUAL(p.binaries[1], 1, "long long argument not binary.");
+  PQXX_CHECK_EQUAL(p.binaries[2], 0, "String argument binary.");
+
+  auto none{
+    conn.prepare<std::optional<int>>("handle_null", "SELECT $1::integer")};
+  PQXX_CHECK(
+    tx.exec_prepared(none, std::optional<int>{})[0][0].is_null(),
+    "Null through handle did not come out null.");
+}
+
+
+void test_exec_prepared_mixed()
+{
+  pqxx::connection conn;
+  conn.prepare(
+    "mixed", "SELECT 7::integer AS n, 'x'::text AS t, '{}'::json AS j");
+  conn.prepare("dated", "SELECT 7::integer AS n, '2020-01-01'::date AS d");
+  conn.prepare("texty", "SELECT 'x'::varchar AS v");
+
+  auto const &desc{conn.describe_prepared("mixed")};
+  PQXX_CHECK(
+    desc.column_formats[0] == pqxx::format::binary,
+    "Integer column does not prefer binary.");
+  PQXX_CHECK(
+    desc.column_formats[1] == pqxx::format::text,
+    "Text column does not prefer text.");
+
+  pqxx::work tx{conn};
+  auto const r{tx.exec_prepared_mixed("mixed")};
+  PQXX_CHECK(r[0][0].is_binary(), "Integer did not come in binary.");
+  PQXX_CHECK(not r[0][1].is_binary(), "Text column is not text.");
+  PQXX_CHECK(not r[0][2].is_binary(), "JSON column is not text.");
+  PQXX_CHECK_EQUAL(r[0][0].as<int>(), 7, "Bad binary integer.");
+  PQXX_CHECK_EQUAL(r[0][1].as<std::string>(), "x", "Bad text field.");
+  PQXX_CHECK_EQUAL(
+    std::string{r[0][2].c_str()}, "{}", "Bad JSON as C-style string.");
+
+  auto const d{tx.exec_prepared_mixed("dated")};
+  PQXX_CHECK(
+    not d[0][0].is_binary(), "Date column did not force text format.");
+  PQXX_CHECK_EQUAL(d[0][1].as<std::string>(), "2020-01-01", "Bad date.");
+
+  auto const t{tx.exec_prepared_mixed("texty")};
+  PQXX_CHECK(not t[0][0].is_binary(), "All-text statement went binary.");
+}
+
+
+void test_exec_prepared_autocommit()
+{
+  pqxx::connection conn;
+  conn.prepare("add", "SELECT $1::integer + $2::integer");
+
+  auto const r{conn.exec_prepared_autocommit("add", 20, 22)};
+  PQXX_CHECK_EQUAL(std::size(r), 1, "Wrong number of rows.");
+  PQXX_CHECK_EQUAL(r[0][0].as<int>(), 42, "Wrong autocommit result.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(conn.exec_prepared_autocommit("nonexistent")),
+    pqxx::sql_error, "Nonexistent statement did not fail.");
+
+  {
+    pqxx::nontransaction tx{conn};
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(conn.exec_prepared_autocommit("add", 1, 2)),
+      pqxx::usage_error, "Autocommit statement ran inside a transaction.");
+  }
+  PQXX_CHECK_EQUAL(
+    conn.exec_prepared_autocommit("add", 1, 2)[0][0].as<int>(), 3,
+    "Autocommit statement did not work after transaction.");
+}
+
+
 void test_prepared_statements()
 {
   test_registration_and_invocation();
@@ -225,11 +771,24 @@ void test_prepared_statements()
   test_nulls();
   test_strings();
   test_binary();
+  test_binary_params();
   test_dynamic_params();
 
   test_optional();
+  test_bulk();
+  test_insert_bulk();
+  test_auto_prepare();
+  test_shared_query_text();
+  test_prepare_all();
+  test_by_keys();
+  test_typed_prepare_and_describe();
+  test_prepared_handle();
+  test_exec_prepared_mixed();
+  test_exec_prepared_autocommit();
 }
 
 
 PQXX_REGISTER_TEST(test_prepared_statements);
+PQXX_REGISTER_TEST(test_params_encoding);
+PQXX_REGISTER_TEST(test_borrowed_params);
 } // namespace
@@ -0,0 +1,238 @@
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <pqxx/nontransaction>
+#include <pqxx/pipeline>
+#include <pqxx/stream_from>
+#include <pqxx/stream_to>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+/// Collects the statistics which a connection reports.
+struct collector
+{
+  std::vector<pqxx::query_stats> stats;
+  std::vector<std::string> queries;
+
+  explicit collector(pqxx::connection &conn)
+  {
+    conn.set_query_hook([this](pqxx::query_stats const &s) {
+      stats.push_back(s);
+      queries.emplace_back(s.query);
+    });
+  }
+
+  pqxx::query_stats const &last() const { return stats.back(); }
+};
+
+
+void test_query_hook()
+{
+  pqxx::connection conn;
+  collector seen{conn};
+  pqxx::nontransaction tx{conn};
+
+  std::string const query{"SELECT generate_series(1, 3)"};
+  tx.exec(query);
+  PQXX_CHECK_EQUAL(std::size(seen.stats), 1u, "Expected one report.");
+  PQXX_CHECK(
+    seen.last().what == pqxx::query_stats::kind::query, "Wrong kind.");
+  PQXX_CHECK_EQUAL(seen.queries.back(), query, "Wrong query text.");
+  PQXX_CHECK_EQUAL(seen.last().rows, 3, "Wrong row count.");
+  PQXX_CHECK_EQUAL(seen.last().bytes_sent, std::size(query), "Bytes sent.");
+  PQXX_CHECK(seen.last().bytes_received > 0, "No bytes received.");
+  PQXX_CHECK(seen.last().elapsed.count() > 0, "No time elapsed.");
+  PQXX_CHECK(not seen.last().failed, "Query failed.");
+
+  conn.prepare("hook_stmt", "SELECT $1::integer + 1");
+  tx.exec_prepared("hook_stmt", 41);
+  PQXX_CHECK(
+    seen.last().what == pqxx::query_stats::kind::prepared,
+    "Prepared statement reported as something else.");
+  PQXX_CHECK_EQUAL(seen.queries.back(), "hook_stmt", "Wrong statement.");
+  PQXX_CHECK_EQUAL(
+    seen.last().bytes_sent, std::size("hook_stmt41") - 1,
+    "Parameters not counted.");
+
+  PQXX_CHECK_THROWS(
+    tx.exec("SELECT nonexistent_hook_column"), pqxx::sql_error,
+    "Bad query did not fail.");
+  PQXX_CHECK(seen.last().failed, "Failure was not reported.");
+
+  // Without a hook, nothing gets reported.
+  auto const count{std::size(seen.stats)};
+  conn.set_query_hook({});
+  tx.exec("SELECT 1");
+  PQXX_CHECK_EQUAL(std::size(seen.stats), count, "Reported without hook.");
+
+  // A hook which throws does not affect the query.
+  conn.set_query_hook(
+    [](pqxx::query_stats const &) { throw std::runtime_error{"Oops."}; });
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 9"), 9, "Throwing hook broke the query.");
+}
+
+
+void test_query_hook_batch()
+{
+  pqxx::connection conn;
+  collector seen{conn};
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE hook_bulk (id integer)");
+  conn.prepare("hook_insert", "INSERT INTO hook_bulk (id) VALUES ($1)");
+
+  std::vector<std::tuple<int>> rows;
+  for (int i{0}; i < 10; ++i) rows.emplace_back(i);
+  tx.exec_prepared_bulk("hook_insert", rows);
+  PQXX_CHECK(
+    seen.last().what == pqxx::query_stats::kind::batch,
+    "Bulk execution not reported as a batch.");
+  PQXX_CHECK_EQUAL(seen.last().statements, 10u, "Wrong statement count.");
+  PQXX_CHECK_EQUAL(seen.last().rows, 10, "Wrong row count for batch.");
+
+  seen.stats.clear();
+  pqxx::pipeline pipe{tx};
+  pipe.insert("SELECT generate_series(1, 2)");
+  pipe.insert("SELECT 3");
+  pipe.insert("SELECT generate_series(1, 4)");
+  pipe.complete();
+  std::size_t statements{0};
+  pqxx::result_size_type total{0};
+  for (auto const &s : seen.stats)
+    if (s.what == pqxx::query_stats::kind::batch)
+    {
+      statements += s.statements;
+      total += s.rows;
+    }
+  PQXX_CHECK_EQUAL(statements, 3u, "Pipeline statements went missing.");
+  PQXX_CHECK_EQUAL(total, 7, "Pipeline rows went missing.");
+}
+
+
+void test_query_hook_copy()
+{
+  pqxx::connection conn;
+  collector seen{conn};
+  pqxx::work tx{conn};
+
+  pqxx::stream_from out{tx, pqxx::from_query, "SELECT generate_series(1, 5)"};
+  std::tuple<int> row;
+  while (out >> row) {}
+  out.complete();
+  PQXX_CHECK(
+    seen.last().what == pqxx::query_stats::kind::copy,
+    "COPY out not reported as COPY.");
+  PQXX_CHECK_EQUAL(seen.last().rows, 5, "Wrong row count for COPY out.");
+  PQXX_CHECK(seen.last().bytes_received >= 10, "COPY data not counted.");
+
+  tx.exec0("CREATE TEMP TABLE hook_copy (id integer)");
+  pqxx::stream_to in{tx, "hook_copy"};
+  for (int i{0}; i < 4; ++i) in << std::make_tuple(i);
+  in.complete();
+  PQXX_CHECK(
+    seen.last().what == pqxx::query_stats::kind::copy,
+    "COPY in not reported as COPY.");
+  PQXX_CHECK_EQUAL(seen.last().rows, 4, "Wrong row count for COPY in.");
+  PQXX_CHECK(seen.last().bytes_sent >= 8, "COPY data not counted.");
+}
+
+
+
+void test_transaction_stats()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  std::vector<std::string> alerts;
+  tx.collect_stats(
+    pqxx::stats_limits{5, 3},
+    [&alerts](
+      pqxx::transaction_base const &, pqxx::transaction_stats const &,
+      std::string_view query) { alerts.emplace_back(query); });
+
+  // An N+1 pattern: the same query, over and over.
+  for (int i{0}; i < 4; ++i)
+    pqxx::ignore_unused(tx.exec_params("SELECT $1::integer", i));
+  auto const &stats{tx.stats()};
+  PQXX_CHECK(stats.round_trips >= 4, "Round trips not counted.");
+  PQXX_CHECK(stats.statements >= 4, "Statements not counted.");
+  PQXX_CHECK(stats.bytes_sent > 0, "Bytes sent not counted.");
+  PQXX_CHECK(stats.bytes_received > 0, "Bytes received not counted.");
+  PQXX_CHECK_EQUAL(stats.most_repeats, 4u, "Repeats not counted.");
+  PQXX_CHECK_EQUAL(std::size(alerts), 1u, "Repeat alert did not fire once.");
+  PQXX_CHECK_EQUAL(alerts[0], "SELECT $1::integer", "Alert for wrong query.");
+
+  pqxx::ignore_unused(tx.exec("SELECT 1"));
+  pqxx::ignore_unused(tx.exec("SELECT 2"));
+  PQXX_CHECK_EQUAL(std::size(alerts), 2u, "Round trip alert did not fire.");
+  pqxx::ignore_unused(tx.exec("SELECT 3"));
+  PQXX_CHECK_EQUAL(std::size(alerts), 2u, "Round trip alert fired again.");
+}
+
+
+void test_connection_transaction_stats()
+{
+  pqxx::connection conn;
+  {
+    pqxx::work tx{conn};
+    pqxx::ignore_unused(tx.exec("SELECT 1"));
+    PQXX_CHECK_EQUAL(tx.stats().round_trips, 0u, "Counted without asking.");
+  }
+  conn.collect_transaction_stats();
+  pqxx::work tx{conn};
+  pqxx::ignore_unused(tx.exec("SELECT 1"));
+  PQXX_CHECK(tx.stats().round_trips > 0, "Connection default not applied.");
+}
+
+
+void test_slow_query_log()
+{
+  pqxx::connection conn;
+  pqxx::slow_query_config config;
+  config.threshold = std::chrono::milliseconds{50};
+  config.capacity = 2;
+  config.explain_every = 1;
+  conn.set_slow_query_log(config);
+  conn.prepare("slow_sleep", "SELECT pg_sleep($1), $2::text AS tag");
+
+  pqxx::work tx{conn};
+  pqxx::ignore_unused(tx.exec("SELECT 1"));
+  PQXX_CHECK(std::empty(conn.slow_queries()), "Fast query logged as slow.");
+
+  pqxx::ignore_unused(tx.exec_params("SELECT pg_sleep($1)", 0.1));
+  pqxx::ignore_unused(tx.exec_prepared("slow_sleep", 0.1, "first"));
+  pqxx::ignore_unused(tx.exec_prepared("slow_sleep", 0.1, "second"));
+
+  // The log keeps only the last two.
+  auto const slow{conn.slow_queries()};
+  PQXX_CHECK_EQUAL(std::size(slow), 2u, "Wrong number of slow queries.");
+  PQXX_CHECK_EQUAL(slow[0].query, "slow_sleep", "Wrong statement logged.");
+  PQXX_CHECK(
+    slow[0].what == pqxx::query_stats::kind::prepared,
+    "Prepared statement logged as something else.");
+  PQXX_CHECK_EQUAL(std::size(slow[1].parameters), 2u, "Parameters missing.");
+  PQXX_CHECK_EQUAL(
+    slow[1].parameters[1].value_or(""), "second", "Wrong parameter.");
+  PQXX_CHECK(
+    slow[1].elapsed >= std::chrono::milliseconds{100}, "Wrong timing.");
+  PQXX_CHECK(
+    slow[1].plan.find("Result") != std::string::npos,
+    "No query plan: " + slow[1].plan);
+
+  conn.stop_slow_query_log();
+  PQXX_CHECK(std::empty(conn.slow_queries()), "Log survived stopping.");
+}
+
+PQXX_REGISTER_TEST(test_query_hook);
+PQXX_REGISTER_TEST(test_query_hook_batch);
+PQXX_REGISTER_TEST(test_query_hook_copy);
+PQXX_REGISTER_TEST(test_transaction_stats);
+PQXX_REGISTER_TEST(test_connection_transaction_stats);
+PQXX_REGISTER_TEST(test_slow_query_log);
+} // namespace
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <pqxx/nontransaction>
+#include <pqxx/reactor>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_reactor_queries()
+{
+  pqxx::connection c1, c2;
+  pqxx::reactor r;
+  r.add(c1);
+  r.add(c2);
+  PQXX_CHECK_EQUAL(r.size(), 2u, "Wrong number of connections in reactor.");
+
+  std::vector<int> got;
+  auto const keep{[&got](pqxx::result const &res, std::exception_ptr err) {
+    PQXX_CHECK(not err, "Query failed unexpectedly.");
+    got.push_back(res[0][0].as<int>());
+  }};
+  r.exec(c1, "SELECT 1", keep);
+  r.exec(c1, "SELECT 2", keep);
+  r.exec(c2, "SELECT 3", keep);
+  PQXX_CHECK_EQUAL(r.pending(), 3u, "Wrong number of pending queries.");
+
+  r.run();
+  PQXX_CHECK_EQUAL(r.pending(), 0u, "Queries still pending after run().");
+  PQXX_CHECK_EQUAL(std::size(got), 3u, "Wrong number of results.");
+
+  // Queries on one connection complete in the order in which we issued them.
+  auto const one{std::find(std::begin(got), std::end(got), 1)},
+    two{std::find(std::begin(got), std::end(got), 2)};
+  PQXX_CHECK(two != std::end(got), "Missing result.");
+  PQXX_CHECK(one < two, "Queries on a connection completed out of order.");
+
+  r.remove(c1);
+  PQXX_CHECK_EQUAL(r.size(), 1u, "Connection not removed.");
+  PQXX_CHECK_THROWS(
+    r.exec(c1, "SELECT 1", keep), pqxx::usage_error,
+    "Reactor accepted query on connection it doesn't watch.");
+}
+
+
+void test_reactor_error()
+{
+  pqxx::connection c;
+  pqxx::reactor r;
+  r.add(c);
+
+  bool failed{false}, succeeded{false};
+  r.exec(c, "SELECT nonexistent_column_in_reactor_test",
+    [&failed](pqxx::result const &, std::exception_ptr err) {
+      failed = bool(err);
+      PQXX_CHECK_THROWS(
+        std::rethrow_exception(err), pqxx::sql_error,
+        "Reactor reported the wrong kind of error.");
+    });
+  r.exec(c, "SELECT 1", [&succeeded](pqxx::result const &res, auto err) {
+    succeeded = (not err and res[0][0].as<int>() == 1);
+  });
+  r.run();
+  PQXX_CHECK(failed, "Failing query did not report its error.");
+  PQXX_CHECK(succeeded, "Error in one query broke the next.");
+}
+
+
+void test_reactor_futures()
+{
+  pqxx::connection c1, c2, c3;
+  c3.prepare("future_double", "SELECT 2 * $1::integer");
+  pqxx::reactor r;
+  r.add(c1);
+  r.add(c2);
+  r.add(c3);
+
+  // Fan out over all connections, and only then collect the results.
+  auto f1{r.async_exec(c1, "SELECT 1")};
+  auto f2{r.async_exec_params(c2, "SELECT $1::integer", 2)};
+  auto f3{r.async_exec_prepared(c3, "future_double", 3)};
+  auto bad{r.async_exec(c1, "SELECT nonexistent_column_in_future_test")};
+  PQXX_CHECK(not f3.ready(), "Future was ready before the reactor ran.");
+
+  auto const copy{f3};
+  PQXX_CHECK_EQUAL(f3.get()[0][0].as<int>(), 6, "Bad prepared result.");
+  PQXX_CHECK(copy.ready(), "Copy of a future did not share its outcome.");
+  PQXX_CHECK(f2.wait_for(std::chrono::seconds{30}), "Query timed out.");
+  PQXX_CHECK_EQUAL(f2.get()[0][0].as<int>(), 2, "Bad parameterised result.");
+  PQXX_CHECK_EQUAL(f1.get()[0][0].as<int>(), 1, "Bad plain result.");
+  PQXX_CHECK_THROWS(
+    bad.get(), pqxx::sql_error, "Future did not rethrow query's error.");
+  PQXX_CHECK_EQUAL(r.pending(), 0u, "Queries still pending.");
+}
+
+
+void test_reactor_query_timeout()
+{
+  pqxx::connection c;
+  pqxx::reactor r;
+  r.add(c);
+  r.set_query_timeout(c, std::chrono::milliseconds{200});
+
+  auto slow{r.async_exec(c, "SELECT pg_sleep(30)")};
+  auto const start{std::chrono::steady_clock::now()};
+  try
+  {
+    slow.get();
+    PQXX_CHECK_NOTREACHED("Slow query did not time out.");
+  }
+  catch (pqxx::sql_error const &e)
+  {
+    PQXX_CHECK_EQUAL(e.sqlstate(), "57014", "Wrong error for timeout.");
+  }
+  PQXX_CHECK(
+    std::chrono::steady_clock::now() - start < std::chrono::seconds{20},
+    "Query timeout took too long.");
+  PQXX_CHECK_EQUAL(
+    r.async_exec(c, "SELECT 1").get()[0][0].as<int>(), 1,
+    "Query after a timeout failed.");
+
+  r.set_query_timeout(c, std::chrono::milliseconds{0});
+  PQXX_CHECK_EQUAL(
+    r.async_exec(c, "SELECT pg_sleep(0.3), 2").get()[0][1].as<int>(), 2,
+    "Query timed out after disabling timeouts.");
+}
+
+
+class counting_receiver final : public pqxx::notification_receiver
+{
+public:
+  int count = 0;
+
+  counting_receiver(pqxx::connection &c, std::string const &channel) :
+          pqxx::notification_receiver(c, channel)
+  {}
+
+  void operator()(std::string const &, int) override { ++count; }
+};
+
+
+void test_reactor_notifications()
+{
+  pqxx::connection listener, notifier;
+  counting_receiver receiver{listener, "pqxx_reactor_test"};
+  pqxx::reactor r;
+  r.add(listener);
+
+  pqxx::nontransaction{notifier}.exec0("NOTIFY pqxx_reactor_test");
+
+  for (int i{0}; (i < 20) and (receiver.count == 0); ++i)
+    r.poll(std::chrono::milliseconds{500});
+  PQXX_CHECK_EQUAL(receiver.count, 1, "Reactor did not deliver notification.");
+}
+
+
+void test_reactor_offline()
+{
+  pqxx::reactor r;
+  PQXX_CHECK_EQUAL(
+    r.poll(std::chrono::milliseconds{0}), 0u,
+    "Empty reactor handled input.");
+  r.run();
+  PQXX_CHECK_EQUAL(r.size(), 0u, "Empty reactor has connections.");
+}
+
+
+PQXX_REGISTER_TEST(test_reactor_queries);
+PQXX_REGISTER_TEST(test_reactor_error);
+PQXX_REGISTER_TEST(test_reactor_futures);
+PQXX_REGISTER_TEST(test_reactor_query_timeout);
+PQXX_REGISTER_TEST(test_reactor_notifications);
+PQXX_REGISTER_TEST(test_reactor_offline);
+} // namespace
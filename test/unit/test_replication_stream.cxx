@@ -0,0 +1,114 @@
+#include <string>
+
+#include <pqxx/nontransaction>
+#include <pqxx/replication_stream>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_lsn_conversion()
+{
+  PQXX_CHECK_EQUAL(pqxx::parse_lsn("0/0"), pqxx::lsn{0}, "Bad zero LSN.");
+  PQXX_CHECK_EQUAL(
+    pqxx::parse_lsn("16/B374D848"), pqxx::lsn{0x16B374D848u},
+    "Bad LSN parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::parse_lsn("16/b374d848"), pqxx::lsn{0x16B374D848u},
+    "Lower-case LSN did not parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::lsn_to_string(0x16B374D848u), "16/B374D848", "Bad LSN string.");
+  PQXX_CHECK_EQUAL(pqxx::lsn_to_string(0), "0/0", "Bad zero LSN string.");
+  PQXX_CHECK_EQUAL(
+    pqxx::parse_lsn(pqxx::lsn_to_string(0xFFFFFFFFFFFFFFFFu)),
+    pqxx::lsn{0xFFFFFFFFFFFFFFFFu}, "Maximum LSN did not round-trip.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::parse_lsn("16B374D848")), pqxx::conversion_error,
+    "LSN without slash was accepted.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::parse_lsn("1/123456789")),
+    pqxx::conversion_error, "Overlong LSN was accepted.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::parse_lsn("1/X")), pqxx::conversion_error,
+    "Bad LSN digit was accepted.");
+}
+
+
+void test_replication_message_parsing()
+{
+  pqxx::replication_message message;
+  bool reply{false};
+
+  std::string data{"w"};
+  data.append(7, '\0').append("\x10");
+  data.append(7, '\0').append("\x20");
+  data.append(8, '\0').append("BEGIN 1");
+  PQXX_CHECK(
+    pqxx::internal::parse_replication_message(data, message, reply),
+    "Data message was not recognised.");
+  PQXX_CHECK_EQUAL(message.start, pqxx::lsn{0x10}, "Bad start position.");
+  PQXX_CHECK_EQUAL(message.server_end, pqxx::lsn{0x20}, "Bad end position.");
+  PQXX_CHECK_EQUAL(std::string{message.data}, "BEGIN 1", "Bad data.");
+  PQXX_CHECK(
+    std::data(message.data) == std::data(data) + 25,
+    "Message data was copied.");
+
+  std::string keepalive{"k"};
+  keepalive.append(7, '\0').append("\x30");
+  keepalive.append(8, '\0').append("\x01");
+  PQXX_CHECK(
+    not pqxx::internal::parse_replication_message(keepalive, message, reply),
+    "Keepalive looked like data.");
+  PQXX_CHECK_EQUAL(message.server_end, pqxx::lsn{0x30}, "Bad keepalive end.");
+  PQXX_CHECK(reply, "Keepalive reply request got lost.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::internal::parse_replication_message("w123", message, reply),
+    pqxx::failure, "Truncated message was accepted.");
+  PQXX_CHECK_THROWS(
+    pqxx::internal::parse_replication_message("?", message, reply),
+    pqxx::failure, "Unknown message type was accepted.");
+}
+
+
+void test_replication_stream()
+{
+  pqxx::connection conn;
+  {
+    // Logical decoding needs a server configured for it.
+    pqxx::nontransaction tx{conn};
+    if (tx.query_value<std::string>("SHOW wal_level") != "logical")
+      return;
+    tx.exec0(
+      "SELECT pg_create_logical_replication_slot("
+      "'pqxx_test_slot', 'test_decoding')");
+    // Temporary tables don't go into the WAL, so this needs a real one.
+    tx.exec0("CREATE TABLE pqxx_replicated (x integer)");
+    tx.exec0("INSERT INTO pqxx_replicated VALUES (42)");
+    tx.exec0("DROP TABLE pqxx_replicated");
+  }
+
+  pqxx::connection replication{
+    conn.connection_string() + " replication=database"};
+  pqxx::replication_stream stream{replication, "pqxx_test_slot"};
+  pqxx::replication_message message;
+  bool seen{false};
+  while (not seen and stream.read(message))
+  {
+    seen = (message.data.find("42") != std::string_view::npos);
+    stream.confirm(message.start);
+  }
+  PQXX_CHECK(seen, "Replication stream did not show the insert.");
+  stream.complete();
+  PQXX_CHECK(stream.done(), "Completed stream is not done.");
+
+  pqxx::nontransaction tx{conn};
+  tx.exec0("SELECT pg_drop_replication_slot('pqxx_test_slot')");
+}
+
+
+PQXX_REGISTER_TEST(test_lsn_conversion);
+PQXX_REGISTER_TEST(test_replication_message_parsing);
+PQXX_REGISTER_TEST(test_replication_stream);
+} // namespace
@@ -0,0 +1,142 @@
+#include <thread>
+#include <tuple>
+
+#include <pqxx/nontransaction>
+#include <pqxx/prepared_statement>
+#include <pqxx/result_cache>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+/// Prepare a statement whose result changes every time it executes.
+void prepare_counter(pqxx::connection &conn)
+{
+  pqxx::nontransaction{conn}.exec0(
+    "CREATE TEMP SEQUENCE IF NOT EXISTS pqxx_cache_seq");
+  conn.prepare("cache_count", "SELECT nextval('pqxx_cache_seq'), $1::integer");
+}
+
+
+void test_result_cache_hits()
+{
+  pqxx::connection conn;
+  prepare_counter(conn);
+  pqxx::result_cache cache{conn};
+  pqxx::nontransaction tx{conn};
+
+  auto const first{cache.exec_prepared(tx, "cache_count", 1)};
+  auto const again{cache.exec_prepared(tx, "cache_count", 1)};
+  PQXX_CHECK_EQUAL(
+    again[0][0].as<long>(), first[0][0].as<long>(),
+    "Repeated lookup executed the statement again.");
+  PQXX_CHECK(again == first, "Cache hit returned a different result.");
+
+  auto const other{cache.exec_prepared(tx, "cache_count", 2)};
+  PQXX_CHECK_NOT_EQUAL(
+    other[0][0].as<long>(), first[0][0].as<long>(),
+    "Different parameters got the same cached result.");
+  PQXX_CHECK_EQUAL(other[0][1].as<int>(), 2, "Wrong parameter.");
+
+  auto const stats{cache.stats()};
+  PQXX_CHECK_EQUAL(stats.hits, 1u, "Wrong hit count.");
+  PQXX_CHECK_EQUAL(stats.misses, 2u, "Wrong miss count.");
+  PQXX_CHECK_EQUAL(cache.size(), 2u, "Wrong cache size.");
+  PQXX_CHECK(cache.bytes() > 0, "Cached results take no memory.");
+
+  PQXX_CHECK_ALLOCATIONS(
+    cache.exec_prepared(tx, "cache_count", 2), 0u, "Cache hit allocated.");
+
+  cache.invalidate("cache_count");
+  PQXX_CHECK_EQUAL(cache.size(), 0u, "invalidate() left entries behind.");
+  PQXX_CHECK_EQUAL(cache.bytes(), 0u, "Lost count of cached bytes.");
+  PQXX_CHECK_NOT_EQUAL(
+    cache.exec_prepared(tx, "cache_count", 1)[0][0].as<long>(),
+    first[0][0].as<long>(), "Got stale result after invalidation.");
+}
+
+
+void test_result_cache_limits()
+{
+  pqxx::connection conn;
+  prepare_counter(conn);
+  pqxx::nontransaction tx{conn};
+
+  pqxx::result_cache_config config;
+  config.max_entries = 2;
+  pqxx::result_cache small{conn, config};
+  for (int i{0}; i < 3; ++i)
+    std::ignore = small.exec_prepared(tx, "cache_count", i);
+  PQXX_CHECK_EQUAL(small.size(), 2u, "Cache outgrew max_entries.");
+  PQXX_CHECK_EQUAL(small.stats().evictions, 1u, "Wrong eviction count.");
+  // The least recently used entry went first.
+  std::ignore = small.exec_prepared(tx, "cache_count", 2);
+  std::ignore = small.exec_prepared(tx, "cache_count", 1);
+  PQXX_CHECK_EQUAL(small.stats().hits, 2u, "Evicted the wrong entry.");
+
+  config.max_entries = 0;
+  config.ttl = std::chrono::milliseconds{50};
+  pqxx::result_cache brief{conn, config};
+  std::ignore = brief.exec_prepared(tx, "cache_count", 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds{100});
+  std::ignore = brief.exec_prepared(tx, "cache_count", 1);
+  PQXX_CHECK_EQUAL(brief.stats().misses, 2u, "Result outlived its TTL.");
+
+  config.ttl = std::chrono::milliseconds{0};
+  config.max_bytes = 1;
+  pqxx::result_cache tiny{conn, config};
+  std::ignore = tiny.exec_prepared(tx, "cache_count", 1);
+  PQXX_CHECK_EQUAL(tiny.size(), 0u, "Cached a result bigger than max_bytes.");
+}
+
+
+void test_result_cache_notification()
+{
+  pqxx::connection conn, listener;
+  prepare_counter(conn);
+  pqxx::result_cache cache{listener};
+  cache.invalidate_on("pqxx_cache_test");
+  cache.invalidate_on("pqxx_cache_other", "other_statement");
+  pqxx::nontransaction tx{conn};
+
+  std::ignore = cache.exec_prepared(tx, "cache_count", 1);
+  pqxx::nontransaction{listener}.exec0("NOTIFY pqxx_cache_other");
+  listener.await_notification(5, 0);
+  PQXX_CHECK_EQUAL(cache.size(), 1u, "Invalidated the wrong statement.");
+
+  pqxx::nontransaction{listener}.exec0("NOTIFY pqxx_cache_test");
+  listener.await_notification(5, 0);
+  PQXX_CHECK_EQUAL(cache.size(), 0u, "Notification did not invalidate.");
+  PQXX_CHECK_EQUAL(
+    cache.stats().invalidations, 1u, "Wrong invalidation count.");
+}
+
+
+void test_params_encode()
+{
+  auto const key{[](pqxx::internal::params const &p) {
+    std::string out;
+    p.encode(out);
+    return out;
+  }};
+  PQXX_CHECK_EQUAL(
+    key(pqxx::internal::params{1, "x"}), key(pqxx::internal::params{"1", "x"}),
+    "Same values encoded differently.");
+  PQXX_CHECK_NOT_EQUAL(
+    key(pqxx::internal::params{nullptr}), key(pqxx::internal::params{""}),
+    "Null encoded like an empty string.");
+  PQXX_CHECK_NOT_EQUAL(
+    key(pqxx::internal::params{"1", "2"}), key(pqxx::internal::params{"12"}),
+    "Parameter boundaries got lost.");
+  PQXX_CHECK_NOT_EQUAL(
+    key(pqxx::internal::params{1}),
+    key(pqxx::internal::params{pqxx::prepare::make_binary_param(1)}),
+    "Binary parameter encoded like a text one.");
+}
+
+
+PQXX_REGISTER_TEST(test_result_cache_hits);
+PQXX_REGISTER_TEST(test_result_cache_limits);
+PQXX_REGISTER_TEST(test_result_cache_notification);
+PQXX_REGISTER_TEST(test_params_encode);
+} // namespace
@@ -1,3 +1,8 @@
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "../test_helpers.hxx"
 
 namespace
@@ -21,5 +26,190 @@ void test_result_iteration()
 }
 
 
+void test_row_refs()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::result const r{
+    tx.exec("SELECT n, n * 10 AS tens, NULL::text AS nothing "
+            "FROM generate_series(1, 3) AS n")};
+
+  int total{0}, rows{0};
+  for (auto const row : r.row_refs())
+  {
+    PQXX_CHECK_EQUAL(row.size(), 3, "Wrong row_ref size.");
+    PQXX_CHECK_EQUAL(row.rownumber(), rows, "Wrong row_ref number.");
+    total += row[0].as<int>() + row["tens"].as<int>();
+    PQXX_CHECK(row[2].is_null(), "Null field_ref is not null.");
+    PQXX_CHECK(
+      not row["nothing"].get<std::string>(), "Null field_ref has a value.");
+    ++rows;
+  }
+  PQXX_CHECK_EQUAL(rows, 3, "Wrong number of row_refs.");
+  PQXX_CHECK_EQUAL(total, 66, "Wrong values in field_refs.");
+
+  pqxx::row_ref const slice{r[1].slice(1, 2)};
+  PQXX_CHECK_EQUAL(slice.size(), 1, "Wrong size for sliced row_ref.");
+  PQXX_CHECK_EQUAL(slice[0].as<int>(), 20, "Wrong field in row_ref slice.");
+  PQXX_CHECK_EQUAL(
+    std::string{slice[0].name()}, "tens", "Wrong column name in field_ref.");
+  PQXX_CHECK_THROWS(
+    slice.at(1), pqxx::range_error, "row_ref::at() did not check range.");
+  PQXX_CHECK_THROWS(
+    slice.column_number("n"), pqxx::argument_error,
+    "row_ref found column outside its slice.");
+}
+
+
+void test_column_numbers()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::result const r{
+    tx.exec("SELECT 1 AS one, 2 AS \"Two\", 3 AS one, 4 AS four")};
+
+  // A copy shares the column index, so it finds the same columns.
+  auto const copy{r};
+  for (auto const &res : {r, copy})
+  {
+    PQXX_CHECK_EQUAL(res.column_number("one"), 0, "Wrong column.");
+    PQXX_CHECK_EQUAL(res.column_number("four"), 3, "Wrong column.");
+    // Unquoted names fold to lower case; quoted ones don't.
+    PQXX_CHECK_EQUAL(res.column_number("FOUR"), 3, "Name did not fold.");
+    PQXX_CHECK_EQUAL(res.column_number("\"Two\""), 1, "Quoted name failed.");
+    PQXX_CHECK_THROWS(
+      res.column_number("Two"), pqxx::argument_error,
+      "Unquoted name did not fold.");
+    PQXX_CHECK_THROWS(
+      res.column_number("five"), pqxx::argument_error,
+      "Found nonexistent column.");
+  }
+  PQXX_CHECK_EQUAL(r[0]["four"].as<int>(), 4, "Bad field by name.");
+}
+
+
+void test_result_iter()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::result const r{tx.exec(
+    "SELECT n, 'row ' || n, CASE WHEN n = 2 THEN NULL ELSE n * 0.5 END "
+    "FROM generate_series(1, 3) AS n")};
+
+  int rows{0};
+  double halves{0};
+  for (auto [n, text, half] :
+       r.iter<int, std::string, std::optional<double>>())
+  {
+    ++rows;
+    PQXX_CHECK_EQUAL(n, rows, "Wrong value from iter().");
+    PQXX_CHECK_EQUAL(text, "row " + pqxx::to_string(n), "Wrong string.");
+    PQXX_CHECK_EQUAL(bool(half), n != 2, "Null did not become nullopt.");
+    if (half)
+      halves += *half;
+  }
+  PQXX_CHECK_EQUAL(rows, 3, "Wrong number of rows from iter().");
+  PQXX_CHECK_BOUNDS(halves, 1.9999, 2.0001, "Wrong doubles from iter().");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(r.iter<int>()), pqxx::usage_error,
+    "iter() accepted wrong column count.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(r[1].as<int, std::string, double>()),
+    pqxx::conversion_error, "Null converted to double.");
+
+  auto const [n, text]{r[0].slice(0, 2).as<int, std::string>()};
+  PQXX_CHECK_EQUAL(n, 1, "Wrong value from row::as().");
+  PQXX_CHECK_EQUAL(text, "row 1", "Wrong string from row::as().");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(r[0].as<int>()), pqxx::usage_error,
+    "row::as() accepted wrong size.");
+}
+
+
+void test_column_as()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const r{tx.exec(
+    "SELECT n, CASE WHEN n % 3 = 0 THEN NULL ELSE n * 10 END "
+    "FROM generate_series(1, 10) AS n")};
+
+  pqxx::column_batch<int> ns;
+  r.column_as(0, ns);
+  PQXX_CHECK_EQUAL(ns.size(), 10u, "Wrong column size.");
+  PQXX_CHECK_EQUAL(ns.values[9], 10, "Wrong value in column.");
+  PQXX_CHECK(not ns.is_null(2), "Non-null field came out null.");
+
+  std::vector<long> tens(std::size(r));
+  std::vector<std::uint8_t> valid(2);
+  r.column_as(1, std::data(tens), std::data(valid));
+  PQXX_CHECK_EQUAL(tens[0], 10L, "Wrong value in array.");
+  PQXX_CHECK_EQUAL(tens[2], 0L, "Null did not become default value.");
+  // Rows 3, 6, and 9 (bits 2, 5, and 8) are null.
+  PQXX_CHECK_EQUAL(int(valid[0]), 0xdb, "Wrong validity bitmap.");
+  PQXX_CHECK_EQUAL(int(valid[1]), 0x02, "Wrong validity bits at the end.");
+
+  pqxx::column_batch<std::optional<int>> tens_batch;
+  r.column_as(1, tens_batch);
+  PQXX_CHECK(not tens_batch.values[5], "Null did not become nullopt.");
+  PQXX_CHECK(
+    tens_batch.validity_bitmap() == valid, "Bitmaps are inconsistent.");
+
+  PQXX_CHECK_THROWS(
+    r.column_as(2, ns), pqxx::range_error, "Bad column number accepted.");
+}
+
+
+void test_column_nulls_and_lengths()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const r{tx.exec(
+    "SELECT CASE WHEN n % 3 = 0 THEN NULL ELSE repeat('x', n) END "
+    "FROM generate_series(1, 10) AS n")};
+
+  std::vector<std::uint8_t> valid(2, 0xff);
+  PQXX_CHECK_EQUAL(
+    r.validity_bitmap(0, std::data(valid)), 3, "Wrong null count.");
+  PQXX_CHECK_EQUAL(int(valid[0]), 0xdb, "Wrong validity bitmap.");
+  PQXX_CHECK_EQUAL(int(valid[1]), 0x02, "Wrong validity bits at the end.");
+
+  std::vector<pqxx::field_size_type> lengths(std::size(r));
+  r.field_lengths(0, std::data(lengths));
+  for (std::size_t row{0}; row < std::size(lengths); ++row)
+    PQXX_CHECK_EQUAL(
+      lengths[row], r[static_cast<pqxx::result_size_type>(row)][0].size(),
+      "Wrong field length.");
+  PQXX_CHECK_EQUAL(lengths[2], 0u, "Null field has nonzero length.");
+
+  PQXX_CHECK_THROWS(
+    r.validity_bitmap(1, std::data(valid)), pqxx::range_error,
+    "Bad column number accepted.");
+}
+
+
+void test_validity_bitmap()
+{
+  pqxx::column_batch<int> batch;
+  PQXX_CHECK(batch.validity_bitmap().empty(), "Empty batch has a bitmap.");
+  for (int i{0}; i < 9; ++i)
+  {
+    batch.values.push_back(i);
+    batch.nulls.push_back(i == 1);
+  }
+  auto const bits{batch.validity_bitmap()};
+  PQXX_CHECK_EQUAL(std::size(bits), 2u, "Wrong bitmap size.");
+  PQXX_CHECK_EQUAL(int(bits[0]), 0xfd, "Wrong validity bits.");
+  PQXX_CHECK_EQUAL(int(bits[1]), 0x01, "Wrong spare validity bits.");
+}
+
+
 PQXX_REGISTER_TEST(test_result_iteration);
+PQXX_REGISTER_TEST(test_row_refs);
+PQXX_REGISTER_TEST(test_column_numbers);
+PQXX_REGISTER_TEST(test_result_iter);
+PQXX_REGISTER_TEST(test_column_as);
+PQXX_REGISTER_TEST(test_column_nulls_and_lengths);
+PQXX_REGISTER_TEST(test_validity_bitmap);
 } // namespace
@@ -139,5 +139,47 @@ void test_result_slicing()
 }
 
 
+void test_result_compact()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto r{tx.exec(
+    "SELECT n AS id, repeat('x', 1000) AS wide, "
+    "CASE WHEN n % 2 = 0 THEN NULL ELSE 'odd' END AS parity "
+    "FROM generate_series(1, 100) n")};
+
+  auto const c{r.compact("parity", 0)};
+  PQXX_CHECK_EQUAL(c.size(), r.size(), "Compacting lost rows.");
+  PQXX_CHECK_EQUAL(c.columns(), 2, "Wrong number of columns.");
+  PQXX_CHECK_EQUAL(
+    std::string{c.column_name(0)}, "parity", "Wrong first column.");
+  PQXX_CHECK_EQUAL(c.column_number("id"), 1, "Column lookup broke.");
+  PQXX_CHECK_EQUAL(
+    c.column_type(1), r.column_type(0), "Column type did not carry over.");
+  PQXX_CHECK(
+    c.memory_usage() < r.memory_usage() / 10,
+    "Compacted result is not small.");
+
+  r.clear();
+  for (auto const row : c)
+  {
+    auto const id{row["id"].as<int>()};
+    PQXX_CHECK_EQUAL(
+      row[0].is_null(), id % 2 == 0, "Nulls did not carry over.");
+    if (id % 2 != 0)
+      PQXX_CHECK_EQUAL(row[0].view(), "odd", "Bad value in compacted result.");
+  }
+  PQXX_CHECK_EQUAL(c[99][1].as<int>(), 100, "Rows out of order.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(c.compact(2)), pqxx::range_error,
+    "Compacted nonexistent column.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(c.compact()), pqxx::argument_error,
+    "Compacted down to nothing.");
+}
+
+
 PQXX_REGISTER_TEST(test_result_slicing);
+PQXX_REGISTER_TEST(test_result_compact);
 } // namespace
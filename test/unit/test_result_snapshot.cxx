@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <pqxx/result_snapshot>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_result_snapshot()
+{
+  char const name[]{"pqxx-test-result-snapshot.bin"};
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const res{tx.exec(
+    "SELECT n, 'row ' || n AS name, "
+    "CASE WHEN n % 3 = 0 THEN NULL ELSE n END AS maybe, "
+    "ARRAY[n, n + 1] AS arr "
+    "FROM generate_series(1, 100) AS n")};
+
+  std::optional<pqxx::result_snapshot> snap;
+  try
+  {
+    pqxx::result_snapshot::save(res, name);
+    snap.emplace(name);
+  }
+  catch (...)
+  {
+    std::remove(name);
+    throw;
+  }
+  // The mapping, if any, stays valid once the file is gone.
+  std::remove(name);
+
+  PQXX_CHECK_EQUAL(snap->size(), res.size(), "Wrong number of rows.");
+  PQXX_CHECK_EQUAL(snap->columns(), res.columns(), "Wrong number of columns.");
+  for (pqxx::row_size_type col{0}; col < res.columns(); ++col)
+  {
+    PQXX_CHECK_EQUAL(
+      std::string{snap->column_name(col)}, std::string{res.column_name(col)},
+      "Wrong column name.");
+    PQXX_CHECK_EQUAL(
+      snap->column_type(col), res.column_type(col), "Wrong column type.");
+  }
+  PQXX_CHECK_EQUAL(snap->column_number("maybe"), 2, "Bad column lookup.");
+
+  int row{0};
+  for (auto const r : *snap)
+  {
+    auto const [n, text, maybe, arr]{
+      r.as<int, std::string, std::optional<int>, std::vector<int>>()};
+    ++row;
+    PQXX_CHECK_EQUAL(n, row, "Rows came out of order.");
+    PQXX_CHECK_EQUAL(text, "row " + pqxx::to_string(row), "Bad text.");
+    PQXX_CHECK_EQUAL(maybe.has_value(), row % 3 != 0, "Wrong nullness.");
+    PQXX_CHECK_EQUAL(std::size(arr), 2u, "Bad array.");
+  }
+  PQXX_CHECK_EQUAL(row, 100, "Iteration stopped early.");
+
+  auto const f{(*snap)[41]["arr"]};
+  PQXX_CHECK_EQUAL(f.view(), res[41]["arr"].view(), "Bad field text.");
+  PQXX_CHECK_EQUAL(
+    (pqxx::parse_array<std::vector<int>>(f)), (std::vector<int>{42, 43}),
+    "Bad array.");
+  PQXX_CHECK((*snap)[2][2].is_null(), "Null came out non-null.");
+  PQXX_CHECK_EQUAL(
+    (*snap)[2][2].get<int>().has_value(), false, "Null came out as a value.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(snap->at(100)), pqxx::range_error,
+    "No error for a row out of range.");
+  PQXX_CHECK_EQUAL(
+    std::end(*snap) - std::begin(*snap), 100, "Bad iterator distance.");
+}
+
+
+void test_result_snapshot_binary()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const res{tx.exec_params_binary("SELECT $1::integer", 1234)};
+  auto const data{pqxx::result_snapshot::serialize(res)};
+
+  char const name[]{"pqxx-test-result-snapshot-binary.bin"};
+  std::ofstream{name, std::ios::binary} << data;
+  std::optional<pqxx::result_snapshot> snap;
+  try
+  {
+    snap.emplace(name);
+  }
+  catch (...)
+  {
+    std::remove(name);
+    throw;
+  }
+  std::remove(name);
+  PQXX_CHECK((*snap)[0][0].is_binary(), "Lost binary format.");
+  PQXX_CHECK_EQUAL((*snap)[0][0].as<int>(), 1234, "Bad binary field.");
+}
+
+
+void test_result_snapshot_rejects_garbage()
+{
+  char const name[]{"pqxx-test-result-snapshot-bad.bin"};
+  std::ofstream{name, std::ios::binary} << "PQXXSNAP but not really";
+  try
+  {
+    PQXX_CHECK_THROWS(
+      pqxx::result_snapshot{name}, pqxx::failure,
+      "Garbage file loaded as a snapshot.");
+  }
+  catch (...)
+  {
+    std::remove(name);
+    throw;
+  }
+  std::remove(name);
+}
+
+
+PQXX_REGISTER_TEST(test_result_snapshot);
+PQXX_REGISTER_TEST(test_result_snapshot_binary);
+PQXX_REGISTER_TEST(test_result_snapshot_rejects_garbage);
+} // namespace
@@ -0,0 +1,63 @@
+#include <cstddef>
+#include <vector>
+
+#include <pqxx/robusttransaction>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_robusttransaction_round_trips()
+{
+  pqxx::connection conn;
+  std::vector<std::size_t> statements;
+  conn.set_query_hook([&statements](pqxx::query_stats const &s) {
+    statements.push_back(s.statements);
+  });
+
+  pqxx::robusttransaction<> tx{conn};
+  PQXX_CHECK_EQUAL(
+    std::size(statements), 1u,
+    "Starting a robusttransaction took more than one round trip.");
+  PQXX_CHECK_EQUAL(
+    statements.back(), 2u, "Transaction ID query did not go with the BEGIN.");
+
+  tx.exec1("SELECT 1");
+  tx.commit();
+  PQXX_CHECK_EQUAL(
+    std::size(statements), 3u,
+    "A robusttransaction took more round trips than a regular one.");
+  PQXX_CHECK_EQUAL(
+    statements.back(), 2u, "Constraints check did not go with the COMMIT.");
+}
+
+
+void test_robusttransaction_deferred_violation()
+{
+  pqxx::connection conn;
+  pqxx::nontransaction{conn}.exec0(
+    "CREATE TEMP TABLE pqxx_robust_deferred "
+    "(id integer UNIQUE DEFERRABLE INITIALLY DEFERRED)");
+
+  pqxx::robusttransaction<> tx{conn};
+  tx.exec0("INSERT INTO pqxx_robust_deferred (id) VALUES (1)");
+  tx.exec0("INSERT INTO pqxx_robust_deferred (id) VALUES (1)");
+
+  // The violation shows up at commit.  That's a plain failure: the
+  // transaction did not commit, and there is no doubt about it.
+  PQXX_CHECK_THROWS(
+    tx.commit(), pqxx::unique_violation,
+    "Deferred constraint violation did not fail the commit.");
+
+  PQXX_CHECK(conn.is_open(), "Failed commit broke the connection.");
+  PQXX_CHECK_EQUAL(
+    pqxx::work{conn}.query_value<int>(
+      "SELECT count(*) FROM pqxx_robust_deferred"),
+    0, "Failed commit still committed.");
+}
+
+
+PQXX_REGISTER_TEST(test_robusttransaction_round_trips);
+PQXX_REGISTER_TEST(test_robusttransaction_deferred_violation);
+} // namespace
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+
+#include <pqxx/scatter_gather>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+void test_scatter_gather()
+{
+  pqxx::connection c1, c2, c3;
+  pqxx::scatter_gather shards{std::vector<pqxx::connection *>{&c1, &c2, &c3}};
+  PQXX_CHECK_EQUAL(shards.size(), 3u, "Wrong number of shards.");
+
+  auto const results{shards.exec_params("SELECT $1::integer * 2", 21)};
+  PQXX_CHECK_EQUAL(std::size(results), 3u, "Wrong number of results.");
+  for (auto const &res : results)
+    PQXX_CHECK_EQUAL(res[0][0].as<int>(), 42, "Bad result.");
+
+  // Partial aggregation, as each shard's result comes in.
+  long total{0};
+  std::vector<bool> seen(3);
+  shards.gather(
+    "SELECT sum(n) FROM generate_series(1, 100) AS n",
+    [&total, &seen](std::size_t index, pqxx::result const &res) {
+      seen[index] = true;
+      total += res[0][0].as<long>();
+    });
+  PQXX_CHECK_EQUAL(total, 3 * 5050, "Bad aggregate.");
+  PQXX_CHECK(seen[0] and seen[1] and seen[2], "Missed a shard.");
+}
+
+
+void test_scatter_gather_merge()
+{
+  pqxx::connection c1, c2;
+  pqxx::scatter_gather shards{std::vector<pqxx::connection *>{&c1, &c2}};
+
+  // Each shard returns the multiples of its own step, sorted.
+  std::vector<int> merged;
+  shards.merge(
+    "SELECT n * (pg_backend_pid() % 2 + 2) "
+    "FROM generate_series(1, $1) AS n ORDER BY 1",
+    [](pqxx::row_ref const &lhs, pqxx::row_ref const &rhs) {
+      return lhs[0].as<int>() < rhs[0].as<int>();
+    },
+    [&merged](std::size_t, pqxx::row_ref const &row) {
+      merged.push_back(row[0].as<int>());
+    },
+    10);
+  PQXX_CHECK_EQUAL(std::size(merged), 20u, "Wrong number of rows.");
+  for (std::size_t i{1}; i < std::size(merged); ++i)
+    PQXX_CHECK(merged[i - 1] <= merged[i], "Merge came out of order.");
+}
+
+
+void test_scatter_gather_failure()
+{
+  pqxx::connection c1, c2;
+  pqxx::scatter_gather shards{std::vector<pqxx::connection *>{&c1, &c2}};
+  pqxx::quiet_errorhandler d1{c1}, d2{c2};
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(shards.exec("SELECT * FROM pg_nonexistent_table")),
+    pqxx::sql_error, "Shard failure went unnoticed.");
+
+  // The shards are usable again afterwards.
+  auto const results{shards.exec("SELECT 1")};
+  PQXX_CHECK_EQUAL(results[1][0][0].as<int>(), 1, "Bad result after error.");
+}
+
+
+PQXX_REGISTER_TEST(test_scatter_gather);
+PQXX_REGISTER_TEST(test_scatter_gather_merge);
+PQXX_REGISTER_TEST(test_scatter_gather_failure);
+} // namespace
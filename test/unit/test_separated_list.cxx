@@ -1,3 +1,8 @@
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
 #include "../test_helpers.hxx"
 
 // Test program for separated_list.
@@ -23,8 +28,49 @@ void test_separated_list()
     pqxx::separated_list(
       "+", nums.begin(), nums.end(), [](auto elt) { return *elt * 2; }),
     "2+4+6", "Accessors don't seem to work.");
+
+  std::vector<std::string_view> const words{"foo", "", "bar"};
+  PQXX_CHECK_EQUAL(
+    pqxx::separated_list(", ", words), "foo, , bar",
+    "Joining string_views went wrong.");
+
+  std::tuple<int, std::string, char const *, pqxx::zview> const tup{
+    9, "nine", "IX", "ix"};
+  PQXX_CHECK_EQUAL(
+    pqxx::separated_list("/", tup), "9/nine/IX/ix",
+    "Joining a tuple went wrong.");
+  PQXX_CHECK_EQUAL(
+    pqxx::separated_list(
+      ";", std::make_tuple(1, 2), [](auto elt) { return *elt + 1; }),
+    "2;3", "Tuple accessor does not work.");
+  PQXX_CHECK_EQUAL(
+    pqxx::separated_list(",", std::tuple<>{}), "",
+    "Empty tuple came out wrong.");
+}
+
+
+void test_string_view_to_buf()
+{
+  char buf[10];
+  std::string_view const text{"abcdef", 3};
+  auto const view{pqxx::string_traits<std::string_view>::to_buf(
+    std::begin(buf), std::end(buf), text)};
+  PQXX_CHECK_EQUAL(std::string{view.c_str()}, "abc", "Bad string_view.");
+  PQXX_CHECK_EQUAL(view.size(), 3u, "Bad string_view size.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::string_traits<std::string_view>::into_buf(
+      std::begin(buf), std::begin(buf) + 3, text)),
+    pqxx::conversion_overrun, "string_view overran its buffer.");
+
+  std::string const str{"xyz"};
+  buf[3] = 'x';
+  pqxx::ignore_unused(
+    pqxx::string_traits<std::string>::into_buf(
+      std::begin(buf), std::end(buf), str));
+  PQXX_CHECK(buf[3] == '\0', "std::string into_buf() is not terminated.");
 }
 
 
 PQXX_REGISTER_TEST(test_separated_list);
+PQXX_REGISTER_TEST(test_string_view_to_buf);
 } // namespace
@@ -0,0 +1,92 @@
+#include <optional>
+#include <string>
+#include <tuple>
+
+#include <pqxx/spilled_result>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+constexpr char const query[]{
+  "SELECT n, 'row ' || n AS name, CASE WHEN n % 10 = 0 THEN NULL ELSE n END "
+  "FROM generate_series(1, 1000) AS n"};
+
+
+void check_rows(pqxx::spilled_result const &res)
+{
+  PQXX_CHECK_EQUAL(res.size(), 1000, "Wrong number of rows.");
+  PQXX_CHECK_EQUAL(res.columns(), 3, "Wrong number of columns.");
+  PQXX_CHECK_EQUAL(res.column_name(1), "name", "Wrong column name.");
+
+  int expect{1};
+  for (auto const row : res)
+  {
+    auto const [n, name, maybe]{
+      row.as<int, std::string, std::optional<int>>()};
+    PQXX_CHECK_EQUAL(n, expect, "Rows came out of order.");
+    PQXX_CHECK_EQUAL(name, "row " + pqxx::to_string(n), "Wrong text.");
+    PQXX_CHECK_EQUAL(maybe.has_value(), n % 10 != 0, "Wrong nullness.");
+    ++expect;
+  }
+  PQXX_CHECK_EQUAL(expect, 1001, "Iteration stopped early.");
+
+  // Random access, including rows in between index entries.
+  PQXX_CHECK_EQUAL(res[0].as<int>(0), 1, "Bad first row.");
+  PQXX_CHECK_EQUAL(res[130].view(1), "row 131", "Bad row lookup.");
+  PQXX_CHECK(res[999].is_null(2), "Null field came out non-null.");
+  PQXX_CHECK_EQUAL(
+    std::string{res[999].c_str(1).c_str()}, "row 1000", "Bad zview.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(res.at(1000)), pqxx::range_error,
+    "No error for a row out of range.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(res[5].view(3)), pqxx::range_error,
+    "No error for a column out of range.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(res[9].as<int, std::string, int>()),
+    pqxx::conversion_error, "Null went into an int.");
+}
+
+
+void test_spilled_result_in_memory()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::spilled_result const res{tx, query};
+  PQXX_CHECK(not res.spilled(), "Small result spilled to disk.");
+  check_rows(res);
+}
+
+
+void test_spilled_result_on_disk()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::spill_config config;
+  config.memory_limit = 1000;
+  config.chunk_rows = 100;
+  pqxx::spilled_result const res{tx, query, config};
+  PQXX_CHECK(res.spilled(), "Big result did not spill to disk.");
+  check_rows(res);
+
+  // The transaction is usable again.
+  PQXX_CHECK_EQUAL(tx.query_value<int>("SELECT 8"), 8, "Bad query.");
+}
+
+
+void test_spilled_result_empty()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::spilled_result const res{tx, "SELECT 1 WHERE false"};
+  PQXX_CHECK(res.empty(), "Empty result has rows.");
+  PQXX_CHECK(std::begin(res) == std::end(res), "Bad empty iteration.");
+}
+
+
+PQXX_REGISTER_TEST(test_spilled_result_in_memory);
+PQXX_REGISTER_TEST(test_spilled_result_on_disk);
+PQXX_REGISTER_TEST(test_spilled_result_empty);
+} // namespace
@@ -250,6 +250,45 @@ void test_hold_cursor()
     no_hold.fetch(1), pqxx::sql_error, "Cursor not closed on commit");
 }
 
+void test_lazy_sql_cursor()
+{
+  pqxx::connection conn;
+  int queries{0};
+  conn.set_query_hook([&queries](pqxx::query_stats const &) { ++queries; });
+
+  pqxx::work tx{conn};
+  {
+    pqxx::internal::sql_cursor cur(
+      tx, "SELECT generate_series(1, 3)", "lazy",
+      pqxx::cursor_base::forward_only, pqxx::cursor_base::read_only,
+      pqxx::cursor_base::owned, false);
+    PQXX_CHECK_EQUAL(queries, 0, "Cursor declared before first use.");
+
+    auto const rows{cur.fetch(pqxx::cursor_base::all())};
+    PQXX_CHECK_EQUAL(rows.size(), 3, "Wrong number of rows.");
+    PQXX_CHECK_EQUAL(
+      queries, 1, "DECLARE and first FETCH took separate round trips.");
+    PQXX_CHECK_EQUAL(
+      cur.empty_result().columns(), 1, "Empty result has no columns.");
+    PQXX_CHECK_EQUAL(queries, 1, "Empty result cost a round trip.");
+  }
+  PQXX_CHECK_EQUAL(queries, 1, "CLOSE did not wait for the next statement.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 1"), 1, "Bad result after deferred CLOSE.");
+  PQXX_CHECK_EQUAL(queries, 2, "CLOSE took its own round trip.");
+  tx.commit();
+
+  // A broken query fails on first use, not on construction.
+  pqxx::work tx2{conn};
+  pqxx::internal::sql_cursor bad(
+    tx2, "SELECT * FROM pqxx_nonexistent_table", "bad",
+    pqxx::cursor_base::forward_only, pqxx::cursor_base::read_only,
+    pqxx::cursor_base::owned, false);
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(bad.fetch(1)), pqxx::sql_error,
+    "Broken cursor query did not fail on first fetch.");
+}
+
 
 void cursor_tests()
 {
@@ -257,6 +296,7 @@ void cursor_tests()
   test_scroll_sql_cursor();
   test_adopted_sql_cursor();
   test_hold_cursor();
+  test_lazy_sql_cursor();
 }
 
 
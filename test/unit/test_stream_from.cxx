@@ -3,8 +3,10 @@
 
 #include <pqxx/stream_from>
 
+#include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <string>
 #include <tuple>
@@ -223,6 +225,149 @@ void test_stream_from__escaping()
   reader >> out;
   PQXX_CHECK_EQUAL(
     std::get<0>(out), input, "stream_from got weird characters wrong.");
+  reader.complete();
+
+  // Long enough fields to go through the vectorised scan.
+  std::string const longer{
+    "A fairly long string\twith a tab\\, a backslash, and a\nnewline."};
+  tx.exec0("CREATE TEMP TABLE longstr (a text, b text, c text)");
+  tx.exec0(
+    "INSERT INTO longstr (a, b, c) VALUES (" + tx.quote(longer) + ", NULL, " +
+    tx.quote(longer + longer) + ")");
+  pqxx::stream_from reader2{tx, "longstr"};
+  std::tuple<std::string, std::optional<std::string>, std::string> row;
+  reader2 >> row;
+  PQXX_CHECK_EQUAL(std::get<0>(row), longer, "Long field went wrong.");
+  PQXX_CHECK(not std::get<1>(row).has_value(), "Null field went wrong.");
+  PQXX_CHECK_EQUAL(
+    std::get<2>(row), longer + longer, "Last long field went wrong.");
+}
+
+
+void test_stream_from__raw_line_view()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE rawlines (n integer, t text)");
+  tx.exec0("INSERT INTO rawlines (n, t) VALUES (1, 'one'), (2, NULL)");
+  pqxx::stream_from reader{
+    tx, "rawlines", std::vector<std::string>{"n", "t"}};
+
+  std::string_view line;
+  PQXX_CHECK(reader.get_raw_line(line), "Could not read first raw line.");
+  PQXX_CHECK_EQUAL(std::string{line}, "1\tone\n", "Bad first raw line.");
+  PQXX_CHECK(reader.get_raw_line(line), "Could not read second raw line.");
+  PQXX_CHECK_EQUAL(std::string{line}, "2\t\\N\n", "Bad second raw line.");
+  PQXX_CHECK(not reader.get_raw_line(line), "Read past end of stream.");
+  PQXX_CHECK(line.empty(), "Raw line not empty at end of stream.");
+  PQXX_CHECK(not reader, "Stream did not close at end.");
+}
+
+
+void test_stream_from__try_read()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::stream_from reader{
+    tx, "pg_catalog.pg_class", std::vector<std::string>{"oid", "relname"}};
+  PQXX_CHECK(reader.sock() >= 0, "Stream has no socket.");
+
+  std::tuple<pqxx::oid, std::string> row;
+  int rows{0};
+  for (auto status{reader.try_read(row)};
+       status != pqxx::stream_from::read_status::done;
+       status = reader.try_read(row))
+  {
+    if (status == pqxx::stream_from::read_status::row)
+    {
+      ++rows;
+      PQXX_CHECK(not std::get<1>(row).empty(), "Got empty relname.");
+    }
+  }
+  PQXX_CHECK(not reader, "Stream did not close after non-blocking reads.");
+  PQXX_CHECK_EQUAL(
+    rows, tx.query_value<int>("SELECT count(*) FROM pg_catalog.pg_class"),
+    "Non-blocking reads got the wrong number of rows.");
+  PQXX_CHECK(
+    reader.try_read(row) == pqxx::stream_from::read_status::done,
+    "Closed stream did not report being done.");
+}
+
+
+void test_stream_from__query()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT n, n * 2 FROM generate_series(1, 5) AS n WHERE n % 2 = 1")};
+  std::vector<int> got;
+  for (auto [n, twice] : stream.iter<int, int>())
+  {
+    PQXX_CHECK_EQUAL(twice, n * 2, "Bad computed column from query stream.");
+    got.push_back(n);
+  }
+  PQXX_CHECK_EQUAL(got.size(), 3u, "Wrong number of rows from query stream.");
+  PQXX_CHECK_EQUAL(got[2], 5, "Wrong last row from query stream.");
+
+  pqxx::stream_from binary{
+    tx, pqxx::from_query, "SELECT 'x'::text, 42::bigint",
+    pqxx::format::binary};
+  std::tuple<std::string, long long> row;
+  binary >> row;
+  PQXX_CHECK_EQUAL(std::get<0>(row), "x", "Bad binary text from query.");
+  PQXX_CHECK_EQUAL(std::get<1>(row), 42LL, "Bad binary bigint from query.");
+  binary.complete();
+}
+
+
+void test_stream_from__read_columns()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+
+  for (auto const fmt : {pqxx::format::text, pqxx::format::binary})
+  {
+    auto stream{pqxx::stream_from::query(
+      tx,
+      "SELECT n::bigint, "
+      "CASE WHEN n % 3 = 0 THEN NULL ELSE n / 2.0 END::float8 "
+      "FROM generate_series(1, 10) AS n",
+      fmt)};
+    pqxx::column_batch<long long> ints;
+    pqxx::column_batch<double> halves;
+    std::vector<std::size_t> sizes;
+    long long total{0};
+    int nulls{0};
+    for (auto rows{stream.read_columns(4, ints, halves)}; rows > 0;
+         rows = stream.read_columns(4, ints, halves))
+    {
+      sizes.push_back(rows);
+      PQXX_CHECK_EQUAL(ints.size(), rows, "Wrong size for first column.");
+      PQXX_CHECK_EQUAL(halves.size(), rows, "Wrong size for second column.");
+      for (std::size_t r{0}; r < rows; ++r)
+      {
+        PQXX_CHECK(not ints.is_null(r), "Unexpected null.");
+        total += ints.values[r];
+        if (halves.is_null(r))
+        {
+          ++nulls;
+          PQXX_CHECK_EQUAL(
+            ints.values[r] % 3, 0LL, "Null in the wrong place.");
+        }
+        else
+        {
+          auto const half{double(ints.values[r]) / 2};
+          PQXX_CHECK_BOUNDS(
+            halves.values[r], half - 0.0001, half + 0.0001, "Bad value.");
+        }
+      }
+    }
+    PQXX_CHECK_EQUAL(sizes.size(), 3u, "Wrong number of batches.");
+    PQXX_CHECK_EQUAL(sizes.back(), 2u, "Wrong size for last batch.");
+    PQXX_CHECK_EQUAL(total, 55LL, "Batches lost values.");
+    PQXX_CHECK_EQUAL(nulls, 3, "Wrong number of nulls.");
+    PQXX_CHECK(not stream, "Stream did not end.");
+  }
 }
 
 
@@ -260,7 +405,198 @@ void test_stream_from__iteration()
 }
 
 
+void test_stream_from__to_fd()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT n, CASE WHEN n = 2 THEN NULL ELSE 'x' || n END "
+        "FROM generate_series(1, 300) AS n")};
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> file{
+    std::tmpfile(), std::fclose};
+  PQXX_CHECK(file.get() != nullptr, "Could not create temporary file.");
+  auto const bytes{stream.to_fd(fileno(file.get()))};
+  PQXX_CHECK(not stream, "Stream did not close.");
+
+  std::string expected;
+  for (int n{1}; n <= 300; ++n)
+    expected += pqxx::to_string(n) + "\t" +
+                ((n == 2) ? std::string{"\\N"} : "x" + pqxx::to_string(n)) +
+                "\n";
+  PQXX_CHECK_EQUAL(bytes, expected.size(), "Wrong byte count from to_fd().");
+
+  std::rewind(file.get());
+  std::string written(expected.size() + 1, '\0');
+  written.resize(
+    std::fread(std::data(written), 1, std::size(written), file.get()));
+  PQXX_CHECK_EQUAL(written, expected, "Wrong data from to_fd().");
+}
+
+
+void test_stream_from__iteration_move()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto stream{pqxx::stream_from::query(
+    tx, "SELECT n, 'row' || n FROM generate_series(1, 3) AS n")};
+  std::vector<std::string> kept;
+  for (auto &&[n, name] : stream.iter<int, std::string>())
+  {
+    PQXX_CHECK_EQUAL(name, "row" + pqxx::to_string(n), "Bad row.");
+    kept.push_back(std::move(name));
+  }
+  PQXX_CHECK_EQUAL(kept.size(), 3u, "Wrong number of rows.");
+  PQXX_CHECK_EQUAL(kept[0], "row1", "Moved-out row went wrong.");
+  PQXX_CHECK_EQUAL(kept[2], "row3", "Row after moving out went wrong.");
+
+  auto letters{
+    pqxx::stream_from::query(tx, "SELECT * FROM (VALUES ('a'), ('b')) AS x")};
+  auto rows{letters.iter<std::string>()};
+  auto i{std::begin(rows)};
+  std::string const first{std::get<0>(*i++)};
+  PQXX_CHECK_EQUAL(first, "a", "Post-increment returned the wrong row.");
+  PQXX_CHECK_EQUAL(std::get<0>(*i), "b", "Post-increment did not advance.");
+  ++i;
+  PQXX_CHECK(i == std::end(rows), "Stream iteration did not end.");
+}
+
+
+void test_stream_from__binary()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE binstream (i integer, f float8, s text)");
+  tx.exec0(
+    "INSERT INTO binstream VALUES (1, 1.5, 'one'), (-2, NULL, E'two\\t2')");
+
+  pqxx::stream_from empty{tx, "binstream", pqxx::format::binary};
+  empty.complete();
+
+  pqxx::stream_from reader{
+    tx, "binstream", std::vector<std::string>{"s", "i", "f"},
+    pqxx::format::binary};
+  std::tuple<std::string, long, std::optional<double>> row;
+
+  reader >> row;
+  PQXX_CHECK(reader, "Binary stream_from ended too soon.");
+  PQXX_CHECK_EQUAL(std::get<0>(row), "one", "Bad binary text.");
+  PQXX_CHECK_EQUAL(std::get<1>(row), 1L, "Bad binary integer.");
+  PQXX_CHECK_BOUNDS(
+    std::get<2>(row).value(), 1.4999, 1.5001, "Bad binary float.");
+
+  reader >> row;
+  PQXX_CHECK(reader, "Binary stream_from ended after one row.");
+  PQXX_CHECK_EQUAL(std::get<0>(row), "two\t2", "Bad binary escapes.");
+  PQXX_CHECK_EQUAL(std::get<1>(row), -2L, "Bad negative binary integer.");
+  PQXX_CHECK(not std::get<2>(row).has_value(), "Binary null went wrong.");
+
+  reader >> row;
+  PQXX_CHECK(not reader, "Binary stream_from did not end.");
+
+  pqxx::stream_from narrow{tx, "binstream", pqxx::format::binary};
+  std::tuple<int, double> too_short;
+  PQXX_CHECK_THROWS(
+    narrow >> too_short, pqxx::usage_error,
+    "Binary stream_from did not check number of fields.");
+  narrow.complete();
+}
+
+
+void test_stream_from__stats()
+{
+  pqxx::connection conn;
+  std::optional<pqxx::query_stats> copy;
+  conn.set_query_hook([&copy](pqxx::query_stats const &stats) {
+    if (stats.what == pqxx::query_stats::kind::copy)
+      copy = stats;
+  });
+  pqxx::work tx{conn};
+
+  for (auto const data_format : {pqxx::format::text, pqxx::format::binary})
+  {
+    auto reader{pqxx::stream_from::query(
+      tx, "SELECT * FROM generate_series(1, 10)", data_format)};
+    PQXX_CHECK_EQUAL(reader.stats().rows, 0u, "Rows before reading.");
+    int n;
+    std::tuple<int> row;
+    reader >> row;
+    n = std::get<0>(row);
+    PQXX_CHECK_EQUAL(n, 1, "Bad first row.");
+    PQXX_CHECK_EQUAL(reader.stats().rows, 1u, "Bad row count while reading.");
+    reader.complete();
+
+    auto const stats{reader.stats()};
+    PQXX_CHECK_EQUAL(stats.rows, 10u, "Bad final row count.");
+    PQXX_CHECK(stats.bytes >= 20u, "Too few bytes counted.");
+    PQXX_CHECK(stats.blocked <= stats.elapsed, "Blocked beyond elapsed time.");
+    PQXX_CHECK(
+      reader.stats().elapsed == stats.elapsed,
+      "Elapsed time kept running after the stream finished.");
+    PQXX_CHECK(copy.has_value(), "Query hook did not see the COPY.");
+    PQXX_CHECK(copy->blocked <= copy->elapsed, "Bad blocked time in hook.");
+    copy.reset();
+  }
+}
+
+
+void test_stream_from__background()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+
+  for (auto const data_format : {pqxx::format::text, pqxx::format::binary})
+  {
+    auto reader{pqxx::stream_from::query(
+      tx, "SELECT n, repeat('x', n % 100) FROM generate_series(1, 10000) n",
+      data_format)};
+    std::tuple<int, std::string> row;
+    reader >> row;
+    PQXX_CHECK_EQUAL(std::get<0>(row), 1, "Bad row before going background.");
+
+    // Tiny chunks, so the reader thread has to wait for us.
+    reader.read_in_background(2, 256);
+    PQXX_CHECK_THROWS(
+      reader.read_in_background(), pqxx::usage_error,
+      "Started a second background reader.");
+    std::string_view line;
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(reader.try_get_raw_line(line)), pqxx::usage_error,
+      "Non-blocking read worked on a background reader.");
+
+    int expected{2};
+    for (auto [n, text] : reader.iter<int, std::string>())
+    {
+      PQXX_CHECK_EQUAL(n, expected, "Rows out of order.");
+      PQXX_CHECK_EQUAL(
+        std::size(text), static_cast<std::size_t>(n % 100),
+        "Bad field from background reader.");
+      ++expected;
+    }
+    PQXX_CHECK_EQUAL(expected, 10001, "Wrong number of rows.");
+    PQXX_CHECK_EQUAL(reader.stats().rows, 10000u, "Bad row count.");
+  }
+
+  // An error on the reader thread comes out in the consumer's thread.
+  auto reader{pqxx::stream_from::query(
+    tx, "SELECT 1 / (1000 - n) FROM generate_series(1, 2000) n")};
+  reader.read_in_background();
+  std::string_view line;
+  PQXX_CHECK_THROWS(
+    while (reader.get_raw_line(line));, pqxx::sql_error,
+    "Background reader lost an error.");
+}
+
+
 PQXX_REGISTER_TEST(test_stream_from);
 PQXX_REGISTER_TEST(test_stream_from__escaping);
+PQXX_REGISTER_TEST(test_stream_from__raw_line_view);
+PQXX_REGISTER_TEST(test_stream_from__try_read);
+PQXX_REGISTER_TEST(test_stream_from__query);
+PQXX_REGISTER_TEST(test_stream_from__read_columns);
 PQXX_REGISTER_TEST(test_stream_from__iteration);
+PQXX_REGISTER_TEST(test_stream_from__iteration_move);
+PQXX_REGISTER_TEST(test_stream_from__to_fd);
+PQXX_REGISTER_TEST(test_stream_from__binary);
+PQXX_REGISTER_TEST(test_stream_from__stats);
+PQXX_REGISTER_TEST(test_stream_from__background);
 } // namespace
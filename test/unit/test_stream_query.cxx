@@ -0,0 +1,105 @@
+#include "../test_helpers.hxx"
+
+#include <pqxx/stream_query>
+
+#include <optional>
+#include <string>
+#include <tuple>
+
+
+namespace
+{
+void test_stream_query_reads_rows()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::stream_query stream{
+    tx, "SELECT n, 'row ' || n FROM generate_series(1, 5) AS n"};
+
+  int expected{1};
+  std::tuple<int, std::string> row;
+  while (stream >> row)
+  {
+    PQXX_CHECK_EQUAL(std::get<0>(row), expected, "Wrong row from stream.");
+    PQXX_CHECK_EQUAL(
+      std::get<1>(row), "row " + pqxx::to_string(expected),
+      "Wrong field value from stream.");
+    ++expected;
+  }
+  PQXX_CHECK_EQUAL(expected, 6, "Wrong number of rows from stream.");
+  PQXX_CHECK(not stream, "Stream did not close at end of results.");
+
+  // The transaction is usable again.
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 9"), 9, "Transaction broken after stream.");
+}
+
+
+void test_stream_query_iterates()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::stream_query stream{
+    tx, "SELECT 1, NULL::integer UNION ALL SELECT 2, 3"};
+
+  int total{0}, nulls{0};
+  for (auto [x, y] : stream.iter<int, std::optional<int>>())
+  {
+    total += x;
+    if (y)
+      total += *y;
+    else
+      ++nulls;
+  }
+  PQXX_CHECK_EQUAL(total, 6, "Iterating stream_query went wrong.");
+  PQXX_CHECK_EQUAL(nulls, 1, "Null from stream_query went wrong.");
+}
+
+
+void test_stream_query_complete_discards_rest()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::stream_query stream{tx, "SELECT * FROM generate_series(1, 1000)", 10};
+
+  auto const chunk{stream.read_chunk()};
+  PQXX_CHECK(not chunk.empty(), "First chunk was empty.");
+  PQXX_CHECK_GREATER_EQUAL(
+    chunk.at(0).at(0).as<int>(), 1, "Bad first value in stream.");
+  stream.complete();
+  PQXX_CHECK(not stream, "Stream still open after complete().");
+
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT 8"), 8, "Transaction broken after stream.");
+}
+
+
+void test_stream_query_reports_errors()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  std::tuple<int> row;
+  PQXX_CHECK_THROWS(
+    (pqxx::stream_query{tx, "SELECT 1/0"} >> row), pqxx::sql_error,
+    "Error in streamed query went unnoticed.");
+}
+
+
+void test_stream_query_checks_columns()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  pqxx::stream_query stream{tx, "SELECT 1, 2"};
+  std::tuple<int> row;
+  PQXX_CHECK_THROWS(
+    stream >> row, pqxx::usage_error,
+    "Extracting too few columns from stream_query went unnoticed.");
+}
+
+
+PQXX_REGISTER_TEST(test_stream_query_reads_rows);
+PQXX_REGISTER_TEST(test_stream_query_iterates);
+PQXX_REGISTER_TEST(test_stream_query_complete_discards_rest);
+PQXX_REGISTER_TEST(test_stream_query_reports_errors);
+PQXX_REGISTER_TEST(test_stream_query_checks_columns);
+} // namespace
@@ -1,9 +1,15 @@
 #include "../test_helpers.hxx"
 #include "../test_types.hxx"
 
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <optional>
+#include <thread>
+#include <vector>
 
+#include <pqxx/binarystring>
 #include <pqxx/stream_to>
 
 
@@ -157,5 +163,309 @@ void test_stream_to()
 }
 
 
+void test_stream_to_binary()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0(
+    "CREATE TEMP TABLE stream_to_binary ("
+    "i integer, b bigint, f float8, t text, x bytea, ok boolean)");
+
+  pqxx::stream_to out{
+    tx, "stream_to_binary",
+    std::vector<std::string>{"i", "b", "f", "t", "x", "ok"},
+    pqxx::format::binary};
+  out << std::make_tuple(
+    1, 10000000000LL, 2.5, std::string{"tab\there"},
+    std::string{"\0\1", 2}, true);
+  out << std::make_tuple(
+    -2, std::optional<long long>{}, 0.0, nullptr,
+    std::string{}, false);
+  out.complete();
+
+  auto const r{tx.exec("SELECT * FROM stream_to_binary ORDER BY i DESC")};
+  PQXX_CHECK_EQUAL(r.size(), 2, "Wrong number of rows from binary COPY.");
+  PQXX_CHECK_EQUAL(r[0][0].as<int>(), 1, "Bad binary integer.");
+  PQXX_CHECK_EQUAL(r[0][1].as<long long>(), 10000000000LL, "Bad bigint.");
+  PQXX_CHECK_BOUNDS(
+    r[0][2].as<double>(), 2.4999, 2.5001, "Bad binary float8.");
+  PQXX_CHECK_EQUAL(r[0][3].as<std::string>(), "tab\there", "Bad text.");
+  PQXX_CHECK_EQUAL(pqxx::binarystring{r[0][4]}.size(), 2u, "Bad bytea.");
+  PQXX_CHECK(r[0][5].as<bool>(), "Bad binary boolean.");
+  PQXX_CHECK_EQUAL(r[1][0].as<int>(), -2, "Bad negative integer.");
+  PQXX_CHECK(r[1][1].is_null(), "Binary null optional went wrong.");
+  PQXX_CHECK(r[1][3].is_null(), "Binary nullptr went wrong.");
+}
+
+
+void test_copy_escape()
+{
+  std::string buf{"prefix\t"};
+  buf += "a\tb\nc\\d\x01\xc3";
+  pqxx::internal::copy_escape_tail(buf, 7);
+  PQXX_CHECK_EQUAL(
+    buf, "prefix\ta\\tb\\nc\\\\d\\001\\303", "Bad in-place COPY escaping.");
+
+  // Long enough for the vectorised scan, with specials at various offsets.
+  std::string const plain(40, 'x');
+  for (std::size_t pos{0}; pos < plain.size(); ++pos)
+  {
+    std::string text{plain};
+    text[pos] = '\\';
+    buf = text;
+    pqxx::internal::copy_escape_tail(buf, 0);
+    PQXX_CHECK_EQUAL(
+      buf, text.substr(0, pos) + "\\\\" + text.substr(pos + 1),
+      "Bad escaping of long text.");
+    text[pos] = '\x7f';
+    buf = text;
+    pqxx::internal::copy_escape_tail(buf, 0);
+    PQXX_CHECK_EQUAL(
+      buf, text.substr(0, pos) + "\\177" + text.substr(pos + 1),
+      "Bad escaping of DEL.");
+  }
+
+  buf = "plain";
+  pqxx::internal::copy_escape_tail(buf, 0);
+  PQXX_CHECK_EQUAL(buf, "plain", "Escaping changed plain text.");
+  PQXX_CHECK_EQUAL(
+    pqxx::internal::copy_string_escape("\r\b"), "\\r\\b",
+    "Bad copy_string_escape().");
+}
+
+
+void test_stream_to_buffering()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE stream_to_buffer (n integer, t text)");
+
+  pqxx::stream_to out{
+    tx, "stream_to_buffer", std::vector<std::string>{"n", "t"}};
+  PQXX_CHECK_EQUAL(
+    out.buffer_size(), pqxx::stream_to::default_buffer_size,
+    "Unexpected default buffer size.");
+  out.set_buffer_size(100);
+  PQXX_CHECK_EQUAL(out.buffer_size(), 100u, "set_buffer_size() failed.");
+
+  for (int n{0}; n < 1000; ++n) out << std::make_tuple(n, "row");
+  out.flush();
+  out.set_buffer_size(0);
+  out << std::make_tuple(1000, nullptr);
+  out.set_buffer_size(1 << 20);
+  out << std::make_tuple(1001, "last");
+  out.complete();
+
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM stream_to_buffer"), 1002,
+    "Buffered stream_to lost rows.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<std::string>(
+      "SELECT t FROM stream_to_buffer WHERE n = 1001"),
+    "last", "Final buffered row went wrong.");
+}
+
+
+void test_stream_to_nonblocking()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE stream_to_nonblock (n integer, t text)");
+
+  pqxx::stream_to out{
+    tx, "stream_to_nonblock", std::vector<std::string>{"n", "t"}};
+  PQXX_CHECK(out.try_flush(), "Blocking stream left data unsent.");
+  PQXX_CHECK_THROWS(
+    out.set_nonblocking(0), pqxx::argument_error,
+    "Non-blocking stream_to accepted zero room.");
+
+  // Keep the limit small, so that the stream has to wait now and then.
+  out.set_nonblocking(4096);
+  std::string const text(100, 'x');
+  for (int n{0}; n < 10000; ++n)
+  {
+    out << std::make_tuple(n, text);
+    if (n % 1000 == 0)
+      while (not out.try_flush())
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+  out.complete();
+
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM stream_to_nonblock"), 10000,
+    "Non-blocking stream_to lost rows.");
+  PQXX_CHECK_THROWS(
+    out.set_nonblocking(), pqxx::usage_error,
+    "Finished stream_to went into non-blocking mode.");
+}
+
+
+void test_stream_to_from_file()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE stream_to_file (n integer, t text)");
+
+  // A COPY text file, without a newline at the end.
+  char const name[]{"pqxx-test-stream-to-file.copy"};
+  std::string const data{"1\tone\n2\ttw\\\\o\n3\t\\N"};
+  std::ofstream{name, std::ios::binary} << data;
+
+  pqxx::stream_to out{tx, "stream_to_file"};
+  std::size_t sent{0};
+  try
+  {
+    sent = out.from_file(name);
+    PQXX_CHECK_THROWS(
+      out.from_file("/nonexistent/pqxx-test"), pqxx::failure,
+      "Missing file went unnoticed.");
+  }
+  catch (...)
+  {
+    std::remove(name);
+    throw;
+  }
+  std::remove(name);
+  // Rows written after the file must not run into its last line.
+  out << std::make_tuple(4, "four");
+  out.complete();
+
+  PQXX_CHECK_EQUAL(sent, data.size() + 1, "Wrong number of bytes sent.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM stream_to_file"), 4,
+    "Lines from file went wrong.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<std::string>("SELECT t FROM stream_to_file WHERE n = 2"),
+    "tw\\o", "Escape from file went wrong.");
+  PQXX_CHECK_EQUAL(
+    tx.query_value<int>("SELECT count(*) FROM stream_to_file WHERE t IS NULL"),
+    1, "Null from file went wrong.");
+
+  pqxx::stream_to binary{tx, "stream_to_file", pqxx::format::binary};
+  PQXX_CHECK_THROWS(
+    binary.from_file(name), pqxx::usage_error,
+    "Loaded text file into binary stream.");
+  binary.complete();
+}
+
+
+void test_stream_to_checked()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TEMP TABLE stream_to_checked (n integer, ok boolean)");
+
+  auto const &table{conn.describe_table("stream_to_checked")};
+  PQXX_CHECK_EQUAL(
+    std::size(table.column_names), 2u, "Wrong number of columns.");
+  PQXX_CHECK_EQUAL(table.column_names[1], "ok", "Wrong column name.");
+  PQXX_CHECK_EQUAL(table.column_list, "\"n\",\"ok\"", "Bad column list.");
+  PQXX_CHECK(
+    &conn.describe_table("stream_to_checked") == &table,
+    "Table description was not cached.");
+  PQXX_CHECK((table.binary_writable<int, bool>()), "Can't write.");
+  PQXX_CHECK(
+    not(table.binary_writable<long long, bool>()),
+    "Type mismatch went unnoticed.");
+
+  {
+    auto out{pqxx::stream_to::checked<int, bool>(tx, "stream_to_checked")};
+    PQXX_CHECK(
+      out.data_format() == pqxx::format::binary,
+      "Matching types did not choose binary format.");
+    out << std::make_tuple(1, true);
+    out.complete();
+  }
+  {
+    auto out{pqxx::stream_to::checked<long long, bool>(
+      tx, "stream_to_checked")};
+    PQXX_CHECK(
+      out.data_format() == pqxx::format::text,
+      "Mismatched types did not fall back to text format.");
+    out << std::make_tuple(2LL, false);
+    out.complete();
+  }
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::stream_to::checked<int>(tx, "stream_to_checked")),
+    pqxx::usage_error, "Wrong number of fields went unnoticed.");
+
+  auto in{pqxx::stream_from::checked<int, bool>(tx, "stream_to_checked")};
+  PQXX_CHECK(
+    in.data_format() == pqxx::format::binary,
+    "Matching types did not read binary format.");
+  int total{0};
+  for (auto const &[n, ok] : in.iter<int, bool>())
+  {
+    total += n;
+    pqxx::ignore_unused(ok);
+  }
+  PQXX_CHECK_EQUAL(total, 3, "Wrong data in table.");
+
+  conn.forget_table("stream_to_checked");
+}
+
+
+void test_stream_to_dedup()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0(
+    "CREATE TEMP TABLE stream_to_dedup "
+    "(a integer, b integer, v text, UNIQUE (a, b))");
+
+  for (auto const data_format : {pqxx::format::text, pqxx::format::binary})
+  {
+    tx.exec0("TRUNCATE stream_to_dedup");
+    pqxx::stream_to out{tx, "stream_to_dedup", data_format};
+    out.set_dedup({0, 1});
+    out << std::make_tuple(1, 1, "first") << std::make_tuple(1, 2, "x")
+        << std::make_tuple(1, 1, "second") << std::make_tuple(2, 1, "y");
+    // A null in the key makes a row unique.
+    out << std::make_tuple(std::optional<int>{}, 1, "n")
+        << std::make_tuple(std::optional<int>{}, 1, "n");
+    PQXX_CHECK_THROWS(
+      out << std::make_tuple(1), pqxx::usage_error,
+      "Row without the key fields went unnoticed.");
+    out.complete();
+
+    PQXX_CHECK_EQUAL(out.duplicates(), 1u, "Wrong number of duplicates.");
+    auto const stats{out.stats()};
+    PQXX_CHECK_EQUAL(stats.rows, 5u, "Duplicates counted as rows.");
+    PQXX_CHECK(stats.bytes > 0u, "No bytes counted.");
+    PQXX_CHECK(stats.blocked <= stats.elapsed, "Bad blocked time.");
+    PQXX_CHECK(not out.dedup_overflowed(), "Dedup overflowed.");
+    PQXX_CHECK_EQUAL(
+      tx.query_value<int>("SELECT count(*) FROM stream_to_dedup"), 5,
+      "Wrong number of rows after dedup.");
+    PQXX_CHECK_EQUAL(
+      tx.query_value<std::string>(
+        "SELECT v FROM stream_to_dedup WHERE a = 1 AND b = 1"),
+      "first", "Wrong duplicate won.");
+  }
+
+  // With very little memory, the stream can't remember any keys.
+  pqxx::stream_to tiny{tx, "stream_to_dedup"};
+  tiny.set_dedup({0}, 100);
+  tiny << std::make_tuple(10, 1, "a") << std::make_tuple(10, 2, "b");
+  PQXX_CHECK(tiny.dedup_overflowed(), "Tiny dedup set did not overflow.");
+  PQXX_CHECK_EQUAL(tiny.duplicates(), 0u, "Tiny dedup set caught a row.");
+  tiny.complete();
+
+  PQXX_CHECK_EQUAL(tiny.stats().rows, 2u, "Wrong row count.");
+
+  PQXX_CHECK_THROWS(
+    pqxx::stream_to(tx, "stream_to_dedup").set_dedup({}),
+    pqxx::argument_error, "Empty dedup key went unnoticed.");
+}
+
+
 PQXX_REGISTER_TEST(test_stream_to);
+PQXX_REGISTER_TEST(test_copy_escape);
+PQXX_REGISTER_TEST(test_stream_to_binary);
+PQXX_REGISTER_TEST(test_stream_to_buffering);
+PQXX_REGISTER_TEST(test_stream_to_nonblocking);
+PQXX_REGISTER_TEST(test_stream_to_from_file);
+PQXX_REGISTER_TEST(test_stream_to_checked);
+PQXX_REGISTER_TEST(test_stream_to_dedup);
 } // namespace
@@ -1,4 +1,8 @@
 #include <cstdint>
+#include <limits>
+
+#include <pqxx/binary_traits>
+#include <pqxx/stream_from>
 
 #include "../test_helpers.hxx"
 
@@ -21,6 +25,19 @@ PQXX_DECLARE_ENUM_CONVERSION(EnumA);
 PQXX_DECLARE_ENUM_CONVERSION(EnumB);
 } // namespace pqxx
 
+// An enum which converts to and from SQL enum labels.
+enum class Mood
+{
+  sad,
+  ok,
+  happy,
+  ecstatic
+};
+namespace pqxx
+{
+PQXX_DECLARE_ENUM_LABELS(Mood, "sad", "ok", "happy", "ecstatic");
+} // namespace pqxx
+
 
 namespace
 {
@@ -111,5 +128,122 @@ void test_string_conversion()
 }
 
 
+void test_enum_labels()
+{
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(Mood::sad), "sad", "Wrong label for first value.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(Mood::ecstatic), "ecstatic",
+    "Wrong label for last value.");
+  for (auto const m : {Mood::sad, Mood::ok, Mood::happy, Mood::ecstatic})
+    PQXX_CHECK(
+      pqxx::from_string<Mood>(pqxx::to_string(m)) == m,
+      "Enum label did not survive a round trip.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<Mood>("meh")),
+    pqxx::conversion_error, "Unknown label went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<Mood>("")), pqxx::conversion_error,
+    "Empty label went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::to_string(static_cast<Mood>(4))),
+    pqxx::conversion_error, "Out-of-range enum value went unnoticed.");
+
+  char buf[4];
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::string_traits<Mood>::into_buf(
+      std::begin(buf), std::end(buf), Mood::happy)),
+    pqxx::conversion_overrun, "Buffer overrun went unnoticed.");
+
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("CREATE TYPE pqxx_mood AS ENUM ('sad', 'ok', 'happy', 'ecstatic')");
+  PQXX_CHECK(
+    tx.query_value<Mood>("SELECT 'happy'::pqxx_mood") == Mood::happy,
+    "Reading an enum label went wrong.");
+  PQXX_CHECK_EQUAL(
+    tx.exec_params1("SELECT $1::pqxx_mood::text", Mood::ok)[0].view(), "ok",
+    "Writing an enum label went wrong.");
+
+  for (auto const fmt : {pqxx::format::text, pqxx::format::binary})
+  {
+    auto stream{pqxx::stream_from::query(
+      tx, "SELECT unnest(enum_range(NULL::pqxx_mood))", fmt)};
+    std::vector<Mood> moods;
+    for (auto [m] : stream.iter<Mood>()) moods.push_back(m);
+    PQXX_CHECK_EQUAL(std::size(moods), 4u, "Wrong number of enum values.");
+    PQXX_CHECK(moods[3] == Mood::ecstatic, "Streaming an enum went wrong.");
+  }
+}
+
+
+template<typename T> void check_integer_limits()
+{
+  using limits = std::numeric_limits<T>;
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<T>(pqxx::to_string(limits::max())), limits::max(),
+    "Highest " + pqxx::type_name<T> + " did not survive conversion.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<T>(pqxx::to_string(limits::min())), limits::min(),
+    "Lowest " + pqxx::type_name<T> + " did not survive conversion.");
+}
+
+
+void test_integer_parsing()
+{
+  // Every length from 1 to 18 digits, so each takes a different mix of
+  // 8-digit blocks and single digits.
+  std::string digits;
+  long long expected{0};
+  for (int i{1}; i <= 18; ++i)
+  {
+    digits.push_back(static_cast<char>('0' + i % 10));
+    expected = expected * 10 + i % 10;
+    PQXX_CHECK_EQUAL(
+      pqxx::from_string<long long>(digits), expected,
+      "Wrong value for " + digits + ".");
+    PQXX_CHECK_EQUAL(
+      pqxx::from_string<long long>("-" + digits), -expected,
+      "Wrong value for -" + digits + ".");
+  }
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<unsigned long long>("9999999999999999999"),
+    9999999999999999999ull, "Wrong value for 19 nines.");
+
+  check_integer_limits<short>();
+  check_integer_limits<unsigned short>();
+  check_integer_limits<int>();
+  check_integer_limits<unsigned>();
+  check_integer_limits<long long>();
+  check_integer_limits<unsigned long long>();
+
+  PQXX_CHECK_EQUAL(pqxx::from_string<int>("007"), 7, "Leading zeroes.");
+  PQXX_CHECK_EQUAL(pqxx::from_string<int>("-0"), 0, "Negative zero.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<int>("2147483648")),
+    pqxx::conversion_error, "Overflow went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<short>("-32769")),
+    pqxx::conversion_error, "Underflow went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<unsigned>("-1")),
+    pqxx::conversion_error, "Negative unsigned value went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<long>("1234567a")),
+    pqxx::conversion_error, "Non-digit in block of 8 went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<long>("12345678:")),
+    pqxx::conversion_error, "Non-digit after block went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<int>("-")),
+    pqxx::conversion_error, "Lone minus sign went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<int>("")),
+    pqxx::conversion_error, "Empty string went unnoticed.");
+}
+
+
 PQXX_REGISTER_TEST(test_string_conversion);
+PQXX_REGISTER_TEST(test_enum_labels);
+PQXX_REGISTER_TEST(test_integer_parsing);
 } // namespace
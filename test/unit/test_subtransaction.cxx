@@ -62,12 +62,46 @@ void test_subtransaction_aborts_implicitly(pqxx::connection_base &conn)
 }
 
 
+void test_subtransaction_defers_savepoints(pqxx::connection_base &conn)
+{
+  pqxx::work trans(conn);
+  make_table(trans);
+  {
+    // Never runs a statement, so its savepoint never goes out.
+    pqxx::subtransaction empty(trans, "empty");
+    empty.commit();
+  }
+  {
+    pqxx::subtransaction outer(trans, "outer");
+    insert_row(outer);
+    {
+      pqxx::subtransaction failing(outer, "failing");
+      PQXX_CHECK_THROWS(
+        failing.exec0("SELECT * FROM nonexistent_table"), pqxx::sql_error,
+        "Bad query in subtransaction did not fail.");
+      failing.abort();
+    }
+    // The rollback to the failed savepoint goes out with this statement.
+    insert_row(outer);
+    {
+      pqxx::subtransaction aborted(outer, "aborted");
+      insert_row(aborted);
+    }
+    outer.commit();
+  }
+  PQXX_CHECK_EQUAL(
+    count_rows(trans), 2, "Deferred savepoints gave wrong results.");
+  trans.commit();
+}
+
+
 void test_subtransaction()
 {
   pqxx::connection conn;
   test_subtransaction_commits_if_commit_called(conn);
   test_subtransaction_aborts_if_abort_called(conn);
   test_subtransaction_aborts_implicitly(conn);
+  test_subtransaction_defers_savepoints(conn);
 }
 
 
@@ -0,0 +1,80 @@
+#include <pqxx/stream_from>
+#include <pqxx/stream_to>
+#include <pqxx/table_copy>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+/// Copy a table from one connection to another, and check the copy.
+void copy_table(pqxx::format data_format, std::size_t buffer_size)
+{
+  pqxx::connection source_conn, target_conn;
+  pqxx::work source_tx{source_conn}, target_tx{target_conn};
+  // Each connection has its own temporary table by this name.
+  for (auto *tx : {&source_tx, &target_tx})
+    tx->exec0("CREATE TEMP TABLE copied (n integer, s text)");
+  source_tx.exec0(
+    "INSERT INTO copied "
+    "SELECT n, CASE WHEN n % 7 = 0 THEN NULL ELSE E'a\\tb' || n END "
+    "FROM generate_series(1, 1000) AS n");
+
+  std::size_t rows;
+  {
+    pqxx::stream_from source{source_tx, "copied", data_format};
+    pqxx::stream_to target{target_tx, "copied", data_format};
+    pqxx::table_copy copy{source, target, buffer_size};
+    rows = copy.run();
+    PQXX_CHECK(copy.bytes() > 0u, "No bytes counted.");
+    target.complete();
+  }
+  PQXX_CHECK_EQUAL(rows, 1000u, "Wrong number of rows copied.");
+
+  auto const check{target_tx.exec1(
+    "SELECT count(*), sum(n), count(s), "
+    "count(*) FILTER (WHERE s = E'a\\tb' || n) FROM copied")};
+  PQXX_CHECK_EQUAL(check[0].as<int>(), 1000, "Wrong row count in copy.");
+  PQXX_CHECK_EQUAL(check[1].as<int>(), 500500, "Wrong numbers in copy.");
+  PQXX_CHECK_EQUAL(check[2].as<int>(), 858, "Wrong nulls in copy.");
+  PQXX_CHECK_EQUAL(check[3].as<int>(), 858, "Wrong strings in copy.");
+}
+
+
+void test_table_copy_text()
+{
+  copy_table(pqxx::format::text, pqxx::table_copy::default_buffer_size);
+  // With a tiny buffer, the threads hand off for practically every row.
+  copy_table(pqxx::format::text, 10);
+}
+
+
+void test_table_copy_binary()
+{
+  copy_table(pqxx::format::binary, pqxx::table_copy::default_buffer_size);
+  copy_table(pqxx::format::binary, 10);
+}
+
+
+void test_table_copy_checks_formats()
+{
+  pqxx::connection source_conn, target_conn;
+  pqxx::work source_tx{source_conn}, target_tx{target_conn};
+  target_tx.exec0("CREATE TEMP TABLE copied (n integer)");
+  auto source{pqxx::stream_from::query(source_tx, "SELECT 1")};
+  pqxx::stream_to target{target_tx, "copied", pqxx::format::binary};
+  PQXX_CHECK_THROWS(
+    (pqxx::table_copy{source, target}), pqxx::usage_error,
+    "Copied between different data formats.");
+  PQXX_CHECK_THROWS(
+    (pqxx::table_copy{source, target, 0}), pqxx::usage_error,
+    "Accepted a zero buffer size.");
+  source.complete();
+  target.complete();
+}
+
+
+PQXX_REGISTER_TEST(test_table_copy_text);
+PQXX_REGISTER_TEST(test_table_copy_binary);
+PQXX_REGISTER_TEST(test_table_copy_checks_formats);
+} // namespace
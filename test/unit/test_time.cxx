@@ -0,0 +1,222 @@
+#include <array>
+#include <chrono>
+
+#include <pqxx/time>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+using namespace std::literals;
+
+namespace
+{
+using clock_time = std::chrono::system_clock::time_point;
+using micro_time = std::chrono::time_point<
+  std::chrono::system_clock, std::chrono::microseconds>;
+using second_time =
+  std::chrono::time_point<std::chrono::system_clock, std::chrono::seconds>;
+
+
+/// A time point, @c micros microseconds after the Unix epoch.
+clock_time at(long long micros)
+{
+  return clock_time{std::chrono::microseconds{micros}};
+}
+
+
+// 2020-02-29 12:34:56.789 UTC.
+constexpr long long leap_day{(18321LL * 86400 + 45296) * 1'000'000 + 789'000};
+
+
+void test_timestamp_from_string()
+{
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<clock_time>("2020-02-29 12:34:56.789+00"),
+    at(leap_day), "Bad timestamptz parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<clock_time>("2020-02-29 12:34:56.789"), at(leap_day),
+    "Timestamp without time zone did not come out as UTC.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<clock_time>("2020-02-29T18:04:56.789+05:30"),
+    at(leap_day), "Bad parse of ISO 8601 timestamp with offset.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<clock_time>("2020-02-29 04:34:56.789-08"), at(leap_day),
+    "Bad negative offset.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<clock_time>("1970-01-02"), at(86'400'000'000LL),
+    "Bad date-only timestamp.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<clock_time>("1969-12-31 23:59:59.999999"), at(-1),
+    "Bad timestamp before the epoch.");
+  PQXX_CHECK(
+    pqxx::from_string<clock_time>("infinity") == clock_time::max(),
+    "Bad infinity.");
+  PQXX_CHECK(
+    pqxx::from_string<clock_time>("-infinity") == clock_time::min(),
+    "Bad -infinity.");
+
+  for (auto const bad :
+       {"2019-02-29 00:00:00", "2020-1-01", "2020-01-01 24:00:01",
+        "2020-01-01 12:60:00", "2020-01-01 12:00:00 junk", "0000-01-01 BC",
+        ""})
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(pqxx::from_string<clock_time>(bad)),
+      pqxx::conversion_error, "Bad timestamp went unnoticed.");
+}
+
+
+void test_timestamp_to_string()
+{
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(at(leap_day)), "2020-02-29 12:34:56.789+00",
+    "Bad timestamp to string.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(at(-1)), "1969-12-31 23:59:59.999999+00",
+    "Bad timestamp before the epoch.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(clock_time::max()), "infinity", "Bad infinity.");
+
+  // Round trip, through years with all sorts of digit counts.  These go
+  // beyond what a nanosecond-precision time point can hold.
+  for (auto const text :
+       {"0044-03-15 12:00:00+00 BC", "0001-01-01 00:00:00+00",
+        "9999-12-31 23:59:59.000001+00", "12345-06-07 08:09:10+00"})
+    PQXX_CHECK_EQUAL(
+      pqxx::to_string(pqxx::from_string<micro_time>(text)), text,
+      "Timestamp did not survive round trip.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::from_string<clock_time>("12345-06-07 08:09:10+00")),
+    pqxx::range_error, "Out-of-range time point went unnoticed.");
+
+  // Less precise time points work too.
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(second_time{std::chrono::seconds{86400}}),
+    "1970-01-02 00:00:00+00", "Bad conversion from seconds.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<second_time>("1969-12-31 23:59:59.5"),
+    second_time{std::chrono::seconds{-1}}, "Bad rounding to seconds.");
+}
+
+
+void test_date_conversions()
+{
+  // Dates as such only convert to C++20's year_month_day, but the
+  // underlying parser always exists.
+  PQXX_CHECK_EQUAL(
+    pqxx::internal::parse_date("2000-01-01"), 10957, "Bad date parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::internal::parse_date("0044-03-15 BC"), -735160, "Bad BC date.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::internal::parse_date("2000-01-01 00:00")),
+    pqxx::conversion_error, "Date parser accepted a time.");
+  std::array<char, pqxx::internal::date_buffer> buf;
+  pqxx::internal::write_date(std::begin(buf), std::end(buf), -735160);
+  PQXX_CHECK_EQUAL(
+    std::string{buf.data()}, "0044-03-15 BC", "Bad BC date to string.");
+}
+
+
+void test_timestamp_binary()
+{
+  std::string buf(8, '\xff');
+  auto const pg_epoch{at(946'684'800'000'000LL)};
+  pqxx::binary_traits<clock_time>::into_binary(
+    buf.data(), buf.data() + buf.size(), pg_epoch);
+  PQXX_CHECK_EQUAL(buf, std::string(8, '\0'), "Bad binary timestamp.");
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<clock_time>::from_binary("\0\0\0\0\0\0\0\1"sv),
+    at(946'684'800'000'001LL), "Bad binary timestamp decode.");
+  PQXX_CHECK(
+    pqxx::binary_traits<clock_time>::from_binary(
+      "\x7f\xff\xff\xff\xff\xff\xff\xff"sv) == clock_time::max(),
+    "Bad binary infinity.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::binary_traits<clock_time>::from_binary("\0\0\0\0"sv)),
+    pqxx::conversion_error, "Short binary timestamp went unnoticed.");
+}
+
+
+void test_interval_conversions()
+{
+  using std::chrono::microseconds;
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(std::chrono::seconds{3661}), "01:01:01",
+    "Bad interval to string.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(std::chrono::hours{100}), "100:00:00",
+    "Bad long interval to string.");
+  PQXX_CHECK_EQUAL(
+    pqxx::to_string(microseconds{-500'000}), "-00:00:00.5",
+    "Bad negative interval to string.");
+
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<microseconds>("1 day 02:03:04.5"),
+    microseconds{93'784'500'000LL}, "Bad interval parse.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<std::chrono::seconds>("-1 days +02:00:00"),
+    std::chrono::seconds{-22 * 3600}, "Bad mixed-sign interval.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<std::chrono::minutes>("3 days"),
+    std::chrono::minutes{3 * 24 * 60}, "Bad interval in days.");
+  PQXX_CHECK_EQUAL(
+    pqxx::from_string<microseconds>("-00:00:00.000001"), microseconds{-1},
+    "Bad tiny interval.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<microseconds>("1 mon")),
+    pqxx::conversion_error, "Interval with months went unnoticed.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(pqxx::from_string<microseconds>("5 fortnights")),
+    pqxx::conversion_error, "Bad interval went unnoticed.");
+
+  // 1 day, 2 microseconds, and no months.
+  auto const binary{"\0\0\0\0\0\0\0\2\0\0\0\1\0\0\0\0"sv};
+  PQXX_CHECK_EQUAL(
+    pqxx::binary_traits<microseconds>::from_binary(binary),
+    microseconds{86'400'000'002LL}, "Bad binary interval.");
+  std::string buf(16, '\xff');
+  pqxx::binary_traits<microseconds>::into_binary(
+    buf.data(), buf.data() + buf.size(), microseconds{2});
+  PQXX_CHECK_EQUAL(
+    buf, std::string("\0\0\0\0\0\0\0\2\0\0\0\0\0\0\0\0", 16),
+    "Bad binary interval output.");
+}
+
+
+void test_timestamp_from_server()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  tx.exec0("SET TIME ZONE 'Asia/Kolkata'");
+  auto const text{tx.query_value<clock_time>(
+    "SELECT TIMESTAMPTZ '2020-02-29 12:34:56.789+00'")};
+  PQXX_CHECK_EQUAL(text, at(leap_day), "Bad timestamptz from server.");
+
+  auto const binary{tx.exec_params_binary(
+    "SELECT TIMESTAMPTZ '2020-02-29 12:34:56.789+00', $1::timestamptz",
+    at(leap_day))};
+  PQXX_CHECK_EQUAL(
+    binary[0][0].as<clock_time>(), at(leap_day), "Bad binary timestamptz.");
+  PQXX_CHECK_EQUAL(
+    binary[0][1].as<clock_time>(), at(leap_day), "Bad timestamp parameter.");
+
+  auto const interval{tx.exec_params(
+    "SELECT $1::interval, INTERVAL '1 day 00:00:01'",
+    std::chrono::microseconds{1})};
+  PQXX_CHECK_EQUAL(
+    interval[0][0].as<std::chrono::microseconds>(),
+    std::chrono::microseconds{1}, "Bad interval round trip.");
+  PQXX_CHECK_EQUAL(
+    interval[0][1].as<std::chrono::seconds>(), std::chrono::seconds{86401},
+    "Bad interval from server.");
+}
+
+
+PQXX_REGISTER_TEST(test_timestamp_from_string);
+PQXX_REGISTER_TEST(test_timestamp_to_string);
+PQXX_REGISTER_TEST(test_date_conversions);
+PQXX_REGISTER_TEST(test_timestamp_binary);
+PQXX_REGISTER_TEST(test_interval_conversions);
+PQXX_REGISTER_TEST(test_timestamp_from_server);
+} // namespace
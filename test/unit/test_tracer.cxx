@@ -0,0 +1,119 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pqxx/tracer>
+#include <pqxx/transaction>
+
+#include "../test_helpers.hxx"
+
+namespace
+{
+/// Tracer which keeps track of what it sees.
+class recording_tracer final : public pqxx::tracer
+{
+public:
+  struct span
+  {
+    std::string classname, name;
+    bool ended = false, committed = false;
+    std::vector<std::string> queries;
+  };
+
+  std::vector<std::unique_ptr<span>> spans;
+  std::vector<std::string> orphans;
+  std::string ctx;
+
+  void *
+  start_transaction(std::string_view classname, std::string_view name) override
+  {
+    spans.push_back(std::make_unique<span>());
+    spans.back()->classname = classname;
+    spans.back()->name = name;
+    return spans.back().get();
+  }
+
+  void end_transaction(void *s, bool committed) noexcept override
+  {
+    static_cast<span *>(s)->ended = true;
+    static_cast<span *>(s)->committed = committed;
+  }
+
+  void record(
+    void *parent, std::chrono::system_clock::time_point,
+    pqxx::query_stats const &stats) noexcept override
+  {
+    if (parent == nullptr)
+      orphans.emplace_back(stats.query);
+    else
+      static_cast<span *>(parent)->queries.emplace_back(stats.query);
+  }
+
+  std::string context(void *) override { return ctx; }
+};
+
+
+void test_tracer()
+{
+  pqxx::connection conn;
+  auto const t{std::make_shared<recording_tracer>()};
+  conn.set_tracer(t);
+
+  {
+    pqxx::work tx{conn, "traced"};
+    tx.exec("SELECT 1");
+    PQXX_CHECK_THROWS(
+      conn.set_tracer(nullptr), pqxx::usage_error,
+      "Replaced tracer inside a transaction.");
+    tx.commit();
+  }
+  PQXX_CHECK_EQUAL(std::size(t->spans), 1u, "Expected one span.");
+  auto const &first{*t->spans[0]};
+  PQXX_CHECK_EQUAL(first.classname, "transaction", "Wrong span class.");
+  PQXX_CHECK_EQUAL(first.name, "traced", "Wrong span name.");
+  PQXX_CHECK(first.ended, "Span did not end.");
+  PQXX_CHECK(first.committed, "Commit was not recorded.");
+  PQXX_CHECK(not std::empty(first.queries), "No child spans.");
+  PQXX_CHECK_EQUAL(first.queries[0], "SELECT 1", "Wrong child span.");
+
+  {
+    pqxx::work tx{conn};
+    tx.exec0("SELECT 2");
+  }
+  PQXX_CHECK_EQUAL(std::size(t->spans), 2u, "Expected another span.");
+  PQXX_CHECK(t->spans[1]->ended, "Aborted span did not end.");
+  PQXX_CHECK(not t->spans[1]->committed, "Abort recorded as commit.");
+  PQXX_CHECK_EQUAL(
+    t->spans[1]->queries.back(), "ROLLBACK", "Rollback not in the span.");
+  PQXX_CHECK(std::empty(t->orphans), "Query escaped its transaction span.");
+}
+
+
+void test_tracer_context()
+{
+  pqxx::connection conn;
+  auto const t{std::make_shared<recording_tracer>()};
+  t->ctx =
+    "traceparent='00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01'";
+  conn.set_tracer(t);
+
+  pqxx::work tx{conn};
+  auto const seen{tx.query_value<std::string>("SELECT current_query()")};
+  PQXX_CHECK_EQUAL(
+    seen.substr(0, 2 + std::size(t->ctx)), "/*" + t->ctx,
+    "Trace context did not reach the server.");
+  tx.commit();
+
+  // A context which would end the comment early doesn't get sent.
+  t->ctx = "evil*/ DROP TABLE x; /*";
+  pqxx::work tx2{conn};
+  PQXX_CHECK(
+    tx2.query_value<std::string>("SELECT current_query()").find("evil") ==
+      std::string::npos,
+    "Unsafe trace context was sent.");
+}
+
+
+PQXX_REGISTER_TEST(test_tracer);
+PQXX_REGISTER_TEST(test_tracer_context);
+} // namespace
@@ -115,6 +115,59 @@ template<typename TX> void test_double_close()
 }
 
 
+void test_deferred_begin()
+{
+  pqxx::connection c;
+  {
+    pqxx::work tx{c};
+    tx.exec0("CREATE TEMP TABLE deferred (id integer)");
+    tx.commit();
+  }
+
+  // The deferred BEGIN goes out with the first statement, so both statements
+  // run in the same transaction.
+  pqxx::work tx1{c, pqxx::begin_policy::deferred};
+  auto const xid{tx1.query_value<long>("SELECT txid_current()")};
+  PQXX_CHECK_EQUAL(
+    tx1.query_value<long>("SELECT txid_current()"), xid,
+    "Deferred BEGIN did not start a transaction.");
+  tx1.commit();
+
+  // A parameterised first statement takes another path.
+  pqxx::work tx2{c, pqxx::begin_policy::deferred};
+  tx2.exec_params("INSERT INTO deferred (id) VALUES ($1)", 1);
+  tx2.abort();
+  PQXX_CHECK_EQUAL(
+    pqxx::work{c}.query_value<int>("SELECT count(*) FROM deferred"), 0,
+    "Abort after deferred BEGIN did not roll back.");
+
+  // A transaction that never executes anything still commits and aborts.
+  pqxx::work{c, pqxx::begin_policy::deferred}.commit();
+  pqxx::work{c, pqxx::begin_policy::deferred}.abort();
+
+  // Begin, insert, and commit, all in one round trip.
+  pqxx::work tx3{c, pqxx::begin_policy::deferred};
+  auto const r{
+    tx3.commit_with("INSERT INTO deferred (id) VALUES (2) RETURNING id")};
+  PQXX_CHECK_EQUAL(r[0][0].as<int>(), 2, "Bad result from commit_with().");
+  PQXX_CHECK_EQUAL(
+    pqxx::work{c}.query_value<int>("SELECT id FROM deferred"), 2,
+    "commit_with() did not commit.");
+
+  // If the last query fails, the transaction aborts.
+  {
+    pqxx::work tx4{c, pqxx::begin_policy::deferred};
+    tx4.exec0("INSERT INTO deferred (id) VALUES (3)");
+    PQXX_CHECK_THROWS(
+      tx4.commit_with("SELECT nonexistent_column_in_deferred_test"),
+      pqxx::sql_error, "Failing query in commit_with() did not throw.");
+  }
+  PQXX_CHECK_EQUAL(
+    pqxx::work{c}.query_value<int>("SELECT count(*) FROM deferred"), 1,
+    "Failed commit_with() still committed.");
+}
+
+
 void test_transaction()
 {
   test_nontransaction_continues_after_error();
@@ -123,6 +176,7 @@ void test_transaction()
   test_double_close<pqxx::read_transaction>();
   test_double_close<pqxx::nontransaction>();
   test_double_close<pqxx::robusttransaction<>>();
+  test_deferred_begin();
 }
 
 
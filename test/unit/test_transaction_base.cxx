@@ -1,3 +1,7 @@
+#include <optional>
+#include <string>
+#include <string_view>
+
 #include "../test_helpers.hxx"
 
 namespace
@@ -79,5 +83,120 @@ void test_transaction_base()
 }
 
 
+void test_for_query()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+
+  // This one goes through COPY.  The tab needs unescaping.
+  int total{0};
+  std::string names;
+  tx.for_query<int, std::string_view, std::optional<int>>(
+    "SELECT n, 'x' || chr(9) || n, NULL FROM generate_series(1, 3) AS n",
+    [&total, &names](int n, std::string_view name, std::optional<int> nil) {
+      total += n;
+      names.append(name);
+      PQXX_CHECK(not nil.has_value(), "Null came out as a value.");
+    });
+  PQXX_CHECK_EQUAL(total, 6, "Wrong total.");
+  PQXX_CHECK_EQUAL(names, "x\t1x\t2x\t3", "Wrong text fields.");
+
+  // This one can't use COPY.
+  tx.exec0("CREATE TEMP TABLE for_query (n integer)");
+  total = 0;
+  tx.for_query<int>(
+    "INSERT INTO for_query SELECT generate_series(1, 4) RETURNING n",
+    [&total](int n) { total += n; });
+  PQXX_CHECK_EQUAL(total, 10, "Wrong total from non-COPY query.");
+
+  PQXX_CHECK_THROWS(
+    tx.for_query<int>("SELECT 1, 2", [](int) {}), pqxx::usage_error,
+    "Wrong number of fields went unnoticed.");
+}
+
+
+
+
+void test_build_query()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+
+  auto &q{tx.build_query()};
+  PQXX_CHECK(q.empty(), "New query builder is not empty.");
+  q.append("SELECT ")
+    .append(42)
+    .append(", ")
+    .append_quoted("it's")
+    .append(", ")
+    .append(std::optional<int>{})
+    .append(" AS ")
+    .append_identifier("a \"b\"");
+  PQXX_CHECK_EQUAL(
+    q.str(), "SELECT 42, 'it''s', NULL AS \"a \"\"b\"\"\"",
+    "Query builder composed the wrong query.");
+
+  auto const res{tx.exec(q)};
+  PQXX_CHECK_EQUAL(std::size(res), 1, "Wrong number of rows.");
+  auto const r{res[0]};
+  PQXX_CHECK_EQUAL(r[0].as<int>(), 42, "Wrong number from built query.");
+  PQXX_CHECK_EQUAL(
+    r[1].as<std::string>(), "it's", "Wrong string from built query.");
+  PQXX_CHECK(r[2].is_null(), "Null from built query came out wrong.");
+  PQXX_CHECK_EQUAL(
+    std::string{res.column_name(2)}, std::string{"a \"b\""},
+    "Wrong identifier from built query.");
+
+  auto const capacity{q.capacity()};
+  auto &again{tx.build_query()};
+  PQXX_CHECK(&again == &q, "Transaction did not re-use its builder.");
+  PQXX_CHECK(again.empty(), "build_query() did not clear the builder.");
+  PQXX_CHECK_EQUAL(
+    again.capacity(), capacity, "Clearing the builder lost its memory.");
+
+  again.append("SELECT ").append(3.5);
+  PQXX_CHECK_BOUNDS(
+    tx.exec1(again.str())[0].as<double>(), 3.4999, 3.5001,
+    "Executing a builder went wrong.");
+}
+
+
+void test_exec_all()
+{
+  pqxx::connection conn;
+  std::size_t statements{0};
+  conn.set_query_hook(
+    [&statements](pqxx::query_stats const &s) { statements = s.statements; });
+  pqxx::work tx{conn};
+
+  // The first statement also carries the transaction's deferred BEGIN, but
+  // its result does not show up.
+  auto const results{tx.exec_all(
+    "CREATE TEMP TABLE exec_all (n integer);"
+    "INSERT INTO exec_all VALUES (1), (2), (3);"
+    "UPDATE exec_all SET n = n + 1 WHERE n > 1;"
+    "SELECT n FROM exec_all ORDER BY n")};
+  PQXX_CHECK_EQUAL(std::size(results), 4u, "Wrong number of results.");
+  PQXX_CHECK_EQUAL(
+    results[1].affected_rows(), 3, "Wrong row count for INSERT.");
+  PQXX_CHECK_EQUAL(
+    results[2].affected_rows(), 2, "Wrong row count for UPDATE.");
+  PQXX_CHECK_EQUAL(std::size(results[3]), 3, "Wrong number of rows.");
+  PQXX_CHECK_EQUAL(results[3][2][0].as<int>(), 4, "Wrong data.");
+  PQXX_CHECK(statements >= 4u, "Query hook missed statements.");
+
+  PQXX_CHECK_EQUAL(
+    std::size(tx.exec_all("SELECT 1")), 1u,
+    "Single statement did not give a single result.");
+
+  PQXX_CHECK_THROWS(
+    tx.exec_all("SELECT 1; SELECT 1/0; SELECT 2"), pqxx::sql_error,
+    "Error in script went unnoticed.");
+}
+
+
 PQXX_REGISTER_TEST(test_transaction_base);
+PQXX_REGISTER_TEST(test_for_query);
+PQXX_REGISTER_TEST(test_build_query);
+PQXX_REGISTER_TEST(test_exec_all);
 } // namespace
@@ -1,3 +1,12 @@
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include <pqxx/connection_pool>
+#include <pqxx/parallel_perform>
+#include <pqxx/transactor>
+
 #include "../test_helpers.hxx"
 
 namespace
@@ -110,6 +119,59 @@ void test_transactor_newstyle_repeats_up_to_given_number_of_attempts()
 }
 
 
+void test_transactor_policy_reports_retries()
+{
+  std::vector<int> seen;
+  pqxx::retry_policy policy;
+  policy.attempts = 4;
+  policy.base_delay = std::chrono::milliseconds{1};
+  policy.max_delay = std::chrono::milliseconds{2};
+  policy.on_retry = [&seen, &policy](pqxx::retry_event const &e) {
+    PQXX_CHECK(
+      dynamic_cast<pqxx::transaction_rollback const *>(&e.cause) != nullptr,
+      "Retry reported wrong cause.");
+    PQXX_CHECK(e.delay <= policy.max_delay, "Retry delay exceeds maximum.");
+    PQXX_CHECK(e.elapsed.count() >= 0, "Negative elapsed time.");
+    seen.push_back(e.attempt);
+  };
+
+  int counter{0};
+  auto const &callback{[&counter] {
+    if (++counter < 3)
+      throw pqxx::transaction_rollback("Simulated error");
+    return counter;
+  }};
+
+  PQXX_CHECK_EQUAL(
+    pqxx::perform(callback, policy), 3, "Transactor returned wrong result.");
+  PQXX_CHECK_EQUAL(std::size(seen), 2u, "Wrong number of retries reported.");
+  PQXX_CHECK_EQUAL(seen[0], 1, "Wrong attempt number reported.");
+  PQXX_CHECK_EQUAL(seen[1], 2, "Wrong attempt number reported.");
+}
+
+
+void test_transactor_policy_respects_budget()
+{
+  pqxx::retry_policy policy;
+  policy.attempts = 1000;
+  policy.base_delay = std::chrono::milliseconds{50};
+  policy.jitter = false;
+  policy.budget = std::chrono::milliseconds{120};
+
+  int counter{0};
+  auto const &callback{[&counter] {
+    ++counter;
+    throw pqxx::broken_connection("Simulated error");
+  }};
+
+  PQXX_CHECK_THROWS(
+    pqxx::perform(callback, policy), pqxx::broken_connection,
+    "Not propagating original exception.");
+  // Pauses of 50 and 100 ms would add up to more than the budget.
+  PQXX_CHECK_EQUAL(counter, 2, "Retry budget not respected.");
+}
+
+
 void test_transactor()
 {
   test_transactor_newstyle_executes_simple_query();
@@ -123,5 +185,58 @@ void test_transactor()
 }
 
 
+void test_perform_all()
+{
+  pqxx::connection_pool_config config;
+  config.max_size = 3;
+  pqxx::connection_pool pool{"", config};
+
+  std::atomic<int> conflicts{0};
+  std::vector<std::function<int(pqxx::connection &)>> jobs;
+  for (int i{0}; i < 20; ++i)
+    jobs.emplace_back([i, &conflicts](pqxx::connection &cx) {
+      if (i == 7)
+        throw std::runtime_error{"Job 7 fails."};
+      if (i == 11 and conflicts++ == 0)
+        throw pqxx::serialization_failure{"Simulated conflict.", ""};
+      pqxx::work tx{cx};
+      auto const value{tx.query_value<int>("SELECT " + pqxx::to_string(i))};
+      tx.commit();
+      return value;
+    });
+
+  pqxx::retry_policy policy;
+  policy.base_delay = std::chrono::milliseconds{0};
+  auto const outcomes{pqxx::perform_all(pool, jobs, 3, policy)};
+
+  PQXX_CHECK_EQUAL(std::size(outcomes), std::size(jobs), "Lost outcomes.");
+  for (int i{0}; i < 20; ++i)
+  {
+    auto const &outcome{outcomes[static_cast<std::size_t>(i)]};
+    if (i == 7)
+    {
+      PQXX_CHECK(not outcome.ok(), "Failing job did not report failure.");
+      PQXX_CHECK_THROWS(
+        std::rethrow_exception(outcome.error), std::runtime_error,
+        "Wrong error for failing job.");
+    }
+    else
+    {
+      PQXX_CHECK(outcome.ok(), "Job failed.");
+      PQXX_CHECK_EQUAL(*outcome.value, i, "Wrong result.");
+    }
+  }
+  PQXX_CHECK_EQUAL(conflicts.load(), 2, "Conflicting job was not retried.");
+  PQXX_CHECK(pool.size() <= 3u, "Pool grew too large.");
+
+  std::vector<std::function<void(pqxx::connection &)>> none;
+  PQXX_CHECK(
+    std::empty(pqxx::perform_all(pool, none)), "Outcomes for no jobs.");
+}
+
+
 PQXX_REGISTER_TEST(test_transactor);
+PQXX_REGISTER_TEST(test_transactor_policy_reports_retries);
+PQXX_REGISTER_TEST(test_transactor_policy_respects_budget);
+PQXX_REGISTER_TEST(test_perform_all);
 } // namespace
@@ -1,3 +1,5 @@
+#include <vector>
+
 #include "../test_helpers.hxx"
 
 namespace
@@ -10,6 +12,16 @@ void test_type_name()
   // types.
   PQXX_CHECK_EQUAL(
     pqxx::type_name<int>, "int", "type_name<int> came out weird.");
+  PQXX_CHECK_EQUAL(
+    std::string{pqxx::name_type<int>()}, "int",
+    "name_type<int>() came out weird.");
+  PQXX_CHECK(
+    pqxx::name_type<std::vector<int>>().find("vector") != std::string::npos,
+    "name_type() did not name a template instance.");
+
+#if defined(PQXX_CONSTEXPR_TYPE_NAME)
+  static_assert(pqxx::name_type<double>() == "double");
+#endif
 }
 
 
@@ -0,0 +1,78 @@
+#include <pqxx/transaction>
+#include <pqxx/uuid>
+
+#include "../test_helpers.hxx"
+
+using namespace std::literals;
+
+namespace
+{
+constexpr auto sample{"a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11"};
+
+
+void test_uuid_text()
+{
+  auto const id{pqxx::from_string<pqxx::uuid>(sample)};
+  PQXX_CHECK_EQUAL(int{id.bytes[0]}, 0xa0, "Bad first uuid byte.");
+  PQXX_CHECK_EQUAL(int{id.bytes[15]}, 0x11, "Bad last uuid byte.");
+  PQXX_CHECK_EQUAL(pqxx::to_string(id), sample, "Bad uuid to string.");
+
+  for (auto const text :
+       {"A0EEBC99-9C0B-4EF8-BB6D-6BB9BD380A11",
+        "{a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11}",
+        "a0eebc999c0b4ef8bb6d6bb9bd380a11",
+        "a0ee-bc99-9c0b-4ef8-bb6d-6bb9-bd38-0a11"})
+    PQXX_CHECK(
+      pqxx::from_string<pqxx::uuid>(text) == id,
+      "Alternative uuid form did not parse.");
+
+  for (auto const bad :
+       {"", "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a1",
+        "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a111",
+        "{a0eebc999c0b4ef8bb6d6bb9bd380a11",
+        "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a1g",
+        "a0eebc9-99c0b-4ef8-bb6d-6bb9bd380a11"})
+    PQXX_CHECK_THROWS(
+      pqxx::ignore_unused(pqxx::from_string<pqxx::uuid>(bad)),
+      pqxx::conversion_error, "Bad uuid went unnoticed.");
+}
+
+
+void test_uuid_binary()
+{
+  auto const id{pqxx::from_string<pqxx::uuid>(sample)};
+  std::string buf(16, '\0');
+  pqxx::binary_traits<pqxx::uuid>::into_binary(
+    buf.data(), buf.data() + buf.size(), id);
+  PQXX_CHECK_EQUAL(
+    buf,
+    "\xa0\xee\xbc\x99\x9c\x0b\x4e\xf8\xbb\x6d\x6b\xb9\xbd\x38\x0a\x11"s,
+    "Bad binary uuid.");
+  PQXX_CHECK(
+    pqxx::binary_traits<pqxx::uuid>::from_binary(buf) == id,
+    "Binary uuid did not round-trip.");
+  PQXX_CHECK_THROWS(
+    pqxx::ignore_unused(
+      pqxx::binary_traits<pqxx::uuid>::from_binary(buf.substr(1))),
+    pqxx::conversion_error, "Short binary uuid went unnoticed.");
+}
+
+
+void test_uuid_from_server()
+{
+  pqxx::connection conn;
+  pqxx::work tx{conn};
+  auto const id{pqxx::from_string<pqxx::uuid>(sample)};
+  auto const r{tx.exec_params_binary("SELECT $1::uuid", id)};
+  PQXX_CHECK(r[0][0].as<pqxx::uuid>() == id, "Bad binary uuid from server.");
+  PQXX_CHECK(
+    tx.query_value<pqxx::uuid>("SELECT '" + std::string{sample} + "'::uuid") ==
+      id,
+    "Bad text uuid from server.");
+}
+
+
+PQXX_REGISTER_TEST(test_uuid_text);
+PQXX_REGISTER_TEST(test_uuid_binary);
+PQXX_REGISTER_TEST(test_uuid_from_server);
+} // namespace